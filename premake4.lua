@@ -5,6 +5,19 @@ function abort( message )
     os.exit()
 end
 
+-- Instruction set used by the SIMD code paths (see ArchitectureInfo.h)
+newoption {
+    trigger = "simd",
+    value = "ISA",
+    description = "Choose the instruction set for SIMD code paths",
+    allowed = {
+        { "sse2", "SSE2, 4 lanes (default)" },
+        { "avx2", "AVX2 and FMA, 8 lanes" },
+        { "none", "Scalar fallback" }
+    }
+}
+
+
 solution "nut"
 
     local buildPath = "build"
@@ -30,6 +43,20 @@ solution "nut"
     end
 
 
+    -- Setting SIMD instruction set
+    local simdoptions = ""
+    local simddefines = {}
+    if _OPTIONS["simd"] == "avx2" then
+        if _ACTION == "gmake" then
+            simdoptions = "-mavx2 -mfma"
+        else
+            simdoptions = "/arch:AVX2"
+        end
+    elseif _OPTIONS["simd"] == "none" then
+        simddefines = { "NUT_NO_SIMD" }
+    end
+
+
     -- Checking for third party library dependencies
     
     -- Assimp
@@ -54,7 +81,8 @@ solution "nut"
     -- Setting solution options
     configurations { "ReleaseStatic", "ReleaseShared", "DebugStatic", "DebugShared" }
     location (buildPath .. "/" .. action)
-    buildoptions { cxxstd }
+    buildoptions { cxxstd, simdoptions }
+    defines { simddefines }
 
 
     -- Compiles nut engine either as static or shared (DLL) library
@@ -70,6 +98,11 @@ solution "nut"
         files { "src/engine/**.h", "src/engine/**.cpp" }
         flags { "ExtraWarnings" }
 
+        -- ThreadPool runs on std::thread
+        configuration "gmake"
+            buildoptions { "-pthread" }
+            links { "pthread" }
+
         configuration "ReleaseStatic"
             flags { "Optimize" }
             kind "StaticLib"
@@ -0,0 +1,248 @@
+/** 
+ * \file BoundingBox.cpp
+ * \brief Class definition for an axis-aligned bounding box (AABB).
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <vector>
+#include "BoundingBox.h"
+#include "Mesh.h"
+#include "SIMD.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    // Bulk methods read boxes as arrays of 6 floats
+    static_assert(sizeof(BoundingBox) == 6 * sizeof(float), "BoundingBox must be tightly packed");
+
+
+
+    /**
+     * Load one coordinate of @SIMDFloat::WIDTH consecutive boxes.
+     * 
+     * @param boxes First box.
+     * @param offsets Lane offsets (0, 6, 12, ...) in floats.
+     * @param component Coordinate: 0 to 2 for min, 3 to 5 for max.
+     */
+    static inline SIMDFloat loadBoxes(const BoundingBox* boxes, const SIMDInt& offsets, int component)
+    {
+        return SIMDFloat::gather(&boxes->min.x + component, offsets);
+    }
+
+    /**
+     * Bounds of the points in [begin, end).
+     */
+    static BoundingBox computeRange(const float* positions, size_t begin, size_t end, size_t stride)
+    {
+        SIMDInt offsets = SIMDInt::mullo(SIMDInt::sequence(), SIMDInt(I32(stride)));
+        SIMDFloat minX(FLT_MAX), minY(FLT_MAX), minZ(FLT_MAX);
+        SIMDFloat maxX(-FLT_MAX), maxY(-FLT_MAX), maxZ(-FLT_MAX);
+        size_t i = begin;
+
+        for (; i + SIMDFloat::WIDTH <= end; i += SIMDFloat::WIDTH)
+        {
+            const float* p = positions + i * stride;
+            SIMDFloat x = SIMDFloat::gather(p, offsets);
+            SIMDFloat y = SIMDFloat::gather(p + 1, offsets);
+            SIMDFloat z = SIMDFloat::gather(p + 2, offsets);
+
+            minX = SIMDFloat::min(minX, x);
+            minY = SIMDFloat::min(minY, y);
+            minZ = SIMDFloat::min(minZ, z);
+            maxX = SIMDFloat::max(maxX, x);
+            maxY = SIMDFloat::max(maxY, y);
+            maxZ = SIMDFloat::max(maxZ, z);
+        }
+
+        BoundingBox box(Vec3f(SIMDFloat::reduceMin(minX), SIMDFloat::reduceMin(minY), SIMDFloat::reduceMin(minZ)),
+                        Vec3f(SIMDFloat::reduceMax(maxX), SIMDFloat::reduceMax(maxY), SIMDFloat::reduceMax(maxZ)));
+
+        for (; i < end; ++i)
+        {
+            const float* p = positions + i * stride;
+            box.expand(Vec3f(p[0], p[1], p[2]));
+        }
+
+        return box;
+    }
+
+
+
+    BoundingBox BoundingBox::transform(const GLMatrix<float>& m) const
+    {
+        if (isEmpty())
+        {
+            return *this;
+        }
+
+        const float a[3] = { min.x, min.y, min.z };
+        const float b[3] = { max.x, max.y, max.z };
+        float rMin[3] = { m[12], m[13], m[14] };
+        float rMax[3] = { m[12], m[13], m[14] };
+
+        // Each output coordinate is a sum of terms; take the smaller and larger of each term
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                float e = m[j * 4 + i] * a[j];
+                float f = m[j * 4 + i] * b[j];
+
+                if (e < f)
+                {
+                    rMin[i] += e;
+                    rMax[i] += f;
+                }
+                else
+                {
+                    rMin[i] += f;
+                    rMax[i] += e;
+                }
+            }
+        }
+
+        return BoundingBox(Vec3f(rMin[0], rMin[1], rMin[2]), Vec3f(rMax[0], rMax[1], rMax[2]));
+    }
+
+
+
+    bool BoundingBox::intersect(const Vec3f& origin, const Vec3f& inverseDirection, float tMin, float tMax,
+                                float* t) const
+    {
+        const float o[3] = { origin.x, origin.y, origin.z };
+        const float d[3] = { inverseDirection.x, inverseDirection.y, inverseDirection.z };
+        const float a[3] = { min.x, min.y, min.z };
+        const float b[3] = { max.x, max.y, max.z };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            float t1 = (a[i] - o[i]) * d[i];
+            float t2 = (b[i] - o[i]) * d[i];
+
+            // NaN (0 * inf): a parallel ray lying on a slab plane, the slab doesn't clip it
+            if (t1 != t1 || t2 != t2)
+            {
+                continue;
+            }
+
+            tMin = t1 < t2 ? (t1 > tMin ? t1 : tMin) : (t2 > tMin ? t2 : tMin);
+            tMax = t1 < t2 ? (t2 < tMax ? t2 : tMax) : (t1 < tMax ? t1 : tMax);
+        }
+
+        if (tMin > tMax)
+        {
+            return false;
+        }
+
+        if (t)
+        {
+            *t = tMin;
+        }
+
+        return true;
+    }
+
+
+
+    size_t BoundingBox::overlaps(const BoundingBox* boxes, size_t count, const BoundingBox& box, U32* indices)
+    {
+        const SIMDInt offsets = SIMDInt::mullo(SIMDInt::sequence(), SIMDInt(6));
+        const SIMDFloat minX(box.min.x), minY(box.min.y), minZ(box.min.z);
+        const SIMDFloat maxX(box.max.x), maxY(box.max.y), maxZ(box.max.z);
+        size_t n = 0;
+        size_t i = 0;
+
+        for (; i + SIMDFloat::WIDTH <= count; i += SIMDFloat::WIDTH)
+        {
+            const BoundingBox* b = boxes + i;
+            SIMDFloat mask = (loadBoxes(b, offsets, 0) <= maxX) & (loadBoxes(b, offsets, 3) >= minX) &
+                             (loadBoxes(b, offsets, 1) <= maxY) & (loadBoxes(b, offsets, 4) >= minY) &
+                             (loadBoxes(b, offsets, 2) <= maxZ) & (loadBoxes(b, offsets, 5) >= minZ);
+
+            n += compactLanes(SIMDFloat::movemask(mask), i, indices + n);
+        }
+
+        for (; i < count; ++i)
+        {
+            if (boxes[i].overlaps(box))
+            {
+                indices[n++] = U32(i);
+            }
+        }
+
+        return n;
+    }
+
+
+
+    size_t BoundingBox::contained(const BoundingBox* boxes, size_t count, const BoundingBox& box, U32* indices)
+    {
+        const SIMDInt offsets = SIMDInt::mullo(SIMDInt::sequence(), SIMDInt(6));
+        const SIMDFloat minX(box.min.x), minY(box.min.y), minZ(box.min.z);
+        const SIMDFloat maxX(box.max.x), maxY(box.max.y), maxZ(box.max.z);
+        size_t n = 0;
+        size_t i = 0;
+
+        for (; i + SIMDFloat::WIDTH <= count; i += SIMDFloat::WIDTH)
+        {
+            const BoundingBox* b = boxes + i;
+            SIMDFloat mask = (loadBoxes(b, offsets, 0) >= minX) & (loadBoxes(b, offsets, 3) <= maxX) &
+                             (loadBoxes(b, offsets, 1) >= minY) & (loadBoxes(b, offsets, 4) <= maxY) &
+                             (loadBoxes(b, offsets, 2) >= minZ) & (loadBoxes(b, offsets, 5) <= maxZ);
+
+            n += compactLanes(SIMDFloat::movemask(mask), i, indices + n);
+        }
+
+        for (; i < count; ++i)
+        {
+            if (box.contains(boxes[i]))
+            {
+                indices[n++] = U32(i);
+            }
+        }
+
+        return n;
+    }
+
+
+
+    BoundingBox BoundingBox::compute(const float* positions, size_t count, size_t stride)
+    {
+        const size_t grain = 64 * 1024;
+        std::vector<BoundingBox> partial((count + grain - 1) / grain);
+
+        ThreadPool::getInstance().parallelFor(count, grain, [&](size_t begin, size_t end)
+        {
+            partial[begin / grain] = computeRange(positions, begin, end, stride);
+        });
+
+        BoundingBox box;
+
+        for (size_t i = 0; i < partial.size(); ++i)
+        {
+            box.merge(partial[i]);
+        }
+
+        return box;
+    }
+
+
+
+    BoundingBox BoundingBox::compute(const Mesh& mesh)
+    {
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+
+        if (vertices.empty())
+        {
+            return BoundingBox();
+        }
+
+        return compute(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float));
+    }
+}
@@ -1,23 +1,238 @@
-/** \file BoundingBox.h
- * brief Class definition for an bounding box.
+/** 
+ * \file BoundingBox.h
+ * \brief Class definition for an axis-aligned bounding box (AABB).
+ * 
+ * Besides the usual single-box queries, this class has bulk versions working on
+ * arrays of boxes or points: @SIMDFloat::WIDTH boxes are tested per iteration
+ * and large arrays are split across the @ThreadPool.
  * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
  * 
- * @author: Eder A. Perez
+ * @author: Eder A. Perez.
  */
 
 #ifndef BOUNDINGBOX_H
 #define BOUNDINGBOX_H
 
+#include <cfloat>
+#include <cstddef>
+#include "DataType.h"
+#include "GLMatrix.h"
+#include "Vector.h"
+
 
 
 namespace nut
 {
-	class BoundingBox
-	{
+    class Mesh;
+
+    class BoundingBox
+    {
+        public:
+
+        Vec3f min; /**< Minimum corner. */
+        Vec3f max; /**< Maximum corner. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor.
+         * 
+         * Instantiates an empty box (min = +FLT_MAX, max = -FLT_MAX), so that
+         * merging or expanding it with anything results in that thing.
+         */
+        BoundingBox() : min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX)
+        {
+        }
+
+        /**
+         * Instantiates a box from its corners.
+         * 
+         * @param min Minimum corner.
+         * @param max Maximum corner.
+         */
+        BoundingBox(const Vec3f& min, const Vec3f& max) : min(min), max(max)
+        {
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Check if the box is empty (any min coordinate greater than max).
+         */
+        bool isEmpty() const
+        {
+            return min.x > max.x || min.y > max.y || min.z > max.z;
+        }
+
+        /**
+         * Get the center of the box.
+         */
+        Vec3f getCenter() const
+        {
+            return Vec3f((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+        }
+
+        /**
+         * Get the half sizes of the box along each axis.
+         */
+        Vec3f getExtents() const
+        {
+            return Vec3f((max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f);
+        }
+
+        /**
+         * Get the surface area of the box (used by the surface area heuristic).
+         * 
+         * @return The area, or zero for an empty box.
+         */
+        float getSurfaceArea() const
+        {
+            if (isEmpty())
+            {
+                return 0.0f;
+            }
+
+            float dx = max.x - min.x, dy = max.y - min.y, dz = max.z - min.z;
+            return 2.0f * (dx * dy + dy * dz + dz * dx);
+        }
+
+        /**
+         * Grow the box to include a point.
+         * 
+         * @param p Point.
+         */
+        void expand(const Vec3f& p)
+        {
+            min.x = p.x < min.x ? p.x : min.x;
+            min.y = p.y < min.y ? p.y : min.y;
+            min.z = p.z < min.z ? p.z : min.z;
+            max.x = p.x > max.x ? p.x : max.x;
+            max.y = p.y > max.y ? p.y : max.y;
+            max.z = p.z > max.z ? p.z : max.z;
+        }
+
+        /**
+         * Grow the box by the same margin in every direction.
+         * 
+         * @param margin Distance added to each face. Negative values shrink it.
+         */
+        void inflate(float margin)
+        {
+            min.x -= margin; min.y -= margin; min.z -= margin;
+            max.x += margin; max.y += margin; max.z += margin;
+        }
+
+        /**
+         * Grow the box to include another box.
+         * 
+         * @param b Box.
+         */
+        void merge(const BoundingBox& b)
+        {
+            min.x = b.min.x < min.x ? b.min.x : min.x;
+            min.y = b.min.y < min.y ? b.min.y : min.y;
+            min.z = b.min.z < min.z ? b.min.z : min.z;
+            max.x = b.max.x > max.x ? b.max.x : max.x;
+            max.y = b.max.y > max.y ? b.max.y : max.y;
+            max.z = b.max.z > max.z ? b.max.z : max.z;
+        }
+
+        /**
+         * Check if a point is inside the box (boundary included).
+         */
+        bool contains(const Vec3f& p) const
+        {
+            return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y &&
+                   p.z >= min.z && p.z <= max.z;
+        }
+
+        /**
+         * Check if a box is entirely inside this box.
+         */
+        bool contains(const BoundingBox& b) const
+        {
+            return b.min.x >= min.x && b.max.x <= max.x && b.min.y >= min.y && b.max.y <= max.y &&
+                   b.min.z >= min.z && b.max.z <= max.z;
+        }
+
+        /**
+         * Check if two boxes overlap (touching counts as overlapping).
+         */
+        bool overlaps(const BoundingBox& b) const
+        {
+            return min.x <= b.max.x && max.x >= b.min.x && min.y <= b.max.y && max.y >= b.min.y &&
+                   min.z <= b.max.z && max.z >= b.min.z;
+        }
+
+        /**
+         * \brief Compute the box bounding this box transformed by an affine matrix,
+         * without transforming its 8 corners (Arvo, "Transforming axis-aligned
+         * bounding boxes", Graphics Gems, 1990).
+         * 
+         * @param m Affine transformation.
+         * @return Bounds of the transformed box.
+         */
+        BoundingBox transform(const GLMatrix<float>& m) const;
+
+        /**
+         * \brief Ray slab test.
+         * 
+         * @param origin Ray origin.
+         * @param inverseDirection Component-wise inverse of the ray direction
+         * (infinite components for axis-parallel rays are fine).
+         * @param tMin Start of the ray interval.
+         * @param tMax End of the ray interval.
+         * @param t Receives the entry distance (clamped to @tMin) if not null.
+         * @return True if the ray hits the box within [@tMin, @tMax].
+         */
+        bool intersect(const Vec3f& origin, const Vec3f& inverseDirection, float tMin, float tMax,
+                       float* t = nullptr) const;
+
+
+
+        /// Bulk methods ///
+
+        /**
+         * \brief Find which boxes of an array overlap a box.
+         * 
+         * @param boxes Array of boxes.
+         * @param count Number of boxes.
+         * @param box Box tested against all of them.
+         * @param indices Receives the indices of the overlapping boxes, in
+         * increasing order. Must have room for @count elements.
+         * @return Number of indices written.
+         */
+        static size_t overlaps(const BoundingBox* boxes, size_t count, const BoundingBox& box, U32* indices);
+
+        /**
+         * \brief Find which boxes of an array are entirely inside a box.
+         * 
+         * Same parameters as @overlaps().
+         */
+        static size_t contained(const BoundingBox* boxes, size_t count, const BoundingBox& box, U32* indices);
+
+        /**
+         * \brief Compute the bounds of an array of points, in parallel.
+         * 
+         * @param positions Address of the first point's x coordinate.
+         * @param count Number of points.
+         * @param stride Distance between consecutive points, in floats (3 for a
+         * Vec3f array, sizeof(Vertex) / sizeof(float) for a Vertex array).
+         * @return Bounds of the points (empty if @count is zero).
+         */
+        static BoundingBox compute(const float* positions, size_t count, size_t stride = 3);
 
-	};
+        /**
+         * \brief Compute the bounds of a mesh's vertex positions, in parallel.
+         */
+        static BoundingBox compute(const Mesh& mesh);
+    };
 }
 
-#endif // BOUNDINGBOX_H
\ No newline at end of file
+#endif // BOUNDINGBOX_H
@@ -0,0 +1,684 @@
+/** 
+ * \file ConvexHull.cpp
+ * \brief Convex hull of a point set (Quickhull).
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "ConvexHull.h"
+#include "Math.h"
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    static const U32 CONVEXHULL_NONE = 0xFFFFFFFF;             /**< No face. */
+    static const size_t CONVEXHULL_PARALLEL_COUNT = 16 * 1024; /**< Larger point sets are assigned to faces in parallel. */
+    static const size_t CONVEXHULL_GRAIN = 4 * 1024;           /**< Points per parallel chunk. */
+    static const double CONVEXHULL_TOLERANCE_SCALE = 3.0;      /**< Tolerance, in epsilons of the coordinate magnitude. */
+
+
+
+    /**
+     * \brief Hull triangle with its plane and the outside points it sees.
+     */
+    struct ConvexHullFace
+    {
+        U32 v[3];                /**< Vertices, counterclockwise seen from outside. */
+        U32 adjacent[3];         /**< Face across the edge v[i] -> v[(i + 1) % 3]. */
+        double normal[3];
+        double offset;
+        std::vector<U32> points; /**< Outside points assigned to the face. */
+        U32 farthest;            /**< Farthest of @points. */
+        double farthestDistance;
+        bool deleted;
+
+        ConvexHullFace() : offset(0.0), farthest(CONVEXHULL_NONE), farthestDistance(0.0), deleted(false)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                v[i] = CONVEXHULL_NONE;
+                adjacent[i] = CONVEXHULL_NONE;
+                normal[i] = 0.0;
+            }
+        }
+
+        double distance(const Vec3f& p) const
+        {
+            return normal[0] * p.x + normal[1] * p.y + normal[2] * p.z - offset;
+        }
+
+        /**
+         * Index of the edge going from @a to @b, or 3.
+         */
+        U32 findEdge(U32 a, U32 b) const
+        {
+            for (U32 i = 0; i < 3; ++i)
+            {
+                if (v[i] == a && v[(i + 1) % 3] == b)
+                {
+                    return i;
+                }
+            }
+
+            return 3;
+        }
+    };
+
+    /**
+     * \brief Edge between the region seen by a new point and the rest of the
+     * hull, with the face and edge index on the unseen side.
+     */
+    struct ConvexHullEdge
+    {
+        U32 a;
+        U32 b;
+        U32 face;
+        U32 edge;
+    };
+
+    /**
+     * \brief Face being explored by the horizon search, and the edges left.
+     */
+    struct ConvexHullFrame
+    {
+        U32 face;
+        U32 edge;
+        U32 remaining;
+    };
+
+    /**
+     * \brief State of a hull build.
+     */
+    struct ConvexHullBuilder
+    {
+        const std::vector<Vec3f>& points;
+        double tolerance;
+        std::vector<ConvexHullFace> faces;
+        size_t liveFaces;
+
+        std::vector<U32> targets;   /**< Face chosen for each point being assigned. */
+        std::vector<double> depths; /**< Distance of each point to its chosen face. */
+        std::vector<ConvexHullFrame> stack;
+        std::vector<ConvexHullEdge> horizon;
+        std::vector<U32> visible;
+        std::vector<U32> orphans;
+
+        ConvexHullBuilder(const std::vector<Vec3f>& points, double tolerance) :
+            points(points), tolerance(tolerance), liveFaces(0)
+        {
+        }
+
+        /**
+         * Append a face and compute its plane.
+         */
+        U32 addFace(U32 a, U32 b, U32 c)
+        {
+            faces.push_back(ConvexHullFace());
+            ConvexHullFace& face = faces.back();
+            face.v[0] = a;
+            face.v[1] = b;
+            face.v[2] = c;
+            setPlane(face);
+            ++liveFaces;
+
+            return U32(faces.size() - 1);
+        }
+
+        void setPlane(ConvexHullFace& face) const
+        {
+            const Vec3f& a = points[face.v[0]];
+            const Vec3f& b = points[face.v[1]];
+            const Vec3f& c = points[face.v[2]];
+
+            double u[3] = { double(b.x) - a.x, double(b.y) - a.y, double(b.z) - a.z };
+            double w[3] = { double(c.x) - a.x, double(c.y) - a.y, double(c.z) - a.z };
+            double n[3] = { u[1] * w[2] - u[2] * w[1], u[2] * w[0] - u[0] * w[2], u[0] * w[1] - u[1] * w[0] };
+            double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            double scale = length > 0.0 ? 1.0 / length : 0.0;
+
+            for (int i = 0; i < 3; ++i)
+            {
+                face.normal[i] = n[i] * scale;
+            }
+
+            // Offset through the centroid, which averages the rounding of the vertices
+            face.offset = (face.normal[0] * (double(a.x) + b.x + c.x) +
+                           face.normal[1] * (double(a.y) + b.y + c.y) +
+                           face.normal[2] * (double(a.z) + b.z + c.z)) / 3.0;
+        }
+
+        /**
+         * \brief Build the first tetrahedron from extreme points.
+         * 
+         * @return False if the points don't span a volume.
+         */
+        bool initialize()
+        {
+            size_t count = points.size();
+            size_t minIndex[3] = { 0, 0, 0 };
+            size_t maxIndex[3] = { 0, 0, 0 };
+            float lo[3] = { points[0].x, points[0].y, points[0].z };
+            float hi[3] = { lo[0], lo[1], lo[2] };
+
+            for (size_t i = 1; i < count; ++i)
+            {
+                const float c[3] = { points[i].x, points[i].y, points[i].z };
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (c[k] < lo[k])
+                    {
+                        lo[k] = c[k];
+                        minIndex[k] = i;
+                    }
+
+                    if (c[k] > hi[k])
+                    {
+                        hi[k] = c[k];
+                        maxIndex[k] = i;
+                    }
+                }
+            }
+
+            // First edge: the extreme pair along the widest axis
+            U32 v[4];
+            double widest = -1.0;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                double extent = (points[maxIndex[k]] - points[minIndex[k]]).length();
+
+                if (extent > widest)
+                {
+                    widest = extent;
+                    v[0] = U32(minIndex[k]);
+                    v[1] = U32(maxIndex[k]);
+                }
+            }
+
+            if (widest <= tolerance)
+            {
+                return false;
+            }
+
+            // Farthest point from the line
+            const Vec3f& p0 = points[v[0]];
+            Vec3f direction = points[v[1]] - p0;
+            double length = direction.length();
+            double farthest = -1.0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                double d = (points[i] - p0).cross(direction).length() / length;
+
+                if (d > farthest)
+                {
+                    farthest = d;
+                    v[2] = U32(i);
+                }
+            }
+
+            if (farthest <= tolerance)
+            {
+                return false;
+            }
+
+            // Farthest point from the plane
+            ConvexHullFace base;
+            base.v[0] = v[0];
+            base.v[1] = v[1];
+            base.v[2] = v[2];
+            setPlane(base);
+            farthest = -1.0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                double d = std::fabs(base.distance(points[i]));
+
+                if (d > farthest)
+                {
+                    farthest = d;
+                    v[3] = U32(i);
+                }
+            }
+
+            if (farthest <= tolerance)
+            {
+                return false;
+            }
+
+            // Faces oriented so that the vertex left out is behind them
+            static const int TETRAHEDRON[4][4] = { { 0, 1, 2, 3 }, { 0, 1, 3, 2 }, { 0, 2, 3, 1 }, { 1, 2, 3, 0 } };
+
+            for (int f = 0; f < 4; ++f)
+            {
+                const int* t = TETRAHEDRON[f];
+                U32 index = addFace(v[t[0]], v[t[1]], v[t[2]]);
+                ConvexHullFace& face = faces[index];
+
+                if (face.distance(points[v[t[3]]]) > 0.0)
+                {
+                    std::swap(face.v[1], face.v[2]);
+                    setPlane(face);
+                }
+            }
+
+            for (U32 f = 0; f < 4; ++f)
+            {
+                for (U32 e = 0; e < 3; ++e)
+                {
+                    U32 a = faces[f].v[e];
+                    U32 b = faces[f].v[(e + 1) % 3];
+
+                    for (U32 g = 0; g < 4; ++g)
+                    {
+                        if (g != f && faces[g].findEdge(b, a) < 3)
+                        {
+                            faces[f].adjacent[e] = g;
+                        }
+                    }
+                }
+            }
+
+            std::vector<U32> rest;
+            rest.reserve(count - 4);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (i != v[0] && i != v[1] && i != v[2] && i != v[3])
+                {
+                    rest.push_back(U32(i));
+                }
+            }
+
+            assign(rest, 0, 4);
+
+            return true;
+        }
+
+        /**
+         * \brief Assign each point to the face among [first, first + count) it
+         * is farthest outside of, if any; points inside all of them are dropped.
+         */
+        void assign(const std::vector<U32>& ids, U32 first, U32 count)
+        {
+            size_t size = ids.size();
+            targets.resize(size);
+            depths.resize(size);
+
+            auto classify = [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const Vec3f& p = points[ids[i]];
+                    U32 best = CONVEXHULL_NONE;
+                    double depth = tolerance;
+
+                    for (U32 f = first; f < first + count; ++f)
+                    {
+                        double d = faces[f].distance(p);
+
+                        if (d > depth)
+                        {
+                            depth = d;
+                            best = f;
+                        }
+                    }
+
+                    targets[i] = best;
+                    depths[i] = depth;
+                }
+            };
+
+            if (size >= CONVEXHULL_PARALLEL_COUNT)
+            {
+                ThreadPool::getInstance().parallelFor(size, CONVEXHULL_GRAIN, classify);
+            }
+            else
+            {
+                classify(0, size);
+            }
+
+            // Appending in input order keeps the result independent of the chunking
+            for (size_t i = 0; i < size; ++i)
+            {
+                if (targets[i] != CONVEXHULL_NONE)
+                {
+                    ConvexHullFace& face = faces[targets[i]];
+                    face.points.push_back(ids[i]);
+
+                    if (depths[i] > face.farthestDistance)
+                    {
+                        face.farthestDistance = depths[i];
+                        face.farthest = ids[i];
+                    }
+                }
+            }
+        }
+
+        /**
+         * \brief Delete the faces seen by a point, starting from one of them,
+         * and collect the boundary of that region counterclockwise.
+         */
+        void findHorizon(U32 start, const Vec3f& eye)
+        {
+            horizon.clear();
+            visible.clear();
+            stack.clear();
+
+            faces[start].deleted = true;
+            visible.push_back(start);
+            stack.push_back({ start, 0, 3 });
+
+            while (!stack.empty())
+            {
+                ConvexHullFrame& top = stack.back();
+
+                if (top.remaining == 0)
+                {
+                    stack.pop_back();
+                    continue;
+                }
+
+                U32 f = top.face;
+                U32 e = top.edge;
+                top.edge = (e + 1) % 3;
+                --top.remaining;
+
+                U32 n = faces[f].adjacent[e];
+
+                if (faces[n].deleted)
+                {
+                    continue;
+                }
+
+                U32 a = faces[f].v[e];
+                U32 b = faces[f].v[(e + 1) % 3];
+                U32 k = faces[n].findEdge(b, a);
+
+                // Faces the point is barely in front of are replaced too, so
+                // the new faces don't fold over them
+                if (faces[n].distance(eye) > 0.0)
+                {
+                    // Continue past the edge we came through
+                    faces[n].deleted = true;
+                    visible.push_back(n);
+                    stack.push_back({ n, (k + 1) % 3, 2 });
+                }
+                else
+                {
+                    horizon.push_back({ a, b, n, k });
+                }
+            }
+        }
+
+        /**
+         * \brief Add the farthest point of a face to the hull.
+         * 
+         * @return False if the seen region isn't bounded by a single loop,
+         * which only happens when rounding defeats the tolerance.
+         */
+        bool addPoint(U32 face)
+        {
+            U32 eye = faces[face].farthest;
+            findHorizon(face, points[eye]);
+
+            size_t size = horizon.size();
+
+            for (size_t k = 0; k < size; ++k)
+            {
+                if (horizon[k].b != horizon[(k + 1) % size].a)
+                {
+                    return false;
+                }
+            }
+
+            // Fan of new faces around the point
+            U32 first = U32(faces.size());
+
+            for (size_t k = 0; k < size; ++k)
+            {
+                const ConvexHullEdge& edge = horizon[k];
+                U32 f = addFace(edge.a, edge.b, eye);
+                faces[f].adjacent[0] = edge.face;
+                faces[f].adjacent[1] = first + U32((k + 1) % size);
+                faces[f].adjacent[2] = first + U32((k + size - 1) % size);
+                faces[edge.face].adjacent[edge.edge] = f;
+            }
+
+            orphans.clear();
+
+            for (size_t i = 0; i < visible.size(); ++i)
+            {
+                std::vector<U32>& list = faces[visible[i]].points;
+
+                for (size_t j = 0; j < list.size(); ++j)
+                {
+                    if (list[j] != eye)
+                    {
+                        orphans.push_back(list[j]);
+                    }
+                }
+
+                std::vector<U32>().swap(list);
+            }
+
+            liveFaces -= visible.size();
+            assign(orphans, first, U32(size));
+
+            return true;
+        }
+
+        /**
+         * \brief Get the largest distance of a point left outside in front of
+         * any face (not only the face it's assigned to).
+         */
+        double measureError() const
+        {
+            double error = 0.0;
+
+            for (size_t f = 0; f < faces.size(); ++f)
+            {
+                const std::vector<U32>& list = faces[f].points;
+
+                for (size_t i = 0; i < list.size() && !faces[f].deleted; ++i)
+                {
+                    for (size_t g = 0; g < faces.size(); ++g)
+                    {
+                        if (!faces[g].deleted)
+                        {
+                            error = std::fmax(error, faces[g].distance(points[list[i]]));
+                        }
+                    }
+                }
+            }
+
+            return error;
+        }
+
+        /**
+         * Find the face with the farthest outside point, or @CONVEXHULL_NONE.
+         */
+        U32 findFarthest() const
+        {
+            U32 best = CONVEXHULL_NONE;
+            double distance = 0.0;
+
+            for (size_t f = 0; f < faces.size(); ++f)
+            {
+                if (!faces[f].deleted && !faces[f].points.empty() && faces[f].farthestDistance > distance)
+                {
+                    distance = faces[f].farthestDistance;
+                    best = U32(f);
+                }
+            }
+
+            return best;
+        }
+    };
+
+
+
+    ConvexHull::ConvexHull() : _error(0.0f)
+    {
+    }
+
+
+
+    bool ConvexHull::build(const float* positions, size_t count, size_t stride, size_t maxVertices)
+    {
+        _vertices.clear();
+        _indices.clear();
+        _error = 0.0f;
+
+        if (maxVertices != 0 && maxVertices < 4)
+        {
+            std::cerr << "nut::ConvexHull::build error. The vertex budget must be at least four.\n";
+            return false;
+        }
+
+        // Flat and tiny point sets are common (quads, decals) and just have no hull
+        if (count < 4)
+        {
+            return false;
+        }
+
+        std::vector<Vec3f> points(count);
+        double magnitude[3] = { 0.0, 0.0, 0.0 };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float* p = positions + i * stride;
+            points[i] = Vec3f(p[0], p[1], p[2]);
+
+            for (int k = 0; k < 3; ++k)
+            {
+                magnitude[k] = std::fmax(magnitude[k], std::fabs(double(p[k])));
+            }
+        }
+
+        // Rounding of a float plane distance grows with the coordinates' magnitude
+        double tolerance = CONVEXHULL_TOLERANCE_SCALE * Math<float>::EPSILON * (magnitude[0] + magnitude[1] + magnitude[2]);
+        ConvexHullBuilder builder(points, tolerance);
+
+        if (!builder.initialize())
+        {
+            return false;
+        }
+
+        size_t cursor = 0;
+
+        while (true)
+        {
+            U32 face;
+
+            if (maxVertices != 0)
+            {
+                // A closed triangle mesh of genus zero has F / 2 + 2 vertices
+                if (builder.liveFaces / 2 + 2 >= maxVertices)
+                {
+                    break;
+                }
+
+                face = builder.findFarthest();
+            }
+            else
+            {
+                // New faces are appended, so faces before the cursor are final
+                while (cursor < builder.faces.size() &&
+                       (builder.faces[cursor].deleted || builder.faces[cursor].points.empty()))
+                {
+                    ++cursor;
+                }
+
+                face = cursor < builder.faces.size() ? U32(cursor) : CONVEXHULL_NONE;
+            }
+
+            if (face == CONVEXHULL_NONE)
+            {
+                break;
+            }
+
+            if (!builder.addPoint(face))
+            {
+                std::cerr << "nut::ConvexHull::build error. Inconsistent horizon.\n";
+                return false;
+            }
+        }
+
+        // Keep the vertices of the remaining faces, in order of first use
+        std::vector<U32> remap(count, CONVEXHULL_NONE);
+        _indices.reserve(builder.liveFaces * 3);
+
+        for (size_t f = 0; f < builder.faces.size(); ++f)
+        {
+            const ConvexHullFace& face = builder.faces[f];
+
+            if (face.deleted)
+            {
+                continue;
+            }
+
+            for (int i = 0; i < 3; ++i)
+            {
+                U32 v = face.v[i];
+
+                if (remap[v] == CONVEXHULL_NONE)
+                {
+                    remap[v] = U32(_vertices.size());
+                    _vertices.push_back(points[v]);
+                }
+
+                _indices.push_back(remap[v]);
+            }
+        }
+
+        if (maxVertices != 0)
+        {
+            _error = float(builder.measureError());
+        }
+
+        return true;
+    }
+
+
+
+    bool ConvexHull::build(const Mesh& mesh, size_t maxVertices)
+    {
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+
+        if (vertices.empty())
+        {
+            return false;
+        }
+
+        return build(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float), maxVertices);
+    }
+
+
+
+    bool ConvexHull::contains(const Vec3f& point, float tolerance) const
+    {
+        for (size_t i = 0; i < _indices.size(); i += 3)
+        {
+            const Vec3f& a = _vertices[_indices[i]];
+            Vec3f normal = (_vertices[_indices[i + 1]] - a).cross(_vertices[_indices[i + 2]] - a);
+
+            if (normal * (point - a) > tolerance * normal.length())
+            {
+                return false;
+            }
+        }
+
+        return !_indices.empty();
+    }
+}
@@ -0,0 +1,144 @@
+/** 
+ * \file ConvexHull.h
+ * \brief Class definition for the convex hull of a point set.
+ * 
+ * The hull is built with Quickhull (Barber, Dobkin and Huhdanpaa, "The
+ * Quickhull algorithm for convex hulls", 1996): starting from a tetrahedron of
+ * extreme points, every point outside the hull is assigned to one face it sees
+ * and the farthest point of a face is added repeatedly, replacing the faces it
+ * sees, until no point is left outside. Assigning the points to the faces of
+ * the first tetrahedron, and reassigning the points of large replaced regions,
+ * runs in parallel on the @ThreadPool; the result doesn't depend on the number
+ * of threads.
+ * 
+ * Face planes are computed in double precision and points closer than a
+ * tolerance derived from Math<float>::EPSILON and the magnitude of the input
+ * coordinates count as inside, so coplanar and duplicated points don't produce
+ * slivers or flipped faces.
+ * 
+ * The build can stop at a vertex budget, adding the farthest outside point
+ * first; the result is then a simplified hull inside the exact one, off by
+ * @getError().
+ * 
+ * Hulls of imported meshes are built once when the model is cooked and kept
+ * in the @Mesh; the vertex and index arrays can be stored and filled back directly.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef CONVEXHULL_H
+#define CONVEXHULL_H
+
+#include <cstddef>
+#include <vector>
+#include "DataType.h"
+#include "Vector.h"
+
+
+
+namespace nut
+{
+    class Mesh;
+
+    class ConvexHull
+    {
+        public:
+
+        /// Constructors ///
+
+        /**
+         * Default constructor. Instantiates an empty hull.
+         */
+        ConvexHull();
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Build the hull of a set of points.
+         * 
+         * @param positions Address of the first point's x coordinate.
+         * @param count Number of points.
+         * @param stride Distance between consecutive points, in floats.
+         * @param maxVertices Stop once the hull has this many vertices (at
+         * least four); zero builds the exact hull.
+         * @return False, leaving the hull empty, if the points don't span a
+         * volume (fewer than four points, or all collinear or coplanar).
+         */
+        bool build(const float* positions, size_t count, size_t stride = 3, size_t maxVertices = 0);
+
+        /**
+         * \brief Build the hull of a mesh's vertex positions.
+         */
+        bool build(const Mesh& mesh, size_t maxVertices = 0);
+
+        /**
+         * Check if the hull is empty.
+         */
+        bool isEmpty() const
+        {
+            return _indices.empty();
+        }
+
+        /**
+         * \brief Check if a point is inside the hull (boundary included).
+         * 
+         * @param point Point to check.
+         * @param tolerance Distance a point can be outside a face and still
+         * count as inside.
+         */
+        bool contains(const Vec3f& point, float tolerance = 0.0f) const;
+
+        /**
+         * Get the hull vertices.
+         */
+        std::vector<Vec3f>& getVertices()
+        {
+            return _vertices;
+        }
+
+        const std::vector<Vec3f>& getVertices() const
+        {
+            return _vertices;
+        }
+
+        /**
+         * Get the hull triangles: three vertex indices each, counterclockwise
+         * seen from outside.
+         */
+        std::vector<U32>& getIndices()
+        {
+            return _indices;
+        }
+
+        const std::vector<U32>& getIndices() const
+        {
+            return _indices;
+        }
+
+        /**
+         * Get how far the input points are in front of the hull faces, which
+         * is zero unless the build stopped at its vertex budget.
+         */
+        float getError() const
+        {
+            return _error;
+        }
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        std::vector<Vec3f> _vertices;
+        std::vector<U32> _indices;
+        float _error;
+    };
+}
+
+#endif // CONVEXHULL_H
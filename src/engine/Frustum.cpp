@@ -0,0 +1,279 @@
+/** 
+ * \file Frustum.cpp
+ * \brief Class definition for a view frustum.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <cstring>
+#include <vector>
+#include "Frustum.h"
+#include "SIMD.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    /**
+     * \brief Frustum planes broadcast to every SIMD lane.
+     */
+    struct FrustumLanes
+    {
+        SIMDFloat nx[6], ny[6], nz[6], d[6];
+
+        FrustumLanes(const Plane* planes)
+        {
+            for (int i = 0; i < 6; ++i)
+            {
+                nx[i] = SIMDFloat(planes[i].normal.x);
+                ny[i] = SIMDFloat(planes[i].normal.y);
+                nz[i] = SIMDFloat(planes[i].normal.z);
+                d[i] = SIMDFloat(planes[i].distance);
+            }
+        }
+    };
+
+
+
+    /**
+     * Cull the elements in [begin, end). @block tests @SIMDFloat::WIDTH elements
+     * and returns the visible lanes as bits; @single tests one element.
+     */
+    template <class Block, class Single>
+    static size_t cullRange(size_t begin, size_t end, U32* visible, const Block& block, const Single& single)
+    {
+        size_t n = 0;
+        size_t i = begin;
+
+        for (; i + SIMDFloat::WIDTH <= end; i += SIMDFloat::WIDTH)
+        {
+            n += compactLanes(block(i), i, visible + n);
+        }
+
+        for (; i < end; ++i)
+        {
+            if (single(i))
+            {
+                visible[n++] = U32(i);
+            }
+        }
+
+        return n;
+    }
+
+    /**
+     * Cull [0, @count) in parallel chunks. Each chunk writes its visible indices
+     * at its own offset of @visible; the lists are packed afterwards.
+     */
+    template <class Block, class Single>
+    static size_t cull(size_t count, U32* visible, const Block& block, const Single& single)
+    {
+        const size_t grain = 32 * 1024;
+
+        if (count <= grain)
+        {
+            return cullRange(0, count, visible, block, single);
+        }
+
+        std::vector<size_t> counts((count + grain - 1) / grain);
+
+        ThreadPool::getInstance().parallelFor(count, grain, [&](size_t begin, size_t end)
+        {
+            counts[begin / grain] = cullRange(begin, end, visible + begin, block, single);
+        });
+
+        size_t n = counts[0];
+
+        for (size_t c = 1; c < counts.size(); ++c)
+        {
+            std::memmove(visible + n, visible + c * grain, counts[c] * sizeof(U32));
+            n += counts[c];
+        }
+
+        return n;
+    }
+
+
+
+    Frustum::Frustum()
+    {
+        set(GLMatrix<float>());
+    }
+
+
+
+    Frustum::Frustum(const GLMatrix<float>& viewProjection)
+    {
+        set(viewProjection);
+    }
+
+
+
+    void Frustum::set(const GLMatrix<float>& m)
+    {
+        // A point is inside when -w <= x, y, z <= w in clip space, i.e.
+        // (row3 +- rowi) . p >= 0. Matrices are stored column-wise.
+        for (int i = 0; i < 3; ++i)
+        {
+            Vec3f row(m[i], m[4 + i], m[8 + i]);
+            Vec3f w(m[3], m[7], m[11]);
+
+            _planes[2 * i] = Plane(w + row, m[15] + m[12 + i]);
+            _planes[2 * i + 1] = Plane(w - row, m[15] - m[12 + i]);
+        }
+
+        for (int i = 0; i < 6; ++i)
+        {
+            _planes[i].normalize();
+        }
+    }
+
+
+
+    bool Frustum::contains(const Vec3f& p) const
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            if (_planes[i].getSignedDistance(p) < 0.0f)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+
+    bool Frustum::intersects(const Vec3f& center, float radius) const
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            if (_planes[i].getSignedDistance(center) < -radius)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+
+    bool Frustum::intersects(const BoundingBox& box) const
+    {
+        if (box.isEmpty())
+        {
+            return false;
+        }
+
+        Vec3f c = box.getCenter();
+        Vec3f e = box.getExtents();
+
+        for (int i = 0; i < 6; ++i)
+        {
+            const Vec3f& n = _planes[i].normal;
+
+            // Projected radius of the box onto the plane normal
+            float r = std::fabs(n.x) * e.x + std::fabs(n.y) * e.y + std::fabs(n.z) * e.z;
+
+            if (_planes[i].getSignedDistance(c) < -r)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+
+    bool Frustum::intersects(const OrientedBoundingBox& box) const
+    {
+        const Vec3f axes[3] = { box.getAxis(0), box.getAxis(1), box.getAxis(2) };
+
+        for (int i = 0; i < 6; ++i)
+        {
+            const Vec3f& n = _planes[i].normal;
+
+            // Projected radius of the box onto the plane normal
+            float r = std::fabs(n * axes[0]) * box.halfExtents.x + std::fabs(n * axes[1]) * box.halfExtents.y +
+                      std::fabs(n * axes[2]) * box.halfExtents.z;
+
+            if (_planes[i].getSignedDistance(box.center) < -r)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+
+    size_t Frustum::cullSpheres(const float* x, const float* y, const float* z, const float* radius,
+                                size_t count, U32* visible) const
+    {
+        const FrustumLanes planes(_planes);
+
+        return cull(count, visible,
+            [&](size_t i)
+            {
+                SIMDFloat cx = SIMDFloat::loadu(x + i);
+                SIMDFloat cy = SIMDFloat::loadu(y + i);
+                SIMDFloat cz = SIMDFloat::loadu(z + i);
+                SIMDFloat r = -SIMDFloat::loadu(radius + i);
+                SIMDFloat inside = (cx * planes.nx[0] + cy * planes.ny[0] + cz * planes.nz[0] + planes.d[0]) >= r;
+
+                for (int p = 1; p < 6; ++p)
+                {
+                    inside &= (cx * planes.nx[p] + cy * planes.ny[p] + cz * planes.nz[p] + planes.d[p]) >= r;
+                }
+
+                return SIMDFloat::movemask(inside);
+            },
+            [&](size_t i)
+            {
+                return intersects(Vec3f(x[i], y[i], z[i]), radius[i]);
+            });
+    }
+
+
+
+    size_t Frustum::cullBoxes(const BoundingBox* boxes, size_t count, U32* visible) const
+    {
+        const FrustumLanes planes(_planes);
+        const SIMDInt offsets = SIMDInt::mullo(SIMDInt::sequence(), SIMDInt(6));
+
+        return cull(count, visible,
+            [&](size_t i)
+            {
+                const float* b = &boxes[i].min.x;
+                SIMDFloat minX = SIMDFloat::gather(b, offsets), maxX = SIMDFloat::gather(b + 3, offsets);
+                SIMDFloat minY = SIMDFloat::gather(b + 1, offsets), maxY = SIMDFloat::gather(b + 4, offsets);
+                SIMDFloat minZ = SIMDFloat::gather(b + 2, offsets), maxZ = SIMDFloat::gather(b + 5, offsets);
+                SIMDFloat cx = (minX + maxX) * 0.5f, ex = (maxX - minX) * 0.5f;
+                SIMDFloat cy = (minY + maxY) * 0.5f, ey = (maxY - minY) * 0.5f;
+                SIMDFloat cz = (minZ + maxZ) * 0.5f, ez = (maxZ - minZ) * 0.5f;
+                SIMDFloat inside(SIMDFloat::asFloat(SIMDInt(-1)));
+
+                for (int p = 0; p < 6; ++p)
+                {
+                    SIMDFloat d = cx * planes.nx[p] + cy * planes.ny[p] + cz * planes.nz[p] + planes.d[p];
+                    SIMDFloat r = ex * SIMDFloat::abs(planes.nx[p]) + ey * SIMDFloat::abs(planes.ny[p]) +
+                                  ez * SIMDFloat::abs(planes.nz[p]);
+                    inside &= d >= -r;
+                }
+
+                return SIMDFloat::movemask(inside);
+            },
+            [&](size_t i)
+            {
+                return intersects(boxes[i]);
+            });
+    }
+}
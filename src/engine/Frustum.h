@@ -1,23 +1,163 @@
-/** \file Frustum.h
- *  \brief Class definition for a frustum.
+/** 
+ * \file Frustum.h
+ * \brief Class definition for a view frustum, made of six planes facing inwards.
+ * 
+ * Planes are extracted from a view-projection matrix (Gribb and Hartmann, "Fast
+ * extraction of viewing frustum planes from the world-view-projection matrix",
+ * 2001), so the frustum lives in the space the matrix transforms from: world
+ * space for projection * view, object space for projection * view * model.
+ * 
+ * The bulk culling methods test @SIMDFloat::WIDTH objects per iteration and
+ * split large arrays across the @ThreadPool.
  * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
  * 
- * @author: Eder A. Perez
+ * @author: Eder A. Perez.
  */
 
 #ifndef FRUSTUM_H
 #define FRUSTUM_H
 
+#include <cstddef>
+#include "BoundingBox.h"
+#include "DataType.h"
+#include "GLMatrix.h"
+#include "OrientedBoundingBox.h"
+#include "Plane.h"
+#include "Sphere.h"
+#include "Vector.h"
+
 
 
 namespace nut
 {
-	class Frustum
-	{
+    class Frustum
+    {
+        public:
+
+        /**
+         * Plane indices.
+         */
+        enum Side
+        {
+            LEFT,
+            RIGHT,
+            BOTTOM,
+            TOP,
+            ZNEAR,
+            ZFAR
+        };
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor.
+         * 
+         * Instantiates the frustum of the identity matrix (the [-1, 1] cube).
+         */
+        Frustum();
+
+        /**
+         * Instantiates the frustum of a view-projection matrix.
+         * 
+         * @param viewProjection Projection matrix times view matrix (OpenGL
+         * clip space conventions, as built by @GLMatrix::setPerspective()).
+         */
+        explicit Frustum(const GLMatrix<float>& viewProjection);
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Extract the planes of a view-projection matrix.
+         * 
+         * @param viewProjection Projection matrix times view matrix.
+         */
+        void set(const GLMatrix<float>& viewProjection);
+
+        /**
+         * Get one of the six normalized planes; normals point inside.
+         * 
+         * @param side A @Side value.
+         */
+        const Plane& getPlane(int side) const
+        {
+            return _planes[side];
+        }
+
+        /**
+         * Check if a point is inside the frustum.
+         */
+        bool contains(const Vec3f& p) const;
+
+        /**
+         * \brief Check if a sphere is at least partially inside the frustum.
+         * 
+         * Conservative: spheres outside but near a frustum corner may be
+         * reported as visible.
+         */
+        bool intersects(const Vec3f& center, float radius) const;
+
+        /**
+         * \brief Check if a sphere is at least partially inside the frustum.
+         */
+        bool intersects(const Sphere& sphere) const
+        {
+            return !sphere.isEmpty() && intersects(sphere.center, sphere.radius);
+        }
+
+        /**
+         * \brief Check if a box is at least partially inside the frustum.
+         * 
+         * Conservative in the same way as for spheres.
+         */
+        bool intersects(const BoundingBox& box) const;
+
+        /**
+         * \brief Check if an oriented box is at least partially inside the frustum.
+         * 
+         * Conservative in the same way as for spheres.
+         */
+        bool intersects(const OrientedBoundingBox& box) const;
+
+        /**
+         * \brief Cull an array of spheres stored as separate coordinate arrays.
+         * 
+         * @param x Center x coordinates.
+         * @param y Center y coordinates.
+         * @param z Center z coordinates.
+         * @param radius Radii.
+         * @param count Number of spheres.
+         * @param visible Receives the indices of the visible spheres, in
+         * increasing order. Must have room for @count elements.
+         * @return Number of visible spheres.
+         */
+        size_t cullSpheres(const float* x, const float* y, const float* z, const float* radius,
+                           size_t count, U32* visible) const;
+
+        /**
+         * \brief Cull an array of boxes.
+         * 
+         * @param boxes Boxes.
+         * @param count Number of boxes.
+         * @param visible Receives the indices of the visible boxes, in increasing
+         * order. Must have room for @count elements.
+         * @return Number of visible boxes.
+         */
+        size_t cullBoxes(const BoundingBox* boxes, size_t count, U32* visible) const;
+
+
+
+        private:
+
+        /// Private attributes ///
 
-	};
+        Plane _planes[6];
+    };
 }
 
-#endif // FRUSTUM_H
\ No newline at end of file
+#endif // FRUSTUM_H
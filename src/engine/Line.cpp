@@ -0,0 +1,91 @@
+/** 
+ * \file Line.cpp
+ * \brief Class definition for a line.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <cfloat>
+#include "Line.h"
+
+
+
+namespace nut
+{
+    float Line::closestPoint(const Vec3f& p, float& t) const
+    {
+        float dd = direction * direction;
+
+        t = dd > FLT_MIN ? ((p - point) * direction) / dd : 0.0f;
+
+        Vec3f r = getPoint(t) - p;
+
+        return r * r;
+    }
+
+
+
+    float Line::closestPoints(const Line& line, float& t, float& u) const
+    {
+        const Vec3f& d1 = direction;
+        const Vec3f& d2 = line.direction;
+        Vec3f r = point - line.point;
+        float dd1 = d1 * d1;
+        float dd2 = d2 * d2;
+        float d12 = d1 * d2;
+        float c = d1 * r;
+        float f = d2 * r;
+        float denom = dd1 * dd2 - d12 * d12;
+
+        if (denom > Segment::PARALLEL_EPSILON * dd1 * dd2)
+        {
+            t = (d12 * f - c * dd2) / denom;
+            u = (dd1 * f - d12 * c) / denom;
+        }
+        else
+        {
+            // Parallel (or degenerate): project this line's point on the other one
+            t = 0.0f;
+            u = dd2 > FLT_MIN ? f / dd2 : 0.0f;
+        }
+
+        Vec3f x = r + d1 * t - d2 * u;
+
+        return x * x;
+    }
+
+
+
+    float Line::closestPoints(const Segment& segment, float& t, float& u) const
+    {
+        const Vec3f& d1 = direction;
+        Vec3f d2 = segment.getDirection();
+        Vec3f r = point - segment.a;
+        float dd1 = d1 * d1;
+        float dd2 = d2 * d2;
+        float d12 = d1 * d2;
+        float c = d1 * r;
+        float f = d2 * r;
+        float denom = dd1 * dd2 - d12 * d12;
+
+        // With t free, the distance is convex in u: clamping the optimum is exact
+        if (denom > Segment::PARALLEL_EPSILON * dd1 * dd2)
+        {
+            u = (dd1 * f - d12 * c) / denom;
+            u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+        }
+        else
+        {
+            u = 0.0f;
+        }
+
+        t = dd1 > FLT_MIN ? (d12 * u - c) / dd1 : 0.0f;
+
+        Vec3f x = r + d1 * t - d2 * u;
+
+        return x * x;
+    }
+}
@@ -1,5 +1,11 @@
-/** \file Line.h
- *  \brief Class definition for a line.
+/** 
+ * \file Line.h
+ * \brief Class definition for a line.
+ * 
+ * A line is the set of points point + t * direction for any t. Closest point
+ * queries return the squared distance and the parameters of the closest
+ * points, like the ones of @Segment; parallel lines have many closest pairs
+ * and any of them is returned.
  * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
@@ -10,14 +16,91 @@
 #ifndef LINE_H
 #define LINE_H
 
+#include "Segment.h"
+#include "Vector.h"
+
 
 
 namespace nut
 {
-	class Line
-	{
+    class Line
+    {
+        public:
+
+        Vec3f point;     /**< A point on the line. */
+        Vec3f direction; /**< Line direction (not required to be unit length). */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor.
+         * 
+         * Instantiates the z axis.
+         */
+        Line() : point(0.0f, 0.0f, 0.0f), direction(0.0f, 0.0f, 1.0f)
+        {
+        }
+
+        /**
+         * Instantiates a line.
+         * 
+         * @param point A point on the line.
+         * @param direction Line direction.
+         */
+        Line(const Vec3f& point, const Vec3f& direction) : point(point), direction(direction)
+        {
+        }
+
+        /**
+         * Instantiates the line through a segment, with the same parameters.
+         */
+        explicit Line(const Segment& segment) : point(segment.a), direction(segment.getDirection())
+        {
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Get the point at distance @t (in units of the direction length).
+         */
+        Vec3f getPoint(float t) const
+        {
+            return point + direction * t;
+        }
+
+        /**
+         * \brief Find the point of the line closest to a point.
+         * 
+         * @param p Query point.
+         * @param t Receives the parameter of the closest point (see @getPoint()).
+         * @return The squared distance.
+         */
+        float closestPoint(const Vec3f& p, float& t) const;
+
+        /**
+         * \brief Find the closest points of two lines.
+         * 
+         * @param line The other line.
+         * @param t Receives the parameter of the closest point on this line.
+         * @param u Receives the parameter of the closest point on @line.
+         * @return The squared distance.
+         */
+        float closestPoints(const Line& line, float& t, float& u) const;
 
-	};
+        /**
+         * \brief Find the closest points of the line and a segment.
+         * 
+         * @param segment The segment.
+         * @param t Receives the parameter of the closest point on the line.
+         * @param u Receives the parameter of the closest point on @segment.
+         * @return The squared distance.
+         */
+        float closestPoints(const Segment& segment, float& t, float& u) const;
+    };
 }
 
-#endif // LINE_H
\ No newline at end of file
+#endif // LINE_H
@@ -0,0 +1,817 @@
+/** 
+ * \file OcclusionBuffer.cpp
+ * \brief Class definition for a masked hierarchical depth buffer.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include "Mesh.h"
+#include "OcclusionBuffer.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    const int OcclusionBuffer::TILE_WIDTH;
+    const int OcclusionBuffer::TILE_HEIGHT;
+
+    static const size_t OCCLUSION_VERTEX_GRAIN = 16 * 1024;   /**< Vertices transformed per parallel chunk. */
+    static const size_t OCCLUSION_TRIANGLE_GRAIN = 4 * 1024;  /**< Triangles set up per parallel chunk. */
+    static const size_t OCCLUSION_BOX_GRAIN = 1024;           /**< Boxes tested per parallel chunk. */
+    static const float OCCLUSION_GUARD_BAND = 16.0f;          /**< Triangles beyond +-16 w in x or y are clipped. */
+    static const float OCCLUSION_MIN_EDGE_HEIGHT = 1e-6f;     /**< Flatter edges don't bound any row. */
+    static const int OCCLUSION_MAX_CLIPPED = 8;               /**< A triangle clipped by five planes. */
+    static const int OCCLUSION_ALL_LANES = (1 << SIMDInt::WIDTH) - 1;
+
+
+
+    /**
+     * Transform the vertices in [begin, end) to clip space, @SIMDFloat::WIDTH
+     * at a time.
+     */
+    static void occlusionTransform(const float* positions, size_t begin, size_t end, size_t stride,
+                                   const GLMatrix<float>& m, float* x, float* y, float* z, float* w)
+    {
+        const SIMDInt offsets = SIMDInt::mullo(SIMDInt::sequence(), SIMDInt(I32(stride)));
+        float* outputs[4] = { x, y, z, w };
+        size_t i = begin;
+
+        for (; i + SIMDFloat::WIDTH <= end; i += SIMDFloat::WIDTH)
+        {
+            const float* p = positions + i * stride;
+            SIMDFloat px = SIMDFloat::gather(p, offsets);
+            SIMDFloat py = SIMDFloat::gather(p + 1, offsets);
+            SIMDFloat pz = SIMDFloat::gather(p + 2, offsets);
+
+            // Matrices are stored column-wise
+            for (int r = 0; r < 4; ++r)
+            {
+                SIMDFloat::fmadd(SIMDFloat(m[r]), px,
+                    SIMDFloat::fmadd(SIMDFloat(m[4 + r]), py,
+                        SIMDFloat::fmadd(SIMDFloat(m[8 + r]), pz, SIMDFloat(m[12 + r])))).storeu(outputs[r] + i);
+            }
+        }
+
+        for (; i < end; ++i)
+        {
+            const float* p = positions + i * stride;
+
+            for (int r = 0; r < 4; ++r)
+            {
+                outputs[r][i] = m[r] * p[0] + m[4 + r] * p[1] + m[8 + r] * p[2] + m[12 + r];
+            }
+        }
+    }
+
+    /**
+     * Signed distance of a clip space point to one of the clipping planes: the
+     * near plane, then the four sides of the guard band.
+     */
+    static inline float occlusionClipDistance(const Vec4f& p, int plane)
+    {
+        switch (plane)
+        {
+            case 0: return p.z + p.w;
+            case 1: return OCCLUSION_GUARD_BAND * p.w - p.x;
+            case 2: return OCCLUSION_GUARD_BAND * p.w + p.x;
+            case 3: return OCCLUSION_GUARD_BAND * p.w - p.y;
+            default: return OCCLUSION_GUARD_BAND * p.w + p.y;
+        }
+    }
+
+    /**
+     * Mask of the bits [begin, end) of a coverage row, with 0 <= begin, end <= 32.
+     */
+    static inline U32 occlusionSpan(int begin, int end)
+    {
+        U32 low = begin < 32 ? ~0u << begin : 0u;
+        U32 high = end < 32 ? ~0u << end : 0u;
+
+        return low & ~high;
+    }
+
+
+
+    OcclusionBuffer::OcclusionBuffer() : _width(0), _height(0), _tilesX(0), _tilesY(0)
+    {
+    }
+
+
+
+    OcclusionBuffer::OcclusionBuffer(U32 width, U32 height) : _width(0), _height(0), _tilesX(0), _tilesY(0)
+    {
+        resize(width, height);
+    }
+
+
+
+    bool OcclusionBuffer::resize(U32 width, U32 height)
+    {
+        if (width % TILE_WIDTH != 0 || height % 8 != 0)
+        {
+            std::cerr << "nut::OcclusionBuffer::resize error. The width must be a multiple of 32 and the height of 8.\n";
+            return false;
+        }
+
+        _width = width;
+        _height = height;
+        _tilesX = width / TILE_WIDTH;
+        _tilesY = height / TILE_HEIGHT;
+        _tiles.resize(size_t(_tilesX) * _tilesY);
+        _masks.resize(_tiles.size() * TILE_HEIGHT);
+
+        // Twice as many bands as threads, to balance uneven occluder density
+        size_t bands = std::min(size_t(_tilesY), 2 * ThreadPool::getInstance().getNumberOfThreads());
+
+        _bandOfTileRow.resize(_tilesY);
+        _bandRows.assign(1, 0);
+
+        for (size_t b = 0; b < bands; ++b)
+        {
+            size_t end = (b + 1) * _tilesY / bands;
+
+            for (size_t r = _bandRows.back() / TILE_HEIGHT; r < end; ++r)
+            {
+                _bandOfTileRow[r] = U32(b);
+            }
+
+            _bandRows.push_back(U32(end * TILE_HEIGHT));
+        }
+
+        clear();
+
+        return true;
+    }
+
+
+
+    void OcclusionBuffer::clear()
+    {
+        for (size_t i = 0; i < _tiles.size(); ++i)
+        {
+            _tiles[i].zMax0 = 1.0f;
+            _tiles[i].zMax1 = 1.0f;
+        }
+
+        std::fill(_masks.begin(), _masks.end(), 0u);
+    }
+
+
+
+    bool OcclusionBuffer::render(const float* positions, size_t vertexCount, size_t stride, const int* indices,
+                                 size_t triangleCount, const GLMatrix<float>& modelViewProjection)
+    {
+        if (_tiles.empty() || vertexCount == 0 || triangleCount == 0)
+        {
+            return true;
+        }
+
+        for (size_t i = 0; i < 3 * triangleCount; ++i)
+        {
+            if (indices[i] < 0 || size_t(indices[i]) >= vertexCount)
+            {
+                std::cerr << "nut::OcclusionBuffer::render error. Invalid vertex index " << indices[i] << ".\n";
+                return false;
+            }
+        }
+
+        ThreadPool& pool = ThreadPool::getInstance();
+
+        // Clip space vertices, as separate coordinate arrays
+        _clip.resize(4 * vertexCount);
+        float* x = &_clip[0];
+
+        pool.parallelFor(vertexCount, OCCLUSION_VERTEX_GRAIN, [&](size_t begin, size_t end)
+        {
+            occlusionTransform(positions, begin, end, stride, modelViewProjection,
+                               x, x + vertexCount, x + 2 * vertexCount, x + 3 * vertexCount);
+        });
+
+        // Set up the triangles; every chunk has its own bin per band
+        size_t bands = _bandRows.size() - 1;
+        size_t chunks = (triangleCount + OCCLUSION_TRIANGLE_GRAIN - 1) / OCCLUSION_TRIANGLE_GRAIN;
+
+        if (_bins.size() < chunks * bands)
+        {
+            _bins.resize(chunks * bands);
+        }
+
+        for (size_t i = 0; i < chunks * bands; ++i)
+        {
+            _bins[i].clear();
+        }
+
+        pool.parallelFor(triangleCount, OCCLUSION_TRIANGLE_GRAIN, [&](size_t begin, size_t end)
+        {
+            _setup(indices, begin, end, &_bins[(begin / OCCLUSION_TRIANGLE_GRAIN) * bands]);
+        });
+
+        // Rasterize the bands, each in submission order
+        pool.parallelFor(bands, 1, [&](size_t begin, size_t end)
+        {
+            for (size_t band = begin; band < end; ++band)
+            {
+                for (size_t chunk = 0; chunk < chunks; ++chunk)
+                {
+                    const std::vector<Triangle>& bin = _bins[chunk * bands + band];
+
+                    for (size_t i = 0; i < bin.size(); ++i)
+                    {
+                        _rasterize(bin[i], int(_bandRows[band]), int(_bandRows[band + 1]));
+                    }
+                }
+            }
+        });
+
+        return true;
+    }
+
+
+
+    bool OcclusionBuffer::render(const Mesh& mesh, const GLMatrix<float>& modelViewProjection)
+    {
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+        const std::vector<int>& triangulation = mesh.getTriangulation();
+
+        if (vertices.empty() || triangulation.size() < 3)
+        {
+            return true;
+        }
+
+        return render(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float), &triangulation[0],
+                      triangulation.size() / 3, modelViewProjection);
+    }
+
+
+
+    bool OcclusionBuffer::isVisible(const BoundingBox& box, const GLMatrix<float>& m) const
+    {
+        if (_tiles.empty())
+        {
+            return true;
+        }
+
+        if (box.isEmpty())
+        {
+            return false;
+        }
+
+        // Corners: the min corner plus any of the transformed edge vectors
+        Vec3f e = box.max - box.min;
+        Vec4f base(m[0] * box.min.x + m[4] * box.min.y + m[8] * box.min.z + m[12],
+                   m[1] * box.min.x + m[5] * box.min.y + m[9] * box.min.z + m[13],
+                   m[2] * box.min.x + m[6] * box.min.y + m[10] * box.min.z + m[14],
+                   m[3] * box.min.x + m[7] * box.min.y + m[11] * box.min.z + m[15]);
+        Vec4f axes[3] = { Vec4f(m[0] * e.x, m[1] * e.x, m[2] * e.x, m[3] * e.x),
+                          Vec4f(m[4] * e.y, m[5] * e.y, m[6] * e.y, m[7] * e.y),
+                          Vec4f(m[8] * e.z, m[9] * e.z, m[10] * e.z, m[11] * e.z) };
+        float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+        float maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            Vec4f c = base;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                if (i & (1 << k))
+                {
+                    c += axes[k];
+                }
+            }
+
+            if (!(c.w > 0.0f) || c.z < -c.w)
+            {
+                return true;
+            }
+
+            float invW = 1.0f / c.w;
+            float x = (c.x * invW * 0.5f + 0.5f) * _width;
+            float y = (c.y * invW * 0.5f + 0.5f) * _height;
+
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+            minZ = std::min(minZ, c.z * invW * 0.5f + 0.5f);
+        }
+
+        // Pixels the rectangle touches
+        int colBegin = int(std::floor(std::max(minX, 0.0f)));
+        int colEnd = int(std::floor(std::min(maxX, float(_width)))) + 1;
+        int rowBegin = int(std::floor(std::max(minY, 0.0f)));
+        int rowEnd = int(std::floor(std::min(maxY, float(_height)))) + 1;
+
+        colEnd = std::min(colEnd, int(_width));
+        rowEnd = std::min(rowEnd, int(_height));
+
+        if (colBegin >= colEnd || rowBegin >= rowEnd)
+        {
+            return false;
+        }
+
+        for (int ty = rowBegin / TILE_HEIGHT; ty * TILE_HEIGHT < rowEnd; ++ty)
+        {
+            for (int tx = colBegin / TILE_WIDTH; tx * TILE_WIDTH < colEnd; ++tx)
+            {
+                size_t t = size_t(ty) * _tilesX + tx;
+                const Tile& tile = _tiles[t];
+
+                if (minZ > tile.zMax0)
+                {
+                    continue;
+                }
+
+                if (minZ <= tile.zMax1)
+                {
+                    return true;
+                }
+
+                // Behind the working layer: hidden if all its pixels are in it
+                U32 span = occlusionSpan(std::max(colBegin - tx * TILE_WIDTH, 0), std::min(colEnd - tx * TILE_WIDTH, TILE_WIDTH));
+                int rowLast = std::min(rowEnd, (ty + 1) * TILE_HEIGHT);
+
+                for (int row = std::max(rowBegin, ty * TILE_HEIGHT); row < rowLast; ++row)
+                {
+                    if ((_masks[t * TILE_HEIGHT + row - ty * TILE_HEIGHT] & span) != span)
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+
+
+    size_t OcclusionBuffer::cullBoxes(const BoundingBox* boxes, size_t count, const GLMatrix<float>& viewProjection,
+                                      U32* visible) const
+    {
+        auto cullRange = [&](size_t begin, size_t end, U32* output)
+        {
+            size_t n = 0;
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (isVisible(boxes[i], viewProjection))
+                {
+                    output[n++] = U32(i);
+                }
+            }
+
+            return n;
+        };
+
+        if (count <= OCCLUSION_BOX_GRAIN)
+        {
+            return cullRange(0, count, visible);
+        }
+
+        // Each chunk writes at its own offset; the lists are packed afterwards
+        std::vector<size_t> counts((count + OCCLUSION_BOX_GRAIN - 1) / OCCLUSION_BOX_GRAIN);
+
+        ThreadPool::getInstance().parallelFor(count, OCCLUSION_BOX_GRAIN, [&](size_t begin, size_t end)
+        {
+            counts[begin / OCCLUSION_BOX_GRAIN] = cullRange(begin, end, visible + begin);
+        });
+
+        size_t n = counts[0];
+
+        for (size_t c = 1; c < counts.size(); ++c)
+        {
+            std::memmove(visible + n, visible + c * OCCLUSION_BOX_GRAIN, counts[c] * sizeof(U32));
+            n += counts[c];
+        }
+
+        return n;
+    }
+
+
+
+    float OcclusionBuffer::getDepth(U32 x, U32 y) const
+    {
+        if (x >= _width || y >= _height)
+        {
+            return 1.0f;
+        }
+
+        size_t t = size_t(y / TILE_HEIGHT) * _tilesX + x / TILE_WIDTH;
+        const Tile& tile = _tiles[t];
+        U32 row = _masks[t * TILE_HEIGHT + y % TILE_HEIGHT];
+
+        return (row >> (x % TILE_WIDTH)) & 1u ? std::min(tile.zMax0, tile.zMax1) : tile.zMax0;
+    }
+
+
+
+    void OcclusionBuffer::_bin(const float* x, const float* y, const float* z, std::vector<Triangle>* bins) const
+    {
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+
+        if (!(area > 0.0f))
+        {
+            return;
+        }
+
+        // Columns and rows whose pixel centers are within the bounds
+        float minX = std::max(std::min(std::min(x[0], x[1]), x[2]), -1.0f);
+        float maxX = std::min(std::max(std::max(x[0], x[1]), x[2]), float(_width) + 1.0f);
+        float minY = std::max(std::min(std::min(y[0], y[1]), y[2]), -1.0f);
+        float maxY = std::min(std::max(std::max(y[0], y[1]), y[2]), float(_height) + 1.0f);
+        Triangle t;
+
+        t.colBegin = std::max(int(std::ceil(minX - 0.5f)), 0);
+        t.colEnd = std::min(int(std::floor(maxX - 0.5f)) + 1, int(_width));
+        t.rowBegin = std::max(int(std::ceil(minY - 0.5f)), 0);
+        t.rowEnd = std::min(int(std::floor(maxY - 0.5f)) + 1, int(_height));
+
+        if (t.colBegin >= t.colEnd || t.rowBegin >= t.rowEnd)
+        {
+            return;
+        }
+
+        // Counter-clockwise: edges going down bound x from below, going up from
+        // above. Edges are set up from their lower end, so the two triangles of
+        // a shared edge compute the same bound and leave no gap between them.
+        int lower = 0, upper = 0;
+
+        for (int i = 0; i < 2; ++i)
+        {
+            t.lowerK[i] = 0.0f;
+            t.lowerM[i] = -FLT_MAX;
+            t.upperK[i] = 0.0f;
+            t.upperM[i] = FLT_MAX;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            int j = i == 2 ? 0 : i + 1;
+            float dy = y[j] - y[i];
+
+            if (std::fabs(dy) < OCCLUSION_MIN_EDGE_HEIGHT)
+            {
+                continue;
+            }
+
+            int a = dy < 0.0f ? j : i;
+            int b = dy < 0.0f ? i : j;
+            float k = (x[b] - x[a]) / (y[b] - y[a]);
+            float m = x[a] - y[a] * k;
+
+            if (dy < 0.0f)
+            {
+                t.lowerK[lower] = k;
+                t.lowerM[lower++] = m;
+            }
+            else
+            {
+                t.upperK[upper] = k;
+                t.upperM[upper++] = m;
+            }
+        }
+
+        t.zx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+        t.zy = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+        t.z0 = z[0] - t.zx * x[0] - t.zy * y[0];
+        t.zMax = std::max(std::max(z[0], z[1]), z[2]);
+
+        U32 first = _bandOfTileRow[t.rowBegin / TILE_HEIGHT];
+        U32 last = _bandOfTileRow[(t.rowEnd - 1) / TILE_HEIGHT];
+
+        for (U32 band = first; band <= last; ++band)
+        {
+            bins[band].push_back(t);
+        }
+    }
+
+
+
+    void OcclusionBuffer::_clipAndBin(const Vec4f* vertices, std::vector<Triangle>* bins) const
+    {
+        Vec4f polygons[2][OCCLUSION_MAX_CLIPPED];
+        int n = 3;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            polygons[0][i] = vertices[i];
+        }
+
+        // Sutherland-Hodgman
+        for (int plane = 0; plane < 5; ++plane)
+        {
+            const Vec4f* input = polygons[plane & 1];
+            Vec4f* output = polygons[(plane + 1) & 1];
+            int m = 0;
+
+            for (int i = 0; i < n; ++i)
+            {
+                const Vec4f& a = input[i];
+                const Vec4f& b = input[i + 1 < n ? i + 1 : 0];
+                float da = occlusionClipDistance(a, plane);
+                float db = occlusionClipDistance(b, plane);
+
+                if (da >= 0.0f)
+                {
+                    output[m++] = a;
+                }
+
+                if ((da >= 0.0f) != (db >= 0.0f))
+                {
+                    output[m++] = a + (b - a) * (da / (da - db));
+                }
+            }
+
+            n = m;
+
+            if (n < 3)
+            {
+                return;
+            }
+        }
+
+        // Five planes: the result is in polygons[1]
+        float x[OCCLUSION_MAX_CLIPPED], y[OCCLUSION_MAX_CLIPPED], z[OCCLUSION_MAX_CLIPPED];
+
+        for (int i = 0; i < n; ++i)
+        {
+            const Vec4f& p = polygons[1][i];
+
+            if (!(p.w > 0.0f))
+            {
+                return;
+            }
+
+            float invW = 1.0f / p.w;
+            x[i] = (p.x * invW * 0.5f + 0.5f) * _width;
+            y[i] = (p.y * invW * 0.5f + 0.5f) * _height;
+            z[i] = p.z * invW * 0.5f + 0.5f;
+        }
+
+        for (int i = 2; i < n; ++i)
+        {
+            float tx[3] = { x[0], x[i - 1], x[i] };
+            float ty[3] = { y[0], y[i - 1], y[i] };
+            float tz[3] = { z[0], z[i - 1], z[i] };
+
+            _bin(tx, ty, tz, bins);
+        }
+    }
+
+
+
+    void OcclusionBuffer::_setup(const int* indices, size_t begin, size_t end, std::vector<Triangle>* bins) const
+    {
+        const size_t vertexCount = _clip.size() / 4;
+        const float* clip[4] = { &_clip[0], &_clip[vertexCount], &_clip[2 * vertexCount], &_clip[3 * vertexCount] };
+        const SIMDInt offsets = SIMDInt::mullo(SIMDInt::sequence(), SIMDInt(3));
+        const SIMDFloat halfWidth(0.5f * _width), halfHeight(0.5f * _height), half(0.5f), zero(0.0f);
+        const SIMDFloat guard(OCCLUSION_GUARD_BAND);
+        const SIMDFloat lastCol(float(_width) - 1.0f), lastRow(float(_height) - 1.0f);
+        ALIGNED_ALLOC_DECL(float, sx[3 * SIMDFloat::WIDTH], NUT_SIMD_ALIGNMENT);
+        ALIGNED_ALLOC_DECL(float, sy[3 * SIMDFloat::WIDTH], NUT_SIMD_ALIGNMENT);
+        ALIGNED_ALLOC_DECL(float, sz[3 * SIMDFloat::WIDTH], NUT_SIMD_ALIGNMENT);
+        size_t t = begin;
+
+        // Reject, cull back faces and triangles between pixel centers, and find
+        // the triangles to clip, @SIMDFloat::WIDTH at a time
+        for (; t + SIMDFloat::WIDTH <= end; t += SIMDFloat::WIDTH)
+        {
+            const I32* triangle = reinterpret_cast<const I32*>(indices + 3 * t);
+            SIMDFloat x[3], y[3], z[3];
+            SIMDFloat left, right, bottom, top, nearSide, farSide, needsClip;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                SIMDInt v = SIMDInt::gather(triangle + k, offsets);
+                SIMDFloat cx = SIMDFloat::gather(clip[0], v);
+                SIMDFloat cy = SIMDFloat::gather(clip[1], v);
+                SIMDFloat cz = SIMDFloat::gather(clip[2], v);
+                SIMDFloat cw = SIMDFloat::gather(clip[3], v);
+                SIMDFloat band = guard * cw;
+                SIMDFloat clipped = (cz < -cw) | (SIMDFloat::abs(cx) > band) | (SIMDFloat::abs(cy) > band) | (cw <= zero);
+
+                if (k == 0)
+                {
+                    left = cx < -cw;
+                    right = cx > cw;
+                    bottom = cy < -cw;
+                    top = cy > cw;
+                    nearSide = cz < -cw;
+                    farSide = cz > cw;
+                    needsClip = clipped;
+                }
+                else
+                {
+                    left &= cx < -cw;
+                    right &= cx > cw;
+                    bottom &= cy < -cw;
+                    top &= cy > cw;
+                    nearSide &= cz < -cw;
+                    farSide &= cz > cw;
+                    needsClip |= clipped;
+                }
+
+                SIMDFloat invW = SIMDFloat(1.0f) / cw;
+                x[k] = SIMDFloat::fmadd(cx * invW, halfWidth, halfWidth);
+                y[k] = SIMDFloat::fmadd(cy * invW, halfHeight, halfHeight);
+                z[k] = SIMDFloat::fmadd(cz * invW, half, half);
+            }
+
+            SIMDFloat rejected = left | right | bottom | top | nearSide | farSide;
+            SIMDFloat area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+            SIMDFloat minX = SIMDFloat::min(SIMDFloat::min(x[0], x[1]), x[2]);
+            SIMDFloat maxX = SIMDFloat::max(SIMDFloat::max(x[0], x[1]), x[2]);
+            SIMDFloat minY = SIMDFloat::min(SIMDFloat::min(y[0], y[1]), y[2]);
+            SIMDFloat maxY = SIMDFloat::max(SIMDFloat::max(y[0], y[1]), y[2]);
+
+            // First and last pixel centers within the bounds, on screen
+            SIMDFloat colFirst = SIMDFloat::max(-SIMDFloat::floor(half - minX), zero);
+            SIMDFloat colLast = SIMDFloat::min(SIMDFloat::floor(maxX - half), lastCol);
+            SIMDFloat rowFirst = SIMDFloat::max(-SIMDFloat::floor(half - minY), zero);
+            SIMDFloat rowLast = SIMDFloat::min(SIMDFloat::floor(maxY - half), lastRow);
+            SIMDFloat drawn = (area > zero) & (colFirst <= colLast) & (rowFirst <= rowLast);
+
+            int drawBits = SIMDFloat::movemask(SIMDFloat::andnot(rejected | needsClip, drawn));
+            int clipBits = SIMDFloat::movemask(SIMDFloat::andnot(rejected, needsClip));
+
+            if (drawBits != 0)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    x[k].store(sx + k * SIMDFloat::WIDTH);
+                    y[k].store(sy + k * SIMDFloat::WIDTH);
+                    z[k].store(sz + k * SIMDFloat::WIDTH);
+                }
+
+                for (int lane = 0; lane < SIMDFloat::WIDTH; ++lane)
+                {
+                    if (drawBits & (1 << lane))
+                    {
+                        float vx[3] = { sx[lane], sx[SIMDFloat::WIDTH + lane], sx[2 * SIMDFloat::WIDTH + lane] };
+                        float vy[3] = { sy[lane], sy[SIMDFloat::WIDTH + lane], sy[2 * SIMDFloat::WIDTH + lane] };
+                        float vz[3] = { sz[lane], sz[SIMDFloat::WIDTH + lane], sz[2 * SIMDFloat::WIDTH + lane] };
+
+                        _bin(vx, vy, vz, bins);
+                    }
+                }
+            }
+
+            for (int lane = 0; clipBits != 0 && lane < SIMDFloat::WIDTH; ++lane)
+            {
+                if (clipBits & (1 << lane))
+                {
+                    const int* v = indices + 3 * (t + lane);
+                    Vec4f vertices[3];
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        vertices[k] = Vec4f(clip[0][v[k]], clip[1][v[k]], clip[2][v[k]], clip[3][v[k]]);
+                    }
+
+                    _clipAndBin(vertices, bins);
+                }
+            }
+        }
+
+        // Remaining triangles: clipping leaves unclipped ones unchanged
+        for (; t < end; ++t)
+        {
+            const int* v = indices + 3 * t;
+            Vec4f vertices[3];
+
+            for (int k = 0; k < 3; ++k)
+            {
+                vertices[k] = Vec4f(clip[0][v[k]], clip[1][v[k]], clip[2][v[k]], clip[3][v[k]]);
+            }
+
+            _clipAndBin(vertices, bins);
+        }
+    }
+
+
+
+    void OcclusionBuffer::_rasterize(const Triangle& triangle, int bandBegin, int bandEnd)
+    {
+        int rowBegin = std::max(triangle.rowBegin, bandBegin);
+        int rowEnd = std::min(triangle.rowEnd, bandEnd);
+
+        if (rowBegin >= rowEnd)
+        {
+            return;
+        }
+
+        const SIMDFloat lowerK0(triangle.lowerK[0]), lowerM0(triangle.lowerM[0]);
+        const SIMDFloat lowerK1(triangle.lowerK[1]), lowerM1(triangle.lowerM[1]);
+        const SIMDFloat upperK0(triangle.upperK[0]), upperM0(triangle.upperM[0]);
+        const SIMDFloat upperK1(triangle.upperK[1]), upperM1(triangle.upperM[1]);
+        const SIMDFloat colBegin(float(triangle.colBegin)), colEnd(float(triangle.colEnd)), half(0.5f);
+        const SIMDInt rows = SIMDInt::sequence(), none(0), all(-1), width(TILE_WIDTH);
+        int txBegin = triangle.colBegin / TILE_WIDTH;
+        int txEnd = (triangle.colEnd + TILE_WIDTH - 1) / TILE_WIDTH;
+
+        for (int ty = rowBegin / TILE_HEIGHT; ty * TILE_HEIGHT < rowEnd; ++ty)
+        {
+            // Span of every row, one row per lane
+            int y0 = ty * TILE_HEIGHT;
+            SIMDInt row = rows + SIMDInt(y0);
+            SIMDFloat y = SIMDFloat::fromInt(row) + half;
+            SIMDFloat start = SIMDFloat::max(SIMDFloat::fmadd(lowerK0, y, lowerM0), SIMDFloat::fmadd(lowerK1, y, lowerM1));
+            SIMDFloat end = SIMDFloat::min(SIMDFloat::fmadd(upperK0, y, upperM0), SIMDFloat::fmadd(upperK1, y, upperM1));
+
+            // Columns whose centers are in [start, end], as [first, last)
+            SIMDFloat first = SIMDFloat::min(SIMDFloat::max(-SIMDFloat::floor(half - start), colBegin), colEnd);
+            SIMDFloat last = SIMDFloat::max(SIMDFloat::min(SIMDFloat::floor(end - half) + SIMDFloat(1.0f), colEnd), colBegin);
+            SIMDInt firstCol = SIMDInt::fromFloat(first);
+            SIMDInt lastCol = SIMDInt::fromFloat(last);
+            SIMDInt inside = (row > SIMDInt(rowBegin - 1)) & (row < SIMDInt(rowEnd));
+
+            lastCol = SIMDInt::select(inside, lastCol, firstCol);
+
+            // Farthest depth over the rows of the tile the triangle touches
+            float yLow = std::max(y0, rowBegin) + 0.5f;
+            float yHigh = std::min(y0 + TILE_HEIGHT, rowEnd) - 0.5f;
+            float zRow = triangle.z0 + triangle.zy * (triangle.zy > 0.0f ? yHigh : yLow);
+
+            for (int tx = txBegin; tx < txEnd; ++tx)
+            {
+                SIMDInt x0(tx * TILE_WIDTH);
+                SIMDInt begin = SIMDInt::min(SIMDInt::max(firstCol - x0, none), width);
+                SIMDInt stop = SIMDInt::min(SIMDInt::max(lastCol - x0, none), width);
+                SIMDInt coverage = SIMDInt::sllv(all, begin) & (SIMDInt::sllv(all, stop) ^ all);
+
+                if (SIMDInt::movemask(coverage == none) == OCCLUSION_ALL_LANES)
+                {
+                    continue;
+                }
+
+                float xLow = std::max(tx * TILE_WIDTH, triangle.colBegin) + 0.5f;
+                float xHigh = std::min((tx + 1) * TILE_WIDTH, triangle.colEnd) - 0.5f;
+                float z = zRow + triangle.zx * (triangle.zx > 0.0f ? xHigh : xLow);
+
+                _updateTile(size_t(ty) * _tilesX + tx, coverage, std::min(z, triangle.zMax));
+            }
+        }
+    }
+
+
+
+    void OcclusionBuffer::_updateTile(size_t t, const SIMDInt& coverage, float z)
+    {
+        Tile& tile = _tiles[t];
+
+        if (z >= tile.zMax0)
+        {
+            return;
+        }
+
+        I32* rows = reinterpret_cast<I32*>(&_masks[t * TILE_HEIGHT]);
+        const SIMDInt none(0), all(-1);
+        SIMDInt mask = SIMDInt::loadu(rows);
+
+        if (SIMDInt::movemask(coverage == all) == OCCLUSION_ALL_LANES)
+        {
+            // Covers the whole tile: the working layer only helps if nearer
+            tile.zMax0 = z;
+
+            if (tile.zMax1 >= z)
+            {
+                none.storeu(rows);
+            }
+
+            return;
+        }
+
+        if (SIMDInt::movemask(mask == none) == OCCLUSION_ALL_LANES ||
+            std::fabs(z - tile.zMax1) > tile.zMax0 - tile.zMax1)
+        {
+            // Start a new working layer; the old one is nearer the tile depth
+            // than the triangle is to it
+            tile.zMax1 = z;
+            mask = coverage;
+        }
+        else
+        {
+            tile.zMax1 = std::max(tile.zMax1, z);
+            mask |= coverage;
+        }
+
+        if (SIMDInt::movemask(mask == all) == OCCLUSION_ALL_LANES)
+        {
+            tile.zMax0 = tile.zMax1;
+            mask = none;
+        }
+
+        mask.storeu(rows);
+    }
+}
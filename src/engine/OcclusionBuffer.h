@@ -0,0 +1,243 @@
+/** 
+ * \file OcclusionBuffer.h
+ * \brief Class definition for a masked hierarchical depth buffer, used to cull
+ * objects hidden behind occluders on the CPU (no GPU occlusion queries).
+ * 
+ * Occluder meshes are rasterized at low resolution in the way of masked
+ * software occlusion culling (Hasselgren, Andersson and Akenine-Moller, "Masked
+ * Software Occlusion Culling", HPG 2016). The screen is split in tiles of
+ * @TILE_WIDTH x @TILE_HEIGHT pixels, and tiles store no per pixel depth. A tile
+ * keeps a conservative (farthest) depth valid for all its pixels, which is the
+ * coarse level of the hierarchy, and a working layer: a coverage bit per pixel
+ * and the farthest depth of the covered pixels. When the working layer covers
+ * the whole tile, it becomes the tile depth.
+ * 
+ * Rendering transforms the vertices @SIMDFloat::WIDTH at a time, sets up and
+ * bins the triangles into bands of tile rows in parallel, then rasterizes the
+ * bands in parallel. Rasterization computes the covered span of one pixel row
+ * per SIMD lane (the tile height is @SIMDInt::WIDTH), so the coverage of a tile
+ * takes a few instructions. Bands draw their triangles in submission order,
+ * which makes the result independent of the number of threads.
+ * 
+ * Matrices follow OpenGL conventions (as built by @GLMatrix::setPerspective());
+ * depths are window depths in [0, 1]. Front faces are counter-clockwise; back
+ * faces don't occlude. Occludees are tested through the screen rectangle and
+ * the nearest depth of their bounding box, so they are only reported hidden
+ * when the occluders are in front of that whole rectangle.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef OCCLUSIONBUFFER_H
+#define OCCLUSIONBUFFER_H
+
+#include <cstddef>
+#include <vector>
+#include "BoundingBox.h"
+#include "DataType.h"
+#include "GLMatrix.h"
+#include "SIMD.h"
+#include "Vector.h"
+
+
+
+namespace nut
+{
+    class Mesh;
+
+    class OcclusionBuffer
+    {
+        public:
+
+        static const int TILE_WIDTH = 32;               /**< Tile width in pixels (a coverage row fits a @U32). */
+        static const int TILE_HEIGHT = SIMDInt::WIDTH;  /**< Tile height in pixels (one row per lane). */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor.
+         * 
+         * Instantiates an empty buffer, which occludes nothing.
+         */
+        OcclusionBuffer();
+
+        /**
+         * Instantiates a cleared buffer (see @resize()).
+         */
+        OcclusionBuffer(U32 width, U32 height);
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Set the resolution and clear the buffer.
+         * 
+         * @param width Width in pixels, a multiple of 32.
+         * @param height Height in pixels, a multiple of 8.
+         * @return False if the resolution is not valid (the buffer is left
+         * unchanged).
+         */
+        bool resize(U32 width, U32 height);
+
+        U32 getWidth() const
+        {
+            return _width;
+        }
+
+        U32 getHeight() const
+        {
+            return _height;
+        }
+
+        /**
+         * \brief Remove all occluders.
+         */
+        void clear();
+
+        /**
+         * \brief Rasterize occluder triangles.
+         * 
+         * Not thread-safe: it uses scratch memory of the buffer, and threads
+         * from the @ThreadPool itself.
+         * 
+         * @param positions Address of the first vertex's x coordinate.
+         * @param vertexCount Number of vertices.
+         * @param stride Distance between consecutive vertices, in floats.
+         * @param indices Three vertex indices per triangle.
+         * @param triangleCount Number of triangles.
+         * @param modelViewProjection Matrix from the space of @positions to clip
+         * space.
+         * @return False if the indices are invalid; nothing is rasterized then.
+         */
+        bool render(const float* positions, size_t vertexCount, size_t stride, const int* indices,
+                    size_t triangleCount, const GLMatrix<float>& modelViewProjection);
+
+        /**
+         * \brief Rasterize the triangles of a mesh as occluders.
+         * 
+         * @return False if the mesh has invalid indices.
+         */
+        bool render(const Mesh& mesh, const GLMatrix<float>& modelViewProjection);
+
+        /**
+         * \brief Check if a box may be visible behind the occluders.
+         * 
+         * Conservative: boxes crossing or behind the near plane are visible
+         * (they are left to frustum culling); boxes outside the viewport are
+         * hidden.
+         * 
+         * @param box The box.
+         * @param viewProjection Matrix from the space of @box to clip space.
+         * @return False if the box is certainly hidden.
+         */
+        bool isVisible(const BoundingBox& box, const GLMatrix<float>& viewProjection) const;
+
+        /**
+         * \brief Cull an array of boxes, split across the @ThreadPool.
+         * 
+         * @param boxes Boxes.
+         * @param count Number of boxes.
+         * @param viewProjection Matrix from the space of @boxes to clip space.
+         * @param visible Receives the indices of the visible boxes, in increasing
+         * order. Must have room for @count elements.
+         * @return Number of visible boxes.
+         */
+        size_t cullBoxes(const BoundingBox* boxes, size_t count, const GLMatrix<float>& viewProjection,
+                         U32* visible) const;
+
+        /**
+         * \brief Get the conservative depth of a pixel: no occluder drawn so
+         * far is visible behind it. 1 where nothing was drawn.
+         * 
+         * @param x Column, from the left.
+         * @param y Row, from the bottom.
+         */
+        float getDepth(U32 x, U32 y) const;
+
+
+
+        private:
+
+        /**
+         * \brief Depths of a tile; its coverage mask is in @_masks.
+         */
+        struct Tile
+        {
+            float zMax0; /**< Farthest depth of the whole tile. */
+            float zMax1; /**< Farthest depth of the pixels in the coverage mask. */
+        };
+
+        /**
+         * \brief Triangle set up for rasterization, in pixel units.
+         * 
+         * The covered span of row y is [max of lower edges, min of upper edges],
+         * where an edge bounds x at k * y + m.
+         */
+        struct Triangle
+        {
+            float lowerK[2], lowerM[2];
+            float upperK[2], upperM[2];
+            float zx, zy, z0;           /**< Depth plane: z = zx * x + zy * y + z0. */
+            float zMax;                 /**< Farthest vertex depth. */
+            int colBegin, colEnd;       /**< Columns whose centers are in the bounds. */
+            int rowBegin, rowEnd;       /**< Rows whose centers are in the bounds. */
+        };
+
+
+
+        /// Private attributes ///
+
+        U32 _width;
+        U32 _height;
+        U32 _tilesX;
+        U32 _tilesY;
+        std::vector<Tile> _tiles;
+        std::vector<U32> _masks;                  /**< @TILE_HEIGHT coverage rows per tile. */
+        std::vector<U32> _bandOfTileRow;          /**< Raster band of each tile row. */
+        std::vector<U32> _bandRows;               /**< First pixel row of each band, plus the height. */
+
+        // Scratch memory of @render()
+        std::vector<float> _clip;                 /**< Clip space x, y, z and w arrays of the vertices. */
+        std::vector< std::vector<Triangle> > _bins; /**< Triangles per setup chunk and band. */
+
+
+
+        /// Private methods ///
+
+        /**
+         * \brief Set up a counter-clockwise screen space triangle and add it to
+         * the bins of the bands it touches. Triangles covering no pixel center
+         * are dropped.
+         */
+        void _bin(const float* x, const float* y, const float* z, std::vector<Triangle>* bins) const;
+
+        /**
+         * \brief Clip a triangle against the near plane and the guard band,
+         * then bin the pieces.
+         */
+        void _clipAndBin(const Vec4f* vertices, std::vector<Triangle>* bins) const;
+
+        /**
+         * \brief Set up and bin the triangles in [begin, end).
+         */
+        void _setup(const int* indices, size_t begin, size_t end, std::vector<Triangle>* bins) const;
+
+        /**
+         * \brief Rasterize the rows of a triangle in [rowBegin, rowEnd).
+         */
+        void _rasterize(const Triangle& triangle, int rowBegin, int rowEnd);
+
+        /**
+         * \brief Merge a triangle's coverage of a tile, at conservative depth @z.
+         */
+        void _updateTile(size_t tile, const SIMDInt& coverage, float z);
+    };
+}
+
+#endif // OCCLUSIONBUFFER_H
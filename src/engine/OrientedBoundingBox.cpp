@@ -0,0 +1,290 @@
+/** 
+ * \file OrientedBoundingBox.cpp
+ * \brief Class definition for an oriented bounding box (OBB).
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <cmath>
+#include <vector>
+#include "OrientedBoundingBox.h"
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    /**
+     * Added to the rotation terms of the separating axis test, so edge pairs
+     * that are nearly parallel (cross product close to zero) can't report a
+     * separation because of rounding.
+     */
+    static const float OBB_PARALLEL_EPSILON = 1e-6f;
+
+    static const size_t OBB_FIT_GRAIN = 64 * 1024; /**< Points per parallel fitting task. */
+
+
+
+    /**
+     * \brief Sums for the covariance of a range of points, relative to a
+     * reference point to avoid cancellation.
+     */
+    struct OBBMoments
+    {
+        double sum[3];
+        double products[6]; /**< xx, xy, xz, yy, yz, zz. */
+
+        OBBMoments()
+        {
+            for (int i = 0; i < 3; ++i) sum[i] = 0.0;
+            for (int i = 0; i < 6; ++i) products[i] = 0.0;
+        }
+    };
+
+
+
+    OrientedBoundingBox::OrientedBoundingBox() : center(0.0f, 0.0f, 0.0f), halfExtents(0.0f, 0.0f, 0.0f)
+    {
+    }
+
+
+
+    OrientedBoundingBox::OrientedBoundingBox(const Vec3f& center, const Vec3f& halfExtents,
+                                             const Matrix3x3<float>& basis)
+        : center(center), halfExtents(halfExtents), basis(basis)
+    {
+    }
+
+
+
+    OrientedBoundingBox::OrientedBoundingBox(const BoundingBox& box)
+        : center(box.getCenter()), halfExtents(box.getExtents())
+    {
+    }
+
+
+
+    void OrientedBoundingBox::getCorners(Vec3f corners[8]) const
+    {
+        Vec3f u = getAxis(0) * halfExtents.x;
+        Vec3f v = getAxis(1) * halfExtents.y;
+        Vec3f w = getAxis(2) * halfExtents.z;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            corners[i] = center + (i & 1 ? u : -u) + (i & 2 ? v : -v) + (i & 4 ? w : -w);
+        }
+    }
+
+
+
+    BoundingBox OrientedBoundingBox::getBoundingBox() const
+    {
+        // Projected radius on each world axis
+        Vec3f r(std::fabs(basis[0]) * halfExtents.x + std::fabs(basis[3]) * halfExtents.y + std::fabs(basis[6]) * halfExtents.z,
+                std::fabs(basis[1]) * halfExtents.x + std::fabs(basis[4]) * halfExtents.y + std::fabs(basis[7]) * halfExtents.z,
+                std::fabs(basis[2]) * halfExtents.x + std::fabs(basis[5]) * halfExtents.y + std::fabs(basis[8]) * halfExtents.z);
+
+        return BoundingBox(center - r, center + r);
+    }
+
+
+
+    bool OrientedBoundingBox::contains(const Vec3f& p) const
+    {
+        Vec3f d = p - center;
+        const float e[3] = { halfExtents.x, halfExtents.y, halfExtents.z };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            if (std::fabs(d * getAxis(i)) > e[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+
+    bool OrientedBoundingBox::overlaps(const OrientedBoundingBox& b) const
+    {
+        const float ea[3] = { halfExtents.x, halfExtents.y, halfExtents.z };
+        const float eb[3] = { b.halfExtents.x, b.halfExtents.y, b.halfExtents.z };
+        const Vec3f a[3] = { getAxis(0), getAxis(1), getAxis(2) };
+        const Vec3f ab[3] = { b.getAxis(0), b.getAxis(1), b.getAxis(2) };
+        float r[3][3], absR[3][3];
+
+        // Rotation from b to this box's frame, and translation in this frame
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                r[i][j] = a[i] * ab[j];
+                absR[i][j] = std::fabs(r[i][j]) + OBB_PARALLEL_EPSILON;
+            }
+        }
+
+        Vec3f d = b.center - center;
+        const float t[3] = { d * a[0], d * a[1], d * a[2] };
+
+        // Axes of this box
+        for (int i = 0; i < 3; ++i)
+        {
+            float rb = eb[0] * absR[i][0] + eb[1] * absR[i][1] + eb[2] * absR[i][2];
+
+            if (std::fabs(t[i]) > ea[i] + rb)
+            {
+                return false;
+            }
+        }
+
+        // Axes of b
+        for (int j = 0; j < 3; ++j)
+        {
+            float ra = ea[0] * absR[0][j] + ea[1] * absR[1][j] + ea[2] * absR[2][j];
+
+            if (std::fabs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > ra + eb[j])
+            {
+                return false;
+            }
+        }
+
+        // Cross products a[i] x ab[j]
+        for (int i = 0; i < 3; ++i)
+        {
+            const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+
+            for (int j = 0; j < 3; ++j)
+            {
+                const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+                float ra = ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j];
+                float rb = eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1];
+
+                if (std::fabs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+
+
+    bool OrientedBoundingBox::overlaps(const BoundingBox& box) const
+    {
+        return overlaps(OrientedBoundingBox(box));
+    }
+
+
+
+    OrientedBoundingBox OrientedBoundingBox::fit(const float* positions, size_t count, size_t stride)
+    {
+        if (count == 0)
+        {
+            return OrientedBoundingBox();
+        }
+
+        ThreadPool& pool = ThreadPool::getInstance();
+        const size_t chunks = (count + OBB_FIT_GRAIN - 1) / OBB_FIT_GRAIN;
+        const double origin[3] = { positions[0], positions[1], positions[2] };
+
+        // Covariance of the points
+        std::vector<OBBMoments> moments(chunks);
+
+        pool.parallelFor(count, OBB_FIT_GRAIN, [&](size_t begin, size_t end)
+        {
+            OBBMoments& m = moments[begin / OBB_FIT_GRAIN];
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const float* p = positions + i * stride;
+                double x = p[0] - origin[0], y = p[1] - origin[1], z = p[2] - origin[2];
+
+                m.sum[0] += x;
+                m.sum[1] += y;
+                m.sum[2] += z;
+                m.products[0] += x * x;
+                m.products[1] += x * y;
+                m.products[2] += x * z;
+                m.products[3] += y * y;
+                m.products[4] += y * z;
+                m.products[5] += z * z;
+            }
+        });
+
+        OBBMoments total;
+
+        for (size_t c = 0; c < chunks; ++c)
+        {
+            for (int i = 0; i < 3; ++i) total.sum[i] += moments[c].sum[i];
+            for (int i = 0; i < 6; ++i) total.products[i] += moments[c].products[i];
+        }
+
+        const double n = double(count);
+        const double mean[3] = { total.sum[0] / n, total.sum[1] / n, total.sum[2] / n };
+        float cxx = float(total.products[0] / n - mean[0] * mean[0]);
+        float cxy = float(total.products[1] / n - mean[0] * mean[1]);
+        float cxz = float(total.products[2] / n - mean[0] * mean[2]);
+        float cyy = float(total.products[3] / n - mean[1] * mean[1]);
+        float cyz = float(total.products[4] / n - mean[1] * mean[2]);
+        float czz = float(total.products[5] / n - mean[2] * mean[2]);
+
+        Matrix3x3<float> covariance(cxx, cxy, cxz,
+                                    cxy, cyy, cyz,
+                                    cxz, cyz, czz);
+        Vec3f variances;
+        OrientedBoundingBox box;
+        covariance.symmetricEigen(variances, box.basis);
+
+        // Extents of the points along the principal axes
+        const Vec3f axes[3] = { box.getAxis(0), box.getAxis(1), box.getAxis(2) };
+        std::vector<BoundingBox> ranges(chunks);
+
+        pool.parallelFor(count, OBB_FIT_GRAIN, [&](size_t begin, size_t end)
+        {
+            BoundingBox& range = ranges[begin / OBB_FIT_GRAIN];
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const float* p = positions + i * stride;
+                Vec3f q(p[0], p[1], p[2]);
+                range.expand(Vec3f(q * axes[0], q * axes[1], q * axes[2]));
+            }
+        });
+
+        BoundingBox local;
+
+        for (size_t c = 0; c < chunks; ++c)
+        {
+            local.merge(ranges[c]);
+        }
+
+        Vec3f mid = local.getCenter();
+        box.center = axes[0] * mid.x + axes[1] * mid.y + axes[2] * mid.z;
+        box.halfExtents = local.getExtents();
+
+        return box;
+    }
+
+
+
+    OrientedBoundingBox OrientedBoundingBox::fit(const Mesh& mesh)
+    {
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+
+        if (vertices.empty())
+        {
+            return OrientedBoundingBox();
+        }
+
+        return fit(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float));
+    }
+}
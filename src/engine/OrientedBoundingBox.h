@@ -1,23 +1,135 @@
-/** \file OrientedBoundingBox.h
- *  \brief Class definition for an oriented bounding box.
+/** 
+ * \file OrientedBoundingBox.h
+ * \brief Class definition for an oriented bounding box (OBB).
+ * 
+ * The box is the set of points center + basis * (x, y, z) with |x|, |y| and |z|
+ * bounded by the half-extents. Basis columns are unit length and orthogonal.
+ * 
+ * Overlap tests use the separating axis theorem (Gottschalk, Lin and Manocha,
+ * "OBBTree: a hierarchical structure for rapid interference detection", 1996)
+ * and fitting uses principal component analysis of the points.
  * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
  * 
- * @author: Eder A. Perez
+ * @author: Eder A. Perez.
  */
 
 #ifndef ORIENTEDBOUNDINGBOX_H
 #define ORIENTEDBOUNDINGBOX_H
 
+#include <cstddef>
+#include "BoundingBox.h"
+#include "Matrix3x3.h"
+#include "Vector.h"
+
 
 
 namespace nut
 {
-	class OrientedBoundingBox
-	{
+    class Mesh;
+
+    class OrientedBoundingBox
+    {
+        public:
+
+        Vec3f center;           /**< Box center. */
+        Vec3f halfExtents;      /**< Half of the box size along each axis. */
+        Matrix3x3<float> basis; /**< Box axes as columns. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor.
+         * 
+         * Instantiates a degenerate box (a point) at the origin.
+         */
+        OrientedBoundingBox();
+
+        /**
+         * Instantiates a box.
+         * 
+         * @param center Box center.
+         * @param halfExtents Half of the box size along each axis.
+         * @param basis Orthonormal box axes as columns.
+         */
+        OrientedBoundingBox(const Vec3f& center, const Vec3f& halfExtents, const Matrix3x3<float>& basis);
+
+        /**
+         * Instantiates the box covering the same space as an AABB.
+         */
+        explicit OrientedBoundingBox(const BoundingBox& box);
+
+
+
+        /// Methods ///
+
+        /**
+         * Get one of the box axes.
+         * 
+         * @param i Axis index in [0, 3).
+         */
+        Vec3f getAxis(int i) const
+        {
+            return Vec3f(basis[3 * i], basis[3 * i + 1], basis[3 * i + 2]);
+        }
+
+        /**
+         * Compute the box volume.
+         */
+        float getVolume() const
+        {
+            return 8.0f * halfExtents.x * halfExtents.y * halfExtents.z;
+        }
+
+        /**
+         * Compute the eight box corners.
+         */
+        void getCorners(Vec3f corners[8]) const;
+
+        /**
+         * Compute the smallest AABB enclosing the box.
+         */
+        BoundingBox getBoundingBox() const;
+
+        /**
+         * Check if a point is inside the box (boundary included).
+         */
+        bool contains(const Vec3f& p) const;
+
+        /**
+         * \brief Check if two boxes overlap with the 15-axis separating axis test.
+         * 
+         * Face axes are tested first since they separate most disjoint pairs,
+         * then the nine edge-edge axes.
+         */
+        bool overlaps(const OrientedBoundingBox& b) const;
+
+        /**
+         * \brief Check if the box overlaps an AABB.
+         */
+        bool overlaps(const BoundingBox& box) const;
+
+        /**
+         * \brief Fit a box to a set of points. The axes are the principal
+         * directions of the points (eigenvectors of their covariance matrix).
+         * 
+         * Large sets are processed in parallel.
+         * 
+         * @param positions Address of the first point's x coordinate.
+         * @param count Number of points.
+         * @param stride Distance between consecutive points, in floats.
+         * @return The fitted box (degenerate at the origin if @count is zero).
+         */
+        static OrientedBoundingBox fit(const float* positions, size_t count, size_t stride = 3);
 
-	};
+        /**
+         * \brief Fit a box to a mesh's vertex positions.
+         */
+        static OrientedBoundingBox fit(const Mesh& mesh);
+    };
 }
 
 #endif // ORIENTEDBOUNDINGBOX_H
@@ -0,0 +1,303 @@
+/** 
+ * \file Plane.cpp
+ * \brief Class definition for a plane.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <unordered_map>
+#include <vector>
+#include "Mesh.h"
+#include "Plane.h"
+#include "SIMD.h"
+
+
+
+namespace nut
+{
+    /**
+     * One part of a sliced mesh, indexed: source and cut vertices are copied
+     * the first time a triangle of the part uses them.
+     */
+    struct PlanePart
+    {
+        std::vector<Vertex> vertices;
+        std::vector<int> triangulation;
+        std::vector<int> remap; /**< Output index of each source or cut vertex, -1 if not copied yet. */
+
+        int add(const std::vector<Vertex>& source, const std::vector<Vertex>& cuts, int index)
+        {
+            if (index >= int(remap.size()))
+            {
+                remap.resize(source.size() + cuts.size(), -1);
+            }
+
+            if (remap[index] < 0)
+            {
+                remap[index] = int(vertices.size());
+                vertices.push_back(index < int(source.size()) ? source[index] : cuts[index - source.size()]);
+            }
+
+            return remap[index];
+        }
+
+        /**
+         * Fan-triangulate a convex polygon of source or cut vertex indices.
+         */
+        void addPolygon(const std::vector<Vertex>& source, const std::vector<Vertex>& cuts, const int* polygon, int size)
+        {
+            for (int i = 2; i < size; ++i)
+            {
+                triangulation.push_back(add(source, cuts, polygon[0]));
+                triangulation.push_back(add(source, cuts, polygon[i - 1]));
+                triangulation.push_back(add(source, cuts, polygon[i]));
+            }
+        }
+    };
+
+
+
+    /**
+     * Unit length copy of @v, or @v itself if it is zero.
+     */
+    static inline Vec3f planeNormalized(const Vec3f& v)
+    {
+        float length = v.length();
+
+        return length > 0.0f ? v / length : v;
+    }
+
+    /**
+     * Split @mesh into @front and @back (either may be null to drop that part).
+     * The parts are built aside, so they may alias @mesh.
+     */
+    static void planeSplit(const Plane& plane, const Mesh& mesh, Mesh* front, Mesh* back, float epsilon)
+    {
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+        const std::vector<int>& triangulation = mesh.getTriangulation();
+        size_t count = vertices.size();
+        std::vector<float> distances(count);
+        std::vector<signed char> sides(count);
+        int anyFront = 0, anyBack = 0;
+
+        if (count > 0)
+        {
+            plane.getSignedDistances(&vertices[0].pos.x, count, sizeof(Vertex) / sizeof(float), &distances[0]);
+        }
+
+        // Classify the vertices: 1 in front, -1 behind, 0 on the plane
+        SIMDFloat upper(epsilon), lower(-epsilon);
+        size_t i = 0;
+
+        for (; i + SIMDFloat::WIDTH <= count; i += SIMDFloat::WIDTH)
+        {
+            SIMDFloat d = SIMDFloat::loadu(&distances[i]);
+            int frontMask = SIMDFloat::movemask(d > upper);
+            int backMask = SIMDFloat::movemask(d < lower);
+
+            for (int k = 0; k < SIMDFloat::WIDTH; ++k)
+            {
+                sides[i + k] = static_cast<signed char>(((frontMask >> k) & 1) - ((backMask >> k) & 1));
+            }
+
+            anyFront |= frontMask;
+            anyBack |= backMask;
+        }
+
+        for (; i < count; ++i)
+        {
+            sides[i] = static_cast<signed char>((distances[i] > epsilon) - (distances[i] < -epsilon));
+            anyFront |= sides[i] > 0;
+            anyBack |= sides[i] < 0;
+        }
+
+        // Nothing crosses the plane: the whole mesh goes to one side
+        if (anyBack == 0 || anyFront == 0)
+        {
+            Mesh* whole = anyBack == 0 ? front : back;
+            Mesh* empty = anyBack == 0 ? back : front;
+
+            if (whole != nullptr && whole != &mesh)
+            {
+                whole->getVertices() = vertices;
+                whole->getTriangulation() = triangulation;
+            }
+
+            if (empty != nullptr && empty != whole)
+            {
+                empty->getVertices().clear();
+                empty->getTriangulation().clear();
+            }
+
+            return;
+        }
+
+        PlanePart parts[2];
+        std::vector<Vertex> cuts;
+        std::unordered_map<U64, int> cutIndices;
+
+        for (size_t t = 0; t + 2 < triangulation.size(); t += 3)
+        {
+            const int* triangle = &triangulation[t];
+            int s0 = sides[triangle[0]], s1 = sides[triangle[1]], s2 = sides[triangle[2]];
+
+            // Not crossing: triangles on the plane go to the front part
+            if (s0 >= 0 && s1 >= 0 && s2 >= 0)
+            {
+                if (front != nullptr)
+                {
+                    parts[0].addPolygon(vertices, cuts, triangle, 3);
+                }
+
+                continue;
+            }
+
+            if (s0 <= 0 && s1 <= 0 && s2 <= 0)
+            {
+                if (back != nullptr)
+                {
+                    parts[1].addPolygon(vertices, cuts, triangle, 3);
+                }
+
+                continue;
+            }
+
+            // Sutherland-Hodgman against both half-spaces at once
+            int frontPolygon[4], backPolygon[4];
+            int frontSize = 0, backSize = 0;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                int a = triangle[k];
+                int b = triangle[(k + 1) % 3];
+
+                if (sides[a] >= 0)
+                {
+                    frontPolygon[frontSize++] = a;
+                }
+
+                if (sides[a] <= 0)
+                {
+                    backPolygon[backSize++] = a;
+                }
+
+                if (sides[a] * sides[b] < 0)
+                {
+                    // Shared by the neighbor triangle: computed once, from the lower index
+                    int lo = a < b ? a : b;
+                    int hi = a < b ? b : a;
+                    U64 key = (U64(U32(lo)) << 32) | U32(hi);
+                    std::unordered_map<U64, int>::iterator it = cutIndices.find(key);
+                    int cut;
+
+                    if (it != cutIndices.end())
+                    {
+                        cut = it->second;
+                    }
+                    else
+                    {
+                        const Vertex& va = vertices[lo];
+                        const Vertex& vb = vertices[hi];
+                        float s = distances[lo] / (distances[lo] - distances[hi]);
+                        Vertex v;
+
+                        v.pos = va.pos + (vb.pos - va.pos) * s;
+                        v.normal = planeNormalized(va.normal + (vb.normal - va.normal) * s);
+                        v.tangent = planeNormalized(va.tangent + (vb.tangent - va.tangent) * s);
+                        v.bitangent = planeNormalized(va.bitangent + (vb.bitangent - va.bitangent) * s);
+
+                        cut = int(count + cuts.size());
+                        cuts.push_back(v);
+                        cutIndices[key] = cut;
+                    }
+
+                    frontPolygon[frontSize++] = cut;
+                    backPolygon[backSize++] = cut;
+                }
+            }
+
+            if (front != nullptr)
+            {
+                parts[0].addPolygon(vertices, cuts, frontPolygon, frontSize);
+            }
+
+            if (back != nullptr)
+            {
+                parts[1].addPolygon(vertices, cuts, backPolygon, backSize);
+            }
+        }
+
+        if (front != nullptr)
+        {
+            front->getVertices().swap(parts[0].vertices);
+            front->getTriangulation().swap(parts[0].triangulation);
+        }
+
+        if (back != nullptr)
+        {
+            back->getVertices().swap(parts[1].vertices);
+            back->getTriangulation().swap(parts[1].triangulation);
+        }
+    }
+
+
+
+    void Plane::getSignedDistances(const float* positions, size_t count, size_t stride, float* distances) const
+    {
+        SIMDInt offsets = SIMDInt::mullo(SIMDInt::sequence(), SIMDInt(I32(stride)));
+        SIMDFloat nx(normal.x), ny(normal.y), nz(normal.z), d(distance);
+        size_t i = 0;
+
+        for (; i + SIMDFloat::WIDTH <= count; i += SIMDFloat::WIDTH)
+        {
+            const float* p = positions + i * stride;
+            SIMDFloat x = SIMDFloat::gather(p, offsets);
+            SIMDFloat y = SIMDFloat::gather(p + 1, offsets);
+            SIMDFloat z = SIMDFloat::gather(p + 2, offsets);
+
+            SIMDFloat::fmadd(nx, x, SIMDFloat::fmadd(ny, y, SIMDFloat::fmadd(nz, z, d))).storeu(distances + i);
+        }
+
+        for (; i < count; ++i)
+        {
+            const float* p = positions + i * stride;
+            distances[i] = getSignedDistance(Vec3f(p[0], p[1], p[2]));
+        }
+    }
+
+
+
+    bool Plane::intersect(const Plane& plane, Line& line) const
+    {
+        Vec3f u = normal.cross(plane.normal);
+        float uu = u * u;
+
+        if (uu <= Segment::PARALLEL_EPSILON * (normal * normal) * (plane.normal * plane.normal))
+        {
+            return false;
+        }
+
+        // Planes n.x = h: the line passes through (h1 n2 - h2 n1) x u / |u|^2
+        line.point = (plane.normal.cross(u) * -distance + u.cross(normal) * -plane.distance) / uu;
+        line.direction = u;
+
+        return true;
+    }
+
+
+
+    void Plane::slice(const Mesh& mesh, Mesh& front, Mesh& back, float epsilon) const
+    {
+        planeSplit(*this, mesh, &front, &back, epsilon);
+    }
+
+
+
+    void Plane::clip(const Mesh& mesh, Mesh& front, float epsilon) const
+    {
+        planeSplit(*this, mesh, &front, nullptr, epsilon);
+    }
+}
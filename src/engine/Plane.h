@@ -1,23 +1,183 @@
-/** \file Plane.h
- *  \brief Class definition for a plane.
+/** 
+ * \file Plane.h
+ * \brief Class definition for a plane.
+ * 
+ * The plane is the set of points p where dot(normal, p) + distance = 0.
+ * Points with positive signed distance are in front of it (the side the normal
+ * points to).
+ * 
+ * Meshes can be sliced by a plane into the parts in front of and behind it, or
+ * clipped to keep the part in front (decals, destruction, portal clipping).
+ * Vertex distances are computed @SIMDFloat::WIDTH at a time; triangles
+ * crossing the plane are clipped with Sutherland-Hodgman and fanned, with the
+ * new vertices shared between neighbor triangles so the parts stay indexed
+ * meshes without cracks.
  * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
  * 
- * @author: Eder A. Perez
+ * @author: Eder A. Perez.
  */
 
 #ifndef PLANE_H
 #define PLANE_H
 
+#include <cmath>
+#include <cstddef>
+#include "Line.h"
+#include "Ray.h"
+#include "Vector.h"
+
 
 
 namespace nut
 {
-	class Plane
-	{
+    class Mesh;
+
+    class Plane
+    {
+        public:
+
+        Vec3f normal;   /**< Plane normal. */
+        float distance; /**< Signed distance from the plane to the origin, along -normal. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor.
+         * 
+         * Instantiates the plane z = 0, facing +z.
+         */
+        Plane() : normal(0.0f, 0.0f, 1.0f), distance(0.0f)
+        {
+        }
+
+        /**
+         * Instantiates a plane from its equation coefficients.
+         * 
+         * @param normal Plane normal (not required to be unit length).
+         * @param distance Constant term of the plane equation.
+         */
+        Plane(const Vec3f& normal, float distance) : normal(normal), distance(distance)
+        {
+        }
+
+        /**
+         * Instantiates a plane from a normal and a point on it.
+         * 
+         * @param normal Plane normal.
+         * @param point Point on the plane.
+         */
+        Plane(const Vec3f& normal, const Vec3f& point) : normal(normal), distance(-(normal * point))
+        {
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Scale the plane equation so the normal has unit length. Signed
+         * distances become Euclidean distances.
+         */
+        void normalize()
+        {
+            float length = normal.length();
+
+            if (length > Math<float>::EPSILON)
+            {
+                float rLength = 1.0f / length;
+                normal *= rLength;
+                distance *= rLength;
+            }
+        }
+
+        /**
+         * Compute the signed distance from a point to the plane (scaled by the
+         * normal length if it's not normalized).
+         * 
+         * @param p Point.
+         * @return Positive in front of the plane, negative behind it.
+         */
+        float getSignedDistance(const Vec3f& p) const
+        {
+            return normal.x * p.x + normal.y * p.y + normal.z * p.z + distance;
+        }
+
+        /**
+         * \brief Compute the signed distances of many points, @SIMDFloat::WIDTH
+         * at a time.
+         * 
+         * @param positions Address of the first point's x coordinate.
+         * @param count Number of points.
+         * @param stride Distance between consecutive points, in floats.
+         * @param distances Receives @count signed distances.
+         */
+        void getSignedDistances(const float* positions, size_t count, size_t stride, float* distances) const;
+
+        /**
+         * Get the point of the plane closest to @p.
+         */
+        Vec3f project(const Vec3f& p) const
+        {
+            return p - normal * (getSignedDistance(p) / (normal * normal));
+        }
+
+        /**
+         * \brief Intersect a ray.
+         * 
+         * @param ray The ray.
+         * @param t Receives the hit distance.
+         * @return True if the ray crosses the plane (from either side) within
+         * (ray.tMin, ray.tMax); false if it doesn't or is parallel to it.
+         */
+        bool intersect(const Ray& ray, float& t) const
+        {
+            float rate = normal * ray.direction;
+
+            if (rate == 0.0f)
+            {
+                return false;
+            }
+
+            t = -getSignedDistance(ray.origin) / rate;
+
+            return t > ray.tMin && t < ray.tMax;
+        }
+
+        /**
+         * \brief Intersect another plane.
+         * 
+         * @param plane The other plane.
+         * @param line Receives the intersection line, along normal x
+         * plane.normal.
+         * @return False if the planes are parallel.
+         */
+        bool intersect(const Plane& plane, Line& line) const;
+
+        /**
+         * \brief Split a mesh into the parts in front of and behind the plane.
+         * 
+         * Vertices closer to the plane than @epsilon count as on it, so they
+         * don't produce slivers; triangles on the plane go to the front part.
+         * New vertices interpolate all the attributes of the edge they cut.
+         * Only the vertices and the triangulation of the parts are written.
+         * 
+         * @param mesh Mesh to split.
+         * @param front Receives the part in front of the plane.
+         * @param back Receives the part behind the plane.
+         * @param epsilon Thickness of the plane, in units of the signed
+         * distance.
+         */
+        void slice(const Mesh& mesh, Mesh& front, Mesh& back, float epsilon = 1e-5f) const;
 
-	};
+        /**
+         * \brief Keep the part of a mesh in front of the plane (see @slice()).
+         */
+        void clip(const Mesh& mesh, Mesh& front, float epsilon = 1e-5f) const;
+    };
 }
 
-#endif // PLANE_H
\ No newline at end of file
+#endif // PLANE_H
@@ -0,0 +1,116 @@
+/** 
+ * \file Ray.cpp
+ * \brief Class definition for a ray.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include "Ray.h"
+
+
+
+namespace nut
+{
+    TrianglePack::TrianglePack()
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < SIMDFloat::WIDTH; ++j)
+            {
+                v0[i][j] = e1[i][j] = e2[i][j] = 0.0f;
+            }
+        }
+    }
+
+
+
+    void TrianglePack::set(int lane, const Vec3f& a, const Vec3f& b, const Vec3f& c)
+    {
+        v0[0][lane] = a.x;
+        v0[1][lane] = a.y;
+        v0[2][lane] = a.z;
+        e1[0][lane] = b.x - a.x;
+        e1[1][lane] = b.y - a.y;
+        e1[2][lane] = b.z - a.z;
+        e2[0][lane] = c.x - a.x;
+        e2[1][lane] = c.y - a.y;
+        e2[2][lane] = c.z - a.z;
+    }
+
+
+
+    Ray::Ray() : origin(0.0f, 0.0f, 0.0f), tMin(0.0f), tMax(FLT_MAX)
+    {
+        setDirection(Vec3f(0.0f, 0.0f, 1.0f));
+    }
+
+
+
+    Ray::Ray(const Vec3f& origin, const Vec3f& direction, float tMin, float tMax)
+        : origin(origin), tMin(tMin), tMax(tMax)
+    {
+        setDirection(direction);
+    }
+
+
+
+    void Ray::setDirection(const Vec3f& d)
+    {
+        direction = d;
+
+        // Zero components give infinities, which slab tests handle
+        invDirection = Vec3f(1.0f / d.x, 1.0f / d.y, 1.0f / d.z);
+    }
+
+
+
+    bool Ray::intersect(const Vec3f& v0, const Vec3f& v1, const Vec3f& v2, float& t, float& u, float& v) const
+    {
+        Vec3f e1 = v1 - v0;
+        Vec3f e2 = v2 - v0;
+        Vec3f p = direction.cross(e2);
+        float det = e1 * p;
+
+        if (det == 0.0f)
+        {
+            return false;
+        }
+
+        float invDet = 1.0f / det;
+        Vec3f s = origin - v0;
+        u = (s * p) * invDet;
+
+        if (u < 0.0f || u > 1.0f)
+        {
+            return false;
+        }
+
+        Vec3f q = s.cross(e1);
+        v = (direction * q) * invDet;
+
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return false;
+        }
+
+        t = (e2 * q) * invDet;
+
+        return t > tMin && t < tMax;
+    }
+
+
+
+    int Ray::intersect(const TrianglePack& pack, SIMDFloat& t, SIMDFloat& u, SIMDFloat& v) const
+    {
+        const SIMDFloat o[3] = { SIMDFloat(origin.x), SIMDFloat(origin.y), SIMDFloat(origin.z) };
+        const SIMDFloat d[3] = { SIMDFloat(direction.x), SIMDFloat(direction.y), SIMDFloat(direction.z) };
+        const SIMDFloat v0[3] = { SIMDFloat::loadu(pack.v0[0]), SIMDFloat::loadu(pack.v0[1]), SIMDFloat::loadu(pack.v0[2]) };
+        const SIMDFloat e1[3] = { SIMDFloat::loadu(pack.e1[0]), SIMDFloat::loadu(pack.e1[1]), SIMDFloat::loadu(pack.e1[2]) };
+        const SIMDFloat e2[3] = { SIMDFloat::loadu(pack.e2[0]), SIMDFloat::loadu(pack.e2[1]), SIMDFloat::loadu(pack.e2[2]) };
+
+        return SIMDFloat::movemask(intersect(o, d, v0, e1, e2, SIMDFloat(tMin), SIMDFloat(tMax), t, u, v));
+    }
+}
@@ -1,23 +1,165 @@
-/** \file Ray.h
- *  \brief Class definition for a ray.
+/** 
+ * \file Ray.h
+ * \brief Class definition for a ray.
+ * 
+ * A ray is the set of points origin + t * direction with t in [tMin, tMax].
+ * The inverse direction is cached for slab tests against bounding boxes, so
+ * the direction must be changed through @setDirection().
+ * 
+ * Ray-triangle tests use the Moller-Trumbore algorithm ("Fast, minimum storage
+ * ray/triangle intersection", 1997). The SIMD version tests @SIMDFloat::WIDTH
+ * triangles (4 or 8) stored in a @TrianglePack against one ray; its kernel,
+ * @Ray::intersect(const SIMDFloat*, ...), takes any mix of broadcast and
+ * per-lane arguments, so it also tests one triangle against several rays.
  * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
  * 
- * @author: Eder A. Perez
+ * @author: Eder A. Perez.
  */
 
 #ifndef RAY_H
 #define RAY_H
 
+#include <cfloat>
+#include "SIMD.h"
+#include "Vector.h"
+
 
 
 namespace nut
 {
-	class Ray
-	{
+    /**
+     * \brief @SIMDFloat::WIDTH triangles in structure of arrays layout, stored
+     * as a vertex and two edges (the form Moller-Trumbore consumes).
+     */
+    struct TrianglePack
+    {
+        float v0[3][SIMDFloat::WIDTH]; /**< First vertex: x, y and z lanes. */
+        float e1[3][SIMDFloat::WIDTH]; /**< v1 - v0. */
+        float e2[3][SIMDFloat::WIDTH]; /**< v2 - v0. */
+
+        /**
+         * Default constructor. All lanes hold degenerate triangles, which
+         * rays never hit.
+         */
+        TrianglePack();
+
+        /**
+         * Store a triangle in a lane.
+         * 
+         * @param lane Lane index in [0, WIDTH).
+         */
+        void set(int lane, const Vec3f& a, const Vec3f& b, const Vec3f& c);
+    };
+
+
+
+    class Ray
+    {
+        public:
+
+        Vec3f origin;       /**< Ray origin. */
+        Vec3f direction;    /**< Ray direction (not required to be unit length). */
+        Vec3f invDirection; /**< Component-wise inverse of @direction. */
+        float tMin;         /**< Start of the ray interval. */
+        float tMax;         /**< End of the ray interval. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor.
+         * 
+         * Instantiates a ray from the origin along +z.
+         */
+        Ray();
+
+        /**
+         * Instantiates a ray.
+         * 
+         * @param origin Ray origin.
+         * @param direction Ray direction.
+         * @param tMin Start of the ray interval.
+         * @param tMax End of the ray interval.
+         */
+        Ray(const Vec3f& origin, const Vec3f& direction, float tMin = 0.0f, float tMax = FLT_MAX);
+
+
+
+        /// Methods ///
+
+        /**
+         * Set the direction and update the inverse direction.
+         */
+        void setDirection(const Vec3f& d);
+
+        /**
+         * Get the point at distance @t (in units of the direction length).
+         */
+        Vec3f getPoint(float t) const
+        {
+            return origin + direction * t;
+        }
+
+        /**
+         * \brief Intersect a triangle.
+         * 
+         * @param t Receives the hit distance.
+         * @param u Receives the barycentric coordinate of @v1.
+         * @param v Receives the barycentric coordinate of @v2.
+         * @return True if the ray hits the triangle (either side) within (@tMin, @tMax).
+         */
+        bool intersect(const Vec3f& v0, const Vec3f& v1, const Vec3f& v2, float& t, float& u, float& v) const;
+
+        /**
+         * \brief Intersect the @SIMDFloat::WIDTH triangles of a pack.
+         * 
+         * @param t, u, v Receive the hit distance and barycentric coordinates of
+         * each lane (only meaningful for lanes that hit).
+         * @return Bit i is set if the ray hits triangle i within (@tMin, @tMax).
+         */
+        int intersect(const TrianglePack& pack, SIMDFloat& t, SIMDFloat& u, SIMDFloat& v) const;
+
+        /**
+         * \brief Moller-Trumbore over SIMD lanes. Lane i tests ray i against
+         * triangle i; broadcast the ray or the triangle to test one against many.
+         * 
+         * @param o, d Ray origin and direction (x, y and z).
+         * @param v0, e1, e2 Triangle vertex and edges (x, y and z).
+         * @param tMin, tMax Ray intervals.
+         * @param t, u, v Receive the hit distance and barycentric coordinates.
+         * @return Mask of the lanes that hit within (@tMin, @tMax).
+         */
+        static SIMDFloat intersect(const SIMDFloat* o, const SIMDFloat* d,
+                                   const SIMDFloat* v0, const SIMDFloat* e1, const SIMDFloat* e2,
+                                   const SIMDFloat& tMin, const SIMDFloat& tMax,
+                                   SIMDFloat& t, SIMDFloat& u, SIMDFloat& v)
+        {
+            // p = d x e2
+            SIMDFloat px = d[1] * e2[2] - d[2] * e2[1];
+            SIMDFloat py = d[2] * e2[0] - d[0] * e2[2];
+            SIMDFloat pz = d[0] * e2[1] - d[1] * e2[0];
+            SIMDFloat det = e1[0] * px + e1[1] * py + e1[2] * pz;
+            SIMDFloat invDet = SIMDFloat(1.0f) / det;
+
+            SIMDFloat sx = o[0] - v0[0], sy = o[1] - v0[1], sz = o[2] - v0[2];
+            u = (sx * px + sy * py + sz * pz) * invDet;
+
+            // q = s x e1
+            SIMDFloat qx = sy * e1[2] - sz * e1[1];
+            SIMDFloat qy = sz * e1[0] - sx * e1[2];
+            SIMDFloat qz = sx * e1[1] - sy * e1[0];
+            v = (d[0] * qx + d[1] * qy + d[2] * qz) * invDet;
+            t = (e2[0] * qx + e2[1] * qy + e2[2] * qz) * invDet;
+
+            const SIMDFloat zero(0.0f);
 
-	};
+            return (det != zero) & (u >= zero) & (v >= zero) & (u + v <= SIMDFloat(1.0f)) &
+                   (t > tMin) & (t < tMax);
+        }
+    };
 }
 
-#endif // RAY_H
\ No newline at end of file
+#endif // RAY_H
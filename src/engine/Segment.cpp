@@ -0,0 +1,342 @@
+/** 
+ * \file Segment.cpp
+ * \brief Class definition for a line segment.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include "Segment.h"
+
+
+
+namespace nut
+{
+    const float Segment::PARALLEL_EPSILON = 1e-6f;
+
+
+
+    /**
+     * Clamp a segment parameter to [0, 1].
+     */
+    static float segmentClamp(float t)
+    {
+        return t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    }
+
+
+
+    SegmentPack::SegmentPack()
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < SIMDFloat::WIDTH; ++j)
+            {
+                a[i][j] = d[i][j] = 0.0f;
+            }
+        }
+    }
+
+
+
+    void SegmentPack::set(int lane, const Vec3f& a, const Vec3f& b)
+    {
+        this->a[0][lane] = a.x;
+        this->a[1][lane] = a.y;
+        this->a[2][lane] = a.z;
+        d[0][lane] = b.x - a.x;
+        d[1][lane] = b.y - a.y;
+        d[2][lane] = b.z - a.z;
+    }
+
+
+
+    float Segment::closestPoint(const Vec3f& point, float& t) const
+    {
+        Vec3f d = b - a;
+        float dd = d * d;
+
+        t = dd > FLT_MIN ? segmentClamp(((point - a) * d) / dd) : 0.0f;
+
+        Vec3f r = a + d * t - point;
+
+        return r * r;
+    }
+
+
+
+    float Segment::closestPoints(const Segment& segment, float& t, float& u) const
+    {
+        Vec3f d1 = b - a;
+        Vec3f d2 = segment.b - segment.a;
+        Vec3f r = a - segment.a;
+        float dd1 = d1 * d1;
+        float dd2 = d2 * d2;
+        float f = d2 * r;
+
+        if (dd1 <= FLT_MIN && dd2 <= FLT_MIN)
+        {
+            // Both segments are points
+            t = u = 0.0f;
+        }
+        else if (dd1 <= FLT_MIN)
+        {
+            t = 0.0f;
+            u = segmentClamp(f / dd2);
+        }
+        else
+        {
+            float c = d1 * r;
+
+            if (dd2 <= FLT_MIN)
+            {
+                u = 0.0f;
+                t = segmentClamp(-c / dd1);
+            }
+            else
+            {
+                // Closest points of the lines, unless they're parallel (any t works then)
+                float d12 = d1 * d2;
+                float denom = dd1 * dd2 - d12 * d12;
+                t = denom > PARALLEL_EPSILON * dd1 * dd2 ? segmentClamp((d12 * f - c * dd2) / denom) : 0.0f;
+                u = (d12 * t + f) / dd2;
+
+                // Clamp u and recompute t for the clamped u
+                if (u < 0.0f)
+                {
+                    u = 0.0f;
+                    t = segmentClamp(-c / dd1);
+                }
+                else if (u > 1.0f)
+                {
+                    u = 1.0f;
+                    t = segmentClamp((d12 - c) / dd1);
+                }
+            }
+        }
+
+        Vec3f x = r + d1 * t - d2 * u;
+
+        return x * x;
+    }
+
+
+
+    float Segment::closestPoints(const Vec3f& v0, const Vec3f& v1, const Vec3f& v2, float& t, Vec3f& q) const
+    {
+        Vec3f d = b - a;
+
+        // A crossing segment touches the triangle
+        float hit, bu, bv;
+
+        if (Ray(a, d, 0.0f, 1.0f).intersect(v0, v1, v2, hit, bu, bv))
+        {
+            t = hit;
+            q = getPoint(hit);
+
+            return 0.0f;
+        }
+
+        // Otherwise the closest points are on an edge, or an end point is over the face
+        const Segment edges[3] = { Segment(v0, v1), Segment(v1, v2), Segment(v2, v0) };
+        float best = FLT_MAX;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            float s, u;
+            float distance = closestPoints(edges[i], s, u);
+
+            if (distance < best)
+            {
+                best = distance;
+                t = s;
+                q = edges[i].getPoint(u);
+            }
+        }
+
+        Vec3f e1 = v1 - v0;
+        Vec3f e2 = v2 - v0;
+        Vec3f n = e1.cross(e2);
+        float nn = n * n;
+
+        if (nn > FLT_MIN)
+        {
+            for (int end = 0; end < 2; ++end)
+            {
+                const Vec3f& p = end == 0 ? a : b;
+                Vec3f w = p - v0;
+
+                // Barycentric coordinates of the projection, times nn
+                float b1 = w.cross(e2) * n;
+                float b2 = e1.cross(w) * n;
+                float h = w * n;
+                float distance = h * h / nn;
+
+                if (b1 >= 0.0f && b2 >= 0.0f && b1 + b2 <= nn && distance < best)
+                {
+                    best = distance;
+                    t = float(end);
+                    q = p - n * (h / nn);
+                }
+            }
+        }
+
+        return best;
+    }
+
+
+
+    SIMDFloat Segment::closestPoints(const SegmentPack& pack, SIMDFloat& t, SIMDFloat& u) const
+    {
+        const SIMDFloat p1[3] = { SIMDFloat(a.x), SIMDFloat(a.y), SIMDFloat(a.z) };
+        const SIMDFloat d1[3] = { SIMDFloat(b.x - a.x), SIMDFloat(b.y - a.y), SIMDFloat(b.z - a.z) };
+        const SIMDFloat p2[3] = { SIMDFloat::loadu(pack.a[0]), SIMDFloat::loadu(pack.a[1]), SIMDFloat::loadu(pack.a[2]) };
+        const SIMDFloat d2[3] = { SIMDFloat::loadu(pack.d[0]), SIMDFloat::loadu(pack.d[1]), SIMDFloat::loadu(pack.d[2]) };
+
+        return closestPoints(p1, d1, p2, d2, t, u);
+    }
+
+
+
+    void Segment::closestPoints(const SegmentPack* packs, size_t count, float* distances, float* t, float* u) const
+    {
+        const SIMDFloat p1[3] = { SIMDFloat(a.x), SIMDFloat(a.y), SIMDFloat(a.z) };
+        const SIMDFloat d1[3] = { SIMDFloat(b.x - a.x), SIMDFloat(b.y - a.y), SIMDFloat(b.z - a.z) };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const SegmentPack& pack = packs[i];
+            const SIMDFloat p2[3] = { SIMDFloat::loadu(pack.a[0]), SIMDFloat::loadu(pack.a[1]), SIMDFloat::loadu(pack.a[2]) };
+            const SIMDFloat d2[3] = { SIMDFloat::loadu(pack.d[0]), SIMDFloat::loadu(pack.d[1]), SIMDFloat::loadu(pack.d[2]) };
+            SIMDFloat s, v;
+            size_t offset = i * SIMDFloat::WIDTH;
+
+            closestPoints(p1, d1, p2, d2, s, v).storeu(distances + offset);
+            s.storeu(t + offset);
+            v.storeu(u + offset);
+        }
+    }
+
+
+
+    SIMDFloat Segment::closestPoints(const TrianglePack& pack, SIMDFloat& t, SIMDFloat* q) const
+    {
+        const SIMDFloat p[3] = { SIMDFloat(a.x), SIMDFloat(a.y), SIMDFloat(a.z) };
+        const SIMDFloat d[3] = { SIMDFloat(b.x - a.x), SIMDFloat(b.y - a.y), SIMDFloat(b.z - a.z) };
+        const SIMDFloat v0[3] = { SIMDFloat::loadu(pack.v0[0]), SIMDFloat::loadu(pack.v0[1]), SIMDFloat::loadu(pack.v0[2]) };
+        const SIMDFloat e1[3] = { SIMDFloat::loadu(pack.e1[0]), SIMDFloat::loadu(pack.e1[1]), SIMDFloat::loadu(pack.e1[2]) };
+        const SIMDFloat e2[3] = { SIMDFloat::loadu(pack.e2[0]), SIMDFloat::loadu(pack.e2[1]), SIMDFloat::loadu(pack.e2[2]) };
+
+        return closestPoints(p, d, v0, e1, e2, t, q);
+    }
+
+
+
+    void Segment::closestPoints(const TrianglePack* packs, size_t count, float* distances, float* t) const
+    {
+        const SIMDFloat p[3] = { SIMDFloat(a.x), SIMDFloat(a.y), SIMDFloat(a.z) };
+        const SIMDFloat d[3] = { SIMDFloat(b.x - a.x), SIMDFloat(b.y - a.y), SIMDFloat(b.z - a.z) };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const TrianglePack& pack = packs[i];
+            const SIMDFloat v0[3] = { SIMDFloat::loadu(pack.v0[0]), SIMDFloat::loadu(pack.v0[1]), SIMDFloat::loadu(pack.v0[2]) };
+            const SIMDFloat e1[3] = { SIMDFloat::loadu(pack.e1[0]), SIMDFloat::loadu(pack.e1[1]), SIMDFloat::loadu(pack.e1[2]) };
+            const SIMDFloat e2[3] = { SIMDFloat::loadu(pack.e2[0]), SIMDFloat::loadu(pack.e2[1]), SIMDFloat::loadu(pack.e2[2]) };
+            SIMDFloat s, q[3];
+            size_t offset = i * SIMDFloat::WIDTH;
+
+            closestPoints(p, d, v0, e1, e2, s, q).storeu(distances + offset);
+            s.storeu(t + offset);
+        }
+    }
+
+
+
+    SIMDFloat Segment::closestPoints(const SIMDFloat* p, const SIMDFloat* d,
+                                     const SIMDFloat* v0, const SIMDFloat* e1, const SIMDFloat* e2,
+                                     SIMDFloat& t, SIMDFloat* q)
+    {
+        const SIMDFloat zero(0.0f);
+        const SIMDFloat one(1.0f);
+
+        // Edges as start points and directions: v0 -> v1, v1 -> v2 and v2 -> v0
+        const SIMDFloat v1[3] = { v0[0] + e1[0], v0[1] + e1[1], v0[2] + e1[2] };
+        const SIMDFloat v2[3] = { v0[0] + e2[0], v0[1] + e2[1], v0[2] + e2[2] };
+        const SIMDFloat e3[3] = { e2[0] - e1[0], e2[1] - e1[1], e2[2] - e1[2] };
+        const SIMDFloat e4[3] = { -e2[0], -e2[1], -e2[2] };
+        const SIMDFloat* starts[3] = { v0, v1, v2 };
+        const SIMDFloat* directions[3] = { e1, e3, e4 };
+
+        SIMDFloat best(FLT_MAX);
+        t = zero;
+        q[0] = q[1] = q[2] = zero;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            const SIMDFloat* s = starts[i];
+            const SIMDFloat* e = directions[i];
+            SIMDFloat ts, us;
+            SIMDFloat distance = closestPoints(p, d, s, e, ts, us);
+            SIMDFloat closer = distance < best;
+
+            best = SIMDFloat::min(distance, best);
+            t = SIMDFloat::select(closer, ts, t);
+
+            for (int k = 0; k < 3; ++k)
+            {
+                q[k] = SIMDFloat::select(closer, s[k] + e[k] * us, q[k]);
+            }
+        }
+
+        // End points over the face
+        SIMDFloat nx = e1[1] * e2[2] - e1[2] * e2[1];
+        SIMDFloat ny = e1[2] * e2[0] - e1[0] * e2[2];
+        SIMDFloat nz = e1[0] * e2[1] - e1[1] * e2[0];
+        SIMDFloat nn = nx * nx + ny * ny + nz * nz;
+        SIMDFloat face = nn > SIMDFloat(FLT_MIN);
+        SIMDFloat invNN = one / SIMDFloat::select(face, nn, one);
+
+        for (int end = 0; end < 2; ++end)
+        {
+            SIMDFloat pe[3];
+
+            for (int k = 0; k < 3; ++k)
+            {
+                pe[k] = end == 0 ? p[k] : p[k] + d[k];
+            }
+
+            SIMDFloat wx = pe[0] - v0[0], wy = pe[1] - v0[1], wz = pe[2] - v0[2];
+
+            // Barycentric coordinates of the projection, times nn
+            SIMDFloat b1 = (wy * e2[2] - wz * e2[1]) * nx + (wz * e2[0] - wx * e2[2]) * ny + (wx * e2[1] - wy * e2[0]) * nz;
+            SIMDFloat b2 = (e1[1] * wz - e1[2] * wy) * nx + (e1[2] * wx - e1[0] * wz) * ny + (e1[0] * wy - e1[1] * wx) * nz;
+            SIMDFloat h = wx * nx + wy * ny + wz * nz;
+            SIMDFloat distance = h * h * invNN;
+            SIMDFloat closer = face & (b1 >= zero) & (b2 >= zero) & (b1 + b2 <= nn) & (distance < best);
+            SIMDFloat scale = h * invNN;
+
+            best = SIMDFloat::select(closer, distance, best);
+            t = SIMDFloat::select(closer, SIMDFloat(float(end)), t);
+            q[0] = SIMDFloat::select(closer, pe[0] - nx * scale, q[0]);
+            q[1] = SIMDFloat::select(closer, pe[1] - ny * scale, q[1]);
+            q[2] = SIMDFloat::select(closer, pe[2] - nz * scale, q[2]);
+        }
+
+        // A crossing segment touches the triangle
+        SIMDFloat hit, bu, bv;
+        SIMDFloat crosses = Ray::intersect(p, d, v0, e1, e2, zero, one, hit, bu, bv);
+
+        best = SIMDFloat::select(crosses, zero, best);
+        t = SIMDFloat::select(crosses, hit, t);
+
+        for (int k = 0; k < 3; ++k)
+        {
+            q[k] = SIMDFloat::select(crosses, p[k] + d[k] * hit, q[k]);
+        }
+
+        return best;
+    }
+}
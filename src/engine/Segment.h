@@ -1,5 +1,19 @@
-/** \file Segment.h
- *  \brief Class definition for a segment.
+/** 
+ * \file Segment.h
+ * \brief Class definition for a line segment.
+ * 
+ * A segment is the set of points a + t * (b - a) with t in [0, 1]. Closest
+ * point queries return the squared distance and the parameters of the closest
+ * points, and handle degenerate (zero length) and parallel segments.
+ * Segment-segment distance follows Ericson ("Real-Time Collision Detection",
+ * 2005, section 5.1.9); segment-triangle distance is zero if the segment
+ * crosses the triangle, and otherwise the smallest of the segment against the
+ * three edges and of the end points against the face.
+ * 
+ * The SIMD versions test one segment against the @SIMDFloat::WIDTH segments
+ * of a @SegmentPack or triangles of a @TrianglePack, without branches. Their
+ * kernels take any mix of broadcast and per-lane arguments, like
+ * @Ray::intersect(const SIMDFloat*, ...).
  * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
@@ -10,14 +24,253 @@
 #ifndef SEGMENT_H
 #define SEGMENT_H
 
+#include <cfloat>
+#include <cstddef>
+#include "Ray.h"
+#include "SIMD.h"
+#include "Vector.h"
+
 
 
 namespace nut
 {
-	class Segment
-	{
+    /**
+     * \brief @SIMDFloat::WIDTH segments in structure of arrays layout, stored
+     * as a start point and a direction.
+     */
+    struct SegmentPack
+    {
+        float a[3][SIMDFloat::WIDTH]; /**< Start point: x, y and z lanes. */
+        float d[3][SIMDFloat::WIDTH]; /**< b - a. */
+
+        /**
+         * Default constructor. All lanes hold degenerate segments at the
+         * origin.
+         */
+        SegmentPack();
+
+        /**
+         * Store a segment in a lane.
+         * 
+         * @param lane Lane index in [0, WIDTH).
+         */
+        void set(int lane, const Vec3f& a, const Vec3f& b);
+    };
+
+
+
+    class Segment
+    {
+        public:
+
+        Vec3f a; /**< First end point. */
+        Vec3f b; /**< Second end point. */
+
+        static const float PARALLEL_EPSILON; /**< Squared sine of the angle under which segments count as parallel. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor.
+         * 
+         * Instantiates a degenerate segment (a point) at the origin.
+         */
+        Segment() : a(0.0f, 0.0f, 0.0f), b(0.0f, 0.0f, 0.0f)
+        {
+        }
+
+        /**
+         * Instantiates a segment.
+         * 
+         * @param a First end point.
+         * @param b Second end point.
+         */
+        Segment(const Vec3f& a, const Vec3f& b) : a(a), b(b)
+        {
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Get the vector from @a to @b.
+         */
+        Vec3f getDirection() const
+        {
+            return b - a;
+        }
+
+        /**
+         * Get the length of the segment.
+         */
+        float getLength() const
+        {
+            return (b - a).length();
+        }
+
+        /**
+         * Get the midpoint of the segment.
+         */
+        Vec3f getCenter() const
+        {
+            return (a + b) * 0.5f;
+        }
+
+        /**
+         * Get the point a + t * (b - a).
+         */
+        Vec3f getPoint(float t) const
+        {
+            return a + (b - a) * t;
+        }
+
+        /**
+         * \brief Find the point of the segment closest to a point.
+         * 
+         * @param point Query point.
+         * @param t Receives the parameter of the closest point (see @getPoint()).
+         * @return The squared distance.
+         */
+        float closestPoint(const Vec3f& point, float& t) const;
+
+        /**
+         * \brief Find the closest points of two segments.
+         * 
+         * @param segment The other segment.
+         * @param t Receives the parameter of the closest point on this segment.
+         * @param u Receives the parameter of the closest point on @segment.
+         * @return The squared distance.
+         */
+        float closestPoints(const Segment& segment, float& t, float& u) const;
+
+        /**
+         * \brief Find the closest points of the segment and a triangle.
+         * 
+         * @param v0, v1, v2 Triangle vertices.
+         * @param t Receives the parameter of the closest point on the segment.
+         * @param q Receives the closest point on the triangle.
+         * @return The squared distance (zero if the segment crosses the
+         * triangle).
+         */
+        float closestPoints(const Vec3f& v0, const Vec3f& v1, const Vec3f& v2, float& t, Vec3f& q) const;
+
+        /**
+         * \brief Find the closest points to the @SIMDFloat::WIDTH segments of a
+         * pack.
+         * 
+         * @param t, u Receive the parameters of each lane's closest points, on
+         * this segment and on the lane's segment.
+         * @return The squared distance of each lane.
+         */
+        SIMDFloat closestPoints(const SegmentPack& pack, SIMDFloat& t, SIMDFloat& u) const;
+
+        /**
+         * \brief Find the closest points to the segments of several packs.
+         * 
+         * @param packs Segment packs.
+         * @param count Number of packs.
+         * @param distances, t, u Receive the squared distance and parameters of
+         * each segment (@count * @SIMDFloat::WIDTH values).
+         */
+        void closestPoints(const SegmentPack* packs, size_t count, float* distances, float* t, float* u) const;
+
+        /**
+         * \brief Find the closest points to the @SIMDFloat::WIDTH triangles of a
+         * pack.
+         * 
+         * @param t Receives the parameter of the closest point on this segment.
+         * @param q Receives the closest point on each lane's triangle (x, y
+         * and z).
+         * @return The squared distance of each lane.
+         */
+        SIMDFloat closestPoints(const TrianglePack& pack, SIMDFloat& t, SIMDFloat* q) const;
+
+        /**
+         * \brief Find the closest points to the triangles of several packs.
+         * 
+         * @param packs Triangle packs.
+         * @param count Number of packs.
+         * @param distances, t Receive the squared distance and the parameter on
+         * this segment of each triangle (@count * @SIMDFloat::WIDTH values).
+         */
+        void closestPoints(const TrianglePack* packs, size_t count, float* distances, float* t) const;
+
+        /**
+         * \brief Segment-segment closest points over SIMD lanes.
+         * 
+         * @param p1, d1 Start point and direction of the first segments (x, y
+         * and z).
+         * @param p2, d2 Start point and direction of the second segments.
+         * @param t, u Receive the parameters of the closest points on the first
+         * and second segments.
+         * @return The squared distances.
+         */
+        static SIMDFloat closestPoints(const SIMDFloat* p1, const SIMDFloat* d1,
+                                       const SIMDFloat* p2, const SIMDFloat* d2,
+                                       SIMDFloat& t, SIMDFloat& u)
+        {
+            const SIMDFloat zero(0.0f);
+            const SIMDFloat one(1.0f);
+            const SIMDFloat tiny(FLT_MIN);
+
+            SIMDFloat rx = p1[0] - p2[0], ry = p1[1] - p2[1], rz = p1[2] - p2[2];
+            SIMDFloat dd1 = d1[0] * d1[0] + d1[1] * d1[1] + d1[2] * d1[2];
+            SIMDFloat dd2 = d2[0] * d2[0] + d2[1] * d2[1] + d2[2] * d2[2];
+            SIMDFloat d12 = d1[0] * d2[0] + d1[1] * d2[1] + d1[2] * d2[2];
+            SIMDFloat c = d1[0] * rx + d1[1] * ry + d1[2] * rz;
+            SIMDFloat f = d2[0] * rx + d2[1] * ry + d2[2] * rz;
+
+            // Zero length segments take the branches of Ericson's version as selects
+            SIMDFloat firstValid = dd1 > tiny;
+            SIMDFloat secondValid = dd2 > tiny;
+            SIMDFloat safe1 = SIMDFloat::select(firstValid, dd1, one);
+            SIMDFloat safe2 = SIMDFloat::select(secondValid, dd2, one);
+
+            // Closest points of the lines, unless they're parallel
+            SIMDFloat denom = dd1 * dd2 - d12 * d12;
+            SIMDFloat skew = denom > SIMDFloat(PARALLEL_EPSILON) * dd1 * dd2;
+            SIMDFloat s = (d12 * f - c * dd2) / SIMDFloat::select(skew, denom, one);
+            s = SIMDFloat::select(skew, SIMDFloat::min(SIMDFloat::max(s, zero), one), zero);
+
+            // Clamp the second parameter and recompute the first one
+            SIMDFloat v = (d12 * s + f) / safe2;
+            SIMDFloat sLow = SIMDFloat::min(SIMDFloat::max(-c / safe1, zero), one);
+            SIMDFloat sHigh = SIMDFloat::min(SIMDFloat::max((d12 - c) / safe1, zero), one);
+            s = SIMDFloat::select(v < zero, sLow, SIMDFloat::select(v > one, sHigh, s));
+            v = SIMDFloat::min(SIMDFloat::max(v, zero), one);
+
+            s = SIMDFloat::select(secondValid, s, sLow);
+            v = SIMDFloat::select(secondValid, v, zero);
+            v = SIMDFloat::select(firstValid, v, SIMDFloat::min(SIMDFloat::max(f / safe2, zero), one));
+            s = SIMDFloat::select(firstValid, s, zero);
+
+            t = s;
+            u = v;
+
+            SIMDFloat x = rx + d1[0] * s - d2[0] * v;
+            SIMDFloat y = ry + d1[1] * s - d2[1] * v;
+            SIMDFloat z = rz + d1[2] * s - d2[2] * v;
+
+            return x * x + y * y + z * z;
+        }
 
-	};
+        /**
+         * \brief Segment-triangle closest points over SIMD lanes.
+         * 
+         * @param p, d Start point and direction of the segments (x, y and z).
+         * @param v0, e1, e2 Triangle vertex and edges (x, y and z).
+         * @param t Receives the parameters of the closest points on the
+         * segments.
+         * @param q Receives the closest points on the triangles (x, y and z).
+         * @return The squared distances.
+         */
+        static SIMDFloat closestPoints(const SIMDFloat* p, const SIMDFloat* d,
+                                       const SIMDFloat* v0, const SIMDFloat* e1, const SIMDFloat* e2,
+                                       SIMDFloat& t, SIMDFloat* q);
+    };
 }
 
 #endif // SEGMENT_H
@@ -0,0 +1,413 @@
+/** 
+ * \file Sphere.cpp
+ * \brief Class definition for a bounding sphere.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include "Sphere.h"
+#include "Matrix3x3.h"
+#include "Mesh.h"
+#include "Xoshiro256.h"
+
+
+
+namespace nut
+{
+    /**
+     * Relative slack of the point-in-sphere test used by Welzl's algorithm,
+     * so points on the boundary of the current sphere don't trigger a
+     * recomputation because of rounding.
+     */
+    static const double SPHERE_WELZL_TOLERANCE = 1e-9;
+
+    /**
+     * Below this (relative) value, three points are treated as collinear and
+     * four points as coplanar.
+     */
+    static const double SPHERE_DEGENERATE_EPSILON = 1e-12;
+
+    static const U64 SPHERE_WELZL_SEED = 0x5EEDBA11ULL; /**< Seed of the point shuffle (results are repeatable). */
+
+
+
+    /**
+     * \brief Sphere used while running Welzl's algorithm, in double precision.
+     */
+    struct SphereBall
+    {
+        Vec3d center;
+        double radius2; /**< Squared radius. */
+
+        SphereBall() : center(0.0, 0.0, 0.0), radius2(-1.0)
+        {
+        }
+
+        SphereBall(const Vec3d& center, double radius2) : center(center), radius2(radius2)
+        {
+        }
+
+        bool contains(const Vec3d& p) const
+        {
+            Vec3d d = p - center;
+            return d * d <= radius2 * (1.0 + SPHERE_WELZL_TOLERANCE);
+        }
+    };
+
+
+
+    /**
+     * Smallest sphere through two points.
+     */
+    static SphereBall sphereBall(const Vec3d& a, const Vec3d& b)
+    {
+        Vec3d d = b - a;
+        return SphereBall((a + b) * 0.5, (d * d) * 0.25);
+    }
+
+
+
+    /**
+     * Smallest sphere through three points (centered on their circumcircle).
+     * Collinear points fall back to the sphere through the two farthest ones.
+     */
+    static SphereBall sphereBall(const Vec3d& a, const Vec3d& b, const Vec3d& c)
+    {
+        Vec3d ab = b - a, ac = c - a;
+        Vec3d n = ab.cross(ac);
+        double n2 = n * n, ab2 = ab * ab, ac2 = ac * ac;
+
+        if (n2 <= SPHERE_DEGENERATE_EPSILON * ab2 * ac2)
+        {
+            SphereBall s = sphereBall(a, b);
+            SphereBall t = sphereBall(a, c);
+            SphereBall u = sphereBall(b, c);
+
+            if (t.radius2 > s.radius2) s = t;
+            if (u.radius2 > s.radius2) s = u;
+
+            return s;
+        }
+
+        Vec3d x = (ac.cross(n) * ab2 + n.cross(ab) * ac2) * (0.5 / n2);
+        return SphereBall(a + x, x * x);
+    }
+
+
+
+    /**
+     * Sphere through four points (their circumsphere). Coplanar points fall
+     * back to the smallest sphere through three of them containing the fourth.
+     */
+    static SphereBall sphereBall(const Vec3d& a, const Vec3d& b, const Vec3d& c, const Vec3d& d)
+    {
+        Vec3d ab = b - a, ac = c - a, ad = d - a;
+        double det = ab * ac.cross(ad);
+        double ab2 = ab * ab, ac2 = ac * ac, ad2 = ad * ad;
+
+        if (det * det <= SPHERE_DEGENERATE_EPSILON * ab2 * ac2 * ad2)
+        {
+            const SphereBall candidates[4] = { sphereBall(a, b, c), sphereBall(a, b, d),
+                                               sphereBall(a, c, d), sphereBall(b, c, d) };
+            const Vec3d* others[4] = { &d, &c, &b, &a };
+            SphereBall best, largest;
+
+            for (int i = 0; i < 4; ++i)
+            {
+                if (candidates[i].contains(*others[i]) && (best.radius2 < 0.0 || candidates[i].radius2 < best.radius2))
+                {
+                    best = candidates[i];
+                }
+
+                if (candidates[i].radius2 > largest.radius2)
+                {
+                    largest = candidates[i];
+                }
+            }
+
+            return best.radius2 < 0.0 ? largest : best;
+        }
+
+        Vec3d x = (ac.cross(ad) * ab2 + ad.cross(ab) * ac2 + ab.cross(ac) * ad2) * (0.5 / det);
+        return SphereBall(a + x, x * x);
+    }
+
+
+
+    bool Sphere::contains(const Sphere& s) const
+    {
+        if (isEmpty() || s.isEmpty())
+        {
+            return !isEmpty();
+        }
+
+        Vec3f d = s.center - center;
+        float r = radius - s.radius;
+        return r >= 0.0f && d * d <= r * r;
+    }
+
+
+
+    bool Sphere::overlaps(const BoundingBox& box) const
+    {
+        if (isEmpty() || box.isEmpty())
+        {
+            return false;
+        }
+
+        // Distance to the closest point of the box
+        float dx = center.x < box.min.x ? box.min.x - center.x : (center.x > box.max.x ? center.x - box.max.x : 0.0f);
+        float dy = center.y < box.min.y ? box.min.y - center.y : (center.y > box.max.y ? center.y - box.max.y : 0.0f);
+        float dz = center.z < box.min.z ? box.min.z - center.z : (center.z > box.max.z ? center.z - box.max.z : 0.0f);
+
+        return dx * dx + dy * dy + dz * dz <= radius * radius;
+    }
+
+
+
+    void Sphere::expand(const Vec3f& p)
+    {
+        if (isEmpty())
+        {
+            center = p;
+            radius = 0.0f;
+            return;
+        }
+
+        Vec3f d = p - center;
+        float d2 = d * d;
+
+        if (d2 > radius * radius)
+        {
+            // New sphere: the old one's far side and p are on opposite ends
+            float distance = std::sqrt(d2);
+            float newRadius = (radius + distance) * 0.5f;
+            center += d * ((newRadius - radius) / distance);
+            radius = newRadius;
+        }
+    }
+
+
+
+    void Sphere::merge(const Sphere& s)
+    {
+        if (s.isEmpty() || contains(s))
+        {
+            return;
+        }
+
+        if (isEmpty() || s.contains(*this))
+        {
+            *this = s;
+            return;
+        }
+
+        Vec3f d = s.center - center;
+        float distance = std::sqrt(d * d);
+        float newRadius = (distance + radius + s.radius) * 0.5f;
+        center += d * ((newRadius - radius) / distance);
+        radius = newRadius;
+    }
+
+
+
+    BoundingBox Sphere::getBoundingBox() const
+    {
+        if (isEmpty())
+        {
+            return BoundingBox();
+        }
+
+        Vec3f r(radius, radius, radius);
+        return BoundingBox(center - r, center + r);
+    }
+
+
+
+    Sphere Sphere::transform(const GLMatrix<float>& m) const
+    {
+        if (isEmpty())
+        {
+            return *this;
+        }
+
+        // Largest stretch of the linear part: its largest singular value
+        Matrix3x3<float> a(m);
+        Matrix3x3<float> vectors;
+        Vec3f values;
+        (a.transpose() * a).symmetricEigen(values, vectors);
+
+        return Sphere(m * center, radius * std::sqrt(std::max(values.x, 0.0f)));
+    }
+
+
+
+    Sphere Sphere::fit(const float* positions, size_t count, size_t stride)
+    {
+        if (count == 0)
+        {
+            return Sphere();
+        }
+
+        // Points with the smallest and largest coordinate on each axis
+        size_t minIndex[3] = { 0, 0, 0 }, maxIndex[3] = { 0, 0, 0 };
+
+        for (size_t i = 1; i < count; ++i)
+        {
+            const float* p = positions + i * stride;
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (p[axis] < positions[minIndex[axis] * stride + axis]) minIndex[axis] = i;
+                if (p[axis] > positions[maxIndex[axis] * stride + axis]) maxIndex[axis] = i;
+            }
+        }
+
+        // Start with the most distant pair
+        Vec3f a, b;
+        float best = -1.0f;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float* p = positions + minIndex[axis] * stride;
+            const float* q = positions + maxIndex[axis] * stride;
+            Vec3f d(q[0] - p[0], q[1] - p[1], q[2] - p[2]);
+
+            if (d * d > best)
+            {
+                best = d * d;
+                a = Vec3f(p[0], p[1], p[2]);
+                b = Vec3f(q[0], q[1], q[2]);
+            }
+        }
+
+        Sphere sphere((a + b) * 0.5f, std::sqrt(best) * 0.5f);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float* p = positions + i * stride;
+            sphere.expand(Vec3f(p[0], p[1], p[2]));
+        }
+
+        return sphere;
+    }
+
+
+
+    Sphere Sphere::fit(const Mesh& mesh)
+    {
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+
+        if (vertices.empty())
+        {
+            return Sphere();
+        }
+
+        return fit(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float));
+    }
+
+
+
+    Sphere Sphere::fitExact(const float* positions, size_t count, size_t stride)
+    {
+        if (count == 0)
+        {
+            return Sphere();
+        }
+
+        std::vector<Vec3d> points(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float* p = positions + i * stride;
+            points[i] = Vec3d(p[0], p[1], p[2]);
+        }
+
+        // Random order gives the expected linear running time
+        Xoshiro256 rng(SPHERE_WELZL_SEED);
+
+        for (size_t i = count - 1; i > 0; --i)
+        {
+            std::swap(points[i], points[size_t(rng.next() % (i + 1))]);
+        }
+
+        // Iterative form of the recursion: each level fixes one more point on
+        // the boundary
+        SphereBall ball(points[0], 0.0);
+
+        for (size_t i = 1; i < count; ++i)
+        {
+            if (ball.contains(points[i]))
+            {
+                continue;
+            }
+
+            ball = SphereBall(points[i], 0.0);
+
+            for (size_t j = 0; j < i; ++j)
+            {
+                if (ball.contains(points[j]))
+                {
+                    continue;
+                }
+
+                ball = sphereBall(points[i], points[j]);
+
+                for (size_t k = 0; k < j; ++k)
+                {
+                    if (ball.contains(points[k]))
+                    {
+                        continue;
+                    }
+
+                    ball = sphereBall(points[i], points[j], points[k]);
+
+                    for (size_t l = 0; l < k; ++l)
+                    {
+                        if (!ball.contains(points[l]))
+                        {
+                            ball = sphereBall(points[i], points[j], points[k], points[l]);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Radius from the rounded center, so every point is inside
+        Vec3f center(float(ball.center.x), float(ball.center.y), float(ball.center.z));
+        Vec3d c(center.x, center.y, center.z);
+        double radius2 = 0.0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Vec3d d = points[i] - c;
+            radius2 = std::max(radius2, d * d);
+        }
+
+        double radius = std::sqrt(radius2);
+        float r = float(radius);
+
+        return Sphere(center, double(r) < radius ? std::nextafter(r, FLT_MAX) : r);
+    }
+
+
+
+    Sphere Sphere::fitExact(const Mesh& mesh)
+    {
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+
+        if (vertices.empty())
+        {
+            return Sphere();
+        }
+
+        return fitExact(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float));
+    }
+}
@@ -1,23 +1,170 @@
-/** \file Sphere.h
- *  \brief Class definition for an sphere.
+/** 
+ * \file Sphere.h
+ * \brief Class definition for a bounding sphere.
+ * 
+ * Two fitting methods are provided for point sets such as @Mesh vertex arrays:
+ * @fit() is Ritter's two pass approximation ("An efficient bounding sphere",
+ * Graphics Gems, 1990): a pass over the points finds the extremes the initial
+ * sphere spans, and a second one grows it to include every point. It is usually
+ * within a few percent of the optimum and cheap enough to run at load time.
+ * @fitExact() is Welzl's randomized algorithm ("Smallest enclosing disks (balls
+ * and ellipsoids)", 1991), which finds the minimum sphere in expected linear
+ * time and is meant for offline cooking.
  * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
  * 
- * @author: Eder A. Perez
+ * @author: Eder A. Perez.
  */
 
 #ifndef SPHERE_H
 #define SPHERE_H
 
+#include <cstddef>
+#include "BoundingBox.h"
+#include "GLMatrix.h"
+#include "Vector.h"
+
 
 
-namespace fen
+namespace nut
 {
-	class Sphere
-	{
+    class Mesh;
+
+    class Sphere
+    {
+        public:
+
+        Vec3f center; /**< Sphere center. */
+        float radius; /**< Sphere radius; negative for an empty sphere. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor.
+         * 
+         * Instantiates an empty sphere, so that merging or expanding it with
+         * anything results in that thing.
+         */
+        Sphere() : center(0.0f, 0.0f, 0.0f), radius(-1.0f)
+        {
+        }
+
+        /**
+         * Instantiates a sphere.
+         * 
+         * @param center Sphere center.
+         * @param radius Sphere radius.
+         */
+        Sphere(const Vec3f& center, float radius) : center(center), radius(radius)
+        {
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Check if the sphere is empty (negative radius).
+         */
+        bool isEmpty() const
+        {
+            return radius < 0.0f;
+        }
+
+        /**
+         * Check if a point is inside the sphere (boundary included).
+         */
+        bool contains(const Vec3f& p) const
+        {
+            Vec3f d = p - center;
+            return d * d <= radius * radius && !isEmpty();
+        }
+
+        /**
+         * Check if a sphere is entirely inside this sphere.
+         */
+        bool contains(const Sphere& s) const;
+
+        /**
+         * Check if two spheres overlap (touching counts as overlapping).
+         */
+        bool overlaps(const Sphere& s) const
+        {
+            Vec3f d = s.center - center;
+            float r = radius + s.radius;
+            return d * d <= r * r && !isEmpty() && !s.isEmpty();
+        }
+
+        /**
+         * Check if the sphere overlaps a box (touching counts as overlapping).
+         */
+        bool overlaps(const BoundingBox& box) const;
+
+        /**
+         * \brief Grow the sphere to include a point, moving its center toward
+         * the point (Ritter's update), so the result is smaller than keeping
+         * the center fixed.
+         */
+        void expand(const Vec3f& p);
+
+        /**
+         * \brief Replace the sphere with the smallest sphere enclosing both
+         * this sphere and @s.
+         */
+        void merge(const Sphere& s);
+
+        /**
+         * Get the smallest box enclosing the sphere (empty if the sphere is).
+         */
+        BoundingBox getBoundingBox() const;
+
+        /**
+         * \brief Compute a sphere bounding this sphere transformed by an affine
+         * matrix. The radius is scaled by the matrix's largest stretch (its
+         * largest singular value), so the result is exact for similarity
+         * transforms.
+         */
+        Sphere transform(const GLMatrix<float>& m) const;
+
+        /**
+         * \brief Fit a sphere to a set of points with Ritter's algorithm.
+         * 
+         * The initial sphere spans the most distant pair among the points with
+         * extreme x, y and z coordinates, then grows to include every point.
+         * 
+         * @param positions Address of the first point's x coordinate.
+         * @param count Number of points.
+         * @param stride Distance between consecutive points, in floats.
+         * @return A sphere enclosing all points (empty if @count is zero).
+         */
+        static Sphere fit(const float* positions, size_t count, size_t stride = 3);
+
+        /**
+         * \brief Fit a sphere to a mesh's vertex positions with Ritter's
+         * algorithm.
+         */
+        static Sphere fit(const Mesh& mesh);
+
+        /**
+         * \brief Compute the minimum sphere enclosing a set of points with
+         * Welzl's algorithm.
+         * 
+         * Points are visited in a random (seeded, so repeatable) order and the
+         * support sets are solved in double precision.
+         * 
+         * Same parameters as @fit().
+         */
+        static Sphere fitExact(const float* positions, size_t count, size_t stride = 3);
 
-	};
+        /**
+         * \brief Compute the minimum sphere enclosing a mesh's vertex positions
+         * with Welzl's algorithm.
+         */
+        static Sphere fitExact(const Mesh& mesh);
+    };
 }
 
-#endif // SPHERE_H
\ No newline at end of file
+#endif // SPHERE_H
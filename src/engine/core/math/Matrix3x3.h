@@ -13,6 +13,7 @@
 
 #include <cstring>
 #include <cmath>
+#include <limits>
 #include "Vector3D.h"
 #include "GLMatrix.h"
 
@@ -153,6 +154,16 @@ namespace nut
                              _m[6], _m[7], _m[8]);
         }
 
+        /**
+         * Compute the eigenvalues and eigenvectors of a symmetric matrix
+         * (e.g. a covariance matrix) with cyclic Jacobi rotations.
+         * 
+         * @param values Receives the eigenvalues in decreasing order.
+         * @param vectors Receives the unit eigenvectors as columns, in the same
+         * order as @values. They form a right-handed orthonormal basis.
+         */
+        void symmetricEigen(Vector3D<T>& values, Matrix3x3& vectors) const;
+
         /// Operators ///
 
         /**
@@ -432,5 +443,103 @@ namespace nut
                           invDet * (_m[3]*_m[2] - _m[0]*_m[5]),
                           invDet * (_m[0]*_m[4] - _m[3]*_m[1]) );
     }
+
+    template<typename T> void Matrix3x3<T>::symmetricEigen(Vector3D<T>& values, Matrix3x3<T>& vectors) const
+    {
+        const T epsilon = std::numeric_limits<T>::epsilon();
+        T a[3][3], v[3][3];
+
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                a[r][c] = _m[c * 3 + r];
+                v[r][c] = r == c ? T(1.0) : T(0.0);
+            }
+        }
+
+        for (int sweep = 0; sweep < 32; ++sweep)
+        {
+            bool rotated = false;
+
+            for (int p = 0; p < 2; ++p)
+            {
+                for (int q = p + 1; q < 3; ++q)
+                {
+                    // Off-diagonal element negligible next to the diagonal
+                    if (std::fabs(a[p][q]) <= epsilon * (std::fabs(a[p][p]) + std::fabs(a[q][q])))
+                    {
+                        a[p][q] = a[q][p] = T(0.0);
+                        continue;
+                    }
+
+                    // Rotation that zeroes a[p][q]
+                    T theta = (a[q][q] - a[p][p]) / (T(2.0) * a[p][q]);
+                    T t = (theta < T(0.0) ? T(-1.0) : T(1.0)) / (std::fabs(theta) + std::sqrt(theta * theta + T(1.0)));
+                    T c = T(1.0) / std::sqrt(t * t + T(1.0));
+                    T s = t * c;
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        T akp = a[k][p], akq = a[k][q];
+                        a[k][p] = c * akp - s * akq;
+                        a[k][q] = s * akp + c * akq;
+                    }
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        T apk = a[p][k], aqk = a[q][k];
+                        a[p][k] = c * apk - s * aqk;
+                        a[q][k] = s * apk + c * aqk;
+                    }
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        T vkp = v[k][p], vkq = v[k][q];
+                        v[k][p] = c * vkp - s * vkq;
+                        v[k][q] = s * vkp + c * vkq;
+                    }
+
+                    rotated = true;
+                }
+            }
+
+            if (!rotated)
+            {
+                break;
+            }
+        }
+
+        // Sort by decreasing eigenvalue
+        int order[3] = { 0, 1, 2 };
+
+        for (int i = 0; i < 2; ++i)
+        {
+            for (int j = i + 1; j < 3; ++j)
+            {
+                if (a[order[j]][order[j]] > a[order[i]][order[i]])
+                {
+                    int tmp = order[i];
+                    order[i] = order[j];
+                    order[j] = tmp;
+                }
+            }
+        }
+
+        values = Vector3D<T>(a[order[0]][order[0]], a[order[1]][order[1]], a[order[2]][order[2]]);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                vectors[i * 3 + k] = v[k][order[i]];
+            }
+        }
+
+        // Third axis from the first two, so the basis is right-handed
+        vectors[6] = vectors[1] * vectors[5] - vectors[2] * vectors[4];
+        vectors[7] = vectors[2] * vectors[3] - vectors[0] * vectors[5];
+        vectors[8] = vectors[0] * vectors[4] - vectors[1] * vectors[3];
+    }
 }
 #endif // MATRIX3X3_H
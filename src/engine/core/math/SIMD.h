@@ -0,0 +1,937 @@
+/**
+ * \file SIMD.h
+ * \brief Thin wrappers over SIMD registers used by the bulk (batched) code paths
+ * of the engine.
+ *
+ * @SIMDFloat holds @SIMDFloat::WIDTH single precision lanes and @SIMDInt the same
+ * number of 32 bit integer lanes. The width depends on the instruction set the
+ * engine is compiled for (see ArchitectureInfo.h):
+ *
+ * AVX2: 8 lanes (__m256 / __m256i).
+ * SSE2: 4 lanes (__m128 / __m128i).
+ * None: 4 lanes emulated with plain arrays, so batched algorithms keep a single
+ *       code path on every platform.
+ *
+ * Comparisons return masks with all bits of a lane set when the comparison
+ * holds, in the same way SSE/AVX do. Masks are consumed by @select(),
+ * @movemask(), @any() and @all().
+ *
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ *
+ * @author: Eder A. Perez.
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cmath>
+#include <cstring>
+#include "ArchitectureInfo.h"
+#include "AlignedAllocator.h"
+#include "DataType.h"
+
+#if defined(NUT_AVX2)
+    #include <immintrin.h>
+#elif defined(NUT_SSE41)
+    #include <smmintrin.h>
+#elif defined(NUT_SSE2)
+    #include <emmintrin.h>
+#endif
+
+
+
+/**
+ * \def NUT_SIMD_ALIGNMENT
+ * \brief Alignment, in bytes, required by @SIMDFloat::load() and @SIMDFloat::store().
+ */
+#if defined(NUT_AVX2)
+    #define NUT_SIMD_ALIGNMENT 32
+#else
+    #define NUT_SIMD_ALIGNMENT 16
+#endif
+
+
+
+namespace nut
+{
+    class SIMDInt;
+
+    /**
+     * \brief @SIMDFloat::WIDTH single precision floating-point lanes.
+     */
+    class SIMDFloat
+    {
+        public:
+
+        #if defined(NUT_AVX2)
+            typedef __m256 Native;
+            static const int WIDTH = 8;
+        #elif defined(NUT_SSE2)
+            typedef __m128 Native;
+            static const int WIDTH = 4;
+        #else
+            union Native { float f[4]; U32 u[4]; }; // Bits accessed as in IntFloat
+            static const int WIDTH = 4;
+        #endif
+
+        Native native; /**< Underlying register. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor. Lanes are left uninitialized.
+         */
+        SIMDFloat()
+        {
+        }
+
+        /**
+         * Broadcast a scalar to all lanes.
+         *
+         * @param s Scalar value.
+         */
+        SIMDFloat(float s)
+        {
+            #if defined(NUT_AVX2)
+                native = _mm256_set1_ps(s);
+            #elif defined(NUT_SSE2)
+                native = _mm_set1_ps(s);
+            #else
+                for (int i = 0; i < WIDTH; ++i) native.f[i] = s;
+            #endif
+        }
+
+        /**
+         * Wrap a native register.
+         *
+         * @param n Native register.
+         */
+        explicit SIMDFloat(const Native& n) : native(n)
+        {
+        }
+
+
+
+        /// Load and store ///
+
+        /**
+         * Load @WIDTH values from a @NUT_SIMD_ALIGNMENT aligned address.
+         */
+        static SIMDFloat load(const float* p)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDFloat(_mm256_load_ps(p));
+            #elif defined(NUT_SSE2)
+                return SIMDFloat(_mm_load_ps(p));
+            #else
+                return loadu(p);
+            #endif
+        }
+
+        /**
+         * Load @WIDTH values from any address.
+         */
+        static SIMDFloat loadu(const float* p)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDFloat(_mm256_loadu_ps(p));
+            #elif defined(NUT_SSE2)
+                return SIMDFloat(_mm_loadu_ps(p));
+            #else
+                SIMDFloat r;
+                memcpy(r.native.f, p, sizeof(r.native.f));
+                return r;
+            #endif
+        }
+
+        /**
+         * Store @WIDTH values to a @NUT_SIMD_ALIGNMENT aligned address.
+         */
+        void store(float* p) const
+        {
+            #if defined(NUT_AVX2)
+                _mm256_store_ps(p, native);
+            #elif defined(NUT_SSE2)
+                _mm_store_ps(p, native);
+            #else
+                storeu(p);
+            #endif
+        }
+
+        /**
+         * Store @WIDTH values to any address.
+         */
+        void storeu(float* p) const
+        {
+            #if defined(NUT_AVX2)
+                _mm256_storeu_ps(p, native);
+            #elif defined(NUT_SSE2)
+                _mm_storeu_ps(p, native);
+            #else
+                memcpy(p, native.f, sizeof(native.f));
+            #endif
+        }
+
+        /**
+         * Load lane i from @base[@idx[i]].
+         */
+        static SIMDFloat gather(const float* base, const SIMDInt& idx);
+
+        /**
+         * Lanes set to (0, 1, 2, ..., WIDTH - 1).
+         */
+        static SIMDFloat sequence()
+        {
+            #if defined(NUT_AVX2)
+                return SIMDFloat(_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+            #elif defined(NUT_SSE2)
+                return SIMDFloat(_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+            #else
+                SIMDFloat r;
+                for (int i = 0; i < WIDTH; ++i) r.native.f[i] = float(i);
+                return r;
+            #endif
+        }
+
+        /**
+         * Read a single lane. It is slow, so keep it out of inner loops.
+         *
+         * @param i Lane index in [0, WIDTH).
+         */
+        float lane(int i) const
+        {
+            ALIGNED_ALLOC_DECL(float, tmp[WIDTH], NUT_SIMD_ALIGNMENT);
+            store(tmp);
+            return tmp[i];
+        }
+
+
+
+        /// Conversions ///
+
+        /**
+         * Convert integer lanes to floating-point lanes.
+         */
+        static SIMDFloat fromInt(const SIMDInt& v);
+
+        /**
+         * Reinterpret the bits of integer lanes as floating-point lanes.
+         */
+        static SIMDFloat asFloat(const SIMDInt& v);
+
+
+
+        /// Math ///
+
+        static SIMDFloat min(const SIMDFloat& a, const SIMDFloat& b)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDFloat(_mm256_min_ps(a.native, b.native));
+            #elif defined(NUT_SSE2)
+                return SIMDFloat(_mm_min_ps(a.native, b.native));
+            #else
+                SIMDFloat r;
+                for (int i = 0; i < WIDTH; ++i) r.native.f[i] = a.native.f[i] < b.native.f[i] ? a.native.f[i] : b.native.f[i];
+                return r;
+            #endif
+        }
+
+        static SIMDFloat max(const SIMDFloat& a, const SIMDFloat& b)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDFloat(_mm256_max_ps(a.native, b.native));
+            #elif defined(NUT_SSE2)
+                return SIMDFloat(_mm_max_ps(a.native, b.native));
+            #else
+                SIMDFloat r;
+                for (int i = 0; i < WIDTH; ++i) r.native.f[i] = a.native.f[i] > b.native.f[i] ? a.native.f[i] : b.native.f[i];
+                return r;
+            #endif
+        }
+
+        static SIMDFloat sqrt(const SIMDFloat& a)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDFloat(_mm256_sqrt_ps(a.native));
+            #elif defined(NUT_SSE2)
+                return SIMDFloat(_mm_sqrt_ps(a.native));
+            #else
+                SIMDFloat r;
+                for (int i = 0; i < WIDTH; ++i) r.native.f[i] = std::sqrt(a.native.f[i]);
+                return r;
+            #endif
+        }
+
+        static SIMDFloat abs(const SIMDFloat& a)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDFloat(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.native));
+            #elif defined(NUT_SSE2)
+                return SIMDFloat(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.native));
+            #else
+                SIMDFloat r;
+                for (int i = 0; i < WIDTH; ++i) r.native.f[i] = std::fabs(a.native.f[i]);
+                return r;
+            #endif
+        }
+
+        /**
+         * Round lanes towards negative infinity. The SSE2 path is valid for
+         * |@a| < 2^31.
+         */
+        static SIMDFloat floor(const SIMDFloat& a)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDFloat(_mm256_floor_ps(a.native));
+            #elif defined(NUT_SSE41)
+                return SIMDFloat(_mm_floor_ps(a.native));
+            #elif defined(NUT_SSE2)
+                __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.native));
+                return SIMDFloat(_mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.native), _mm_set1_ps(1.0f))));
+            #else
+                SIMDFloat r;
+                for (int i = 0; i < WIDTH; ++i) r.native.f[i] = std::floor(a.native.f[i]);
+                return r;
+            #endif
+        }
+
+        /**
+         * Multiply-add: @a * @b + @c. It is fused when FMA is available.
+         */
+        static SIMDFloat fmadd(const SIMDFloat& a, const SIMDFloat& b, const SIMDFloat& c)
+        {
+            #if defined(NUT_AVX2) && defined(NUT_FMA)
+                return SIMDFloat(_mm256_fmadd_ps(a.native, b.native, c.native));
+            #else
+                return a * b + c;
+            #endif
+        }
+
+        /**
+         * Choose lanes from @a where @mask is set and from @b elsewhere.
+         */
+        static SIMDFloat select(const SIMDFloat& mask, const SIMDFloat& a, const SIMDFloat& b)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDFloat(_mm256_blendv_ps(b.native, a.native, mask.native));
+            #elif defined(NUT_SSE41)
+                return SIMDFloat(_mm_blendv_ps(b.native, a.native, mask.native));
+            #else
+                return (mask & a) | andnot(mask, b);
+            #endif
+        }
+
+        /**
+         * Compute ~@a & @b bitwise.
+         */
+        static SIMDFloat andnot(const SIMDFloat& a, const SIMDFloat& b)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDFloat(_mm256_andnot_ps(a.native, b.native));
+            #elif defined(NUT_SSE2)
+                return SIMDFloat(_mm_andnot_ps(a.native, b.native));
+            #else
+                SIMDFloat r;
+                for (int i = 0; i < WIDTH; ++i) r.native.u[i] = ~a.native.u[i] & b.native.u[i];
+                return r;
+            #endif
+        }
+
+        /**
+         * Gather the sign bit of every lane into an integer (bit i is lane i).
+         */
+        static int movemask(const SIMDFloat& mask)
+        {
+            #if defined(NUT_AVX2)
+                return _mm256_movemask_ps(mask.native);
+            #elif defined(NUT_SSE2)
+                return _mm_movemask_ps(mask.native);
+            #else
+                int bits = 0;
+                for (int i = 0; i < WIDTH; ++i) bits |= int(mask.native.u[i] >> 31) << i;
+                return bits;
+            #endif
+        }
+
+        /**
+         * Return true if any lane of @mask is set.
+         */
+        static bool any(const SIMDFloat& mask)
+        {
+            return movemask(mask) != 0;
+        }
+
+        /**
+         * Return true if all lanes of @mask are set.
+         */
+        static bool all(const SIMDFloat& mask)
+        {
+            return movemask(mask) == (1 << WIDTH) - 1;
+        }
+
+        /**
+         * Horizontal minimum.
+         */
+        static float reduceMin(const SIMDFloat& a)
+        {
+            ALIGNED_ALLOC_DECL(float, tmp[WIDTH], NUT_SIMD_ALIGNMENT);
+            a.store(tmp);
+            float r = tmp[0];
+            for (int i = 1; i < WIDTH; ++i) r = tmp[i] < r ? tmp[i] : r;
+            return r;
+        }
+
+        /**
+         * Horizontal maximum.
+         */
+        static float reduceMax(const SIMDFloat& a)
+        {
+            ALIGNED_ALLOC_DECL(float, tmp[WIDTH], NUT_SIMD_ALIGNMENT);
+            a.store(tmp);
+            float r = tmp[0];
+            for (int i = 1; i < WIDTH; ++i) r = tmp[i] > r ? tmp[i] : r;
+            return r;
+        }
+
+        /**
+         * Horizontal sum.
+         */
+        static float reduceAdd(const SIMDFloat& a)
+        {
+            ALIGNED_ALLOC_DECL(float, tmp[WIDTH], NUT_SIMD_ALIGNMENT);
+            a.store(tmp);
+            float r = tmp[0];
+            for (int i = 1; i < WIDTH; ++i) r += tmp[i];
+            return r;
+        }
+
+
+
+        /// Operators ///
+
+        #if defined(NUT_AVX2)
+            #define NUT_SIMDFLOAT_BINARY_OP(op, intrinsic) \
+                SIMDFloat operator op (const SIMDFloat& b) const { return SIMDFloat(intrinsic(native, b.native)); }
+            #define NUT_SIMDFLOAT_COMPARE_OP(op, predicate) \
+                SIMDFloat operator op (const SIMDFloat& b) const { return SIMDFloat(_mm256_cmp_ps(native, b.native, predicate)); }
+
+            NUT_SIMDFLOAT_BINARY_OP(+, _mm256_add_ps)
+            NUT_SIMDFLOAT_BINARY_OP(-, _mm256_sub_ps)
+            NUT_SIMDFLOAT_BINARY_OP(*, _mm256_mul_ps)
+            NUT_SIMDFLOAT_BINARY_OP(/, _mm256_div_ps)
+            NUT_SIMDFLOAT_BINARY_OP(&, _mm256_and_ps)
+            NUT_SIMDFLOAT_BINARY_OP(|, _mm256_or_ps)
+            NUT_SIMDFLOAT_BINARY_OP(^, _mm256_xor_ps)
+            NUT_SIMDFLOAT_COMPARE_OP(<, _CMP_LT_OQ)
+            NUT_SIMDFLOAT_COMPARE_OP(<=, _CMP_LE_OQ)
+            NUT_SIMDFLOAT_COMPARE_OP(>, _CMP_GT_OQ)
+            NUT_SIMDFLOAT_COMPARE_OP(>=, _CMP_GE_OQ)
+            NUT_SIMDFLOAT_COMPARE_OP(==, _CMP_EQ_OQ)
+            NUT_SIMDFLOAT_COMPARE_OP(!=, _CMP_NEQ_UQ)
+        #elif defined(NUT_SSE2)
+            #define NUT_SIMDFLOAT_BINARY_OP(op, intrinsic) \
+                SIMDFloat operator op (const SIMDFloat& b) const { return SIMDFloat(intrinsic(native, b.native)); }
+            #define NUT_SIMDFLOAT_COMPARE_OP(op, intrinsic) NUT_SIMDFLOAT_BINARY_OP(op, intrinsic)
+
+            NUT_SIMDFLOAT_BINARY_OP(+, _mm_add_ps)
+            NUT_SIMDFLOAT_BINARY_OP(-, _mm_sub_ps)
+            NUT_SIMDFLOAT_BINARY_OP(*, _mm_mul_ps)
+            NUT_SIMDFLOAT_BINARY_OP(/, _mm_div_ps)
+            NUT_SIMDFLOAT_BINARY_OP(&, _mm_and_ps)
+            NUT_SIMDFLOAT_BINARY_OP(|, _mm_or_ps)
+            NUT_SIMDFLOAT_BINARY_OP(^, _mm_xor_ps)
+            NUT_SIMDFLOAT_COMPARE_OP(<, _mm_cmplt_ps)
+            NUT_SIMDFLOAT_COMPARE_OP(<=, _mm_cmple_ps)
+            NUT_SIMDFLOAT_COMPARE_OP(>, _mm_cmpgt_ps)
+            NUT_SIMDFLOAT_COMPARE_OP(>=, _mm_cmpge_ps)
+            NUT_SIMDFLOAT_COMPARE_OP(==, _mm_cmpeq_ps)
+            NUT_SIMDFLOAT_COMPARE_OP(!=, _mm_cmpneq_ps)
+        #else
+            #define NUT_SIMDFLOAT_BINARY_OP(op, unused) \
+                SIMDFloat operator op (const SIMDFloat& b) const \
+                { SIMDFloat r; for (int i = 0; i < WIDTH; ++i) r.native.f[i] = native.f[i] op b.native.f[i]; return r; }
+            #define NUT_SIMDFLOAT_BITWISE_OP(op, unused) \
+                SIMDFloat operator op (const SIMDFloat& b) const \
+                { SIMDFloat r; for (int i = 0; i < WIDTH; ++i) r.native.u[i] = native.u[i] op b.native.u[i]; return r; }
+            #define NUT_SIMDFLOAT_COMPARE_OP(op, unused) \
+                SIMDFloat operator op (const SIMDFloat& b) const \
+                { SIMDFloat r; for (int i = 0; i < WIDTH; ++i) r.native.u[i] = native.f[i] op b.native.f[i] ? 0xFFFFFFFFu : 0u; return r; }
+
+            NUT_SIMDFLOAT_BINARY_OP(+, 0)
+            NUT_SIMDFLOAT_BINARY_OP(-, 0)
+            NUT_SIMDFLOAT_BINARY_OP(*, 0)
+            NUT_SIMDFLOAT_BINARY_OP(/, 0)
+            NUT_SIMDFLOAT_BITWISE_OP(&, 0)
+            NUT_SIMDFLOAT_BITWISE_OP(|, 0)
+            NUT_SIMDFLOAT_BITWISE_OP(^, 0)
+            NUT_SIMDFLOAT_COMPARE_OP(<, 0)
+            NUT_SIMDFLOAT_COMPARE_OP(<=, 0)
+            NUT_SIMDFLOAT_COMPARE_OP(>, 0)
+            NUT_SIMDFLOAT_COMPARE_OP(>=, 0)
+            NUT_SIMDFLOAT_COMPARE_OP(==, 0)
+            NUT_SIMDFLOAT_COMPARE_OP(!=, 0)
+
+            #undef NUT_SIMDFLOAT_BITWISE_OP
+        #endif
+
+        #undef NUT_SIMDFLOAT_BINARY_OP
+        #undef NUT_SIMDFLOAT_COMPARE_OP
+
+        SIMDFloat operator - () const
+        {
+            return *this ^ SIMDFloat(-0.0f);
+        }
+
+        SIMDFloat& operator += (const SIMDFloat& b) { return *this = *this + b; }
+        SIMDFloat& operator -= (const SIMDFloat& b) { return *this = *this - b; }
+        SIMDFloat& operator *= (const SIMDFloat& b) { return *this = *this * b; }
+        SIMDFloat& operator /= (const SIMDFloat& b) { return *this = *this / b; }
+        SIMDFloat& operator &= (const SIMDFloat& b) { return *this = *this & b; }
+        SIMDFloat& operator |= (const SIMDFloat& b) { return *this = *this | b; }
+    };
+
+
+
+    /**
+     * \brief @SIMDInt::WIDTH 32 bit integer lanes (same count as @SIMDFloat).
+     */
+    class SIMDInt
+    {
+        public:
+
+        #if defined(NUT_AVX2)
+            typedef __m256i Native;
+        #elif defined(NUT_SSE2)
+            typedef __m128i Native;
+        #else
+            struct Native { I32 i[4]; };
+        #endif
+
+        static const int WIDTH = SIMDFloat::WIDTH;
+
+        Native native; /**< Underlying register. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor. Lanes are left uninitialized.
+         */
+        SIMDInt()
+        {
+        }
+
+        /**
+         * Broadcast a scalar to all lanes.
+         *
+         * @param s Scalar value.
+         */
+        SIMDInt(I32 s)
+        {
+            #if defined(NUT_AVX2)
+                native = _mm256_set1_epi32(s);
+            #elif defined(NUT_SSE2)
+                native = _mm_set1_epi32(s);
+            #else
+                for (int i = 0; i < WIDTH; ++i) native.i[i] = s;
+            #endif
+        }
+
+        /**
+         * Wrap a native register.
+         *
+         * @param n Native register.
+         */
+        explicit SIMDInt(const Native& n) : native(n)
+        {
+        }
+
+
+
+        /// Load and store ///
+
+        /**
+         * Load @WIDTH values from a @NUT_SIMD_ALIGNMENT aligned address.
+         */
+        static SIMDInt load(const I32* p)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDInt(_mm256_load_si256(reinterpret_cast<const __m256i*>(p)));
+            #elif defined(NUT_SSE2)
+                return SIMDInt(_mm_load_si128(reinterpret_cast<const __m128i*>(p)));
+            #else
+                return loadu(p);
+            #endif
+        }
+
+        /**
+         * Load @WIDTH values from any address.
+         */
+        static SIMDInt loadu(const I32* p)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDInt(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+            #elif defined(NUT_SSE2)
+                return SIMDInt(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+            #else
+                SIMDInt r;
+                memcpy(r.native.i, p, sizeof(r.native.i));
+                return r;
+            #endif
+        }
+
+        /**
+         * Store @WIDTH values to a @NUT_SIMD_ALIGNMENT aligned address.
+         */
+        void store(I32* p) const
+        {
+            #if defined(NUT_AVX2)
+                _mm256_store_si256(reinterpret_cast<__m256i*>(p), native);
+            #elif defined(NUT_SSE2)
+                _mm_store_si128(reinterpret_cast<__m128i*>(p), native);
+            #else
+                storeu(p);
+            #endif
+        }
+
+        /**
+         * Store @WIDTH values to any address.
+         */
+        void storeu(I32* p) const
+        {
+            #if defined(NUT_AVX2)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), native);
+            #elif defined(NUT_SSE2)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(p), native);
+            #else
+                memcpy(p, native.i, sizeof(native.i));
+            #endif
+        }
+
+        /**
+         * Load lane i from @base[@idx[i]].
+         */
+        static SIMDInt gather(const I32* base, const SIMDInt& idx)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDInt(_mm256_i32gather_epi32(base, idx.native, 4));
+            #else
+                ALIGNED_ALLOC_DECL(I32, i[WIDTH], NUT_SIMD_ALIGNMENT);
+                ALIGNED_ALLOC_DECL(I32, r[WIDTH], NUT_SIMD_ALIGNMENT);
+                idx.store(i);
+                for (int n = 0; n < WIDTH; ++n) r[n] = base[i[n]];
+                return load(r);
+            #endif
+        }
+
+        /**
+         * Lanes set to (0, 1, 2, ..., WIDTH - 1).
+         */
+        static SIMDInt sequence()
+        {
+            #if defined(NUT_AVX2)
+                return SIMDInt(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            #elif defined(NUT_SSE2)
+                return SIMDInt(_mm_setr_epi32(0, 1, 2, 3));
+            #else
+                SIMDInt r;
+                for (int i = 0; i < WIDTH; ++i) r.native.i[i] = i;
+                return r;
+            #endif
+        }
+
+        /**
+         * Read a single lane. It is slow, so keep it out of inner loops.
+         *
+         * @param i Lane index in [0, WIDTH).
+         */
+        I32 lane(int i) const
+        {
+            ALIGNED_ALLOC_DECL(I32, tmp[WIDTH], NUT_SIMD_ALIGNMENT);
+            store(tmp);
+            return tmp[i];
+        }
+
+
+
+        /// Conversions ///
+
+        /**
+         * Convert floating-point lanes to integer lanes, truncating towards zero.
+         */
+        static SIMDInt fromFloat(const SIMDFloat& v)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDInt(_mm256_cvttps_epi32(v.native));
+            #elif defined(NUT_SSE2)
+                return SIMDInt(_mm_cvttps_epi32(v.native));
+            #else
+                SIMDInt r;
+                for (int i = 0; i < WIDTH; ++i) r.native.i[i] = I32(v.native.f[i]);
+                return r;
+            #endif
+        }
+
+        /**
+         * Reinterpret the bits of floating-point lanes as integer lanes.
+         */
+        static SIMDInt asInt(const SIMDFloat& v)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDInt(_mm256_castps_si256(v.native));
+            #elif defined(NUT_SSE2)
+                return SIMDInt(_mm_castps_si128(v.native));
+            #else
+                SIMDInt r;
+                memcpy(r.native.i, v.native.f, sizeof(r.native.i));
+                return r;
+            #endif
+        }
+
+
+
+        /// Math ///
+
+        /**
+         * Lane-wise multiplication keeping the low 32 bits.
+         */
+        static SIMDInt mullo(const SIMDInt& a, const SIMDInt& b)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDInt(_mm256_mullo_epi32(a.native, b.native));
+            #elif defined(NUT_SSE41)
+                return SIMDInt(_mm_mullo_epi32(a.native, b.native));
+            #elif defined(NUT_SSE2)
+                __m128i even = _mm_mul_epu32(a.native, b.native);
+                __m128i odd = _mm_mul_epu32(_mm_srli_si128(a.native, 4), _mm_srli_si128(b.native, 4));
+                return SIMDInt(_mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))));
+            #else
+                SIMDInt r;
+                for (int i = 0; i < WIDTH; ++i) r.native.i[i] = I32(U32(a.native.i[i]) * U32(b.native.i[i]));
+                return r;
+            #endif
+        }
+
+        /**
+         * Arithmetic (sign-extending) right shift.
+         */
+        static SIMDInt sra(const SIMDInt& a, int count)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDInt(_mm256_srai_epi32(a.native, count));
+            #elif defined(NUT_SSE2)
+                return SIMDInt(_mm_srai_epi32(a.native, count));
+            #else
+                SIMDInt r;
+                for (int i = 0; i < WIDTH; ++i) r.native.i[i] = a.native.i[i] >> count;
+                return r;
+            #endif
+        }
+
+        /**
+         * Left shift by a per-lane count. Counts of 32 or more give zero, like
+         * AVX2 does; negative counts are not allowed.
+         */
+        static SIMDInt sllv(const SIMDInt& a, const SIMDInt& count)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDInt(_mm256_sllv_epi32(a.native, count.native));
+            #elif defined(NUT_SSE2)
+                // Multiply by 2^count, built in the exponent of a float. The
+                // conversion of 2^31 overflows to 0x80000000, which is 1 << 31.
+                __m128i exponent = _mm_slli_epi32(_mm_add_epi32(count.native, _mm_set1_epi32(127)), 23);
+                SIMDInt pow2(_mm_cvttps_epi32(_mm_castsi128_ps(exponent)));
+                return select(count > SIMDInt(31), SIMDInt(0), mullo(a, pow2));
+            #else
+                SIMDInt r;
+                for (int i = 0; i < WIDTH; ++i) r.native.i[i] = count.native.i[i] < 32 ? I32(U32(a.native.i[i]) << count.native.i[i]) : 0;
+                return r;
+            #endif
+        }
+
+        static SIMDInt min(const SIMDInt& a, const SIMDInt& b)
+        {
+            return select(a < b, a, b);
+        }
+
+        static SIMDInt max(const SIMDInt& a, const SIMDInt& b)
+        {
+            return select(a > b, a, b);
+        }
+
+        /**
+         * Choose lanes from @a where @mask is set and from @b elsewhere.
+         */
+        static SIMDInt select(const SIMDInt& mask, const SIMDInt& a, const SIMDInt& b)
+        {
+            #if defined(NUT_AVX2)
+                return SIMDInt(_mm256_blendv_epi8(b.native, a.native, mask.native));
+            #elif defined(NUT_SSE2)
+                return SIMDInt(_mm_or_si128(_mm_and_si128(mask.native, a.native), _mm_andnot_si128(mask.native, b.native)));
+            #else
+                SIMDInt r;
+                for (int i = 0; i < WIDTH; ++i) r.native.i[i] = (mask.native.i[i] & a.native.i[i]) | (~mask.native.i[i] & b.native.i[i]);
+                return r;
+            #endif
+        }
+
+        /**
+         * Gather the sign bit of every lane into an integer (bit i is lane i).
+         */
+        static int movemask(const SIMDInt& mask)
+        {
+            return SIMDFloat::movemask(SIMDFloat::asFloat(mask));
+        }
+
+
+
+        /// Operators ///
+
+        #if defined(NUT_AVX2)
+            #define NUT_SIMDINT_BINARY_OP(op, intrinsic) \
+                SIMDInt operator op (const SIMDInt& b) const { return SIMDInt(intrinsic(native, b.native)); }
+
+            NUT_SIMDINT_BINARY_OP(+, _mm256_add_epi32)
+            NUT_SIMDINT_BINARY_OP(-, _mm256_sub_epi32)
+            NUT_SIMDINT_BINARY_OP(&, _mm256_and_si256)
+            NUT_SIMDINT_BINARY_OP(|, _mm256_or_si256)
+            NUT_SIMDINT_BINARY_OP(^, _mm256_xor_si256)
+            NUT_SIMDINT_BINARY_OP(==, _mm256_cmpeq_epi32)
+            NUT_SIMDINT_BINARY_OP(>, _mm256_cmpgt_epi32)
+
+            SIMDInt operator < (const SIMDInt& b) const { return SIMDInt(_mm256_cmpgt_epi32(b.native, native)); }
+            SIMDInt operator << (int count) const { return SIMDInt(_mm256_slli_epi32(native, count)); }
+            SIMDInt operator >> (int count) const { return SIMDInt(_mm256_srli_epi32(native, count)); }
+        #elif defined(NUT_SSE2)
+            #define NUT_SIMDINT_BINARY_OP(op, intrinsic) \
+                SIMDInt operator op (const SIMDInt& b) const { return SIMDInt(intrinsic(native, b.native)); }
+
+            NUT_SIMDINT_BINARY_OP(+, _mm_add_epi32)
+            NUT_SIMDINT_BINARY_OP(-, _mm_sub_epi32)
+            NUT_SIMDINT_BINARY_OP(&, _mm_and_si128)
+            NUT_SIMDINT_BINARY_OP(|, _mm_or_si128)
+            NUT_SIMDINT_BINARY_OP(^, _mm_xor_si128)
+            NUT_SIMDINT_BINARY_OP(==, _mm_cmpeq_epi32)
+            NUT_SIMDINT_BINARY_OP(>, _mm_cmpgt_epi32)
+            NUT_SIMDINT_BINARY_OP(<, _mm_cmplt_epi32)
+
+            SIMDInt operator << (int count) const { return SIMDInt(_mm_slli_epi32(native, count)); }
+            SIMDInt operator >> (int count) const { return SIMDInt(_mm_srli_epi32(native, count)); }
+        #else
+            #define NUT_SIMDINT_BINARY_OP(op, unused) \
+                SIMDInt operator op (const SIMDInt& b) const \
+                { SIMDInt r; for (int i = 0; i < WIDTH; ++i) r.native.i[i] = I32(U32(native.i[i]) op U32(b.native.i[i])); return r; }
+            #define NUT_SIMDINT_COMPARE_OP(op) \
+                SIMDInt operator op (const SIMDInt& b) const \
+                { SIMDInt r; for (int i = 0; i < WIDTH; ++i) r.native.i[i] = native.i[i] op b.native.i[i] ? -1 : 0; return r; }
+
+            NUT_SIMDINT_BINARY_OP(+, 0)
+            NUT_SIMDINT_BINARY_OP(-, 0)
+            NUT_SIMDINT_BINARY_OP(&, 0)
+            NUT_SIMDINT_BINARY_OP(|, 0)
+            NUT_SIMDINT_BINARY_OP(^, 0)
+            NUT_SIMDINT_COMPARE_OP(==)
+            NUT_SIMDINT_COMPARE_OP(>)
+            NUT_SIMDINT_COMPARE_OP(<)
+
+            SIMDInt operator << (int count) const
+            {
+                SIMDInt r;
+                for (int i = 0; i < WIDTH; ++i) r.native.i[i] = I32(U32(native.i[i]) << count);
+                return r;
+            }
+
+            SIMDInt operator >> (int count) const
+            {
+                SIMDInt r;
+                for (int i = 0; i < WIDTH; ++i) r.native.i[i] = I32(U32(native.i[i]) >> count);
+                return r;
+            }
+
+            #undef NUT_SIMDINT_COMPARE_OP
+        #endif
+
+        #undef NUT_SIMDINT_BINARY_OP
+
+        SIMDInt& operator += (const SIMDInt& b) { return *this = *this + b; }
+        SIMDInt& operator -= (const SIMDInt& b) { return *this = *this - b; }
+        SIMDInt& operator &= (const SIMDInt& b) { return *this = *this & b; }
+        SIMDInt& operator |= (const SIMDInt& b) { return *this = *this | b; }
+        SIMDInt& operator ^= (const SIMDInt& b) { return *this = *this ^ b; }
+    };
+
+
+
+    /// Definitions depending on both types ///
+
+    inline SIMDFloat SIMDFloat::gather(const float* base, const SIMDInt& idx)
+    {
+        #if defined(NUT_AVX2)
+            return SIMDFloat(_mm256_i32gather_ps(base, idx.native, 4));
+        #else
+            ALIGNED_ALLOC_DECL(I32, i[WIDTH], NUT_SIMD_ALIGNMENT);
+            ALIGNED_ALLOC_DECL(float, r[WIDTH], NUT_SIMD_ALIGNMENT);
+            idx.store(i);
+            for (int n = 0; n < WIDTH; ++n) r[n] = base[i[n]];
+            return load(r);
+        #endif
+    }
+
+    inline SIMDFloat SIMDFloat::fromInt(const SIMDInt& v)
+    {
+        #if defined(NUT_AVX2)
+            return SIMDFloat(_mm256_cvtepi32_ps(v.native));
+        #elif defined(NUT_SSE2)
+            return SIMDFloat(_mm_cvtepi32_ps(v.native));
+        #else
+            SIMDFloat r;
+            for (int i = 0; i < WIDTH; ++i) r.native.f[i] = float(v.native.i[i]);
+            return r;
+        #endif
+    }
+
+    inline SIMDFloat SIMDFloat::asFloat(const SIMDInt& v)
+    {
+        #if defined(NUT_AVX2)
+            return SIMDFloat(_mm256_castsi256_ps(v.native));
+        #elif defined(NUT_SSE2)
+            return SIMDFloat(_mm_castsi128_ps(v.native));
+        #else
+            SIMDFloat r;
+            memcpy(r.native.f, v.native.i, sizeof(r.native.f));
+            return r;
+        #endif
+    }
+
+
+    /**
+     * \brief Write the indices of the lanes set in a @movemask() result, so
+     * batched tests can output a compacted list of the elements that passed.
+     *
+     * @param bits Lane bits, as returned by @SIMDFloat::movemask().
+     * @param first Index of the element in lane 0.
+     * @param indices Destination, with room for @SIMDFloat::WIDTH indices.
+     * @return Number of indices written.
+     */
+    inline size_t compactLanes(int bits, size_t first, U32* indices)
+    {
+        size_t n = 0;
+
+        for (int lane = 0; bits; ++lane, bits >>= 1)
+        {
+            if (bits & 1)
+            {
+                indices[n++] = U32(first + lane);
+            }
+        }
+
+        return n;
+    }
+}
+
+#endif // SIMD_H
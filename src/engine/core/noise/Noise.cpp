@@ -0,0 +1,827 @@
+/** 
+ * \file Noise.cpp
+ * \brief Coherent gradient noise (Perlin and simplex) and fractal combinations.
+ * 
+ * Every basis function has a scalar version and a @SIMDFloat version computing
+ * the same operations in the same order. Fractal combinations are templates
+ * instantiated for both, so @fillGrid() and the scalar methods agree.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <cmath>
+#include <cstring>
+#include "Noise.h"
+#include "PCG32.h"
+#include "SIMD.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    /// Scalar helpers ///
+
+    static inline int fastFloor(float x)
+    {
+        int i = int(x);
+        return x < float(i) ? i - 1 : i;
+    }
+
+    static inline float fade(float t)
+    {
+        return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+    }
+
+    static inline float lerp(float t, float a, float b)
+    {
+        return a + t * (b - a);
+    }
+
+    static inline float absolute(float x)
+    {
+        return std::fabs(x);
+    }
+
+    /**
+     * Dot product between (x, y) and one of 8 gradients selected by @hash.
+     */
+    static inline float grad(int hash, float x, float y)
+    {
+        int h = hash & 7;
+        float u = h < 4 ? x : y;
+        float v = h < 4 ? y : x;
+        return ((h & 1) ? -u : u) + ((h & 2) ? -2.0f * v : 2.0f * v);
+    }
+
+    /**
+     * Dot product between (x, y, z) and one of the 12 edge gradients (16 entries)
+     * selected by @hash, as in Perlin's improved noise.
+     */
+    static inline float grad(int hash, float x, float y, float z)
+    {
+        int h = hash & 15;
+        float u = h < 8 ? x : y;
+        float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+        return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+    }
+
+    /**
+     * Dot product between (x, y, z, w) and one of 32 gradients selected by @hash.
+     */
+    static inline float grad(int hash, float x, float y, float z, float w)
+    {
+        int h = hash & 31;
+        float u = h < 24 ? x : y;
+        float v = h < 16 ? y : z;
+        float s = h < 8 ? z : w;
+        return ((h & 1) ? -u : u) + ((h & 2) ? -v : v) + ((h & 4) ? -s : s);
+    }
+
+
+
+    /// SIMD helpers ///
+
+    static inline SIMDFloat fade(const SIMDFloat& t)
+    {
+        return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+    }
+
+    static inline SIMDFloat lerp(const SIMDFloat& t, const SIMDFloat& a, const SIMDFloat& b)
+    {
+        return a + t * (b - a);
+    }
+
+    static inline SIMDFloat absolute(const SIMDFloat& x)
+    {
+        return SIMDFloat::abs(x);
+    }
+
+    /**
+     * Flip the sign of @v in the lanes where @bits (0 or a single bit) is set.
+     */
+    static inline SIMDFloat negateIf(const SIMDFloat& v, const SIMDInt& bits, int bit)
+    {
+        return v ^ SIMDFloat::asFloat(bits << (31 - bit));
+    }
+
+    static inline SIMDFloat grad(const SIMDInt& hash, const SIMDFloat& x, const SIMDFloat& y)
+    {
+        SIMDFloat low = SIMDFloat::asFloat((hash & 4) == SIMDInt(0));
+        SIMDFloat u = SIMDFloat::select(low, x, y);
+        SIMDFloat v = SIMDFloat::select(low, y, x);
+        return negateIf(u, hash & 1, 0) + negateIf(v * 2.0f, hash & 2, 1);
+    }
+
+    static inline SIMDFloat grad(const SIMDInt& hash, const SIMDFloat& x, const SIMDFloat& y, const SIMDFloat& z)
+    {
+        SIMDInt h = hash & 15;
+        SIMDFloat u = SIMDFloat::select(SIMDFloat::asFloat(h < SIMDInt(8)), x, y);
+        SIMDFloat xz = SIMDFloat::select(SIMDFloat::asFloat((h == SIMDInt(12)) | (h == SIMDInt(14))), x, z);
+        SIMDFloat v = SIMDFloat::select(SIMDFloat::asFloat(h < SIMDInt(4)), y, xz);
+        return negateIf(u, h & 1, 0) + negateIf(v, h & 2, 1);
+    }
+
+
+
+    /// Perlin noise ///
+
+    static float perlinBasis(const I32* p, float x, float y)
+    {
+        int ix = fastFloor(x);
+        int iy = fastFloor(y);
+        float x0 = x - float(ix);
+        float y0 = y - float(iy);
+        float x1 = x0 - 1.0f;
+        float y1 = y0 - 1.0f;
+
+        ix &= 255;
+        iy &= 255;
+
+        int a = p[ix] + iy;
+        int b = p[ix + 1] + iy;
+
+        float u = fade(x0);
+        float v = fade(y0);
+
+        float n0 = lerp(v, grad(p[a], x0, y0), grad(p[a + 1], x0, y1));
+        float n1 = lerp(v, grad(p[b], x1, y0), grad(p[b + 1], x1, y1));
+
+        return 0.507f * lerp(u, n0, n1);
+    }
+
+    static SIMDFloat perlinBasis(const I32* p, const SIMDFloat& x, const SIMDFloat& y)
+    {
+        SIMDFloat fx = SIMDFloat::floor(x);
+        SIMDFloat fy = SIMDFloat::floor(y);
+        SIMDFloat x0 = x - fx;
+        SIMDFloat y0 = y - fy;
+        SIMDFloat x1 = x0 - 1.0f;
+        SIMDFloat y1 = y0 - 1.0f;
+
+        SIMDInt ix = SIMDInt::fromFloat(fx) & 255;
+        SIMDInt iy = SIMDInt::fromFloat(fy) & 255;
+
+        SIMDInt a = SIMDInt::gather(p, ix) + iy;
+        SIMDInt b = SIMDInt::gather(p, ix + 1) + iy;
+
+        SIMDFloat u = fade(x0);
+        SIMDFloat v = fade(y0);
+
+        SIMDFloat n0 = lerp(v, grad(SIMDInt::gather(p, a), x0, y0), grad(SIMDInt::gather(p, a + 1), x0, y1));
+        SIMDFloat n1 = lerp(v, grad(SIMDInt::gather(p, b), x1, y0), grad(SIMDInt::gather(p, b + 1), x1, y1));
+
+        return lerp(u, n0, n1) * 0.507f;
+    }
+
+    static float perlinBasis(const I32* p, float x, float y, float z)
+    {
+        int ix = fastFloor(x);
+        int iy = fastFloor(y);
+        int iz = fastFloor(z);
+        float x0 = x - float(ix);
+        float y0 = y - float(iy);
+        float z0 = z - float(iz);
+        float x1 = x0 - 1.0f;
+        float y1 = y0 - 1.0f;
+        float z1 = z0 - 1.0f;
+
+        ix &= 255;
+        iy &= 255;
+        iz &= 255;
+
+        int a = p[ix] + iy;
+        int aa = p[a] + iz;
+        int ab = p[a + 1] + iz;
+        int b = p[ix + 1] + iy;
+        int ba = p[b] + iz;
+        int bb = p[b + 1] + iz;
+
+        float u = fade(x0);
+        float v = fade(y0);
+        float w = fade(z0);
+
+        float n0 = lerp(v, lerp(u, grad(p[aa], x0, y0, z0), grad(p[ba], x1, y0, z0)),
+                           lerp(u, grad(p[ab], x0, y1, z0), grad(p[bb], x1, y1, z0)));
+        float n1 = lerp(v, lerp(u, grad(p[aa + 1], x0, y0, z1), grad(p[ba + 1], x1, y0, z1)),
+                           lerp(u, grad(p[ab + 1], x0, y1, z1), grad(p[bb + 1], x1, y1, z1)));
+
+        return 0.936f * lerp(w, n0, n1);
+    }
+
+    static SIMDFloat perlinBasis(const I32* p, const SIMDFloat& x, const SIMDFloat& y, const SIMDFloat& z)
+    {
+        SIMDFloat fx = SIMDFloat::floor(x);
+        SIMDFloat fy = SIMDFloat::floor(y);
+        SIMDFloat fz = SIMDFloat::floor(z);
+        SIMDFloat x0 = x - fx;
+        SIMDFloat y0 = y - fy;
+        SIMDFloat z0 = z - fz;
+        SIMDFloat x1 = x0 - 1.0f;
+        SIMDFloat y1 = y0 - 1.0f;
+        SIMDFloat z1 = z0 - 1.0f;
+
+        SIMDInt ix = SIMDInt::fromFloat(fx) & 255;
+        SIMDInt iy = SIMDInt::fromFloat(fy) & 255;
+        SIMDInt iz = SIMDInt::fromFloat(fz) & 255;
+
+        SIMDInt a = SIMDInt::gather(p, ix) + iy;
+        SIMDInt aa = SIMDInt::gather(p, a) + iz;
+        SIMDInt ab = SIMDInt::gather(p, a + 1) + iz;
+        SIMDInt b = SIMDInt::gather(p, ix + 1) + iy;
+        SIMDInt ba = SIMDInt::gather(p, b) + iz;
+        SIMDInt bb = SIMDInt::gather(p, b + 1) + iz;
+
+        SIMDFloat u = fade(x0);
+        SIMDFloat v = fade(y0);
+        SIMDFloat w = fade(z0);
+
+        SIMDFloat n0 = lerp(v, lerp(u, grad(SIMDInt::gather(p, aa), x0, y0, z0), grad(SIMDInt::gather(p, ba), x1, y0, z0)),
+                               lerp(u, grad(SIMDInt::gather(p, ab), x0, y1, z0), grad(SIMDInt::gather(p, bb), x1, y1, z0)));
+        SIMDFloat n1 = lerp(v, lerp(u, grad(SIMDInt::gather(p, aa + 1), x0, y0, z1), grad(SIMDInt::gather(p, ba + 1), x1, y0, z1)),
+                               lerp(u, grad(SIMDInt::gather(p, ab + 1), x0, y1, z1), grad(SIMDInt::gather(p, bb + 1), x1, y1, z1)));
+
+        return lerp(w, n0, n1) * 0.936f;
+    }
+
+    static float perlinBasis(const I32* p, float x, float y, float z, float w)
+    {
+        int i[4] = { fastFloor(x), fastFloor(y), fastFloor(z), fastFloor(w) };
+        float f[4] = { x - float(i[0]), y - float(i[1]), z - float(i[2]), w - float(i[3]) };
+        float n[16];
+
+        for (int d = 0; d < 4; ++d)
+        {
+            i[d] &= 255;
+        }
+
+        // Corner c has offset (c & 1, c >> 1 & 1, c >> 2 & 1, c >> 3 & 1)
+        for (int c = 0; c < 16; ++c)
+        {
+            int dx = c & 1, dy = (c >> 1) & 1, dz = (c >> 2) & 1, dw = (c >> 3) & 1;
+            int h = p[i[0] + dx + p[i[1] + dy + p[i[2] + dz + p[i[3] + dw]]]];
+            n[c] = grad(h, f[0] - float(dx), f[1] - float(dy), f[2] - float(dz), f[3] - float(dw));
+        }
+
+        // Collapse one dimension at a time
+        for (int d = 0, corners = 16; d < 4; ++d)
+        {
+            float t = fade(f[d]);
+            corners /= 2;
+
+            for (int c = 0; c < corners; ++c)
+            {
+                n[c] = lerp(t, n[2 * c], n[2 * c + 1]);
+            }
+        }
+
+        return 0.87f * n[0];
+    }
+
+
+
+    /// Simplex noise ///
+
+    static const float F2 = 0.366025403f; // (sqrt(3) - 1) / 2
+    static const float G2 = 0.211324865f; // (3 - sqrt(3)) / 6
+    static const float F3 = 0.333333333f;
+    static const float G3 = 0.166666667f;
+    static const float F4 = 0.309016994f; // (sqrt(5) - 1) / 4
+    static const float G4 = 0.138196601f; // (5 - sqrt(5)) / 20
+
+    static float simplexBasis(const I32* p, float x, float y)
+    {
+        // Skew the input space to find the simplex cell
+        float s = (x + y) * F2;
+        int i = fastFloor(x + s);
+        int j = fastFloor(y + s);
+        float t = float(i + j) * G2;
+        float x0 = x - (float(i) - t);
+        float y0 = y - (float(j) - t);
+
+        // Lower or upper triangle
+        int i1 = x0 > y0 ? 1 : 0;
+        int j1 = 1 - i1;
+
+        float x1 = x0 - float(i1) + G2;
+        float y1 = y0 - float(j1) + G2;
+        float x2 = x0 - 1.0f + 2.0f * G2;
+        float y2 = y0 - 1.0f + 2.0f * G2;
+
+        i &= 255;
+        j &= 255;
+
+        float t0 = 0.5f - x0 * x0 - y0 * y0;
+        float t1 = 0.5f - x1 * x1 - y1 * y1;
+        float t2 = 0.5f - x2 * x2 - y2 * y2;
+        t0 = t0 < 0.0f ? 0.0f : t0 * t0;
+        t1 = t1 < 0.0f ? 0.0f : t1 * t1;
+        t2 = t2 < 0.0f ? 0.0f : t2 * t2;
+
+        float n0 = t0 * t0 * grad(p[i + p[j]], x0, y0);
+        float n1 = t1 * t1 * grad(p[i + i1 + p[j + j1]], x1, y1);
+        float n2 = t2 * t2 * grad(p[i + 1 + p[j + 1]], x2, y2);
+
+        return 40.0f * (n0 + n1 + n2);
+    }
+
+    static SIMDFloat simplexBasis(const I32* p, const SIMDFloat& x, const SIMDFloat& y)
+    {
+        SIMDFloat s = (x + y) * F2;
+        SIMDFloat fi = SIMDFloat::floor(x + s);
+        SIMDFloat fj = SIMDFloat::floor(y + s);
+        SIMDFloat t = (fi + fj) * G2;
+        SIMDFloat x0 = x - (fi - t);
+        SIMDFloat y0 = y - (fj - t);
+
+        SIMDFloat lower = x0 > y0;
+        SIMDInt i1 = SIMDInt::asInt(lower) & 1;
+        SIMDInt j1 = SIMDInt(1) - i1;
+
+        SIMDFloat x1 = x0 - SIMDFloat::fromInt(i1) + G2;
+        SIMDFloat y1 = y0 - SIMDFloat::fromInt(j1) + G2;
+        SIMDFloat x2 = x0 - 1.0f + 2.0f * G2;
+        SIMDFloat y2 = y0 - 1.0f + 2.0f * G2;
+
+        SIMDInt i = SIMDInt::fromFloat(fi) & 255;
+        SIMDInt j = SIMDInt::fromFloat(fj) & 255;
+
+        SIMDFloat zero(0.0f);
+        SIMDFloat t0 = SIMDFloat::max(SIMDFloat(0.5f) - x0 * x0 - y0 * y0, zero);
+        SIMDFloat t1 = SIMDFloat::max(SIMDFloat(0.5f) - x1 * x1 - y1 * y1, zero);
+        SIMDFloat t2 = SIMDFloat::max(SIMDFloat(0.5f) - x2 * x2 - y2 * y2, zero);
+        t0 = t0 * t0;
+        t1 = t1 * t1;
+        t2 = t2 * t2;
+
+        SIMDFloat n0 = t0 * t0 * grad(SIMDInt::gather(p, i + SIMDInt::gather(p, j)), x0, y0);
+        SIMDFloat n1 = t1 * t1 * grad(SIMDInt::gather(p, i + i1 + SIMDInt::gather(p, j + j1)), x1, y1);
+        SIMDFloat n2 = t2 * t2 * grad(SIMDInt::gather(p, i + 1 + SIMDInt::gather(p, j + 1)), x2, y2);
+
+        return (n0 + n1 + n2) * 40.0f;
+    }
+
+    static float simplexBasis(const I32* p, float x, float y, float z)
+    {
+        float s = (x + y + z) * F3;
+        int i = fastFloor(x + s);
+        int j = fastFloor(y + s);
+        int k = fastFloor(z + s);
+        float t = float(i + j + k) * G3;
+        float x0 = x - (float(i) - t);
+        float y0 = y - (float(j) - t);
+        float z0 = z - (float(k) - t);
+
+        // Rank the coordinates to find which of the six tetrahedra holds the point
+        int xy = x0 >= y0, xz = x0 >= z0, yz = y0 >= z0;
+        int i1 = xy & xz, j1 = (xy ^ 1) & yz, k1 = (xz ^ 1) & (yz ^ 1);
+        int i2 = xy | xz, j2 = (xy ^ 1) | yz, k2 = (xz & yz) ^ 1;
+
+        float x1 = x0 - float(i1) + G3;
+        float y1 = y0 - float(j1) + G3;
+        float z1 = z0 - float(k1) + G3;
+        float x2 = x0 - float(i2) + 2.0f * G3;
+        float y2 = y0 - float(j2) + 2.0f * G3;
+        float z2 = z0 - float(k2) + 2.0f * G3;
+        float x3 = x0 - 1.0f + 3.0f * G3;
+        float y3 = y0 - 1.0f + 3.0f * G3;
+        float z3 = z0 - 1.0f + 3.0f * G3;
+
+        i &= 255;
+        j &= 255;
+        k &= 255;
+
+        float t0 = 0.6f - x0 * x0 - y0 * y0 - z0 * z0;
+        float t1 = 0.6f - x1 * x1 - y1 * y1 - z1 * z1;
+        float t2 = 0.6f - x2 * x2 - y2 * y2 - z2 * z2;
+        float t3 = 0.6f - x3 * x3 - y3 * y3 - z3 * z3;
+        t0 = t0 < 0.0f ? 0.0f : t0 * t0;
+        t1 = t1 < 0.0f ? 0.0f : t1 * t1;
+        t2 = t2 < 0.0f ? 0.0f : t2 * t2;
+        t3 = t3 < 0.0f ? 0.0f : t3 * t3;
+
+        float n0 = t0 * t0 * grad(p[i + p[j + p[k]]], x0, y0, z0);
+        float n1 = t1 * t1 * grad(p[i + i1 + p[j + j1 + p[k + k1]]], x1, y1, z1);
+        float n2 = t2 * t2 * grad(p[i + i2 + p[j + j2 + p[k + k2]]], x2, y2, z2);
+        float n3 = t3 * t3 * grad(p[i + 1 + p[j + 1 + p[k + 1]]], x3, y3, z3);
+
+        return 32.0f * (n0 + n1 + n2 + n3);
+    }
+
+    static SIMDFloat simplexBasis(const I32* p, const SIMDFloat& x, const SIMDFloat& y, const SIMDFloat& z)
+    {
+        SIMDFloat s = (x + y + z) * F3;
+        SIMDFloat fi = SIMDFloat::floor(x + s);
+        SIMDFloat fj = SIMDFloat::floor(y + s);
+        SIMDFloat fk = SIMDFloat::floor(z + s);
+        SIMDFloat t = (fi + fj + fk) * G3;
+        SIMDFloat x0 = x - (fi - t);
+        SIMDFloat y0 = y - (fj - t);
+        SIMDFloat z0 = z - (fk - t);
+
+        SIMDInt one(1);
+        SIMDInt xy = SIMDInt::asInt(x0 >= y0) & one;
+        SIMDInt xz = SIMDInt::asInt(x0 >= z0) & one;
+        SIMDInt yz = SIMDInt::asInt(y0 >= z0) & one;
+        SIMDInt i1 = xy & xz, j1 = (xy ^ one) & yz, k1 = (xz ^ one) & (yz ^ one);
+        SIMDInt i2 = xy | xz, j2 = (xy ^ one) | yz, k2 = (xz & yz) ^ one;
+
+        SIMDFloat x1 = x0 - SIMDFloat::fromInt(i1) + G3;
+        SIMDFloat y1 = y0 - SIMDFloat::fromInt(j1) + G3;
+        SIMDFloat z1 = z0 - SIMDFloat::fromInt(k1) + G3;
+        SIMDFloat x2 = x0 - SIMDFloat::fromInt(i2) + 2.0f * G3;
+        SIMDFloat y2 = y0 - SIMDFloat::fromInt(j2) + 2.0f * G3;
+        SIMDFloat z2 = z0 - SIMDFloat::fromInt(k2) + 2.0f * G3;
+        SIMDFloat x3 = x0 - 1.0f + 3.0f * G3;
+        SIMDFloat y3 = y0 - 1.0f + 3.0f * G3;
+        SIMDFloat z3 = z0 - 1.0f + 3.0f * G3;
+
+        SIMDInt i = SIMDInt::fromFloat(fi) & 255;
+        SIMDInt j = SIMDInt::fromFloat(fj) & 255;
+        SIMDInt k = SIMDInt::fromFloat(fk) & 255;
+
+        SIMDFloat zero(0.0f);
+        SIMDFloat t0 = SIMDFloat::max(SIMDFloat(0.6f) - x0 * x0 - y0 * y0 - z0 * z0, zero);
+        SIMDFloat t1 = SIMDFloat::max(SIMDFloat(0.6f) - x1 * x1 - y1 * y1 - z1 * z1, zero);
+        SIMDFloat t2 = SIMDFloat::max(SIMDFloat(0.6f) - x2 * x2 - y2 * y2 - z2 * z2, zero);
+        SIMDFloat t3 = SIMDFloat::max(SIMDFloat(0.6f) - x3 * x3 - y3 * y3 - z3 * z3, zero);
+        t0 = t0 * t0;
+        t1 = t1 * t1;
+        t2 = t2 * t2;
+        t3 = t3 * t3;
+
+        SIMDInt h0 = SIMDInt::gather(p, i + SIMDInt::gather(p, j + SIMDInt::gather(p, k)));
+        SIMDInt h1 = SIMDInt::gather(p, i + i1 + SIMDInt::gather(p, j + j1 + SIMDInt::gather(p, k + k1)));
+        SIMDInt h2 = SIMDInt::gather(p, i + i2 + SIMDInt::gather(p, j + j2 + SIMDInt::gather(p, k + k2)));
+        SIMDInt h3 = SIMDInt::gather(p, i + 1 + SIMDInt::gather(p, j + 1 + SIMDInt::gather(p, k + 1)));
+
+        SIMDFloat n0 = t0 * t0 * grad(h0, x0, y0, z0);
+        SIMDFloat n1 = t1 * t1 * grad(h1, x1, y1, z1);
+        SIMDFloat n2 = t2 * t2 * grad(h2, x2, y2, z2);
+        SIMDFloat n3 = t3 * t3 * grad(h3, x3, y3, z3);
+
+        return (n0 + n1 + n2 + n3) * 32.0f;
+    }
+
+    static float simplexBasis(const I32* p, float x, float y, float z, float w)
+    {
+        float s = (x + y + z + w) * F4;
+        int i = fastFloor(x + s);
+        int j = fastFloor(y + s);
+        int k = fastFloor(z + s);
+        int l = fastFloor(w + s);
+        float t = float(i + j + k + l) * G4;
+        float c0[4] = { x - (float(i) - t), y - (float(j) - t), z - (float(k) - t), w - (float(l) - t) };
+
+        // Rank each coordinate: the largest one is stepped first
+        int rank[4] = { 0, 0, 0, 0 };
+
+        for (int a = 0; a < 4; ++a)
+        {
+            for (int b = a + 1; b < 4; ++b)
+            {
+                if (c0[a] > c0[b]) ++rank[a]; else ++rank[b];
+            }
+        }
+
+        i &= 255;
+        j &= 255;
+        k &= 255;
+        l &= 255;
+
+        float n = 0.0f;
+
+        // Corner 0 is the cell origin, corner 4 is the opposite one
+        for (int c = 0; c < 5; ++c)
+        {
+            int o[4];
+            float d[4];
+
+            for (int a = 0; a < 4; ++a)
+            {
+                o[a] = rank[a] >= 4 - c ? 1 : 0;
+                d[a] = c0[a] - float(o[a]) + float(c) * G4;
+            }
+
+            float tc = 0.6f - d[0] * d[0] - d[1] * d[1] - d[2] * d[2] - d[3] * d[3];
+
+            if (tc > 0.0f)
+            {
+                int h = p[i + o[0] + p[j + o[1] + p[k + o[2] + p[l + o[3]]]]];
+                tc *= tc;
+                n += tc * tc * grad(h, d[0], d[1], d[2], d[3]);
+            }
+        }
+
+        return 27.0f * n;
+    }
+
+
+
+    /// Fractals ///
+
+    template <class T>
+    static T basis(const I32* p, Noise::Basis b, const T& x, const T& y)
+    {
+        return b == Noise::Basis::PERLIN ? perlinBasis(p, x, y) : simplexBasis(p, x, y);
+    }
+
+    template <class T>
+    static T basis(const I32* p, Noise::Basis b, const T& x, const T& y, const T& z)
+    {
+        return b == Noise::Basis::PERLIN ? perlinBasis(p, x, y, z) : simplexBasis(p, x, y, z);
+    }
+
+    template <class T>
+    static T basis(const I32* p, Noise::Basis b, const T& x, const T& y, const T& z, const T& w)
+    {
+        return b == Noise::Basis::PERLIN ? perlinBasis(p, x, y, z, w) : simplexBasis(p, x, y, z, w);
+    }
+
+    /**
+     * Sum of octaves. @Sample returns the basis noise at the given frequency.
+     */
+    template <class T, class Sample>
+    static T octaves(const Noise::Fractal& f, bool ridged, Sample sample)
+    {
+        T sum(0.0f);
+        float amplitude = 1.0f;
+        float frequency = f.frequency;
+        float norm = 0.0f;
+
+        for (int o = 0; o < f.octaves; ++o)
+        {
+            T n = sample(frequency);
+
+            if (ridged)
+            {
+                n = T(1.0f) - absolute(n);
+                n = n * n;
+            }
+
+            sum = sum + n * amplitude;
+            norm += amplitude;
+            amplitude *= f.gain;
+            frequency *= f.lacunarity;
+        }
+
+        return norm > 0.0f ? sum * (1.0f / norm) : T(0.0f);
+    }
+
+    template <class T>
+    static T octaves(const I32* p, const Noise::Fractal& f, bool ridged, const T& x, const T& y)
+    {
+        return octaves<T>(f, ridged, [&](float s) { return basis(p, f.basis, x * s, y * s); });
+    }
+
+    template <class T>
+    static T octaves(const I32* p, const Noise::Fractal& f, bool ridged, const T& x, const T& y, const T& z)
+    {
+        return octaves<T>(f, ridged, [&](float s) { return basis(p, f.basis, x * s, y * s, z * s); });
+    }
+
+    template <class T>
+    static T octaves(const I32* p, const Noise::Fractal& f, bool ridged, const T& x, const T& y, const T& z, const T& w)
+    {
+        return octaves<T>(f, ridged, [&](float s) { return basis(p, f.basis, x * s, y * s, z * s, w * s); });
+    }
+
+    /**
+     * Fractal over a domain displaced by an fBm vector field. The offsets
+     * decorrelate the components of the field.
+     */
+    template <class T>
+    static T warped(const I32* p, const Noise::Fractal& f, T x, T y)
+    {
+        if (f.warp != 0.0f)
+        {
+            T qx = octaves(p, f, false, x, y);
+            T qy = octaves(p, f, false, T(x + 5.2f), T(y + 1.3f));
+            x = x + qx * f.warp;
+            y = y + qy * f.warp;
+        }
+
+        return octaves(p, f, f.mode == Noise::Mode::RIDGED, x, y);
+    }
+
+    template <class T>
+    static T warped(const I32* p, const Noise::Fractal& f, T x, T y, T z)
+    {
+        if (f.warp != 0.0f)
+        {
+            T qx = octaves(p, f, false, x, y, z);
+            T qy = octaves(p, f, false, T(x + 5.2f), T(y + 1.3f), T(z + 2.8f));
+            T qz = octaves(p, f, false, T(x + 1.7f), T(y + 9.2f), T(z + 3.4f));
+            x = x + qx * f.warp;
+            y = y + qy * f.warp;
+            z = z + qz * f.warp;
+        }
+
+        return octaves(p, f, f.mode == Noise::Mode::RIDGED, x, y, z);
+    }
+
+    /**
+     * Evaluate @eval over the rows of a grid, @SIMDFloat::WIDTH columns at a
+     * time, spreading chunks of rows across the thread pool.
+     */
+    template <class Eval>
+    static void fillRows(float* out, int width, int height, float x0, float y0, float step, Eval eval)
+    {
+        if (width <= 0 || height <= 0)
+        {
+            return;
+        }
+
+        // Keep chunks around a few thousand samples
+        size_t grain = 4096 / size_t(width) + 1;
+
+        ThreadPool::getInstance().parallelFor(size_t(height), grain, [=](size_t begin, size_t end)
+        {
+            for (size_t row = begin; row < end; ++row)
+            {
+                SIMDFloat y(y0 + float(row) * step);
+                float* dst = out + row * size_t(width);
+
+                for (int i = 0; i < width; i += SIMDFloat::WIDTH)
+                {
+                    SIMDFloat x = SIMDFloat(x0) + SIMDFloat::fromInt(SIMDInt::sequence() + i) * step;
+                    SIMDFloat n = eval(x, y);
+
+                    if (i + SIMDFloat::WIDTH <= width)
+                    {
+                        n.storeu(dst + i);
+                    }
+                    else
+                    {
+                        ALIGNED_ALLOC_DECL(float, tail[SIMDFloat::WIDTH], NUT_SIMD_ALIGNMENT);
+                        n.store(tail);
+                        std::memcpy(dst + i, tail, sizeof(float) * size_t(width - i));
+                    }
+                }
+            }
+        });
+    }
+
+
+
+    /// Noise ///
+
+    Noise::Noise(U64 seed)
+    {
+        this->seed(seed);
+    }
+
+
+
+    void Noise::seed(U64 seed)
+    {
+        PCG32 rng(seed);
+
+        for (int i = 0; i < 256; ++i)
+        {
+            _perm[i] = i;
+        }
+
+        // Fisher-Yates shuffle
+        for (int i = 255; i > 0; --i)
+        {
+            int j = int(rng.nextBounded(U32(i + 1)));
+            I32 tmp = _perm[i];
+            _perm[i] = _perm[j];
+            _perm[j] = tmp;
+        }
+
+        for (int i = 0; i < 256; ++i)
+        {
+            _perm[i + 256] = _perm[i];
+        }
+    }
+
+
+
+    float Noise::perlin(float x, float y) const
+    {
+        return perlinBasis(_perm, x, y);
+    }
+
+
+
+    float Noise::perlin(float x, float y, float z) const
+    {
+        return perlinBasis(_perm, x, y, z);
+    }
+
+
+
+    float Noise::perlin(float x, float y, float z, float w) const
+    {
+        return perlinBasis(_perm, x, y, z, w);
+    }
+
+
+
+    float Noise::simplex(float x, float y) const
+    {
+        return simplexBasis(_perm, x, y);
+    }
+
+
+
+    float Noise::simplex(float x, float y, float z) const
+    {
+        return simplexBasis(_perm, x, y, z);
+    }
+
+
+
+    float Noise::simplex(float x, float y, float z, float w) const
+    {
+        return simplexBasis(_perm, x, y, z, w);
+    }
+
+
+
+    float Noise::fbm(float x, float y, const Fractal& fractal) const
+    {
+        return octaves(_perm, fractal, false, x, y);
+    }
+
+
+
+    float Noise::fbm(float x, float y, float z, const Fractal& fractal) const
+    {
+        return octaves(_perm, fractal, false, x, y, z);
+    }
+
+
+
+    float Noise::fbm(float x, float y, float z, float w, const Fractal& fractal) const
+    {
+        return octaves(_perm, fractal, false, x, y, z, w);
+    }
+
+
+
+    float Noise::ridged(float x, float y, const Fractal& fractal) const
+    {
+        return octaves(_perm, fractal, true, x, y);
+    }
+
+
+
+    float Noise::ridged(float x, float y, float z, const Fractal& fractal) const
+    {
+        return octaves(_perm, fractal, true, x, y, z);
+    }
+
+
+
+    float Noise::ridged(float x, float y, float z, float w, const Fractal& fractal) const
+    {
+        return octaves(_perm, fractal, true, x, y, z, w);
+    }
+
+
+
+    float Noise::fractal(float x, float y, const Fractal& fractal) const
+    {
+        return warped(_perm, fractal, x, y);
+    }
+
+
+
+    float Noise::fractal(float x, float y, float z, const Fractal& fractal) const
+    {
+        return warped(_perm, fractal, x, y, z);
+    }
+
+
+
+    void Noise::fillGrid(float* out, int width, int height, float x0, float y0, float step,
+                         const Fractal& fractal) const
+    {
+        const I32* p = _perm;
+
+        fillRows(out, width, height, x0, y0, step, [p, &fractal](const SIMDFloat& x, const SIMDFloat& y)
+        {
+            return warped(p, fractal, x, y);
+        });
+    }
+
+
+
+    void Noise::fillGrid(float* out, int width, int height, float x0, float y0, float z, float step,
+                         const Fractal& fractal) const
+    {
+        const I32* p = _perm;
+
+        // Capture z as a float: closures may be heap allocated without the alignment of a register
+        fillRows(out, width, height, x0, y0, step, [p, z, &fractal](const SIMDFloat& x, const SIMDFloat& y)
+        {
+            return warped(p, fractal, x, y, SIMDFloat(z));
+        });
+    }
+}
@@ -0,0 +1,183 @@
+/** 
+ * \file Noise.h
+ * \brief Coherent gradient noise (Perlin and simplex, in 2, 3 and 4 dimensions)
+ * and fractal combinations of it (fBm, ridged multifractal and domain warping)
+ * for procedural terrain, textures and effects.
+ * 
+ * A @Noise instance owns a permutation table shuffled from a seed, so two
+ * instances with the same seed produce the same field on every platform.
+ * Single samples are evaluated with the scalar methods; whole grids (e.g.
+ * heightmaps) with @fillGrid(), which evaluates @SIMDFloat::WIDTH samples at
+ * once and spreads rows across the @ThreadPool. Both paths compute the same
+ * field (up to floating-point rounding).
+ * 
+ * Output ranges are approximately [-1, 1], except @ridged() which is in [0, 1].
+ * 
+ * sources: Ken Perlin, "Improving Noise" (SIGGRAPH 2002).
+ *          Stefan Gustavson, "Simplex noise demystified" (2005).
+ *          Inigo Quilez, "Domain warping" (2002).
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef NOISE_H
+#define NOISE_H
+
+#include "DataType.h"
+
+
+
+namespace nut
+{
+    class Noise
+    {
+        public:
+
+        /**
+         * Noise function summed by the fractal methods.
+         */
+        enum class Basis
+        {
+            PERLIN,
+            SIMPLEX
+        };
+
+        /**
+         * How octaves are combined by @fractal().
+         */
+        enum class Mode
+        {
+            FBM,    /**< Fractal Brownian motion: plain weighted sum. */
+            RIDGED  /**< Ridged multifractal: sum of (1 - |noise|)^2. */
+        };
+
+        /**
+         * \brief Parameters of the fractal methods.
+         */
+        struct Fractal
+        {
+            Basis basis;
+            Mode mode;
+            int octaves;      /**< Number of summed layers. */
+            float frequency;  /**< Frequency of the first octave. */
+            float lacunarity; /**< Frequency multiplier between octaves. */
+            float gain;       /**< Amplitude multiplier between octaves. */
+            float warp;       /**< Domain warping displacement; 0 disables warping. */
+
+            Fractal()
+                : basis(Basis::SIMPLEX), mode(Mode::FBM), octaves(6),
+                  frequency(1.0f), lacunarity(2.0f), gain(0.5f), warp(0.0f) {}
+        };
+
+
+
+        /// Constructors ///
+
+        /**
+         * Instantiates a noise generator.
+         * 
+         * @param seed Seed used to shuffle the permutation table.
+         */
+        explicit Noise(U64 seed = 88675123);
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Shuffle the permutation table. Same seed, same noise.
+         * 
+         * @param seed New seed, expanded with @PCG32.
+         */
+        void seed(U64 seed);
+
+        /**
+         * \brief Shuffle the permutation table drawing the seed from an engine
+         * random number generator (@Xoshiro256, @PCG32, @XORShift...).
+         * 
+         * @param engine Generator providing next().
+         */
+        template <class Engine>
+        void seed(Engine& engine)
+        {
+            U64 hi = U64(engine.next());
+            seed((hi << 32) ^ U64(engine.next()));
+        }
+
+        /**
+         * \brief Perlin's improved gradient noise.
+         */
+        float perlin(float x, float y) const;
+        float perlin(float x, float y, float z) const;
+        float perlin(float x, float y, float z, float w) const;
+
+        /**
+         * \brief Simplex noise. Cheaper than @perlin() in 3 and 4 dimensions and
+         * free of axis-aligned artifacts.
+         */
+        float simplex(float x, float y) const;
+        float simplex(float x, float y, float z) const;
+        float simplex(float x, float y, float z, float w) const;
+
+        /**
+         * \brief Fractal Brownian motion: @Fractal::octaves layers of the basis
+         * noise, normalized by the sum of amplitudes.
+         */
+        float fbm(float x, float y, const Fractal& fractal) const;
+        float fbm(float x, float y, float z, const Fractal& fractal) const;
+        float fbm(float x, float y, float z, float w, const Fractal& fractal) const;
+
+        /**
+         * \brief Ridged multifractal, in [0, 1]. Sharp crests where the basis
+         * noise crosses zero, useful for mountain ranges.
+         */
+        float ridged(float x, float y, const Fractal& fractal) const;
+        float ridged(float x, float y, float z, const Fractal& fractal) const;
+        float ridged(float x, float y, float z, float w, const Fractal& fractal) const;
+
+        /**
+         * \brief Evaluate @fractal as described by its parameters: @fbm() or
+         * @ridged() according to @Fractal::mode, over a domain displaced by an
+         * fBm vector field scaled by @Fractal::warp.
+         */
+        float fractal(float x, float y, const Fractal& fractal) const;
+        float fractal(float x, float y, float z, const Fractal& fractal) const;
+
+        /**
+         * \brief Evaluate @fractal() over a regular grid, in parallel.
+         * 
+         * Sample (i, j) is taken at (x0 + i * step, y0 + j * step) and written
+         * to out[j * width + i].
+         * 
+         * @param out Destination, with at least @width * @height elements.
+         * @param width Number of columns.
+         * @param height Number of rows.
+         * @param x0 X coordinate of the first column.
+         * @param y0 Y coordinate of the first row.
+         * @param step Distance between samples.
+         * @param fractal Fractal parameters.
+         */
+        void fillGrid(float* out, int width, int height, float x0, float y0, float step,
+                      const Fractal& fractal) const;
+
+        /**
+         * \brief Same as above, over the slice @z of the 3D field (e.g. a frame
+         * of an animated 2D texture).
+         */
+        void fillGrid(float* out, int width, int height, float x0, float y0, float z, float step,
+                      const Fractal& fractal) const;
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        I32 _perm[512]; /**< Permutation of [0, 255], stored twice to avoid wrapping indices. */
+    };
+}
+
+#endif // NOISE_H
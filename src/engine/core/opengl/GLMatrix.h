@@ -406,6 +406,57 @@ namespace nut
             setFrustum(-right, right, -top, top, zNear, zFar);
         }
 
+        /**
+         * Map a point to window coordinates, like gluProject(), with this
+         * matrix as the model-view-projection matrix.
+         * 
+         * @param p A point in object space.
+         * @param viewport The viewport as (x, y, width, height), like in glViewport().
+         * @return Window coordinates: x and y in pixels from the bottom left corner
+         * of the window, and the depth in [0, 1].
+         */
+        Vector3D<T> project(const Vector3D<T>& p, const Vector4D<T>& viewport) const
+        {
+            Vector4D<T> clip = (*this) * Vector4D<T>(p.x, p.y, p.z, T(1.0));
+            T invW = T(1.0) / clip.w;
+
+            return Vector3D<T>(viewport.x + viewport.z * (clip.x * invW + T(1.0)) * T(0.5),
+                               viewport.y + viewport.w * (clip.y * invW + T(1.0)) * T(0.5),
+                               (clip.z * invW + T(1.0)) * T(0.5));
+        }
+
+        /**
+         * Map window coordinates back to object space, like gluUnProject(), with
+         * this matrix as the model-view-projection matrix. The matrix is inverted
+         * on each call; see @unprojectWithInverse() for many points.
+         * 
+         * @param window Window coordinates, as returned by @project(). A depth of 0
+         * gives a point on the near plane, 1 on the far plane.
+         * @param viewport The viewport as (x, y, width, height), like in glViewport().
+         * @return A point in object space.
+         */
+        Vector3D<T> unproject(const Vector3D<T>& window, const Vector4D<T>& viewport) const
+        {
+            return inverse().unprojectWithInverse(window, viewport);
+        }
+
+        /**
+         * Same as @unproject(), with this matrix as the INVERSE of the
+         * model-view-projection matrix (see @inverse()), so it is inverted once
+         * for many points.
+         */
+        Vector3D<T> unprojectWithInverse(const Vector3D<T>& window, const Vector4D<T>& viewport) const
+        {
+            Vector4D<T> ndc(T(2.0) * (window.x - viewport.x) / viewport.z - T(1.0),
+                            T(2.0) * (window.y - viewport.y) / viewport.w - T(1.0),
+                            T(2.0) * window.z - T(1.0),
+                            T(1.0));
+            Vector4D<T> p = (*this) * ndc;
+            T invW = T(1.0) / p.w;
+
+            return Vector3D<T>(p.x * invW, p.y * invW, p.z * invW);
+        }
+
 
 
         /// Operators ///
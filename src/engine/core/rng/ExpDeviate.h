@@ -1,9 +1,15 @@
 /** 
  * \file ExpDeviate.h
  * \brief This class generates exponential deviates (pseudo-random numbers distributed
- * exponentially).
+ * exponentially) using the ziggurat method.
  * 
- * source: Numerical Recipes in C, 2nd edition - chapter 7.2.
+ * Instances own their generator and can be used concurrently from different
+ * threads. The static @srand()/@rand() interface works on a per-thread instance
+ * seeded by @ThreadGenerator.
+ * To fill large arrays use @SIMDRandom::fillExponential() instead.
+ * 
+ * source: G. Marsaglia and W. W. Tsang, "The Ziggurat Method for Generating
+ * Random Variables", Journal of Statistical Software, vol. 5, 2000.
  * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
@@ -14,7 +20,9 @@
 #ifndef EXPDEVIATE_H
 #define EXPDEVIATE_H
 
-#include <cmath>
+#include "ThreadGenerator.h"
+#include "XORShift.h"
+#include "Ziggurat.h"
 
 
 
@@ -24,22 +32,33 @@ namespace nut
     {
         public:
 
-        /// Methods ///
+        /// Constructors ///
 
         /**
-         * Initialize random number generator.
+         * Instantiates a generator.
          * 
          * @param x Generator seed (default value 123456789).
          * @param y Generator seed (default value 362436069).
          * @param z Generator seed (default value 521288629).
          * @param w Generator seed (default value 88675123).
          */
-        static void srand(unsigned long x, unsigned long y, unsigned long z, unsigned long w)
+        ExpDeviate(U32 x = 123456789, U32 y = 362436069, U32 z = 521288629, U32 w = 88675123)
+            : _xorshift(x, y, z, w)
         {
-            _x = x;
-            _y = y;
-            _z = z;
-            _w = w;
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Initialize this generator.
+         * 
+         * @param x, y, z, w Generator seeds (not all zero).
+         */
+        void seed(U32 x, U32 y, U32 z, U32 w)
+        {
+            _xorshift.seed(x, y, z, w);
         }
 
         /**
@@ -48,20 +67,35 @@ namespace nut
          * @return A pseudo-random floating-point number exponentially distributed in
          * the range (0, +inf).
          */
-        static float rand()
+        float next()
         {
-            float value;
-
-            // Discarded
-            _xorshift();
+            return Ziggurat::exponential(_xorshift);
+        }
 
-            // Generate an uniform deviate for input for an exponential function
-            do
-            {
-                value = _xorshift();
-            } while (value == 0.0);
+        /**
+         * Initialize the calling thread's random number generator. The other
+         * threads reseed from these values on their next @rand().
+         * 
+         * @param x Generator seed (default value 123456789).
+         * @param y Generator seed (default value 362436069).
+         * @param z Generator seed (default value 521288629).
+         * @param w Generator seed (default value 88675123).
+         */
+        static void srand(unsigned long x, unsigned long y, unsigned long z, unsigned long w)
+        {
+            ThreadGenerator< ExpDeviate >::reseed(U32(x), U32(y), U32(z), U32(w)).seed(U32(x), U32(y), U32(z), U32(w));
+        }
 
-            return -log(value);
+        /**
+         * Compute an exponentially distributed, positive, random deviate of unit
+         * mean with the calling thread's generator.
+         * 
+         * @return A pseudo-random floating-point number exponentially distributed in
+         * the range (0, +inf).
+         */
+        static float rand()
+        {
+            return ThreadGenerator< ExpDeviate >::get().next();
         }
 
 
@@ -70,36 +104,19 @@ namespace nut
 
         /// Private attributes ///
 
-        static unsigned long _x, _y, _z, _w;
+        XORShift _xorshift;
 
 
 
         /// Private methods ///
 
-        /**
-         * Compute a uniformly distributed pseudo-random number.
-         * 
-         * @return A pseudo-random floating-point number uniformly distributed in
-         * the range [0, 1].
-         */
-        static float _xorshift()
-        {
-            unsigned long t;
-
-            t = (_x ^ (_x << 11));
-
-            _x = _y; _y = _z; _z = _w;
+        friend class ThreadGenerator< ExpDeviate >;
 
-            return _w = (_w ^ (_w >> 19)) ^ (t ^ (t >> 8));
+        void _seedThread(U64 seed)
+        {
+            _xorshift.seed(seed);
         }
     };
-
-    // Initialize private attributes
-
-    unsigned long XORShift::_x = 123456789;
-    unsigned long XORShift::_y = 362436069;
-    unsigned long XORShift::_z = 521288629;
-    unsigned long XORShift::_w = 88675123;
 }
 
 #endif // EXPDEVIATE_H
@@ -19,11 +19,6 @@
 
 namespace nut
 {
-    long Mother::_idum = 0;
-
-    short Mother::mother1[10] = { 0 };
-    short Mother::mother2[10] = { 0 };
-
     const long Mother::m16Long = 65536L;           // 2^16
     const long Mother::m16Mask = 0xFFFF;           // mask for lower 16 bits
     const long Mother::m15Mask = 0x7FFF;           // mask for lower 15 bits
@@ -32,11 +27,12 @@ namespace nut
 
 
 
-    void Mother::srand(long seed)
+    void Mother::seed(long seed)
     {
         unsigned short sNumber;
         unsigned long number;
-        short n, *p;
+        unsigned short* p;
+        short n;
 
         _idum = seed == 0 ? seed ^ 123459876 : seed; // Avoid using zero for seed
 
@@ -61,13 +57,13 @@ namespace nut
 
 
 
-    float Mother::rand()
+    float Mother::next()
     {
         unsigned long number1, number2;
 
         // Move elements 1 to 8 to 2 to 9
-        memcpy((char*)mother1 + 2,(char*)mother1 + 1, 8 * sizeof(short));
-        memcpy((char*)mother2 + 2,(char*)mother2 + 1, 8 * sizeof(short));
+        memmove(mother1 + 2, mother1 + 1, 8 * sizeof(short));
+        memmove(mother2 + 2, mother2 + 1, 8 * sizeof(short));
 
         // Put the carry values in numberi
         number1 = mother1[0];
@@ -93,9 +89,9 @@ namespace nut
         mother2[1] = m16Mask & number2;
 
         // Combine the two 16 bit random numbers into one 32 bit
-        _idum = ( ( (long)mother1[1] ) << 16) + (long)mother2[1];
+        _idum = ( ( (unsigned long)mother1[1] ) << 16) + (unsigned long)mother2[1];
 
         // Return a float value between 0 and 1
-        return ((float)_idum) / m32Double;
+        return (float)( (unsigned long)_idum / m32Double );
     }
 }
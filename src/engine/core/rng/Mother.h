@@ -4,6 +4,10 @@
  * number generator producing uniformly distributed pseudo-random 32 bit values
  * with period about 2^250.
  * 
+ * Instances own their state and can be used concurrently from different
+ * threads. The static @srand()/@rand() interface works on a per-thread instance
+ * seeded by @ThreadGenerator.
+ * 
  * source: http://www.stat.berkeley.edu/classes/s243/mother.c visited on may 10, 2014.
  * 
  * Licensed under the MIT License (MIT)
@@ -15,6 +19,9 @@
 #ifndef MOTHER_H
 #define MOTHER_H
 
+#include "DataType.h"
+#include "ThreadGenerator.h"
+
 
 
 namespace nut
@@ -23,14 +30,28 @@ namespace nut
     {
         public:
 
+        /// Constructors ///
+
+        /**
+         * Instantiates a generator.
+         * 
+         * @param seed Generator seed (default value 0).
+         */
+        explicit Mother(long seed = 0)
+        {
+            this->seed(seed);
+        }
+
+
+
         /// Methods ///
 
         /**
-         * Initialize random number generator.
+         * Initialize this generator.
          * 
          * @param seed Generator seed.
          */
-        static void srand(long seed);
+        void seed(long seed);
 
         /**
          * Compute a uniformly distributed pseudo-random number.
@@ -38,7 +59,30 @@ namespace nut
          * @return A pseudo-random floating-point number uniformly distributed in
          * the range [0, 1].
          */
-        static float rand();
+        float next();
+
+        /**
+         * Initialize the calling thread's random number generator. The other
+         * threads reseed from this value on their next @rand().
+         * 
+         * @param seed Generator seed.
+         */
+        static void srand(long seed)
+        {
+            ThreadGenerator< Mother >::reseed(U64(seed)).seed(seed);
+        }
+
+        /**
+         * Compute a uniformly distributed pseudo-random number with the calling
+         * thread's generator.
+         * 
+         * @return A pseudo-random floating-point number uniformly distributed in
+         * the range [0, 1].
+         */
+        static float rand()
+        {
+            return ThreadGenerator< Mother >::get().next();
+        }
 
 
 
@@ -46,16 +90,27 @@ namespace nut
 
         /// Private attributes ///
 
-        static long _idum;
+        long _idum;
 
-        static short mother1[10];
-        static short mother2[10];
+        unsigned short mother1[10];
+        unsigned short mother2[10];
 
         static const long m16Long;     // 2^16
         static const long m16Mask;     // mask for lower 16 bits
         static const long m15Mask;     // mask for lower 15 bits
         static const long m31Mask;     // mask for 31 bits
         static const double m32Double; // 2^32-1
+
+
+
+        /// Private methods ///
+
+        friend class ThreadGenerator< Mother >;
+
+        void _seedThread(U64 seed)
+        {
+            this->seed(long(seed & m31Mask));
+        }
     };
 }
 
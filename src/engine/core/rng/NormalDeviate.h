@@ -1,9 +1,15 @@
 /** 
  * \file NormalDeviate.h
  * \brief This class generates normal (or gaussian) deviates (pseudo-random numbers
- * normally distributed) using Box-Muller method.
+ * normally distributed) using the ziggurat method.
  * 
- * source: Numerical Recipes in C, 2nd edition - chapter 7.2.
+ * Instances own their generator, so they can be used concurrently from different
+ * threads. The static @srand()/@rand() interface works on a per-thread instance
+ * seeded by @ThreadGenerator.
+ * To fill large arrays use @SIMDRandom::fillNormal() instead.
+ * 
+ * source: G. Marsaglia and W. W. Tsang, "The Ziggurat Method for Generating
+ * Random Variables", Journal of Statistical Software, vol. 5, 2000.
  * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
@@ -14,6 +20,9 @@
 #ifndef NORMALDEVIATE_H
 #define NORMALDEVIATE_H
 
+#include "ThreadGenerator.h"
+#include "XORShift.h"
+
 
 
 namespace nut
@@ -22,10 +31,46 @@ namespace nut
     {
         public:
 
+        /// Constructors ///
+
+        /**
+         * Instantiates a generator.
+         * 
+         * @param x Generator seed (default value 123456789).
+         * @param y Generator seed (default value 362436069).
+         * @param z Generator seed (default value 521288629).
+         * @param w Generator seed (default value 88675123).
+         */
+        NormalDeviate(U32 x = 123456789, U32 y = 362436069, U32 z = 521288629, U32 w = 88675123)
+            : _xorshift(x, y, z, w)
+        {
+        }
+
+
+
         /// Methods ///
 
         /**
-         * Initialize random number generator.
+         * Initialize this generator.
+         * 
+         * @param x, y, z, w Generator seeds (not all zero).
+         */
+        void seed(U32 x, U32 y, U32 z, U32 w)
+        {
+            _xorshift.seed(x, y, z, w);
+        }
+
+        /**
+         * Compute a normally distributed deviate with zero mean and unit variance.
+         * 
+         * @return A pseudo-random floating-point number normally distributed with
+         * zero mean and unit variance.
+         */
+        float next();
+
+        /**
+         * Initialize the calling thread's random number generator. The other
+         * threads reseed from these values on their next @rand().
          * 
          * @param x Generator seed (default value 123456789).
          * @param y Generator seed (default value 362436069).
@@ -34,19 +79,20 @@ namespace nut
          */
         static void srand(unsigned long x, unsigned long y, unsigned long z, unsigned long w)
         {
-            _x = x;
-            _y = y;
-            _z = z;
-            _w = w;
+            ThreadGenerator< NormalDeviate >::reseed(U32(x), U32(y), U32(z), U32(w)).seed(U32(x), U32(y), U32(z), U32(w));
         }
 
         /**
-         * Compute a normally distributed deviate with zero mean and unit variance.
+         * Compute a normally distributed deviate with zero mean and unit variance
+         * with the calling thread's generator.
          * 
          * @return A pseudo-random floating-point number normally distributed with
          * zero mean and unit variance.
          */
-        static float rand();
+        static float rand()
+        {
+            return ThreadGenerator< NormalDeviate >::get().next();
+        }
 
 
 
@@ -54,27 +100,17 @@ namespace nut
 
         /// Private attributes ///
 
-        static unsigned long _x, _y, _z, _w;
+        XORShift _xorshift;
 
 
 
         /// Private methods ///
 
-        /**
-         * Compute a uniformly distributed pseudo-random number.
-         * 
-         * @return A pseudo-random floating-point number uniformly distributed in
-         * the range [0, 1].
-         */
-        static float _xorshift()
-        {
-            unsigned long t;
-
-            t = (_x ^ (_x << 11));
+        friend class ThreadGenerator< NormalDeviate >;
 
-            _x = _y; _y = _z; _z = _w;
-
-            return _w = (_w ^ (_w >> 19)) ^ (t ^ (t >> 8));
+        void _seedThread(U64 seed)
+        {
+            _xorshift.seed(seed);
         }
     };
 }
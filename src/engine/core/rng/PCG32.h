@@ -0,0 +1,187 @@
+/** 
+ * \file PCG32.h
+ * \brief This class implements Melissa O'Neill's PCG32 (XSH-RR variant) generator
+ * producing uniformly distributed pseudo-random 32 bit values with a period of
+ * 2^64 per stream and 2^63 selectable streams.
+ * 
+ * Every instance owns its state. Parallel jobs either select a distinct stream
+ * through @seed(), or share one stream and skip ahead with @advance(), which
+ * runs in O(log n).
+ * 
+ * source: http://www.pcg-random.org/download.html (pcg-c-basic).
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef PCG32_H
+#define PCG32_H
+
+#include "DataType.h"
+
+
+
+namespace nut
+{
+    class PCG32
+    {
+        public:
+
+        typedef U32 result_type; /**< Allows using this class with <random> distributions. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Instantiates a generator.
+         * 
+         * @param initState Starting state (default value 0x853c49e6748fea9b).
+         * @param initSeq Stream selector; only the lower 63 bits are used
+         * (default value 0xda3e39cb94b95bdb).
+         */
+        explicit PCG32(U64 initState = 0x853C49E6748FEA9BULL, U64 initSeq = 0xDA3E39CB94B95BDBULL)
+        {
+            seed(initState, initSeq);
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Initialize random number generator.
+         * 
+         * @param initState Starting state.
+         * @param initSeq Stream selector. Generators with different @initSeq
+         * produce different sequences even with the same @initState.
+         */
+        void seed(U64 initState, U64 initSeq)
+        {
+            _state = 0;
+            _inc = (initSeq << 1) | 1;
+            next();
+            _state += initState;
+            next();
+        }
+
+        /**
+         * Compute a uniformly distributed pseudo-random 32 bit value.
+         * 
+         * @return A pseudo-random integer in the range [0, 2^32 - 1].
+         */
+        U32 next()
+        {
+            U64 oldState = _state;
+
+            _state = oldState * MULTIPLIER + _inc;
+
+            U32 xorShifted = U32(((oldState >> 18) ^ oldState) >> 27);
+            U32 rot = U32(oldState >> 59);
+
+            return (xorShifted >> rot) | (xorShifted << ((~rot + 1) & 31));
+        }
+
+        /**
+         * Compute an unbiased pseudo-random integer in [0, @bound).
+         * 
+         * @param bound Upper bound (exclusive). Must be greater than zero.
+         * @return A pseudo-random integer in the range [0, @bound - 1].
+         */
+        U32 nextBounded(U32 bound)
+        {
+            // Reject the values that would make the modulo biased
+            U32 threshold = (~bound + 1) % bound;
+
+            for (;;)
+            {
+                U32 r = next();
+
+                if (r >= threshold)
+                {
+                    return r % bound;
+                }
+            }
+        }
+
+        /**
+         * Compute a uniformly distributed pseudo-random number.
+         * 
+         * @return A pseudo-random floating-point number uniformly distributed in
+         * the range [0, 1).
+         */
+        float nextFloat()
+        {
+            return float(next() >> 8) * (1.0f / 16777216.0f);
+        }
+
+        /**
+         * Advance the generator by @delta steps in O(log @delta) time.
+         * 
+         * source: F. Brown, "Random Number Generation with Arbitrary Stride",
+         * Transactions of the American Nuclear Society, 1994.
+         * 
+         * @param delta Number of steps to skip. Since the arithmetic is modulo
+         * 2^64, passing (2^64 - n) moves the generator n steps backwards.
+         */
+        void advance(U64 delta)
+        {
+            U64 curMult = MULTIPLIER;
+            U64 curPlus = _inc;
+            U64 accMult = 1;
+            U64 accPlus = 0;
+
+            while (delta > 0)
+            {
+                if (delta & 1)
+                {
+                    accMult *= curMult;
+                    accPlus = accPlus * curMult + curPlus;
+                }
+
+                curPlus = (curMult + 1) * curPlus;
+                curMult *= curMult;
+                delta >>= 1;
+            }
+
+            _state = accMult * _state + accPlus;
+        }
+
+
+
+        /// Operators ///
+
+        /**
+         * Same as @next(). Allows using this class with <random> distributions.
+         */
+        U32 operator () ()
+        {
+            return next();
+        }
+
+        static constexpr result_type min()
+        {
+            return 0;
+        }
+
+        static constexpr result_type max()
+        {
+            return ~result_type(0);
+        }
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        static const U64 MULTIPLIER = 6364136223846793005ULL;
+
+        U64 _state; /**< RNG state. All values are possible. */
+        U64 _inc;   /**< Controls which RNG sequence (stream) is selected. Must always be odd. */
+    };
+}
+
+#endif // PCG32_H
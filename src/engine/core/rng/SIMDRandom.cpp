@@ -0,0 +1,293 @@
+/** 
+ * \file SIMDRandom.cpp
+ * \brief This class fills arrays with uniform, normal and exponential deviates
+ * using @SIMDInt::WIDTH interleaved xoshiro128** generators, one per SIMD lane.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <cstring>
+#include "SIMDRandom.h"
+#include "SplitMix64.h"
+#include "Ziggurat.h"
+
+
+
+namespace nut
+{
+    /**
+     * \brief Working copy of the lane states held in registers while filling.
+     */
+    struct SIMDRandomLanes
+    {
+        SIMDInt s0, s1, s2, s3;
+
+        SIMDRandomLanes(const I32 s[4][SIMDInt::WIDTH])
+        {
+            s0 = SIMDInt::loadu(s[0]);
+            s1 = SIMDInt::loadu(s[1]);
+            s2 = SIMDInt::loadu(s[2]);
+            s3 = SIMDInt::loadu(s[3]);
+        }
+
+        void store(I32 s[4][SIMDInt::WIDTH]) const
+        {
+            s0.storeu(s[0]);
+            s1.storeu(s[1]);
+            s2.storeu(s[2]);
+            s3.storeu(s[3]);
+        }
+
+        /**
+         * One xoshiro128** step in every lane. Multiplications by 5 and 9 are
+         * done with shifts, so SSE2 is enough.
+         */
+        SIMDInt next()
+        {
+            SIMDInt r = s1 + (s1 << 2);
+            r = (r << 7) | (r >> 25);
+            r = r + (r << 3);
+
+            SIMDInt t = s1 << 9;
+
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+
+            s2 ^= t;
+
+            s3 = (s3 << 11) | (s3 >> 21);
+
+            return r;
+        }
+    };
+
+
+
+    /**
+     * Scalar xoshiro128** step, used to jump a single lane.
+     */
+    static void xoshiro128Step(U32 s[4])
+    {
+        const U32 t = s[1] << 9;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+
+        s[2] ^= t;
+
+        s[3] = (s[3] << 11) | (s[3] >> 21);
+    }
+
+    /**
+     * Advance a single xoshiro128** state by 2^64 steps.
+     */
+    static void xoshiro128Jump(U32 s[4])
+    {
+        static const U32 JUMP[] = { 0x8764000B, 0xF542D2D3, 0x6FA035C3, 0x77F2DB5B };
+
+        U32 r[4] = { 0, 0, 0, 0 };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int b = 0; b < 32; ++b)
+            {
+                if (JUMP[i] & (U32(1) << b))
+                {
+                    r[0] ^= s[0];
+                    r[1] ^= s[1];
+                    r[2] ^= s[2];
+                    r[3] ^= s[3];
+                }
+
+                xoshiro128Step(s);
+            }
+        }
+
+        memcpy(s, r, sizeof(r));
+    }
+
+
+
+    void SIMDRandom::seed(U64 seed)
+    {
+        SplitMix64 sm(seed);
+        U64 a = sm.next();
+        U64 b = sm.next();
+
+        U32 lane[4] = { U32(a), U32(a >> 32), U32(b), U32(b >> 32) };
+
+        for (int i = 0; i < LANES; ++i)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                _s[k][i] = I32(lane[k]);
+            }
+
+            xoshiro128Jump(lane);
+        }
+
+        _fallback.seed(sm.next());
+    }
+
+
+
+    void SIMDRandom::jump()
+    {
+        for (int i = 0; i < LANES; ++i)
+        {
+            U32 lane[4] = { U32(_s[0][i]), U32(_s[1][i]), U32(_s[2][i]), U32(_s[3][i]) };
+
+            for (int j = 0; j < LANES; ++j)
+            {
+                xoshiro128Jump(lane);
+            }
+
+            for (int k = 0; k < 4; ++k)
+            {
+                _s[k][i] = I32(lane[k]);
+            }
+        }
+
+        _fallback.jump();
+    }
+
+
+
+    template<class Function> void SIMDRandom::_fill(float* out, size_t n, Function fn)
+    {
+        SIMDRandomLanes lanes(_s);
+        size_t i = 0;
+
+        for (; i + LANES <= n; i += LANES)
+        {
+            fn(lanes, out + i);
+        }
+
+        if (i < n)
+        {
+            float tmp[LANES];
+            fn(lanes, tmp);
+            memcpy(out + i, tmp, (n - i) * sizeof(float));
+        }
+
+        lanes.store(_s);
+    }
+
+
+
+    void SIMDRandom::fillBits(U32* out, size_t n)
+    {
+        SIMDRandomLanes lanes(_s);
+        size_t i = 0;
+
+        for (; i + LANES <= n; i += LANES)
+        {
+            lanes.next().storeu(reinterpret_cast<I32*>(out + i));
+        }
+
+        if (i < n)
+        {
+            I32 tmp[LANES];
+            lanes.next().storeu(tmp);
+            memcpy(out + i, tmp, (n - i) * sizeof(U32));
+        }
+
+        lanes.store(_s);
+    }
+
+
+
+    void SIMDRandom::fillUniform(float* out, size_t n, float min, float max)
+    {
+        // The upper 24 bits fill the float mantissa exactly
+        const SIMDFloat scale((max - min) * (1.0f / 16777216.0f));
+        const SIMDFloat offset(min);
+
+        _fill(out, n, [&](SIMDRandomLanes& lanes, float* dst)
+        {
+            SIMDFloat u = SIMDFloat::fromInt(lanes.next() >> 8);
+            SIMDFloat::fmadd(u, scale, offset).storeu(dst);
+        });
+    }
+
+
+
+    void SIMDRandom::fillNormal(float* out, size_t n, float mean, float stddev)
+    {
+        const Ziggurat::Tables& t = Ziggurat::getTables();
+        const SIMDFloat vMean(mean);
+        const SIMDFloat vStddev(stddev);
+        const int allLanes = (1 << LANES) - 1;
+
+        _fill(out, n, [&](SIMDRandomLanes& lanes, float* dst)
+        {
+            SIMDInt hz = lanes.next();
+            SIMDInt iz = hz & SIMDInt(127);
+
+            // |hz| without overflow (see Ziggurat::_abs)
+            SIMDInt absHz = hz ^ SIMDInt::sra(hz, 31);
+            SIMDInt accept = absHz < SIMDInt::gather(t.kn, iz);
+
+            SIMDFloat x = SIMDFloat::fromInt(hz) * SIMDFloat::gather(t.wn, iz);
+            SIMDFloat::fmadd(x, vStddev, vMean).storeu(dst);
+
+            int mask = SIMDInt::movemask(accept);
+
+            if (mask != allLanes)
+            {
+                for (int k = 0; k < LANES; ++k)
+                {
+                    if (!(mask & (1 << k)))
+                    {
+                        dst[k] = mean + stddev * Ziggurat::normalFix(_fallback, hz.lane(k), iz.lane(k));
+                    }
+                }
+            }
+        });
+    }
+
+
+
+    void SIMDRandom::fillExponential(float* out, size_t n, float lambda)
+    {
+        const Ziggurat::Tables& t = Ziggurat::getTables();
+        const I32* ke = reinterpret_cast<const I32*>(t.ke);
+        const SIMDInt signBit(I32(0x80000000u));
+        const float rLambda = 1.0f / lambda;
+        const SIMDFloat scale(2.0f * rLambda);
+        const int allLanes = (1 << LANES) - 1;
+
+        _fill(out, n, [&](SIMDRandomLanes& lanes, float* dst)
+        {
+            SIMDInt jz = lanes.next();
+            SIMDInt iz = jz & SIMDInt(255);
+
+            // Unsigned jz < ke[iz], done as a signed comparison with flipped sign bits
+            SIMDInt accept = (jz ^ signBit) < (SIMDInt::gather(ke, iz) ^ signBit);
+
+            // jz is unsigned, so convert jz / 2 and scale back
+            SIMDFloat x = SIMDFloat::fromInt(jz >> 1) * SIMDFloat::gather(t.we, iz);
+            (x * scale).storeu(dst);
+
+            int mask = SIMDInt::movemask(accept);
+
+            if (mask != allLanes)
+            {
+                for (int k = 0; k < LANES; ++k)
+                {
+                    if (!(mask & (1 << k)))
+                    {
+                        dst[k] = rLambda * Ziggurat::exponentialFix(_fallback, U32(jz.lane(k)), iz.lane(k));
+                    }
+                }
+            }
+        });
+    }
+}
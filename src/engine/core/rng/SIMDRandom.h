@@ -0,0 +1,142 @@
+/** 
+ * \file SIMDRandom.h
+ * \brief This class fills arrays with uniform, normal and exponential deviates
+ * using @SIMDInt::WIDTH interleaved xoshiro128** generators, one per SIMD lane.
+ * 
+ * Normal and exponential deviates are produced with the ziggurat method: the
+ * fast path (about 99% of the values) runs entirely in SIMD registers and the
+ * few rejected lanes are completed by the scalar slow path of @Ziggurat.
+ * 
+ * Instances own their state, so each thread (or job) should use its own
+ * generator. Non-overlapping streams are obtained by copying a generator and
+ * calling @jump() on the copy.
+ * 
+ * source: http://prng.di.unimi.it/xoshiro128starstar.c
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef SIMDRANDOM_H
+#define SIMDRANDOM_H
+
+#include <cstddef>
+#include "DataType.h"
+#include "SIMD.h"
+#include "Xoshiro256.h"
+
+
+
+namespace nut
+{
+    class SIMDRandom
+    {
+        public:
+
+        static const int LANES = SIMDInt::WIDTH; /**< Number of interleaved generators. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Instantiates a generator.
+         * 
+         * @param seed Generator seed (default value 88675123).
+         */
+        explicit SIMDRandom(U64 seed = 88675123)
+        {
+            this->seed(seed);
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Initialize the generator. The first lane is seeded by SplitMix64 and
+         * every following lane starts 2^64 steps ahead of the previous one.
+         * 
+         * @param seed Generator seed.
+         */
+        void seed(U64 seed);
+
+        /**
+         * Advance every lane by @LANES * 2^64 steps, past the starting points of
+         * all lanes of the original generator. A copy of a generator followed
+         * by @jump() produces a stream that never overlaps the original one.
+         */
+        void jump();
+
+        /**
+         * Fill an array with uniformly distributed 32 bit values.
+         * 
+         * @param out Output array.
+         * @param n Number of values.
+         */
+        void fillBits(U32* out, size_t n);
+
+        /**
+         * Fill an array with uniformly distributed numbers in [0, 1).
+         * 
+         * @param out Output array.
+         * @param n Number of values.
+         */
+        void fillUniform(float* out, size_t n)
+        {
+            fillUniform(out, n, 0.0f, 1.0f);
+        }
+
+        /**
+         * Fill an array with uniformly distributed numbers in [@min, @max).
+         * 
+         * @param out Output array.
+         * @param n Number of values.
+         * @param min Lower bound.
+         * @param max Upper bound.
+         */
+        void fillUniform(float* out, size_t n, float min, float max);
+
+        /**
+         * Fill an array with normally distributed numbers.
+         * 
+         * @param out Output array.
+         * @param n Number of values.
+         * @param mean Mean (default value 0).
+         * @param stddev Standard deviation (default value 1).
+         */
+        void fillNormal(float* out, size_t n, float mean = 0.0f, float stddev = 1.0f);
+
+        /**
+         * Fill an array with exponentially distributed numbers.
+         * 
+         * @param out Output array.
+         * @param n Number of values.
+         * @param lambda Rate parameter; the mean is 1 / @lambda (default value 1).
+         */
+        void fillExponential(float* out, size_t n, float lambda = 1.0f);
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        I32 _s[4][LANES];     /**< xoshiro128** state, one column per lane. */
+        Xoshiro256 _fallback; /**< Feeds the ziggurat slow paths. */
+
+
+
+        /// Private methods ///
+
+        /**
+         * Run @fn once per @LANES values, storing its result in @out. The last
+         * partial vector goes through a temporary buffer.
+         */
+        template<class Function> void _fill(float* out, size_t n, Function fn);
+    };
+}
+
+#endif // SIMDRANDOM_H
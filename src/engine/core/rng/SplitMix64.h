@@ -0,0 +1,78 @@
+/** 
+ * \file SplitMix64.h
+ * \brief This class implements Sebastiano Vigna's SplitMix64 generator. It is
+ * mainly used to expand a single 64 bit seed into the state of larger generators
+ * such as @Xoshiro256.
+ * 
+ * source: http://prng.di.unimi.it/splitmix64.c
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef SPLITMIX64_H
+#define SPLITMIX64_H
+
+#include "DataType.h"
+
+
+
+namespace nut
+{
+    class SplitMix64
+    {
+        public:
+
+        /// Constructors ///
+
+        /**
+         * Instantiates a generator.
+         * 
+         * @param seed Generator seed. Any value is valid, including zero.
+         */
+        explicit SplitMix64(U64 seed = 0) : _state(seed)
+        {
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Initialize random number generator.
+         * 
+         * @param seed Generator seed.
+         */
+        void seed(U64 seed)
+        {
+            _state = seed;
+        }
+
+        /**
+         * Compute a uniformly distributed pseudo-random 64 bit value.
+         * 
+         * @return A pseudo-random integer in the range [0, 2^64 - 1].
+         */
+        U64 next()
+        {
+            U64 z = (_state += 0x9E3779B97F4A7C15ULL);
+
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+            return z ^ (z >> 31);
+        }
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        U64 _state;
+    };
+}
+
+#endif // SPLITMIX64_H
@@ -0,0 +1,155 @@
+/**
+ * \file ThreadGenerator.h
+ * \brief This class keeps the per-thread generators used by the static
+ * srand()/rand() interface of @XORShift, @NormalDeviate, @ExpDeviate and
+ * @Mother.
+ *
+ * Each thread gets an index from a global counter the first time it uses the
+ * generator, and its seed is derived by SplitMix64 from a base seed shared by
+ * all threads and that index, so different threads produce different
+ * sequences. The first thread keeps the generator's default seeds until
+ * srand() is called. Calling srand() on any thread changes the base seed: the
+ * calling thread is seeded with the exact values passed to srand() and every
+ * other thread reseeds from the new base seed on its next rand().
+ *
+ * The generator class must declare this class a friend and implement a
+ * private _seedThread(U64 seed) method.
+ *
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ *
+ * @author: Eder A. Perez.
+ */
+
+#ifndef THREADGENERATOR_H
+#define THREADGENERATOR_H
+
+#include <atomic>
+#include "DataType.h"
+#include "SplitMix64.h"
+
+
+
+namespace nut
+{
+    template <class Generator>
+    class ThreadGenerator
+    {
+        public:
+
+        /// Methods ///
+
+        /**
+         * Get the calling thread's generator, reseeding it first if srand() was
+         * called on another thread since it was last used.
+         */
+        static Generator& get()
+        {
+            Slot& slot = _slot();
+            U32 generation = _generation().load(std::memory_order_acquire);
+
+            if (slot.generation != generation)
+            {
+                slot.reseed(generation);
+            }
+
+            return slot.generator;
+        }
+
+        /**
+         * Set the base seed shared by all threads.
+         *
+         * @param base Base seed.
+         * @return The calling thread's generator, which the caller seeds itself.
+         */
+        static Generator& reseed(U64 base)
+        {
+            Slot& slot = _slot();
+
+            _base().store(base, std::memory_order_relaxed);
+            slot.generation = _generation().fetch_add(1, std::memory_order_release) + 1;
+
+            return slot.generator;
+        }
+
+        /**
+         * Same as above, for generators seeded with four 32 bit values.
+         */
+        static Generator& reseed(U32 x, U32 y, U32 z, U32 w)
+        {
+            SplitMix64 sm((U64(x) << 32) | y);
+            return reseed(sm.next() ^ ((U64(z) << 32) | w));
+        }
+
+
+
+        private:
+
+        /// Private types ///
+
+        struct Slot
+        {
+            Slot() : thread(_threads().fetch_add(1, std::memory_order_relaxed))
+            {
+                U32 current = _generation().load(std::memory_order_acquire);
+
+                // The first thread starts from the default seeds
+                if (thread == 0 && current == 0)
+                {
+                    generation = 0;
+                }
+                else
+                {
+                    reseed(current);
+                }
+            }
+
+            void reseed(U32 current)
+            {
+                SplitMix64 sm(_base().load(std::memory_order_relaxed) ^ (U64(thread) * 0xD1B54A32D192ED03ULL));
+
+                generation = current;
+                _seed(generator, sm.next());
+            }
+
+            Generator generator;
+            U32 thread;     // Index of the owning thread
+            U32 generation; // Base seed generation the generator was seeded from
+        };
+
+
+
+        /// Private methods ///
+
+        static void _seed(Generator& generator, U64 seed)
+        {
+            generator._seedThread(seed);
+        }
+
+        static Slot& _slot()
+        {
+            static thread_local Slot slot;
+            return slot;
+        }
+
+        static std::atomic<U64>& _base()
+        {
+            static std::atomic<U64> base(0);
+            return base;
+        }
+
+        static std::atomic<U32>& _generation()
+        {
+            static std::atomic<U32> generation(0);
+            return generation;
+        }
+
+        static std::atomic<U32>& _threads()
+        {
+            static std::atomic<U32> threads(0);
+            return threads;
+        }
+    };
+}
+
+#endif // THREADGENERATOR_H
@@ -4,6 +4,12 @@
  * generator producing uniformly distributed pseudo-random with a period of
  * (2^128) - 1.
  * 
+ * The generator can be used either as an instance, which owns its state and is
+ * safe to use from one thread without locking, or through the static
+ * @srand()/@rand() interface. The static interface operates on a per-thread
+ * generator seeded by @ThreadGenerator, so each thread produces its own
+ * sequence.
+ * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
  * 
@@ -13,6 +19,10 @@
 #ifndef XORSHIFT_H
 #define XORSHIFT_H
 
+#include "DataType.h"
+#include "SplitMix64.h"
+#include "ThreadGenerator.h"
+
 
 
 namespace nut
@@ -21,17 +31,31 @@ namespace nut
     {
         public:
 
-        /// Methods ///
+        /// Constructors ///
 
         /**
-         * Initialize random number generator.
+         * Instantiates a generator.
          * 
          * @param x Generator seed (default value 123456789).
          * @param y Generator seed (default value 362436069).
          * @param z Generator seed (default value 521288629).
          * @param w Generator seed (default value 88675123).
          */
-        static void srand(unsigned long x, unsigned long y, unsigned long z, unsigned long w)
+        XORShift(U32 x = 123456789, U32 y = 362436069, U32 z = 521288629, U32 w = 88675123)
+            : _x(x), _y(y), _z(z), _w(w)
+        {
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Initialize this generator.
+         * 
+         * @param x, y, z, w Generator seeds (not all zero).
+         */
+        void seed(U32 x, U32 y, U32 z, U32 w)
         {
             _x = x;
             _y = y;
@@ -40,37 +64,95 @@ namespace nut
         }
 
         /**
-         * Compute a uniformly distributed pseudo-random number.
+         * Initialize this generator with state expanded from @seed by SplitMix64.
          * 
-         * @return A pseudo-random floating-point number uniformly distributed in
-         * the range [0, 1].
+         * @param seed Generator seed.
          */
-        static unsigned long rand()
+        void seed(U64 seed)
         {
-            unsigned long t;
+            SplitMix64 sm(seed);
+            U64 a = sm.next(), b = sm.next();
+
+            _x = U32(a);
+            _y = U32(a >> 32);
+            _z = U32(b);
+            _w = U32(b >> 32);
+
+            if ((_x | _y | _z | _w) == 0)
+            {
+                _w = 88675123;
+            }
+        }
 
-            t = (_x ^ (_x << 11));
+        /**
+         * Compute a uniformly distributed pseudo-random 32 bit value.
+         * 
+         * @return A pseudo-random integer in the range [0, 2^32 - 1].
+         */
+        U32 next()
+        {
+            U32 t = _x ^ (_x << 11);
 
             _x = _y; _y = _z; _z = _w;
 
             return _w = (_w ^ (_w >> 19)) ^ (t ^ (t >> 8));
         }
 
+        /**
+         * Compute a uniformly distributed pseudo-random number.
+         * 
+         * @return A pseudo-random floating-point number uniformly distributed in
+         * the range [0, 1].
+         */
+        float nextFloat()
+        {
+            return float(next() * (1.0 / 4294967295.0));
+        }
+
+        /**
+         * Initialize the calling thread's random number generator. The other
+         * threads reseed from these values on their next @rand().
+         * 
+         * @param x Generator seed (default value 123456789).
+         * @param y Generator seed (default value 362436069).
+         * @param z Generator seed (default value 521288629).
+         * @param w Generator seed (default value 88675123).
+         */
+        static void srand(unsigned long x, unsigned long y, unsigned long z, unsigned long w)
+        {
+            ThreadGenerator< XORShift >::reseed(U32(x), U32(y), U32(z), U32(w)).seed(U32(x), U32(y), U32(z), U32(w));
+        }
+
+        /**
+         * Compute a uniformly distributed pseudo-random number with the calling
+         * thread's generator.
+         * 
+         * @return A pseudo-random integer in the range [0, 2^32 - 1].
+         */
+        static unsigned long rand()
+        {
+            return ThreadGenerator< XORShift >::get().next();
+        }
+
 
 
         private:
 
         /// Private attributes ///
 
-        static unsigned long _x, _y, _z, _w;
-    };
+        U32 _x, _y, _z, _w;
+
+
+
+        /// Private methods ///
 
-    // Initialize private attributes
+        friend class ThreadGenerator< XORShift >;
 
-    unsigned long XORShift::_x = 123456789;
-    unsigned long XORShift::_y = 362436069;
-    unsigned long XORShift::_z = 521288629;
-    unsigned long XORShift::_w = 88675123;
+        void _seedThread(U64 seed)
+        {
+            this->seed(seed);
+        }
+    };
 }
 
 #endif // XORSHIFT_H
@@ -0,0 +1,231 @@
+/** 
+ * \file Xoshiro256.h
+ * \brief This class implements David Blackman and Sebastiano Vigna's xoshiro256**
+ * generator producing uniformly distributed pseudo-random 64 bit values with a
+ * period of (2^256) - 1.
+ * 
+ * Unlike @XORShift, every instance owns its state, so a generator per thread (or
+ * per job) can be used without any locking. Non-overlapping streams are obtained
+ * by copying a generator and calling @jump() (2^128 steps) or @longJump()
+ * (2^192 steps) on the copy:
+ * 
+ *     Xoshiro256 streams[N];
+ *     streams[0].seed(seed);
+ *     for (int i = 1; i < N; ++i)
+ *     {
+ *         streams[i] = streams[i - 1];
+ *         streams[i].jump();
+ *     }
+ * 
+ * source: http://prng.di.unimi.it/xoshiro256starstar.c
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef XOSHIRO256_H
+#define XOSHIRO256_H
+
+#include "DataType.h"
+#include "SplitMix64.h"
+
+
+
+namespace nut
+{
+    class Xoshiro256
+    {
+        public:
+
+        typedef U64 result_type; /**< Allows using this class with <random> distributions. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Instantiates a generator whose state is expanded from @seed by SplitMix64.
+         * 
+         * @param seed Generator seed (default value 88675123).
+         */
+        explicit Xoshiro256(U64 seed = 88675123)
+        {
+            this->seed(seed);
+        }
+
+
+
+        /// Methods ///
+
+        /**
+         * Initialize random number generator. The 256 bit state is filled with
+         * SplitMix64 outputs, so it is never all zeros.
+         * 
+         * @param seed Generator seed.
+         */
+        void seed(U64 seed)
+        {
+            SplitMix64 sm(seed);
+
+            _s[0] = sm.next();
+            _s[1] = sm.next();
+            _s[2] = sm.next();
+            _s[3] = sm.next();
+        }
+
+        /**
+         * Set the full generator state.
+         * 
+         * WARNING: The state must not be all zeros.
+         * 
+         * @param s Four 64 bit words.
+         */
+        void setState(const U64 s[4])
+        {
+            _s[0] = s[0];
+            _s[1] = s[1];
+            _s[2] = s[2];
+            _s[3] = s[3];
+        }
+
+        /**
+         * Compute a uniformly distributed pseudo-random 64 bit value.
+         * 
+         * @return A pseudo-random integer in the range [0, 2^64 - 1].
+         */
+        U64 next()
+        {
+            const U64 result = _rotateLeft(_s[1] * 5, 7) * 9;
+            const U64 t = _s[1] << 17;
+
+            _s[2] ^= _s[0];
+            _s[3] ^= _s[1];
+            _s[1] ^= _s[2];
+            _s[0] ^= _s[3];
+
+            _s[2] ^= t;
+
+            _s[3] = _rotateLeft(_s[3], 45);
+
+            return result;
+        }
+
+        /**
+         * Compute a uniformly distributed pseudo-random number.
+         * 
+         * @return A pseudo-random floating-point number uniformly distributed in
+         * the range [0, 1).
+         */
+        float nextFloat()
+        {
+            // Upper 24 bits fill the float mantissa exactly
+            return float(next() >> 40) * (1.0f / 16777216.0f);
+        }
+
+        /**
+         * Compute a uniformly distributed pseudo-random number.
+         * 
+         * @return A pseudo-random double precision number uniformly distributed in
+         * the range [0, 1).
+         */
+        double nextDouble()
+        {
+            return double(next() >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        /**
+         * Advance the generator by 2^128 steps. It is equivalent to 2^128 calls
+         * to @next() and can be used to generate 2^128 non-overlapping
+         * subsequences for parallel computations.
+         */
+        void jump()
+        {
+            static const U64 JUMP[] = { 0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+                                        0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+
+            _jump(JUMP);
+        }
+
+        /**
+         * Advance the generator by 2^192 steps. It can be used to generate 2^64
+         * starting points, from each of which @jump() generates 2^64
+         * non-overlapping subsequences.
+         */
+        void longJump()
+        {
+            static const U64 LONG_JUMP[] = { 0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL,
+                                             0x77710069854EE241ULL, 0x39109BB02ACBE635ULL };
+
+            _jump(LONG_JUMP);
+        }
+
+
+
+        /// Operators ///
+
+        /**
+         * Same as @next(). Allows using this class with <random> distributions.
+         */
+        U64 operator () ()
+        {
+            return next();
+        }
+
+        static constexpr result_type min()
+        {
+            return 0;
+        }
+
+        static constexpr result_type max()
+        {
+            return ~result_type(0);
+        }
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        U64 _s[4];
+
+
+
+        /// Private methods ///
+
+        static U64 _rotateLeft(const U64 x, int k)
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        void _jump(const U64 polynomial[4])
+        {
+            U64 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+            for (int i = 0; i < 4; ++i)
+            {
+                for (int b = 0; b < 64; ++b)
+                {
+                    if (polynomial[i] & (U64(1) << b))
+                    {
+                        s0 ^= _s[0];
+                        s1 ^= _s[1];
+                        s2 ^= _s[2];
+                        s3 ^= _s[3];
+                    }
+
+                    next();
+                }
+            }
+
+            _s[0] = s0;
+            _s[1] = s1;
+            _s[2] = s2;
+            _s[3] = s3;
+        }
+    };
+}
+
+#endif // XOSHIRO256_H
@@ -0,0 +1,88 @@
+/** 
+ * \file Ziggurat.cpp
+ * \brief George Marsaglia and Wai Wan Tsang's ziggurat method for normal and
+ * exponential deviates.
+ * 
+ * source: G. Marsaglia and W. W. Tsang, "The Ziggurat Method for Generating
+ * Random Variables", Journal of Statistical Software, vol. 5, 2000.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <cmath>
+#include "Ziggurat.h"
+
+
+
+namespace nut
+{
+    const float Ziggurat::NORMAL_R = 3.442620f;
+    const float Ziggurat::EXPONENTIAL_R = 7.69711f;
+
+
+
+    /**
+     * Build the tables (zigset() in the original paper).
+     */
+    static Ziggurat::Tables buildTables()
+    {
+        Ziggurat::Tables t;
+
+        const double m1 = 2147483648.0, m2 = 4294967296.0;
+        double dn = 3.442619855899, tn = dn, vn = 9.91256303526217e-3, q;
+        double de = 7.697117470131487, te = de, ve = 3.949659822581572e-3;
+
+        // Normal layers
+        q = vn / std::exp(-0.5 * dn * dn);
+        t.kn[0] = I32((dn / q) * m1);
+        t.kn[1] = 0;
+
+        t.wn[0] = float(q / m1);
+        t.wn[127] = float(dn / m1);
+
+        t.fn[0] = 1.0f;
+        t.fn[127] = float(std::exp(-0.5 * dn * dn));
+
+        for (int i = 126; i >= 1; --i)
+        {
+            dn = std::sqrt(-2.0 * std::log(vn / dn + std::exp(-0.5 * dn * dn)));
+            t.kn[i + 1] = I32((dn / tn) * m1);
+            tn = dn;
+            t.fn[i] = float(std::exp(-0.5 * dn * dn));
+            t.wn[i] = float(dn / m1);
+        }
+
+        // Exponential layers
+        q = ve / std::exp(-de);
+        t.ke[0] = U32((de / q) * m2);
+        t.ke[1] = 0;
+
+        t.we[0] = float(q / m2);
+        t.we[255] = float(de / m2);
+
+        t.fe[0] = 1.0f;
+        t.fe[255] = float(std::exp(-de));
+
+        for (int i = 254; i >= 1; --i)
+        {
+            de = -std::log(ve / de + std::exp(-de));
+            t.ke[i + 1] = U32((de / te) * m2);
+            te = de;
+            t.fe[i] = float(std::exp(-de));
+            t.we[i] = float(de / m2);
+        }
+
+        return t;
+    }
+
+
+
+    const Ziggurat::Tables& Ziggurat::getTables()
+    {
+        static const Tables tables = buildTables();
+        return tables;
+    }
+}
@@ -0,0 +1,204 @@
+/** 
+ * \file Ziggurat.h
+ * \brief George Marsaglia and Wai Wan Tsang's ziggurat method for normal and
+ * exponential deviates. About 99% of the deviates cost one table lookup, one
+ * comparison and one multiplication; the remaining ones fall back to the exact
+ * (but slower) tail and wedge computations.
+ * 
+ * The generators are templates over any engine whose next() returns at least
+ * 32 random bits (@XORShift, @PCG32, @Xoshiro256...), so the same tables serve
+ * the scalar deviates and the vectorized @SIMDRandom.
+ * 
+ * source: G. Marsaglia and W. W. Tsang, "The Ziggurat Method for Generating
+ * Random Variables", Journal of Statistical Software, vol. 5, 2000.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef ZIGGURAT_H
+#define ZIGGURAT_H
+
+#include <cmath>
+#include "DataType.h"
+
+
+
+namespace nut
+{
+    class Ziggurat
+    {
+        public:
+
+        /**
+         * \brief Precomputed layers of both ziggurats.
+         */
+        struct Tables
+        {
+            I32 kn[128];   /**< Normal: acceptance thresholds for |hz|. */
+            float wn[128]; /**< Normal: layer widths scaled by 2^-31. */
+            float fn[128]; /**< Normal: density at the layer edges. */
+
+            U32 ke[256];   /**< Exponential: acceptance thresholds for jz. */
+            float we[256]; /**< Exponential: layer widths scaled by 2^-32. */
+            float fe[256]; /**< Exponential: density at the layer edges. */
+        };
+
+        static const float NORMAL_R;      /**< Start of the right tail of the normal ziggurat. */
+        static const float EXPONENTIAL_R; /**< Start of the tail of the exponential ziggurat. */
+
+
+
+        /// Methods ///
+
+        /**
+         * Get the ziggurat tables. They are built on first use (thread-safe).
+         * 
+         * @return Ziggurat tables.
+         */
+        static const Tables& getTables();
+
+        /**
+         * Compute a normally distributed deviate with zero mean and unit variance.
+         * 
+         * @param engine Uniform random engine.
+         * @return A normal deviate.
+         */
+        template<class Engine> static float normal(Engine& engine)
+        {
+            const Tables& t = getTables();
+            I32 hz = I32(U32(engine.next()));
+            int iz = hz & 127;
+
+            if (_abs(hz) < t.kn[iz])
+            {
+                return hz * t.wn[iz];
+            }
+
+            return normalFix(engine, hz, iz);
+        }
+
+        /**
+         * Compute an exponentially distributed, positive, random deviate of unit mean.
+         * 
+         * @param engine Uniform random engine.
+         * @return An exponential deviate.
+         */
+        template<class Engine> static float exponential(Engine& engine)
+        {
+            const Tables& t = getTables();
+            U32 jz = U32(engine.next());
+            int iz = jz & 255;
+
+            if (jz < t.ke[iz])
+            {
+                return jz * t.we[iz];
+            }
+
+            return exponentialFix(engine, jz, iz);
+        }
+
+        /**
+         * Slow path of @normal() for a rejected first attempt (@hz, @iz). It
+         * samples the tail or the wedge of layer @iz, retrying from scratch
+         * when needed.
+         */
+        template<class Engine> static float normalFix(Engine& engine, I32 hz, int iz)
+        {
+            const Tables& t = getTables();
+
+            for (;;)
+            {
+                float x = hz * t.wn[iz];
+
+                // iz == 0 handles the base strip
+                if (iz == 0)
+                {
+                    float y;
+
+                    do
+                    {
+                        x = -std::log(_uniform(engine)) * (1.0f / NORMAL_R);
+                        y = -std::log(_uniform(engine));
+                    } while (y + y < x * x);
+
+                    return hz > 0 ? NORMAL_R + x : -NORMAL_R - x;
+                }
+
+                // iz > 0, handle the wedges of other strips
+                if (t.fn[iz] + _uniform(engine) * (t.fn[iz - 1] - t.fn[iz]) < std::exp(-0.5f * x * x))
+                {
+                    return x;
+                }
+
+                // Try to exit the loop with a fresh deviate
+                hz = I32(U32(engine.next()));
+                iz = hz & 127;
+
+                if (_abs(hz) < t.kn[iz])
+                {
+                    return hz * t.wn[iz];
+                }
+            }
+        }
+
+        /**
+         * Slow path of @exponential() for a rejected first attempt (@jz, @iz).
+         */
+        template<class Engine> static float exponentialFix(Engine& engine, U32 jz, int iz)
+        {
+            const Tables& t = getTables();
+
+            for (;;)
+            {
+                if (iz == 0)
+                {
+                    return EXPONENTIAL_R - std::log(_uniform(engine));
+                }
+
+                float x = jz * t.we[iz];
+
+                if (t.fe[iz] + _uniform(engine) * (t.fe[iz - 1] - t.fe[iz]) < std::exp(-x))
+                {
+                    return x;
+                }
+
+                // Try to exit the loop with a fresh deviate
+                jz = U32(engine.next());
+                iz = jz & 255;
+
+                if (jz < t.ke[iz])
+                {
+                    return jz * t.we[iz];
+                }
+            }
+        }
+
+
+
+        private:
+
+        /// Private methods ///
+
+        /**
+         * |@value| computed without overflow; INT_MIN maps to INT_MAX, which is
+         * larger than every threshold and therefore always rejected.
+         */
+        static I32 _abs(I32 value)
+        {
+            return value < 0 ? ~value : value;
+        }
+
+        /**
+         * Uniform deviate in the open interval (0, 1).
+         */
+        template<class Engine> static float _uniform(Engine& engine)
+        {
+            return (float(U32(engine.next()) >> 8) + 0.5f) * (1.0f / 16777216.0f);
+        }
+    };
+}
+
+#endif // ZIGGURAT_H
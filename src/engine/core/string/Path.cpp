@@ -0,0 +1,82 @@
+/** 
+ * \file Path.cpp
+ * \brief Path resolution on the file system.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX // Keep std::min() and std::max() usable
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef _WIN32_WINNT
+        #define _WIN32_WINNT 0x0600 // GetFinalPathNameByHandleA() needs Windows Vista
+    #endif
+    #include <windows.h>
+#endif
+
+#include <cstdlib>
+
+#include "Path.h"
+
+
+namespace nut
+{
+
+
+std::string Path::getCanonicalPath( const std::string& path )
+{
+#ifdef _WIN32
+    // Opening the file follows symbolic links and junctions; directories need backup semantics
+    HANDLE file = CreateFileA(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+
+    if ( file == INVALID_HANDLE_VALUE )
+    {
+        return path;
+    }
+
+    char buffer[MAX_PATH];
+    DWORD length = GetFinalPathNameByHandleA(file, buffer, MAX_PATH, FILE_NAME_NORMALIZED | VOLUME_NAME_DOS);
+    CloseHandle(file);
+
+    if ( length == 0 || length >= MAX_PATH )
+    {
+        return path;
+    }
+
+    // Drop the "\\?\" prefix, turning "\\?\UNC\server\share" back into "\\server\share"
+    std::string canonical(buffer, length);
+
+    if ( canonical.compare(0, 8, "\\\\?\\UNC\\") == 0 )
+    {
+        canonical = "\\\\" + canonical.substr(8);
+    }
+    else if ( canonical.compare(0, 4, "\\\\?\\") == 0 )
+    {
+        canonical = canonical.substr(4);
+    }
+
+    return canonical;
+#else
+    char* resolved = realpath(path.c_str(), nullptr);
+
+    if ( resolved != nullptr )
+    {
+        std::string canonical(resolved);
+        free(resolved);
+
+        return canonical;
+    }
+
+    return path;
+#endif
+}
+
+}
@@ -13,6 +13,7 @@
 
 #include <algorithm>
 #include <sstream>
+#include <string>
 
 
 namespace nut
@@ -84,6 +85,17 @@ namespace nut
 
             return extension;
         }
+
+        /**
+         * Get the absolute path of an existing file, with ".", ".." and symbolic
+         * links resolved, so that every spelling of a path gives the same string.
+         * The path is returned unchanged if it can't be resolved (e.g. the file
+         * doesn't exist).
+         * 
+         * On Windows the path is the one the file system reports for the opened
+         * file, so it also has the case of the names on disk.
+         */
+        static std::string getCanonicalPath( const std::string& path );
     };
 }
 #endif // STRING_H
@@ -0,0 +1,101 @@
+/**
+ * \file ParallelCollector.h
+ * \brief Collects the items produced by a @ThreadPool::parallelFor() into one
+ * vector.
+ *
+ * Every chunk of the range appends to its own vector, and the vectors are
+ * concatenated in chunk order once all chunks are done, so the result doesn't
+ * depend on the number of threads. The chunk vectors are kept between calls,
+ * so collecting a similar number of items again doesn't allocate memory.
+ *
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ *
+ * @author: Eder A. Perez.
+ */
+
+#ifndef PARALLELCOLLECTOR_H
+#define PARALLELCOLLECTOR_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    template <class T>
+    class ParallelCollector
+    {
+        public:
+
+        /**
+         * Function executed over the sub-range [@begin, @end), appending its
+         * items to @out.
+         */
+        typedef std::function<void(size_t begin, size_t end, std::vector<T>& out)> RangeFunction;
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Run @fn over [0, @count) in chunks of @grain elements, in
+         * parallel, and append the items of all chunks to @items in chunk order.
+         *
+         * @param count Number of elements.
+         * @param grain Number of elements per chunk (at least one).
+         * @param fn Function called once per sub-range.
+         * @param items Receives the items (not cleared).
+         */
+        void run(size_t count, size_t grain, const RangeFunction& fn, std::vector<T>& items)
+        {
+            grain = grain > 0 ? grain : 1;
+
+            const size_t chunks = (count + grain - 1) / grain;
+
+            if (_chunks.size() < chunks)
+            {
+                _chunks.resize(chunks);
+            }
+
+            // A sub-range can span several chunks (the whole range when there
+            // are no workers), so not every chunk vector is written to
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                _chunks[c].clear();
+            }
+
+            ThreadPool::getInstance().parallelFor(count, grain, [&](size_t begin, size_t end)
+            {
+                fn(begin, end, _chunks[begin / grain]);
+            });
+
+            size_t total = items.size();
+
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                total += _chunks[c].size();
+            }
+
+            items.reserve(total);
+
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                items.insert(items.end(), _chunks[c].begin(), _chunks[c].end());
+            }
+        }
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        std::vector< std::vector<T> > _chunks; /**< Items of each chunk. */
+    };
+}
+
+#endif // PARALLELCOLLECTOR_H
@@ -0,0 +1,208 @@
+/** 
+ * \file ThreadPool.cpp
+ * \brief Pool of worker threads used to split data-parallel work across all
+ * hardware threads.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    ThreadPool::ThreadPool() : _stop(false)
+    {
+        unsigned int threads = std::thread::hardware_concurrency();
+
+        for (unsigned int i = 1; i < threads; ++i)
+        {
+            _workers.push_back( std::thread(&ThreadPool::_workerLoop, this) );
+        }
+    }
+
+
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _wakeUp.notify_all();
+
+        for (size_t i = 0; i < _workers.size(); ++i)
+        {
+            _workers[i].join();
+        }
+    }
+
+
+
+    void ThreadPool::parallelFor(size_t count, size_t grain, const RangeFunction& fn)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        grain = grain > 0 ? grain : 1;
+
+        // Nothing to share: run inline
+        if (_workers.empty() || count <= grain)
+        {
+            fn(0, count);
+            return;
+        }
+
+        Job job;
+        job.fn = &fn;
+        job.count = count;
+        job.grain = grain;
+        job.chunks = (count + grain - 1) / grain;
+        job.next = 0;
+        job.pending = job.chunks;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.push_back(&job);
+        }
+
+        _wakeUp.notify_all();
+
+        // Work on our own job first
+        for (;;)
+        {
+            size_t chunk = job.next.fetch_add(1);
+
+            if (chunk >= job.chunks)
+            {
+                break;
+            }
+
+            _execute(&job, chunk);
+        }
+
+        // No chunks left to claim: make sure no worker picks the job up again
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        for (std::deque<Job*>::iterator it = _jobs.begin(); it != _jobs.end(); ++it)
+        {
+            if (*it == &job)
+            {
+                _jobs.erase(it);
+                break;
+            }
+        }
+
+        // Help with other jobs while the remaining chunks of ours are running
+        while (job.pending.load() > 0)
+        {
+            size_t chunk;
+            Job* other = _claim(chunk);
+
+            if (other)
+            {
+                lock.unlock();
+                _execute(other, chunk);
+                lock.lock();
+            }
+            else
+            {
+                _jobDone.wait(lock);
+            }
+        }
+    }
+
+
+
+    void ThreadPool::parallelInvoke(const std::function<void()>& a, const std::function<void()>& b)
+    {
+        parallelFor(2, 1, [&a, &b](size_t begin, size_t end)
+        {
+            // Both run in this call when there are no workers
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (i == 0)
+                {
+                    a();
+                }
+                else
+                {
+                    b();
+                }
+            }
+        });
+    }
+
+
+
+    void ThreadPool::_workerLoop()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        for (;;)
+        {
+            size_t chunk;
+            Job* job = _claim(chunk);
+
+            if (job)
+            {
+                lock.unlock();
+                _execute(job, chunk);
+                lock.lock();
+            }
+            else if (_stop)
+            {
+                return;
+            }
+            else
+            {
+                _wakeUp.wait(lock);
+            }
+        }
+    }
+
+
+
+    ThreadPool::Job* ThreadPool::_claim(size_t& chunk)
+    {
+        while (!_jobs.empty())
+        {
+            Job* job = _jobs.front();
+            chunk = job->next.fetch_add(1);
+
+            if (chunk < job->chunks)
+            {
+                return job;
+            }
+
+            // Fully claimed, it only waits for running chunks now
+            _jobs.pop_front();
+        }
+
+        return nullptr;
+    }
+
+
+
+    void ThreadPool::_execute(Job* job, size_t chunk)
+    {
+        size_t begin = chunk * job->grain;
+        size_t end = begin + job->grain < job->count ? begin + job->grain : job->count;
+
+        (*job->fn)(begin, end);
+
+        if (job->pending.fetch_sub(1) == 1)
+        {
+            // Lock so the notification can't slip between the owner's check and wait
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,160 @@
+/** 
+ * \file ThreadPool.h
+ * \brief Pool of worker threads used to split data-parallel work (noise grids,
+ * culling, tree construction...) across all hardware threads.
+ * 
+ * The calling thread always takes part in the work it submits, and a thread
+ * waiting for its work to finish helps with any other pending work. Because of
+ * that, @parallelFor() can be called from inside another @parallelFor() (for
+ * instance, by recursive fork-join algorithms) without deadlocking. It also
+ * means that a frame waiting for its own work can end up running any job in
+ * the pool, so work that blocks or may take longer than a frame (disk loads,
+ * background queries) belongs on a thread of its own.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+namespace nut
+{
+    class ThreadPool
+    {
+        public:
+
+        /**
+         * Function executed over the sub-range [@begin, @end) of a @parallelFor().
+         */
+        typedef std::function<void(size_t begin, size_t end)> RangeFunction;
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Return an unique instance of @ThreadPool. It starts one worker
+         * per hardware thread, minus one for the calling thread.
+         * 
+         * @return An unique instance of @ThreadPool.
+         */
+        static ThreadPool& getInstance()
+        {
+            static ThreadPool instance;
+            return instance;
+        }
+
+        /**
+         * Get the number of threads that take part in a @parallelFor(), including
+         * the calling thread.
+         * 
+         * @return Number of workers plus one.
+         */
+        size_t getNumberOfThreads() const
+        {
+            return _workers.size() + 1;
+        }
+
+        /**
+         * \brief Split [0, @count) into chunks of @grain elements and run @fn over
+         * every chunk, in parallel. Returns when all chunks have been executed.
+         * 
+         * @param count Number of elements.
+         * @param grain Number of elements per chunk (at least one). Chunks should
+         * be big enough to amortize scheduling, e.g. thousands of cheap elements.
+         * @param fn Function called once per chunk.
+         */
+        void parallelFor(size_t count, size_t grain, const RangeFunction& fn);
+
+        /**
+         * \brief Run two functions in parallel and wait for both (fork-join).
+         * 
+         * @param a First function (runs on the calling thread if nobody steals it).
+         * @param b Second function.
+         */
+        void parallelInvoke(const std::function<void()>& a, const std::function<void()>& b);
+
+
+
+        private:
+
+        /**
+         * \brief Work submitted by a @parallelFor() call. It lives on the stack of
+         * the submitting thread.
+         */
+        struct Job
+        {
+            const RangeFunction* fn;
+            size_t count;
+            size_t grain;
+            size_t chunks;
+            std::atomic<size_t> next;    /**< Next chunk to be claimed. */
+            std::atomic<size_t> pending; /**< Chunks claimed or not, but not finished yet. */
+        };
+
+
+
+        /// Private attributes ///
+
+        std::vector<std::thread> _workers;
+        std::deque<Job*> _jobs;           /**< Jobs with unclaimed chunks. */
+        std::mutex _mutex;                /**< Guards @_jobs and @_stop. */
+        std::condition_variable _wakeUp;  /**< Signaled when a job is submitted. */
+        std::condition_variable _jobDone; /**< Signaled when a job finishes. */
+        bool _stop;
+
+
+
+        /// Private methods ///
+
+        /**
+         * \brief Constructor.
+         */
+        ThreadPool();
+
+        /**
+         * \brief Destructor. Stops and joins all workers.
+         */
+        ~ThreadPool();
+
+        // Stop the compiler generating methods of copy the object
+        ThreadPool(const ThreadPool& copy) = delete;
+        ThreadPool& operator=(const ThreadPool& copy) = delete;
+
+        /**
+         * \brief Worker thread main loop.
+         */
+        void _workerLoop();
+
+        /**
+         * \brief Claim a chunk of the first pending job. Must be called with
+         * @_mutex locked.
+         * 
+         * @param chunk Index of the claimed chunk.
+         * @return The job the chunk belongs to, or nullptr if there's no work.
+         */
+        Job* _claim(size_t& chunk);
+
+        /**
+         * \brief Execute a claimed chunk and signal the job's completion if it
+         * was the last one.
+         */
+        void _execute(Job* job, size_t chunk);
+    };
+}
+
+#endif // THREADPOOL_H
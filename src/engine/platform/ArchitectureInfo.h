@@ -14,6 +14,10 @@
 
 #undef NUT_X86
 #undef NUT_X64
+#undef NUT_SSE2
+#undef NUT_SSE41
+#undef NUT_AVX2
+#undef NUT_FMA
 
 
 
@@ -31,4 +35,28 @@
 
 
 
+// SIMD instruction sets enabled in the compiler. Define NUT_NO_SIMD to force
+// the scalar code paths.
+#if !defined(NUT_NO_SIMD)
+
+    #if defined(__AVX2__)
+        #define NUT_AVX2
+    #endif
+
+    #if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+        #define NUT_FMA
+    #endif
+
+    #if defined(__SSE4_1__) || defined(NUT_AVX2)
+        #define NUT_SSE41
+    #endif
+
+    #if defined(__SSE2__) || defined(NUT_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define NUT_SSE2
+    #endif
+
+#endif
+
+
+
 #endif // ARCHITECTUREINFO_H
@@ -12,6 +12,7 @@
 #ifndef DATATYPE_H
 #define DATATYPE_H
 
+#include <cstddef>
 #include <cstdint>
 
 
@@ -27,6 +27,12 @@ class IResourceFile
         }
 
         virtual size_t getNumberOfResources() const = 0;
+
+        /**
+         * Get the memory held by the file's resources, in bytes, as counted by
+         * the budget of the @ResourceManager.
+         */
+        virtual size_t getMemoryUsage() const = 0;
 };
 
 }
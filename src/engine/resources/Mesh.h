@@ -11,6 +11,9 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <vector>
+#include "ConvexHull.h"
+#include "Sphere.h"
 #include "Vertex.h"
 
 
@@ -26,15 +29,55 @@ class Mesh
             return m_vertices;
         }
 
+        const std::vector< Vertex >& getVertices() const
+        {
+            return m_vertices;
+        }
+
         std::vector< int >& getTriangulation()
         {
             return m_triangulation;
         }
 
+        const std::vector< int >& getTriangulation() const
+        {
+            return m_triangulation;
+        }
+
+        /**
+         * Get the sphere bounding the vertex positions, computed when the
+         * mesh is imported (the minimal sphere if the mesh was cooked).
+         */
+        Sphere& getBoundingSphere()
+        {
+            return m_boundingSphere;
+        }
+
+        const Sphere& getBoundingSphere() const
+        {
+            return m_boundingSphere;
+        }
+
+        /**
+         * Get the convex hull of the vertex positions, computed when the mesh
+         * is cooked (empty if the mesh is flat or wasn't cooked).
+         */
+        ConvexHull& getConvexHull()
+        {
+            return m_convexHull;
+        }
+
+        const ConvexHull& getConvexHull() const
+        {
+            return m_convexHull;
+        }
+
     private:
 
         std::vector< Vertex > m_vertices;
         std::vector< int > m_triangulation;
+        Sphere m_boundingSphere;
+        ConvexHull m_convexHull;
 };
 
 }
@@ -15,6 +15,7 @@
 
 #include "ModelResourceFile.h"
 #include "Mesh.h"
+#include "NutResourceFile.h"
 
 
 namespace nut
@@ -83,6 +84,57 @@ ModelResourceFile::ModelResourceFile( const std::string& path ) : m_numberOfReso
 
 
 
+bool ModelResourceFile::cook( const std::string& path, const std::string& cookedPath )
+{
+    ModelResourceFile file( path );
+
+    if ( !file.hasMeshes() )
+    {
+        std::cerr << "nut::ModelResourceFile::cook error. No meshes to cook in: " << path << "\n";
+        return false;
+    }
+
+    // Exact spheres replace the approximate ones from the import. Hulls are
+    // for physics proxies and occluders; they stay empty for flat meshes
+    for (size_t i = 0; i < file.m_meshes.size(); ++i)
+    {
+        Mesh& mesh = file.m_meshes[i];
+
+        mesh.getBoundingSphere() = Sphere::fitExact( mesh );
+        mesh.getConvexHull().build( mesh );
+    }
+
+    return NutResourceFile::write( cookedPath, file.m_meshes );
+}
+
+
+
+size_t ModelResourceFile::getMemoryUsage() const
+{
+    size_t bytes = m_meshes.size() * sizeof(Mesh);
+
+    for (size_t i = 0; i < m_meshes.size(); ++i)
+    {
+        const Mesh& mesh = m_meshes[i];
+
+        bytes += mesh.getVertices().size() * sizeof(Vertex) +
+                 mesh.getTriangulation().size() * sizeof(int) +
+                 mesh.getConvexHull().getVertices().size() * sizeof(Vec3f) +
+                 mesh.getConvexHull().getIndices().size() * sizeof(U32);
+    }
+
+    return bytes;
+}
+
+
+
+Mesh& ModelResourceFile::getMesh( size_t index )
+{
+    return m_meshes[index];
+}
+
+
+
 void ModelResourceFile::loadMeshes( aiMesh** meshes, unsigned int size )
 {
     for (unsigned int n = 0; n < size; ++n)
@@ -140,6 +192,9 @@ void ModelResourceFile::loadMeshes( aiMesh** meshes, unsigned int size )
             triangulation.push_back( face->mIndices[2] );
         }
 
+        // Bounds for culling
+        nutMesh.getBoundingSphere() = Sphere::fit( nutMesh );
+
         m_meshes.push_back( nutMesh );
     }
 }
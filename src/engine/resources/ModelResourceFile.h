@@ -30,11 +30,25 @@ class ModelResourceFile : public IResourceFile
             return new ModelResourceFile( path );
         }
 
+        /**
+         * \brief Import a model file and write its meshes to a cooked file,
+         * which @NutResourceFile maps without going through Assimp. The
+         * meshes get exact bounding spheres, and their convex hulls are only
+         * built here.
+         *
+         * @param path Model file.
+         * @param cookedPath Destination file, usually with the .nut extension.
+         * @return False if the model has no meshes or the file can't be written.
+         */
+        static bool cook( const std::string& path, const std::string& cookedPath );
+
         size_t getNumberOfResources() const
         {
             return m_numberOfResources;
         }
 
+        size_t getMemoryUsage() const;
+
         bool hasMeshes()
         {
             return m_meshes.size() > 0;
@@ -45,6 +59,14 @@ class ModelResourceFile : public IResourceFile
             return m_meshes.size();
         }
 
+        /**
+         * Get a mesh of this file, e.g. to build its @BVH once and share it
+         * between instances.
+         * 
+         * @param index Mesh index in [0, getNumberOfMeshes()).
+         */
+        Mesh& getMesh( size_t index );
+
 
     private:
 
@@ -0,0 +1,419 @@
+/** 
+ * \file NutResourceFile.cpp
+ * \brief Cooked binary mesh file (.nut), mapped into memory.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX // Keep std::min() and std::max() usable
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "NutResourceFile.h"
+#include "Mesh.h"
+
+
+namespace nut
+{
+
+static const char NUT_FILE_MAGIC[4] = { 'N', 'U', 'T', 'M' }; /**< First bytes of a cooked file. */
+static const U32 NUT_FILE_ENDIANNESS = 0x01020304;             /**< Reads differently on a foreign byte order. */
+
+/** 
+ * \brief Header at the start of a cooked file.
+ */
+struct NutFileHeader
+{
+    char magic[4];
+    U32 version;
+    U32 endianness;
+    U32 vertexSize;     /**< sizeof(Vertex) of the build that cooked the file. */
+    U32 meshCount;
+    U32 reserved;
+    U64 fileSize;
+};
+
+/** 
+ * \brief Record of the mesh table, which follows the header.
+ */
+struct NutFileMesh
+{
+    U64 vertexOffset;   /**< Offsets from the start of the file, in bytes. */
+    U64 indexOffset;
+    U64 hullVertexOffset;
+    U64 hullIndexOffset;
+    U32 vertexCount;
+    U32 indexCount;
+    U32 hullVertexCount;
+    U32 hullIndexCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    float sphere[4];    /**< Center and radius. */
+};
+
+
+
+/** 
+ * Round a file offset up to the section alignment.
+ */
+static U64 nutAlign(U64 offset)
+{
+    return (offset + NutResourceFile::ALIGNMENT - 1) & ~U64(NutResourceFile::ALIGNMENT - 1);
+}
+
+
+
+/** 
+ * Check that a section of @count elements is aligned and inside the file.
+ */
+static bool nutCheckSection(U64 offset, U64 count, size_t elementSize, size_t fileSize)
+{
+    return offset % NutResourceFile::ALIGNMENT == 0 &&
+           offset <= fileSize &&
+           count <= (fileSize - offset) / elementSize;
+}
+
+
+
+/** 
+ * Write zeros up to a file offset.
+ */
+static void nutPad(std::ofstream& file, U64 offset)
+{
+    static const char zeros[NutResourceFile::ALIGNMENT] = {};
+    U64 position = static_cast<U64>(file.tellp());
+
+    if (position < offset)
+    {
+        file.write(zeros, static_cast<std::streamsize>(offset - position));
+    }
+}
+
+
+
+NutResourceFile::NutResourceFile( const std::string& path ) : m_data(nullptr), m_size(0)
+{
+    if ( map(path) && !loadMeshes() )
+    {
+        std::cerr << "nut::NutResourceFile error. Invalid or outdated cooked file: " << path << "\n";
+        unmap();
+    }
+}
+
+
+
+NutResourceFile::~NutResourceFile()
+{
+    unmap();
+}
+
+
+
+bool NutResourceFile::write( const std::string& path, const std::vector< Mesh >& meshes )
+{
+    NutFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, NUT_FILE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.endianness = NUT_FILE_ENDIANNESS;
+    header.vertexSize = sizeof(Vertex);
+    header.meshCount = static_cast<U32>(meshes.size());
+
+    // Lay out the sections
+    std::vector< NutFileMesh > records(meshes.size());
+    U64 tableOffset = nutAlign(sizeof(NutFileHeader));
+    U64 offset = nutAlign(tableOffset + records.size() * sizeof(NutFileMesh));
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        const Mesh& mesh = meshes[i];
+        NutFileMesh& record = records[i];
+        std::memset(&record, 0, sizeof(record));
+
+        record.vertexCount = static_cast<U32>(mesh.getVertices().size());
+        record.indexCount = static_cast<U32>(mesh.getTriangulation().size());
+        record.hullVertexCount = static_cast<U32>(mesh.getConvexHull().getVertices().size());
+        record.hullIndexCount = static_cast<U32>(mesh.getConvexHull().getIndices().size());
+
+        record.vertexOffset = offset;
+        offset = nutAlign(offset + U64(record.vertexCount) * sizeof(Vertex));
+        record.indexOffset = offset;
+        offset = nutAlign(offset + U64(record.indexCount) * sizeof(int));
+        record.hullVertexOffset = offset;
+        offset = nutAlign(offset + U64(record.hullVertexCount) * sizeof(Vec3f));
+        record.hullIndexOffset = offset;
+        offset = nutAlign(offset + U64(record.hullIndexCount) * sizeof(U32));
+
+        BoundingBox bounds = BoundingBox::compute(mesh);
+        const Sphere& sphere = mesh.getBoundingSphere();
+
+        record.boundsMin[0] = bounds.min.x; record.boundsMin[1] = bounds.min.y; record.boundsMin[2] = bounds.min.z;
+        record.boundsMax[0] = bounds.max.x; record.boundsMax[1] = bounds.max.y; record.boundsMax[2] = bounds.max.z;
+        record.sphere[0] = sphere.center.x;
+        record.sphere[1] = sphere.center.y;
+        record.sphere[2] = sphere.center.z;
+        record.sphere[3] = sphere.radius;
+    }
+
+    header.fileSize = offset;
+
+    // Write them
+    std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+
+    if ( !file )
+    {
+        std::cerr << "nut::NutResourceFile::write error. Can't create file: " << path << "\n";
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    nutPad(file, tableOffset);
+
+    if ( !records.empty() )
+    {
+        file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(NutFileMesh));
+    }
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        const Mesh& mesh = meshes[i];
+        const NutFileMesh& record = records[i];
+
+        nutPad(file, record.vertexOffset);
+        file.write(reinterpret_cast<const char*>(mesh.getVertices().data()), U64(record.vertexCount) * sizeof(Vertex));
+        nutPad(file, record.indexOffset);
+        file.write(reinterpret_cast<const char*>(mesh.getTriangulation().data()), U64(record.indexCount) * sizeof(int));
+        nutPad(file, record.hullVertexOffset);
+        file.write(reinterpret_cast<const char*>(mesh.getConvexHull().getVertices().data()),
+                   U64(record.hullVertexCount) * sizeof(Vec3f));
+        nutPad(file, record.hullIndexOffset);
+        file.write(reinterpret_cast<const char*>(mesh.getConvexHull().getIndices().data()),
+                   U64(record.hullIndexCount) * sizeof(U32));
+    }
+
+    nutPad(file, header.fileSize);
+    file.close();
+
+    if ( !file )
+    {
+        std::cerr << "nut::NutResourceFile::write error. Can't write file: " << path << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+
+
+void NutResourceFile::copyMesh( size_t index, Mesh& mesh ) const
+{
+    const MeshView& view = m_meshes[index];
+
+    mesh.getVertices().assign(view.vertices, view.vertices + view.vertexCount);
+    mesh.getTriangulation().assign(view.triangulation, view.triangulation + view.indexCount);
+    mesh.getBoundingSphere() = view.boundingSphere;
+    mesh.getConvexHull().getVertices().assign(view.hullVertices, view.hullVertices + view.hullVertexCount);
+    mesh.getConvexHull().getIndices().assign(view.hullIndices, view.hullIndices + view.hullIndexCount);
+}
+
+
+
+bool NutResourceFile::map( const std::string& path )
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+
+    if ( file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) || size.QuadPart == 0 )
+    {
+        std::cerr << "nut::NutResourceFile::map error. Can't open file: " << path << "\n";
+
+        if ( file != INVALID_HANDLE_VALUE )
+        {
+            CloseHandle(file);
+        }
+
+        return false;
+    }
+
+    // The view keeps the file mapped after both handles are closed
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+    if ( mapping != nullptr )
+    {
+        CloseHandle(mapping);
+    }
+
+    CloseHandle(file);
+
+    if ( data == nullptr )
+    {
+        std::cerr << "nut::NutResourceFile::map error. Can't map file: " << path << "\n";
+        return false;
+    }
+
+    m_size = static_cast<size_t>(size.QuadPart);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    struct stat status;
+
+    if ( file < 0 || fstat(file, &status) != 0 || status.st_size == 0 )
+    {
+        std::cerr << "nut::NutResourceFile::map error. Can't open file: " << path << "\n";
+
+        if ( file >= 0 )
+        {
+            close(file);
+        }
+
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if ( data == MAP_FAILED )
+    {
+        std::cerr << "nut::NutResourceFile::map error. Can't map file: " << path << "\n";
+        return false;
+    }
+
+    m_size = static_cast<size_t>(status.st_size);
+#endif
+
+    m_data = static_cast<const char*>(data);
+
+    return true;
+}
+
+
+
+void NutResourceFile::unmap()
+{
+    if ( m_data != nullptr )
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+#else
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_meshes.clear();
+}
+
+
+
+bool NutResourceFile::loadMeshes()
+{
+    // The mapping is page aligned, so the sections are aligned in memory too
+    if ( m_size < sizeof(NutFileHeader) )
+    {
+        return false;
+    }
+
+    const NutFileHeader* header = reinterpret_cast<const NutFileHeader*>(m_data);
+
+    if ( std::memcmp(header->magic, NUT_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+         header->version != VERSION ||
+         header->endianness != NUT_FILE_ENDIANNESS ||
+         header->vertexSize != sizeof(Vertex) ||
+         header->fileSize != m_size )
+    {
+        return false;
+    }
+
+    U64 tableOffset = nutAlign(sizeof(NutFileHeader));
+
+    if ( !nutCheckSection(tableOffset, header->meshCount, sizeof(NutFileMesh), m_size) )
+    {
+        return false;
+    }
+
+    const NutFileMesh* records = reinterpret_cast<const NutFileMesh*>(m_data + tableOffset);
+    m_meshes.resize(header->meshCount);
+
+    for (U32 i = 0; i < header->meshCount; ++i)
+    {
+        const NutFileMesh& record = records[i];
+        MeshView& view = m_meshes[i];
+
+        if ( !nutCheckSection(record.vertexOffset, record.vertexCount, sizeof(Vertex), m_size) ||
+             !nutCheckSection(record.indexOffset, record.indexCount, sizeof(int), m_size) ||
+             !nutCheckSection(record.hullVertexOffset, record.hullVertexCount, sizeof(Vec3f), m_size) ||
+             !nutCheckSection(record.hullIndexOffset, record.hullIndexCount, sizeof(U32), m_size) )
+        {
+            return false;
+        }
+
+        if ( record.indexCount % 3 != 0 || record.hullIndexCount % 3 != 0 )
+        {
+            std::cerr << "nut::NutResourceFile::loadMeshes error. Partial triangle in mesh " << i << ".\n";
+            return false;
+        }
+
+        // Consumers index the vertices without checking, so a bad index must not get through
+        const int* indices = reinterpret_cast<const int*>(m_data + record.indexOffset);
+
+        for (U32 k = 0; k < record.indexCount; ++k)
+        {
+            if ( indices[k] < 0 || U32(indices[k]) >= record.vertexCount )
+            {
+                std::cerr << "nut::NutResourceFile::loadMeshes error. Invalid vertex index " << indices[k]
+                          << " in mesh " << i << ".\n";
+                return false;
+            }
+        }
+
+        const U32* hullIndices = reinterpret_cast<const U32*>(m_data + record.hullIndexOffset);
+
+        for (U32 k = 0; k < record.hullIndexCount; ++k)
+        {
+            if ( hullIndices[k] >= record.hullVertexCount )
+            {
+                std::cerr << "nut::NutResourceFile::loadMeshes error. Invalid hull vertex index " << hullIndices[k]
+                          << " in mesh " << i << ".\n";
+                return false;
+            }
+        }
+
+        view.vertices = reinterpret_cast<const Vertex*>(m_data + record.vertexOffset);
+        view.vertexCount = record.vertexCount;
+        view.triangulation = indices;
+        view.indexCount = record.indexCount;
+        view.hullVertices = reinterpret_cast<const Vec3f*>(m_data + record.hullVertexOffset);
+        view.hullVertexCount = record.hullVertexCount;
+        view.hullIndices = hullIndices;
+        view.hullIndexCount = record.hullIndexCount;
+        view.bounds = BoundingBox(Vec3f(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]),
+                                  Vec3f(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]));
+        view.boundingSphere = Sphere(Vec3f(record.sphere[0], record.sphere[1], record.sphere[2]), record.sphere[3]);
+    }
+
+    return true;
+}
+
+}
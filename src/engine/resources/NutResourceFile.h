@@ -0,0 +1,165 @@
+/** 
+ * \file NutResourceFile.h
+ * \brief Cooked binary mesh file (.nut), mapped into memory.
+ * 
+ * Model files are cooked once with @ModelResourceFile::cook(), which runs the
+ * Assimp import (triangulation, normals, tangents, vertex joining) and the
+ * bounds and hull computations, then writes the result in the memory layout
+ * of the engine. Loading a cooked file maps it with mmap and points into the
+ * mapping: there is no parsing and no copy, the pages are read on first touch
+ * and shared with any other process mapping the same file.
+ * 
+ * Layout (native endianness, every section aligned to @ALIGNMENT bytes):
+ * 
+ *     Header       magic, version, endianness tag, sizeof(@Vertex), mesh count, file size
+ *     Mesh table   one record per mesh: section offsets, counts, bounding box and sphere
+ *     Sections     per mesh: vertices (@Vertex), triangulation (int),
+ *                  hull vertices (@Vec3f), hull triangles (U32)
+ * 
+ * A file is rejected if its header doesn't match this build (other version,
+ * endianness or @Vertex layout) or a section falls outside it; it must then
+ * be cooked again.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef NUT_RESOURCE_FILE_H
+#define	NUT_RESOURCE_FILE_H
+
+#include <string>
+#include <vector>
+#include "BoundingBox.h"
+#include "DataType.h"
+#include "IResourceFile.h"
+#include "Sphere.h"
+#include "Vector.h"
+#include "Vertex.h"
+
+
+namespace nut
+{
+
+class Mesh;
+
+class NutResourceFile : public IResourceFile
+{
+    public:
+
+        static const U32 VERSION = 1;         /**< Format version, bumped on any layout change. */
+        static const size_t ALIGNMENT = 64;   /**< Alignment of every section, in bytes. */
+
+        /**
+         * \brief A mesh of the file: pointers into the mapping, valid as long
+         * as the file object lives.
+         */
+        struct MeshView
+        {
+            const Vertex* vertices;
+            size_t vertexCount;
+            const int* triangulation;     /**< Three vertex indices per triangle. */
+            size_t indexCount;
+            const Vec3f* hullVertices;
+            size_t hullVertexCount;
+            const U32* hullIndices;       /**< Three hull vertex indices per triangle (none if the mesh is flat). */
+            size_t hullIndexCount;
+            BoundingBox bounds;
+            Sphere boundingSphere;
+        };
+
+        static IResourceFile* createMe( const std::string& path )
+        {
+            return new NutResourceFile( path );
+        }
+
+        /**
+         * Destructor. Unmaps the file.
+         */
+        ~NutResourceFile();
+
+        /**
+         * \brief Write meshes to a cooked file.
+         * 
+         * @param path Destination file, usually with the .nut extension.
+         * @param meshes Meshes with their bounding sphere and convex hull
+         * computed, as imported by @ModelResourceFile.
+         * @return False if the file can't be written.
+         */
+        static bool write( const std::string& path, const std::vector< Mesh >& meshes );
+
+        size_t getNumberOfResources() const
+        {
+            return m_meshes.size();
+        }
+
+        /**
+         * Get the size of the mapping, whose pages are shared with the system's
+         * file cache, plus the mesh views.
+         */
+        size_t getMemoryUsage() const
+        {
+            return m_size + m_meshes.size() * sizeof(MeshView);
+        }
+
+        /**
+         * Check if the file was mapped and its header and sections are valid.
+         */
+        bool isLoaded() const
+        {
+            return m_data != nullptr;
+        }
+
+        bool hasMeshes() const
+        {
+            return m_meshes.size() > 0;
+        }
+
+        size_t getNumberOfMeshes() const
+        {
+            return m_meshes.size();
+        }
+
+        /**
+         * Get a mesh of this file, e.g. to build its @BVH straight from the
+         * mapped arrays.
+         * 
+         * @param index Mesh index in [0, getNumberOfMeshes()).
+         */
+        const MeshView& getMesh( size_t index ) const
+        {
+            return m_meshes[index];
+        }
+
+        /**
+         * \brief Copy a mesh into a @Mesh, for code that needs to own or
+         * modify it (a copy per array, no conversion).
+         * 
+         * @param index Mesh index in [0, getNumberOfMeshes()).
+         * @param mesh Receives the vertices, triangulation, bounding sphere and
+         * convex hull.
+         */
+        void copyMesh( size_t index, Mesh& mesh ) const;
+
+
+    private:
+
+        NutResourceFile(const std::string& path);
+
+        // Stop the compiler generating methods of copy the object
+        NutResourceFile(const NutResourceFile& copy) = delete;
+        NutResourceFile& operator=(const NutResourceFile& copy) = delete;
+
+        bool map(const std::string& path);
+        void unmap();
+        bool loadMeshes();
+
+
+        const char* m_data;                 /**< Mapped file, or nullptr. */
+        size_t m_size;                      /**< Size of the mapping in bytes. */
+        std::vector< MeshView > m_meshes;   /**< Views of all meshes in this resource file. */
+};
+
+}
+#endif	// NUT_RESOURCE_FILE_H
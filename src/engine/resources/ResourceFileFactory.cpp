@@ -8,30 +8,248 @@
  * @author: Eder A. Perez.
  */
 
+#include <algorithm>
+
 #include "ResourceFileFactory.h"
+#include "IResourceFile.h"
 #include "Path.h"
 
 
 namespace nut
 {
 
+/** 
+ * \brief An asynchronous load. Guarded by the factory's load mutex, except for
+ * the members set at submission.
+ */
+struct LoadRequest
+{
+    std::string path;
+    int priority;
+    U64 sequence;
+    LoadCallback callback;
+    CallbackThread thread;
+    LoadStatus status;
+    bool cancelled;                         /**< Cancelled while loading. */
+    bool calling;                           /**< The callback runs on the loader thread: too late to cancel. */
+    std::shared_ptr< IResourceFile > file;
+};
+
+
+/** 
+ * Heap order of the queued loads: highest priority first, then oldest first.
+ */
+static bool loadRequestLess(const std::shared_ptr< LoadRequest >& a, const std::shared_ptr< LoadRequest >& b)
+{
+    return a->priority < b->priority || (a->priority == b->priority && a->sequence > b->sequence);
+}
+
+
+static bool loadRequestIsFinished(const LoadRequest& request)
+{
+    return request.status == LoadStatus::Done ||
+           request.status == LoadStatus::Failed ||
+           request.status == LoadStatus::Cancelled;
+}
+
+
+LoadStatus LoadHandle::getStatus() const
+{
+    std::lock_guard< std::mutex > lock(ResourceFileFactory::getInstance().m_loadMutex);
+    return m_request->status;
+}
+
+
+bool LoadHandle::isFinished() const
+{
+    std::lock_guard< std::mutex > lock(ResourceFileFactory::getInstance().m_loadMutex);
+    return loadRequestIsFinished(*m_request);
+}
+
+
+std::shared_ptr< IResourceFile > LoadHandle::get() const
+{
+    std::lock_guard< std::mutex > lock(ResourceFileFactory::getInstance().m_loadMutex);
+    return m_request->status == LoadStatus::Done ? m_request->file : nullptr;
+}
+
+
+std::shared_ptr< IResourceFile > LoadHandle::wait() const
+{
+    ResourceFileFactory& factory = ResourceFileFactory::getInstance();
+    std::unique_lock< std::mutex > lock(factory.m_loadMutex);
+    const LoadRequest& request = *m_request;
+
+    factory.m_loadFinished.wait(lock, [&request]() { return loadRequestIsFinished(request); });
+
+    return request.status == LoadStatus::Done ? request.file : nullptr;
+}
+
+
+bool LoadHandle::cancel()
+{
+    ResourceFileFactory& factory = ResourceFileFactory::getInstance();
+    std::lock_guard< std::mutex > lock(factory.m_loadMutex);
+
+    if ( m_request->status == LoadStatus::Queued )
+    {
+        std::vector< std::shared_ptr< LoadRequest > >& queue = factory.m_queue;
+        queue.erase(std::find(queue.begin(), queue.end(), m_request));
+        std::make_heap(queue.begin(), queue.end(), loadRequestLess);
+
+        m_request->status = LoadStatus::Cancelled;
+        factory.m_loadFinished.notify_all();
+
+        return true;
+    }
+
+    if ( m_request->status == LoadStatus::Loading && !m_request->calling )
+    {
+        m_request->cancelled = true;
+        return true;
+    }
+
+    return false;
+}
+
+
+ResourceFileFactory::ResourceFileFactory() : m_loaderCount(std::max(1u, std::thread::hardware_concurrency() / 2)),
+                                             m_sequence(0), m_generation(0)
+{
+
+}
+
+
+ResourceFileFactory::~ResourceFileFactory()
+{
+    stopLoaders();
+
+    std::lock_guard< std::mutex > lock(m_loadMutex);
+
+    for (size_t i = 0; i < m_queue.size(); ++i)
+    {
+        m_queue[i]->status = LoadStatus::Cancelled;
+    }
+
+    m_queue.clear();
+    m_loadFinished.notify_all();
+}
+
+
 IResourceFile* ResourceFileFactory::createResourceFile(const std::string& path)
 {
     std::string extension = Path::getFileExtension(path);
     
     ResourceFileId id = getResourceFileIdByExtension(extension);
+    std::map< ResourceFileId, CreateResourceFileFunc >::const_iterator it = m_resourceFiles.find(id);
     
-    if ( m_resourceFiles.find(id) != m_resourceFiles.end() )
+    if ( it != m_resourceFiles.end() )
     {
-        return m_resourceFiles[id](path);
+        return it->second(path);
     }
     
     return nullptr;
 }
 
 
+LoadHandle ResourceFileFactory::loadAsync(const std::string& path, int priority, const LoadCallback& callback,
+                                          CallbackThread thread)
+{
+    std::shared_ptr< LoadRequest > request = std::make_shared< LoadRequest >();
+    request->path = path;
+    request->priority = priority;
+    request->callback = callback;
+    request->thread = thread;
+    request->status = LoadStatus::Queued;
+    request->cancelled = false;
+    request->calling = false;
+
+    {
+        std::lock_guard< std::mutex > lock(m_loadMutex);
+
+        if ( m_loaders.empty() )
+        {
+            startLoaders();
+        }
+
+        request->sequence = m_sequence++;
+        m_queue.push_back(request);
+        std::push_heap(m_queue.begin(), m_queue.end(), loadRequestLess);
+    }
+
+    m_loadQueued.notify_one();
+
+    LoadHandle handle;
+    handle.m_request = request;
+
+    return handle;
+}
+
+
+size_t ResourceFileFactory::dispatchCallbacks()
+{
+    std::vector< std::shared_ptr< LoadRequest > > finished;
+
+    {
+        std::lock_guard< std::mutex > lock(m_loadMutex);
+        finished.swap(m_dispatch);
+    }
+
+    for (size_t i = 0; i < finished.size(); ++i)
+    {
+        finished[i]->callback(finished[i]->path, finished[i]->file);
+    }
+
+    return finished.size();
+}
+
+
+void ResourceFileFactory::setNumberOfLoaderThreads(size_t count)
+{
+    bool running;
+
+    {
+        std::lock_guard< std::mutex > lock(m_loadMutex);
+        m_loaderCount = std::max(count, size_t(1));
+        running = !m_loaders.empty();
+    }
+
+    if ( running )
+    {
+        stopLoaders();
+
+        std::lock_guard< std::mutex > lock(m_loadMutex);
+
+        if ( m_loaders.empty() )
+        {
+            startLoaders();
+        }
+    }
+}
+
+
+size_t ResourceFileFactory::getNumberOfLoaderThreads() const
+{
+    std::lock_guard< std::mutex > lock(m_loadMutex);
+    return m_loaderCount;
+}
+
+
+size_t ResourceFileFactory::getNumberOfQueuedLoads() const
+{
+    std::lock_guard< std::mutex > lock(m_loadMutex);
+    return m_queue.size();
+}
+
+
 ResourceFileId ResourceFileFactory::getResourceFileIdByExtension(const std::string& extension)
 {
+    // Cooked files
+    if ( extension == "nut" )
+    {
+        return ResourceFileId::nut;
+    }
+
     // 3D model files
     if ( extension == "obj" || // Wavefront Object
          extension == "ply" || // Stanford Polygon Library
@@ -47,4 +265,99 @@ ResourceFileId ResourceFileFactory::getResourceFileIdByExtension(const std::stri
     return ResourceFileId::Unknown;
 }
 
+
+void ResourceFileFactory::startLoaders()
+{
+    // Called with m_loadMutex locked
+    for (size_t i = 0; i < m_loaderCount; ++i)
+    {
+        m_loaders.push_back( std::thread(&ResourceFileFactory::loaderLoop, this, m_generation) );
+    }
+}
+
+
+void ResourceFileFactory::stopLoaders()
+{
+    std::vector< std::thread > loaders;
+
+    {
+        std::lock_guard< std::mutex > lock(m_loadMutex);
+        ++m_generation;
+        loaders.swap(m_loaders);
+    }
+
+    m_loadQueued.notify_all();
+
+    for (size_t i = 0; i < loaders.size(); ++i)
+    {
+        loaders[i].join();
+    }
+}
+
+
+void ResourceFileFactory::loaderLoop(U32 generation)
+{
+    std::unique_lock< std::mutex > lock(m_loadMutex);
+
+    for (;;)
+    {
+        m_loadQueued.wait(lock, [this, generation]() { return m_generation != generation || !m_queue.empty(); });
+
+        if ( m_generation != generation )
+        {
+            return;
+        }
+
+        std::pop_heap(m_queue.begin(), m_queue.end(), loadRequestLess);
+        std::shared_ptr< LoadRequest > request = m_queue.back();
+        m_queue.pop_back();
+        request->status = LoadStatus::Loading;
+
+        lock.unlock();
+
+        std::shared_ptr< IResourceFile > file( createResourceFile(request->path) );
+
+        if ( file != nullptr && file->getNumberOfResources() == 0 )
+        {
+            file.reset();
+        }
+
+        lock.lock();
+
+        if ( request->cancelled )
+        {
+            request->status = LoadStatus::Cancelled;
+            m_loadFinished.notify_all();
+
+            // Release the file outside the lock
+            lock.unlock();
+            file.reset();
+            lock.lock();
+
+            continue;
+        }
+
+        request->file = file;
+
+        if ( request->callback )
+        {
+            if ( request->thread == CallbackThread::Loader )
+            {
+                // Before the status is published, so that wait() returns after it
+                request->calling = true;
+                lock.unlock();
+                request->callback(request->path, file);
+                lock.lock();
+            }
+            else
+            {
+                m_dispatch.push_back(request);
+            }
+        }
+
+        request->status = file != nullptr ? LoadStatus::Done : LoadStatus::Failed;
+        m_loadFinished.notify_all();
+    }
+}
+
 }
\ No newline at end of file
@@ -2,6 +2,16 @@
  * \file ResourceFileFactory.h
  * \brief 
  * 
+ * Files are created synchronously by @createResourceFile(), or in the
+ * background by @loadAsync(), which queues the load for a set of loader
+ * threads and returns a @LoadHandle to wait for, poll or cancel it. Loads run
+ * by priority, then in submission order. Loader threads are separate from the
+ * @ThreadPool, since an import blocks on the disk.
+ * 
+ * A completion callback runs either on the loader thread or, for code that
+ * isn't thread safe (e.g. OpenGL uploads), on the thread that calls
+ * @dispatchCallbacks(), typically once per frame from the game loop.
+ * 
  * Licensed under the MIT License (MIT)
  * Copyright (c) 2014 Eder de Almeida Perez
  * 
@@ -11,8 +21,15 @@
 #ifndef RESOURCE_FILE_FACTORY_H
 #define	RESOURCE_FILE_FACTORY_H
 
+#include <condition_variable>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+#include "DataType.h"
 #include "ResourceFileId.h"
 
 
@@ -22,6 +39,95 @@ namespace nut
 class IResourceFile;
 typedef IResourceFile* (*CreateResourceFileFunc)(const std::string& path);
 
+/** 
+ * State of an asynchronous load.
+ */
+enum class LoadStatus
+{
+    Queued,
+    Loading,
+    Done,
+    Failed,    /**< Unknown file type, or the file has no resources. */
+    Cancelled
+};
+
+/** 
+ * Thread a load's completion callback runs on.
+ */
+enum class CallbackThread
+{
+    Loader,    /**< The loader thread, as soon as the file is loaded. */
+    Dispatch   /**< The thread calling @ResourceFileFactory::dispatchCallbacks(). */
+};
+
+/** 
+ * Completion callback: the file is nullptr if the load failed. It's not called
+ * for cancelled loads.
+ */
+typedef std::function< void(const std::string& path, const std::shared_ptr< IResourceFile >& file) > LoadCallback;
+
+struct LoadRequest;
+
+/** 
+ * \brief Handle to an asynchronous load. Copies refer to the same load.
+ */
+class LoadHandle
+{
+    public:
+
+    LoadHandle()
+    {
+
+    }
+
+    /**
+     * Check if the handle refers to a load.
+     */
+    bool isValid() const
+    {
+        return m_request != nullptr;
+    }
+
+    LoadStatus getStatus() const;
+
+    /**
+     * Check if the load is done, failed or cancelled.
+     */
+    bool isFinished() const;
+
+    /**
+     * \brief Get the loaded file without waiting.
+     * 
+     * @return The file, or nullptr if the load isn't done.
+     */
+    std::shared_ptr< IResourceFile > get() const;
+
+    /**
+     * \brief Wait for the load to finish; a callback on the loader thread has
+     * returned by then.
+     * 
+     * @return The file, or nullptr if the load failed or was cancelled.
+     */
+    std::shared_ptr< IResourceFile > wait() const;
+
+    /**
+     * \brief Cancel the load. A queued load is dropped without being run; a
+     * load already running can't be interrupted, but its file is released and
+     * its callback isn't called.
+     * 
+     * @return False if the load had already finished, or its callback on the
+     * loader thread had already started.
+     */
+    bool cancel();
+
+
+    private:
+
+    friend class ResourceFileFactory;
+
+    std::shared_ptr< LoadRequest > m_request;
+};
+
 class ResourceFileFactory
 {
     public:
@@ -32,28 +138,87 @@ class ResourceFileFactory
         return instance;
     }
 
+    /**
+     * Register the creation function of a file type. Types must be registered
+     * before any load starts.
+     */
     void registerResourceFile(ResourceFileId id, CreateResourceFileFunc create)
     {
         m_resourceFiles[id] = create;
     }
 
+    /**
+     * Create a file on the calling thread. Thread safe.
+     */
     IResourceFile* createResourceFile(const std::string& path);
 
+    /**
+     * \brief Queue a file to be created on a loader thread. Loader threads are
+     * started by the first call.
+     * 
+     * @param path File to load.
+     * @param priority Loads with a higher priority are started first; equal
+     * priorities start in submission order.
+     * @param callback Called once the file is loaded or failed to load
+     * (optional).
+     * @param thread Thread the callback runs on.
+     * @return Handle to wait for, poll or cancel the load.
+     */
+    LoadHandle loadAsync(const std::string& path, int priority = 0, const LoadCallback& callback = LoadCallback(),
+                         CallbackThread thread = CallbackThread::Dispatch);
+
+    /**
+     * \brief Run the callbacks of the loads finished since the last call, on
+     * the calling thread.
+     * 
+     * @return Number of callbacks run.
+     */
+    size_t dispatchCallbacks();
+
+    /**
+     * \brief Set the number of loader threads (one or more), restarting the
+     * running ones once they finish their current load. Must not be called
+     * from a loader thread.
+     */
+    void setNumberOfLoaderThreads(size_t count);
+
+    size_t getNumberOfLoaderThreads() const;
+
+    /**
+     * Get the number of loads queued and not started yet.
+     */
+    size_t getNumberOfQueuedLoads() const;
+
 
     private:
 
-    ResourceFileFactory()
-    {
+    friend class LoadHandle;
 
-    }
+    ResourceFileFactory();
+    ~ResourceFileFactory();
 
     // Stop the compiler generating methods of copy the object
     ResourceFileFactory(const ResourceFileFactory& copy) = delete;
     ResourceFileFactory& operator=(const ResourceFileFactory& copy) = delete;
-    
+
     ResourceFileId getResourceFileIdByExtension(const std::string& extension);
 
+    void startLoaders();
+    void stopLoaders();
+    void loaderLoop(U32 generation);
+
     std::map< ResourceFileId, CreateResourceFileFunc > m_resourceFiles;
+
+    // Asynchronous loads
+    std::vector< std::thread > m_loaders;
+    size_t m_loaderCount;                                       /**< Number of loader threads to start. */
+    std::vector< std::shared_ptr< LoadRequest > > m_queue;      /**< Heap of queued loads, by priority. */
+    std::vector< std::shared_ptr< LoadRequest > > m_dispatch;   /**< Finished loads with a callback to dispatch. */
+    U64 m_sequence;                                             /**< Submission counter, for FIFO order. */
+    mutable std::mutex m_loadMutex;                             /**< Guards the queues and the state of all requests. */
+    std::condition_variable m_loadQueued;                       /**< Signaled when a load is queued or on stop. */
+    std::condition_variable m_loadFinished;                     /**< Signaled when a load finishes. */
+    U32 m_generation;                                           /**< Bumped to stop the running loader threads. */
 };
 
 }
@@ -8,6 +8,9 @@
  * @author: Eder A. Perez.
  */
 
+#ifndef RESOURCE_FILE_ID_H
+#define	RESOURCE_FILE_ID_H
+
 namespace nut
 {
 
@@ -21,4 +24,5 @@ enum class ResourceFileId
     Unknown
 };
 
-}
\ No newline at end of file
+}
+#endif	// RESOURCE_FILE_ID_H
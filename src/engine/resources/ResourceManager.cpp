@@ -0,0 +1,330 @@
+/** 
+ * \file ResourceManager.cpp
+ * \brief Cache of resource files in front of the @ResourceFileFactory.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include "ResourceManager.h"
+#include "IResourceFile.h"
+#include "Path.h"
+
+
+namespace nut
+{
+
+/** 
+ * \brief A cached file. Guarded by the manager's mutex, except for the members
+ * set at creation.
+ */
+struct ResourceEntry
+{
+    ResourceManager* manager;
+    std::string path;                       /**< Canonical path. */
+    std::shared_ptr< IResourceFile > file;  /**< Set once loaded; nullptr if the load failed. */
+    LoadHandle load;                        /**< Asynchronous load, until it's accounted for. */
+    bool loading;                           /**< Loading on the thread that acquired it first. */
+    bool cached;                            /**< Still in the manager's table. */
+    size_t memoryUsage;                     /**< Memory counted in the manager's usage. */
+};
+
+
+
+static bool resourceEntryIsReady(const ResourceEntry& entry)
+{
+    return !entry.loading && !entry.load.isValid();
+}
+
+
+
+bool ResourceHandle::isReady() const
+{
+    std::lock_guard< std::mutex > lock(m_entry->manager->m_mutex);
+    m_entry->manager->finish(*m_entry);
+
+    return resourceEntryIsReady(*m_entry);
+}
+
+
+
+IResourceFile* ResourceHandle::get() const
+{
+    std::lock_guard< std::mutex > lock(m_entry->manager->m_mutex);
+    m_entry->manager->finish(*m_entry);
+
+    return resourceEntryIsReady(*m_entry) ? m_entry->file.get() : nullptr;
+}
+
+
+
+IResourceFile* ResourceHandle::wait() const
+{
+    ResourceManager& manager = *m_entry->manager;
+    std::unique_lock< std::mutex > lock(manager.m_mutex);
+
+    for (;;)
+    {
+        manager.finish(*m_entry);
+
+        if ( m_entry->load.isValid() )
+        {
+            LoadHandle load = m_entry->load;
+
+            lock.unlock();
+            load.wait();
+            lock.lock();
+        }
+        else if ( m_entry->loading )
+        {
+            manager.m_loaded.wait(lock);
+        }
+        else
+        {
+            return m_entry->file.get();
+        }
+    }
+}
+
+
+
+const std::string& ResourceHandle::getPath() const
+{
+    return m_entry->path;
+}
+
+
+
+ResourceManager::ResourceManager(size_t memoryBudget) : m_budget(memoryBudget), m_memoryUsage(0), m_hits(0),
+                                                        m_misses(0), m_evictions(0)
+{
+
+}
+
+
+
+ResourceHandle ResourceManager::acquire(const std::string& path)
+{
+    ResourceHandle handle = acquireEntry(path, false, 0);
+
+    // A hit can still be loading on another thread
+    handle.wait();
+
+    return handle;
+}
+
+
+
+ResourceHandle ResourceManager::acquireAsync(const std::string& path, int priority)
+{
+    return acquireEntry(path, true, priority);
+}
+
+
+
+void ResourceManager::update()
+{
+    std::lock_guard< std::mutex > lock(m_mutex);
+    std::vector< std::shared_ptr< ResourceEntry > > pending;
+    pending.swap(m_pending);
+
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        finish(*pending[i]);
+
+        if ( pending[i]->load.isValid() )
+        {
+            m_pending.push_back(pending[i]);
+        }
+    }
+
+    // The references held here would keep the entries from being evicted
+    pending.clear();
+    evict();
+}
+
+
+
+void ResourceManager::setMemoryBudget(size_t bytes)
+{
+    std::lock_guard< std::mutex > lock(m_mutex);
+    m_budget = bytes;
+    evict();
+}
+
+
+
+size_t ResourceManager::getMemoryBudget() const
+{
+    std::lock_guard< std::mutex > lock(m_mutex);
+    return m_budget;
+}
+
+
+
+ResourceManager::Statistics ResourceManager::getStatistics() const
+{
+    std::lock_guard< std::mutex > lock(m_mutex);
+    Statistics statistics;
+
+    statistics.hits = m_hits;
+    statistics.misses = m_misses;
+    statistics.evictions = m_evictions;
+    statistics.resources = m_table.size();
+    statistics.memoryUsage = m_memoryUsage;
+
+    return statistics;
+}
+
+
+
+void ResourceManager::resetStatistics()
+{
+    std::lock_guard< std::mutex > lock(m_mutex);
+    m_hits = 0;
+    m_misses = 0;
+    m_evictions = 0;
+}
+
+
+
+ResourceHandle ResourceManager::acquireEntry(const std::string& path, bool async, int priority)
+{
+    std::string key = Path::getCanonicalPath(path);
+    std::unique_lock< std::mutex > lock(m_mutex);
+    std::unordered_map< std::string, EntryList::iterator >::iterator it = m_table.find(key);
+    ResourceHandle handle;
+
+    if ( it != m_table.end() )
+    {
+        ++m_hits;
+
+        // Most recently acquired first
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        handle.m_entry = *it->second;
+        finish(*handle.m_entry);
+
+        return handle;
+    }
+
+    ++m_misses;
+
+    std::shared_ptr< ResourceEntry > entry = std::make_shared< ResourceEntry >();
+    entry->manager = this;
+    entry->path = key;
+    entry->loading = !async;
+    entry->cached = true;
+    entry->memoryUsage = 0;
+
+    m_entries.push_front(entry);
+    m_table[key] = m_entries.begin();
+    handle.m_entry = entry;
+
+    if ( async )
+    {
+        entry->load = ResourceFileFactory::getInstance().loadAsync(key, priority);
+        m_pending.push_back(entry);
+    }
+    else
+    {
+        // Other threads acquiring the file wait for this load
+        lock.unlock();
+
+        std::shared_ptr< IResourceFile > file( ResourceFileFactory::getInstance().createResourceFile(key) );
+
+        if ( file != nullptr && file->getNumberOfResources() == 0 )
+        {
+            file.reset();
+        }
+
+        lock.lock();
+
+        entry->file = file;
+        entry->loading = false;
+        account(*entry);
+        m_loaded.notify_all();
+    }
+
+    evict();
+
+    return handle;
+}
+
+
+
+void ResourceManager::finish(ResourceEntry& entry)
+{
+    if ( entry.load.isValid() && entry.load.isFinished() )
+    {
+        entry.file = entry.load.get();
+        entry.load = LoadHandle();
+        account(entry);
+    }
+}
+
+
+
+void ResourceManager::account(ResourceEntry& entry)
+{
+    if ( entry.file == nullptr )
+    {
+        // Failed loads aren't cached, so that they can be retried
+        uncache(entry);
+        return;
+    }
+
+    if ( entry.cached )
+    {
+        entry.memoryUsage = entry.file->getMemoryUsage();
+        m_memoryUsage += entry.memoryUsage;
+    }
+}
+
+
+
+void ResourceManager::uncache(ResourceEntry& entry)
+{
+    if ( !entry.cached )
+    {
+        return;
+    }
+
+    std::unordered_map< std::string, EntryList::iterator >::iterator it = m_table.find(entry.path);
+    EntryList::iterator position = it->second;
+
+    entry.cached = false;
+    m_memoryUsage -= entry.memoryUsage;
+    entry.memoryUsage = 0;
+    m_table.erase(it);
+
+    // Last, as the entry might only be referenced by the list
+    m_entries.erase(position);
+}
+
+
+
+void ResourceManager::evict()
+{
+    EntryList::iterator it = m_entries.end();
+
+    while ( m_memoryUsage > m_budget && it != m_entries.begin() )
+    {
+        --it;
+        ResourceEntry& entry = **it;
+
+        // Referenced only by the cache
+        if ( it->use_count() == 1 && resourceEntryIsReady(entry) )
+        {
+            EntryList::iterator next = it;
+            ++next;
+
+            uncache(entry);
+            ++m_evictions;
+            it = next;
+        }
+    }
+}
+
+}
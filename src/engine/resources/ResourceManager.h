@@ -0,0 +1,189 @@
+/** 
+ * \file ResourceManager.h
+ * \brief Cache of resource files in front of the @ResourceFileFactory.
+ * 
+ * Files are keyed by their canonical path (@Path::getCanonicalPath()), so a
+ * file is loaded once however its path is spelled, and shared through
+ * reference counted @ResourceHandle objects. Asking for a file that is still
+ * loading returns a handle to the same load.
+ * 
+ * Files nobody holds a handle to stay cached until the memory they use
+ * (@IResourceFile::getMemoryUsage()) exceeds the budget; the least recently
+ * acquired ones are evicted first. Files with handles are never evicted, so
+ * the budget can be exceeded while they are in use.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef RESOURCE_MANAGER_H
+#define	RESOURCE_MANAGER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "DataType.h"
+#include "ResourceFileFactory.h"
+
+
+namespace nut
+{
+
+class IResourceFile;
+class ResourceManager;
+struct ResourceEntry;
+
+/** 
+ * \brief Reference to a file of a @ResourceManager. The file stays cached while
+ * a copy of the handle exists. Handles must not outlive their manager.
+ */
+class ResourceHandle
+{
+    public:
+
+    ResourceHandle()
+    {
+
+    }
+
+    /**
+     * Check if the handle refers to a file.
+     */
+    bool isValid() const
+    {
+        return m_entry != nullptr;
+    }
+
+    /**
+     * Check if the file finished loading (successfully or not).
+     */
+    bool isReady() const;
+
+    /**
+     * \brief Get the file without waiting.
+     * 
+     * @return The file, or nullptr while it's loading or if it failed to load.
+     */
+    IResourceFile* get() const;
+
+    /**
+     * \brief Wait for the file to finish loading.
+     * 
+     * @return The file, or nullptr if it failed to load.
+     */
+    IResourceFile* wait() const;
+
+    /**
+     * Get the canonical path of the file.
+     */
+    const std::string& getPath() const;
+
+
+    private:
+
+    friend class ResourceManager;
+
+    std::shared_ptr< ResourceEntry > m_entry;
+};
+
+class ResourceManager
+{
+    public:
+
+    /**
+     * \brief Cache counters.
+     */
+    struct Statistics
+    {
+        U64 hits;             /**< Acquisitions of a cached or loading file. */
+        U64 misses;           /**< Acquisitions that started a load. */
+        U64 evictions;        /**< Files evicted to stay within the budget. */
+        size_t resources;     /**< Files cached, loading ones included. */
+        size_t memoryUsage;   /**< Memory used by the cached files, in bytes. */
+    };
+
+    /**
+     * \brief Constructor.
+     * 
+     * @param memoryBudget Memory the unreferenced files can use before being
+     * evicted, in bytes (no limit by default).
+     */
+    ResourceManager(size_t memoryBudget = SIZE_MAX);
+
+    /**
+     * \brief Get a file, loading it on the calling thread on a miss.
+     * 
+     * @param path Path of the file, in any spelling.
+     * @return Handle to the file; check @ResourceHandle::get() for failures.
+     */
+    ResourceHandle acquire(const std::string& path);
+
+    /**
+     * \brief Get a file, loading it on the loader threads of the
+     * @ResourceFileFactory on a miss (see @ResourceFileFactory::loadAsync()).
+     * 
+     * @param path Path of the file, in any spelling.
+     * @param priority Priority of the load, if one is started.
+     * @return Handle to the file, ready or not.
+     */
+    ResourceHandle acquireAsync(const std::string& path, int priority = 0);
+
+    /**
+     * \brief Account for the loads finished since the last call and evict
+     * unreferenced files over the budget; call once per frame.
+     */
+    void update();
+
+    /**
+     * Set the memory budget, in bytes, evicting unreferenced files over it.
+     */
+    void setMemoryBudget(size_t bytes);
+
+    size_t getMemoryBudget() const;
+
+    Statistics getStatistics() const;
+
+    /**
+     * Reset the hit, miss and eviction counters.
+     */
+    void resetStatistics();
+
+
+    private:
+
+    friend class ResourceHandle;
+
+    typedef std::list< std::shared_ptr< ResourceEntry > > EntryList;
+
+    // Stop the compiler generating methods of copy the object
+    ResourceManager(const ResourceManager& copy) = delete;
+    ResourceManager& operator=(const ResourceManager& copy) = delete;
+
+    ResourceHandle acquireEntry(const std::string& path, bool async, int priority);
+    void finish(ResourceEntry& entry);
+    void account(ResourceEntry& entry);
+    void uncache(ResourceEntry& entry);
+    void evict();
+
+
+    size_t m_budget;
+    size_t m_memoryUsage;                                           /**< Memory used by the loaded files. */
+    U64 m_hits;
+    U64 m_misses;
+    U64 m_evictions;
+    EntryList m_entries;                                            /**< Cached files, most recently acquired first. */
+    std::unordered_map< std::string, EntryList::iterator > m_table; /**< Cached files by canonical path. */
+    std::vector< std::shared_ptr< ResourceEntry > > m_pending;      /**< Files loading asynchronously. */
+    mutable std::mutex m_mutex;                                     /**< Guards the cache and the state of all entries. */
+    std::condition_variable m_loaded;                               /**< Signaled when a synchronous load finishes. */
+};
+
+}
+#endif	// RESOURCE_MANAGER_H
@@ -0,0 +1,1327 @@
+/** 
+ * \file BVH.cpp
+ * \brief Bounding volume hierarchy over the triangles of a mesh.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include "BVH.h"
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    static_assert(sizeof(BVH::Node) == 32, "BVH::Node must take 32 bytes");
+
+    const U32 BVH::MAX_LEAF_SIZE;
+    const U32 BVH::PACKET_SIZE;
+    const U32 BVH::NO_HIT;
+
+    static const int BVH_BINS = 16;                      /**< SAH candidate planes per axis, plus one. */
+    static const float BVH_TRAVERSAL_COST = 1.0f;        /**< Cost of visiting a node, relative to a triangle test. */
+    static const U32 BVH_MIN_SPLIT_SIZE = 4;             /**< Smaller nodes are always leaves (tested in one SIMD batch). */
+    static const U32 BVH_TASK_SIZE = 8 * 1024;           /**< Larger subtrees are built as separate tasks. */
+    static const U32 BVH_PARALLEL_BIN_SIZE = 128 * 1024; /**< Larger nodes are binned in parallel. */
+    static const U32 BVH_MAX_SAH_DEPTH = 64;             /**< Deeper nodes are split in the middle of their range. */
+    static const int BVH_STACK_SIZE = 128;               /**< Traversal stack entries, more than the maximum depth. */
+    static const int BVH_PACKET_REGISTERS = int(BVH::PACKET_SIZE) / SIMDFloat::WIDTH;
+    static const int BVH_SWEEP_ITERATIONS = 32;          /**< Advancement steps per triangle; lanes still closing in after the last one stop there. */
+
+
+
+    /**
+     * \brief Triangle bounds and index, moved around while partitioning so the
+     * build reads memory sequentially.
+     */
+    struct BVHPrimitive
+    {
+        BoundingBox bounds;
+        U32 index;
+        U32 padding;
+
+        Vec3f getCentroid() const
+        {
+            return bounds.getCenter();
+        }
+    };
+
+    /**
+     * \brief SAH bin: bounds of the primitives in it.
+     */
+    struct BVHBin
+    {
+        BoundingBox bounds;
+        U32 count;
+
+        BVHBin() : count(0)
+        {
+        }
+
+        void merge(const BVHBin& b)
+        {
+            bounds.merge(b.bounds);
+            count += b.count;
+        }
+    };
+
+    /**
+     * \brief Bins of the three axes.
+     */
+    struct BVHBinning
+    {
+        BVHBin bins[3][BVH_BINS];
+
+        void merge(const BVHBinning& b)
+        {
+            for (int a = 0; a < 3; ++a)
+            {
+                for (int i = 0; i < BVH_BINS; ++i)
+                {
+                    bins[a][i].merge(b.bins[a][i]);
+                }
+            }
+        }
+    };
+
+    /**
+     * \brief Maps centroid coordinates to bins.
+     */
+    struct BVHBinMapping
+    {
+        float min[3];
+        float scale[3]; /**< Zero on axes where all centroids coincide. */
+
+        BVHBinMapping(const BoundingBox& centroidBounds)
+        {
+            const float a[3] = { centroidBounds.min.x, centroidBounds.min.y, centroidBounds.min.z };
+            const float b[3] = { centroidBounds.max.x, centroidBounds.max.y, centroidBounds.max.z };
+
+            for (int i = 0; i < 3; ++i)
+            {
+                float extent = b[i] - a[i];
+                min[i] = a[i];
+                scale[i] = extent > 0.0f ? float(BVH_BINS) / extent : 0.0f;
+            }
+        }
+
+        int bin(float v, int axis) const
+        {
+            int i = int((v - min[axis]) * scale[axis]);
+            return i < BVH_BINS - 1 ? i : BVH_BINS - 1;
+        }
+
+        int bin(const Vec3f& c, int axis) const
+        {
+            return bin(axis == 0 ? c.x : (axis == 1 ? c.y : c.z), axis);
+        }
+    };
+
+    /**
+     * \brief State shared by the build tasks. Each task owns the range of
+     * @primitives of its subtree, so tasks never write to the same data.
+     */
+    struct BVHBuilder
+    {
+        BVHPrimitive* primitives;
+        BVHPrimitive* scratch; /**< Same size as @primitives. */
+        BVH::Node* nodes; /**< Preallocated with room for the worst case. */
+        std::atomic<U32> nodeCount;
+
+        /**
+         * Bin the primitives [first, first + count) along the three axes.
+         */
+        void bin(U32 first, U32 count, const BVHBinMapping& mapping, BVHBinning& binning)
+        {
+            if (count < BVH_PARALLEL_BIN_SIZE)
+            {
+                binRange(first, first + count, mapping, binning);
+                return;
+            }
+
+            const size_t grain = BVH_PARALLEL_BIN_SIZE / 4;
+            std::vector<BVHBinning> partial((count + grain - 1) / grain);
+
+            ThreadPool::getInstance().parallelFor(count, grain, [&](size_t begin, size_t end)
+            {
+                binRange(U32(first + begin), U32(first + end), mapping, partial[begin / grain]);
+            });
+
+            for (size_t i = 0; i < partial.size(); ++i)
+            {
+                binning.merge(partial[i]);
+            }
+        }
+
+        void binRange(U32 begin, U32 end, const BVHBinMapping& mapping, BVHBinning& binning)
+        {
+            for (U32 i = begin; i < end; ++i)
+            {
+                const BVHPrimitive& p = primitives[i];
+                Vec3f c = p.getCentroid();
+                BVHBin& bx = binning.bins[0][mapping.bin(c.x, 0)];
+                BVHBin& by = binning.bins[1][mapping.bin(c.y, 1)];
+                BVHBin& bz = binning.bins[2][mapping.bin(c.z, 2)];
+
+                bx.bounds.merge(p.bounds);
+                ++bx.count;
+                by.bounds.merge(p.bounds);
+                ++by.count;
+                bz.bounds.merge(p.bounds);
+                ++bz.count;
+            }
+        }
+
+        /**
+         * Move the primitives of [first, first + count) whose centroid falls
+         * in a bin below @split to the front, accumulating the centroid bounds
+         * of both sides on the way. Goes through @scratch so the loop has no
+         * data dependent branches.
+         * 
+         * @param leftCount Number of primitives that go to the front, known from the bins.
+         */
+        void partition(U32 first, U32 count, U32 leftCount, const BVHBinMapping& mapping, int axis, int split,
+                       BoundingBox& leftCentroids, BoundingBox& rightCentroids)
+        {
+            BVHPrimitive* source = primitives + first;
+            BVHPrimitive* target = scratch + first;
+            BoundingBox* centroids[2] = { &rightCentroids, &leftCentroids };
+            U32 left = 0, right = leftCount;
+
+            for (U32 i = 0; i < count; ++i)
+            {
+                Vec3f c = source[i].getCentroid();
+                U32 isLeft = mapping.bin(c, axis) < split;
+
+                target[isLeft ? left : right] = source[i];
+                centroids[isLeft]->expand(c);
+                left += isLeft;
+                right += isLeft ^ 1;
+            }
+
+            std::copy(target, target + count, source);
+        }
+
+
+
+        /**
+         * Build the subtree of @nodeIndex over the primitives [first, first + count).
+         * 
+         * @param bounds Bounds of the primitives.
+         * @param centroidBounds Bounds of their centroids.
+         * @param depth Depth of the node.
+         */
+        void build(U32 nodeIndex, U32 first, U32 count, const BoundingBox& bounds, const BoundingBox& centroidBounds,
+                   U32 depth)
+        {
+            BVH::Node& node = nodes[nodeIndex];
+            node.bounds = bounds;
+            node.index = first;
+            node.count = count;
+
+            if (count <= BVH_MIN_SPLIT_SIZE && count <= BVH::MAX_LEAF_SIZE)
+            {
+                return;
+            }
+
+            // Find the cheapest bin boundary
+            BVHBinMapping mapping(centroidBounds);
+            BVHBinning binning;
+            int bestAxis = -1;
+            int bestSplit = 0;
+            float bestCost = FLT_MAX;
+
+            // Past the SAH depth limit ranges are halved, which bounds the depth
+            const bool sah = depth < BVH_MAX_SAH_DEPTH;
+
+            if (sah)
+            {
+                bin(first, count, mapping, binning);
+            }
+
+            for (int a = 0; a < 3 && sah; ++a)
+            {
+                if (mapping.scale[a] == 0.0f)
+                {
+                    continue;
+                }
+
+                const BVHBin* bins = binning.bins[a];
+                float leftArea[BVH_BINS];
+                U32 leftCount[BVH_BINS];
+                BoundingBox accumulated;
+                U32 n = 0;
+
+                for (int i = 0; i < BVH_BINS - 1; ++i)
+                {
+                    accumulated.merge(bins[i].bounds);
+                    n += bins[i].count;
+                    leftArea[i] = accumulated.getSurfaceArea();
+                    leftCount[i] = n;
+                }
+
+                accumulated = BoundingBox();
+                n = 0;
+
+                for (int i = BVH_BINS - 1; i > 0; --i)
+                {
+                    accumulated.merge(bins[i].bounds);
+                    n += bins[i].count;
+
+                    if (n == 0 || leftCount[i - 1] == 0)
+                    {
+                        continue;
+                    }
+
+                    float cost = leftArea[i - 1] * float(leftCount[i - 1]) + accumulated.getSurfaceArea() * float(n);
+
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = a;
+                        bestSplit = i;
+                    }
+                }
+            }
+
+            U32 leftCount;
+            BVHBin left, right;
+            BoundingBox leftCentroids, rightCentroids;
+
+            if (bestAxis < 0)
+            {
+                // All centroids coincide (no split is better than another) or the tree is too deep
+                if (count <= BVH::MAX_LEAF_SIZE)
+                {
+                    return;
+                }
+
+                leftCount = count / 2;
+                left.bounds = right.bounds = bounds;
+                leftCentroids = rightCentroids = centroidBounds;
+            }
+            else
+            {
+                float area = bounds.getSurfaceArea();
+                float splitCost = area > 0.0f ? BVH_TRAVERSAL_COST + bestCost / area : FLT_MAX;
+
+                if (splitCost >= float(count) && count <= BVH::MAX_LEAF_SIZE)
+                {
+                    return;
+                }
+
+                // Children bounds come straight from the bins
+                for (int i = 0; i < BVH_BINS; ++i)
+                {
+                    (i < bestSplit ? left : right).merge(binning.bins[bestAxis][i]);
+                }
+
+                leftCount = left.count;
+                partition(first, count, leftCount, mapping, bestAxis, bestSplit, leftCentroids, rightCentroids);
+            }
+
+            U32 child = nodeCount.fetch_add(2);
+            node.index = child;
+            node.count = 0;
+
+            if (count > BVH_TASK_SIZE)
+            {
+                ThreadPool::getInstance().parallelInvoke(
+                    [&]() { build(child, first, leftCount, left.bounds, leftCentroids, depth + 1); },
+                    [&]() { build(child + 1, first + leftCount, count - leftCount, right.bounds, rightCentroids, depth + 1); });
+            }
+            else
+            {
+                build(child, first, leftCount, left.bounds, leftCentroids, depth + 1);
+                build(child + 1, first + leftCount, count - leftCount, right.bounds, rightCentroids, depth + 1);
+            }
+        }
+    };
+
+
+
+    /**
+     * \brief Ray prepared for traversal: the inverse direction has no
+     * infinities, so the slab test needs no special cases.
+     */
+    struct BVHRay
+    {
+        float origin[3];
+        float invDirection[3];
+
+        BVHRay(const Ray& ray)
+        {
+            const float d[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+            origin[0] = ray.origin.x;
+            origin[1] = ray.origin.y;
+            origin[2] = ray.origin.z;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                invDirection[k] = 1.0f / (d[k] != 0.0f ? d[k] : std::copysign(1e-30f, d[k]));
+            }
+        }
+
+        /**
+         * Slab test; @t receives the entry distance.
+         */
+        bool intersects(const BoundingBox& box, float tMin, float tMax, float& t) const
+        {
+            const float lo[3] = { box.min.x, box.min.y, box.min.z };
+            const float hi[3] = { box.max.x, box.max.y, box.max.z };
+
+            for (int k = 0; k < 3; ++k)
+            {
+                float t1 = (lo[k] - origin[k]) * invDirection[k];
+                float t2 = (hi[k] - origin[k]) * invDirection[k];
+                tMin = std::max(tMin, std::min(t1, t2));
+                tMax = std::min(tMax, std::max(t1, t2));
+            }
+
+            t = tMin;
+            return tMin <= tMax;
+        }
+
+        /**
+         * Slab test against a box grown by @margin on each axis.
+         */
+        bool intersects(const BoundingBox& box, const float* margin, float tMin, float tMax, float& t) const
+        {
+            const float lo[3] = { box.min.x - margin[0], box.min.y - margin[1], box.min.z - margin[2] };
+            const float hi[3] = { box.max.x + margin[0], box.max.y + margin[1], box.max.z + margin[2] };
+
+            for (int k = 0; k < 3; ++k)
+            {
+                float t1 = (lo[k] - origin[k]) * invDirection[k];
+                float t2 = (hi[k] - origin[k]) * invDirection[k];
+                tMin = std::max(tMin, std::min(t1, t2));
+                tMax = std::min(tMax, std::max(t1, t2));
+            }
+
+            t = tMin;
+            return tMin <= tMax;
+        }
+    };
+
+
+
+    /**
+     * \brief @BVH::PACKET_SIZE rays in SIMD registers, with their closest hits.
+     * Lanes of rays that are done (or don't exist) have a negative tMax, so they
+     * fail every test.
+     */
+    struct BVHPacket
+    {
+        SIMDFloat origin[BVH_PACKET_REGISTERS][3];
+        SIMDFloat direction[BVH_PACKET_REGISTERS][3];
+        SIMDFloat invDirection[BVH_PACKET_REGISTERS][3];
+        SIMDFloat tMin[BVH_PACKET_REGISTERS];
+        SIMDFloat tMax[BVH_PACKET_REGISTERS];
+        SIMDFloat u[BVH_PACKET_REGISTERS];
+        SIMDFloat v[BVH_PACKET_REGISTERS];
+        SIMDInt triangle[BVH_PACKET_REGISTERS];
+        SIMDFloat hit[BVH_PACKET_REGISTERS]; /**< Mask of the lanes that hit something. */
+        float sign[3];                       /**< Summed direction, to visit children front to back. */
+
+        BVHPacket(const Ray* rays, size_t count)
+        {
+            ALIGNED_ALLOC_DECL(float, lanes[8][BVH::PACKET_SIZE], NUT_SIMD_ALIGNMENT);
+
+            sign[0] = sign[1] = sign[2] = 0.0f;
+
+            for (size_t i = 0; i < BVH::PACKET_SIZE; ++i)
+            {
+                const Ray& ray = rays[i < count ? i : 0];
+                const float o[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+                const float d[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    lanes[k][i] = o[k];
+                    lanes[3 + k][i] = d[k];
+                    sign[k] += i < count ? d[k] : 0.0f;
+                }
+
+                lanes[6][i] = ray.tMin;
+                lanes[7][i] = i < count ? ray.tMax : -FLT_MAX;
+            }
+
+            for (int r = 0; r < BVH_PACKET_REGISTERS; ++r)
+            {
+                const int offset = r * SIMDFloat::WIDTH;
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    origin[r][k] = SIMDFloat::load(lanes[k] + offset);
+                    direction[r][k] = SIMDFloat::load(lanes[3 + k] + offset);
+
+                    // Replace zeros so slab tests never compute 0 * inf
+                    SIMDFloat d = direction[r][k];
+                    SIMDFloat tiny = (d & SIMDFloat(-0.0f)) | SIMDFloat(1e-30f);
+                    invDirection[r][k] = SIMDFloat(1.0f) / SIMDFloat::select(d == SIMDFloat(0.0f), tiny, d);
+                }
+
+                tMin[r] = SIMDFloat::load(lanes[6] + offset);
+                tMax[r] = SIMDFloat::load(lanes[7] + offset);
+                u[r] = v[r] = SIMDFloat(0.0f);
+                triangle[r] = SIMDInt(-1);
+                hit[r] = SIMDFloat(0.0f) != SIMDFloat(0.0f);
+            }
+        }
+
+        /**
+         * Check if any active ray hits a box.
+         */
+        bool intersects(const BoundingBox& box) const
+        {
+            const SIMDFloat lo[3] = { SIMDFloat(box.min.x), SIMDFloat(box.min.y), SIMDFloat(box.min.z) };
+            const SIMDFloat hi[3] = { SIMDFloat(box.max.x), SIMDFloat(box.max.y), SIMDFloat(box.max.z) };
+
+            for (int r = 0; r < BVH_PACKET_REGISTERS; ++r)
+            {
+                SIMDFloat tNear = tMin[r], tFar = tMax[r];
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    SIMDFloat t1 = (lo[k] - origin[r][k]) * invDirection[r][k];
+                    SIMDFloat t2 = (hi[k] - origin[r][k]) * invDirection[r][k];
+                    tNear = SIMDFloat::max(tNear, SIMDFloat::min(t1, t2));
+                    tFar = SIMDFloat::min(tFar, SIMDFloat::max(t1, t2));
+                }
+
+                if (SIMDFloat::any(tNear <= tFar))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    };
+
+
+
+    BVH::BVH()
+    {
+    }
+
+
+
+    bool BVH::build(const Mesh& mesh)
+    {
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+        const std::vector<int>& triangulation = mesh.getTriangulation();
+
+        if (vertices.empty() || triangulation.size() < 3)
+        {
+            std::cerr << "nut::BVH::build error. Mesh has no triangles.\n";
+            return false;
+        }
+
+        return build(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float),
+                     &triangulation[0], triangulation.size() / 3);
+    }
+
+
+
+    bool BVH::build(const float* positions, size_t vertexCount, size_t stride, const int* indices, size_t triangleCount)
+    {
+        _nodes.clear();
+        _indices.clear();
+        _packs.clear();
+
+        if (triangleCount == 0 || vertexCount == 0)
+        {
+            std::cerr << "nut::BVH::build error. No triangles.\n";
+            return false;
+        }
+
+        for (size_t i = 0; i < 3 * triangleCount; ++i)
+        {
+            if (indices[i] < 0 || size_t(indices[i]) >= vertexCount)
+            {
+                std::cerr << "nut::BVH::build error. Invalid vertex index " << indices[i] << ".\n";
+                return false;
+            }
+        }
+
+        std::vector<BoundingBox> boxes(triangleCount);
+
+        ThreadPool::getInstance().parallelFor(triangleCount, 16 * 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t < end; ++t)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    const float* v = positions + size_t(indices[3 * t + k]) * stride;
+                    boxes[t].expand(Vec3f(v[0], v[1], v[2]));
+                }
+            }
+        });
+
+        buildNodes(&boxes[0], triangleCount, _nodes, _indices);
+
+        // The packs store edges, so the bounds are recomputed from the
+        // vertices the queries actually test
+        _copyTriangles(positions, stride, indices);
+        _refitNodes();
+
+        return true;
+    }
+
+
+
+    void BVH::buildNodes(const BoundingBox* boxes, size_t count, std::vector<Node>& nodes, std::vector<U32>& indices)
+    {
+        nodes.clear();
+        indices.clear();
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        std::vector<BVHPrimitive> primitives(count), scratch(count);
+        const size_t grain = 16 * 1024;
+        std::vector<BVHBin> partial((count + grain - 1) / grain);
+        std::vector<BoundingBox> centroids(partial.size());
+
+        ThreadPool::getInstance().parallelFor(count, grain, [&](size_t begin, size_t end)
+        {
+            BVHBin& bin = partial[begin / grain];
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                BVHPrimitive& p = primitives[i];
+                p.bounds = boxes[i];
+                p.index = U32(i);
+                bin.bounds.merge(p.bounds);
+                ++bin.count;
+                centroids[begin / grain].expand(p.getCentroid());
+            }
+        });
+
+        BVHBin root;
+        BoundingBox rootCentroids;
+
+        for (size_t i = 0; i < partial.size(); ++i)
+        {
+            root.merge(partial[i]);
+            rootCentroids.merge(centroids[i]);
+        }
+
+        // A binary tree with N leaves has 2N - 1 nodes
+        nodes.resize(2 * count - 1);
+
+        BVHBuilder builder;
+        builder.primitives = &primitives[0];
+        builder.scratch = &scratch[0];
+        builder.nodes = &nodes[0];
+        builder.nodeCount = 1;
+        builder.build(0, 0, U32(count), root.bounds, rootCentroids, 0);
+
+        nodes.resize(builder.nodeCount.load());
+        indices.resize(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            indices[i] = primitives[i].index;
+        }
+    }
+
+
+
+    bool BVH::refit(const Mesh& mesh)
+    {
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+        const std::vector<int>& triangulation = mesh.getTriangulation();
+
+        if (isEmpty())
+        {
+            std::cerr << "nut::BVH::refit error. The tree is empty.\n";
+            return false;
+        }
+
+        if (vertices.empty() || triangulation.size() != 3 * _indices.size())
+        {
+            std::cerr << "nut::BVH::refit error. Mesh has " << triangulation.size() / 3 << " triangles, the tree "
+                      << _indices.size() << ".\n";
+            return false;
+        }
+
+        return refit(&vertices[0].pos.x, sizeof(Vertex) / sizeof(float), &triangulation[0]);
+    }
+
+
+
+    bool BVH::refit(const float* positions, size_t stride, const int* indices)
+    {
+        if (isEmpty())
+        {
+            std::cerr << "nut::BVH::refit error. The tree is empty.\n";
+            return false;
+        }
+
+        _copyTriangles(positions, stride, indices);
+        _refitNodes();
+
+        return true;
+    }
+
+
+
+    void BVH::query(const BoundingBox& box, std::vector<U32>& triangles) const
+    {
+        if (isEmpty())
+        {
+            return;
+        }
+
+        std::vector<U32> stack;
+        stack.reserve(64);
+        stack.push_back(0);
+
+        while (!stack.empty())
+        {
+            const Node& node = _nodes[stack.back()];
+            stack.pop_back();
+
+            if (!node.bounds.overlaps(box))
+            {
+                continue;
+            }
+
+            if (node.isLeaf())
+            {
+                for (U32 i = node.index; i < node.index + node.count; ++i)
+                {
+                    const Triangle triangle = getTriangle(i);
+                    BoundingBox t;
+                    t.expand(triangle.v0);
+                    t.expand(triangle.v1);
+                    t.expand(triangle.v2);
+
+                    if (t.overlaps(box))
+                    {
+                        triangles.push_back(_indices[i]);
+                    }
+                }
+            }
+            else
+            {
+                stack.push_back(node.index + 1);
+                stack.push_back(node.index);
+            }
+        }
+    }
+
+
+
+    bool BVH::intersect(const Ray& ray, Hit& hit) const
+    {
+        return _trace(ray, hit, false);
+    }
+
+
+
+    void BVH::intersect(const Ray* rays, Hit* hits, size_t count) const
+    {
+        ThreadPool::getInstance().parallelFor((count + PACKET_SIZE - 1) / PACKET_SIZE, 64, [&](size_t begin, size_t end)
+        {
+            for (size_t p = begin; p < end; ++p)
+            {
+                size_t first = p * PACKET_SIZE;
+                size_t n = count - first < PACKET_SIZE ? count - first : PACKET_SIZE;
+                _tracePacket(rays + first, n, hits + first, nullptr);
+            }
+        });
+    }
+
+
+
+    bool BVH::occluded(const Ray& ray) const
+    {
+        Hit hit;
+        return _trace(ray, hit, true);
+    }
+
+
+
+    void BVH::occluded(const Ray* rays, bool* occluded, size_t count) const
+    {
+        ThreadPool::getInstance().parallelFor((count + PACKET_SIZE - 1) / PACKET_SIZE, 64, [&](size_t begin, size_t end)
+        {
+            for (size_t p = begin; p < end; ++p)
+            {
+                size_t first = p * PACKET_SIZE;
+                size_t n = count - first < PACKET_SIZE ? count - first : PACKET_SIZE;
+                _tracePacket(rays + first, n, nullptr, occluded + first);
+            }
+        });
+    }
+
+
+
+    bool BVH::sweep(const Sweep& sweep, SweepHit& hit) const
+    {
+        hit.t = 1.0f;
+        hit.point = hit.normal = Vec3f(0.0f, 0.0f, 0.0f);
+        hit.triangle = NO_HIT;
+
+        // Nodes are grown by the half extents of the shape's box, which then moves as a point
+        const Vec3f& a = sweep.axis.a;
+        const Vec3f& b = sweep.axis.b;
+        const float reach = sweep.radius + sweep.tolerance;
+        const float margin[3] = { 0.5f * std::fabs(b.x - a.x) + reach, 0.5f * std::fabs(b.y - a.y) + reach,
+                                  0.5f * std::fabs(b.z - a.z) + reach };
+        const BVHRay ray(Ray((a + b) * 0.5f, sweep.motion));
+        float tEntry;
+
+        if (isEmpty() || !ray.intersects(_nodes[0].bounds, margin, 0.0f, 1.0f, tEntry))
+        {
+            return false;
+        }
+
+        struct Entry
+        {
+            U32 node;
+            float t;
+        } stack[BVH_STACK_SIZE];
+
+        const int width = SIMDFloat::WIDTH;
+        int top = 0;
+
+        stack[top].node = 0;
+        stack[top++].t = tEntry;
+
+        while (top > 0)
+        {
+            const Entry entry = stack[--top];
+
+            if (entry.t > hit.t)
+            {
+                continue;
+            }
+
+            const Node& node = _nodes[entry.node];
+
+            if (node.isLeaf())
+            {
+                const U32 end = node.index + node.count;
+
+                for (U32 p = node.index / width; p * width < end; ++p)
+                {
+                    const U32 base = p * width;
+                    const U32 lo = node.index > base ? node.index - base : 0;
+                    const U32 hi = end - base < U32(width) ? end - base : U32(width);
+
+                    _advance(sweep, p, (1 << hi) - (1 << lo), hit);
+                }
+            }
+            else
+            {
+                float tLeft, tRight;
+                bool left = ray.intersects(_nodes[node.index].bounds, margin, 0.0f, hit.t, tLeft);
+                bool right = ray.intersects(_nodes[node.index + 1].bounds, margin, 0.0f, hit.t, tRight);
+
+                if (left && right && tLeft <= tRight)
+                {
+                    stack[top].node = node.index + 1;
+                    stack[top++].t = tRight;
+                    stack[top].node = node.index;
+                    stack[top++].t = tLeft;
+                }
+                else
+                {
+                    if (left)
+                    {
+                        stack[top].node = node.index;
+                        stack[top++].t = tLeft;
+                    }
+
+                    if (right)
+                    {
+                        stack[top].node = node.index + 1;
+                        stack[top++].t = tRight;
+                    }
+                }
+            }
+        }
+
+        if (hit.triangle == NO_HIT)
+        {
+            return false;
+        }
+
+        hit.triangle = _indices[hit.triangle];
+
+        return true;
+    }
+
+
+
+    void BVH::sweep(const Sweep* sweeps, SweepHit* hits, size_t count) const
+    {
+        ThreadPool::getInstance().parallelFor(count, 64, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                sweep(sweeps[i], hits[i]);
+            }
+        });
+    }
+
+
+
+    BVH::Triangle BVH::getTriangle(size_t i) const
+    {
+        const size_t width = SIMDFloat::WIDTH;
+        const TrianglePack& pack = _packs[i / width];
+        const size_t lane = i % width;
+
+        Triangle triangle;
+        triangle.v0 = Vec3f(pack.v0[0][lane], pack.v0[1][lane], pack.v0[2][lane]);
+        triangle.v1 = triangle.v0 + Vec3f(pack.e1[0][lane], pack.e1[1][lane], pack.e1[2][lane]);
+        triangle.v2 = triangle.v0 + Vec3f(pack.e2[0][lane], pack.e2[1][lane], pack.e2[2][lane]);
+
+        return triangle;
+    }
+
+
+
+    float BVH::getCost() const
+    {
+        if (isEmpty())
+        {
+            return 0.0f;
+        }
+
+        double cost = 0.0;
+
+        for (size_t i = 0; i < _nodes.size(); ++i)
+        {
+            const Node& node = _nodes[i];
+            cost += double(node.bounds.getSurfaceArea()) * (node.isLeaf() ? double(node.count) : BVH_TRAVERSAL_COST);
+        }
+
+        float area = _nodes[0].bounds.getSurfaceArea();
+        return area > 0.0f ? float(cost / area) : 0.0f;
+    }
+
+
+
+    void BVH::_copyTriangles(const float* positions, size_t stride, const int* indices)
+    {
+        const size_t width = SIMDFloat::WIDTH;
+        const size_t count = _indices.size();
+        _packs.assign((count + width - 1) / width, TrianglePack());
+
+        ThreadPool::getInstance().parallelFor(_packs.size(), 4 * 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t p = begin; p < end; ++p)
+            {
+                for (size_t i = p * width; i < (p + 1) * width && i < count; ++i)
+                {
+                    const int* v = indices + 3 * size_t(_indices[i]);
+                    const float* p0 = positions + size_t(v[0]) * stride;
+                    const float* p1 = positions + size_t(v[1]) * stride;
+                    const float* p2 = positions + size_t(v[2]) * stride;
+
+                    _packs[p].set(int(i - p * width), Vec3f(p0[0], p0[1], p0[2]), Vec3f(p1[0], p1[1], p1[2]),
+                                  Vec3f(p2[0], p2[1], p2[2]));
+                }
+            }
+        });
+    }
+
+
+
+    void BVH::_refitNodes()
+    {
+        // Leaves in parallel, then inner nodes bottom-up (children follow their parent)
+        ThreadPool::getInstance().parallelFor(_nodes.size(), 16 * 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t n = begin; n < end; ++n)
+            {
+                Node& node = _nodes[n];
+
+                if (node.isLeaf())
+                {
+                    node.bounds = BoundingBox();
+
+                    for (U32 i = node.index; i < node.index + node.count; ++i)
+                    {
+                        const Triangle triangle = getTriangle(i);
+                        node.bounds.expand(triangle.v0);
+                        node.bounds.expand(triangle.v1);
+                        node.bounds.expand(triangle.v2);
+                    }
+                }
+            }
+        });
+
+        for (size_t n = _nodes.size(); n-- > 0;)
+        {
+            Node& node = _nodes[n];
+
+            if (!node.isLeaf())
+            {
+                node.bounds = _nodes[node.index].bounds;
+                node.bounds.merge(_nodes[node.index + 1].bounds);
+            }
+        }
+    }
+
+
+
+    bool BVH::_trace(const Ray& ray, Hit& hit, bool anyHit) const
+    {
+        hit.t = ray.tMax;
+        hit.u = hit.v = 0.0f;
+        hit.triangle = NO_HIT;
+
+        const BVHRay prepared(ray);
+        float tEntry;
+
+        if (isEmpty() || !prepared.intersects(_nodes[0].bounds, ray.tMin, ray.tMax, tEntry))
+        {
+            return false;
+        }
+
+        // Nodes to visit, with the distance where the ray enters them
+        struct Entry
+        {
+            U32 node;
+            float t;
+        } stack[BVH_STACK_SIZE];
+
+        const int width = SIMDFloat::WIDTH;
+        Ray r = ray;
+        U32 hitIndex = NO_HIT;
+        int top = 0;
+
+        stack[top].node = 0;
+        stack[top++].t = tEntry;
+
+        while (top > 0)
+        {
+            const Entry entry = stack[--top];
+
+            if (entry.t > r.tMax)
+            {
+                continue;
+            }
+
+            const Node& node = _nodes[entry.node];
+
+            if (node.isLeaf())
+            {
+                const U32 end = node.index + node.count;
+
+                for (U32 p = node.index / width; p * width < end; ++p)
+                {
+                    // Lanes of the pack that belong to the leaf
+                    const U32 base = p * width;
+                    const U32 lo = node.index > base ? node.index - base : 0;
+                    const U32 hi = end - base < U32(width) ? end - base : U32(width);
+                    SIMDFloat t, u, v;
+                    int bits = r.intersect(_packs[p], t, u, v) & ((1 << hi) - (1 << lo));
+
+                    if (bits == 0)
+                    {
+                        continue;
+                    }
+
+                    if (anyHit)
+                    {
+                        return true;
+                    }
+
+                    ALIGNED_ALLOC_DECL(float, lanes[3][SIMDFloat::WIDTH], NUT_SIMD_ALIGNMENT);
+                    t.store(lanes[0]);
+                    u.store(lanes[1]);
+                    v.store(lanes[2]);
+
+                    for (int i = 0; i < width; ++i)
+                    {
+                        if ((bits >> i & 1) && lanes[0][i] < r.tMax)
+                        {
+                            r.tMax = lanes[0][i];
+                            hit.u = lanes[1][i];
+                            hit.v = lanes[2][i];
+                            hitIndex = base + U32(i);
+                        }
+                    }
+                }
+            }
+            else
+            {
+                float tLeft, tRight;
+                bool left = prepared.intersects(_nodes[node.index].bounds, r.tMin, r.tMax, tLeft);
+                bool right = prepared.intersects(_nodes[node.index + 1].bounds, r.tMin, r.tMax, tRight);
+
+                // Push the far child first so the near one is visited next
+                if (left && right && tLeft <= tRight)
+                {
+                    stack[top].node = node.index + 1;
+                    stack[top++].t = tRight;
+                    stack[top].node = node.index;
+                    stack[top++].t = tLeft;
+                }
+                else
+                {
+                    if (left)
+                    {
+                        stack[top].node = node.index;
+                        stack[top++].t = tLeft;
+                    }
+
+                    if (right)
+                    {
+                        stack[top].node = node.index + 1;
+                        stack[top++].t = tRight;
+                    }
+                }
+            }
+        }
+
+        if (hitIndex == NO_HIT)
+        {
+            return false;
+        }
+
+        hit.t = r.tMax;
+        hit.triangle = _indices[hitIndex];
+
+        return true;
+    }
+
+
+
+    void BVH::_tracePacket(const Ray* rays, size_t count, Hit* hits, bool* occluded) const
+    {
+        const bool anyHit = occluded != nullptr;
+        const int width = SIMDFloat::WIDTH;
+        BVHPacket packet(rays, count);
+        U32 stack[BVH_STACK_SIZE];
+        int top = 0;
+
+        if (!isEmpty())
+        {
+            stack[top++] = 0;
+        }
+
+        while (top > 0)
+        {
+            const Node& node = _nodes[stack[--top]];
+
+            if (!packet.intersects(node.bounds))
+            {
+                continue;
+            }
+
+            if (node.isLeaf())
+            {
+                bool finished = anyHit;
+
+                for (U32 i = node.index; i < node.index + node.count; ++i)
+                {
+                    // One triangle against all rays
+                    const TrianglePack& pack = _packs[i / width];
+                    const int lane = int(i % width);
+                    const SIMDFloat v0[3] = { SIMDFloat(pack.v0[0][lane]), SIMDFloat(pack.v0[1][lane]), SIMDFloat(pack.v0[2][lane]) };
+                    const SIMDFloat e1[3] = { SIMDFloat(pack.e1[0][lane]), SIMDFloat(pack.e1[1][lane]), SIMDFloat(pack.e1[2][lane]) };
+                    const SIMDFloat e2[3] = { SIMDFloat(pack.e2[0][lane]), SIMDFloat(pack.e2[1][lane]), SIMDFloat(pack.e2[2][lane]) };
+
+                    for (int r = 0; r < BVH_PACKET_REGISTERS; ++r)
+                    {
+                        SIMDFloat t, u, v;
+                        SIMDFloat mask = Ray::intersect(packet.origin[r], packet.direction[r], v0, e1, e2,
+                                                        packet.tMin[r], packet.tMax[r], t, u, v);
+
+                        if (!SIMDFloat::any(mask))
+                        {
+                            continue;
+                        }
+
+                        packet.hit[r] |= mask;
+
+                        if (anyHit)
+                        {
+                            packet.tMax[r] = SIMDFloat::select(mask, SIMDFloat(-FLT_MAX), packet.tMax[r]);
+                        }
+                        else
+                        {
+                            packet.tMax[r] = SIMDFloat::select(mask, t, packet.tMax[r]);
+                            packet.u[r] = SIMDFloat::select(mask, u, packet.u[r]);
+                            packet.v[r] = SIMDFloat::select(mask, v, packet.v[r]);
+                            packet.triangle[r] = SIMDInt::select(SIMDInt::asInt(mask), SIMDInt(I32(i)), packet.triangle[r]);
+                        }
+                    }
+                }
+
+                for (int r = 0; r < BVH_PACKET_REGISTERS && finished; ++r)
+                {
+                    finished = SIMDFloat::all(packet.tMax[r] < packet.tMin[r]);
+                }
+
+                if (finished)
+                {
+                    break;
+                }
+            }
+            else
+            {
+                // Visit first the child nearer to the rays' origins
+                Vec3f offset = _nodes[node.index + 1].bounds.getCenter() - _nodes[node.index].bounds.getCenter();
+                bool rightFirst = offset.x * packet.sign[0] + offset.y * packet.sign[1] + offset.z * packet.sign[2] < 0.0f;
+
+                stack[top++] = rightFirst ? node.index : node.index + 1;
+                stack[top++] = rightFirst ? node.index + 1 : node.index;
+            }
+        }
+
+        ALIGNED_ALLOC_DECL(float, t[PACKET_SIZE], NUT_SIMD_ALIGNMENT);
+        ALIGNED_ALLOC_DECL(float, u[PACKET_SIZE], NUT_SIMD_ALIGNMENT);
+        ALIGNED_ALLOC_DECL(float, v[PACKET_SIZE], NUT_SIMD_ALIGNMENT);
+        ALIGNED_ALLOC_DECL(I32, triangle[PACKET_SIZE], NUT_SIMD_ALIGNMENT);
+        int bits = 0;
+
+        for (int r = 0; r < BVH_PACKET_REGISTERS; ++r)
+        {
+            packet.tMax[r].store(t + r * width);
+            packet.u[r].store(u + r * width);
+            packet.v[r].store(v + r * width);
+            packet.triangle[r].store(triangle + r * width);
+            bits |= SIMDFloat::movemask(packet.hit[r]) << (r * width);
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            bool hit = (bits >> i & 1) != 0;
+
+            if (anyHit)
+            {
+                occluded[i] = hit;
+                continue;
+            }
+
+            hits[i].t = hit ? t[i] : rays[i].tMax;
+            hits[i].u = hit ? u[i] : 0.0f;
+            hits[i].v = hit ? v[i] : 0.0f;
+            hits[i].triangle = hit ? _indices[triangle[i]] : NO_HIT;
+        }
+    }
+
+
+
+    void BVH::_advance(const Sweep& sweep, U32 pack, int lanes, SweepHit& hit) const
+    {
+        const TrianglePack& triangles = _packs[pack];
+        const SIMDFloat v0[3] = { SIMDFloat::loadu(triangles.v0[0]), SIMDFloat::loadu(triangles.v0[1]), SIMDFloat::loadu(triangles.v0[2]) };
+        const SIMDFloat e1[3] = { SIMDFloat::loadu(triangles.e1[0]), SIMDFloat::loadu(triangles.e1[1]), SIMDFloat::loadu(triangles.e1[2]) };
+        const SIMDFloat e2[3] = { SIMDFloat::loadu(triangles.e2[0]), SIMDFloat::loadu(triangles.e2[1]), SIMDFloat::loadu(triangles.e2[2]) };
+        const Vec3f& a = sweep.axis.a;
+        const Vec3f& b = sweep.axis.b;
+        const SIMDFloat d[3] = { SIMDFloat(b.x - a.x), SIMDFloat(b.y - a.y), SIMDFloat(b.z - a.z) };
+        const SIMDFloat m[3] = { SIMDFloat(sweep.motion.x), SIMDFloat(sweep.motion.y), SIMDFloat(sweep.motion.z) };
+        const SIMDFloat radius(sweep.radius);
+        const SIMDFloat tolerance(sweep.tolerance);
+        const SIMDFloat contact(sweep.radius + sweep.tolerance);
+        const SIMDFloat zero(0.0f);
+
+        // Lanes of the pack in @lanes
+        const SIMDInt bits = SIMDInt::sllv(SIMDInt(1), SIMDInt::sequence());
+        SIMDFloat active = SIMDFloat::asFloat((SIMDInt(lanes) & bits) == bits);
+        SIMDFloat t = zero;
+
+        for (int iteration = 0; iteration < BVH_SWEEP_ITERATIONS && SIMDFloat::any(active); ++iteration)
+        {
+            const SIMDFloat p[3] = { SIMDFloat(a.x) + m[0] * t, SIMDFloat(a.y) + m[1] * t, SIMDFloat(a.z) + m[2] * t };
+            SIMDFloat s, q[3];
+            SIMDFloat distance = SIMDFloat::sqrt(Segment::closestPoints(p, d, v0, e1, e2, s, q));
+
+            // From the closest point of the triangle to the closest point of the axis
+            SIMDFloat w[3];
+
+            for (int k = 0; k < 3; ++k)
+            {
+                w[k] = p[k] + d[k] * s - q[k];
+            }
+
+            // Speed at which the distance shrinks; the tangent step never overshoots
+            SIMDFloat closing = -(m[0] * w[0] + m[1] * w[1] + m[2] * w[2]) / SIMDFloat::max(distance, SIMDFloat(FLT_MIN));
+            SIMDFloat next = t + (distance - radius) / closing;
+
+            // Touching counts when moving closer, so shapes resting on a triangle can leave it
+            SIMDFloat penetrating = distance <= SIMDFloat::max(radius - tolerance, zero);
+            SIMDFloat touching = active & (distance <= contact) & ((closing > zero) | penetrating);
+
+            // Out of steps (grazing, or float rounding stalled the advance): stopping short is safer than tunneling
+            if (iteration == BVH_SWEEP_ITERATIONS - 1)
+            {
+                touching = touching | (active & (closing > zero) & (next <= SIMDFloat(hit.t)));
+            }
+
+            int touchingBits = SIMDFloat::movemask(touching);
+
+            if (touchingBits != 0)
+            {
+                ALIGNED_ALLOC_DECL(float, values[8][SIMDFloat::WIDTH], NUT_SIMD_ALIGNMENT);
+                t.store(values[0]);
+                distance.store(values[1]);
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    q[k].store(values[2 + k]);
+                    w[k].store(values[5 + k]);
+                }
+
+                for (int i = 0; i < SIMDFloat::WIDTH; ++i)
+                {
+                    if ((touchingBits >> i & 1) == 0 || values[0][i] >= hit.t)
+                    {
+                        continue;
+                    }
+
+                    hit.t = values[0][i];
+                    hit.point = Vec3f(values[2][i], values[3][i], values[4][i]);
+                    hit.triangle = pack * U32(SIMDFloat::WIDTH) + U32(i);
+
+                    // Overlapping shapes have no closest direction: use the face, against the motion
+                    if (values[1][i] > 1e-6f * (1.0f + sweep.radius))
+                    {
+                        hit.normal = Vec3f(values[5][i], values[6][i], values[7][i]) / values[1][i];
+                    }
+                    else
+                    {
+                        const Triangle triangle = getTriangle(hit.triangle);
+                        Vec3f n = (triangle.v1 - triangle.v0).cross(triangle.v2 - triangle.v0);
+                        float length = n.length();
+
+                        if (length > 0.0f)
+                        {
+                            hit.normal = n * (n * sweep.motion > 0.0f ? -1.0f / length : 1.0f / length);
+                        }
+                        else
+                        {
+                            length = sweep.motion.length();
+                            hit.normal = length > 0.0f ? sweep.motion * (-1.0f / length) : Vec3f(0.0f, 0.0f, 1.0f);
+                        }
+                    }
+                }
+            }
+
+            active = SIMDFloat::andnot(touching, active) & (closing > zero) & (next <= SIMDFloat(hit.t));
+            t = SIMDFloat::select(active, next, t);
+        }
+    }
+}
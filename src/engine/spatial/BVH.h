@@ -0,0 +1,353 @@
+/** 
+ * \file BVH.h
+ * \brief Bounding volume hierarchy over the triangles of a mesh.
+ * 
+ * The tree is built top-down with the binned surface area heuristic (SAH)
+ * (Wald, "On fast construction of SAH-based bounding volume hierarchies",
+ * 2007). Large nodes are binned in parallel and subtrees are built as parallel
+ * tasks on the @ThreadPool.
+ * 
+ * Nodes take 32 bytes, two per cache line; siblings are stored next to each
+ * other and children always come after their parent. Triangles are copied
+ * into the tree in leaf order, as @TrianglePack's of @SIMDFloat::WIDTH (first
+ * vertex and edges), so the tree doesn't depend on the mesh after it's built.
+ * Node bounds are computed from the packs, so they match the triangles the
+ * queries test. Deforming meshes keep the topology and call @refit().
+ * 
+ * Single rays test leaves @SIMDFloat::WIDTH triangles at a time. Batches of
+ * rays are traced in packets of 8 that share one traversal: nodes and
+ * triangles are tested against the whole packet with SIMD, which pays off for
+ * coherent rays (picking, shadow rays to an area light, lightmap texels).
+ * 
+ * Swept spheres and capsules (continuous collision detection, so fast objects
+ * don't tunnel through thin walls) use conservative advancement (Mirtich,
+ * "Timewarp rigid body simulation", 2000). Under a translation the distance to
+ * a triangle is a convex function of time, so the time where its tangent
+ * reaches the radius never overshoots the contact. Each triangle of a pack
+ * advances its own time in one SIMD lane until it touches or moves away, and
+ * the nodes are traversed as a ray against bounds grown by the shape's box.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstddef>
+#include <vector>
+#include "BoundingBox.h"
+#include "DataType.h"
+#include "Ray.h"
+#include "Segment.h"
+#include "Vector.h"
+
+
+
+namespace nut
+{
+    class Mesh;
+
+    class BVH
+    {
+        public:
+
+        /**
+         * \brief Tree node (32 bytes).
+         */
+        struct Node
+        {
+            BoundingBox bounds;
+            U32 index; /**< Inner node: left child (the right one follows it). Leaf: first triangle. */
+            U32 count; /**< Number of triangles of a leaf; zero for inner nodes. */
+
+            bool isLeaf() const
+            {
+                return count != 0;
+            }
+        };
+
+        /**
+         * \brief Triangle vertices.
+         */
+        struct Triangle
+        {
+            Vec3f v0, v1, v2;
+        };
+
+        /**
+         * \brief Closest hit of a ray.
+         */
+        struct Hit
+        {
+            float t;      /**< Hit distance; the ray's tMax if nothing was hit. */
+            float u, v;   /**< Barycentric coordinates of the second and third vertices. */
+            U32 triangle; /**< Original (mesh) index of the triangle, or @NO_HIT. */
+        };
+
+        /**
+         * \brief A sphere or capsule moving along a straight line.
+         */
+        struct Sweep
+        {
+            Segment axis;    /**< Capsule axis at the start of the motion; degenerate for a sphere. */
+            float radius;
+            Vec3f motion;    /**< Translation over the whole sweep. */
+            float tolerance; /**< The shape stops within this distance of the triangles. */
+
+            Sweep() : radius(0.0f), motion(0.0f, 0.0f, 0.0f), tolerance(1e-3f)
+            {
+            }
+
+            /**
+             * Sphere sweep.
+             */
+            Sweep(const Vec3f& center, float radius, const Vec3f& motion)
+                : axis(center, center), radius(radius), motion(motion), tolerance(1e-3f)
+            {
+            }
+
+            /**
+             * Capsule sweep.
+             */
+            Sweep(const Segment& axis, float radius, const Vec3f& motion)
+                : axis(axis), radius(radius), motion(motion), tolerance(1e-3f)
+            {
+            }
+        };
+
+        /**
+         * \brief First contact of a sweep.
+         */
+        struct SweepHit
+        {
+            float t;      /**< Time of impact, as a fraction of the motion in [0, 1]; 1 if nothing was hit. */
+            Vec3f point;  /**< Contact point on the triangle. */
+            Vec3f normal; /**< Unit contact normal, from the triangle towards the shape. */
+            U32 triangle; /**< Original (mesh) index of the triangle, or @NO_HIT. */
+        };
+
+        static const U32 MAX_LEAF_SIZE = 8;   /**< Leaves hold at most this many triangles. */
+        static const U32 PACKET_SIZE = 8;     /**< Rays traced together by the batched queries. */
+        static const U32 NO_HIT = 0xFFFFFFFF; /**< @Hit::triangle of a ray that missed. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor. Instantiates an empty tree.
+         */
+        BVH();
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Build the tree over the triangles of a mesh.
+         * 
+         * @param mesh Triangle mesh (three indices per triangle).
+         * @return False if the mesh has no triangles or has invalid indices.
+         */
+        bool build(const Mesh& mesh);
+
+        /**
+         * \brief Build the tree over indexed triangles.
+         * 
+         * @param positions Address of the first vertex position's x coordinate.
+         * @param vertexCount Number of vertices.
+         * @param stride Distance between consecutive positions, in floats.
+         * @param indices Three vertex indices per triangle.
+         * @param triangleCount Number of triangles.
+         * @return False if there are no triangles or the indices are invalid.
+         */
+        bool build(const float* positions, size_t vertexCount, size_t stride, const int* indices, size_t triangleCount);
+
+        /**
+         * \brief Build a tree over arbitrary boxes. The triangle tree and the
+         * top level of a @TLAS are both built with it.
+         * 
+         * @param boxes Bounds of the primitives.
+         * @param count Number of boxes.
+         * @param nodes Receives the nodes; the root is the first one.
+         * @param indices Receives the index of the box in each leaf slot (leaves
+         * reference the range [index, index + count) of this array).
+         */
+        static void buildNodes(const BoundingBox* boxes, size_t count, std::vector<Node>& nodes,
+                               std::vector<U32>& indices);
+
+        /**
+         * \brief Update the bounds after the vertices moved, keeping the tree
+         * topology. Much faster than a rebuild, but the tree quality degrades
+         * if the deformation is large.
+         * 
+         * @param mesh The mesh the tree was built from, with the same triangulation.
+         * @return False if the tree is empty or the mesh has a different number
+         * of triangles.
+         */
+        bool refit(const Mesh& mesh);
+
+        /**
+         * \brief Same as above, for indexed triangles.
+         * 
+         * @return False if the tree is empty.
+         */
+        bool refit(const float* positions, size_t stride, const int* indices);
+
+        /**
+         * \brief Find the triangles whose bounds overlap a box.
+         * 
+         * @param box Query box.
+         * @param triangles Receives the original indices of the triangles.
+         */
+        void query(const BoundingBox& box, std::vector<U32>& triangles) const;
+
+        /**
+         * \brief Find the closest triangle hit by a ray.
+         * 
+         * @param ray Ray; only hits within (tMin, tMax) count.
+         * @param hit Receives the closest hit.
+         * @return True if a triangle was hit.
+         */
+        bool intersect(const Ray& ray, Hit& hit) const;
+
+        /**
+         * \brief Find the closest hits of a batch of rays, traced in packets of
+         * @PACKET_SIZE and spread across the @ThreadPool.
+         * 
+         * @param rays Rays.
+         * @param hits Receives one hit per ray.
+         * @param count Number of rays.
+         */
+        void intersect(const Ray* rays, Hit* hits, size_t count) const;
+
+        /**
+         * \brief Check if a ray hits any triangle. Stops at the first hit found,
+         * so it's faster than @intersect() for visibility queries.
+         */
+        bool occluded(const Ray& ray) const;
+
+        /**
+         * \brief Visibility of a batch of rays, traced in packets of @PACKET_SIZE.
+         * 
+         * @param rays Rays.
+         * @param occluded Receives true for each ray that hits a triangle.
+         * @param count Number of rays.
+         */
+        void occluded(const Ray* rays, bool* occluded, size_t count) const;
+
+        /**
+         * \brief Find the first triangle touched by a moving sphere or capsule.
+         * 
+         * Shapes that already penetrate a triangle deeper than the tolerance
+         * hit it at time zero; shapes touching one only hit it when moving
+         * towards it. Grazing contacts that don't converge within the step
+         * budget are reported early, slightly before the actual contact.
+         * 
+         * @param sweep The shape and its motion.
+         * @param hit Receives the first contact.
+         * @return True if a triangle was hit.
+         */
+        bool sweep(const Sweep& sweep, SweepHit& hit) const;
+
+        /**
+         * \brief Find the first contacts of a batch of sweeps (e.g. all the
+         * projectiles of a frame), spread across the @ThreadPool.
+         * 
+         * @param sweeps Sweeps.
+         * @param hits Receives one hit per sweep.
+         * @param count Number of sweeps.
+         */
+        void sweep(const Sweep* sweeps, SweepHit* hits, size_t count) const;
+
+        /**
+         * Check if the tree has no nodes.
+         */
+        bool isEmpty() const
+        {
+            return _nodes.empty();
+        }
+
+        /**
+         * Get the bounds of the whole tree, or an empty box if the tree is empty.
+         */
+        BoundingBox getBounds() const
+        {
+            return isEmpty() ? BoundingBox() : _nodes[0].bounds;
+        }
+
+        /**
+         * Get the nodes; the root is the first one.
+         */
+        const std::vector<Node>& getNodes() const
+        {
+            return _nodes;
+        }
+
+        /**
+         * Get a triangle by its position in leaf order.
+         * 
+         * @param i Index in [0, getTriangleIndices().size()).
+         */
+        Triangle getTriangle(size_t i) const;
+
+        /**
+         * Get the original (mesh) index of each triangle in leaf order.
+         */
+        const std::vector<U32>& getTriangleIndices() const
+        {
+            return _indices;
+        }
+
+        /**
+         * \brief Compute the SAH cost of the tree, normalized by the root area.
+         * Lower is better; useful to compare builds.
+         */
+        float getCost() const;
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        std::vector<Node> _nodes;
+        std::vector<U32> _indices;        /**< Original index of each triangle in leaf order. */
+        std::vector<TrianglePack> _packs; /**< Pack i holds triangles [i * WIDTH, (i + 1) * WIDTH) in leaf order. */
+
+
+
+        /// Private methods ///
+
+        /**
+         * Copy the triangles into the packs in leaf order.
+         */
+        void _copyTriangles(const float* positions, size_t stride, const int* indices);
+
+        /**
+         * Recompute all node bounds from the packs.
+         */
+        void _refitNodes();
+
+        /**
+         * Trace one ray, for the closest hit or (@anyHit) for any hit.
+         */
+        bool _trace(const Ray& ray, Hit& hit, bool anyHit) const;
+
+        /**
+         * Trace up to @PACKET_SIZE rays together.
+         */
+        void _tracePacket(const Ray* rays, size_t count, Hit* hits, bool* occluded) const;
+
+        /**
+         * Advance a sweep against the lanes of a pack in @lanes (a bit mask)
+         * while their time is below @hit.t, and keep the earliest contact.
+         */
+        void _advance(const Sweep& sweep, U32 pack, int lanes, SweepHit& hit) const;
+    };
+}
+
+#endif // BVH_H
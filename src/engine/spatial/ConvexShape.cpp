@@ -0,0 +1,69 @@
+/** 
+ * \file ConvexShape.cpp
+ * \brief Convex shapes described by their support function, as consumed by
+ * @GJK.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include "ConvexShape.h"
+
+
+
+namespace nut
+{
+    Vec3f BoxShape::support(const Vec3f& direction) const
+    {
+        Vec3f p = box.center;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            Vec3f axis = box.getAxis(i);
+            float h = i == 0 ? box.halfExtents.x : (i == 1 ? box.halfExtents.y : box.halfExtents.z);
+            p += axis * (axis * direction >= 0.0f ? h : -h);
+        }
+
+        return p;
+    }
+
+
+
+    ConvexHullShape::ConvexHullShape(const float* positions, size_t count, size_t stride) :
+        points(count), translation(0.0f, 0.0f, 0.0f)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float* p = positions + i * stride;
+            points[i] = Vec3f(p[0], p[1], p[2]);
+        }
+    }
+
+
+
+    Vec3f ConvexHullShape::support(const Vec3f& direction) const
+    {
+        // Search in local space
+        Vec3f d(rotation[0] * direction.x + rotation[1] * direction.y + rotation[2] * direction.z,
+                rotation[3] * direction.x + rotation[4] * direction.y + rotation[5] * direction.z,
+                rotation[6] * direction.x + rotation[7] * direction.y + rotation[8] * direction.z);
+
+        size_t best = 0;
+        float bestDot = points[0] * d;
+
+        for (size_t i = 1; i < points.size(); ++i)
+        {
+            float dot = points[i] * d;
+
+            if (dot > bestDot)
+            {
+                bestDot = dot;
+                best = i;
+            }
+        }
+
+        return rotation * points[best] + translation;
+    }
+}
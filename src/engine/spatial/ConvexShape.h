@@ -0,0 +1,223 @@
+/** 
+ * \file ConvexShape.h
+ * \brief Convex shapes described by their support function, as consumed by
+ * @GJK.
+ * 
+ * A shape is a convex core (a point, a segment, a box or a hull) rounded by a
+ * radius: the set of points within the radius of the core. The support
+ * function gives the farthest point of the core along a direction, so spheres
+ * and capsules have exact, cheap supports and @GJK can work on the cores and
+ * add the radii at the end, which converges much faster than sampling their
+ * curved surfaces.
+ * 
+ * Shapes are given in world space; moving one means updating its data (or the
+ * transform of a @ConvexHullShape) before the next query.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef CONVEXSHAPE_H
+#define CONVEXSHAPE_H
+
+#include <cstddef>
+#include <vector>
+#include "Matrix3x3.h"
+#include "OrientedBoundingBox.h"
+#include "Segment.h"
+#include "Sphere.h"
+#include "Vector.h"
+
+
+
+namespace nut
+{
+    class ConvexShape
+    {
+        public:
+
+        virtual ~ConvexShape()
+        {
+        }
+
+        /**
+         * \brief Get the farthest point of the core along a direction (any of
+         * them on ties).
+         * 
+         * @param direction Search direction, not required to be unit length.
+         */
+        virtual Vec3f support(const Vec3f& direction) const = 0;
+
+        /**
+         * Get a point inside the core, used as the first search direction.
+         */
+        virtual Vec3f getCenter() const = 0;
+
+        /**
+         * Get the radius rounding the core (zero for polyhedra).
+         */
+        virtual float getRadius() const
+        {
+            return 0.0f;
+        }
+    };
+
+
+
+    class SphereShape : public ConvexShape
+    {
+        public:
+
+        Sphere sphere;
+
+
+
+        /// Constructors ///
+
+        explicit SphereShape(const Sphere& sphere) : sphere(sphere)
+        {
+        }
+
+
+
+        /// Methods ///
+
+        Vec3f support(const Vec3f&) const
+        {
+            return sphere.center;
+        }
+
+        Vec3f getCenter() const
+        {
+            return sphere.center;
+        }
+
+        float getRadius() const
+        {
+            return sphere.radius;
+        }
+    };
+
+
+
+    class BoxShape : public ConvexShape
+    {
+        public:
+
+        OrientedBoundingBox box;
+
+
+
+        /// Constructors ///
+
+        explicit BoxShape(const OrientedBoundingBox& box) : box(box)
+        {
+        }
+
+
+
+        /// Methods ///
+
+        Vec3f support(const Vec3f& direction) const;
+
+        Vec3f getCenter() const
+        {
+            return box.center;
+        }
+    };
+
+
+
+    /**
+     * \brief Capsule: the points within a radius of a segment.
+     */
+    class CapsuleShape : public ConvexShape
+    {
+        public:
+
+        Segment segment;
+        float radius;
+
+
+
+        /// Constructors ///
+
+        CapsuleShape(const Segment& segment, float radius) : segment(segment), radius(radius)
+        {
+        }
+
+
+
+        /// Methods ///
+
+        Vec3f support(const Vec3f& direction) const
+        {
+            return segment.getDirection() * direction >= 0.0f ? segment.b : segment.a;
+        }
+
+        Vec3f getCenter() const
+        {
+            return segment.getCenter();
+        }
+
+        float getRadius() const
+        {
+            return radius;
+        }
+    };
+
+
+
+    /**
+     * \brief Convex hull of a point set, placed by a rotation and a translation.
+     * 
+     * The points don't need to be the hull's vertices: interior points are
+     * never the farthest along any direction, they only cost time.
+     */
+    class ConvexHullShape : public ConvexShape
+    {
+        public:
+
+        std::vector<Vec3f> points;  /**< Points in local space. */
+        Matrix3x3<float> rotation;  /**< Local to world rotation. */
+        Vec3f translation;          /**< Local to world translation. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Instantiates an empty hull at the origin.
+         */
+        ConvexHullShape() : translation(0.0f, 0.0f, 0.0f)
+        {
+        }
+
+        /**
+         * \brief Instantiates a hull from points in local space.
+         * 
+         * @param positions Address of the first point's x coordinate.
+         * @param count Number of points (at least one).
+         * @param stride Distance between consecutive points, in floats.
+         */
+        ConvexHullShape(const float* positions, size_t count, size_t stride = 3);
+
+
+
+        /// Methods ///
+
+        Vec3f support(const Vec3f& direction) const;
+
+        /**
+         * Get the first point, in world space.
+         */
+        Vec3f getCenter() const
+        {
+            return rotation * points[0] + translation;
+        }
+    };
+}
+
+#endif // CONVEXSHAPE_H
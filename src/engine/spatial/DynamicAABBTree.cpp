@@ -0,0 +1,743 @@
+/** 
+ * \file DynamicAABBTree.cpp
+ * \brief Incremental bounding volume tree over moving boxes (broadphase).
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include "DynamicAABBTree.h"
+
+
+
+namespace nut
+{
+    const U32 DynamicAABBTree::NULL_NODE = 0xFFFFFFFF;
+
+    /**
+     * Traversal stack entries. Keeping siblings' heights close keeps the height
+     * within a few times log2(proxies), and a depth-first traversal holds at
+     * most one entry per level plus one.
+     */
+    static const int DYNAMIC_TREE_STACK_SIZE = 256;
+
+    static const float DYNAMIC_TREE_DISPLACEMENT_MULTIPLIER = 2.0f; /**< Fat boxes anticipate this many steps of motion. */
+    static const size_t DYNAMIC_TREE_MIN_POOL_SIZE = 16;            /**< Nodes of the pool when it's first used. */
+    static const size_t DYNAMIC_TREE_PAIR_GRAIN = 256;              /**< Proxies per parallel pair finding task. */
+    static const I32 DYNAMIC_TREE_MAX_IMBALANCE = 4;                /**< Height difference of siblings that forces a rotation. */
+
+
+
+    /**
+     * Traversal stack entry: a node and the distance where a ray enters it, or
+     * the area its ancestors gain during an insertion.
+     */
+    struct DynamicAABBTreeEntry
+    {
+        U32 node;
+        float value;
+    };
+
+
+
+    /**
+     * Union of two boxes.
+     */
+    static inline BoundingBox merged(const BoundingBox& a, const BoundingBox& b)
+    {
+        BoundingBox box = a;
+        box.merge(b);
+        return box;
+    }
+
+
+
+    DynamicAABBTree::DynamicAABBTree(float margin)
+        : _margin(margin), _root(NULL_NODE), _freeList(NULL_NODE), _proxyCount(0)
+    {
+    }
+
+
+
+    void DynamicAABBTree::reserve(size_t proxies)
+    {
+        // A tree with n leaves has n - 1 inner nodes
+        size_t nodes = proxies > 0 ? 2 * proxies - 1 : 0;
+
+        if (nodes > _nodes.size())
+        {
+            _growPool(nodes);
+        }
+
+        _moved.reserve(proxies);
+    }
+
+
+
+    void DynamicAABBTree::clear()
+    {
+        _root = NULL_NODE;
+        _freeList = NULL_NODE;
+        _proxyCount = 0;
+        _moved.clear();
+
+        // Return every node to the free list, in increasing order
+        for (size_t i = _nodes.size(); i-- > 0;)
+        {
+            _nodes[i].parent = _freeList;
+            _nodes[i].height = -1;
+            _freeList = U32(i);
+        }
+    }
+
+
+
+    U32 DynamicAABBTree::createProxy(const BoundingBox& box, U32 userData)
+    {
+        U32 proxy = _allocateNode();
+        Node& node = _nodes[proxy];
+
+        node.bounds = box;
+        node.bounds.inflate(_margin);
+        node.userData = userData;
+        node.height = 0;
+        node.moved = true;
+
+        _moved.push_back(proxy);
+        _insertLeaf(proxy);
+        ++_proxyCount;
+
+        return proxy;
+    }
+
+
+
+    void DynamicAABBTree::destroyProxy(U32 proxy)
+    {
+        if (_nodes[proxy].moved)
+        {
+            std::vector<U32>::iterator it = std::find(_moved.begin(), _moved.end(), proxy);
+            *it = _moved.back();
+            _moved.pop_back();
+        }
+
+        _removeLeaf(proxy);
+        _freeNode(proxy);
+        --_proxyCount;
+    }
+
+
+
+    bool DynamicAABBTree::moveProxy(U32 proxy, const BoundingBox& box, const Vec3f& displacement)
+    {
+        // New fat box: margin, then stretched along the motion
+        BoundingBox fat = box;
+        fat.inflate(_margin);
+
+        Vec3f d = displacement * DYNAMIC_TREE_DISPLACEMENT_MULTIPLIER;
+        (d.x < 0.0f ? fat.min.x : fat.max.x) += d.x;
+        (d.y < 0.0f ? fat.min.y : fat.max.y) += d.y;
+        (d.z < 0.0f ? fat.min.z : fat.max.z) += d.z;
+
+        const BoundingBox& current = _nodes[proxy].bounds;
+
+        if (current.contains(box))
+        {
+            // Still inside; keep it unless it became far too large (the object
+            // slowed down), which would give false pairs
+            BoundingBox huge = fat;
+            huge.inflate(4.0f * _margin);
+
+            if (huge.contains(current))
+            {
+                return false;
+            }
+        }
+
+        _removeLeaf(proxy);
+        _nodes[proxy].bounds = fat;
+        _insertLeaf(proxy);
+
+        if (!_nodes[proxy].moved)
+        {
+            _nodes[proxy].moved = true;
+            _moved.push_back(proxy);
+        }
+
+        return true;
+    }
+
+
+
+    float DynamicAABBTree::getAreaRatio() const
+    {
+        if (_root == NULL_NODE)
+        {
+            return 0.0f;
+        }
+
+        float area = 0.0f;
+
+        for (size_t i = 0; i < _nodes.size(); ++i)
+        {
+            if (_nodes[i].height >= 0)
+            {
+                area += _nodes[i].bounds.getSurfaceArea();
+            }
+        }
+
+        float rootArea = _nodes[_root].bounds.getSurfaceArea();
+        return rootArea > 0.0f ? area / rootArea : 0.0f;
+    }
+
+
+
+    size_t DynamicAABBTree::query(const BoundingBox& box, std::vector<U32>& proxies) const
+    {
+        if (_root == NULL_NODE)
+        {
+            return 0;
+        }
+
+        size_t found = proxies.size();
+        U32 stack[DYNAMIC_TREE_STACK_SIZE];
+        int size = 0;
+        stack[size++] = _root;
+
+        while (size > 0)
+        {
+            const U32 index = stack[--size];
+            const Node& node = _nodes[index];
+
+            if (!node.bounds.overlaps(box))
+            {
+                continue;
+            }
+
+            if (node.isLeaf())
+            {
+                proxies.push_back(index);
+            }
+            else
+            {
+                stack[size++] = node.child[0];
+                stack[size++] = node.child[1];
+            }
+        }
+
+        return proxies.size() - found;
+    }
+
+
+
+    size_t DynamicAABBTree::query(const Ray& ray, std::vector<U32>& proxies) const
+    {
+        if (_root == NULL_NODE)
+        {
+            return 0;
+        }
+
+        size_t found = proxies.size();
+        U32 stack[DYNAMIC_TREE_STACK_SIZE];
+        int size = 0;
+        stack[size++] = _root;
+
+        while (size > 0)
+        {
+            const U32 index = stack[--size];
+            const Node& node = _nodes[index];
+
+            if (!node.bounds.intersect(ray.origin, ray.invDirection, ray.tMin, ray.tMax))
+            {
+                continue;
+            }
+
+            if (node.isLeaf())
+            {
+                proxies.push_back(index);
+            }
+            else
+            {
+                stack[size++] = node.child[0];
+                stack[size++] = node.child[1];
+            }
+        }
+
+        return proxies.size() - found;
+    }
+
+
+
+    U32 DynamicAABBTree::raycast(const Ray& ray, const RayCallback& callback, float* t) const
+    {
+        U32 hit = NULL_NODE;
+        Ray clipped = ray;
+        float entry;
+
+        if (t != nullptr)
+        {
+            *t = ray.tMax;
+        }
+
+        if (_root == NULL_NODE ||
+            !_nodes[_root].bounds.intersect(ray.origin, ray.invDirection, ray.tMin, ray.tMax, &entry))
+        {
+            return NULL_NODE;
+        }
+
+        DynamicAABBTreeEntry stack[DYNAMIC_TREE_STACK_SIZE];
+        int size = 0;
+        stack[size].node = _root;
+        stack[size++].value = entry;
+
+        while (size > 0)
+        {
+            const DynamicAABBTreeEntry current = stack[--size];
+
+            // Entered beyond a hit found after it was pushed
+            if (current.value > clipped.tMax)
+            {
+                continue;
+            }
+
+            const Node& node = _nodes[current.node];
+
+            if (node.isLeaf())
+            {
+                float tHit = callback(current.node, clipped);
+
+                if (tHit < clipped.tMax && tHit >= clipped.tMin)
+                {
+                    clipped.tMax = tHit;
+                    hit = current.node;
+                }
+
+                continue;
+            }
+
+            float t0, t1;
+            bool hit0 = _nodes[node.child[0]].bounds.intersect(ray.origin, ray.invDirection, clipped.tMin, clipped.tMax, &t0);
+            bool hit1 = _nodes[node.child[1]].bounds.intersect(ray.origin, ray.invDirection, clipped.tMin, clipped.tMax, &t1);
+
+            // Far child first, so the near one is popped next
+            if (hit0 && hit1)
+            {
+                bool nearFirst = t0 <= t1;
+                stack[size].node = node.child[nearFirst ? 1 : 0];
+                stack[size++].value = nearFirst ? t1 : t0;
+                stack[size].node = node.child[nearFirst ? 0 : 1];
+                stack[size++].value = nearFirst ? t0 : t1;
+            }
+            else if (hit0 || hit1)
+            {
+                stack[size].node = node.child[hit0 ? 0 : 1];
+                stack[size++].value = hit0 ? t0 : t1;
+            }
+        }
+
+        if (t != nullptr)
+        {
+            *t = clipped.tMax;
+        }
+
+        return hit;
+    }
+
+
+
+    void DynamicAABBTree::updatePairs(std::vector<Pair>& pairs)
+    {
+        _findPairs(_moved, false, pairs);
+
+        for (size_t i = 0; i < _moved.size(); ++i)
+        {
+            _nodes[_moved[i]].moved = false;
+        }
+
+        _moved.clear();
+    }
+
+
+
+    void DynamicAABBTree::findPairs(std::vector<Pair>& pairs)
+    {
+        _leaves.clear();
+
+        for (size_t i = 0; i < _nodes.size(); ++i)
+        {
+            if (_nodes[i].height == 0)
+            {
+                _leaves.push_back(U32(i));
+            }
+        }
+
+        _findPairs(_leaves, true, pairs);
+    }
+
+
+
+    U32 DynamicAABBTree::_allocateNode()
+    {
+        if (_freeList == NULL_NODE)
+        {
+            _growPool(std::max(DYNAMIC_TREE_MIN_POOL_SIZE, 2 * _nodes.size()));
+        }
+
+        U32 index = _freeList;
+        Node& node = _nodes[index];
+        _freeList = node.parent;
+
+        node.parent = NULL_NODE;
+        node.child[0] = node.child[1] = NULL_NODE;
+        node.height = 0;
+        node.userData = NULL_NODE;
+        node.moved = false;
+
+        return index;
+    }
+
+
+
+    void DynamicAABBTree::_freeNode(U32 node)
+    {
+        _nodes[node].parent = _freeList;
+        _nodes[node].height = -1;
+        _freeList = node;
+    }
+
+
+
+    void DynamicAABBTree::_growPool(size_t nodes)
+    {
+        size_t first = _nodes.size();
+        _nodes.resize(nodes);
+
+        // New nodes go in front of the free list, in increasing order
+        for (size_t i = nodes; i-- > first;)
+        {
+            _nodes[i].parent = _freeList;
+            _nodes[i].height = -1;
+            _freeList = U32(i);
+        }
+    }
+
+
+
+    void DynamicAABBTree::_insertLeaf(U32 leaf)
+    {
+        if (_root == NULL_NODE)
+        {
+            _root = leaf;
+            _nodes[leaf].parent = NULL_NODE;
+            return;
+        }
+
+        // Allocate first: growing the pool moves the nodes
+        U32 newParent = _allocateNode();
+        const BoundingBox box = _nodes[leaf].bounds;
+
+        // Descend toward the sibling with the smallest cost: the area of the
+        // new parent plus the growth of its ancestors. Stop when pairing with
+        // the current node is cheaper than descending into either child
+        U32 sibling = _root;
+
+        while (!_nodes[sibling].isLeaf())
+        {
+            const Node& node = _nodes[sibling];
+            const float area = node.bounds.getSurfaceArea();
+            const float combinedArea = merged(node.bounds, box).getSurfaceArea();
+
+            // Cost of a new parent of this node and the leaf
+            const float cost = 2.0f * combinedArea;
+
+            // Growth of this node, paid by descending further
+            const float inheritance = 2.0f * (combinedArea - area);
+
+            float childCost[2];
+
+            for (int k = 0; k < 2; ++k)
+            {
+                const Node& child = _nodes[node.child[k]];
+                float childArea = merged(child.bounds, box).getSurfaceArea();
+
+                if (!child.isLeaf())
+                {
+                    childArea -= child.bounds.getSurfaceArea();
+                }
+
+                childCost[k] = childArea + inheritance;
+            }
+
+            if (cost < childCost[0] && cost < childCost[1])
+            {
+                break;
+            }
+
+            sibling = node.child[childCost[0] <= childCost[1] ? 0 : 1];
+        }
+
+        // Replace the sibling with a new parent of the sibling and the leaf
+        U32 oldParent = _nodes[sibling].parent;
+        Node& parent = _nodes[newParent];
+
+        parent.parent = oldParent;
+        parent.bounds = box;
+        parent.bounds.merge(_nodes[sibling].bounds);
+        parent.height = _nodes[sibling].height + 1;
+        parent.child[0] = sibling;
+        parent.child[1] = leaf;
+
+        if (oldParent != NULL_NODE)
+        {
+            Node& grandParent = _nodes[oldParent];
+            grandParent.child[grandParent.child[0] == sibling ? 0 : 1] = newParent;
+        }
+        else
+        {
+            _root = newParent;
+        }
+
+        _nodes[sibling].parent = newParent;
+        _nodes[leaf].parent = newParent;
+
+        _fixUpwards(newParent);
+    }
+
+
+
+    void DynamicAABBTree::_removeLeaf(U32 leaf)
+    {
+        if (leaf == _root)
+        {
+            _root = NULL_NODE;
+            return;
+        }
+
+        U32 parent = _nodes[leaf].parent;
+        U32 grandParent = _nodes[parent].parent;
+        U32 sibling = _nodes[parent].child[_nodes[parent].child[0] == leaf ? 1 : 0];
+
+        // The sibling takes the parent's place
+        if (grandParent != NULL_NODE)
+        {
+            Node& node = _nodes[grandParent];
+            node.child[node.child[0] == parent ? 0 : 1] = sibling;
+            _nodes[sibling].parent = grandParent;
+            _freeNode(parent);
+
+            _fixUpwards(grandParent);
+        }
+        else
+        {
+            _root = sibling;
+            _nodes[sibling].parent = NULL_NODE;
+            _freeNode(parent);
+        }
+    }
+
+
+
+    void DynamicAABBTree::_fixUpwards(U32 index)
+    {
+        while (index != NULL_NODE)
+        {
+            index = _balance(index);
+            _rotate(index);
+
+            Node& node = _nodes[index];
+            const Node& a = _nodes[node.child[0]];
+            const Node& b = _nodes[node.child[1]];
+
+            node.height = 1 + std::max(a.height, b.height);
+            node.bounds = a.bounds;
+            node.bounds.merge(b.bounds);
+
+            index = node.parent;
+        }
+    }
+
+
+
+    U32 DynamicAABBTree::_balance(U32 iA)
+    {
+        Node& a = _nodes[iA];
+
+        if (a.isLeaf() || a.height < 2)
+        {
+            return iA;
+        }
+
+        // Rotate the taller child up: it becomes the parent of @a, and @a
+        // keeps the shorter of its two children
+        const U32 iB = a.child[0], iC = a.child[1];
+        const I32 balance = _nodes[iC].height - _nodes[iB].height;
+
+        if (std::abs(balance) <= DYNAMIC_TREE_MAX_IMBALANCE)
+        {
+            return iA;
+        }
+
+        const int up = balance > 1 ? 1 : 0; // Side of the child rotated up
+        const U32 iUp = a.child[up];
+        const U32 iStay = a.child[1 - up];
+        Node& upNode = _nodes[iUp];
+        const U32 iF = upNode.child[0], iG = upNode.child[1];
+
+        upNode.child[0] = iA;
+        upNode.parent = a.parent;
+        a.parent = iUp;
+
+        if (upNode.parent != NULL_NODE)
+        {
+            Node& parent = _nodes[upNode.parent];
+            parent.child[parent.child[0] == iA ? 0 : 1] = iUp;
+        }
+        else
+        {
+            _root = iUp;
+        }
+
+        // The taller grandchild stays under the rotated node
+        const bool fTaller = _nodes[iF].height > _nodes[iG].height;
+        const U32 iKeep = fTaller ? iF : iG;
+        const U32 iMove = fTaller ? iG : iF;
+
+        upNode.child[1] = iKeep;
+        a.child[up] = iMove;
+        _nodes[iMove].parent = iA;
+
+        a.bounds = _nodes[iStay].bounds;
+        a.bounds.merge(_nodes[iMove].bounds);
+        a.height = 1 + std::max(_nodes[iStay].height, _nodes[iMove].height);
+
+        upNode.bounds = a.bounds;
+        upNode.bounds.merge(_nodes[iKeep].bounds);
+        upNode.height = 1 + std::max(a.height, _nodes[iKeep].height);
+
+        return iUp;
+    }
+
+
+
+    void DynamicAABBTree::_rotate(U32 iA)
+    {
+        Node& a = _nodes[iA];
+
+        if (a.height < 2)
+        {
+            return;
+        }
+
+        // Try swapping a child of @a with a grandchild on the other side: the
+        // inner node receiving the child is rebuilt, and the swap is kept if
+        // that node shrinks the most while the subtree stays balanced
+        float bestGain = 0.0f;
+        int bestSide = -1, bestGrandChild = 0;
+
+        for (int side = 0; side < 2; ++side)
+        {
+            const Node& inner = _nodes[a.child[1 - side]];
+            const Node& moved = _nodes[a.child[side]];
+
+            if (inner.isLeaf())
+            {
+                continue;
+            }
+
+            for (int g = 0; g < 2; ++g)
+            {
+                // @moved replaces grandchild g, which goes up to @a
+                const Node& up = _nodes[inner.child[g]];
+                const Node& stays = _nodes[inner.child[1 - g]];
+                const I32 innerHeight = 1 + std::max(moved.height, stays.height);
+
+                if (std::abs(moved.height - stays.height) > DYNAMIC_TREE_MAX_IMBALANCE ||
+                    std::abs(innerHeight - up.height) > DYNAMIC_TREE_MAX_IMBALANCE)
+                {
+                    continue;
+                }
+
+                float gain = inner.bounds.getSurfaceArea() - merged(moved.bounds, stays.bounds).getSurfaceArea();
+
+                if (gain > bestGain)
+                {
+                    bestGain = gain;
+                    bestSide = side;
+                    bestGrandChild = g;
+                }
+            }
+        }
+
+        if (bestSide < 0)
+        {
+            return;
+        }
+
+        const U32 iInner = a.child[1 - bestSide];
+        const U32 iMoved = a.child[bestSide];
+        Node& inner = _nodes[iInner];
+        const U32 iUp = inner.child[bestGrandChild];
+        const U32 iStays = inner.child[1 - bestGrandChild];
+
+        a.child[bestSide] = iUp;
+        inner.child[bestGrandChild] = iMoved;
+        _nodes[iUp].parent = iA;
+        _nodes[iMoved].parent = iInner;
+
+        inner.bounds = _nodes[iMoved].bounds;
+        inner.bounds.merge(_nodes[iStays].bounds);
+        inner.height = 1 + std::max(_nodes[iMoved].height, _nodes[iStays].height);
+    }
+
+
+
+    void DynamicAABBTree::_findPairs(const std::vector<U32>& proxies, bool allProxies, std::vector<Pair>& pairs)
+    {
+        pairs.clear();
+
+        if (proxies.empty() || _root == NULL_NODE)
+        {
+            return;
+        }
+
+        _pairCollector.run(proxies.size(), DYNAMIC_TREE_PAIR_GRAIN, [&](size_t begin, size_t end, std::vector<Pair>& out)
+        {
+            U32 stack[DYNAMIC_TREE_STACK_SIZE];
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const U32 proxy = proxies[i];
+                const BoundingBox& box = _nodes[proxy].bounds;
+                int size = 0;
+                stack[size++] = _root;
+
+                while (size > 0)
+                {
+                    const U32 index = stack[--size];
+                    const Node& node = _nodes[index];
+
+                    if (!node.bounds.overlaps(box))
+                    {
+                        continue;
+                    }
+
+                    if (!node.isLeaf())
+                    {
+                        stack[size++] = node.child[0];
+                        stack[size++] = node.child[1];
+                    }
+                    else if (index != proxy && !((allProxies || node.moved) && index < proxy))
+                    {
+                        Pair pair = { std::min(proxy, index), std::max(proxy, index) };
+                        out.push_back(pair);
+                    }
+                }
+            }
+        }, pairs);
+    }
+}
@@ -0,0 +1,300 @@
+/** 
+ * \file DynamicAABBTree.h
+ * \brief Incremental bounding volume tree over moving boxes (broadphase).
+ * 
+ * Each object (proxy) is a leaf holding a "fat" box: the object's box grown by
+ * a margin and stretched along its last displacement. Small motions stay
+ * inside the fat box and cost nothing; the leaf is only reinserted when the
+ * object leaves it.
+ * 
+ * Leaves are inserted next to the sibling that minimizes the increase of
+ * surface area of the tree (the approach of Box2D's b2DynamicTree, by Erin
+ * Catto). On the way up, nodes swap a child with a grandchild when that
+ * shrinks the tree (Kopta et al., "Fast, effective BVH updates for animated
+ * scenes", 2012), which keeps queries fast as objects move; AVL rotations only
+ * happen when siblings' heights get far apart. Nodes live in a pool: a
+ * contiguous array with an intrusive free list, so once it reached its peak
+ * size, creating, moving and destroying proxies doesn't allocate memory.
+ * Proxy ids are node indices and stay valid until the proxy is destroyed.
+ * 
+ * Pair finding queries the tree with the fat box of every proxy that moved
+ * since the last @updatePairs() (or of all proxies for @findPairs()); proxies
+ * are split across the @ThreadPool and every pair is reported once.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef DYNAMICAABBTREE_H
+#define DYNAMICAABBTREE_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "BoundingBox.h"
+#include "DataType.h"
+#include "ParallelCollector.h"
+#include "Ray.h"
+#include "Vector.h"
+
+
+
+namespace nut
+{
+    class DynamicAABBTree
+    {
+        public:
+
+        static const U32 NULL_NODE; /**< Invalid node (and proxy) index. */
+
+        /**
+         * \brief Pair of proxies whose fat boxes overlap, with @a < @b.
+         */
+        struct Pair
+        {
+            U32 a, b;
+        };
+
+        /**
+         * \brief Tree node. Leaves are proxies.
+         */
+        struct Node
+        {
+            BoundingBox bounds; /**< Fat box of a leaf; union of the children of an inner node. */
+            U32 parent;         /**< Parent node, or next node of the free list. */
+            U32 child[2];       /**< Children; @NULL_NODE for leaves. */
+            I32 height;         /**< Zero for leaves, -1 for free nodes. */
+            U32 userData;       /**< Value given to @createProxy(). */
+            bool moved;         /**< The proxy was reinserted since the last @updatePairs(). */
+
+            bool isLeaf() const
+            {
+                return child[0] == NULL_NODE;
+            }
+        };
+
+        /**
+         * Called by @raycast() for each proxy whose fat box is hit. Returns the
+         * distance of the closest hit with the proxy's object, or the ray's
+         * tMax if there's none.
+         */
+        typedef std::function<float(U32 proxy, const Ray& ray)> RayCallback;
+
+
+
+        /// Constructors ///
+
+        /**
+         * \brief Instantiates an empty tree.
+         * 
+         * @param margin Distance added around the boxes of proxies. Larger
+         * margins mean fewer reinsertions but more false pairs.
+         */
+        explicit DynamicAABBTree(float margin = 0.1f);
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Allocate room for a number of proxies, so that creating them
+         * doesn't allocate memory.
+         */
+        void reserve(size_t proxies);
+
+        /**
+         * Remove all proxies. The pool keeps its memory.
+         */
+        void clear();
+
+        /**
+         * \brief Add an object.
+         * 
+         * @param box Bounds of the object.
+         * @param userData Value returned by @getUserData().
+         * @return The proxy id.
+         */
+        U32 createProxy(const BoundingBox& box, U32 userData);
+
+        /**
+         * \brief Remove an object.
+         * 
+         * @param proxy Proxy returned by @createProxy().
+         */
+        void destroyProxy(U32 proxy);
+
+        /**
+         * \brief Update the bounds of an object.
+         * 
+         * @param proxy Proxy returned by @createProxy().
+         * @param box New bounds of the object.
+         * @param displacement Motion of the object over the last step; the fat
+         * box is stretched along it to anticipate the next one.
+         * @return True if the proxy was reinserted (its fat box changed).
+         */
+        bool moveProxy(U32 proxy, const BoundingBox& box, const Vec3f& displacement);
+
+        /**
+         * Get the value given to @createProxy().
+         */
+        U32 getUserData(U32 proxy) const
+        {
+            return _nodes[proxy].userData;
+        }
+
+        /**
+         * Get the fat box of a proxy.
+         */
+        const BoundingBox& getFatBounds(U32 proxy) const
+        {
+            return _nodes[proxy].bounds;
+        }
+
+        /**
+         * Get the number of proxies.
+         */
+        size_t getNumberOfProxies() const
+        {
+            return _proxyCount;
+        }
+
+        /**
+         * Get the height of the tree (zero for a single proxy, -1 when empty).
+         */
+        I32 getHeight() const
+        {
+            return _root == NULL_NODE ? -1 : _nodes[_root].height;
+        }
+
+        /**
+         * \brief Get the sum of the surface areas of all nodes divided by the
+         * area of the root, a measure of the tree quality (lower is better).
+         */
+        float getAreaRatio() const;
+
+        /**
+         * \brief Find the proxies whose fat boxes overlap a box.
+         * 
+         * @param box Query region.
+         * @param proxies The proxies found are appended to it.
+         * @return Number of proxies found.
+         */
+        size_t query(const BoundingBox& box, std::vector<U32>& proxies) const;
+
+        /**
+         * \brief Find the proxies whose fat boxes are hit by a ray within
+         * [tMin, tMax].
+         * 
+         * @param ray Ray.
+         * @param proxies The proxies found are appended to it.
+         * @return Number of proxies found.
+         */
+        size_t query(const Ray& ray, std::vector<U32>& proxies) const;
+
+        /**
+         * \brief Find the closest object hit by a ray.
+         * 
+         * Nodes are visited near to far and the ray is clipped at each hit the
+         * callback reports, so most proxies behind the closest hit are skipped.
+         * 
+         * @param ray Ray.
+         * @param callback Exact test against the object of a proxy.
+         * @param t Receives the distance of the closest hit, if not null.
+         * @return The proxy hit, or @NULL_NODE.
+         */
+        U32 raycast(const Ray& ray, const RayCallback& callback, float* t = nullptr) const;
+
+        /**
+         * \brief Find the pairs involving proxies created or reinserted since
+         * the last call, and reset the set of moved proxies.
+         * 
+         * Pairs of two proxies that stayed inside their fat boxes aren't
+         * reported again, since their overlap can't have changed.
+         * 
+         * @param pairs Receives the pairs (cleared first), each pair once.
+         */
+        void updatePairs(std::vector<Pair>& pairs);
+
+        /**
+         * \brief Find all pairs of proxies whose fat boxes overlap.
+         * 
+         * @param pairs Receives the pairs (cleared first), each pair once.
+         */
+        void findPairs(std::vector<Pair>& pairs);
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        float _margin;
+        std::vector<Node> _nodes; /**< Node pool. */
+        U32 _root;
+        U32 _freeList;            /**< First free node of the pool. */
+        size_t _proxyCount;
+        std::vector<U32> _moved;  /**< Proxies reinserted since the last @updatePairs(). */
+        std::vector<U32> _leaves; /**< Scratch list of proxies for @findPairs(). */
+        ParallelCollector<Pair> _pairCollector;
+
+
+
+        /// Private methods ///
+
+        /**
+         * Take a node from the pool, growing it if needed.
+         */
+        U32 _allocateNode();
+
+        /**
+         * Return a node to the pool.
+         */
+        void _freeNode(U32 node);
+
+        /**
+         * Grow the pool to a number of nodes, adding the new ones to the free
+         * list.
+         */
+        void _growPool(size_t nodes);
+
+        /**
+         * Insert a leaf next to the sibling with the smallest area cost.
+         */
+        void _insertLeaf(U32 leaf);
+
+        /**
+         * Detach a leaf, removing its parent.
+         */
+        void _removeLeaf(U32 leaf);
+
+        /**
+         * Refit bounds and heights from a node up to the root, rotating
+         * unbalanced nodes on the way.
+         */
+        void _fixUpwards(U32 node);
+
+        /**
+         * Rotate a node if its children's heights differ by too much.
+         * 
+         * @return The node now at the position of @node.
+         */
+        U32 _balance(U32 node);
+
+        /**
+         * Swap a child of a node with a grandchild from the other side if that
+         * reduces the surface area without unbalancing the subtree.
+         */
+        void _rotate(U32 node);
+
+        /**
+         * Query the tree with the fat box of each given proxy. A pair of two
+         * listed proxies (moved ones, or any if @allProxies) is reported only
+         * by the one with the smaller id.
+         */
+        void _findPairs(const std::vector<U32>& proxies, bool allProxies, std::vector<Pair>& pairs);
+    };
+}
+
+#endif // DYNAMICAABBTREE_H
@@ -0,0 +1,796 @@
+/** 
+ * \file GJK.cpp
+ * \brief Distance, intersection and penetration queries between convex shapes
+ * (narrowphase).
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "GJK.h"
+#include "Math.h"
+
+
+
+namespace nut
+{
+    static const int GJK_MAX_ITERATIONS = 64;
+    static const float GJK_TOLERANCE = 1e-6f;  /**< Relative gain of the squared distance under which GJK stops. */
+    static const float GJK_DEPENDENT = 1e-10f; /**< Relative squared size under which a new vertex is affinely dependent. */
+
+    static const int EPA_MAX_ITERATIONS = 64;
+    static const int EPA_MAX_VERTICES = EPA_MAX_ITERATIONS + 4;
+    static const int EPA_MAX_FACES = 2 * EPA_MAX_VERTICES; /**< A closed polytope of V vertices has 2V - 4 faces. */
+    static const float EPA_TOLERANCE = 1e-4f;              /**< Relative gain of the depth under which EPA stops. */
+
+
+
+    /**
+     * \brief Support point of the Minkowski difference A - B, with the points
+     * of each shape it comes from and the direction that found it.
+     */
+    struct GJKVertex
+    {
+        Vec3f a, b, w;
+        Vec3f direction;
+    };
+
+
+
+    /**
+     * \brief Simplex of up to four vertices, with the barycentric coordinates
+     * of its point closest to the origin.
+     */
+    struct GJKSimplex
+    {
+        GJKVertex vertices[4];
+        float lambdas[4];
+        int count;
+    };
+
+
+
+    /**
+     * \brief EPA polytope face, wound counterclockwise seen from outside, with
+     * its outward unit normal and distance to the origin.
+     */
+    struct EPAFace
+    {
+        int v[3];
+        Vec3f normal;
+        float distance;
+    };
+
+
+
+    /**
+     * Support point of the cores of A - B along a direction.
+     */
+    static GJKVertex gjkSupport(const ConvexShape& a, const ConvexShape& b, const Vec3f& direction)
+    {
+        GJKVertex v;
+        v.direction = direction;
+        v.a = a.support(direction);
+        v.b = b.support(-direction);
+        v.w = v.a - v.b;
+
+        return v;
+    }
+
+
+
+    /**
+     * Check if a point would add a dimension to the vertices of a simplex.
+     */
+    static bool gjkIndependent(const GJKVertex* vertices, int count, const Vec3f& w)
+    {
+        if (count == 0)
+        {
+            return true;
+        }
+
+        Vec3f e = w - vertices[0].w;
+        float ee = e * e;
+
+        if (count == 1)
+        {
+            return ee > GJK_DEPENDENT * std::max(w * w, vertices[0].w * vertices[0].w);
+        }
+
+        Vec3f e1 = vertices[1].w - vertices[0].w;
+
+        if (count == 2)
+        {
+            return e1.cross(e).slength() > GJK_DEPENDENT * (e1 * e1) * ee;
+        }
+
+        if (count == 3)
+        {
+            Vec3f n = e1.cross(vertices[2].w - vertices[0].w);
+            float d = n * e;
+            return d * d > GJK_DEPENDENT * (n * n) * ee;
+        }
+
+        return false;
+    }
+
+
+
+    /**
+     * \brief Reduce a triangle simplex to the feature closest to the origin
+     * (Ericson, "Real-Time Collision Detection", 5.1.5).
+     */
+    static void gjkSolveTriangle(GJKSimplex& s)
+    {
+        const Vec3f a = s.vertices[0].w, b = s.vertices[1].w, c = s.vertices[2].w;
+        Vec3f ab = b - a, ac = c - a;
+
+        float d1 = -(ab * a), d2 = -(ac * a);
+
+        if (d1 <= 0.0f && d2 <= 0.0f)
+        {
+            s.count = 1;
+            s.lambdas[0] = 1.0f;
+            return;
+        }
+
+        float d3 = -(ab * b), d4 = -(ac * b);
+
+        if (d3 >= 0.0f && d4 <= d3)
+        {
+            s.vertices[0] = s.vertices[1];
+            s.count = 1;
+            s.lambdas[0] = 1.0f;
+            return;
+        }
+
+        float vc = d1 * d4 - d3 * d2;
+
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        {
+            float t = d1 / (d1 - d3);
+            s.count = 2;
+            s.lambdas[0] = 1.0f - t;
+            s.lambdas[1] = t;
+            return;
+        }
+
+        float d5 = -(ab * c), d6 = -(ac * c);
+
+        if (d6 >= 0.0f && d5 <= d6)
+        {
+            s.vertices[0] = s.vertices[2];
+            s.count = 1;
+            s.lambdas[0] = 1.0f;
+            return;
+        }
+
+        float vb = d5 * d2 - d1 * d6;
+
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        {
+            float t = d2 / (d2 - d6);
+            s.vertices[1] = s.vertices[2];
+            s.count = 2;
+            s.lambdas[0] = 1.0f - t;
+            s.lambdas[1] = t;
+            return;
+        }
+
+        float va = d3 * d6 - d5 * d4;
+
+        if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        {
+            float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+            s.vertices[0] = s.vertices[1];
+            s.vertices[1] = s.vertices[2];
+            s.count = 2;
+            s.lambdas[0] = 1.0f - t;
+            s.lambdas[1] = t;
+            return;
+        }
+
+        float denominator = va + vb + vc;
+
+        // Degenerate triangle whose regions all failed: keep its closest vertex
+        if (!(denominator > 0.0f))
+        {
+            int closest = 0;
+
+            for (int i = 1; i < 3; ++i)
+            {
+                if (s.vertices[i].w.slength() < s.vertices[closest].w.slength())
+                {
+                    closest = i;
+                }
+            }
+
+            s.vertices[0] = s.vertices[closest];
+            s.count = 1;
+            s.lambdas[0] = 1.0f;
+            return;
+        }
+
+        s.lambdas[1] = vb / denominator;
+        s.lambdas[2] = vc / denominator;
+        s.lambdas[0] = 1.0f - s.lambdas[1] - s.lambdas[2];
+    }
+
+
+
+    /**
+     * \brief Reduce a simplex to the feature closest to the origin and get
+     * that point.
+     * 
+     * @return False if the simplex is a tetrahedron containing the origin.
+     */
+    static bool gjkClosest(GJKSimplex& s, Vec3f& v)
+    {
+        switch (s.count)
+        {
+            case 1:
+            {
+                s.lambdas[0] = 1.0f;
+                break;
+            }
+
+            case 2:
+            {
+                Vec3f a = s.vertices[0].w, ab = s.vertices[1].w - a;
+                float t = -(a * ab), denominator = ab * ab;
+
+                if (t <= 0.0f)
+                {
+                    s.count = 1;
+                    s.lambdas[0] = 1.0f;
+                }
+                else if (t >= denominator)
+                {
+                    s.vertices[0] = s.vertices[1];
+                    s.count = 1;
+                    s.lambdas[0] = 1.0f;
+                }
+                else
+                {
+                    s.lambdas[1] = t / denominator;
+                    s.lambdas[0] = 1.0f - s.lambdas[1];
+                }
+
+                break;
+            }
+
+            case 3:
+            {
+                gjkSolveTriangle(s);
+                break;
+            }
+
+            case 4:
+            {
+                // Faces and their opposite vertex
+                static const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+                GJKSimplex best;
+                float bestDistance = FLT_MAX;
+
+                for (int f = 0; f < 4; ++f)
+                {
+                    const Vec3f& a = s.vertices[faces[f][0]].w;
+                    Vec3f n = (s.vertices[faces[f][1]].w - a).cross(s.vertices[faces[f][2]].w - a);
+                    float originSide = -(n * a);
+                    float oppositeSide = n * (s.vertices[faces[f][3]].w - a);
+
+                    // Faces of a flat tetrahedron are all tested
+                    bool flat = oppositeSide * oppositeSide <= GJK_DEPENDENT * (n * n) * (s.vertices[faces[f][3]].w - a).slength();
+
+                    if (originSide * oppositeSide >= 0.0f && !flat)
+                    {
+                        continue;
+                    }
+
+                    GJKSimplex face;
+                    face.count = 3;
+                    face.vertices[0] = s.vertices[faces[f][0]];
+                    face.vertices[1] = s.vertices[faces[f][1]];
+                    face.vertices[2] = s.vertices[faces[f][2]];
+                    gjkSolveTriangle(face);
+
+                    Vec3f p(0.0f, 0.0f, 0.0f);
+
+                    for (int i = 0; i < face.count; ++i)
+                    {
+                        p += face.vertices[i].w * face.lambdas[i];
+                    }
+
+                    if (p * p < bestDistance)
+                    {
+                        bestDistance = p * p;
+                        best = face;
+                    }
+                }
+
+                if (bestDistance == FLT_MAX)
+                {
+                    return false;
+                }
+
+                s = best;
+                break;
+            }
+        }
+
+        v = Vec3f(0.0f, 0.0f, 0.0f);
+
+        for (int i = 0; i < s.count; ++i)
+        {
+            v += s.vertices[i].w * s.lambdas[i];
+        }
+
+        return true;
+    }
+
+
+
+    /**
+     * \brief Run GJK on the cores of A - B.
+     * 
+     * @param separation Stop as soon as the distance is known to exceed it;
+     * negative to always converge.
+     * @param s Receives the final simplex.
+     * @param v Receives its point closest to the origin.
+     * @return True if the origin is outside A - B.
+     */
+    static bool gjkRun(const ConvexShape& a, const ConvexShape& b, float separation, const GJK::Cache* cache, GJKSimplex& s,
+                       Vec3f& v, int& iterations)
+    {
+        s.count = 0;
+        iterations = 0;
+
+        if (cache != nullptr)
+        {
+            for (int i = 0; i < cache->count; ++i)
+            {
+                GJKVertex w = gjkSupport(a, b, cache->directions[i]);
+
+                if (gjkIndependent(s.vertices, s.count, w.w))
+                {
+                    s.vertices[s.count++] = w;
+                }
+            }
+        }
+
+        if (s.count == 0)
+        {
+            Vec3f d = b.getCenter() - a.getCenter();
+            s.vertices[s.count++] = gjkSupport(a, b, d.slength() > 0.0f ? d : Vec3f::X_AXIS);
+        }
+
+        while (iterations < GJK_MAX_ITERATIONS)
+        {
+            if (!gjkClosest(s, v))
+            {
+                return false;
+            }
+
+            // The origin is on the simplex
+            float vv = v * v;
+            float scale = 0.0f;
+
+            for (int i = 0; i < s.count; ++i)
+            {
+                scale = std::max(scale, s.vertices[i].w.slength());
+            }
+
+            if (vv <= Math<float>::EPSILON * scale)
+            {
+                return false;
+            }
+
+            GJKVertex w = gjkSupport(a, b, -v);
+            float vw = v * w.w;
+            ++iterations;
+
+            // v * w / |v| is a lower bound of the distance
+            if (separation >= 0.0f && vw > 0.0f && vw * vw > separation * separation * vv)
+            {
+                return true;
+            }
+
+            if (vv - vw <= GJK_TOLERANCE * vv || !gjkIndependent(s.vertices, s.count, w.w))
+            {
+                return true;
+            }
+
+            s.vertices[s.count++] = w;
+        }
+
+        return gjkClosest(s, v);
+    }
+
+
+
+    /**
+     * Keep the search directions of a simplex for the next query.
+     */
+    static void gjkStore(const GJKSimplex& s, GJK::Cache* cache)
+    {
+        if (cache == nullptr)
+        {
+            return;
+        }
+
+        cache->count = s.count;
+
+        for (int i = 0; i < s.count; ++i)
+        {
+            cache->directions[i] = s.vertices[i].direction;
+        }
+    }
+
+
+
+    /**
+     * \brief Fill a result from the closest points of the cores, separated by
+     * @v (their difference).
+     * 
+     * @return True if the shapes are separated.
+     */
+    static bool gjkCoreResult(const ConvexShape& a, const ConvexShape& b, const GJKSimplex& s, const Vec3f& v,
+                              GJK::Result& result)
+    {
+        Vec3f pa(0.0f, 0.0f, 0.0f), pb(0.0f, 0.0f, 0.0f);
+
+        for (int i = 0; i < s.count; ++i)
+        {
+            pa += s.vertices[i].a * s.lambdas[i];
+            pb += s.vertices[i].b * s.lambdas[i];
+        }
+
+        float d = v.length();
+        result.normal = -v / d;
+        result.distance = d - a.getRadius() - b.getRadius();
+        result.pointA = pa + result.normal * a.getRadius();
+        result.pointB = pb - result.normal * b.getRadius();
+
+        return result.distance > 0.0f;
+    }
+
+
+
+    /**
+     * \brief Grow a simplex containing the origin into a tetrahedron.
+     * 
+     * @return False if A - B is flat and no tetrahedron exists.
+     */
+    static bool epaBlowUp(const ConvexShape& a, const ConvexShape& b, GJKVertex* vertices, int& count)
+    {
+        static const Vec3f axes[6] = { Vec3f(1.0f, 0.0f, 0.0f), Vec3f(-1.0f, 0.0f, 0.0f), Vec3f(0.0f, 1.0f, 0.0f),
+                                       Vec3f(0.0f, -1.0f, 0.0f), Vec3f(0.0f, 0.0f, 1.0f), Vec3f(0.0f, 0.0f, -1.0f) };
+
+        while (count < 4)
+        {
+            Vec3f directions[6];
+            int candidates = 0;
+
+            if (count == 1)
+            {
+                std::copy(axes, axes + 6, directions);
+                candidates = 6;
+            }
+            else if (count == 2)
+            {
+                // Perpendiculars of the segment
+                Vec3f d = vertices[1].w - vertices[0].w;
+                float ax = std::fabs(d.x), ay = std::fabs(d.y), az = std::fabs(d.z);
+                Vec3f axis = ax <= ay && ax <= az ? axes[0] : (ay <= az ? axes[2] : axes[4]);
+                Vec3f e1 = d.cross(axis), e2 = d.cross(e1);
+                directions[0] = e1;
+                directions[1] = -e1;
+                directions[2] = e2;
+                directions[3] = -e2;
+                candidates = 4;
+            }
+            else
+            {
+                Vec3f n = (vertices[1].w - vertices[0].w).cross(vertices[2].w - vertices[0].w);
+                directions[0] = n;
+                directions[1] = -n;
+                candidates = 2;
+            }
+
+            int before = count;
+
+            for (int i = 0; i < candidates && count == before; ++i)
+            {
+                GJKVertex w = gjkSupport(a, b, directions[i]);
+
+                if (gjkIndependent(vertices, count, w.w))
+                {
+                    vertices[count++] = w;
+                }
+            }
+
+            if (count == before)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+
+    static EPAFace epaFace(const GJKVertex* vertices, int i, int j, int k)
+    {
+        EPAFace face;
+        face.v[0] = i;
+        face.v[1] = j;
+        face.v[2] = k;
+        face.normal = (vertices[j].w - vertices[i].w).cross(vertices[k].w - vertices[i].w);
+
+        float length = face.normal.length();
+
+        if (length > 0.0f)
+        {
+            face.normal /= length;
+            face.distance = face.normal * vertices[i].w;
+        }
+        else
+        {
+            // Degenerate: never the closest face, never visible
+            face.distance = FLT_MAX;
+        }
+
+        return face;
+    }
+
+
+
+    /**
+     * Add an edge to the horizon, or remove it if its twin is there.
+     */
+    static void epaAddEdge(int edges[][2], int& count, int i, int j)
+    {
+        for (int e = 0; e < count; ++e)
+        {
+            if (edges[e][0] == j && edges[e][1] == i)
+            {
+                edges[e][0] = edges[count - 1][0];
+                edges[e][1] = edges[count - 1][1];
+                --count;
+                return;
+            }
+        }
+
+        edges[count][0] = i;
+        edges[count][1] = j;
+        ++count;
+    }
+
+
+
+    /**
+     * \brief Find the penetration of two shapes whose cores overlap, from the
+     * final GJK simplex.
+     * 
+     * The depth of a core grown by a radius is the depth of the core plus the
+     * radius, so the polytope only has to approximate the cores: it's exact
+     * for spheres and capsules, whose flat cores need no expansion at all.
+     */
+    static void epaRun(const ConvexShape& a, const ConvexShape& b, const GJKSimplex& s, GJK::Result& result)
+    {
+        GJKVertex vertices[EPA_MAX_VERTICES];
+        int vertexCount = s.count;
+        std::copy(s.vertices, s.vertices + s.count, vertices);
+
+        if (!epaBlowUp(a, b, vertices, vertexCount))
+        {
+            // Flat cores (points, segments or parallelograms): no depth across
+            // them, so the radii make all of it
+            Vec3f n = Vec3f::Z_AXIS;
+
+            if (vertexCount == 2)
+            {
+                Vec3f d = vertices[1].w - vertices[0].w;
+                n = d.cross(std::fabs(d.x) <= std::fabs(d.y) ? Vec3f::X_AXIS : Vec3f::Y_AXIS);
+            }
+            else if (vertexCount == 3)
+            {
+                n = (vertices[1].w - vertices[0].w).cross(vertices[2].w - vertices[0].w);
+            }
+
+            n.normalize();
+
+            Vec3f pa(0.0f, 0.0f, 0.0f), pb(0.0f, 0.0f, 0.0f);
+
+            for (int i = 0; i < s.count; ++i)
+            {
+                pa += s.vertices[i].a * s.lambdas[i];
+                pb += s.vertices[i].b * s.lambdas[i];
+            }
+
+            result.distance = -(a.getRadius() + b.getRadius());
+            result.normal = n;
+            result.pointA = pa + n * a.getRadius();
+            result.pointB = pb - n * b.getRadius();
+            return;
+        }
+
+        EPAFace faces[EPA_MAX_FACES];
+        int faceCount = 0;
+        static const int tetrahedron[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+        Vec3f centroid = (vertices[0].w + vertices[1].w + vertices[2].w + vertices[3].w) * 0.25f;
+
+        for (int f = 0; f < 4; ++f)
+        {
+            EPAFace face = epaFace(vertices, tetrahedron[f][0], tetrahedron[f][1], tetrahedron[f][2]);
+
+            // Wind the faces outward
+            if (face.normal * (vertices[face.v[0]].w - centroid) < 0.0f)
+            {
+                face = epaFace(vertices, tetrahedron[f][0], tetrahedron[f][2], tetrahedron[f][1]);
+            }
+
+            faces[faceCount++] = face;
+        }
+
+        int closest = 0;
+
+        for (int iteration = 0; ; ++iteration)
+        {
+            closest = 0;
+
+            for (int f = 1; f < faceCount; ++f)
+            {
+                if (faces[f].distance < faces[closest].distance)
+                {
+                    closest = f;
+                }
+            }
+
+            const EPAFace& face = faces[closest];
+            GJKVertex p = gjkSupport(a, b, face.normal);
+            float gain = p.w * face.normal - face.distance;
+
+            if (gain <= EPA_TOLERANCE * std::max(face.distance, EPA_TOLERANCE) || iteration == EPA_MAX_ITERATIONS ||
+                vertexCount == EPA_MAX_VERTICES)
+            {
+                break;
+            }
+
+            // Faces seen from the new point, and the edges around them
+            bool visible[EPA_MAX_FACES];
+            int edges[EPA_MAX_FACES][2];
+            int edgeCount = 0, visibleCount = 0;
+
+            for (int f = 0; f < faceCount; ++f)
+            {
+                const EPAFace& g = faces[f];
+                visible[f] = g.distance != FLT_MAX && g.normal * (p.w - vertices[g.v[0]].w) > 0.0f;
+
+                if (visible[f])
+                {
+                    epaAddEdge(edges, edgeCount, g.v[0], g.v[1]);
+                    epaAddEdge(edges, edgeCount, g.v[1], g.v[2]);
+                    epaAddEdge(edges, edgeCount, g.v[2], g.v[0]);
+                    ++visibleCount;
+                }
+            }
+
+            if (faceCount - visibleCount + edgeCount > EPA_MAX_FACES)
+            {
+                break;
+            }
+
+            int kept = 0;
+
+            for (int f = 0; f < faceCount; ++f)
+            {
+                if (!visible[f])
+                {
+                    faces[kept++] = faces[f];
+                }
+            }
+
+            faceCount = kept;
+            vertices[vertexCount] = p;
+
+            for (int e = 0; e < edgeCount; ++e)
+            {
+                faces[faceCount++] = epaFace(vertices, edges[e][0], edges[e][1], vertexCount);
+            }
+
+            ++vertexCount;
+        }
+
+        // Barycentric coordinates of the origin's projection on the face
+        const EPAFace& face = faces[closest];
+        float depth = std::max(face.distance, 0.0f);
+        const GJKVertex& v0 = vertices[face.v[0]];
+        const GJKVertex& v1 = vertices[face.v[1]];
+        const GJKVertex& v2 = vertices[face.v[2]];
+        Vec3f e0 = v1.w - v0.w, e1 = v2.w - v0.w, e2 = face.normal * depth - v0.w;
+        float d00 = e0 * e0, d01 = e0 * e1, d11 = e1 * e1, d20 = e2 * e0, d21 = e2 * e1;
+        float denominator = d00 * d11 - d01 * d01;
+        float l1 = 0.0f, l2 = 0.0f;
+
+        if (denominator > 0.0f)
+        {
+            l1 = (d11 * d20 - d01 * d21) / denominator;
+            l2 = (d00 * d21 - d01 * d20) / denominator;
+        }
+
+        float l0 = 1.0f - l1 - l2;
+
+        // The radii add to the depth of the cores
+        result.distance = -depth - a.getRadius() - b.getRadius();
+        result.normal = face.normal;
+        result.pointA = v0.a * l0 + v1.a * l1 + v2.a * l2 + face.normal * a.getRadius();
+        result.pointB = v0.b * l0 + v1.b * l1 + v2.b * l2 - face.normal * b.getRadius();
+    }
+
+
+
+    bool GJK::distance(const ConvexShape& a, const ConvexShape& b, Result& result, Cache* cache)
+    {
+        GJKSimplex s;
+        Vec3f v;
+        bool separated = gjkRun(a, b, -1.0f, cache, s, v, result.iterations);
+        gjkStore(s, cache);
+
+        if (separated && gjkCoreResult(a, b, s, v, result))
+        {
+            return true;
+        }
+
+        // Overlapping shapes are at zero distance
+        if (!separated)
+        {
+            result.normal = Vec3f::Z_AXIS;
+            result.pointA = result.pointB = s.vertices[0].a;
+        }
+
+        result.distance = 0.0f;
+
+        return false;
+    }
+
+
+
+    bool GJK::intersect(const ConvexShape& a, const ConvexShape& b, Cache* cache)
+    {
+        GJKSimplex s;
+        Vec3f v;
+        int iterations;
+        float radii = a.getRadius() + b.getRadius();
+        bool separated = gjkRun(a, b, radii, cache, s, v, iterations);
+        gjkStore(s, cache);
+
+        return !separated || v * v <= radii * radii;
+    }
+
+
+
+    bool GJK::penetration(const ConvexShape& a, const ConvexShape& b, Result& result, Cache* cache)
+    {
+        GJKSimplex s;
+        Vec3f v;
+        bool separated = gjkRun(a, b, -1.0f, cache, s, v, result.iterations);
+        gjkStore(s, cache);
+
+        // Separated cores: the radii give the depth, if any
+        if (separated)
+        {
+            return !gjkCoreResult(a, b, s, v, result);
+        }
+
+        epaRun(a, b, s, result);
+
+        return true;
+    }
+}
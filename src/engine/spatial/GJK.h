@@ -0,0 +1,116 @@
+/** 
+ * \file GJK.h
+ * \brief Distance, intersection and penetration queries between convex shapes
+ * (narrowphase).
+ * 
+ * The Gilbert-Johnson-Keerthi algorithm ("A fast procedure for computing the
+ * distance between complex objects in three-dimensional space", 1988) finds
+ * the point of the Minkowski difference of two shapes closest to the origin,
+ * refining a simplex of up to four support points; the closest point on the
+ * simplex is found with the Voronoi region tests of Ericson ("Real-Time
+ * Collision Detection", 2005). It runs on the shapes' cores and adds their
+ * radii afterwards (see @ConvexShape).
+ * 
+ * When the cores overlap, the Expanding Polytope Algorithm (van den Bergen,
+ * "Proximity queries and penetration depth computation on 3D game objects",
+ * 2001) grows the final simplex into a polytope inside the Minkowski
+ * difference of the cores until its face closest to the origin is on the
+ * boundary, which gives the penetration depth and normal; the radii add to
+ * that depth.
+ * 
+ * A @GJK::Cache kept per pair of shapes warm-starts the next query from the
+ * search directions of the last simplex. When the shapes moved a little since,
+ * those directions give almost the final simplex and the query converges in
+ * one or two iterations.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef GJK_H
+#define GJK_H
+
+#include "ConvexShape.h"
+#include "Vector.h"
+
+
+
+namespace nut
+{
+    class GJK
+    {
+        public:
+
+        /**
+         * \brief Simplex of the last query of a pair of shapes, as the search
+         * directions of its vertices.
+         */
+        struct Cache
+        {
+            Vec3f directions[4];
+            int count;
+
+            Cache() : count(0)
+            {
+            }
+        };
+
+        /**
+         * \brief Result of a query. The normal points from the first shape to
+         * the second one, and moving the second shape by @normal * -@distance
+         * brings the shapes in contact.
+         */
+        struct Result
+        {
+            float distance; /**< Distance between the shapes; minus the penetration depth when they overlap. */
+            Vec3f pointA;   /**< Closest (or deepest) point of the first shape. */
+            Vec3f pointB;   /**< Closest (or deepest) point of the second shape. */
+            Vec3f normal;   /**< Unit contact normal. */
+            int iterations; /**< Support evaluations of the GJK loop. */
+        };
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Compute the distance between two shapes and their closest
+         * points.
+         * 
+         * @param a First shape.
+         * @param b Second shape.
+         * @param result Receives the distance, the closest points and the
+         * normal; zero distance if the shapes overlap (see @penetration()).
+         * @param cache Warm-start data of the pair, updated, if not null.
+         * @return True if the shapes are separated.
+         */
+        static bool distance(const ConvexShape& a, const ConvexShape& b, Result& result, Cache* cache = nullptr);
+
+        /**
+         * \brief Check if two shapes overlap (touching counts as overlapping).
+         * 
+         * Stops as soon as a separating direction is found, so it's cheaper
+         * than @distance().
+         * 
+         * @param cache Warm-start data of the pair, updated, if not null.
+         */
+        static bool intersect(const ConvexShape& a, const ConvexShape& b, Cache* cache = nullptr);
+
+        /**
+         * \brief Compute the penetration depth of two shapes, or their
+         * distance if they don't overlap.
+         * 
+         * @param a First shape.
+         * @param b Second shape.
+         * @param result Receives the signed distance, the deepest points and
+         * the normal.
+         * @param cache Warm-start data of the pair, updated, if not null.
+         * @return True if the shapes overlap.
+         */
+        static bool penetration(const ConvexShape& a, const ConvexShape& b, Result& result, Cache* cache = nullptr);
+    };
+}
+
+#endif // GJK_H
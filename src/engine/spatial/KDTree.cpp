@@ -0,0 +1,498 @@
+/** 
+ * \file KDTree.cpp
+ * \brief Static k-d tree over a point cloud.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include "KDTree.h"
+#include "Mesh.h"
+#include "SIMD.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    const U32 KDTree::LEAF_SIZE;
+    const U32 KDTree::NO_POINT;
+
+    static const size_t KDTREE_TASK_SIZE = 16 * 1024; /**< Larger subtrees are built as separate tasks. */
+    static const int KDTREE_STACK_SIZE = 64;          /**< Traversal stack entries, more than the maximum depth. */
+
+
+
+    /**
+     * \brief Point moved around by the median selections, with its original
+     * index.
+     */
+    struct KDTreePoint
+    {
+        float p[3];
+        U32 index;
+    };
+
+    /**
+     * \brief Node range waiting to be visited, with a lower bound of the
+     * squared distance from the query point to its cell.
+     */
+    struct KDTreeEntry
+    {
+        U32 begin;
+        U32 end;
+        float distance;
+    };
+
+    /**
+     * \brief The @capacity nearest points found so far, as a max-heap on the
+     * squared distance stored in the caller's arrays.
+     */
+    struct KDTreeHeap
+    {
+        U32* indices;
+        float* distances;
+        size_t size;
+        size_t capacity;
+
+        /**
+         * Squared distance a point must beat to be kept.
+         */
+        float bound(float maxDistance2) const
+        {
+            return size < capacity ? maxDistance2 : distances[0];
+        }
+
+        void push(U32 index, float distance)
+        {
+            size_t i;
+
+            if (size < capacity)
+            {
+                // Sift up from the new slot
+                i = size++;
+
+                while (i > 0 && distances[(i - 1) / 2] < distance)
+                {
+                    indices[i] = indices[(i - 1) / 2];
+                    distances[i] = distances[(i - 1) / 2];
+                    i = (i - 1) / 2;
+                }
+            }
+            else
+            {
+                // Replace the farthest point and sift down
+                i = 0;
+
+                for (size_t child = 1; child < size; child = 2 * i + 1)
+                {
+                    if (child + 1 < size && distances[child + 1] > distances[child])
+                    {
+                        ++child;
+                    }
+
+                    if (distances[child] <= distance)
+                    {
+                        break;
+                    }
+
+                    indices[i] = indices[child];
+                    distances[i] = distances[child];
+                    i = child;
+                }
+            }
+
+            indices[i] = index;
+            distances[i] = distance;
+        }
+
+        /**
+         * Sort the points, nearest first (heap sort).
+         */
+        void sort()
+        {
+            for (size_t n = size; n > 1; --n)
+            {
+                U32 index = indices[n - 1];
+                float distance = distances[n - 1];
+                indices[n - 1] = indices[0];
+                distances[n - 1] = distances[0];
+
+                size_t i = 0;
+
+                for (size_t child = 1; child < n - 1; child = 2 * i + 1)
+                {
+                    if (child + 1 < n - 1 && distances[child + 1] > distances[child])
+                    {
+                        ++child;
+                    }
+
+                    if (distances[child] <= distance)
+                    {
+                        break;
+                    }
+
+                    indices[i] = indices[child];
+                    distances[i] = distances[child];
+                    i = child;
+                }
+
+                indices[i] = index;
+                distances[i] = distance;
+            }
+        }
+    };
+
+
+
+    /**
+     * Split the range [begin, end) at its median along the widest axis of its
+     * cell, then build both halves.
+     */
+    static void kdTreeBuild(KDTreePoint* points, U8* axes, size_t begin, size_t end, const float* lo, const float* hi)
+    {
+        if (end - begin <= KDTree::LEAF_SIZE)
+        {
+            return;
+        }
+
+        const float extent[3] = { hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] };
+        const int axis = extent[0] >= extent[1] ? (extent[0] >= extent[2] ? 0 : 2) : (extent[1] >= extent[2] ? 1 : 2);
+        const size_t middle = begin + (end - begin) / 2;
+
+        std::nth_element(points + begin, points + middle, points + end,
+                         [axis](const KDTreePoint& a, const KDTreePoint& b) { return a.p[axis] < b.p[axis]; });
+        axes[middle] = U8(axis);
+
+        // Children cells: the parent cell cut at the median
+        const float split = points[middle].p[axis];
+        float leftHi[3] = { hi[0], hi[1], hi[2] };
+        float rightLo[3] = { lo[0], lo[1], lo[2] };
+        leftHi[axis] = split;
+        rightLo[axis] = split;
+
+        if (end - begin > KDTREE_TASK_SIZE)
+        {
+            ThreadPool::getInstance().parallelInvoke(
+                [&]() { kdTreeBuild(points, axes, begin, middle, lo, leftHi); },
+                [&]() { kdTreeBuild(points, axes, middle + 1, end, rightLo, hi); });
+        }
+        else
+        {
+            kdTreeBuild(points, axes, begin, middle, lo, leftHi);
+            kdTreeBuild(points, axes, middle + 1, end, rightLo, hi);
+        }
+    }
+
+    /**
+     * Squared distances from a point to the points [i, i + WIDTH) of the
+     * arrays, and the mask of the lanes below @end.
+     */
+    static inline SIMDFloat kdTreeDistances(const float* x, const float* y, const float* z, const SIMDFloat* q,
+                                            U32 i, U32 end, SIMDFloat& valid)
+    {
+        SIMDFloat dx = SIMDFloat::loadu(x + i) - q[0];
+        SIMDFloat dy = SIMDFloat::loadu(y + i) - q[1];
+        SIMDFloat dz = SIMDFloat::loadu(z + i) - q[2];
+
+        valid = SIMDFloat::asFloat(SIMDInt::sequence() < SIMDInt(I32(end - i)));
+
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+
+
+    KDTree::KDTree()
+    {
+    }
+
+
+
+    bool KDTree::build(const Mesh& mesh)
+    {
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+
+        if (vertices.empty())
+        {
+            std::cerr << "nut::KDTree::build error. Mesh has no vertices.\n";
+            return false;
+        }
+
+        return build(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float));
+    }
+
+
+
+    bool KDTree::build(const float* positions, size_t count, size_t stride)
+    {
+        _x.clear();
+        _y.clear();
+        _z.clear();
+        _indices.clear();
+        _axes.clear();
+
+        if (count == 0)
+        {
+            std::cerr << "nut::KDTree::build error. No points.\n";
+            return false;
+        }
+
+        if (count >= size_t(NO_POINT))
+        {
+            std::cerr << "nut::KDTree::build error. Too many points.\n";
+            return false;
+        }
+
+        std::vector<KDTreePoint> points(count);
+
+        ThreadPool::getInstance().parallelFor(count, 64 * 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const float* p = positions + i * stride;
+                points[i].p[0] = p[0];
+                points[i].p[1] = p[1];
+                points[i].p[2] = p[2];
+                points[i].index = U32(i);
+            }
+        });
+
+        float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                lo[k] = std::min(lo[k], points[i].p[k]);
+                hi[k] = std::max(hi[k], points[i].p[k]);
+            }
+        }
+
+        _axes.resize(count, 0);
+        kdTreeBuild(&points[0], &_axes[0], 0, count, lo, hi);
+
+        // Structure of arrays in tree order; the padding lets leaves load whole registers
+        _x.resize(count + SIMDFloat::WIDTH, 0.0f);
+        _y.resize(count + SIMDFloat::WIDTH, 0.0f);
+        _z.resize(count + SIMDFloat::WIDTH, 0.0f);
+        _indices.resize(count);
+
+        ThreadPool::getInstance().parallelFor(count, 64 * 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                _x[i] = points[i].p[0];
+                _y[i] = points[i].p[1];
+                _z[i] = points[i].p[2];
+                _indices[i] = points[i].index;
+            }
+        });
+
+        return true;
+    }
+
+
+
+    size_t KDTree::nearest(const Vec3f& point, size_t k, U32* indices, float* squaredDistances,
+                           float epsilon, float maxDistance) const
+    {
+        if (isEmpty() || k == 0)
+        {
+            return 0;
+        }
+
+        const float q[3] = { point.x, point.y, point.z };
+        const SIMDFloat qs[3] = { SIMDFloat(point.x), SIMDFloat(point.y), SIMDFloat(point.z) };
+        const float scale = (1.0f + epsilon) * (1.0f + epsilon);
+        const float maxDistance2 = maxDistance < FLT_MAX ? maxDistance * maxDistance : FLT_MAX;
+        const float* x = &_x[0];
+        const float* y = &_y[0];
+        const float* z = &_z[0];
+
+        KDTreeHeap heap = { indices, squaredDistances, 0, k };
+        KDTreeEntry stack[KDTREE_STACK_SIZE];
+        int top = 0;
+
+        stack[top].begin = 0;
+        stack[top].end = U32(_indices.size());
+        stack[top++].distance = 0.0f;
+
+        while (top > 0)
+        {
+            const KDTreeEntry entry = stack[--top];
+
+            // Cells can be skipped when even the nearest point they may hold is too far
+            if (entry.distance * scale > heap.bound(maxDistance2))
+            {
+                continue;
+            }
+
+            if (entry.end - entry.begin <= LEAF_SIZE)
+            {
+                for (U32 i = entry.begin; i < entry.end; i += SIMDFloat::WIDTH)
+                {
+                    SIMDFloat valid;
+                    SIMDFloat d = kdTreeDistances(x, y, z, qs, i, entry.end, valid);
+                    int bits = SIMDFloat::movemask(valid & (d <= SIMDFloat(heap.bound(maxDistance2))));
+
+                    if (bits == 0)
+                    {
+                        continue;
+                    }
+
+                    ALIGNED_ALLOC_DECL(float, lanes[SIMDFloat::WIDTH], NUT_SIMD_ALIGNMENT);
+                    d.store(lanes);
+
+                    for (int lane = 0; lane < SIMDFloat::WIDTH; ++lane)
+                    {
+                        if ((bits >> lane & 1) && (heap.size < k ? lanes[lane] <= maxDistance2 : lanes[lane] < squaredDistances[0]))
+                        {
+                            heap.push(_indices[i + lane], lanes[lane]);
+                        }
+                    }
+                }
+
+                continue;
+            }
+
+            const U32 middle = entry.begin + (entry.end - entry.begin) / 2;
+            const int axis = _axes[middle];
+            const float dx = x[middle] - q[0], dy = y[middle] - q[1], dz = z[middle] - q[2];
+            const float d = dx * dx + dy * dy + dz * dz;
+
+            if (heap.size < k ? d <= maxDistance2 : d < squaredDistances[0])
+            {
+                heap.push(_indices[middle], d);
+            }
+
+            // Visit the side of the query point first; the other one is at least the plane distance away
+            const float offset = q[axis] - (axis == 0 ? x[middle] : (axis == 1 ? y[middle] : z[middle]));
+            const float farDistance = std::max(entry.distance, offset * offset);
+
+            if (offset < 0.0f)
+            {
+                stack[top].begin = middle + 1;
+                stack[top].end = entry.end;
+                stack[top++].distance = farDistance;
+                stack[top].begin = entry.begin;
+                stack[top].end = middle;
+                stack[top++].distance = entry.distance;
+            }
+            else
+            {
+                stack[top].begin = entry.begin;
+                stack[top].end = middle;
+                stack[top++].distance = farDistance;
+                stack[top].begin = middle + 1;
+                stack[top].end = entry.end;
+                stack[top++].distance = entry.distance;
+            }
+        }
+
+        heap.sort();
+
+        return heap.size;
+    }
+
+
+
+    void KDTree::nearest(const Vec3f* points, size_t count, size_t k, U32* indices, float* squaredDistances,
+                         float epsilon) const
+    {
+        ThreadPool::getInstance().parallelFor(count, 256, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                size_t found = nearest(points[i], k, indices + i * k, squaredDistances + i * k, epsilon);
+
+                for (size_t j = found; j < k; ++j)
+                {
+                    indices[i * k + j] = NO_POINT;
+                    squaredDistances[i * k + j] = FLT_MAX;
+                }
+            }
+        });
+    }
+
+
+
+    size_t KDTree::query(const Sphere& sphere, std::vector<U32>& points) const
+    {
+        if (isEmpty() || sphere.radius < 0.0f)
+        {
+            return 0;
+        }
+
+        const float q[3] = { sphere.center.x, sphere.center.y, sphere.center.z };
+        const SIMDFloat qs[3] = { SIMDFloat(q[0]), SIMDFloat(q[1]), SIMDFloat(q[2]) };
+        const float radius2 = sphere.radius * sphere.radius;
+        const SIMDFloat radius2s(radius2);
+        const float* x = &_x[0];
+        const float* y = &_y[0];
+        const float* z = &_z[0];
+        const size_t first = points.size();
+
+        KDTreeEntry stack[KDTREE_STACK_SIZE];
+        int top = 0;
+
+        stack[top].begin = 0;
+        stack[top].end = U32(_indices.size());
+        stack[top++].distance = 0.0f;
+
+        while (top > 0)
+        {
+            const KDTreeEntry entry = stack[--top];
+
+            if (entry.distance > radius2)
+            {
+                continue;
+            }
+
+            if (entry.end - entry.begin <= LEAF_SIZE)
+            {
+                for (U32 i = entry.begin; i < entry.end; i += SIMDFloat::WIDTH)
+                {
+                    SIMDFloat valid;
+                    SIMDFloat d = kdTreeDistances(x, y, z, qs, i, entry.end, valid);
+                    int bits = SIMDFloat::movemask(valid & (d <= radius2s));
+
+                    for (int lane = 0; bits != 0; ++lane, bits >>= 1)
+                    {
+                        if (bits & 1)
+                        {
+                            points.push_back(_indices[i + lane]);
+                        }
+                    }
+                }
+
+                continue;
+            }
+
+            const U32 middle = entry.begin + (entry.end - entry.begin) / 2;
+            const int axis = _axes[middle];
+            const float dx = x[middle] - q[0], dy = y[middle] - q[1], dz = z[middle] - q[2];
+
+            if (dx * dx + dy * dy + dz * dz <= radius2)
+            {
+                points.push_back(_indices[middle]);
+            }
+
+            const float offset = q[axis] - (axis == 0 ? x[middle] : (axis == 1 ? y[middle] : z[middle]));
+            const float farDistance = std::max(entry.distance, offset * offset);
+
+            stack[top].begin = entry.begin;
+            stack[top].end = middle;
+            stack[top++].distance = offset < 0.0f ? entry.distance : farDistance;
+            stack[top].begin = middle + 1;
+            stack[top].end = entry.end;
+            stack[top++].distance = offset < 0.0f ? farDistance : entry.distance;
+        }
+
+        return points.size() - first;
+    }
+}
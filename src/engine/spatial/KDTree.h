@@ -0,0 +1,167 @@
+/** 
+ * \file KDTree.h
+ * \brief Static k-d tree over a point cloud, for nearest neighbor and radius
+ * queries.
+ * 
+ * The tree is implicit: the points are reordered so that the node of a range
+ * [begin, end) of the array is its middle point, with the left subtree in
+ * [begin, middle) and the right one in (middle, end). There are no node
+ * records or pointers, only the split axis of each middle point; ranges of at
+ * most @LEAF_SIZE points are leaves. Each node splits its cell along the
+ * widest axis at the median, found with a selection (nth_element), and large
+ * subtrees are built as parallel tasks on the @ThreadPool.
+ * 
+ * Points are stored as separate x, y and z arrays, so leaves are scanned
+ * @SIMDFloat::WIDTH points at a time. Nearest neighbor queries can be
+ * approximate (Arya et al., "An optimal algorithm for approximate nearest
+ * neighbor searching in fixed dimensions", 1998): with an error bound
+ * epsilon, the neighbors found are at most 1 + epsilon times farther than the
+ * true ones, and many more cells are skipped.
+ * 
+ * Point clouds loaded through @ModelResourceFile (e.g. PLY or OFF files) are
+ * meshes without triangles; the tree is built from their vertex positions.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include <cfloat>
+#include <cstddef>
+#include <vector>
+#include "DataType.h"
+#include "Sphere.h"
+#include "Vector.h"
+
+
+
+namespace nut
+{
+    class Mesh;
+
+    class KDTree
+    {
+        public:
+
+        static const U32 LEAF_SIZE = 8;         /**< Ranges of at most this many points are leaves. */
+        static const U32 NO_POINT = 0xFFFFFFFF; /**< Index of the neighbors that were not found. */
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor. Instantiates an empty tree.
+         */
+        KDTree();
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Build the tree over the vertex positions of a mesh.
+         * 
+         * @param mesh Mesh or point cloud; its triangles are ignored.
+         * @return False if the mesh has no vertices.
+         */
+        bool build(const Mesh& mesh);
+
+        /**
+         * \brief Build the tree over an array of points.
+         * 
+         * @param positions Address of the first point's x coordinate.
+         * @param count Number of points.
+         * @param stride Distance between consecutive points, in floats.
+         * @return False if there are no points.
+         */
+        bool build(const float* positions, size_t count, size_t stride);
+
+        /**
+         * \brief Find the @k points closest to a point.
+         * 
+         * @param point Query point.
+         * @param k Number of neighbors wanted.
+         * @param indices Receives the original indices of the neighbors, nearest
+         * first (room for @k values).
+         * @param squaredDistances Receives their squared distances (room for @k
+         * values).
+         * @param epsilon Error bound: the i-th neighbor found is at most
+         * 1 + @epsilon times farther than the true i-th neighbor. Zero for an
+         * exact search.
+         * @param maxDistance Points farther than this are ignored.
+         * @return Number of neighbors found, less than @k if the tree has fewer
+         * points within @maxDistance.
+         */
+        size_t nearest(const Vec3f& point, size_t k, U32* indices, float* squaredDistances,
+                       float epsilon = 0.0f, float maxDistance = FLT_MAX) const;
+
+        /**
+         * \brief Find the @k nearest neighbors of a batch of points, spread
+         * across the @ThreadPool.
+         * 
+         * @param points Query points.
+         * @param count Number of query points.
+         * @param k Number of neighbors wanted per point.
+         * @param indices Receives @k indices per point (@count * @k values);
+         * the slots of neighbors that were not found hold @NO_POINT.
+         * @param squaredDistances Receives @k squared distances per point; FLT_MAX
+         * for neighbors that were not found.
+         * @param epsilon Error bound, as above.
+         */
+        void nearest(const Vec3f* points, size_t count, size_t k, U32* indices, float* squaredDistances,
+                     float epsilon = 0.0f) const;
+
+        /**
+         * \brief Find the points inside a sphere (the radius query).
+         * 
+         * @param sphere Query region.
+         * @param points The original indices of the points found are appended
+         * to it, in no particular order.
+         * @return Number of points found.
+         */
+        size_t query(const Sphere& sphere, std::vector<U32>& points) const;
+
+        /**
+         * Get the number of points.
+         */
+        size_t getNumberOfPoints() const
+        {
+            return _indices.size();
+        }
+
+        /**
+         * Check if the tree has no points.
+         */
+        bool isEmpty() const
+        {
+            return _indices.empty();
+        }
+
+        /**
+         * Get the original index of each point, in tree order.
+         */
+        const std::vector<U32>& getIndices() const
+        {
+            return _indices;
+        }
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        std::vector<float> _x;       /**< Coordinates in tree order, padded by @SIMDFloat::WIDTH values. */
+        std::vector<float> _y;
+        std::vector<float> _z;
+        std::vector<U32> _indices;   /**< Original index of each point, in tree order. */
+        std::vector<U8> _axes;       /**< Split axis of each node, stored at its middle point. */
+    };
+}
+
+#endif // KDTREE_H
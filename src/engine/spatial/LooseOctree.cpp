@@ -0,0 +1,730 @@
+/** 
+ * \file LooseOctree.cpp
+ * \brief Loose octree over static and slowly moving scene objects, for
+ * frustum, sphere, box and ray queries.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "LooseOctree.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    const U32 LooseOctree::NULL_INDEX = 0xFFFFFFFF;
+    const int LooseOctree::MAX_DEPTH = 16;
+
+    static const size_t LOOSE_OCTREE_SPLIT_COUNT = 16;      /**< Objects a leaf holds before it splits. */
+    static const size_t LOOSE_OCTREE_MERGE_COUNT = 8;       /**< Objects of a subtree below which it merges into its root. */
+    static const size_t LOOSE_OCTREE_PARALLEL_COUNT = 4096; /**< Objects from which queries split the top-level octants across threads. */
+    static const int LOOSE_OCTREE_STACK_SIZE = 8 * 16 + 1;  /**< Ray traversal stack: up to eight children per level below the root. */
+
+
+
+    /**
+     * \brief How a node's loose bounds relate to a query region.
+     */
+    enum LooseOctreeOverlap
+    {
+        LOOSE_OCTREE_OUTSIDE,    /**< No object of the subtree can be found. */
+        LOOSE_OCTREE_INTERSECTS, /**< The objects of the subtree must be tested. */
+        LOOSE_OCTREE_INSIDE      /**< Every object of the subtree is found. */
+    };
+
+
+
+    /**
+     * \brief Query regions. @classify() places a node's loose bounds relative to
+     * the region and @filter() writes the indices of the boxes of an array that
+     * the region accepts, in increasing order.
+     */
+    struct LooseOctreeFrustumRegion
+    {
+        const Frustum& frustum;
+
+        LooseOctreeOverlap classify(const BoundingBox& bounds) const
+        {
+            Vec3f c = bounds.getCenter(), e = bounds.getExtents();
+            LooseOctreeOverlap overlap = LOOSE_OCTREE_INSIDE;
+
+            for (int i = 0; i < 6; ++i)
+            {
+                const Plane& plane = frustum.getPlane(i);
+                float d = plane.getSignedDistance(c);
+                float r = e.x * std::fabs(plane.normal.x) + e.y * std::fabs(plane.normal.y) + e.z * std::fabs(plane.normal.z);
+
+                if (d < -r)
+                {
+                    return LOOSE_OCTREE_OUTSIDE;
+                }
+
+                if (d < r)
+                {
+                    overlap = LOOSE_OCTREE_INTERSECTS;
+                }
+            }
+
+            return overlap;
+        }
+
+        size_t filter(const BoundingBox* boxes, size_t count, U32* indices) const
+        {
+            return frustum.cullBoxes(boxes, count, indices);
+        }
+    };
+
+
+
+    struct LooseOctreeSphereRegion
+    {
+        const Sphere& sphere;
+
+        LooseOctreeOverlap classify(const BoundingBox& bounds) const
+        {
+            if (!sphere.overlaps(bounds))
+            {
+                return LOOSE_OCTREE_OUTSIDE;
+            }
+
+            // Farthest corner of the bounds
+            float dx = std::max(std::fabs(sphere.center.x - bounds.min.x), std::fabs(sphere.center.x - bounds.max.x));
+            float dy = std::max(std::fabs(sphere.center.y - bounds.min.y), std::fabs(sphere.center.y - bounds.max.y));
+            float dz = std::max(std::fabs(sphere.center.z - bounds.min.z), std::fabs(sphere.center.z - bounds.max.z));
+
+            return dx * dx + dy * dy + dz * dz <= sphere.radius * sphere.radius ? LOOSE_OCTREE_INSIDE : LOOSE_OCTREE_INTERSECTS;
+        }
+
+        size_t filter(const BoundingBox* boxes, size_t count, U32* indices) const
+        {
+            size_t found = 0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (sphere.overlaps(boxes[i]))
+                {
+                    indices[found++] = U32(i);
+                }
+            }
+
+            return found;
+        }
+    };
+
+
+
+    struct LooseOctreeBoxRegion
+    {
+        const BoundingBox& box;
+
+        LooseOctreeOverlap classify(const BoundingBox& bounds) const
+        {
+            if (!box.overlaps(bounds))
+            {
+                return LOOSE_OCTREE_OUTSIDE;
+            }
+
+            return box.contains(bounds) ? LOOSE_OCTREE_INSIDE : LOOSE_OCTREE_INTERSECTS;
+        }
+
+        size_t filter(const BoundingBox* boxes, size_t count, U32* indices) const
+        {
+            return BoundingBox::overlaps(boxes, count, box, indices);
+        }
+    };
+
+
+
+    struct LooseOctreeRayRegion
+    {
+        const Ray& ray;
+
+        LooseOctreeOverlap classify(const BoundingBox& bounds) const
+        {
+            return bounds.intersect(ray.origin, ray.invDirection, ray.tMin, ray.tMax) ? LOOSE_OCTREE_INTERSECTS
+                                                                                     : LOOSE_OCTREE_OUTSIDE;
+        }
+
+        size_t filter(const BoundingBox* boxes, size_t count, U32* indices) const
+        {
+            size_t found = 0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (boxes[i].intersect(ray.origin, ray.invDirection, ray.tMin, ray.tMax))
+                {
+                    indices[found++] = U32(i);
+                }
+            }
+
+            return found;
+        }
+    };
+
+
+
+    /**
+     * Ray traversal stack entry: a node and the distance where the ray enters
+     * its loose bounds.
+     */
+    struct LooseOctreeEntry
+    {
+        U32 node;
+        float t;
+    };
+
+
+
+    LooseOctree::LooseOctree(const Vec3f& center, float halfSize, int maxDepth, float looseness) :
+        _maxDepth(std::max(0, std::min(maxDepth, MAX_DEPTH))), _looseness(looseness), _freeObject(NULL_INDEX)
+    {
+        Node root;
+        root.center = center;
+        root.halfSize = halfSize;
+        root.parent = NULL_INDEX;
+        root.children = NULL_INDEX;
+        root.count = 0;
+        root.depth = 0;
+
+        _nodes.push_back(root);
+    }
+
+
+
+    void LooseOctree::clear()
+    {
+        _nodes.resize(1);
+        _freeBlocks.clear();
+        _nodes[0].children = NULL_INDEX;
+        _nodes[0].boxes.clear();
+        _nodes[0].objects.clear();
+        _nodes[0].count = 0;
+
+        _objects.clear();
+        _freeObject = NULL_INDEX;
+    }
+
+
+
+    U32 LooseOctree::insert(const BoundingBox& box, U32 userData)
+    {
+        U32 object = _freeObject;
+
+        if (object == NULL_INDEX)
+        {
+            object = U32(_objects.size());
+            _objects.push_back(Object());
+        }
+        else
+        {
+            _freeObject = _objects[object].slot;
+        }
+
+        U32 node = _findNode(box);
+        _objects[object].userData = userData;
+        _attach(object, node, box);
+        _splitFull(node);
+
+        return object;
+    }
+
+
+
+    void LooseOctree::remove(U32 object)
+    {
+        _detach(object);
+
+        _objects[object].node = NULL_INDEX;
+        _objects[object].slot = _freeObject;
+        _freeObject = object;
+    }
+
+
+
+    bool LooseOctree::update(U32 object, const BoundingBox& box)
+    {
+        const Object& o = _objects[object];
+
+        // Still in its node: only the box changes
+        if (_findNode(box) == o.node)
+        {
+            _nodes[o.node].boxes[o.slot] = box;
+            return false;
+        }
+
+        // Detach first, since it may merge the node the object goes to
+        _detach(object);
+
+        U32 node = _findNode(box);
+        _attach(object, node, box);
+        _splitFull(node);
+
+        return true;
+    }
+
+
+
+    BoundingBox LooseOctree::getLooseBounds(U32 node) const
+    {
+        const Node& n = _nodes[node];
+        float h = n.halfSize * _looseness;
+
+        return BoundingBox(n.center - Vec3f(h, h, h), n.center + Vec3f(h, h, h));
+    }
+
+
+
+    size_t LooseOctree::query(const Frustum& frustum, std::vector<U32>& objects) const
+    {
+        LooseOctreeFrustumRegion region = { frustum };
+        return _query(region, objects);
+    }
+
+
+
+    size_t LooseOctree::query(const Sphere& sphere, std::vector<U32>& objects) const
+    {
+        if (sphere.isEmpty())
+        {
+            return 0;
+        }
+
+        LooseOctreeSphereRegion region = { sphere };
+        return _query(region, objects);
+    }
+
+
+
+    size_t LooseOctree::query(const BoundingBox& box, std::vector<U32>& objects) const
+    {
+        if (box.isEmpty())
+        {
+            return 0;
+        }
+
+        LooseOctreeBoxRegion region = { box };
+        return _query(region, objects);
+    }
+
+
+
+    size_t LooseOctree::query(const Ray& ray, std::vector<U32>& objects) const
+    {
+        LooseOctreeRayRegion region = { ray };
+        return _query(region, objects);
+    }
+
+
+
+    U32 LooseOctree::raycast(const Ray& ray, const RayCallback& callback, float* t) const
+    {
+        U32 hit = NULL_INDEX;
+        Ray clipped = ray;
+
+        LooseOctreeEntry stack[LOOSE_OCTREE_STACK_SIZE];
+        int size = 0;
+
+        // The root also holds objects outside its loose bounds, so it's always
+        // visited
+        if (_nodes[0].count > 0)
+        {
+            stack[size].node = 0;
+            stack[size++].t = ray.tMin;
+        }
+
+        while (size > 0)
+        {
+            const LooseOctreeEntry current = stack[--size];
+
+            // Entered beyond a hit found after it was pushed
+            if (current.t > clipped.tMax)
+            {
+                continue;
+            }
+
+            const Node& node = _nodes[current.node];
+
+            for (size_t i = 0; i < node.boxes.size(); ++i)
+            {
+                if (node.boxes[i].intersect(ray.origin, ray.invDirection, clipped.tMin, clipped.tMax))
+                {
+                    float tHit = callback(node.objects[i], clipped);
+
+                    if (tHit < clipped.tMax && tHit >= clipped.tMin)
+                    {
+                        clipped.tMax = tHit;
+                        hit = node.objects[i];
+                    }
+                }
+            }
+
+            if (node.children == NULL_INDEX)
+            {
+                continue;
+            }
+
+            // Push the children hit from far to near, so the nearest is popped
+            // next
+            int first = size;
+
+            for (U32 child = node.children; child < node.children + 8; ++child)
+            {
+                float entry;
+
+                if (_nodes[child].count == 0 ||
+                    !getLooseBounds(child).intersect(ray.origin, ray.invDirection, clipped.tMin, clipped.tMax, &entry))
+                {
+                    continue;
+                }
+
+                int i = size++;
+
+                for (; i > first && stack[i - 1].t < entry; --i)
+                {
+                    stack[i] = stack[i - 1];
+                }
+
+                stack[i].node = child;
+                stack[i].t = entry;
+            }
+        }
+
+        if (t != nullptr)
+        {
+            *t = clipped.tMax;
+        }
+
+        return hit;
+    }
+
+
+
+    int LooseOctree::_findOctant(U32 node, const BoundingBox& box) const
+    {
+        const Node& n = _nodes[node];
+
+        if (n.depth >= _maxDepth || box.isEmpty())
+        {
+            return -1;
+        }
+
+        Vec3f c = box.getCenter(), e = box.getExtents();
+        float childHalfSize = n.halfSize * 0.5f;
+
+        if (std::max(e.x, std::max(e.y, e.z)) > childHalfSize * (_looseness - 1.0f))
+        {
+            return -1;
+        }
+
+        // Child cell containing the center; the containment test settles
+        // rounding errors and centers outside the root cell
+        int octant = (c.x >= n.center.x ? 1 : 0) | (c.y >= n.center.y ? 2 : 0) | (c.z >= n.center.z ? 4 : 0);
+        Vec3f childCenter(n.center.x + (octant & 1 ? childHalfSize : -childHalfSize),
+                          n.center.y + (octant & 2 ? childHalfSize : -childHalfSize),
+                          n.center.z + (octant & 4 ? childHalfSize : -childHalfSize));
+        float h = childHalfSize * _looseness;
+
+        return BoundingBox(childCenter - Vec3f(h, h, h), childCenter + Vec3f(h, h, h)).contains(box) ? octant : -1;
+    }
+
+
+
+    U32 LooseOctree::_findNode(const BoundingBox& box) const
+    {
+        U32 node = 0;
+        int octant;
+
+        while (_nodes[node].children != NULL_INDEX && (octant = _findOctant(node, box)) >= 0)
+        {
+            node = _nodes[node].children + U32(octant);
+        }
+
+        return node;
+    }
+
+
+
+    void LooseOctree::_splitFull(U32 node)
+    {
+        if (_nodes[node].children != NULL_INDEX || _nodes[node].objects.size() <= LOOSE_OCTREE_SPLIT_COUNT ||
+            _nodes[node].depth >= _maxDepth)
+        {
+            return;
+        }
+
+        U32 block;
+
+        if (_freeBlocks.empty())
+        {
+            block = U32(_nodes.size());
+            _nodes.resize(_nodes.size() + 8);
+        }
+        else
+        {
+            block = _freeBlocks.back();
+            _freeBlocks.pop_back();
+        }
+
+        Node& parent = _nodes[node];
+        float h = parent.halfSize * 0.5f;
+
+        for (U32 octant = 0; octant < 8; ++octant)
+        {
+            Node& child = _nodes[block + octant];
+            child.center = Vec3f(parent.center.x + (octant & 1 ? h : -h),
+                                 parent.center.y + (octant & 2 ? h : -h),
+                                 parent.center.z + (octant & 4 ? h : -h));
+            child.halfSize = h;
+            child.parent = node;
+            child.children = NULL_INDEX;
+            child.count = 0;
+            child.depth = parent.depth + 1;
+        }
+
+        parent.children = block;
+
+        // Push down the objects that fit a child, keeping the others in order
+        size_t kept = 0;
+
+        for (size_t i = 0; i < parent.objects.size(); ++i)
+        {
+            U32 object = parent.objects[i];
+            int octant = _findOctant(node, parent.boxes[i]);
+
+            if (octant < 0)
+            {
+                parent.boxes[kept] = parent.boxes[i];
+                parent.objects[kept] = object;
+                _objects[object].slot = U32(kept++);
+                continue;
+            }
+
+            Node& child = _nodes[block + U32(octant)];
+            _objects[object].node = block + U32(octant);
+            _objects[object].slot = U32(child.objects.size());
+            child.boxes.push_back(parent.boxes[i]);
+            child.objects.push_back(object);
+            ++child.count;
+        }
+
+        parent.boxes.resize(kept);
+        parent.objects.resize(kept);
+
+        for (U32 child = block; child < block + 8; ++child)
+        {
+            _splitFull(child);
+        }
+    }
+
+
+
+    void LooseOctree::_merge(U32 node, U32 into)
+    {
+        U32 block = _nodes[node].children;
+
+        if (block == NULL_INDEX)
+        {
+            return;
+        }
+
+        for (U32 child = block; child < block + 8; ++child)
+        {
+            Node& c = _nodes[child];
+            Node& n = _nodes[into];
+
+            for (size_t i = 0; i < c.objects.size(); ++i)
+            {
+                _objects[c.objects[i]].node = into;
+                _objects[c.objects[i]].slot = U32(n.objects.size());
+                n.boxes.push_back(c.boxes[i]);
+                n.objects.push_back(c.objects[i]);
+            }
+
+            c.boxes.clear();
+            c.objects.clear();
+            c.count = 0;
+            _merge(child, into);
+        }
+
+        _nodes[node].children = NULL_INDEX;
+        _freeBlocks.push_back(block);
+    }
+
+
+
+    void LooseOctree::_attach(U32 object, U32 node, const BoundingBox& box)
+    {
+        Node& n = _nodes[node];
+        _objects[object].node = node;
+        _objects[object].slot = U32(n.objects.size());
+        n.boxes.push_back(box);
+        n.objects.push_back(object);
+
+        for (U32 i = node; i != NULL_INDEX; i = _nodes[i].parent)
+        {
+            ++_nodes[i].count;
+        }
+    }
+
+
+
+    void LooseOctree::_detach(U32 object)
+    {
+        U32 node = _objects[object].node;
+        U32 slot = _objects[object].slot;
+        Node& n = _nodes[node];
+
+        // Swap with the last object of the node
+        U32 last = n.objects.back();
+        n.boxes[slot] = n.boxes.back();
+        n.objects[slot] = last;
+        _objects[last].slot = slot;
+        n.boxes.pop_back();
+        n.objects.pop_back();
+
+        U32 sparse = NULL_INDEX;
+
+        for (U32 i = node; i != NULL_INDEX; i = _nodes[i].parent)
+        {
+            if (--_nodes[i].count <= LOOSE_OCTREE_MERGE_COUNT && _nodes[i].children != NULL_INDEX)
+            {
+                sparse = i;
+            }
+        }
+
+        if (sparse != NULL_INDEX)
+        {
+            _merge(sparse, sparse);
+        }
+    }
+
+
+
+    void LooseOctree::_collectAll(U32 node, std::vector<U32>& objects) const
+    {
+        const Node& n = _nodes[node];
+        objects.insert(objects.end(), n.objects.begin(), n.objects.end());
+
+        if (n.children == NULL_INDEX)
+        {
+            return;
+        }
+
+        for (U32 child = n.children; child < n.children + 8; ++child)
+        {
+            if (_nodes[child].count > 0)
+            {
+                _collectAll(child, objects);
+            }
+        }
+    }
+
+
+
+    template<class Region>
+    size_t LooseOctree::_query(const Region& region, std::vector<U32>& objects) const
+    {
+        const Node& root = _nodes[0];
+        size_t before = objects.size();
+
+        if (root.count < LOOSE_OCTREE_PARALLEL_COUNT || root.children == NULL_INDEX)
+        {
+            std::vector<U32> scratch;
+            _collect(0, region, objects, scratch);
+            return objects.size() - before;
+        }
+
+        // The root's own objects, then each octant into its own list
+        std::vector<U32> octants[8];
+        std::vector<U32> scratch(root.boxes.size());
+        size_t found = region.filter(root.boxes.empty() ? nullptr : &root.boxes[0], root.boxes.size(),
+                                     scratch.empty() ? nullptr : &scratch[0]);
+
+        for (size_t i = 0; i < found; ++i)
+        {
+            objects.push_back(root.objects[scratch[i]]);
+        }
+
+        ThreadPool::getInstance().parallelFor(8, 1,
+            [&](size_t begin, size_t end)
+            {
+                std::vector<U32> childScratch;
+
+                for (size_t octant = begin; octant < end; ++octant)
+                {
+                    U32 child = root.children + U32(octant);
+                    LooseOctreeOverlap overlap = _nodes[child].count == 0 ? LOOSE_OCTREE_OUTSIDE
+                                                                          : region.classify(getLooseBounds(child));
+
+                    if (overlap == LOOSE_OCTREE_INSIDE)
+                    {
+                        _collectAll(child, octants[octant]);
+                    }
+                    else if (overlap == LOOSE_OCTREE_INTERSECTS)
+                    {
+                        _collect(child, region, octants[octant], childScratch);
+                    }
+                }
+            });
+
+        for (int octant = 0; octant < 8; ++octant)
+        {
+            objects.insert(objects.end(), octants[octant].begin(), octants[octant].end());
+        }
+
+        return objects.size() - before;
+    }
+
+
+
+    template<class Region>
+    void LooseOctree::_collect(U32 node, const Region& region, std::vector<U32>& objects, std::vector<U32>& scratch) const
+    {
+        const Node& n = _nodes[node];
+
+        if (!n.boxes.empty())
+        {
+            if (scratch.size() < n.boxes.size())
+            {
+                scratch.resize(n.boxes.size());
+            }
+
+            size_t found = region.filter(&n.boxes[0], n.boxes.size(), &scratch[0]);
+
+            for (size_t i = 0; i < found; ++i)
+            {
+                objects.push_back(n.objects[scratch[i]]);
+            }
+        }
+
+        if (n.children == NULL_INDEX)
+        {
+            return;
+        }
+
+        for (U32 child = n.children; child < n.children + 8; ++child)
+        {
+            if (_nodes[child].count == 0)
+            {
+                continue;
+            }
+
+            LooseOctreeOverlap overlap = region.classify(getLooseBounds(child));
+
+            if (overlap == LOOSE_OCTREE_INSIDE)
+            {
+                _collectAll(child, objects);
+            }
+            else if (overlap == LOOSE_OCTREE_INTERSECTS)
+            {
+                _collect(child, region, objects, scratch);
+            }
+        }
+    }
+}
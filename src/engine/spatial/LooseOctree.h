@@ -0,0 +1,315 @@
+/** 
+ * \file LooseOctree.h
+ * \brief Loose octree over static and slowly moving scene objects, for
+ * frustum, sphere, box and ray queries.
+ * 
+ * The cells of a loose octree are grown by a factor (2 by default) into the
+ * bounds that hold their objects, so an object whose size is at most the cell
+ * size times (factor - 1) fits in the cell containing its center (Ulrich,
+ * "Loose octrees", Game Programming Gems, 2000). Unlike a regular octree an
+ * object never straddles a split, and moving it only has to find the cell of
+ * its new center: @update() changes the object's box in place while it stays
+ * in its node, and otherwise moves it to another node, without any rebuild.
+ * 
+ * Leaves split when they hold too many objects and subtrees merge back when
+ * they hold few, so sparse regions don't cost a chain of nodes per object.
+ * Nodes come in blocks of eight siblings, taken from a pool (a contiguous
+ * array with a list of free blocks). Each node stores the boxes of its
+ * objects in a contiguous array, which queries test with the bulk SIMD
+ * methods of @BoundingBox and @Frustum; subtrees entirely inside the query
+ * region are accepted without testing their objects.
+ * 
+ * Queries are const and may run concurrently. When the tree holds enough
+ * objects, a query visits the eight top-level octants in parallel on the
+ * @ThreadPool; results are appended in the same order either way.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef LOOSEOCTREE_H
+#define LOOSEOCTREE_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "BoundingBox.h"
+#include "DataType.h"
+#include "Frustum.h"
+#include "Ray.h"
+#include "Sphere.h"
+#include "Vector.h"
+
+
+
+namespace nut
+{
+    class LooseOctree
+    {
+        public:
+
+        static const U32 NULL_INDEX; /**< Invalid node (and object) index. */
+        static const int MAX_DEPTH;  /**< Largest depth a tree can be given. */
+
+        /**
+         * Called by @raycast() for each object whose box is hit. Returns the
+         * distance of the closest hit with the object, or the ray's tMax if
+         * there's none.
+         */
+        typedef std::function<float(U32 object, const Ray& ray)> RayCallback;
+
+
+
+        /// Constructors ///
+
+        /**
+         * \brief Instantiates an empty tree.
+         * 
+         * Objects whose center is outside the root cell, or that are too large
+         * for its children, are kept in the root.
+         * 
+         * @param center Center of the root cell.
+         * @param halfSize Half the edge length of the root cell.
+         * @param maxDepth Depth of the smallest cells (clamped to @MAX_DEPTH).
+         * @param looseness Ratio between the bounds of a node and its cell,
+         * greater than 1.
+         */
+        LooseOctree(const Vec3f& center, float halfSize, int maxDepth = 8, float looseness = 2.0f);
+
+
+
+        /// Methods ///
+
+        /**
+         * Remove all objects.
+         */
+        void clear();
+
+        /**
+         * \brief Add an object.
+         * 
+         * @param box Bounds of the object.
+         * @param userData Value returned by @getUserData().
+         * @return The object id, valid until the object is removed.
+         */
+        U32 insert(const BoundingBox& box, U32 userData);
+
+        /**
+         * \brief Remove an object.
+         * 
+         * @param object Id returned by @insert().
+         */
+        void remove(U32 object);
+
+        /**
+         * \brief Change the bounds of an object.
+         * 
+         * @param object Id returned by @insert().
+         * @param box New bounds of the object.
+         * @return True if the object moved to another node.
+         */
+        bool update(U32 object, const BoundingBox& box);
+
+        /**
+         * Get the value given to @insert().
+         */
+        U32 getUserData(U32 object) const
+        {
+            return _objects[object].userData;
+        }
+
+        /**
+         * Get the bounds of an object.
+         */
+        const BoundingBox& getBounds(U32 object) const
+        {
+            return _nodes[_objects[object].node].boxes[_objects[object].slot];
+        }
+
+        /**
+         * Get the depth of the node holding an object (zero for the root).
+         */
+        int getDepth(U32 object) const
+        {
+            return _nodes[_objects[object].node].depth;
+        }
+
+        /**
+         * Get the number of objects.
+         */
+        size_t getNumberOfObjects() const
+        {
+            return _nodes[0].count;
+        }
+
+        /**
+         * Get the number of nodes in use, including the root.
+         */
+        size_t getNumberOfNodes() const
+        {
+            return _nodes.size() - 8 * _freeBlocks.size();
+        }
+
+        /**
+         * \brief Get the bounds a node's objects are inside of: its cell grown
+         * by the looseness factor.
+         */
+        BoundingBox getLooseBounds(U32 node) const;
+
+        /**
+         * \brief Find the objects whose boxes intersect a frustum.
+         * 
+         * @param frustum Query region.
+         * @param objects The objects found are appended to it.
+         * @return Number of objects found.
+         */
+        size_t query(const Frustum& frustum, std::vector<U32>& objects) const;
+
+        /**
+         * \brief Find the objects whose boxes overlap a sphere.
+         * 
+         * @param sphere Query region.
+         * @param objects The objects found are appended to it.
+         * @return Number of objects found.
+         */
+        size_t query(const Sphere& sphere, std::vector<U32>& objects) const;
+
+        /**
+         * \brief Find the objects whose boxes overlap a box.
+         * 
+         * @param box Query region.
+         * @param objects The objects found are appended to it.
+         * @return Number of objects found.
+         */
+        size_t query(const BoundingBox& box, std::vector<U32>& objects) const;
+
+        /**
+         * \brief Find the objects whose boxes are hit by a ray within
+         * [tMin, tMax].
+         * 
+         * @param ray Ray.
+         * @param objects The objects found are appended to it.
+         * @return Number of objects found.
+         */
+        size_t query(const Ray& ray, std::vector<U32>& objects) const;
+
+        /**
+         * \brief Find the closest object hit by a ray.
+         * 
+         * Nodes are visited roughly near to far and the ray is clipped at each
+         * hit the callback reports, so most objects behind the closest hit are
+         * skipped.
+         * 
+         * @param ray Ray.
+         * @param callback Exact test against an object.
+         * @param t Receives the distance of the closest hit, if not null.
+         * @return The object hit, or @NULL_INDEX.
+         */
+        U32 raycast(const Ray& ray, const RayCallback& callback, float* t = nullptr) const;
+
+
+
+        private:
+
+        /**
+         * \brief Tree node. The root is node 0; other nodes come in blocks of
+         * eight siblings, ordered by octant (bit 0 for +x, 1 for +y, 2 for +z).
+         */
+        struct Node
+        {
+            Vec3f center;                   /**< Center of the cell. */
+            float halfSize;                 /**< Half the edge length of the cell. */
+            U32 parent;                     /**< Parent node, or @NULL_INDEX for the root. */
+            U32 children;                   /**< First of the eight children, or @NULL_INDEX. */
+            U32 count;                      /**< Objects in the subtree. */
+            int depth;
+            std::vector<BoundingBox> boxes; /**< Boxes of the node's objects. */
+            std::vector<U32> objects;       /**< Ids of the node's objects, parallel to @boxes. */
+        };
+
+        /**
+         * \brief Object: its node and index in the node's arrays, or @node
+         * equal to @NULL_INDEX and @slot the next free object.
+         */
+        struct Object
+        {
+            U32 node;
+            U32 slot;
+            U32 userData;
+        };
+
+
+
+        /// Private attributes ///
+
+        int _maxDepth;
+        float _looseness;
+        std::vector<Node> _nodes;     /**< Node pool. */
+        std::vector<U32> _freeBlocks; /**< First node of each free block of the pool. */
+        std::vector<Object> _objects; /**< Object pool. */
+        U32 _freeObject;              /**< First free object of the pool. */
+
+
+
+        /// Private methods ///
+
+        /**
+         * \brief Find the child of a node an object would fit in: the octant
+         * containing its center, if the child's cell is large enough and its
+         * loose bounds contain the box.
+         * 
+         * @return The octant, or -1 if the object stays in the node.
+         */
+        int _findOctant(U32 node, const BoundingBox& box) const;
+
+        /**
+         * Find the deepest existing node an object fits in.
+         */
+        U32 _findNode(const BoundingBox& box) const;
+
+        /**
+         * \brief Split a leaf holding too many objects, pushing down the ones
+         * that fit its children, and the children in turn.
+         */
+        void _splitFull(U32 node);
+
+        /**
+         * Move the objects of the descendants of a node to another node and
+         * return the descendants to the pool.
+         */
+        void _merge(U32 node, U32 into);
+
+        /**
+         * Append an object to a node's arrays and count it up to the root.
+         */
+        void _attach(U32 object, U32 node, const BoundingBox& box);
+
+        /**
+         * \brief Remove an object from its node's arrays and uncount it up to
+         * the root, merging the highest subtree left with few objects.
+         */
+        void _detach(U32 object);
+
+        /**
+         * Append the objects of a subtree, without testing them.
+         */
+        void _collectAll(U32 node, std::vector<U32>& objects) const;
+
+        /**
+         * \brief Run a region query (see LooseOctree.cpp), over the top-level
+         * octants in parallel if the tree is large enough.
+         */
+        template<class Region>
+        size_t _query(const Region& region, std::vector<U32>& objects) const;
+
+        /**
+         * Append the objects of a subtree that @region accepts.
+         */
+        template<class Region>
+        void _collect(U32 node, const Region& region, std::vector<U32>& objects, std::vector<U32>& scratch) const;
+    };
+}
+
+#endif // LOOSEOCTREE_H
@@ -0,0 +1,162 @@
+/** 
+ * \file Picker.cpp
+ * \brief Picking service on a background thread.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include "Picker.h"
+
+
+
+namespace nut
+{
+    Picker::Picker() : _nextId(0), _inFlight(false), _busy(false), _stop(false)
+    {
+        _thread = std::thread(&Picker::_threadLoop, this);
+    }
+
+
+
+    Picker::~Picker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _wakeUp.notify_all();
+        _thread.join();
+    }
+
+
+
+    Ray Picker::getRay(float x, float y, const Vec4f& viewport, const GLMatrix<float>& inverseViewProjection)
+    {
+        Vec3f nearPoint = inverseViewProjection.unprojectWithInverse(Vec3f(x, y, 0.0f), viewport);
+        Vec3f farPoint = inverseViewProjection.unprojectWithInverse(Vec3f(x, y, 1.0f), viewport);
+        Vec3f direction = farPoint - nearPoint;
+        float length = direction.length();
+
+        return Ray(nearPoint, length > 0.0f ? direction / length : direction, 0.0f, length);
+    }
+
+
+
+    U32 Picker::pick(float x, float y)
+    {
+        Request request;
+        request.id = _nextId++;
+        request.screen = true;
+        request.x = x;
+        request.y = y;
+        _queued.push_back(request);
+
+        return request.id;
+    }
+
+
+
+    U32 Picker::pick(const Ray& ray)
+    {
+        Request request;
+        request.id = _nextId++;
+        request.screen = false;
+        request.x = request.y = 0.0f;
+        request.ray = ray;
+        _queued.push_back(request);
+
+        return request.id;
+    }
+
+
+
+    void Picker::update(const TLAS& scene, const GLMatrix<float>& viewProjection, const Vec4f& viewport,
+                        std::vector<Result>& results)
+    {
+        if (_inFlight)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            // Never stall the frame on the picks: try again on the next one
+            if (_busy)
+            {
+                return;
+            }
+
+            results.insert(results.end(), _results.begin(), _results.end());
+            _inFlight = false;
+        }
+
+        if (_queued.empty())
+        {
+            return;
+        }
+
+        // The thread is idle: its batch can be filled without locking
+        GLMatrix<float> inverse = viewProjection.inverse();
+        _results.resize(_queued.size());
+
+        for (size_t i = 0; i < _queued.size(); ++i)
+        {
+            const Request& request = _queued[i];
+            _results[i].request = request.id;
+            _results[i].ray = request.screen ? getRay(request.x, request.y, viewport, inverse) : request.ray;
+        }
+
+        _scene = scene;
+        _queued.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _busy = true;
+        }
+
+        _inFlight = true;
+        _wakeUp.notify_one();
+    }
+
+
+
+    void Picker::wait()
+    {
+        if (_inFlight)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _done.wait(lock, [this]() { return !_busy; });
+        }
+    }
+
+
+
+    void Picker::_threadLoop()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        for (;;)
+        {
+            _wakeUp.wait(lock, [this]() { return _busy || _stop; });
+
+            if (_stop)
+            {
+                return;
+            }
+
+            lock.unlock();
+
+            for (size_t i = 0; i < _results.size(); ++i)
+            {
+                Result& result = _results[i];
+                _scene.intersect(result.ray, result.hit);
+                result.point = result.ray.getPoint(result.hit.t);
+            }
+
+            lock.lock();
+            _busy = false;
+            _done.notify_all();
+        }
+    }
+}
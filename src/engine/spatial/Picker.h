@@ -0,0 +1,193 @@
+/** 
+ * \file Picker.h
+ * \brief Picking service: turns window coordinates into world rays and finds
+ * what they hit, on a background thread.
+ * 
+ * Pick requests are queued during a frame and handed over in one batch by
+ * @update(), which also returns the results of the previous batch once it is
+ * finished. @update() never waits: while a batch is running, new requests stay
+ * queued for a later frame. Editor selection on huge models then costs the main
+ * thread a copy of the top level, never the traversal of the meshes.
+ * 
+ * The batch is traced against a copy of the scene's @TLAS (its top-level tree
+ * over instance bounds), so instances can be moved and the top level refit or
+ * rebuilt right after @update(). The mesh @BVH of each instance is shared with
+ * the batch, though: it must not be refit, rebuilt or destroyed while
+ * @isPending(); call @wait() first.
+ * 
+ * Rays are traced one at a time on the picker's own thread, not the @ThreadPool.
+ * 
+ * Window coordinates follow OpenGL: pixels from the bottom left corner of the
+ * window (flip the y of mouse events from the top), as used by @GLMatrix::project().
+ * The view matrix is typically built with @GLMatrix::setLookAt() and the
+ * rotation of a @Trackball.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef PICKER_H
+#define PICKER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "DataType.h"
+#include "GLMatrix.h"
+#include "Ray.h"
+#include "TLAS.h"
+#include "Vector.h"
+
+
+
+namespace nut
+{
+    class Picker
+    {
+        public:
+
+        /**
+         * \brief Result of a pick request.
+         */
+        struct Result
+        {
+            U32 request;   /**< Id returned by @pick(). */
+            Ray ray;       /**< World ray: from the near plane, with a unit direction, up to the far plane. */
+            TLAS::Hit hit; /**< Closest hit; @hit.t is the distance from the near plane. */
+            Vec3f point;   /**< World position of the hit (meaningless if nothing was hit). */
+
+            /**
+             * Check if the ray hit a triangle.
+             */
+            bool isHit() const
+            {
+                return hit.instance != BVH::NO_HIT;
+            }
+        };
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor. Starts the picking thread.
+         */
+        Picker();
+
+        /**
+         * Destructor. Waits for the batch in flight and stops the thread.
+         */
+        ~Picker();
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Compute the world ray through a window position.
+         * 
+         * @param x, y Window coordinates, in pixels from the bottom left corner.
+         * @param viewport The viewport as (x, y, width, height).
+         * @param inverseViewProjection Inverse of the view-projection matrix.
+         * @return Ray from the near plane to the far plane, with a unit
+         * direction; tMax is the distance between the planes.
+         */
+        static Ray getRay(float x, float y, const Vec4f& viewport, const GLMatrix<float>& inverseViewProjection);
+
+        /**
+         * \brief Queue a pick at a window position, resolved with the camera
+         * given to the @update() that hands it over.
+         * 
+         * @param x, y Window coordinates, in pixels from the bottom left corner.
+         * @return Request id, found in the @Result.
+         */
+        U32 pick(float x, float y);
+
+        /**
+         * \brief Queue a pick along a world ray.
+         * 
+         * @return Request id, found in the @Result.
+         */
+        U32 pick(const Ray& ray);
+
+        /**
+         * \brief Exchange batches with the picking thread; call once per frame.
+         * 
+         * If the batch in flight is finished, appends its results and hands over
+         * the requests queued since it was. If it is still running, returns
+         * right away: nothing is appended and the requests stay queued.
+         * 
+         * @param scene The scene, built; it is copied. The bottom-level trees are
+         * shared, so they must not be rebuilt or refit while @isPending().
+         * @param viewProjection Matrix from world to clip space.
+         * @param viewport The viewport as (x, y, width, height).
+         * @param results The results of the previous batch are appended to it, in
+         * request order.
+         */
+        void update(const TLAS& scene, const GLMatrix<float>& viewProjection, const Vec4f& viewport,
+                    std::vector<Result>& results);
+
+        /**
+         * Check if a batch was handed over and its results not returned yet.
+         */
+        bool isPending() const
+        {
+            return _inFlight;
+        }
+
+        /**
+         * \brief Block until the batch in flight is finished, e.g. before
+         * refitting or rebuilding the bottom-level trees.
+         * 
+         * Its results are returned by the next @update().
+         */
+        void wait();
+
+
+
+        private:
+
+        /**
+         * \brief A queued request: a window position or a world ray.
+         */
+        struct Request
+        {
+            U32 id;
+            bool screen; /**< True if @x and @y hold the window position, else @ray is set. */
+            float x, y;
+            Ray ray;
+        };
+
+
+
+        /// Private attributes ///
+
+        std::vector<Request> _queued;  /**< Requests not handed over yet (main thread only). */
+        U32 _nextId;
+        bool _inFlight;                /**< A batch was handed over (main thread only). */
+
+        // Shared with the picking thread
+        std::thread _thread;
+        std::mutex _mutex;
+        std::condition_variable _wakeUp; /**< Signaled when a batch is handed over or on stop. */
+        std::condition_variable _done;   /**< Signaled when a batch is finished. */
+        bool _busy;                      /**< The thread owns @_scene and @_results. */
+        bool _stop;
+        TLAS _scene;                     /**< Copy of the scene of the batch. */
+        std::vector<Result> _results;    /**< Batch: rays and requests in, hits out. */
+
+
+
+        /// Private methods ///
+
+        /**
+         * Body of the picking thread.
+         */
+        void _threadLoop();
+    };
+}
+
+#endif // PICKER_H
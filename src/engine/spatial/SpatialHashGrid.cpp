@@ -0,0 +1,521 @@
+/** 
+ * \file SpatialHashGrid.cpp
+ * \brief Uniform grid over points, stored in a hash table of occupied cells,
+ * for radius and k-nearest neighbor queries.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "SpatialHashGrid.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    const U32 SpatialHashGrid::EMPTY_SLOT = 0xFFFFFFFF;
+
+    static const size_t SPATIAL_HASH_MIN_TABLE_SIZE = 16; /**< Slots of the smallest table. */
+    static const size_t SPATIAL_HASH_GRAIN = 4 * 1024;    /**< Points per parallel task. */
+    static const size_t SPATIAL_HASH_CELL_GRAIN = 512;    /**< Cells per parallel neighbor finding task. */
+
+
+
+    /**
+     * Compare cell coordinates exactly (@Vector3D::operator== uses a tolerance).
+     */
+    static inline bool spatialHashSameCell(const Vec3i& a, const Vec3i& b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+
+
+    /**
+     * Squared distance and sorted index of a point, for nearest neighbor queries.
+     */
+    typedef std::pair<float, U32> SpatialHashCandidate;
+
+
+
+    /**
+     * \brief Add a point to a max-heap of the @k closest points so far, if it's
+     * closer than the farthest of them and within the maximum distance.
+     */
+    static inline void spatialHashKeepNearest(std::vector<SpatialHashCandidate>& heap, size_t k, float distance2,
+                                              float maxDistance2, U32 point)
+    {
+        if (distance2 > maxDistance2 || (heap.size() == k && distance2 >= heap.front().first))
+        {
+            return;
+        }
+
+        if (heap.size() == k)
+        {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+        }
+
+        heap.push_back(SpatialHashCandidate(distance2, point));
+        std::push_heap(heap.begin(), heap.end());
+    }
+
+
+
+    SpatialHashGrid::SpatialHashGrid(float cellSize)
+        : _cellSize(cellSize), _invCellSize(1.0f / cellSize), _minCell(0, 0, 0), _maxCell(-1, -1, -1)
+    {
+    }
+
+
+
+    void SpatialHashGrid::build(const float* positions, size_t count, size_t stride)
+    {
+        // At most one cell per point, and the table stays at most half full
+        size_t tableSize = SPATIAL_HASH_MIN_TABLE_SIZE;
+
+        while (tableSize < 2 * count)
+        {
+            tableSize *= 2;
+        }
+
+        Slot empty;
+        empty.cell = EMPTY_SLOT;
+        _table.assign(tableSize, empty);
+
+        _positions.resize(count);
+        _indices.resize(count);
+        _pointCell.resize(count);
+        _coords.resize(count);
+        _cellStart.clear();
+        _minCell = Vec3i(0, 0, 0);
+        _maxCell = Vec3i(-1, -1, -1);
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        // Cell of every point
+        ThreadPool::getInstance().parallelFor(count, SPATIAL_HASH_GRAIN, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const float* p = positions + i * stride;
+                _coords[i] = getCell(Vec3f(p[0], p[1], p[2]));
+            }
+        });
+
+        // Number the cells in order of appearance and count their points.
+        // Consecutive points often share a cell, which skips the lookup
+        _minCell = _maxCell = _coords[0];
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Vec3i& c = _coords[i];
+            U32 cell;
+
+            if (i > 0 && spatialHashSameCell(c, _coords[i - 1]))
+            {
+                cell = _pointCell[i - 1];
+            }
+            else
+            {
+                cell = _insertCell(c, U32(_cellStart.size()));
+
+                if (cell == _cellStart.size())
+                {
+                    _cellStart.push_back(0);
+
+                    _minCell = Vec3i(std::min(_minCell.x, c.x), std::min(_minCell.y, c.y), std::min(_minCell.z, c.z));
+                    _maxCell = Vec3i(std::max(_maxCell.x, c.x), std::max(_maxCell.y, c.y), std::max(_maxCell.z, c.z));
+                }
+            }
+
+            _pointCell[i] = cell;
+            ++_cellStart[cell];
+        }
+
+        // Counting sort: running sums give the end of each cell, and filling
+        // cells backwards leaves each entry at the start of its cell, with the
+        // points of a cell in their original order
+        for (size_t c = 1; c < _cellStart.size(); ++c)
+        {
+            _cellStart[c] += _cellStart[c - 1];
+        }
+
+        _cellStart.push_back(U32(count));
+
+        for (size_t i = count; i-- > 0;)
+        {
+            const U32 position = --_cellStart[_pointCell[i]];
+            const float* p = positions + i * stride;
+
+            _positions[position] = Vec3f(p[0], p[1], p[2]);
+            _indices[position] = U32(i);
+        }
+    }
+
+
+
+    Vec3i SpatialHashGrid::getCell(const Vec3f& p) const
+    {
+        return Vec3i(int(std::floor(p.x * _invCellSize)), int(std::floor(p.y * _invCellSize)),
+                     int(std::floor(p.z * _invCellSize)));
+    }
+
+
+
+    size_t SpatialHashGrid::getCellPoints(const Vec3i& cell, const U32*& points) const
+    {
+        U32 c = _findCell(cell);
+
+        if (c == EMPTY_SLOT)
+        {
+            points = nullptr;
+            return 0;
+        }
+
+        points = &_indices[_cellStart[c]];
+        return _cellStart[c + 1] - _cellStart[c];
+    }
+
+
+
+    size_t SpatialHashGrid::queryRadius(const Vec3f& p, float radius, std::vector<U32>& points) const
+    {
+        const size_t found = points.size();
+        const float radius2 = radius * radius;
+
+        if (_indices.empty() || radius < 0.0f)
+        {
+            return 0;
+        }
+
+        const Vec3i lo = getCell(p - Vec3f(radius, radius, radius));
+        const Vec3i hi = getCell(p + Vec3f(radius, radius, radius));
+        const double range = double(hi.x - lo.x + 1) * double(hi.y - lo.y + 1) * double(hi.z - lo.z + 1);
+
+        // More cells in range than in the grid: test every point instead
+        if (range > double(getNumberOfCells()))
+        {
+            for (size_t j = 0; j < _positions.size(); ++j)
+            {
+                Vec3f v = _positions[j] - p;
+
+                if (v * v <= radius2)
+                {
+                    points.push_back(_indices[j]);
+                }
+            }
+
+            return points.size() - found;
+        }
+
+        for (int x = lo.x; x <= hi.x; ++x)
+        {
+            for (int y = lo.y; y <= hi.y; ++y)
+            {
+                for (int z = lo.z; z <= hi.z; ++z)
+                {
+                    const U32 c = _findCell(Vec3i(x, y, z));
+
+                    if (c == EMPTY_SLOT)
+                    {
+                        continue;
+                    }
+
+                    for (U32 j = _cellStart[c]; j < _cellStart[c + 1]; ++j)
+                    {
+                        Vec3f v = _positions[j] - p;
+
+                        if (v * v <= radius2)
+                        {
+                            points.push_back(_indices[j]);
+                        }
+                    }
+                }
+            }
+        }
+
+        return points.size() - found;
+    }
+
+
+
+    size_t SpatialHashGrid::queryNearest(const Vec3f& p, size_t k, std::vector<U32>& points, float maxRadius) const
+    {
+        if (k == 0 || _indices.empty())
+        {
+            return 0;
+        }
+
+        std::vector<SpatialHashCandidate> heap;
+        heap.reserve(k);
+
+        const float maxDistance2 = maxRadius * maxRadius;
+        const Vec3i center = getCell(p);
+        const size_t cellCount = getNumberOfCells();
+
+        for (int d = 0;; ++d)
+        {
+            // Once the shells hold more cells than the grid, scanning all
+            // points is cheaper
+            const double width = 2.0 * d + 1.0;
+
+            if (width * width * width > 8.0 * double(cellCount))
+            {
+                heap.clear();
+
+                for (size_t j = 0; j < _positions.size(); ++j)
+                {
+                    Vec3f v = _positions[j] - p;
+                    spatialHashKeepNearest(heap, k, v * v, maxDistance2, U32(j));
+                }
+
+                break;
+            }
+
+            // Cells at Chebyshev distance d from the center cell: full layers
+            // at dx or dy = +-d, only the two caps dz = +-d elsewhere
+            for (int dx = -d; dx <= d; ++dx)
+            {
+                for (int dy = -d; dy <= d; ++dy)
+                {
+                    const bool side = dx == -d || dx == d || dy == -d || dy == d;
+                    const int dzStep = side || d == 0 ? 1 : 2 * d;
+
+                    for (int dz = -d; dz <= d; dz += dzStep)
+                    {
+                        const U32 c = _findCell(Vec3i(center.x + dx, center.y + dy, center.z + dz));
+
+                        if (c == EMPTY_SLOT)
+                        {
+                            continue;
+                        }
+
+                        for (U32 j = _cellStart[c]; j < _cellStart[c + 1]; ++j)
+                        {
+                            Vec3f v = _positions[j] - p;
+                            spatialHashKeepNearest(heap, k, v * v, maxDistance2, j);
+                        }
+                    }
+                }
+            }
+
+            // Distance from the position to the cells outside the shells
+            // visited so far
+            const float lo[3] = { float(center.x - d), float(center.y - d), float(center.z - d) };
+            const float pc[3] = { p.x * _invCellSize, p.y * _invCellSize, p.z * _invCellSize };
+            float outside = FLT_MAX;
+
+            for (int a = 0; a < 3; ++a)
+            {
+                outside = std::min(outside, std::min(pc[a] - lo[a], lo[a] + float(2 * d + 1) - pc[a]));
+            }
+
+            outside = std::max(outside, 0.0f) * _cellSize;
+
+            const bool coversGrid = center.x - d <= _minCell.x && center.y - d <= _minCell.y && center.z - d <= _minCell.z &&
+                                    center.x + d >= _maxCell.x && center.y + d >= _maxCell.y && center.z + d >= _maxCell.z;
+
+            if (coversGrid || outside * outside > maxDistance2 ||
+                (heap.size() == k && heap.front().first <= outside * outside))
+            {
+                break;
+            }
+        }
+
+        std::sort_heap(heap.begin(), heap.end());
+
+        for (size_t i = 0; i < heap.size(); ++i)
+        {
+            points.push_back(_indices[heap[i].second]);
+        }
+
+        return heap.size();
+    }
+
+
+
+    void SpatialHashGrid::findNeighbors(float radius, std::vector<U32>& offsets, std::vector<U32>& neighbors) const
+    {
+        const size_t count = _indices.size();
+        const size_t cells = getNumberOfCells();
+        const size_t chunks = (cells + SPATIAL_HASH_CELL_GRAIN - 1) / SPATIAL_HASH_CELL_GRAIN;
+        const int reach = int(std::ceil(radius * _invCellSize)); // Cells around a cell holding neighbors
+        const float radius2 = radius * radius;
+        std::vector< std::vector<U32> > chunkNeighbors(chunks);
+
+        offsets.assign(count + 1, 0);
+        neighbors.clear();
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        // Points of the same cell share their candidate cells, so the cells
+        // around each cell are looked up once; each chunk of cells keeps its
+        // lists, and the counts go to the original indices
+        ThreadPool::getInstance().parallelFor(chunks, 1, [&](size_t firstChunk, size_t lastChunk)
+        {
+            std::vector<U32> ranges;
+
+            for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk)
+            {
+                std::vector<U32>& out = chunkNeighbors[chunk];
+                const size_t end = std::min(cells, (chunk + 1) * SPATIAL_HASH_CELL_GRAIN);
+
+                for (size_t c = chunk * SPATIAL_HASH_CELL_GRAIN; c < end; ++c)
+                {
+                    const U32 first = _cellStart[c];
+                    const U32 last = _cellStart[c + 1];
+
+                    const Vec3i cell = getCell(_positions[first]);
+                    _cellRanges(Vec3i(cell.x - reach, cell.y - reach, cell.z - reach),
+                                Vec3i(cell.x + reach, cell.y + reach, cell.z + reach), ranges);
+
+                    for (U32 j = first; j < last; ++j)
+                    {
+                        const Vec3f p = _positions[j];
+                        const size_t found = out.size();
+
+                        for (size_t r = 0; r < ranges.size(); r += 2)
+                        {
+                            for (U32 n = ranges[r]; n < ranges[r + 1]; ++n)
+                            {
+                                Vec3f v = _positions[n] - p;
+
+                                if (v * v <= radius2 && n != j)
+                                {
+                                    out.push_back(_indices[n]);
+                                }
+                            }
+                        }
+
+                        offsets[_indices[j] + 1] = U32(out.size() - found);
+                    }
+                }
+            }
+        });
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+
+        neighbors.resize(offsets[count]);
+
+        ThreadPool::getInstance().parallelFor(chunks, 1, [&](size_t firstChunk, size_t lastChunk)
+        {
+            for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk)
+            {
+                const std::vector<U32>& lists = chunkNeighbors[chunk];
+                const size_t first = _cellStart[chunk * SPATIAL_HASH_CELL_GRAIN];
+                const size_t end = _cellStart[std::min(cells, (chunk + 1) * SPATIAL_HASH_CELL_GRAIN)];
+                size_t read = 0;
+
+                for (size_t j = first; j < end; ++j)
+                {
+                    const U32 i = _indices[j];
+                    const size_t n = offsets[i + 1] - offsets[i];
+
+                    std::copy(lists.begin() + read, lists.begin() + read + n, neighbors.begin() + offsets[i]);
+                    read += n;
+                }
+            }
+        });
+    }
+
+
+
+    size_t SpatialHashGrid::_hash(const Vec3i& cell) const
+    {
+        U32 h = (U32(cell.x) * 73856093u) ^ (U32(cell.y) * 19349663u) ^ (U32(cell.z) * 83492791u);
+        return size_t(h) & (_table.size() - 1);
+    }
+
+
+
+    U32 SpatialHashGrid::_findCell(const Vec3i& cell) const
+    {
+        if (_cellStart.empty())
+        {
+            return EMPTY_SLOT;
+        }
+
+        // The table is never full, so probing reaches an empty slot
+        for (size_t i = _hash(cell);; i = (i + 1) & (_table.size() - 1))
+        {
+            const Slot& slot = _table[i];
+
+            if (slot.cell == EMPTY_SLOT || spatialHashSameCell(slot.key, cell))
+            {
+                return slot.cell;
+            }
+        }
+    }
+
+
+
+    U32 SpatialHashGrid::_insertCell(const Vec3i& cell, U32 nextCell)
+    {
+        for (size_t i = _hash(cell);; i = (i + 1) & (_table.size() - 1))
+        {
+            Slot& slot = _table[i];
+
+            if (slot.cell == EMPTY_SLOT)
+            {
+                slot.key = cell;
+                slot.cell = nextCell;
+                return nextCell;
+            }
+
+            if (spatialHashSameCell(slot.key, cell))
+            {
+                return slot.cell;
+            }
+        }
+    }
+
+
+
+    void SpatialHashGrid::_cellRanges(const Vec3i& lo, const Vec3i& hi, std::vector<U32>& ranges) const
+    {
+        ranges.clear();
+
+        const double range = double(hi.x - lo.x + 1) * double(hi.y - lo.y + 1) * double(hi.z - lo.z + 1);
+
+        // More cells in range than in the grid: take every point instead
+        if (range > double(getNumberOfCells()))
+        {
+            ranges.push_back(0);
+            ranges.push_back(U32(_indices.size()));
+            return;
+        }
+
+        for (int x = lo.x; x <= hi.x; ++x)
+        {
+            for (int y = lo.y; y <= hi.y; ++y)
+            {
+                for (int z = lo.z; z <= hi.z; ++z)
+                {
+                    const U32 c = _findCell(Vec3i(x, y, z));
+
+                    if (c != EMPTY_SLOT)
+                    {
+                        ranges.push_back(_cellStart[c]);
+                        ranges.push_back(_cellStart[c + 1]);
+                    }
+                }
+            }
+        }
+    }
+}
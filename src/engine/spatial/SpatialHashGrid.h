@@ -0,0 +1,228 @@
+/** 
+ * \file SpatialHashGrid.h
+ * \brief Uniform grid over points, stored in a hash table of occupied cells,
+ * for radius and k-nearest neighbor queries.
+ * 
+ * Space is split into cubic cells of a fixed size; a cell is identified by its
+ * integer coordinates (a @Vec3i) and only occupied cells take memory, so the
+ * grid has no bounds. Cells live in an open addressing table (linear probing,
+ * at most half full) hashed with the primes of Teschner et al., "Optimized
+ * spatial hashing for collision detection of deformable objects", 2003.
+ * 
+ * The grid is meant to be rebuilt every frame from scratch (particles, crowd
+ * agents, triggers): @build() counting sorts the points by cell, so the points
+ * of a cell are contiguous and a query reads a few short runs of one array
+ * instead of chasing per-cell lists. Cells of a grid whose size is about the
+ * query radius are the best choice: a radius query then visits 27 cells.
+ * 
+ * Queries are const and may run concurrently. @findNeighbors() builds the
+ * neighbor lists of all points on the @ThreadPool, looking up the cells around
+ * each cell once for all of its points.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef SPATIALHASHGRID_H
+#define SPATIALHASHGRID_H
+
+#include <cfloat>
+#include <cstddef>
+#include <vector>
+#include "DataType.h"
+#include "Vector.h"
+
+
+
+namespace nut
+{
+    class SpatialHashGrid
+    {
+        public:
+
+        /// Constructors ///
+
+        /**
+         * \brief Instantiates an empty grid.
+         * 
+         * @param cellSize Edge length of the cells.
+         */
+        explicit SpatialHashGrid(float cellSize = 1.0f);
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Replace the points of the grid.
+         * 
+         * Memory is kept between builds, so rebuilding a grid of a similar
+         * number of points every frame doesn't allocate.
+         * 
+         * @param positions Address of the first point's x coordinate.
+         * @param count Number of points.
+         * @param stride Distance between consecutive points, in floats (3 for a
+         * Vec3f array, sizeof(Vertex) / sizeof(float) for a Vertex array).
+         */
+        void build(const float* positions, size_t count, size_t stride = 3);
+
+        /**
+         * \brief Replace the points of the grid with a vector of points.
+         */
+        void build(const std::vector<Vec3f>& positions)
+        {
+            build(positions.empty() ? nullptr : &positions[0].x, positions.size());
+        }
+
+        /**
+         * \brief Change the edge length of the cells. It takes effect at the
+         * next @build().
+         */
+        void setCellSize(float cellSize)
+        {
+            _cellSize = cellSize;
+            _invCellSize = 1.0f / cellSize;
+        }
+
+        /**
+         * Get the edge length of the cells.
+         */
+        float getCellSize() const
+        {
+            return _cellSize;
+        }
+
+        /**
+         * Get the number of points of the last build.
+         */
+        size_t getNumberOfPoints() const
+        {
+            return _indices.size();
+        }
+
+        /**
+         * Get the number of occupied cells.
+         */
+        size_t getNumberOfCells() const
+        {
+            return _cellStart.empty() ? 0 : _cellStart.size() - 1;
+        }
+
+        /**
+         * Get the coordinates of the cell containing a point.
+         */
+        Vec3i getCell(const Vec3f& p) const;
+
+        /**
+         * \brief Get the points in a cell.
+         * 
+         * @param cell Cell coordinates.
+         * @param points Receives the address of the cell's point indices (valid
+         * until the next @build()), or null if the cell is empty.
+         * @return Number of points in the cell.
+         */
+        size_t getCellPoints(const Vec3i& cell, const U32*& points) const;
+
+        /**
+         * \brief Find the points within a distance of a position.
+         * 
+         * @param p Position.
+         * @param radius Distance (points exactly at it are included).
+         * @param points The indices of the points found are appended to it, in
+         * no particular order.
+         * @return Number of points found.
+         */
+        size_t queryRadius(const Vec3f& p, float radius, std::vector<U32>& points) const;
+
+        /**
+         * \brief Find the closest points to a position.
+         * 
+         * Cells are visited in shells of growing distance around the position's
+         * cell until no unvisited cell can hold a closer point.
+         * 
+         * @param p Position.
+         * @param k Number of points wanted.
+         * @param points The indices of the points found are appended to it,
+         * closest first.
+         * @param maxRadius Points farther than it are ignored.
+         * @return Number of points found: @k, or less if the grid doesn't have
+         * enough points within @maxRadius.
+         */
+        size_t queryNearest(const Vec3f& p, size_t k, std::vector<U32>& points, float maxRadius = FLT_MAX) const;
+
+        /**
+         * \brief Find the neighbors of every point of the grid, in parallel.
+         * 
+         * The result is in compressed rows: the neighbors of point i are
+         * @neighbors[@offsets[i]] to @neighbors[@offsets[i + 1] - 1]. A point
+         * isn't its own neighbor.
+         * 
+         * @param radius Distance (points exactly at it are neighbors).
+         * @param offsets Receives @getNumberOfPoints() + 1 offsets.
+         * @param neighbors Receives the neighbors.
+         */
+        void findNeighbors(float radius, std::vector<U32>& offsets, std::vector<U32>& neighbors) const;
+
+
+
+        private:
+
+        /**
+         * \brief Hash table slot: a cell's coordinates and index, or @cell equal
+         * to @SpatialHashGrid::EMPTY_SLOT.
+         */
+        struct Slot
+        {
+            Vec3i key;
+            U32 cell;
+        };
+
+        static const U32 EMPTY_SLOT;
+
+
+
+        /// Private attributes ///
+
+        float _cellSize;
+        float _invCellSize;
+        std::vector<Slot> _table;      /**< Occupied cells; its size is a power of two. */
+        std::vector<U32> _cellStart;   /**< Points of cell c are [@_cellStart[c], @_cellStart[c + 1]) of the sorted arrays. */
+        std::vector<Vec3f> _positions; /**< Points sorted by cell. */
+        std::vector<U32> _indices;     /**< Original index of each sorted point. */
+        std::vector<U32> _pointCell;   /**< Cell of each original point, during a build. */
+        std::vector<Vec3i> _coords;    /**< Cell coordinates of each original point, during a build. */
+        Vec3i _minCell, _maxCell;      /**< Range of the occupied cells. */
+
+
+
+        /// Private methods ///
+
+        /**
+         * Hash of a cell for a table of @_table.size() slots.
+         */
+        size_t _hash(const Vec3i& cell) const;
+
+        /**
+         * \brief Find the index of a cell.
+         * 
+         * @return The cell index, or @EMPTY_SLOT if the cell is empty.
+         */
+        U32 _findCell(const Vec3i& cell) const;
+
+        /**
+         * Find the index of a cell, adding it if it's new.
+         */
+        U32 _insertCell(const Vec3i& cell, U32 nextCell);
+
+        /**
+         * \brief Get the sorted point ranges of the occupied cells in a block of
+         * cells, as pairs of [begin, end) entries; a single range with all
+         * points if the block has more cells than the grid.
+         */
+        void _cellRanges(const Vec3i& lo, const Vec3i& hi, std::vector<U32>& ranges) const;
+    };
+}
+
+#endif // SPATIALHASHGRID_H
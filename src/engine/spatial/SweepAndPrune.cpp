@@ -0,0 +1,306 @@
+/** 
+ * \file SweepAndPrune.cpp
+ * \brief Sort-based broadphase for many similarly sized moving boxes.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <algorithm>
+#include <limits>
+#include "SweepAndPrune.h"
+#include "SIMD.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    static const int SAP_RADIX_BITS = 11;                     /**< Bits sorted per radix pass (three passes for 32 bit keys). */
+    static const U32 SAP_RADIX_SIZE = 1u << SAP_RADIX_BITS;   /**< Buckets per radix pass. */
+    static const size_t SAP_SORT_GRAIN = 16 * 1024;           /**< Boxes per sorting chunk, each with its own histogram. */
+    static const size_t SAP_SWEEP_GRAIN = 1024;               /**< Sorted boxes swept per parallel task. */
+    static const size_t SAP_PADDING = size_t(SIMDFloat::WIDTH); /**< Entries after the last box in the sweep arrays. */
+
+
+
+    /**
+     * Get a coordinate of a vector by axis index.
+     */
+    static inline float sweepAndPruneAxis(const Vec3f& v, int axis)
+    {
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    }
+
+
+
+    /**
+     * \brief Turn floats into unsigned keys with the same order: the sign bit
+     * is set for positive values, and all bits are flipped for negative ones.
+     */
+    static inline SIMDInt sweepAndPruneKey(const SIMDFloat& v)
+    {
+        SIMDInt bits = SIMDInt::asInt(v);
+        return bits ^ (SIMDInt::sra(bits, 31) | SIMDInt(I32(0x80000000)));
+    }
+
+
+
+    SweepAndPrune::SweepAndPrune() : _axis(0)
+    {
+    }
+
+
+
+    void SweepAndPrune::findPairs(const BoundingBox* boxes, size_t count, std::vector<Pair>& pairs)
+    {
+        pairs.clear();
+
+        if (count < 2)
+        {
+            return;
+        }
+
+        _axis = _chooseAxis(boxes, count);
+        _sort(boxes, count);
+        _gather(boxes, count);
+        _sweep(count, pairs);
+    }
+
+
+
+    int SweepAndPrune::_chooseAxis(const BoundingBox* boxes, size_t count)
+    {
+        const size_t chunks = (count + SAP_SORT_GRAIN - 1) / SAP_SORT_GRAIN;
+        _moments.resize(6 * chunks);
+
+        // One task per chunk, so the sums don't depend on the number of workers
+        ThreadPool::getInstance().parallelFor(chunks, 1, [&](size_t firstChunk, size_t lastChunk)
+        {
+            for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk)
+            {
+                double sum[3] = { 0.0, 0.0, 0.0 };
+                double squares[3] = { 0.0, 0.0, 0.0 };
+                const size_t end = std::min(count, (chunk + 1) * SAP_SORT_GRAIN);
+
+                for (size_t i = chunk * SAP_SORT_GRAIN; i < end; ++i)
+                {
+                    const Vec3f c = boxes[i].getCenter();
+                    sum[0] += c.x;
+                    sum[1] += c.y;
+                    sum[2] += c.z;
+                    squares[0] += double(c.x) * c.x;
+                    squares[1] += double(c.y) * c.y;
+                    squares[2] += double(c.z) * c.z;
+                }
+
+                std::copy(sum, sum + 3, &_moments[6 * chunk]);
+                std::copy(squares, squares + 3, &_moments[6 * chunk + 3]);
+            }
+        });
+
+        // Sum the chunks in order, so the choice doesn't depend on scheduling
+        int axis = 0;
+        double best = -1.0;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            double sum = 0.0, squares = 0.0;
+
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                sum += _moments[6 * c + k];
+                squares += _moments[6 * c + 3 + k];
+            }
+
+            double variance = squares - sum * sum / double(count);
+
+            if (variance > best)
+            {
+                best = variance;
+                axis = k;
+            }
+        }
+
+        return axis;
+    }
+
+
+
+    void SweepAndPrune::_sort(const BoundingBox* boxes, size_t count)
+    {
+        const size_t chunks = (count + SAP_SORT_GRAIN - 1) / SAP_SORT_GRAIN;
+        const int axis = _axis;
+
+        _keys.resize(count);
+        _keysTmp.resize(count);
+        _order.resize(count);
+        _orderTmp.resize(count);
+        _histograms.resize(chunks * SAP_RADIX_SIZE);
+
+        // Keys of the minimums, gathered @SIMDFloat::WIDTH boxes at a time
+        ThreadPool::getInstance().parallelFor(count, SAP_SORT_GRAIN, [&](size_t begin, size_t end)
+        {
+            const SIMDInt offsets = SIMDInt::mullo(SIMDInt::sequence(), SIMDInt(6));
+            const SIMDInt step = SIMDInt::sequence();
+            size_t i = begin;
+
+            for (; i + SIMDFloat::WIDTH <= end; i += SIMDFloat::WIDTH)
+            {
+                const float* base = &boxes[i].min.x + axis;
+                sweepAndPruneKey(SIMDFloat::gather(base, offsets)).storeu(reinterpret_cast<I32*>(&_keys[i]));
+                (step + SIMDInt(I32(i))).storeu(reinterpret_cast<I32*>(&_order[i]));
+            }
+
+            for (; i < end; ++i)
+            {
+                IntFloat bits;
+                bits.asFloat = sweepAndPruneAxis(boxes[i].min, axis);
+                _keys[i] = U32(bits.asInt) ^ (bits.asInt < 0 ? 0xFFFFFFFFu : 0x80000000u);
+                _order[i] = U32(i);
+            }
+        });
+
+        // Stable LSD passes; each chunk counts its digits, then scatters its
+        // keys after the same digits of the previous chunks
+        for (int shift = 0; shift < 32; shift += SAP_RADIX_BITS)
+        {
+            ThreadPool::getInstance().parallelFor(chunks, 1, [&](size_t firstChunk, size_t lastChunk)
+            {
+                for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk)
+                {
+                    U32* histogram = &_histograms[chunk * SAP_RADIX_SIZE];
+                    const size_t end = std::min(count, (chunk + 1) * SAP_SORT_GRAIN);
+                    std::fill(histogram, histogram + SAP_RADIX_SIZE, 0u);
+
+                    for (size_t i = chunk * SAP_SORT_GRAIN; i < end; ++i)
+                    {
+                        ++histogram[(_keys[i] >> shift) & (SAP_RADIX_SIZE - 1)];
+                    }
+                }
+            });
+
+            // Skip the pass if every key has the same digit (common for the
+            // high bits, when all boxes are in a small range)
+            const U32 firstDigit = (_keys[0] >> shift) & (SAP_RADIX_SIZE - 1);
+            size_t sameDigit = 0;
+
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                sameDigit += _histograms[c * SAP_RADIX_SIZE + firstDigit];
+            }
+
+            if (sameDigit == count)
+            {
+                continue;
+            }
+
+            // Histograms become the first output position of each digit of each chunk
+            U32 offset = 0;
+
+            for (U32 digit = 0; digit < SAP_RADIX_SIZE; ++digit)
+            {
+                for (size_t c = 0; c < chunks; ++c)
+                {
+                    U32 n = _histograms[c * SAP_RADIX_SIZE + digit];
+                    _histograms[c * SAP_RADIX_SIZE + digit] = offset;
+                    offset += n;
+                }
+            }
+
+            ThreadPool::getInstance().parallelFor(chunks, 1, [&](size_t firstChunk, size_t lastChunk)
+            {
+                for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk)
+                {
+                    U32* position = &_histograms[chunk * SAP_RADIX_SIZE];
+                    const size_t end = std::min(count, (chunk + 1) * SAP_SORT_GRAIN);
+
+                    for (size_t i = chunk * SAP_SORT_GRAIN; i < end; ++i)
+                    {
+                        U32 p = position[(_keys[i] >> shift) & (SAP_RADIX_SIZE - 1)]++;
+                        _keysTmp[p] = _keys[i];
+                        _orderTmp[p] = _order[i];
+                    }
+                }
+            });
+
+            _keys.swap(_keysTmp);
+            _order.swap(_orderTmp);
+        }
+    }
+
+
+
+    void SweepAndPrune::_gather(const BoundingBox* boxes, size_t count)
+    {
+        const int axisB = (_axis + 1) % 3;
+        const int axisC = (_axis + 2) % 3;
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+
+        std::vector<float>* arrays[6] = { &_minA, &_maxA, &_minB, &_maxB, &_minC, &_maxC };
+
+        // Comparisons with NaN are false, so the padding stops every sweep
+        for (int k = 0; k < 6; ++k)
+        {
+            arrays[k]->resize(count + SAP_PADDING);
+            std::fill(arrays[k]->begin() + count, arrays[k]->end(), nan);
+        }
+
+        ThreadPool::getInstance().parallelFor(count, SAP_SORT_GRAIN, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const BoundingBox& box = boxes[_order[i]];
+                _minA[i] = sweepAndPruneAxis(box.min, _axis);
+                _maxA[i] = sweepAndPruneAxis(box.max, _axis);
+                _minB[i] = sweepAndPruneAxis(box.min, axisB);
+                _maxB[i] = sweepAndPruneAxis(box.max, axisB);
+                _minC[i] = sweepAndPruneAxis(box.min, axisC);
+                _maxC[i] = sweepAndPruneAxis(box.max, axisC);
+            }
+        });
+    }
+
+
+
+    void SweepAndPrune::_sweep(size_t count, std::vector<Pair>& pairs)
+    {
+        _pairCollector.run(count, SAP_SWEEP_GRAIN, [&](size_t begin, size_t end, std::vector<Pair>& out)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const SIMDFloat minA(_minA[i]), maxA(_maxA[i]);
+                const SIMDFloat minB(_minB[i]), maxB(_maxB[i]);
+                const SIMDFloat minC(_minC[i]), maxC(_maxC[i]);
+                const U32 self = _order[i];
+
+                // The following boxes start at or after this one; stop at the
+                // first group where one starts after this one ends
+                for (size_t j = i + 1;; j += SIMDFloat::WIDTH)
+                {
+                    const SIMDFloat starts = SIMDFloat::loadu(&_minA[j]) <= maxA;
+                    const SIMDFloat overlap = starts & (SIMDFloat::loadu(&_maxA[j]) >= minA) &
+                                              (SIMDFloat::loadu(&_minB[j]) <= maxB) & (SIMDFloat::loadu(&_maxB[j]) >= minB) &
+                                              (SIMDFloat::loadu(&_minC[j]) <= maxC) & (SIMDFloat::loadu(&_maxC[j]) >= minC);
+
+                    for (int lane = 0, bits = SIMDFloat::movemask(overlap); bits; ++lane, bits >>= 1)
+                    {
+                        if (bits & 1)
+                        {
+                            const U32 other = _order[j + lane];
+                            Pair pair = { std::min(self, other), std::max(self, other) };
+                            out.push_back(pair);
+                        }
+                    }
+
+                    if (!SIMDFloat::all(starts))
+                    {
+                        break;
+                    }
+                }
+            }
+        }, pairs);
+    }
+}
@@ -0,0 +1,138 @@
+/** 
+ * \file SweepAndPrune.h
+ * \brief Sort-based broadphase for many similarly sized moving boxes.
+ * 
+ * Every call to @findPairs() starts from scratch, so there's nothing to update
+ * when objects move, appear or disappear. The boxes are sorted by their minimum
+ * along the axis where their centers spread the most, then each box is swept
+ * against the following ones until their minimum passes its maximum; the other
+ * two axes are tested @SIMDFloat::WIDTH boxes at a time.
+ * 
+ * The sort is a parallel LSD radix sort of the minimums turned into unsigned
+ * keys (computed with SIMD), and the sweep is split into ranges of the sorted
+ * order running in parallel on the @ThreadPool. A pair is only found by the box
+ * that comes first in the sorted order, so the list has no duplicates.
+ * 
+ * When the boxes vary a lot in size, or only a few of them move, prefer the
+ * @DynamicAABBTree.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include <cstddef>
+#include <vector>
+#include "BoundingBox.h"
+#include "DataType.h"
+#include "ParallelCollector.h"
+
+
+
+namespace nut
+{
+    class SweepAndPrune
+    {
+        public:
+
+        /**
+         * \brief Indices of two overlapping boxes, with @a < @b.
+         */
+        struct Pair
+        {
+            U32 a, b;
+        };
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor.
+         */
+        SweepAndPrune();
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Find all pairs of overlapping boxes (touching counts as
+         * overlapping; empty boxes overlap nothing).
+         * 
+         * The order of the pairs only depends on the boxes, not on the number
+         * of threads.
+         * 
+         * @param boxes Boxes, indexed by the pairs.
+         * @param count Number of boxes.
+         * @param pairs Receives the pairs (cleared first), each pair once.
+         */
+        void findPairs(const BoundingBox* boxes, size_t count, std::vector<Pair>& pairs);
+
+        /**
+         * \brief Find all pairs of overlapping boxes of a vector.
+         */
+        void findPairs(const std::vector<BoundingBox>& boxes, std::vector<Pair>& pairs)
+        {
+            findPairs(boxes.empty() ? nullptr : &boxes[0], boxes.size(), pairs);
+        }
+
+        /**
+         * Get the axis (0 for x, 1 for y, 2 for z) of the last sweep.
+         */
+        int getSweepAxis() const
+        {
+            return _axis;
+        }
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        int _axis;
+
+        // Sort keys and box indices, with their radix sort buffers
+        std::vector<U32> _keys, _keysTmp;
+        std::vector<U32> _order, _orderTmp;
+        std::vector<U32> _histograms; /**< Digit counts of each sorting chunk. */
+        std::vector<double> _moments; /**< Sums of centers and squared centers of each chunk. */
+
+        // Bounds in sorted order, on the sweep axis (a) and the other two (b, c),
+        // padded so that SIMD loads past the last box stop the sweep
+        std::vector<float> _minA, _maxA, _minB, _maxB, _minC, _maxC;
+
+        ParallelCollector<Pair> _pairCollector;
+
+
+
+        /// Private methods ///
+
+        /**
+         * Choose the axis along which the box centers have the largest variance.
+         */
+        int _chooseAxis(const BoundingBox* boxes, size_t count);
+
+        /**
+         * Sort the boxes by their minimum along @_axis into @_order.
+         */
+        void _sort(const BoundingBox* boxes, size_t count);
+
+        /**
+         * Copy the bounds to the sweep arrays in sorted order.
+         */
+        void _gather(const BoundingBox* boxes, size_t count);
+
+        /**
+         * Sweep the sorted boxes, in parallel.
+         */
+        void _sweep(size_t count, std::vector<Pair>& pairs);
+    };
+}
+
+#endif // SWEEPANDPRUNE_H
@@ -0,0 +1,247 @@
+/** 
+ * \file TLAS.cpp
+ * \brief Two-level acceleration structure over instances of shared mesh BVHs.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#include <iostream>
+#include "TLAS.h"
+#include "ThreadPool.h"
+
+
+
+namespace nut
+{
+    static const int TLAS_STACK_SIZE = 128; /**< Traversal stack entries, more than the maximum tree depth. */
+
+
+
+    /**
+     * Transform a direction (no translation).
+     */
+    static Vec3f transformDirection(const GLMatrix<float>& m, const Vec3f& d)
+    {
+        return Vec3f(m[0] * d.x + m[4] * d.y + m[8] * d.z,
+                     m[1] * d.x + m[5] * d.y + m[9] * d.z,
+                     m[2] * d.x + m[6] * d.y + m[10] * d.z);
+    }
+
+
+
+    TLAS::TLAS()
+    {
+    }
+
+
+
+    U32 TLAS::addInstance(const BVH* bvh, const GLMatrix<float>& transform)
+    {
+        if (bvh == nullptr || bvh->isEmpty())
+        {
+            std::cerr << "nut::TLAS::addInstance error. The bottom-level BVH is empty.\n";
+            return BVH::NO_HIT;
+        }
+
+        Instance instance;
+        instance.bvh = bvh;
+        instance.transform = transform;
+        _instances.push_back(instance);
+
+        return U32(_instances.size() - 1);
+    }
+
+
+
+    void TLAS::setTransform(U32 instance, const GLMatrix<float>& transform)
+    {
+        _instances[instance].transform = transform;
+    }
+
+
+
+    void TLAS::clear()
+    {
+        _instances.clear();
+        _nodes.clear();
+        _indices.clear();
+    }
+
+
+
+    void TLAS::build()
+    {
+        _updateInstances();
+
+        std::vector<BoundingBox> boxes(_instances.size());
+
+        for (size_t i = 0; i < _instances.size(); ++i)
+        {
+            boxes[i] = _instances[i].bounds;
+        }
+
+        BVH::buildNodes(boxes.empty() ? nullptr : &boxes[0], boxes.size(), _nodes, _indices);
+    }
+
+
+
+    void TLAS::refit()
+    {
+        // The tree doesn't know about instances added since the last build
+        if (_indices.size() != _instances.size())
+        {
+            build();
+            return;
+        }
+
+        _updateInstances();
+
+        // Children always come after their parent, so a reverse pass is bottom-up
+        for (size_t n = _nodes.size(); n-- > 0;)
+        {
+            BVH::Node& node = _nodes[n];
+            node.bounds = BoundingBox();
+
+            if (node.isLeaf())
+            {
+                for (U32 i = node.index; i < node.index + node.count; ++i)
+                {
+                    node.bounds.merge(_instances[_indices[i]].bounds);
+                }
+            }
+            else
+            {
+                node.bounds.merge(_nodes[node.index].bounds);
+                node.bounds.merge(_nodes[node.index + 1].bounds);
+            }
+        }
+    }
+
+
+
+    bool TLAS::intersect(const Ray& ray, Hit& hit) const
+    {
+        return _trace(ray, hit, false);
+    }
+
+
+
+    void TLAS::intersect(const Ray* rays, Hit* hits, size_t count) const
+    {
+        ThreadPool::getInstance().parallelFor(count, 256, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                _trace(rays[i], hits[i], false);
+            }
+        });
+    }
+
+
+
+    bool TLAS::occluded(const Ray& ray) const
+    {
+        Hit hit;
+        return _trace(ray, hit, true);
+    }
+
+
+
+    void TLAS::occluded(const Ray* rays, bool* occluded, size_t count) const
+    {
+        ThreadPool::getInstance().parallelFor(count, 256, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                Hit hit;
+                occluded[i] = _trace(rays[i], hit, true);
+            }
+        });
+    }
+
+
+
+    void TLAS::_updateInstances()
+    {
+        ThreadPool::getInstance().parallelFor(_instances.size(), 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                Instance& instance = _instances[i];
+                instance.inverse = instance.transform.inverse();
+                instance.bounds = instance.bvh->getBounds().transform(instance.transform);
+            }
+        });
+    }
+
+
+
+    bool TLAS::_trace(const Ray& ray, Hit& hit, bool anyHit) const
+    {
+        hit.t = ray.tMax;
+        hit.u = hit.v = 0.0f;
+        hit.instance = hit.triangle = BVH::NO_HIT;
+
+        if (_nodes.empty())
+        {
+            return false;
+        }
+
+        U32 stack[TLAS_STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+
+        while (top > 0)
+        {
+            const BVH::Node& node = _nodes[stack[--top]];
+
+            if (!node.bounds.intersect(ray.origin, ray.invDirection, ray.tMin, hit.t))
+            {
+                continue;
+            }
+
+            if (!node.isLeaf())
+            {
+                stack[top++] = node.index + 1;
+                stack[top++] = node.index;
+                continue;
+            }
+
+            for (U32 i = node.index; i < node.index + node.count; ++i)
+            {
+                const Instance& instance = _instances[_indices[i]];
+
+                // Object space ray; the unnormalized direction keeps distances unchanged
+                Ray local(instance.inverse * ray.origin, transformDirection(instance.inverse, ray.direction),
+                          ray.tMin, hit.t);
+
+                if (anyHit)
+                {
+                    if (instance.bvh->occluded(local))
+                    {
+                        hit.instance = _indices[i];
+                        return true;
+                    }
+
+                    continue;
+                }
+
+                BVH::Hit objectHit;
+
+                if (instance.bvh->intersect(local, objectHit))
+                {
+                    hit.t = objectHit.t;
+                    hit.u = objectHit.u;
+                    hit.v = objectHit.v;
+                    hit.instance = _indices[i];
+                    hit.triangle = objectHit.triangle;
+                }
+            }
+        }
+
+        return hit.instance != BVH::NO_HIT;
+    }
+}
@@ -0,0 +1,193 @@
+/** 
+ * \file TLAS.h
+ * \brief Two-level acceleration structure: a top-level tree over instances of
+ * shared mesh BVHs.
+ * 
+ * Each instance references a bottom-level @BVH (built once per mesh, e.g. per
+ * @ModelResourceFile mesh) and places it in the world with a transform, so a
+ * mesh used a thousand times is stored once. Rays reaching an instance are
+ * moved to its object space with the inverse transform; directions are not
+ * renormalized, so hit distances are the same in both spaces and compare
+ * directly across instances.
+ * 
+ * The top level is meant to be updated every frame: @refit() only recomputes
+ * bounds after instances moved, @build() rebuilds the tree (in parallel) when
+ * they moved a lot or instances were added.
+ * 
+ * Licensed under the MIT License (MIT)
+ * Copyright (c) 2014 Eder de Almeida Perez
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef TLAS_H
+#define TLAS_H
+
+#include <cstddef>
+#include <vector>
+#include "BoundingBox.h"
+#include "BVH.h"
+#include "DataType.h"
+#include "GLMatrix.h"
+#include "Ray.h"
+
+
+
+namespace nut
+{
+    class TLAS
+    {
+        public:
+
+        /**
+         * \brief A placed copy of a mesh.
+         */
+        struct Instance
+        {
+            const BVH* bvh;            /**< Bottom-level tree, owned by the caller. */
+            GLMatrix<float> transform; /**< Object to world transform. */
+            GLMatrix<float> inverse;   /**< World to object transform (updated by @build() and @refit()). */
+            BoundingBox bounds;        /**< World space bounds (updated by @build() and @refit()). */
+        };
+
+        /**
+         * \brief Closest hit of a ray.
+         */
+        struct Hit
+        {
+            float t;      /**< Hit distance; the ray's tMax if nothing was hit. */
+            float u, v;   /**< Barycentric coordinates of the second and third vertices. */
+            U32 instance; /**< Instance hit, or @BVH::NO_HIT. */
+            U32 triangle; /**< Original (mesh) index of the triangle, or @BVH::NO_HIT. */
+        };
+
+
+
+        /// Constructors ///
+
+        /**
+         * Default constructor. Instantiates an empty structure.
+         */
+        TLAS();
+
+
+
+        /// Methods ///
+
+        /**
+         * \brief Add an instance. It takes part in queries after the next @build().
+         * 
+         * @param bvh Built bottom-level tree; it must outlive the instance.
+         * @param transform Object to world transform.
+         * @return The instance index, or @BVH::NO_HIT if @bvh is null or empty.
+         */
+        U32 addInstance(const BVH* bvh, const GLMatrix<float>& transform);
+
+        /**
+         * \brief Move an instance. Call @refit() or @build() once all instances
+         * of the frame were moved.
+         */
+        void setTransform(U32 instance, const GLMatrix<float>& transform);
+
+        /**
+         * Remove all instances.
+         */
+        void clear();
+
+        /**
+         * \brief Update the instances and rebuild the top-level tree.
+         */
+        void build();
+
+        /**
+         * \brief Update the instances and the bounds of the top-level tree,
+         * keeping its topology. Faster than @build(), but the tree degrades if
+         * instances move far from where they were at the last build.
+         */
+        void refit();
+
+        /**
+         * \brief Find the closest triangle hit by a ray.
+         * 
+         * @param ray Ray in world space.
+         * @param hit Receives the closest hit.
+         * @return True if a triangle was hit.
+         */
+        bool intersect(const Ray& ray, Hit& hit) const;
+
+        /**
+         * \brief Find the closest hits of a batch of rays, spread across the
+         * @ThreadPool.
+         */
+        void intersect(const Ray* rays, Hit* hits, size_t count) const;
+
+        /**
+         * \brief Check if a ray hits any triangle.
+         */
+        bool occluded(const Ray& ray) const;
+
+        /**
+         * \brief Visibility of a batch of rays, spread across the @ThreadPool.
+         */
+        void occluded(const Ray* rays, bool* occluded, size_t count) const;
+
+        /**
+         * Get the number of instances.
+         */
+        size_t getNumberOfInstances() const
+        {
+            return _instances.size();
+        }
+
+        /**
+         * Get an instance.
+         */
+        const Instance& getInstance(U32 instance) const
+        {
+            return _instances[instance];
+        }
+
+        /**
+         * Get the nodes of the top-level tree; leaves reference instances
+         * through @getInstanceIndices().
+         */
+        const std::vector<BVH::Node>& getNodes() const
+        {
+            return _nodes;
+        }
+
+        /**
+         * Get the instance index of each leaf slot.
+         */
+        const std::vector<U32>& getInstanceIndices() const
+        {
+            return _indices;
+        }
+
+
+
+        private:
+
+        /// Private attributes ///
+
+        std::vector<Instance> _instances;
+        std::vector<BVH::Node> _nodes;
+        std::vector<U32> _indices;
+
+
+
+        /// Private methods ///
+
+        /**
+         * Recompute the inverse transforms and world bounds of the instances.
+         */
+        void _updateInstances();
+
+        /**
+         * Trace one ray, for the closest hit or (@anyHit) for any hit.
+         */
+        bool _trace(const Ray& ray, Hit& hit, bool anyHit) const;
+    };
+}
+
+#endif // TLAS_H
@@ -0,0 +1,56 @@
+/** 
+ * \file RandomTest.h
+ * \brief Base fixture for tests on random input: a fixed-seed generator and
+ * helpers to draw values, points, directions and rotations from it.
+ * 
+ * @author: Eder A. Perez.
+ */
+
+#ifndef RANDOM_TEST_H
+#define RANDOM_TEST_H
+
+#include <cmath>
+#include "gtest/gtest.h"
+#include "GLMatrix.h"
+#include "Matrix3x3.h"
+#include "Vector.h"
+#include "Xoshiro256.h"
+
+class RandomTest : public ::testing::Test
+{
+    protected:
+
+    nut::Xoshiro256 rng;
+
+    float uniform(float a, float b)
+    {
+        return a + (b - a) * rng.nextFloat();
+    }
+
+    nut::Vec3f randomPoint(float size)
+    {
+        return nut::Vec3f(uniform(-size, size), uniform(-size, size), uniform(-size, size));
+    }
+
+    nut::Vec3f randomUnit()
+    {
+        nut::Vec3f v;
+
+        do
+        {
+            v = nut::Vec3f(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f));
+        }
+        while (v * v > 1.0f || v * v < 1e-4f);
+
+        return v / std::sqrt(v * v);
+    }
+
+    nut::Matrix3x3<float> randomRotation()
+    {
+        nut::GLMatrix<float> m;
+        m.setRotation(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(0.1f, 1.0f), uniform(0.0f, 6.28f));
+        return nut::Matrix3x3<float>(m);
+    }
+};
+
+#endif // RANDOM_TEST_H
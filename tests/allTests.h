@@ -23,4 +23,42 @@
 #include "tests/GLMatrixFloatTest.cpp"
 #include "tests/GLMatrixDoubleTest.cpp"
 
+// core->rng
+#include "tests/RandomEngineTest.cpp"
+#include "tests/SIMDRandomTest.cpp"
+
+// core->thread
+#include "tests/ThreadPoolTest.cpp"
+
+// core->noise
+#include "tests/NoiseTest.cpp"
+
+// geometry
+#include "tests/BoundingBoxTest.cpp"
+#include "tests/ConvexHullTest.cpp"
+#include "tests/FrustumTest.cpp"
+#include "tests/LineTest.cpp"
+#include "tests/OcclusionBufferTest.cpp"
+#include "tests/OrientedBoundingBoxTest.cpp"
+#include "tests/PlaneTest.cpp"
+#include "tests/RayTest.cpp"
+#include "tests/SegmentTest.cpp"
+#include "tests/SphereTest.cpp"
+
+// spatial
+#include "tests/BVHTest.cpp"
+#include "tests/DynamicAABBTreeTest.cpp"
+#include "tests/GJKTest.cpp"
+#include "tests/KDTreeTest.cpp"
+#include "tests/LooseOctreeTest.cpp"
+#include "tests/PickerTest.cpp"
+#include "tests/SpatialHashGridTest.cpp"
+#include "tests/SweepAndPruneTest.cpp"
+#include "tests/TLASTest.cpp"
+
+// resources
+#include "tests/NutResourceFileTest.cpp"
+#include "tests/ResourceFileFactoryTest.cpp"
+#include "tests/ResourceManagerTest.cpp"
+
 #include "tests/DataTypeTest.cpp"
\ No newline at end of file
@@ -0,0 +1,449 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "BVH.h"
+#include "Mesh.h"
+
+using namespace nut;
+
+class BVHTest : public RandomTest
+{
+    protected:
+
+    // Small random triangles scattered in a cube
+    void makeSoup(Mesh& mesh, size_t triangles, float size)
+    {
+        std::vector<Vertex>& vertices = mesh.getVertices();
+        std::vector<int>& indices = mesh.getTriangulation();
+        vertices.resize(3 * triangles);
+        indices.resize(3 * triangles);
+
+        for (size_t t = 0; t < triangles; ++t)
+        {
+            Vec3f c(uniform(-size, size), uniform(-size, size), uniform(-size, size));
+
+            for (int k = 0; k < 3; ++k)
+            {
+                vertices[3 * t + k].pos = c + Vec3f(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f));
+                indices[3 * t + k] = int(3 * t + k);
+            }
+        }
+    }
+
+    static BoundingBox triangleBounds(const BVH::Triangle& t)
+    {
+        BoundingBox b;
+        b.expand(t.v0);
+        b.expand(t.v1);
+        b.expand(t.v2);
+        return b;
+    }
+
+    // Closest hit by testing every triangle of the mesh
+    static U32 bruteForce(Mesh& mesh, const Ray& ray, float& t)
+    {
+        U32 closest = BVH::NO_HIT;
+        t = ray.tMax;
+
+        for (size_t i = 0; i < mesh.getTriangulation().size() / 3; ++i)
+        {
+            const int* v = &mesh.getTriangulation()[3 * i];
+            float ti, u, w;
+
+            if (ray.intersect(mesh.getVertices()[v[0]].pos, mesh.getVertices()[v[1]].pos,
+                              mesh.getVertices()[v[2]].pos, ti, u, w) && ti < t)
+            {
+                t = ti;
+                closest = U32(i);
+            }
+        }
+
+        return closest;
+    }
+
+    // Rays from random points towards random targets; some are axis aligned
+    void makeRays(std::vector<Ray>& rays, size_t count, float size)
+    {
+        rays.resize(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Vec3f o(uniform(-2.0f * size, 2.0f * size), uniform(-2.0f * size, 2.0f * size), uniform(-2.0f * size, 2.0f * size));
+            Vec3f d = Vec3f(uniform(-size, size), uniform(-size, size), uniform(-size, size)) - o;
+
+            if (i % 7 == 0)
+            {
+                d.y = d.z = 0.0f;
+            }
+
+            rays[i] = Ray(o, d, 0.0f, i % 3 == 0 ? 0.5f : FLT_MAX);
+        }
+    }
+
+    // Check the structural invariants of a tree
+    static void validate(const BVH& bvh, size_t triangleCount)
+    {
+        const std::vector<BVH::Node>& nodes = bvh.getNodes();
+        std::vector<int> seen(triangleCount, 0);
+        std::vector<U32> stack(1, 0);
+        size_t visited = 0;
+
+        ASSERT_EQ(triangleCount, bvh.getTriangleIndices().size());
+        ASSERT_LE(nodes.size(), 2 * triangleCount - 1);
+
+        while (!stack.empty())
+        {
+            U32 n = stack.back();
+            stack.pop_back();
+            ++visited;
+
+            const BVH::Node& node = nodes[n];
+
+            if (node.isLeaf())
+            {
+                ASSERT_LE(node.count, BVH::MAX_LEAF_SIZE);
+
+                for (U32 i = node.index; i < node.index + node.count; ++i)
+                {
+                    ++seen[bvh.getTriangleIndices()[i]];
+                    ASSERT_TRUE(node.bounds.contains(triangleBounds(bvh.getTriangle(i))));
+                }
+            }
+            else
+            {
+                ASSERT_GT(node.index, n);
+                ASSERT_LT(node.index + 1, nodes.size());
+                ASSERT_TRUE(node.bounds.contains(nodes[node.index].bounds));
+                ASSERT_TRUE(node.bounds.contains(nodes[node.index + 1].bounds));
+                stack.push_back(node.index);
+                stack.push_back(node.index + 1);
+            }
+        }
+
+        EXPECT_EQ(nodes.size(), visited);
+
+        for (size_t i = 0; i < triangleCount; ++i)
+        {
+            ASSERT_EQ(1, seen[i]) << "triangle " << i;
+        }
+    }
+};
+
+TEST_F(BVHTest, buildInvariants)
+{
+    Mesh mesh;
+    makeSoup(mesh, 20000, 50.0f);
+
+    BVH bvh;
+    ASSERT_TRUE(bvh.build(mesh));
+    validate(bvh, 20000);
+
+    // SAH cost far below testing every triangle
+    EXPECT_LT(bvh.getCost(), 200.0f);
+}
+
+TEST_F(BVHTest, degenerateInput)
+{
+    BVH bvh;
+    Mesh empty;
+    EXPECT_FALSE(bvh.build(empty));
+    EXPECT_TRUE(bvh.isEmpty());
+    EXPECT_TRUE(bvh.getBounds().isEmpty());
+
+    // Single triangle
+    float positions[9] = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+    int indices[6] = { 0, 1, 2, 0, 1, 3 };
+    ASSERT_TRUE(bvh.build(positions, 3, 3, indices, 1));
+    EXPECT_EQ(size_t(1), bvh.getNodes().size());
+    EXPECT_TRUE(bvh.getBounds().contains(Vec3f(1.0f, 0.0f, 0.0f)));
+
+    // Out of range index
+    EXPECT_FALSE(bvh.build(positions, 3, 3, indices, 2));
+    EXPECT_TRUE(bvh.getBounds().isEmpty());
+
+    // Many identical triangles: must still respect the leaf size
+    std::vector<int> same(3 * 100);
+    for (size_t i = 0; i < same.size(); ++i) same[i] = int(i % 3);
+    ASSERT_TRUE(bvh.build(positions, 3, 3, &same[0], 100));
+    validate(bvh, 100);
+}
+
+TEST_F(BVHTest, queryMatchesBruteForce)
+{
+    Mesh mesh;
+    makeSoup(mesh, 5000, 20.0f);
+
+    BVH bvh;
+    ASSERT_TRUE(bvh.build(mesh));
+
+    for (int q = 0; q < 50; ++q)
+    {
+        Vec3f c(uniform(-20.0f, 20.0f), uniform(-20.0f, 20.0f), uniform(-20.0f, 20.0f));
+        Vec3f e(uniform(0.5f, 5.0f), uniform(0.5f, 5.0f), uniform(0.5f, 5.0f));
+        BoundingBox box(c - e, c + e);
+
+        std::vector<U32> result;
+        bvh.query(box, result);
+        std::sort(result.begin(), result.end());
+
+        std::vector<U32> expected;
+
+        for (size_t t = 0; t < 5000; ++t)
+        {
+            BoundingBox b;
+            for (int k = 0; k < 3; ++k) b.expand(mesh.getVertices()[mesh.getTriangulation()[3 * t + k]].pos);
+            if (b.overlaps(box)) expected.push_back(U32(t));
+        }
+
+        ASSERT_EQ(expected, result);
+    }
+}
+
+TEST_F(BVHTest, refit)
+{
+    Mesh mesh;
+    makeSoup(mesh, 10000, 30.0f);
+
+    BVH bvh;
+    ASSERT_TRUE(bvh.build(mesh));
+
+    // Deform: stretch along x and shift
+    std::vector<Vertex>& vertices = mesh.getVertices();
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        vertices[i].pos.x = vertices[i].pos.x * 2.0f + 5.0f;
+        vertices[i].pos.y += std::sin(vertices[i].pos.z);
+    }
+
+    ASSERT_TRUE(bvh.refit(mesh));
+    validate(bvh, 10000);
+
+    BoundingBox expected = BoundingBox::compute(mesh);
+    EXPECT_FLOAT_EQ(expected.min.x, bvh.getBounds().min.x);
+    EXPECT_FLOAT_EQ(expected.max.x, bvh.getBounds().max.x);
+    EXPECT_FLOAT_EQ(expected.max.y, bvh.getBounds().max.y);
+
+    // A mesh with another triangulation is rejected and the tree is kept
+    Mesh other;
+    makeSoup(other, 100, 30.0f);
+    EXPECT_FALSE(bvh.refit(other));
+    EXPECT_FLOAT_EQ(expected.min.x, bvh.getBounds().min.x);
+    validate(bvh, 10000);
+
+    BVH empty;
+    EXPECT_FALSE(empty.refit(mesh));
+    EXPECT_TRUE(empty.isEmpty());
+}
+
+TEST_F(BVHTest, rayMatchesBruteForce)
+{
+    Mesh mesh;
+    makeSoup(mesh, 3000, 20.0f);
+
+    BVH bvh;
+    ASSERT_TRUE(bvh.build(mesh));
+
+    // Not a multiple of the packet size
+    std::vector<Ray> rays;
+    makeRays(rays, 1003, 20.0f);
+
+    std::vector<BVH::Hit> hits(rays.size());
+    bool* occluded = new bool[rays.size()];
+    bvh.intersect(&rays[0], &hits[0], rays.size());
+    bvh.occluded(&rays[0], occluded, rays.size());
+
+    size_t hitCount = 0;
+
+    for (size_t i = 0; i < rays.size(); ++i)
+    {
+        float t;
+        U32 expected = bruteForce(mesh, rays[i], t);
+
+        BVH::Hit hit;
+        bool found = bvh.intersect(rays[i], hit);
+
+        ASSERT_EQ(expected != BVH::NO_HIT, found) << "ray " << i;
+        ASSERT_EQ(found, bvh.occluded(rays[i])) << "ray " << i;
+        ASSERT_EQ(found, occluded[i]) << "ray " << i;
+        ASSERT_EQ(hit.triangle, hits[i].triangle) << "ray " << i;
+
+        if (found)
+        {
+            // Ties between overlapping triangles may pick either one
+            EXPECT_NEAR(t, hit.t, 1e-4f * t);
+            EXPECT_FLOAT_EQ(hit.t, hits[i].t);
+            EXPECT_FLOAT_EQ(hit.u, hits[i].u);
+            ++hitCount;
+        }
+        else
+        {
+            EXPECT_EQ(BVH::NO_HIT, hit.triangle);
+            EXPECT_EQ(rays[i].tMax, hits[i].t);
+        }
+    }
+
+    delete[] occluded;
+
+    // Make sure both outcomes were exercised
+    EXPECT_GT(hitCount, size_t(50));
+    EXPECT_LT(hitCount, rays.size() - 50);
+
+    // Triangles move with a refit
+    std::vector<Vertex>& vertices = mesh.getVertices();
+    for (size_t i = 0; i < vertices.size(); ++i) vertices[i].pos.x += 3.0f;
+    ASSERT_TRUE(bvh.refit(mesh));
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        float t;
+        BVH::Hit hit;
+        EXPECT_EQ(bruteForce(mesh, rays[i], t) != BVH::NO_HIT, bvh.intersect(rays[i], hit)) << "ray " << i;
+    }
+}
+
+TEST_F(BVHTest, sweepThinWall)
+{
+    // A 20 x 20 wall of zero thickness at z = 0
+    float positions[] = { -10.0f, -10.0f, 0.0f, 10.0f, -10.0f, 0.0f, 10.0f, 10.0f, 0.0f, -10.0f, 10.0f, 0.0f };
+    int indices[] = { 0, 1, 2, 0, 2, 3 };
+
+    BVH bvh;
+    ASSERT_TRUE(bvh.build(positions, 4, 3, indices, 2));
+
+    // A bullet going from one side to the other in a single step
+    BVH::SweepHit hit;
+    BVH::Sweep bullet(Vec3f(1.0f, 2.0f, 5.0f), 0.1f, Vec3f(0.0f, 0.0f, -100.0f));
+    ASSERT_TRUE(bvh.sweep(bullet, hit));
+    EXPECT_NEAR(4.9f / 100.0f, hit.t, 1e-3f / 100.0f);
+    EXPECT_NEAR(1.0f, hit.point.x, 1e-4f);
+    EXPECT_NEAR(2.0f, hit.point.y, 1e-4f);
+    EXPECT_NEAR(0.0f, hit.point.z, 1e-4f);
+    EXPECT_NEAR(1.0f, hit.normal.z, 1e-5f);
+
+    // From below, at an angle
+    bullet = BVH::Sweep(Vec3f(0.0f, 0.0f, -1.0f), 0.5f, Vec3f(2.0f, 0.0f, 2.0f));
+    ASSERT_TRUE(bvh.sweep(bullet, hit));
+    EXPECT_NEAR(0.25f, hit.t, 1e-3f);
+    EXPECT_NEAR(-1.0f, hit.normal.z, 1e-5f);
+
+    // Capsules touch with their lowest point
+    BVH::Sweep standing(Segment(Vec3f(0.0f, 0.0f, 5.0f), Vec3f(0.0f, 0.0f, 7.0f)), 0.25f, Vec3f(0.0f, 0.0f, -10.0f));
+    ASSERT_TRUE(bvh.sweep(standing, hit));
+    EXPECT_NEAR(0.475f, hit.t, 1e-3f);
+
+    BVH::Sweep tilted(Segment(Vec3f(0.0f, 0.0f, 5.0f), Vec3f(3.0f, 0.0f, 3.0f)), 0.25f, Vec3f(0.0f, 0.0f, -10.0f));
+    ASSERT_TRUE(bvh.sweep(tilted, hit));
+    EXPECT_NEAR(0.275f, hit.t, 1e-3f);
+    EXPECT_NEAR(3.0f, hit.point.x, 1e-3f);
+
+    // Parallel, moving away, too short, past the edge
+    EXPECT_FALSE(bvh.sweep(BVH::Sweep(Vec3f(0.0f, 0.0f, 1.0f), 0.5f, Vec3f(50.0f, 0.0f, 0.0f)), hit));
+    EXPECT_EQ(BVH::NO_HIT, hit.triangle);
+    EXPECT_EQ(1.0f, hit.t);
+    EXPECT_FALSE(bvh.sweep(BVH::Sweep(Vec3f(0.0f, 0.0f, 1.0f), 0.5f, Vec3f(0.0f, 0.0f, 10.0f)), hit));
+    EXPECT_FALSE(bvh.sweep(BVH::Sweep(Vec3f(0.0f, 0.0f, 5.0f), 0.5f, Vec3f(0.0f, 0.0f, -4.0f)), hit));
+    EXPECT_FALSE(bvh.sweep(BVH::Sweep(Vec3f(11.0f, 0.0f, 5.0f), 0.5f, Vec3f(0.0f, 0.0f, -10.0f)), hit));
+
+    // Already touching
+    ASSERT_TRUE(bvh.sweep(BVH::Sweep(Vec3f(0.0f, 0.0f, 0.2f), 0.5f, Vec3f(0.0f, 0.0f, -1.0f)), hit));
+    EXPECT_EQ(0.0f, hit.t);
+    EXPECT_NEAR(1.0f, hit.normal.z, 1e-5f);
+
+    ASSERT_TRUE(bvh.sweep(BVH::Sweep(Vec3f(0.0f, 0.0f, 0.0f), 0.5f, Vec3f(0.0f, 0.0f, -1.0f)), hit));
+    EXPECT_EQ(0.0f, hit.t);
+    EXPECT_NEAR(1.0f, hit.normal.z, 1e-5f);
+}
+
+TEST_F(BVHTest, sweepGrazing)
+{
+    // The same 20 x 20 wall at z = 0
+    float positions[] = { -10.0f, -10.0f, 0.0f, 10.0f, -10.0f, 0.0f, 10.0f, 10.0f, 0.0f, -10.0f, 10.0f, 0.0f };
+    int indices[] = { 0, 1, 2, 0, 2, 3 };
+
+    BVH bvh;
+    ASSERT_TRUE(bvh.build(positions, 4, 3, indices, 2));
+
+    // Skims the top edge with no tolerance: the advance stalls a hair away
+    // from contact and runs out of steps
+    BVH::SweepHit hit;
+    BVH::Sweep skimming(Vec3f(-5.0f, 10.75f, 3.0f), 0.25f, Vec3f(20.0f, -1.0f, -5.998f));
+    skimming.tolerance = 0.0f;
+    ASSERT_TRUE(bvh.sweep(skimming, hit));
+    EXPECT_NEAR(0.5f, hit.t, 1e-4f);
+    EXPECT_TRUE(hit.t <= 0.50002f);
+    EXPECT_NEAR(10.0f, hit.point.y, 1e-3f);
+    EXPECT_NEAR(0.0f, hit.point.z, 1e-3f);
+    EXPECT_NEAR(1.0f, hit.normal.length(), 1e-5f);
+}
+
+TEST_F(BVHTest, sweepMatchesBruteForce)
+{
+    Mesh mesh;
+    makeSoup(mesh, 300, 5.0f);
+
+    BVH bvh;
+    ASSERT_TRUE(bvh.build(mesh));
+
+    std::vector<BVH::Sweep> sweeps(200);
+
+    for (size_t i = 0; i < sweeps.size(); ++i)
+    {
+        Vec3f a(uniform(-8.0f, 8.0f), uniform(-8.0f, 8.0f), uniform(-8.0f, 8.0f));
+        Vec3f axis = i % 2 == 0 ? Vec3f(0.0f, 0.0f, 0.0f) : Vec3f(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f));
+        Vec3f motion(uniform(-10.0f, 10.0f), uniform(-10.0f, 10.0f), uniform(-10.0f, 10.0f));
+        sweeps[i] = BVH::Sweep(Segment(a, a + axis), uniform(0.0f, 0.5f), motion);
+    }
+
+    std::vector<BVH::SweepHit> hits(sweeps.size());
+    bvh.sweep(&sweeps[0], &hits[0], sweeps.size());
+
+    size_t hitCount = 0;
+
+    for (size_t i = 0; i < sweeps.size(); ++i)
+    {
+        const BVH::Sweep& s = sweeps[i];
+        BVH::SweepHit single;
+        ASSERT_EQ(hits[i].triangle != BVH::NO_HIT, bvh.sweep(s, single));
+        ASSERT_EQ(single.t, hits[i].t);
+        ASSERT_EQ(single.triangle, hits[i].triangle);
+        hitCount += single.triangle != BVH::NO_HIT;
+
+        // Distance from the shape at time t to a triangle
+        std::vector<Vertex>& vertices = mesh.getVertices();
+        std::vector<int>& indices = mesh.getTriangulation();
+        auto distance = [&](float t, size_t triangle, Vec3f& q) -> float
+        {
+            Segment moved(s.axis.a + s.motion * t, s.axis.b + s.motion * t);
+            float u;
+            return std::sqrt(moved.closestPoints(vertices[indices[3 * triangle]].pos, vertices[indices[3 * triangle + 1]].pos,
+                                                 vertices[indices[3 * triangle + 2]].pos, u, q));
+        };
+
+        // Nothing is crossed before the contact, which is within the tolerance
+        Vec3f q;
+
+        for (int n = 0; n < 64 && single.t > 0.0f; ++n)
+        {
+            float t = single.t * float(n) / 64.0f;
+
+            for (size_t k = 0; k < indices.size() / 3; ++k)
+            {
+                ASSERT_GE(distance(t, k, q), s.radius - 1e-4f) << "sweep " << i << " triangle " << k << " t " << t;
+            }
+        }
+
+        if (single.triangle != BVH::NO_HIT)
+        {
+            ASSERT_LE(distance(single.t, single.triangle, q), s.radius + s.tolerance + 1e-4f);
+            ASSERT_NEAR(1.0f, single.normal.length(), 1e-4f);
+            ASSERT_TRUE(single.t == 0.0f || single.normal * s.motion <= 1e-4f);
+        }
+    }
+
+    // Some of each
+    EXPECT_GT(hitCount, sweeps.size() / 4);
+    EXPECT_LT(hitCount, sweeps.size());
+}
@@ -0,0 +1,213 @@
+#include <limits>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "BoundingBox.h"
+#include "Mesh.h"
+
+using namespace nut;
+
+class BoundingBoxTest : public RandomTest
+{
+    protected:
+
+    BoundingBox randomBox()
+    {
+        Vec3f c(uniform(-10.0f, 10.0f), uniform(-10.0f, 10.0f), uniform(-10.0f, 10.0f));
+        Vec3f e(uniform(0.1f, 2.0f), uniform(0.1f, 2.0f), uniform(0.1f, 2.0f));
+        return BoundingBox(c - e, c + e);
+    }
+};
+
+TEST_F(BoundingBoxTest, emptyMergeExpand)
+{
+    BoundingBox box;
+    EXPECT_TRUE(box.isEmpty());
+    EXPECT_FLOAT_EQ(0.0f, box.getSurfaceArea());
+
+    box.expand(Vec3f(1.0f, 2.0f, 3.0f));
+    EXPECT_FALSE(box.isEmpty());
+    EXPECT_TRUE(box.min == Vec3f(1.0f, 2.0f, 3.0f));
+    EXPECT_TRUE(box.max == Vec3f(1.0f, 2.0f, 3.0f));
+
+    box.expand(Vec3f(-1.0f, 4.0f, 0.0f));
+    EXPECT_TRUE(box.min == Vec3f(-1.0f, 2.0f, 0.0f));
+    EXPECT_TRUE(box.max == Vec3f(1.0f, 4.0f, 3.0f));
+
+    BoundingBox other(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(5.0f, 1.0f, 1.0f));
+    box.merge(other);
+    EXPECT_TRUE(box.min == Vec3f(-1.0f, 0.0f, 0.0f));
+    EXPECT_TRUE(box.max == Vec3f(5.0f, 4.0f, 3.0f));
+    EXPECT_TRUE(box.getCenter() == Vec3f(2.0f, 2.0f, 1.5f));
+    EXPECT_TRUE(box.getExtents() == Vec3f(3.0f, 2.0f, 1.5f));
+    EXPECT_FLOAT_EQ(2.0f * (6.0f * 4.0f + 4.0f * 3.0f + 3.0f * 6.0f), box.getSurfaceArea());
+
+    box.inflate(1.0f);
+    EXPECT_TRUE(box.min == Vec3f(-2.0f, -1.0f, -1.0f));
+
+    // Merging an empty box changes nothing
+    BoundingBox copy = box;
+    copy.merge(BoundingBox());
+    EXPECT_TRUE(copy.min == box.min && copy.max == box.max);
+}
+
+TEST_F(BoundingBoxTest, containsAndOverlaps)
+{
+    BoundingBox box(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(2.0f, 2.0f, 2.0f));
+
+    EXPECT_TRUE(box.contains(Vec3f(1.0f, 1.0f, 1.0f)));
+    EXPECT_TRUE(box.contains(Vec3f(2.0f, 0.0f, 1.0f)));
+    EXPECT_FALSE(box.contains(Vec3f(2.1f, 1.0f, 1.0f)));
+
+    EXPECT_TRUE(box.contains(BoundingBox(Vec3f(0.5f, 0.5f, 0.5f), Vec3f(1.5f, 1.5f, 1.5f))));
+    EXPECT_FALSE(box.contains(BoundingBox(Vec3f(0.5f, 0.5f, 0.5f), Vec3f(2.5f, 1.5f, 1.5f))));
+
+    EXPECT_TRUE(box.overlaps(BoundingBox(Vec3f(1.5f, 1.5f, 1.5f), Vec3f(3.0f, 3.0f, 3.0f))));
+    EXPECT_TRUE(box.overlaps(BoundingBox(Vec3f(2.0f, 0.0f, 0.0f), Vec3f(3.0f, 1.0f, 1.0f))));
+    EXPECT_FALSE(box.overlaps(BoundingBox(Vec3f(0.0f, 2.5f, 0.0f), Vec3f(1.0f, 3.0f, 1.0f))));
+    EXPECT_FALSE(box.overlaps(BoundingBox()));
+}
+
+TEST_F(BoundingBoxTest, transform)
+{
+    for (int n = 0; n < 100; ++n)
+    {
+        GLMatrix<float> m(uniform(-2.0f, 2.0f), uniform(-2.0f, 2.0f), uniform(-2.0f, 2.0f), uniform(-5.0f, 5.0f),
+                          uniform(-2.0f, 2.0f), uniform(-2.0f, 2.0f), uniform(-2.0f, 2.0f), uniform(-5.0f, 5.0f),
+                          uniform(-2.0f, 2.0f), uniform(-2.0f, 2.0f), uniform(-2.0f, 2.0f), uniform(-5.0f, 5.0f),
+                          0.0f, 0.0f, 0.0f, 1.0f);
+        BoundingBox box = randomBox();
+        BoundingBox expected;
+
+        // Brute force: transform the 8 corners
+        for (int c = 0; c < 8; ++c)
+        {
+            Vec3f corner(c & 1 ? box.max.x : box.min.x, c & 2 ? box.max.y : box.min.y, c & 4 ? box.max.z : box.min.z);
+            expected.expand(m * corner);
+        }
+
+        BoundingBox result = box.transform(m);
+
+        EXPECT_NEAR(expected.min.x, result.min.x, 1e-4f);
+        EXPECT_NEAR(expected.min.y, result.min.y, 1e-4f);
+        EXPECT_NEAR(expected.min.z, result.min.z, 1e-4f);
+        EXPECT_NEAR(expected.max.x, result.max.x, 1e-4f);
+        EXPECT_NEAR(expected.max.y, result.max.y, 1e-4f);
+        EXPECT_NEAR(expected.max.z, result.max.z, 1e-4f);
+    }
+
+    EXPECT_TRUE(BoundingBox().transform(GLMatrix<float>()).isEmpty());
+}
+
+TEST_F(BoundingBoxTest, intersectRay)
+{
+    BoundingBox box(Vec3f(-1.0f, -1.0f, -1.0f), Vec3f(1.0f, 1.0f, 1.0f));
+    const float inf = std::numeric_limits<float>::infinity();
+    float t = -1.0f;
+
+    // Along +x, from outside
+    EXPECT_TRUE(box.intersect(Vec3f(-5.0f, 0.0f, 0.0f), Vec3f(1.0f, inf, inf), 0.0f, 100.0f, &t));
+    EXPECT_FLOAT_EQ(4.0f, t);
+
+    // Interval ends before the box
+    EXPECT_FALSE(box.intersect(Vec3f(-5.0f, 0.0f, 0.0f), Vec3f(1.0f, inf, inf), 0.0f, 3.0f));
+
+    // Pointing away
+    EXPECT_FALSE(box.intersect(Vec3f(-5.0f, 0.0f, 0.0f), Vec3f(-1.0f, inf, inf), 0.0f, 100.0f));
+
+    // From inside: entry clamped to tMin
+    EXPECT_TRUE(box.intersect(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 1.0f, 1.0f), 0.0f, 100.0f, &t));
+    EXPECT_FLOAT_EQ(0.0f, t);
+
+    // Parallel to a face, outside of it
+    EXPECT_FALSE(box.intersect(Vec3f(-5.0f, 2.0f, 0.0f), Vec3f(1.0f, inf, inf), 0.0f, 100.0f));
+
+    // Parallel and lying on a face plane
+    EXPECT_TRUE(box.intersect(Vec3f(-5.0f, 1.0f, 0.0f), Vec3f(1.0f, inf, inf), 0.0f, 100.0f, &t));
+    EXPECT_FLOAT_EQ(4.0f, t);
+
+    // Diagonal
+    Vec3f d(1.0f, 1.0f, 1.0f);
+    EXPECT_TRUE(box.intersect(Vec3f(-3.0f, -3.0f, -3.0f), Vec3f(1.0f / d.x, 1.0f / d.y, 1.0f / d.z), 0.0f, 100.0f, &t));
+    EXPECT_FLOAT_EQ(2.0f, t);
+}
+
+TEST_F(BoundingBoxTest, bulkQueriesMatchScalar)
+{
+    const size_t N = 1003;
+    std::vector<BoundingBox> boxes(N);
+    std::vector<U32> indices(N);
+
+    for (size_t i = 0; i < N; ++i) boxes[i] = randomBox();
+
+    for (int q = 0; q < 20; ++q)
+    {
+        BoundingBox query = randomBox();
+        query.inflate(uniform(0.0f, 6.0f));
+
+        size_t n = BoundingBox::overlaps(&boxes[0], N, query, &indices[0]);
+        size_t k = 0;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (boxes[i].overlaps(query))
+            {
+                ASSERT_LT(k, n);
+                ASSERT_EQ(i, indices[k++]);
+            }
+        }
+
+        EXPECT_EQ(k, n);
+
+        n = BoundingBox::contained(&boxes[0], N, query, &indices[0]);
+        k = 0;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (query.contains(boxes[i]))
+            {
+                ASSERT_LT(k, n);
+                ASSERT_EQ(i, indices[k++]);
+            }
+        }
+
+        EXPECT_EQ(k, n);
+    }
+}
+
+TEST_F(BoundingBoxTest, computeBounds)
+{
+    const size_t N = 200001;
+    std::vector<Vec3f> points(N);
+    BoundingBox expected;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        points[i] = Vec3f(uniform(-3.0f, 1.0f), uniform(0.0f, 9.0f), uniform(-7.0f, -2.0f));
+        expected.expand(points[i]);
+    }
+
+    BoundingBox box = BoundingBox::compute(&points[0].x, N);
+    EXPECT_EQ(expected.min.x, box.min.x);
+    EXPECT_EQ(expected.min.y, box.min.y);
+    EXPECT_EQ(expected.min.z, box.min.z);
+    EXPECT_EQ(expected.max.x, box.max.x);
+    EXPECT_EQ(expected.max.y, box.max.y);
+    EXPECT_EQ(expected.max.z, box.max.z);
+
+    EXPECT_TRUE(BoundingBox::compute(&points[0].x, 0).isEmpty());
+
+    Mesh mesh;
+    mesh.getVertices().resize(13);
+
+    for (size_t i = 0; i < 13; ++i) mesh.getVertices()[i].pos = points[i];
+
+    box = BoundingBox::compute(mesh);
+    expected = BoundingBox();
+
+    for (size_t i = 0; i < 13; ++i) expected.expand(points[i]);
+
+    EXPECT_EQ(expected.min.x, box.min.x);
+    EXPECT_EQ(expected.max.y, box.max.y);
+    EXPECT_EQ(expected.max.z, box.max.z);
+}
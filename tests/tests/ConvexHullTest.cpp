@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "ConvexHull.h"
+#include "Mesh.h"
+
+using namespace nut;
+
+class ConvexHullTest : public RandomTest
+{
+    protected:
+
+    static bool build(ConvexHull& hull, const std::vector<Vec3f>& points, size_t maxVertices = 0)
+    {
+        return hull.build(&points[0].x, points.size(), 3, maxVertices);
+    }
+
+    static Vec3d toDouble(const Vec3f& v)
+    {
+        return Vec3d(v.x, v.y, v.z);
+    }
+
+    /**
+     * Check that the hull is a closed, outward oriented, convex polyhedron.
+     */
+    static void expectValid(ConvexHull& hull, float tolerance)
+    {
+        std::vector<Vec3f>& vertices = hull.getVertices();
+        std::vector<U32>& indices = hull.getIndices();
+        ASSERT_EQ(indices.size() % 3, 0u);
+
+        // Every directed edge once, and its twin once
+        std::set< std::pair<U32, U32> > edges;
+
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                ASSERT_TRUE(edges.insert(std::make_pair(indices[i + k], indices[i + (k + 1) % 3])).second);
+            }
+        }
+
+        for (std::set< std::pair<U32, U32> >::const_iterator it = edges.begin(); it != edges.end(); ++it)
+        {
+            ASSERT_EQ(edges.count(std::make_pair(it->second, it->first)), 1u);
+        }
+
+        size_t faces = indices.size() / 3;
+        EXPECT_EQ(vertices.size() + faces, edges.size() / 2 + 2); // Euler
+
+        Vec3f centroid(0.0f, 0.0f, 0.0f);
+
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            centroid += vertices[i];
+        }
+
+        centroid /= float(vertices.size());
+
+        // In double, so the check doesn't add its own rounding
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            Vec3d a = toDouble(vertices[indices[i]]);
+            Vec3d n = (toDouble(vertices[indices[i + 1]]) - a).cross(toDouble(vertices[indices[i + 2]]) - a);
+            n /= n.length();
+
+            ASSERT_LT(n * (toDouble(centroid) - a), 0.0);
+
+            for (size_t j = 0; j < vertices.size(); ++j)
+            {
+                ASSERT_LE(n * (toDouble(vertices[j]) - a), tolerance) << "face " << i / 3 << " vertex " << j;
+            }
+        }
+    }
+};
+
+TEST_F(ConvexHullTest, cube)
+{
+    // Corners, interior points and points on the faces, edges and corners again
+    std::vector<Vec3f> points;
+
+    for (int i = 0; i < 500; ++i)
+    {
+        points.push_back(Vec3f(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f)));
+    }
+
+    for (int x = -2; x <= 2; ++x)
+    {
+        for (int y = -2; y <= 2; ++y)
+        {
+            for (int z = -2; z <= 2; ++z)
+            {
+                points.push_back(Vec3f(float(x), float(y), float(z)) * 0.5f);
+            }
+        }
+    }
+
+    ConvexHull hull;
+    EXPECT_TRUE(hull.isEmpty());
+    ASSERT_TRUE(build(hull, points));
+    EXPECT_EQ(hull.getVertices().size(), 8u);
+    EXPECT_EQ(hull.getIndices().size(), 36u);
+    EXPECT_EQ(hull.getError(), 0.0f);
+    expectValid(hull, 1e-5f);
+
+    for (size_t i = 0; i < hull.getVertices().size(); ++i)
+    {
+        const Vec3f& v = hull.getVertices()[i];
+        EXPECT_EQ(std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z), 3.0f);
+    }
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        ASSERT_TRUE(hull.contains(points[i], 1e-5f)) << "point " << i;
+    }
+
+    EXPECT_FALSE(hull.contains(Vec3f(1.01f, 0.0f, 0.0f)));
+    EXPECT_FALSE(hull.contains(Vec3f(0.8f, 0.8f, -1.1f)));
+}
+
+TEST_F(ConvexHullTest, sphere)
+{
+    // Every point is a vertex
+    std::vector<Vec3f> points;
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        points.push_back(randomUnit() * 10.0f + Vec3f(100.0f, -50.0f, 20.0f));
+    }
+
+    ConvexHull hull;
+    ASSERT_TRUE(build(hull, points));
+    EXPECT_EQ(hull.getVertices().size(), points.size());
+    expectValid(hull, 1e-4f);
+}
+
+TEST_F(ConvexHullTest, largeCloud)
+{
+    // Enough points to assign them in parallel
+    std::vector<Vec3f> points;
+
+    for (int i = 0; i < 200000; ++i)
+    {
+        points.push_back(Vec3f(uniform(-1.0f, 1.0f), uniform(-2.0f, 2.0f), uniform(-3.0f, 3.0f)));
+    }
+
+    ConvexHull hull;
+    ASSERT_TRUE(build(hull, points));
+    expectValid(hull, 1e-5f);
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        ASSERT_TRUE(hull.contains(points[i], 1e-5f)) << "point " << i;
+    }
+
+    // Same result on a second build
+    std::vector<Vec3f> vertices = hull.getVertices();
+    std::vector<U32> indices = hull.getIndices();
+    ASSERT_TRUE(build(hull, points));
+    EXPECT_TRUE(vertices == hull.getVertices());
+    EXPECT_TRUE(indices == hull.getIndices());
+}
+
+TEST_F(ConvexHullTest, degenerate)
+{
+    ConvexHull hull;
+    std::vector<Vec3f> points(3, Vec3f(1.0f, 2.0f, 3.0f));
+
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(build(hull, points));
+
+    // Coincident
+    points.assign(10, Vec3f(1.0f, 2.0f, 3.0f));
+    EXPECT_FALSE(build(hull, points));
+
+    // Collinear
+    points.clear();
+
+    for (int i = 0; i < 10; ++i)
+    {
+        points.push_back(Vec3f(1.0f, 2.0f, 3.0f) * float(i));
+    }
+
+    EXPECT_FALSE(build(hull, points));
+
+    // Coplanar, with rounding noise below the tolerance
+    points.clear();
+
+    for (int i = 0; i < 100; ++i)
+    {
+        float x = uniform(-1.0f, 1.0f);
+        float y = uniform(-1.0f, 1.0f);
+        points.push_back(Vec3f(x, y, 0.5f * x - 0.25f * y + 1.0f));
+    }
+
+    EXPECT_FALSE(build(hull, points));
+    EXPECT_TRUE(hull.isEmpty());
+
+    // Flat input is an expected case, not an error
+    EXPECT_TRUE(testing::internal::GetCapturedStderr().empty());
+
+    // A thin but valid slab
+    points.push_back(Vec3f(0.0f, 0.0f, 1.01f));
+    ASSERT_TRUE(build(hull, points));
+    expectValid(hull, 1e-5f);
+}
+
+TEST_F(ConvexHullTest, vertexBudget)
+{
+    std::vector<Vec3f> points;
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        points.push_back(randomUnit() * uniform(0.9f, 1.0f));
+    }
+
+    ConvexHull full;
+    ASSERT_TRUE(build(full, points));
+
+    float previous = 2.0f;
+    size_t budgets[] = { 4, 16, 64, 256 };
+
+    for (size_t b = 0; b < 4; ++b)
+    {
+        ConvexHull hull;
+        ASSERT_TRUE(build(hull, points, budgets[b]));
+        EXPECT_EQ(hull.getVertices().size(), budgets[b]);
+        expectValid(hull, 1e-5f);
+
+        // Inside the exact hull, and off by the reported error
+        float error = hull.getError();
+        EXPECT_GT(error, 0.0f);
+        EXPECT_LT(error, previous);
+        previous = error;
+
+        for (size_t i = 0; i < hull.getVertices().size(); ++i)
+        {
+            EXPECT_TRUE(full.contains(hull.getVertices()[i], 1e-5f));
+        }
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            ASSERT_TRUE(hull.contains(points[i], error + 1e-5f)) << "point " << i;
+        }
+    }
+
+    // A budget above the exact vertex count gives the exact hull
+    ConvexHull hull;
+    ASSERT_TRUE(build(hull, points, full.getVertices().size() + 1));
+    EXPECT_EQ(hull.getVertices().size(), full.getVertices().size());
+    EXPECT_EQ(hull.getError(), 0.0f);
+
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(build(hull, points, 3));
+    testing::internal::GetCapturedStderr();
+}
+
+TEST_F(ConvexHullTest, mesh)
+{
+    Mesh mesh;
+    std::vector<Vertex>& vertices = mesh.getVertices();
+
+    for (int i = 0; i < 300; ++i)
+    {
+        Vertex vertex;
+        vertex.pos = randomUnit() * 2.0f;
+        vertex.normal = vertex.pos;
+        vertices.push_back(vertex);
+    }
+
+    ConvexHull& hull = mesh.getConvexHull();
+    ASSERT_TRUE(hull.build(mesh));
+    EXPECT_EQ(hull.getVertices().size(), vertices.size());
+    expectValid(hull, 1e-5f);
+
+    ConvexHull copy;
+    ASSERT_TRUE(copy.build(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float)));
+    EXPECT_TRUE(copy.getIndices() == hull.getIndices());
+}
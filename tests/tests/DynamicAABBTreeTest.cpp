@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "DynamicAABBTree.h"
+
+using namespace nut;
+
+class DynamicAABBTreeTest : public RandomTest
+{
+    protected:
+
+    typedef std::set< std::pair<U32, U32> > PairSet;
+
+    BoundingBox randomBox(float size, float maxExtent)
+    {
+        Vec3f c(uniform(-size, size), uniform(-size, size), uniform(-size, size));
+        Vec3f e(uniform(0.1f, maxExtent), uniform(0.1f, maxExtent), uniform(0.1f, maxExtent));
+        return BoundingBox(c - e, c + e);
+    }
+
+    static PairSet toSet(const std::vector<DynamicAABBTree::Pair>& pairs)
+    {
+        PairSet set;
+
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            EXPECT_LT(pairs[i].a, pairs[i].b);
+            EXPECT_TRUE(set.insert(std::make_pair(pairs[i].a, pairs[i].b)).second) << "duplicate pair";
+        }
+
+        return set;
+    }
+
+    // Overlapping fat boxes among live proxies, optionally only pairs with a moved proxy
+    static PairSet bruteForcePairs(const DynamicAABBTree& tree, const std::vector<U32>& live,
+                                   const std::set<U32>* moved = nullptr)
+    {
+        PairSet set;
+
+        for (size_t i = 0; i < live.size(); ++i)
+        {
+            for (size_t j = 0; j < live.size(); ++j)
+            {
+                U32 a = live[i], b = live[j];
+
+                if (a < b && tree.getFatBounds(a).overlaps(tree.getFatBounds(b)) &&
+                    (moved == nullptr || moved->count(a) || moved->count(b)))
+                {
+                    set.insert(std::make_pair(a, b));
+                }
+            }
+        }
+
+        return set;
+    }
+};
+
+TEST_F(DynamicAABBTreeTest, empty)
+{
+    DynamicAABBTree tree;
+    std::vector<U32> proxies;
+    std::vector<DynamicAABBTree::Pair> pairs;
+
+    EXPECT_EQ(-1, tree.getHeight());
+    EXPECT_EQ(size_t(0), tree.query(randomBox(1.0f, 1.0f), proxies));
+    EXPECT_EQ(size_t(0), tree.query(Ray(), proxies));
+    EXPECT_EQ(DynamicAABBTree::NULL_NODE, tree.raycast(Ray(), [](U32, const Ray& r) { return r.tMax; }));
+
+    tree.updatePairs(pairs);
+    EXPECT_TRUE(pairs.empty());
+
+    // Single proxy: fattened by the margin
+    U32 proxy = tree.createProxy(BoundingBox(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 1.0f, 1.0f)), 42);
+    EXPECT_EQ(0, tree.getHeight());
+    EXPECT_EQ(U32(42), tree.getUserData(proxy));
+    EXPECT_FLOAT_EQ(-0.1f, tree.getFatBounds(proxy).min.x);
+    EXPECT_EQ(size_t(1), tree.query(BoundingBox(Vec3f(1.05f, 0.5f, 0.5f), Vec3f(2.0f, 2.0f, 2.0f)), proxies));
+
+    tree.destroyProxy(proxy);
+    EXPECT_EQ(size_t(0), tree.getNumberOfProxies());
+    EXPECT_EQ(-1, tree.getHeight());
+    tree.updatePairs(pairs);
+    EXPECT_TRUE(pairs.empty());
+}
+
+TEST_F(DynamicAABBTreeTest, fatBoxes)
+{
+    DynamicAABBTree tree(0.5f);
+    BoundingBox box(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 1.0f, 1.0f));
+    U32 proxy = tree.createProxy(box, 0);
+
+    // Small motions stay inside the fat box
+    box.min.x += 0.3f;
+    box.max.x += 0.3f;
+    EXPECT_FALSE(tree.moveProxy(proxy, box, Vec3f(0.3f, 0.0f, 0.0f)));
+
+    // Leaving it reinserts, stretched along the motion
+    box.min.x += 0.5f;
+    box.max.x += 0.5f;
+    EXPECT_TRUE(tree.moveProxy(proxy, box, Vec3f(0.5f, 0.0f, 0.0f)));
+    EXPECT_FLOAT_EQ(box.max.x + 0.5f + 1.0f, tree.getFatBounds(proxy).max.x);
+    EXPECT_FLOAT_EQ(box.min.x - 0.5f, tree.getFatBounds(proxy).min.x);
+
+    // Stopping shrinks it back once the stretch is large compared to the margin
+    EXPECT_FALSE(tree.moveProxy(proxy, box, Vec3f(0.0f, 0.0f, 0.0f)));
+    DynamicAABBTree fast(0.1f);
+    proxy = fast.createProxy(box, 0);
+    box.min.x += 2.0f;
+    box.max.x += 2.0f;
+    EXPECT_TRUE(fast.moveProxy(proxy, box, Vec3f(2.0f, 0.0f, 0.0f)));
+    EXPECT_TRUE(fast.moveProxy(proxy, box, Vec3f(0.0f, 0.0f, 0.0f)));
+    EXPECT_FLOAT_EQ(box.max.x + 0.1f, fast.getFatBounds(proxy).max.x);
+}
+
+TEST_F(DynamicAABBTreeTest, matchesBruteForce)
+{
+    DynamicAABBTree tree;
+    std::vector<U32> live;
+    std::vector<BoundingBox> boxes(1000);
+    std::vector<DynamicAABBTree::Pair> pairs;
+
+    for (U32 i = 0; i < 600; ++i)
+    {
+        boxes[i] = randomBox(30.0f, 1.5f);
+        live.push_back(tree.createProxy(boxes[i], i));
+        EXPECT_EQ(i, tree.getUserData(live.back()));
+    }
+
+    // First update reports every pair
+    tree.updatePairs(pairs);
+    EXPECT_EQ(bruteForcePairs(tree, live), toSet(pairs));
+
+    size_t pairCount = 0;
+
+    for (int frame = 0; frame < 20; ++frame)
+    {
+        std::set<U32> moved;
+
+        // Move some proxies, destroy a few and create new ones
+        for (size_t i = 0; i < live.size(); ++i)
+        {
+            if (rng.nextFloat() < 0.3f)
+            {
+                U32 proxy = live[i];
+                U32 id = tree.getUserData(proxy);
+                Vec3f d(uniform(-0.5f, 0.5f), uniform(-0.5f, 0.5f), uniform(-0.5f, 0.5f));
+                boxes[id] = BoundingBox(boxes[id].min + d, boxes[id].max + d);
+
+                if (tree.moveProxy(proxy, boxes[id], d))
+                {
+                    moved.insert(proxy);
+                }
+
+                ASSERT_TRUE(tree.getFatBounds(proxy).contains(boxes[id]));
+            }
+        }
+
+        for (int k = 0; k < 5; ++k)
+        {
+            size_t i = size_t(rng.next() % live.size());
+
+            moved.erase(live[i]);
+            tree.destroyProxy(live[i]);
+            live[i] = live.back();
+            live.pop_back();
+
+            U32 id = U32(600 + frame * 5 + k);
+            boxes[id] = randomBox(30.0f, 1.5f);
+            live.push_back(tree.createProxy(boxes[id], id));
+            moved.insert(live.back());
+        }
+
+        tree.updatePairs(pairs);
+        ASSERT_EQ(bruteForcePairs(tree, live, &moved), toSet(pairs)) << "frame " << frame;
+
+        tree.findPairs(pairs);
+        ASSERT_EQ(bruteForcePairs(tree, live), toSet(pairs)) << "frame " << frame;
+        pairCount += pairs.size();
+
+        // Nothing moved since the last update
+        tree.updatePairs(pairs);
+        ASSERT_TRUE(pairs.empty());
+    }
+
+    EXPECT_GT(pairCount, size_t(20 * 50));
+    EXPECT_EQ(live.size(), tree.getNumberOfProxies());
+
+    // Balanced
+    EXPECT_LE(tree.getHeight(), 2 * int(std::log2(double(live.size()))) + 2);
+
+    // Region and ray queries
+    for (int q = 0; q < 200; ++q)
+    {
+        BoundingBox region = randomBox(30.0f, 5.0f);
+        std::vector<U32> found, expected;
+        tree.query(region, found);
+
+        Vec3f o(uniform(-40.0f, 40.0f), uniform(-40.0f, 40.0f), uniform(-40.0f, 40.0f));
+        Ray ray(o, Vec3f(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f)));
+        ray.tMax = uniform(10.0f, 100.0f);
+        std::vector<U32> hit, expectedHit;
+        tree.query(ray, hit);
+
+        for (size_t i = 0; i < live.size(); ++i)
+        {
+            const BoundingBox& fat = tree.getFatBounds(live[i]);
+
+            if (fat.overlaps(region))
+            {
+                expected.push_back(live[i]);
+            }
+
+            if (fat.intersect(ray.origin, ray.invDirection, ray.tMin, ray.tMax))
+            {
+                expectedHit.push_back(live[i]);
+            }
+        }
+
+        std::sort(found.begin(), found.end());
+        std::sort(hit.begin(), hit.end());
+        std::sort(expected.begin(), expected.end());
+        std::sort(expectedHit.begin(), expectedHit.end());
+        ASSERT_EQ(expected, found);
+        ASSERT_EQ(expectedHit, hit);
+    }
+}
+
+TEST_F(DynamicAABBTreeTest, raycast)
+{
+    // Spheres inscribed in the boxes, unit length ray directions
+    DynamicAABBTree tree;
+    std::vector<Vec3f> centers;
+    std::vector<float> radii;
+
+    for (U32 i = 0; i < 2000; ++i)
+    {
+        Vec3f c(uniform(-50.0f, 50.0f), uniform(-50.0f, 50.0f), uniform(-50.0f, 50.0f));
+        float r = uniform(0.2f, 2.0f);
+        centers.push_back(c);
+        radii.push_back(r);
+        tree.createProxy(BoundingBox(c - Vec3f(r, r, r), c + Vec3f(r, r, r)), i);
+    }
+
+    auto sphereHit = [&](U32 id, const Ray& ray)
+    {
+        Vec3f oc = ray.origin - centers[id];
+        float b = oc * ray.direction, c = oc * oc - radii[id] * radii[id];
+        float disc = b * b - c;
+
+        if (disc < 0.0f)
+        {
+            return ray.tMax;
+        }
+
+        float t = -b - std::sqrt(disc);
+        return t >= ray.tMin && t < ray.tMax ? t : ray.tMax;
+    };
+
+    size_t hits = 0, calls = 0;
+
+    for (int q = 0; q < 500; ++q)
+    {
+        Vec3f o(uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f));
+        Vec3f d(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f));
+        Ray ray(o, d / d.length());
+
+        U32 expected = DynamicAABBTree::NULL_NODE;
+        float tExpected = ray.tMax;
+
+        for (U32 i = 0; i < centers.size(); ++i)
+        {
+            float t = sphereHit(i, ray);
+
+            if (t < tExpected)
+            {
+                tExpected = t;
+                expected = i;
+            }
+        }
+
+        float t;
+        U32 proxy = tree.raycast(ray, [&](U32 p, const Ray& r)
+        {
+            ++calls;
+            return sphereHit(tree.getUserData(p), r);
+        }, &t);
+
+        ASSERT_EQ(expected, proxy == DynamicAABBTree::NULL_NODE ? proxy : tree.getUserData(proxy)) << "ray " << q;
+        ASSERT_FLOAT_EQ(tExpected, t);
+        hits += proxy != DynamicAABBTree::NULL_NODE;
+    }
+
+    EXPECT_GT(hits, size_t(50));
+
+    // Near to far traversal skips most proxies
+    EXPECT_LT(calls, size_t(500 * 50));
+}
+
+TEST_F(DynamicAABBTreeTest, clearAndReuse)
+{
+    DynamicAABBTree tree;
+    tree.reserve(100);
+
+    for (U32 i = 0; i < 100; ++i)
+    {
+        tree.createProxy(randomBox(10.0f, 1.0f), i);
+    }
+
+    tree.clear();
+    EXPECT_EQ(size_t(0), tree.getNumberOfProxies());
+
+    std::vector<DynamicAABBTree::Pair> pairs;
+    tree.findPairs(pairs);
+    EXPECT_TRUE(pairs.empty());
+
+    std::vector<U32> live;
+
+    for (U32 i = 0; i < 100; ++i)
+    {
+        live.push_back(tree.createProxy(randomBox(10.0f, 1.0f), i));
+    }
+
+    tree.updatePairs(pairs);
+    EXPECT_EQ(bruteForcePairs(tree, live), toSet(pairs));
+}
+
+TEST_F(DynamicAABBTreeTest, movingBodiesStayBalanced)
+{
+    const size_t N = 50000;
+    const float size = 300.0f;
+    DynamicAABBTree tree;
+    std::vector<BoundingBox> boxes(N);
+    std::vector<Vec3f> velocities(N);
+    std::vector<U32> proxies(N);
+    std::vector<DynamicAABBTree::Pair> pairs;
+
+    tree.reserve(N);
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        boxes[i] = randomBox(size, 1.0f);
+        velocities[i] = Vec3f(uniform(-0.2f, 0.2f), uniform(-0.2f, 0.2f), uniform(-0.2f, 0.2f));
+        proxies[i] = tree.createProxy(boxes[i], U32(i));
+    }
+
+    tree.updatePairs(pairs);
+
+    const int frames = 20;
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            boxes[i] = BoundingBox(boxes[i].min + velocities[i], boxes[i].max + velocities[i]);
+            tree.moveProxy(proxies[i], boxes[i], velocities[i]);
+        }
+
+        tree.updatePairs(pairs);
+    }
+
+    EXPECT_LE(tree.getHeight(), 40);
+}
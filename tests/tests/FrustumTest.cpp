@@ -0,0 +1,114 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "Frustum.h"
+
+using namespace nut;
+
+class FrustumTest : public RandomTest
+{
+    protected:
+
+    Frustum frustum;
+
+    // Camera at the origin looking down -z: 90 degrees fov, square aspect, near 1, far 100
+    virtual void SetUp()
+    {
+        GLMatrix<float> projection, view;
+        projection.setPerspective(90.0f, 1.0f, 1.0f, 100.0f);
+        view.setLookAt(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f);
+        frustum.set(projection * view);
+    }
+};
+
+TEST_F(FrustumTest, planes)
+{
+    // Near plane faces -z at distance 1, far plane faces +z at distance 100
+    const Plane& zNear = frustum.getPlane(Frustum::ZNEAR);
+    EXPECT_NEAR(0.0f, zNear.normal.x, 1e-5f);
+    EXPECT_NEAR(-1.0f, zNear.normal.z, 1e-5f);
+    EXPECT_NEAR(-1.0f, zNear.distance, 1e-4f);
+
+    const Plane& zFar = frustum.getPlane(Frustum::ZFAR);
+    EXPECT_NEAR(1.0f, zFar.normal.z, 1e-5f);
+    EXPECT_NEAR(100.0f, zFar.distance, 1e-2f);
+
+    // 90 degrees: left plane normal is (1, 0, -1) / sqrt(2)
+    const Plane& left = frustum.getPlane(Frustum::LEFT);
+    EXPECT_NEAR(0.70710678f, left.normal.x, 1e-5f);
+    EXPECT_NEAR(-0.70710678f, left.normal.z, 1e-5f);
+    EXPECT_NEAR(0.0f, left.distance, 1e-5f);
+
+    // Identity: the clip cube
+    Frustum cube;
+    EXPECT_TRUE(cube.contains(Vec3f(0.9f, -0.9f, 0.9f)));
+    EXPECT_FALSE(cube.contains(Vec3f(1.1f, 0.0f, 0.0f)));
+}
+
+TEST_F(FrustumTest, singleTests)
+{
+    EXPECT_TRUE(frustum.contains(Vec3f(0.0f, 0.0f, -10.0f)));
+    EXPECT_TRUE(frustum.contains(Vec3f(9.0f, -9.0f, -10.0f)));
+    EXPECT_FALSE(frustum.contains(Vec3f(11.0f, 0.0f, -10.0f)));
+    EXPECT_FALSE(frustum.contains(Vec3f(0.0f, 0.0f, -0.5f)));
+    EXPECT_FALSE(frustum.contains(Vec3f(0.0f, 0.0f, -101.0f)));
+    EXPECT_FALSE(frustum.contains(Vec3f(0.0f, 0.0f, 10.0f)));
+
+    EXPECT_TRUE(frustum.intersects(Vec3f(11.0f, 0.0f, -10.0f), 1.0f));
+    EXPECT_FALSE(frustum.intersects(Vec3f(12.0f, 0.0f, -10.0f), 1.0f));
+    EXPECT_TRUE(frustum.intersects(Vec3f(0.0f, 0.0f, 1.0f), 2.5f));
+    EXPECT_FALSE(frustum.intersects(Vec3f(0.0f, 0.0f, 1.0f), 1.5f));
+
+    EXPECT_TRUE(frustum.intersects(BoundingBox(Vec3f(10.5f, -1.0f, -11.0f), Vec3f(12.0f, 1.0f, -9.0f))));
+    EXPECT_FALSE(frustum.intersects(BoundingBox(Vec3f(11.5f, -1.0f, -10.5f), Vec3f(12.0f, 1.0f, -9.5f))));
+    EXPECT_TRUE(frustum.intersects(BoundingBox(Vec3f(-100.0f, -100.0f, -50.0f), Vec3f(100.0f, 100.0f, -40.0f))));
+    EXPECT_FALSE(frustum.intersects(BoundingBox(Vec3f(-1.0f, -1.0f, 0.0f), Vec3f(1.0f, 1.0f, 5.0f))));
+}
+
+TEST_F(FrustumTest, bulkMatchesScalar)
+{
+    // Large enough to be split across threads, not a multiple of the SIMD width
+    const size_t N = 100003;
+    std::vector<float> x(N), y(N), z(N), r(N);
+    std::vector<BoundingBox> boxes(N);
+    std::vector<U32> visible(N);
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        x[i] = uniform(-120.0f, 120.0f);
+        y[i] = uniform(-120.0f, 120.0f);
+        z[i] = uniform(-120.0f, 20.0f);
+        r[i] = uniform(0.0f, 5.0f);
+        boxes[i] = BoundingBox(Vec3f(x[i] - r[i], y[i] - 0.5f * r[i], z[i] - 2.0f * r[i]), Vec3f(x[i] + r[i], y[i], z[i]));
+    }
+
+    size_t n = frustum.cullSpheres(&x[0], &y[0], &z[0], &r[0], N, &visible[0]);
+    size_t k = 0;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (frustum.intersects(Vec3f(x[i], y[i], z[i]), r[i]))
+        {
+            ASSERT_LT(k, n);
+            ASSERT_EQ(i, visible[k++]);
+        }
+    }
+
+    EXPECT_EQ(k, n);
+    EXPECT_GT(n, N / 10);
+    EXPECT_LT(n, N / 2);
+
+    n = frustum.cullBoxes(&boxes[0], N, &visible[0]);
+    k = 0;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (frustum.intersects(boxes[i]))
+        {
+            ASSERT_LT(k, n);
+            ASSERT_EQ(i, visible[k++]);
+        }
+    }
+
+    EXPECT_EQ(k, n);
+}
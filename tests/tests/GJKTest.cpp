@@ -0,0 +1,258 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "GJK.h"
+
+using namespace nut;
+
+class GJKTest : public RandomTest
+{
+    protected:
+
+    OrientedBoundingBox randomBox(float spread)
+    {
+        return OrientedBoundingBox(Vec3f(uniform(-spread, spread), uniform(-spread, spread), uniform(-spread, spread)),
+                                   Vec3f(uniform(0.2f, 2.0f), uniform(0.2f, 2.0f), uniform(0.2f, 2.0f)),
+                                   randomRotation());
+    }
+
+    static OrientedBoundingBox moved(const OrientedBoundingBox& box, const Vec3f& offset)
+    {
+        return OrientedBoundingBox(box.center + offset, box.halfExtents, box.basis);
+    }
+
+    static void expectVecNear(const Vec3f& expected, const Vec3f& v, float tolerance)
+    {
+        EXPECT_NEAR(expected.x, v.x, tolerance);
+        EXPECT_NEAR(expected.y, v.y, tolerance);
+        EXPECT_NEAR(expected.z, v.z, tolerance);
+    }
+};
+
+TEST_F(GJKTest, spheres)
+{
+    SphereShape a(Sphere(Vec3f(0.0f, 0.0f, 0.0f), 1.0f));
+    SphereShape b(Sphere(Vec3f(3.0f, 0.0f, 0.0f), 1.0f));
+    GJK::Result result;
+
+    ASSERT_TRUE(GJK::distance(a, b, result));
+    EXPECT_NEAR(1.0f, result.distance, 1e-5f);
+    expectVecNear(Vec3f(1.0f, 0.0f, 0.0f), result.pointA, 1e-5f);
+    expectVecNear(Vec3f(2.0f, 0.0f, 0.0f), result.pointB, 1e-5f);
+    expectVecNear(Vec3f(1.0f, 0.0f, 0.0f), result.normal, 1e-5f);
+    EXPECT_FALSE(GJK::intersect(a, b));
+
+    // Overlapping surfaces, separated centers
+    b.sphere.center = Vec3f(1.5f, 0.0f, 0.0f);
+    EXPECT_TRUE(GJK::intersect(a, b));
+    EXPECT_FALSE(GJK::distance(a, b, result));
+    EXPECT_EQ(0.0f, result.distance);
+    ASSERT_TRUE(GJK::penetration(a, b, result));
+    EXPECT_NEAR(-0.5f, result.distance, 1e-5f);
+    expectVecNear(Vec3f(1.0f, 0.0f, 0.0f), result.normal, 1e-5f);
+
+    // Same center: the radii make all of the depth, along any normal
+    b.sphere = Sphere(Vec3f(0.0f, 0.0f, 0.0f), 0.5f);
+    ASSERT_TRUE(GJK::penetration(a, b, result));
+    EXPECT_NEAR(-1.5f, result.distance, 1e-5f);
+    EXPECT_NEAR(1.0f, result.normal.length(), 1e-5f);
+}
+
+TEST_F(GJKTest, boxes)
+{
+    BoxShape a(OrientedBoundingBox(BoundingBox(Vec3f(-1.0f, -1.0f, -1.0f), Vec3f(1.0f, 1.0f, 1.0f))));
+    BoxShape b(OrientedBoundingBox(BoundingBox(Vec3f(2.0f, 1.5f, -1.0f), Vec3f(4.0f, 3.5f, 1.0f))));
+    GJK::Result result;
+
+    // Closest features: edge against edge, 1 apart along x and 0.5 along y
+    ASSERT_TRUE(GJK::distance(a, b, result));
+    EXPECT_NEAR(std::sqrt(1.25f), result.distance, 1e-5f);
+    EXPECT_NEAR(1.0f, result.pointA.x, 1e-5f);
+    EXPECT_NEAR(1.0f, result.pointA.y, 1e-5f);
+    EXPECT_NEAR(2.0f, result.pointB.x, 1e-5f);
+    EXPECT_NEAR(1.5f, result.pointB.y, 1e-5f);
+
+    // Least overlap along x
+    b.box = OrientedBoundingBox(BoundingBox(Vec3f(0.5f, -0.8f, -0.9f), Vec3f(2.5f, 1.2f, 1.1f)));
+    ASSERT_TRUE(GJK::penetration(a, b, result));
+    EXPECT_NEAR(-0.5f, result.distance, 1e-4f);
+    expectVecNear(Vec3f(1.0f, 0.0f, 0.0f), result.normal, 1e-4f);
+    EXPECT_NEAR(0.5f, result.pointA.x - result.pointB.x, 1e-4f);
+
+    // Touching faces
+    b.box = OrientedBoundingBox(BoundingBox(Vec3f(1.0f, -1.0f, -1.0f), Vec3f(3.0f, 1.0f, 1.0f)));
+    EXPECT_TRUE(GJK::intersect(a, b));
+    ASSERT_TRUE(GJK::penetration(a, b, result));
+    EXPECT_NEAR(0.0f, result.distance, 1e-4f);
+}
+
+TEST_F(GJKTest, capsules)
+{
+    // Crossed capsules, one above the other
+    CapsuleShape a(Segment(Vec3f(-2.0f, 0.0f, 0.0f), Vec3f(2.0f, 0.0f, 0.0f)), 0.5f);
+    CapsuleShape b(Segment(Vec3f(0.5f, -2.0f, 1.5f), Vec3f(0.5f, 2.0f, 1.5f)), 0.5f);
+    GJK::Result result;
+
+    ASSERT_TRUE(GJK::distance(a, b, result));
+    EXPECT_NEAR(0.5f, result.distance, 1e-5f);
+    expectVecNear(Vec3f(0.5f, 0.0f, 0.5f), result.pointA, 1e-5f);
+    expectVecNear(Vec3f(0.5f, 0.0f, 1.0f), result.pointB, 1e-5f);
+
+    b.segment = Segment(Vec3f(0.5f, -2.0f, 0.8f), Vec3f(0.5f, 2.0f, 0.8f));
+    ASSERT_TRUE(GJK::penetration(a, b, result));
+    EXPECT_NEAR(-0.2f, result.distance, 1e-5f);
+    expectVecNear(Vec3f(0.0f, 0.0f, 1.0f), result.normal, 1e-5f);
+
+    // Intersecting axes: the normal is across their plane
+    b.segment = Segment(Vec3f(0.5f, -2.0f, 0.0f), Vec3f(0.5f, 2.0f, 0.0f));
+    ASSERT_TRUE(GJK::penetration(a, b, result));
+    EXPECT_NEAR(-1.0f, result.distance, 1e-5f);
+    EXPECT_NEAR(1.0f, std::fabs(result.normal.z), 1e-5f);
+    EXPECT_NEAR(1.0f, (result.pointA - result.pointB).length(), 1e-5f);
+
+    // Capsule against a box it sinks into: EPA on the segment and the box
+    BoxShape box(OrientedBoundingBox(BoundingBox(Vec3f(-1.0f, -1.0f, -3.0f), Vec3f(1.0f, 1.0f, 0.2f))));
+    ASSERT_TRUE(GJK::penetration(a, box, result));
+    EXPECT_NEAR(-0.7f, result.distance, 1e-4f);
+    expectVecNear(Vec3f(0.0f, 0.0f, -1.0f), result.normal, 1e-4f);
+
+    // Capsule against a sphere next to its end cap
+    SphereShape s(Sphere(Vec3f(3.0f, 0.0f, 0.0f), 0.25f));
+    ASSERT_TRUE(GJK::distance(a, s, result));
+    EXPECT_NEAR(0.25f, result.distance, 1e-5f);
+}
+
+TEST_F(GJKTest, hulls)
+{
+    // A hull of the corners of a box, plus interior points, placed like the box
+    OrientedBoundingBox box(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 0.5f, 2.0f), randomRotation());
+    Vec3f corners[8];
+    OrientedBoundingBox(Vec3f(0.0f, 0.0f, 0.0f), box.halfExtents, Matrix3x3<float>()).getCorners(corners);
+
+    std::vector<Vec3f> points(corners, corners + 8);
+    points.push_back(Vec3f(0.1f, 0.2f, -0.3f));
+    points.push_back(Vec3f(0.0f, 0.0f, 0.0f));
+
+    ConvexHullShape hull(&points[0].x, points.size());
+    hull.rotation = box.basis;
+    BoxShape boxShape(box);
+
+    for (int i = 0; i < 50; ++i)
+    {
+        BoxShape other(randomBox(4.0f));
+        GJK::Result fromHull, fromBox;
+        bool separatedHull = GJK::distance(hull, other, fromHull);
+        bool separatedBox = GJK::distance(boxShape, other, fromBox);
+
+        ASSERT_EQ(separatedBox, separatedHull);
+        EXPECT_NEAR(fromBox.distance, fromHull.distance, 1e-4f);
+        EXPECT_EQ(GJK::penetration(boxShape, other, fromBox), GJK::penetration(hull, other, fromHull));
+        EXPECT_NEAR(fromBox.distance, fromHull.distance, 1e-3f);
+    }
+}
+
+TEST_F(GJKTest, matchesSeparatingAxes)
+{
+    int overlaps = 0;
+
+    for (int i = 0; i < 400; ++i)
+    {
+        OrientedBoundingBox boxA = randomBox(2.0f), boxB = randomBox(2.0f);
+        BoxShape a(boxA), b(boxB);
+        GJK::Result result;
+        bool overlapping = GJK::penetration(a, b, result);
+
+        // Skip grazing pairs, where either answer is right
+        if (std::fabs(result.distance) < 1e-3f)
+        {
+            continue;
+        }
+
+        ASSERT_EQ(boxA.overlaps(boxB), overlapping) << "pair " << i;
+        EXPECT_EQ(overlapping, GJK::intersect(a, b));
+        EXPECT_NEAR(1.0f, result.normal.length(), 1e-4f);
+
+        if (overlapping)
+        {
+            // The depth is the shortest way out
+            float depth = -result.distance;
+            EXPECT_FALSE(boxA.overlaps(moved(boxB, result.normal * (depth * 1.01f + 1e-3f)))) << "pair " << i;
+            EXPECT_TRUE(boxA.overlaps(moved(boxB, result.normal * (depth * 0.95f)))) << "pair " << i;
+            ++overlaps;
+        }
+        else
+        {
+            Vec3f gap = result.pointB - result.pointA;
+            EXPECT_NEAR(result.distance, gap.length(), 1e-4f);
+            EXPECT_TRUE(boxA.overlaps(moved(boxB, -result.normal * (result.distance * 1.01f + 1e-3f)))) << "pair " << i;
+        }
+    }
+
+    EXPECT_GT(overlaps, 50);
+}
+
+TEST_F(GJKTest, mixedShapes)
+{
+    // Moving the second shape along the normal by the depth separates them
+    for (int i = 0; i < 300; ++i)
+    {
+        Vec3f c(uniform(-1.5f, 1.5f), uniform(-1.5f, 1.5f), uniform(-1.5f, 1.5f));
+        Vec3f d(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f));
+        BoxShape box(randomBox(0.5f));
+        CapsuleShape capsule(Segment(c - d, c + d), uniform(0.1f, 0.8f));
+        SphereShape sphere(Sphere(c, uniform(0.1f, 1.0f)));
+        const ConvexShape* others[2] = { &capsule, &sphere };
+
+        for (int j = 0; j < 2; ++j)
+        {
+            GJK::Result result, after;
+
+            if (!GJK::penetration(box, *others[j], result) || result.distance > -1e-3f)
+            {
+                continue;
+            }
+
+            Vec3f push = result.normal * (-result.distance);
+            capsule.segment = Segment(c - d + push * 1.01f, c + d + push * 1.01f);
+            sphere.sphere.center = c + push * 1.01f;
+            EXPECT_TRUE(GJK::distance(box, *others[j], after)) << "pair " << i << ", shape " << j;
+
+            capsule.segment = Segment(c - d + push * 0.95f, c + d + push * 0.95f);
+            sphere.sphere.center = c + push * 0.95f;
+            EXPECT_TRUE(GJK::intersect(box, *others[j])) << "pair " << i << ", shape " << j;
+
+            capsule.segment = Segment(c - d, c + d);
+            sphere.sphere.center = c;
+        }
+    }
+}
+
+TEST_F(GJKTest, warmStart)
+{
+    // A box orbiting slowly around another one, in and out of contact
+    BoxShape a(OrientedBoundingBox(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 0.7f, 0.5f), randomRotation()));
+    BoxShape b(OrientedBoundingBox(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(0.6f, 0.4f, 0.9f), randomRotation()));
+    GJK::Cache cache;
+    int coldIterations = 0, warmIterations = 0, frames = 0, fastFrames = 0;
+
+    for (float angle = 0.0f; angle < 6.28f; angle += 0.01f, ++frames)
+    {
+        float radius = 2.2f + 0.6f * std::sin(angle * 3.0f);
+        b.box.center = Vec3f(radius * std::cos(angle), radius * std::sin(angle), 0.3f);
+
+        GJK::Result cold, warm;
+        bool coldSeparated = GJK::distance(a, b, cold);
+        bool warmSeparated = GJK::distance(a, b, warm, &cache);
+
+        ASSERT_EQ(coldSeparated, warmSeparated);
+        EXPECT_NEAR(cold.distance, warm.distance, 1e-4f);
+
+        coldIterations += cold.iterations;
+        warmIterations += warm.iterations;
+        fastFrames += warm.iterations <= 2 ? 1 : 0;
+    }
+
+    EXPECT_LT(warmIterations * 2, coldIterations);
+    EXPECT_GT(fastFrames * 10, frames * 9);
+}
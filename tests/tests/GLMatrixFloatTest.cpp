@@ -999,3 +999,49 @@ TEST_F(GLMatrixFloatTest, setOrtho)
     EXPECT_NEAR(0, m[11], 1e-10);
     EXPECT_NEAR(1, m[15], 1e-10);
 }
+
+
+
+TEST_F(GLMatrixFloatTest, projectUnproject)
+{
+    GLMatrix<FLOAT> view, projection;
+    Vector4D<FLOAT> viewport(10, 20, 640, 480);
+
+    view.setLookAt(0, 0, 10, 0, 0, -2, 0, 1, 0);
+    projection.setPerspective(60, viewport.z / viewport.w, 1, 100);
+
+    GLMatrix<FLOAT> mvp = projection * view;
+    GLMatrix<FLOAT> inverse = mvp.inverse();
+
+    // The looked at point is at the center of the viewport
+    Vector3D<FLOAT> w = mvp.project(Vector3D<FLOAT>(0, 0, -2), viewport);
+    EXPECT_NEAR(10 + 320, w.x, 1e-3);
+    EXPECT_NEAR(20 + 240, w.y, 1e-3);
+    EXPECT_GT(w.z, 0);
+    EXPECT_LT(w.z, 1);
+
+    // Depth 0 on the near plane, 1 on the far plane
+    Vector3D<FLOAT> eye(0, 0, 10);
+    Vector3D<FLOAT> forward(0, 0, -1);
+    EXPECT_NEAR(0, mvp.project(eye + forward * FLOAT(1), viewport).z, 1e-4);
+    EXPECT_NEAR(1, mvp.project(eye + forward * FLOAT(100), viewport).z, 1e-4);
+
+    // Round trip
+    const FLOAT points[4][3] = { {1, 0, -2}, {-3, 2, 0}, {5, 5, -20}, {0, -1, 7} };
+
+    for (int i = 0; i < 4; ++i)
+    {
+        Vector3D<FLOAT> p(points[i][0], points[i][1], points[i][2]);
+        Vector3D<FLOAT> q = mvp.unproject(mvp.project(p, viewport), viewport);
+
+        EXPECT_NEAR(p.x, q.x, 1e-3);
+        EXPECT_NEAR(p.y, q.y, 1e-3);
+        EXPECT_NEAR(p.z, q.z, 1e-3);
+
+        q = inverse.unprojectWithInverse(mvp.project(p, viewport), viewport);
+
+        EXPECT_NEAR(p.x, q.x, 1e-3);
+        EXPECT_NEAR(p.y, q.y, 1e-3);
+        EXPECT_NEAR(p.z, q.z, 1e-3);
+    }
+}
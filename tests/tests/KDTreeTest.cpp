@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "KDTree.h"
+#include "Mesh.h"
+
+using namespace nut;
+
+class KDTreeTest : public RandomTest
+{
+    protected:
+
+    // Points on a noisy sphere plus uniform clutter, like a scanned object
+    void makeCloud(std::vector<Vec3f>& points, size_t count, float size)
+    {
+        points.resize(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Vec3f p(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f));
+
+            if (i % 4 != 0 && p.length() > 0.01f)
+            {
+                p = p * (size * uniform(0.99f, 1.01f) / p.length());
+            }
+            else
+            {
+                p = p * size;
+            }
+
+            points[i] = p;
+        }
+    }
+
+    // Squared distances to every point, sorted
+    static std::vector<float> bruteForce(const std::vector<Vec3f>& points, const Vec3f& q)
+    {
+        std::vector<float> distances(points.size());
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            Vec3f d = points[i] - q;
+            distances[i] = d * d;
+        }
+
+        std::sort(distances.begin(), distances.end());
+        return distances;
+    }
+};
+
+TEST_F(KDTreeTest, degenerateInput)
+{
+    KDTree tree;
+    U32 index;
+    float distance;
+
+    EXPECT_FALSE(tree.build(nullptr, 0, 3));
+    EXPECT_TRUE(tree.isEmpty());
+    EXPECT_EQ(0u, tree.nearest(Vec3f(0.0f, 0.0f, 0.0f), 1, &index, &distance));
+
+    Mesh empty;
+    EXPECT_FALSE(tree.build(empty));
+
+    // One point
+    float single[3] = { 1.0f, 2.0f, 3.0f };
+    ASSERT_TRUE(tree.build(single, 1, 3));
+    ASSERT_EQ(1u, tree.nearest(Vec3f(0.0f, 0.0f, 0.0f), 1, &index, &distance));
+    EXPECT_EQ(0u, index);
+    EXPECT_FLOAT_EQ(14.0f, distance);
+
+    // Many copies of the same point
+    std::vector<float> same(3 * 1000, 5.0f);
+    ASSERT_TRUE(tree.build(&same[0], 1000, 3));
+
+    U32 indices[10];
+    float distances[10];
+    ASSERT_EQ(10u, tree.nearest(Vec3f(5.0f, 5.0f, 6.0f), 10, indices, distances));
+
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_FLOAT_EQ(1.0f, distances[i]);
+    }
+
+    std::vector<U32> found;
+    EXPECT_EQ(1000u, tree.query(Sphere(Vec3f(5.0f, 5.0f, 5.0f), 0.0f), found));
+}
+
+TEST_F(KDTreeTest, nearestMatchesBruteForce)
+{
+    std::vector<Vec3f> points;
+    makeCloud(points, 20000, 10.0f);
+
+    KDTree tree;
+    ASSERT_TRUE(tree.build(&points[0].x, points.size(), 3));
+    ASSERT_EQ(points.size(), tree.getNumberOfPoints());
+
+    const size_t ks[] = { 1, 7, 32 };
+
+    for (int n = 0; n < 200; ++n)
+    {
+        Vec3f q(uniform(-12.0f, 12.0f), uniform(-12.0f, 12.0f), uniform(-12.0f, 12.0f));
+        std::vector<float> expected = bruteForce(points, q);
+
+        for (size_t k : ks)
+        {
+            std::vector<U32> indices(k);
+            std::vector<float> distances(k);
+            ASSERT_EQ(k, tree.nearest(q, k, &indices[0], &distances[0]));
+
+            for (size_t i = 0; i < k; ++i)
+            {
+                Vec3f d = points[indices[i]] - q;
+                ASSERT_FLOAT_EQ(expected[i], distances[i]);
+                ASSERT_FLOAT_EQ(d * d, distances[i]);
+            }
+
+            // Limited range, between two neighbors
+            float range = std::sqrt(0.5f * (expected[k / 2] + expected[k / 2 + 1]));
+            size_t found = tree.nearest(q, k, &indices[0], &distances[0], 0.0f, range);
+            ASSERT_EQ(size_t(std::upper_bound(expected.begin(), expected.begin() + k, range * range) - expected.begin()), found);
+        }
+    }
+}
+
+TEST_F(KDTreeTest, approximateNearest)
+{
+    std::vector<Vec3f> points;
+    makeCloud(points, 20000, 10.0f);
+
+    KDTree tree;
+    ASSERT_TRUE(tree.build(&points[0].x, points.size(), 3));
+
+    const float epsilon = 0.5f;
+    U32 indices[8];
+    float distances[8];
+
+    for (int n = 0; n < 200; ++n)
+    {
+        Vec3f q(uniform(-12.0f, 12.0f), uniform(-12.0f, 12.0f), uniform(-12.0f, 12.0f));
+        std::vector<float> expected = bruteForce(points, q);
+
+        ASSERT_EQ(8u, tree.nearest(q, 8, indices, distances, epsilon));
+
+        for (int i = 0; i < 8; ++i)
+        {
+            ASSERT_LE(distances[i], expected[i] * (1.0f + epsilon) * (1.0f + epsilon) * 1.0001f);
+            ASSERT_GE(distances[i], expected[i] * 0.9999f);
+        }
+    }
+}
+
+TEST_F(KDTreeTest, batchMatchesSingle)
+{
+    std::vector<Vec3f> points, queries;
+    makeCloud(points, 5000, 10.0f);
+    makeCloud(queries, 3000, 11.0f);
+
+    KDTree tree;
+    ASSERT_TRUE(tree.build(&points[0].x, points.size(), 3));
+
+    // More neighbors than a tiny tree has: the rest of the slots are empty
+    const size_t k = 4;
+    std::vector<U32> indices(queries.size() * k);
+    std::vector<float> distances(queries.size() * k);
+    tree.nearest(&queries[0], queries.size(), k, &indices[0], &distances[0]);
+
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        U32 single[k];
+        float singleDistances[k];
+        ASSERT_EQ(k, tree.nearest(queries[i], k, single, singleDistances));
+
+        for (size_t j = 0; j < k; ++j)
+        {
+            ASSERT_EQ(singleDistances[j], distances[i * k + j]);
+        }
+    }
+
+    float three[9] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 2.0f, 0.0f, 0.0f };
+    ASSERT_TRUE(tree.build(three, 3, 3));
+    tree.nearest(&queries[0], 2, k, &indices[0], &distances[0]);
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        EXPECT_NE(KDTree::NO_POINT, indices[i * k + 2]);
+        EXPECT_EQ(KDTree::NO_POINT, indices[i * k + 3]);
+        EXPECT_EQ(FLT_MAX, distances[i * k + 3]);
+    }
+}
+
+TEST_F(KDTreeTest, radiusMatchesBruteForce)
+{
+    Mesh mesh;
+    std::vector<Vec3f> points;
+    makeCloud(points, 20000, 10.0f);
+    mesh.getVertices().resize(points.size());
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        mesh.getVertices()[i].pos = points[i];
+    }
+
+    KDTree tree;
+    ASSERT_TRUE(tree.build(mesh));
+
+    for (int n = 0; n < 100; ++n)
+    {
+        Sphere sphere(Vec3f(uniform(-12.0f, 12.0f), uniform(-12.0f, 12.0f), uniform(-12.0f, 12.0f)), uniform(0.0f, 4.0f));
+        std::vector<U32> expected, found(1, 12345);
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            Vec3f d = points[i] - sphere.center;
+
+            if (d * d <= sphere.radius * sphere.radius)
+            {
+                expected.push_back(U32(i));
+            }
+        }
+
+        // Appended after what the vector already holds
+        ASSERT_EQ(expected.size(), tree.query(sphere, found));
+        ASSERT_EQ(12345u, found[0]);
+        found.erase(found.begin());
+        std::sort(found.begin(), found.end());
+        ASSERT_EQ(expected, found);
+    }
+}
@@ -0,0 +1,86 @@
+#include <cmath>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "Line.h"
+
+using namespace nut;
+
+class LineTest : public RandomTest
+{
+    protected:
+
+    static float squaredDistance(const Vec3f& a, const Vec3f& b)
+    {
+        return (a - b) * (a - b);
+    }
+};
+
+TEST_F(LineTest, point)
+{
+    Line line(Vec3f(1.0f, 0.0f, 0.0f), Vec3f(2.0f, 0.0f, 0.0f));
+    float t;
+
+    // Beyond the defining points, unlike a segment
+    EXPECT_FLOAT_EQ(4.0f, line.closestPoint(Vec3f(-3.0f, 2.0f, 0.0f), t));
+    EXPECT_FLOAT_EQ(-2.0f, t);
+    EXPECT_FLOAT_EQ(-3.0f, line.getPoint(t).x);
+
+    Line segmentLine(Segment(Vec3f(1.0f, 2.0f, 3.0f), Vec3f(2.0f, 2.0f, 3.0f)));
+    EXPECT_FLOAT_EQ(2.0f, segmentLine.getPoint(1.0f).x);
+}
+
+TEST_F(LineTest, lines)
+{
+    Line x(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 0.0f, 0.0f));
+    float t, u;
+
+    EXPECT_FLOAT_EQ(9.0f, x.closestPoints(Line(Vec3f(5.0f, 1.0f, 3.0f), Vec3f(0.0f, 2.0f, 0.0f)), t, u));
+    EXPECT_FLOAT_EQ(5.0f, t);
+    EXPECT_FLOAT_EQ(-0.5f, u);
+
+    // Parallel
+    EXPECT_FLOAT_EQ(1.0f, x.closestPoints(Line(Vec3f(3.0f, 1.0f, 0.0f), Vec3f(-2.0f, 0.0f, 0.0f)), t, u));
+
+    // Random: stationary in both parameters
+    for (int n = 0; n < 200; ++n)
+    {
+        Line a(randomPoint(2.0f), randomPoint(1.0f));
+        Line b(randomPoint(2.0f), randomPoint(1.0f));
+        float distance = a.closestPoints(b, t, u);
+
+        ASSERT_NEAR(distance, squaredDistance(a.getPoint(t), b.getPoint(u)), 1e-3f);
+
+        Vec3f r = a.getPoint(t) - b.getPoint(u);
+        ASSERT_NEAR(0.0f, r * a.direction, 1e-3f);
+        ASSERT_NEAR(0.0f, r * b.direction, 1e-3f);
+    }
+}
+
+TEST_F(LineTest, segments)
+{
+    Line x(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 0.0f, 0.0f));
+    float t, u;
+
+    // The segment's closest point is clamped, the line's is not
+    EXPECT_FLOAT_EQ(5.0f, x.closestPoints(Segment(Vec3f(7.0f, 1.0f, 2.0f), Vec3f(7.0f, 3.0f, 2.0f)), t, u));
+    EXPECT_FLOAT_EQ(7.0f, t);
+    EXPECT_EQ(0.0f, u);
+
+    for (int n = 0; n < 200; ++n)
+    {
+        Line line(randomPoint(2.0f), randomPoint(1.0f));
+        Segment s(randomPoint(2.0f), randomPoint(2.0f));
+        float distance = line.closestPoints(s, t, u);
+
+        ASSERT_GE(u, 0.0f);
+        ASSERT_LE(u, 1.0f);
+        ASSERT_NEAR(distance, squaredDistance(line.getPoint(t), s.getPoint(u)), 1e-3f);
+
+        // No point of the segment is closer to the line
+        for (int i = 0; i <= 20; ++i)
+        {
+            float tp;
+            ASSERT_LE(distance, line.closestPoint(s.getPoint(i / 20.0f), tp) + 1e-4f);
+        }
+    }
+}
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "LooseOctree.h"
+
+using namespace nut;
+
+class LooseOctreeTest : public RandomTest
+{
+    protected:
+
+    Frustum frustum;
+
+    // Camera at (0, 0, 60) looking down -z: 60 degrees fov, near 1, far 100
+    virtual void SetUp()
+    {
+        GLMatrix<float> projection, view;
+        projection.setPerspective(60.0f, 1.0f, 1.0f, 100.0f);
+        view.setLookAt(0.0f, 0.0f, 60.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+        frustum.set(projection * view);
+    }
+
+    BoundingBox randomBox(float size, float maxExtent)
+    {
+        Vec3f c(uniform(-size, size), uniform(-size, size), uniform(-size, size));
+        Vec3f e(uniform(0.01f, maxExtent), uniform(0.01f, maxExtent), uniform(0.01f, maxExtent));
+        return BoundingBox(c - e, c + e);
+    }
+
+    // Mostly small boxes, a few large ones, some outside the root cell and a
+    // few empty ones
+    std::vector<BoundingBox> randomScene(size_t count)
+    {
+        std::vector<BoundingBox> boxes(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i % 101 == 0)
+            {
+                boxes[i] = BoundingBox();
+            }
+            else if (i % 37 == 0)
+            {
+                boxes[i] = randomBox(80.0f, 30.0f);
+            }
+            else
+            {
+                boxes[i] = randomBox(i % 11 == 0 ? 70.0f : 50.0f, 1.0f);
+            }
+        }
+
+        return boxes;
+    }
+
+    static std::vector<U32> sorted(std::vector<U32> v)
+    {
+        std::sort(v.begin(), v.end());
+        return v;
+    }
+
+    // Checks every query type against brute force over the objects' boxes
+    void checkQueries(const LooseOctree& tree, const std::vector<U32>& ids, const std::vector<BoundingBox>& boxes)
+    {
+        std::vector<U32> found, expected;
+
+        tree.query(frustum, found);
+
+        for (size_t i = 0; i < boxes.size(); ++i)
+        {
+            if (frustum.intersects(boxes[i]))
+            {
+                expected.push_back(ids[i]);
+            }
+        }
+
+        ASSERT_EQ(sorted(expected), sorted(found)) << "frustum";
+
+        for (int q = 0; q < 20; ++q)
+        {
+            Sphere sphere(Vec3f(uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f)), uniform(0.0f, 40.0f));
+            BoundingBox box = randomBox(60.0f, 30.0f);
+            Vec3f origin(uniform(-90.0f, 90.0f), uniform(-90.0f, 90.0f), uniform(-90.0f, 90.0f));
+            Ray ray(origin, Vec3f(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f)), 0.0f, uniform(10.0f, 200.0f));
+
+            std::vector<U32> inSphere, inBox, onRay;
+            std::vector<U32> expectedSphere, expectedBox, expectedRay;
+            size_t n = tree.query(sphere, inSphere);
+            EXPECT_EQ(n, inSphere.size());
+            n = tree.query(box, inBox);
+            EXPECT_EQ(n, inBox.size());
+            n = tree.query(ray, onRay);
+            EXPECT_EQ(n, onRay.size());
+
+            for (size_t i = 0; i < boxes.size(); ++i)
+            {
+                if (sphere.overlaps(boxes[i]))
+                {
+                    expectedSphere.push_back(ids[i]);
+                }
+
+                if (box.overlaps(boxes[i]))
+                {
+                    expectedBox.push_back(ids[i]);
+                }
+
+                if (boxes[i].intersect(ray.origin, ray.invDirection, ray.tMin, ray.tMax))
+                {
+                    expectedRay.push_back(ids[i]);
+                }
+            }
+
+            ASSERT_EQ(sorted(expectedSphere), sorted(inSphere)) << "sphere " << q;
+            ASSERT_EQ(sorted(expectedBox), sorted(inBox)) << "box " << q;
+            ASSERT_EQ(sorted(expectedRay), sorted(onRay)) << "ray " << q;
+        }
+    }
+};
+
+TEST_F(LooseOctreeTest, insertRemove)
+{
+    LooseOctree tree(Vec3f(0.0f, 0.0f, 0.0f), 64.0f, 6);
+    std::vector<U32> found;
+
+    EXPECT_EQ(0u, tree.getNumberOfObjects());
+    EXPECT_EQ(1u, tree.getNumberOfNodes());
+    EXPECT_EQ(0u, tree.query(frustum, found));
+    EXPECT_EQ(LooseOctree::NULL_INDEX, tree.raycast(Ray(), [](U32, const Ray& ray) { return ray.tMax; }));
+
+    // A crowded leaf splits, down to the cells that are still large enough
+    // for its objects: a box of half size 0.5 fits cells of half size 1
+    // (depth 6) with a looseness of 2
+    std::vector<U32> cluster;
+
+    for (U32 i = 0; i < 17; ++i)
+    {
+        cluster.push_back(tree.insert(BoundingBox(Vec3f(10.0f, 10.0f, 10.0f), Vec3f(11.0f, 11.0f, 11.0f)), i));
+    }
+
+    U32 large = tree.insert(BoundingBox(Vec3f(-50.0f, -50.0f, -50.0f), Vec3f(50.0f, 50.0f, 50.0f)), 100);
+    U32 outside = tree.insert(BoundingBox(Vec3f(200.0f, 0.0f, 0.0f), Vec3f(201.0f, 1.0f, 1.0f)), 101);
+    U32 empty = tree.insert(BoundingBox(), 102);
+
+    EXPECT_EQ(20u, tree.getNumberOfObjects());
+    EXPECT_EQ(1u + 6u * 8u, tree.getNumberOfNodes());
+    EXPECT_EQ(6, tree.getDepth(cluster[0]));
+    EXPECT_EQ(0, tree.getDepth(large));
+    EXPECT_EQ(0, tree.getDepth(outside));
+    EXPECT_EQ(0, tree.getDepth(empty));
+    EXPECT_EQ(100u, tree.getUserData(large));
+    EXPECT_FLOAT_EQ(11.0f, tree.getBounds(cluster[3]).max.y);
+
+    // Moving inside the node changes the box in place; farther away the object
+    // goes to the deepest existing node it fits
+    EXPECT_FALSE(tree.update(cluster[0], BoundingBox(Vec3f(10.1f, 10.0f, 10.0f), Vec3f(11.1f, 11.0f, 11.0f))));
+    EXPECT_FLOAT_EQ(11.1f, tree.getBounds(cluster[0]).max.x);
+    EXPECT_TRUE(tree.update(cluster[0], BoundingBox(Vec3f(-11.0f, 10.0f, 10.0f), Vec3f(-10.0f, 11.0f, 11.0f))));
+    EXPECT_EQ(1, tree.getDepth(cluster[0]));
+
+    // A subtree left with few objects merges into its root
+    for (size_t i = 1; i <= 8; ++i)
+    {
+        tree.remove(cluster[i]);
+    }
+
+    EXPECT_EQ(1u + 8u, tree.getNumberOfNodes());
+    EXPECT_EQ(1, tree.getDepth(cluster[9]));
+    EXPECT_FLOAT_EQ(11.0f, tree.getBounds(cluster[9]).max.z);
+
+    for (size_t i = 9; i < cluster.size(); ++i)
+    {
+        tree.remove(cluster[i]);
+    }
+
+    EXPECT_EQ(1u, tree.getNumberOfNodes());
+    EXPECT_EQ(0, tree.getDepth(cluster[0]));
+
+    // Ids of removed objects are reused
+    EXPECT_EQ(cluster.back(), tree.insert(BoundingBox(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 1.0f, 1.0f)), 103));
+    EXPECT_EQ(103u, tree.getUserData(cluster.back()));
+
+    tree.query(BoundingBox(Vec3f(150.0f, -10.0f, -10.0f), Vec3f(250.0f, 10.0f, 10.0f)), found);
+    ASSERT_EQ(1u, found.size());
+    EXPECT_EQ(outside, found[0]);
+
+    tree.clear();
+    EXPECT_EQ(0u, tree.getNumberOfObjects());
+    EXPECT_EQ(1u, tree.getNumberOfNodes());
+}
+
+TEST_F(LooseOctreeTest, matchesBruteForce)
+{
+    // Below and above the number of objects of a parallel query
+    const size_t counts[2] = { 500, 12000 };
+
+    for (int c = 0; c < 2; ++c)
+    {
+        LooseOctree tree(Vec3f(0.0f, 0.0f, 0.0f), 64.0f);
+        std::vector<BoundingBox> boxes = randomScene(counts[c]);
+        std::vector<U32> ids(boxes.size());
+
+        for (size_t i = 0; i < boxes.size(); ++i)
+        {
+            ids[i] = tree.insert(boxes[i], U32(i));
+        }
+
+        checkQueries(tree, ids, boxes);
+    }
+}
+
+TEST_F(LooseOctreeTest, incrementalUpdates)
+{
+    LooseOctree tree(Vec3f(0.0f, 0.0f, 0.0f), 64.0f);
+    std::vector<BoundingBox> boxes = randomScene(6000);
+    std::vector<U32> ids(boxes.size());
+
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        ids[i] = tree.insert(boxes[i], U32(i));
+    }
+
+    size_t updates = 0, relocations = 0;
+
+    for (int step = 0; step < 30; ++step)
+    {
+        // Drift a third of the objects, and replace a few
+        for (size_t i = step % 3; i < boxes.size(); i += 3)
+        {
+            if (boxes[i].isEmpty())
+            {
+                continue;
+            }
+
+            Vec3f d(uniform(-0.3f, 0.3f), uniform(-0.3f, 0.3f), uniform(-0.3f, 0.3f));
+            boxes[i] = BoundingBox(boxes[i].min + d, boxes[i].max + d);
+            relocations += tree.update(ids[i], boxes[i]) ? 1 : 0;
+            ++updates;
+        }
+
+        for (size_t i = step; i < boxes.size(); i += 500)
+        {
+            tree.remove(ids[i]);
+            boxes[i] = randomBox(50.0f, 1.0f);
+            ids[i] = tree.insert(boxes[i], U32(i));
+        }
+
+        ASSERT_EQ(boxes.size(), tree.getNumberOfObjects());
+    }
+
+    // Slow motion rarely leaves a node
+    EXPECT_LT(relocations * 5, updates);
+
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        ASSERT_EQ(U32(i), tree.getUserData(ids[i]));
+    }
+
+    checkQueries(tree, ids, boxes);
+}
+
+TEST_F(LooseOctreeTest, raycast)
+{
+    LooseOctree tree(Vec3f(0.0f, 0.0f, 0.0f), 64.0f);
+    std::vector<BoundingBox> boxes = randomScene(8000);
+    std::vector<U32> ids(boxes.size());
+
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        ids[i] = tree.insert(boxes[i], U32(i));
+    }
+
+    // The objects are their boxes
+    LooseOctree::RayCallback callback = [&](U32 object, const Ray& ray)
+    {
+        float t;
+        return tree.getBounds(object).intersect(ray.origin, ray.invDirection, ray.tMin, ray.tMax, &t) ? t : ray.tMax;
+    };
+
+    for (int q = 0; q < 200; ++q)
+    {
+        Vec3f origin(uniform(-90.0f, 90.0f), uniform(-90.0f, 90.0f), uniform(-90.0f, 90.0f));
+        Ray ray(origin, Vec3f(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f)), 0.0f, 300.0f);
+
+        float expected = ray.tMax;
+
+        for (size_t i = 0; i < boxes.size(); ++i)
+        {
+            float t;
+
+            if (boxes[i].intersect(ray.origin, ray.invDirection, ray.tMin, ray.tMax, &t))
+            {
+                expected = std::min(expected, t);
+            }
+        }
+
+        float t;
+        U32 hit = tree.raycast(ray, callback, &t);
+
+        ASSERT_FLOAT_EQ(expected, t) << "ray " << q;
+        EXPECT_EQ(expected < ray.tMax, hit != LooseOctree::NULL_INDEX);
+    }
+}
@@ -214,6 +214,51 @@ TEST_F(Matrix3x3DoubleTest, transpose)
 
 
 
+TEST_F(Matrix3x3DoubleTest, symmetricEigen)
+{
+    Matrix3x3<FLOAT> m(4, 1, 2,
+                       1, 3, 0,
+                       2, 0, 5);
+
+    Vector3D<FLOAT> values;
+    Matrix3x3<FLOAT> vectors;
+    m.symmetricEigen(values, vectors);
+
+    // Decreasing order, trace and determinant preserved
+    EXPECT_GE(values.x, values.y);
+    EXPECT_GE(values.y, values.z);
+    EXPECT_NEAR(12.0, values.x + values.y + values.z, 1e-10);
+    EXPECT_NEAR(m.determinant(), values.x * values.y * values.z, 1e-10 * 10);
+
+    // A v = lambda v for each column, with a right-handed orthonormal basis
+    const FLOAT lambda[3] = { values.x, values.y, values.z };
+
+    for (int i = 0; i < 3; ++i)
+    {
+        Vector3D<FLOAT> v(vectors[3 * i], vectors[3 * i + 1], vectors[3 * i + 2]);
+        Vector3D<FLOAT> av = m * v;
+
+        EXPECT_NEAR(1.0, v.length(), 1e-10);
+        EXPECT_NEAR(lambda[i] * v.x, av.x, 1e-10 * 10);
+        EXPECT_NEAR(lambda[i] * v.y, av.y, 1e-10 * 10);
+        EXPECT_NEAR(lambda[i] * v.z, av.z, 1e-10 * 10);
+    }
+
+    EXPECT_NEAR(1.0, vectors.determinant(), 1e-10);
+
+    // Diagonal matrices are already decomposed
+    Matrix3x3<FLOAT> d(1, 0, 0,
+                       0, 7, 0,
+                       0, 0, 3);
+    d.symmetricEigen(values, vectors);
+    EXPECT_FLOAT_EQ(7, values.x);
+    EXPECT_FLOAT_EQ(3, values.y);
+    EXPECT_FLOAT_EQ(1, values.z);
+    EXPECT_FLOAT_EQ(1, std::fabs(vectors[1]));
+}
+
+
+
 TEST_F(Matrix3x3DoubleTest, constants)
 {
     // Identity matrix
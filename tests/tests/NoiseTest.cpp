@@ -0,0 +1,173 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "Noise.h"
+#include "Xoshiro256.h"
+
+using namespace nut;
+
+class NoiseTest : public ::testing::Test
+{
+    protected:
+
+    Noise noise;
+
+    // Deterministic sample positions covering negative and positive coordinates
+    static float coord(int i, float scale)
+    {
+        return (float((i * 7919) % 2000) - 1000.0f) * scale;
+    }
+};
+
+TEST_F(NoiseTest, zeroAtLatticePoints)
+{
+    for (int i = -5; i <= 5; ++i)
+    {
+        for (int j = -5; j <= 5; ++j)
+        {
+            EXPECT_FLOAT_EQ(0.0f, noise.perlin(float(i), float(j)));
+            EXPECT_FLOAT_EQ(0.0f, noise.perlin(float(i), float(j), float(i + j)));
+            EXPECT_FLOAT_EQ(0.0f, noise.perlin(float(i), float(j), float(i - j), float(j)));
+        }
+    }
+}
+
+TEST_F(NoiseTest, range)
+{
+    float minValue = 0.0f, maxValue = 0.0f;
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        float x = coord(i, 0.013f), y = coord(i + 1, 0.017f), z = coord(i + 2, 0.011f), w = coord(i + 3, 0.019f);
+        float values[6] = {
+            noise.perlin(x, y), noise.perlin(x, y, z), noise.perlin(x, y, z, w),
+            noise.simplex(x, y), noise.simplex(x, y, z), noise.simplex(x, y, z, w)
+        };
+
+        for (int k = 0; k < 6; ++k)
+        {
+            ASSERT_LE(std::fabs(values[k]), 1.1f) << "function " << k;
+            minValue = values[k] < minValue ? values[k] : minValue;
+            maxValue = values[k] > maxValue ? values[k] : maxValue;
+        }
+    }
+
+    // Not degenerate
+    EXPECT_LT(minValue, -0.5f);
+    EXPECT_GT(maxValue, 0.5f);
+}
+
+TEST_F(NoiseTest, continuity)
+{
+    const float h = 1e-3f;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        float x = coord(i, 0.01f), y = coord(i + 5, 0.01f), z = coord(i + 9, 0.01f);
+
+        EXPECT_NEAR(noise.perlin(x, y), noise.perlin(x + h, y), 0.02f);
+        EXPECT_NEAR(noise.simplex(x, y), noise.simplex(x + h, y), 0.02f);
+        EXPECT_NEAR(noise.perlin(x, y, z), noise.perlin(x, y + h, z), 0.02f);
+        EXPECT_NEAR(noise.simplex(x, y, z), noise.simplex(x, y, z + h), 0.02f);
+        EXPECT_NEAR(noise.simplex(x, y, z, x), noise.simplex(x, y, z, x + h), 0.02f);
+    }
+}
+
+TEST_F(NoiseTest, seed)
+{
+    Noise a(1234), b(1234), c(4321);
+    int differences = 0;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        float x = coord(i, 0.01f) + 0.5f, y = coord(i + 3, 0.01f) + 0.25f;
+
+        EXPECT_EQ(a.simplex(x, y), b.simplex(x, y));
+        differences += a.simplex(x, y) != c.simplex(x, y) ? 1 : 0;
+    }
+
+    EXPECT_GT(differences, 90);
+
+    // Seeding from engines is reproducible
+    Xoshiro256 r1(7), r2(7);
+    a.seed(r1);
+    b.seed(r2);
+    EXPECT_EQ(a.perlin(0.3f, 0.7f, 1.1f), b.perlin(0.3f, 0.7f, 1.1f));
+}
+
+TEST_F(NoiseTest, fractals)
+{
+    Noise::Fractal fractal;
+    fractal.octaves = 5;
+    fractal.frequency = 0.05f;
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        float x = coord(i, 0.1f), y = coord(i + 1, 0.1f), z = coord(i + 2, 0.1f);
+
+        fractal.basis = i % 2 ? Noise::Basis::PERLIN : Noise::Basis::SIMPLEX;
+
+        ASSERT_LE(std::fabs(noise.fbm(x, y, fractal)), 1.1f);
+        ASSERT_LE(std::fabs(noise.fbm(x, y, z, fractal)), 1.1f);
+        ASSERT_LE(std::fabs(noise.fbm(x, y, z, x, fractal)), 1.1f);
+
+        float r = noise.ridged(x, y, z, fractal);
+        ASSERT_GE(r, 0.0f);
+        ASSERT_LE(r, 1.0f);
+
+        // Without warping, fractal() is fbm() or ridged()
+        fractal.mode = Noise::Mode::RIDGED;
+        ASSERT_EQ(noise.ridged(x, y, fractal), noise.fractal(x, y, fractal));
+        fractal.mode = Noise::Mode::FBM;
+        ASSERT_EQ(noise.fbm(x, y, z, fractal), noise.fractal(x, y, z, fractal));
+    }
+
+    // A single octave is the basis noise
+    fractal.basis = Noise::Basis::SIMPLEX;
+    fractal.octaves = 1;
+    fractal.frequency = 1.0f;
+    EXPECT_FLOAT_EQ(noise.simplex(0.3f, 0.4f, 0.5f, 0.6f), noise.fbm(0.3f, 0.4f, 0.5f, 0.6f, fractal));
+
+    // Warping displaces the domain
+    fractal.warp = 4.0f;
+    EXPECT_NE(noise.fbm(10.3f, 4.4f, fractal), noise.fractal(10.3f, 4.4f, fractal));
+}
+
+TEST_F(NoiseTest, gridMatchesScalar)
+{
+    const int width = 37, height = 23; // Not multiple of any SIMD width
+    const float x0 = -7.3f, y0 = 3.1f, step = 0.173f;
+    std::vector<float> grid(width * height);
+
+    for (int c = 0; c < 8; ++c)
+    {
+        Noise::Fractal fractal;
+        fractal.basis = c & 1 ? Noise::Basis::PERLIN : Noise::Basis::SIMPLEX;
+        fractal.mode = c & 2 ? Noise::Mode::RIDGED : Noise::Mode::FBM;
+        fractal.warp = c & 4 ? 0.5f : 0.0f;
+        fractal.octaves = 4;
+        fractal.frequency = 0.7f;
+
+        noise.fillGrid(&grid[0], width, height, x0, y0, step, fractal);
+
+        for (int j = 0; j < height; ++j)
+        {
+            for (int i = 0; i < width; ++i)
+            {
+                float expected = noise.fractal(x0 + float(i) * step, y0 + float(j) * step, fractal);
+                ASSERT_NEAR(expected, grid[j * width + i], 1e-4f) << "case " << c << " at " << i << ", " << j;
+            }
+        }
+
+        noise.fillGrid(&grid[0], width, height, x0, y0, 2.7f, step, fractal);
+
+        for (int j = 0; j < height; ++j)
+        {
+            for (int i = 0; i < width; ++i)
+            {
+                float expected = noise.fractal(x0 + float(i) * step, y0 + float(j) * step, 2.7f, fractal);
+                ASSERT_NEAR(expected, grid[j * width + i], 1e-4f) << "case " << c << " at " << i << ", " << j;
+            }
+        }
+    }
+}
@@ -0,0 +1,282 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "gtest/gtest.h"
+#include "BVH.h"
+#include "Mesh.h"
+#include "NutResourceFile.h"
+#include "ResourceFileFactory.h"
+
+using namespace nut;
+
+class NutResourceFileTest : public ::testing::Test
+{
+    protected:
+
+    std::string path;
+
+    virtual void SetUp()
+    {
+        path = ::testing::TempDir() + "NutResourceFileTest.nut";
+    }
+
+    virtual void TearDown()
+    {
+        std::remove(path.c_str());
+    }
+
+    // Latitude-longitude sphere, with its bounds and hull
+    static void makeSphere(Mesh& mesh, int rings, int segments, const Vec3f& center, float radius)
+    {
+        std::vector<Vertex>& vertices = mesh.getVertices();
+        std::vector<int>& indices = mesh.getTriangulation();
+
+        for (int i = 0; i <= rings; ++i)
+        {
+            float theta = float(M_PI) * float(i) / float(rings);
+
+            for (int j = 0; j <= segments; ++j)
+            {
+                float phi = 2.0f * float(M_PI) * float(j) / float(segments);
+                Vertex v;
+                v.normal = Vec3f(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                v.pos = center + v.normal * radius;
+                v.tangent = Vec3f(-std::sin(phi), 0.0f, std::cos(phi));
+                v.bitangent = Vec3f(float(i), float(j), 0.0f);
+                vertices.push_back(v);
+            }
+        }
+
+        for (int i = 0; i < rings; ++i)
+        {
+            for (int j = 0; j < segments; ++j)
+            {
+                int a = i * (segments + 1) + j;
+                int b = a + segments + 1;
+                int triangle[6] = { a, b, a + 1, a + 1, b, b + 1 };
+                indices.insert(indices.end(), triangle, triangle + 6);
+            }
+        }
+
+        mesh.getBoundingSphere() = Sphere::fit(mesh);
+        mesh.getConvexHull().build(mesh);
+    }
+
+    // A flat quad: no hull
+    static void makeQuad(Mesh& mesh)
+    {
+        const float corners[4][2] = { {-1, -1}, {1, -1}, {1, 1}, {-1, 1} };
+        const int triangles[6] = { 0, 1, 2, 0, 2, 3 };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            Vertex v;
+            v.pos = Vec3f(corners[i][0], corners[i][1], 0.0f);
+            v.normal = Vec3f(0.0f, 0.0f, 1.0f);
+            mesh.getVertices().push_back(v);
+        }
+
+        mesh.getTriangulation().assign(triangles, triangles + 6);
+        mesh.getBoundingSphere() = Sphere::fit(mesh);
+        mesh.getConvexHull().build(mesh);
+    }
+
+    static NutResourceFile* load(const std::string& path)
+    {
+        return static_cast<NutResourceFile*>(NutResourceFile::createMe(path));
+    }
+
+    static bool sameBytes(const void* a, const void* b, size_t size)
+    {
+        return size == 0 || std::memcmp(a, b, size) == 0;
+    }
+
+    static bool isAligned(const void* p)
+    {
+        return reinterpret_cast<uintptr_t>(p) % NutResourceFile::ALIGNMENT == 0;
+    }
+
+    void writeBytes(const std::vector<char>& bytes)
+    {
+        std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), bytes.size());
+    }
+
+    std::vector<char> readBytes()
+    {
+        std::ifstream file(path.c_str(), std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+};
+
+
+
+TEST_F(NutResourceFileTest, roundTrip)
+{
+    std::vector<Mesh> meshes(3);
+    makeSphere(meshes[0], 16, 32, Vec3f(1.0f, 2.0f, 3.0f), 2.0f);
+    makeQuad(meshes[1]);
+    // meshes[2] is empty
+
+    ASSERT_FALSE(meshes[0].getConvexHull().isEmpty());
+    ASSERT_TRUE(meshes[1].getConvexHull().isEmpty());
+    ASSERT_TRUE(NutResourceFile::write(path, meshes));
+    EXPECT_EQ(0u, readBytes().size() % NutResourceFile::ALIGNMENT);
+
+    std::unique_ptr<NutResourceFile> file(load(path));
+    ASSERT_TRUE(file->isLoaded());
+    ASSERT_EQ(3u, file->getNumberOfMeshes());
+    EXPECT_EQ(3u, file->getNumberOfResources());
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        Mesh& mesh = meshes[i];
+        const NutResourceFile::MeshView& view = file->getMesh(i);
+
+        ASSERT_EQ(mesh.getVertices().size(), view.vertexCount);
+        ASSERT_EQ(mesh.getTriangulation().size(), view.indexCount);
+        ASSERT_EQ(mesh.getConvexHull().getVertices().size(), view.hullVertexCount);
+        ASSERT_EQ(mesh.getConvexHull().getIndices().size(), view.hullIndexCount);
+
+        // The arrays are used in place, aligned for SIMD loads
+        EXPECT_TRUE(isAligned(view.vertices));
+        EXPECT_TRUE(isAligned(view.triangulation));
+        EXPECT_TRUE(isAligned(view.hullVertices));
+        EXPECT_TRUE(isAligned(view.hullIndices));
+
+        EXPECT_TRUE(sameBytes(mesh.getVertices().data(), view.vertices, view.vertexCount * sizeof(Vertex)));
+        EXPECT_TRUE(sameBytes(mesh.getTriangulation().data(), view.triangulation, view.indexCount * sizeof(int)));
+        EXPECT_TRUE(sameBytes(mesh.getConvexHull().getVertices().data(), view.hullVertices,
+                              view.hullVertexCount * sizeof(Vec3f)));
+        EXPECT_TRUE(sameBytes(mesh.getConvexHull().getIndices().data(), view.hullIndices,
+                              view.hullIndexCount * sizeof(U32)));
+
+        EXPECT_EQ(mesh.getBoundingSphere().center, view.boundingSphere.center);
+        EXPECT_EQ(mesh.getBoundingSphere().radius, view.boundingSphere.radius);
+
+        if (view.vertexCount > 0)
+        {
+            BoundingBox bounds = BoundingBox::compute(mesh);
+            EXPECT_EQ(bounds.min, view.bounds.min);
+            EXPECT_EQ(bounds.max, view.bounds.max);
+        }
+
+        // An owning copy
+        Mesh copy;
+        file->copyMesh(i, copy);
+        EXPECT_EQ(mesh.getVertices().size(), copy.getVertices().size());
+        EXPECT_TRUE(mesh.getTriangulation() == copy.getTriangulation());
+        EXPECT_TRUE(mesh.getConvexHull().getIndices() == copy.getConvexHull().getIndices());
+        EXPECT_EQ(mesh.getBoundingSphere().radius, copy.getBoundingSphere().radius);
+    }
+
+    EXPECT_TRUE(file->getMesh(0).boundingSphere.contains(Vec3f(1.0f, 4.0f, 3.0f)));
+}
+
+
+
+TEST_F(NutResourceFileTest, bvhFromMapping)
+{
+    std::vector<Mesh> meshes(1);
+    makeSphere(meshes[0], 24, 48, Vec3f(0.0f, 0.0f, 0.0f), 1.0f);
+    ASSERT_TRUE(NutResourceFile::write(path, meshes));
+
+    std::unique_ptr<NutResourceFile> file(load(path));
+    ASSERT_TRUE(file->isLoaded());
+
+    // The tree is built straight from the mapped arrays
+    const NutResourceFile::MeshView& view = file->getMesh(0);
+    BVH mapped, imported;
+    ASSERT_TRUE(mapped.build(&view.vertices[0].pos.x, view.vertexCount, sizeof(Vertex) / sizeof(float),
+                             view.triangulation, view.indexCount / 3));
+    ASSERT_TRUE(imported.build(meshes[0]));
+
+    for (int i = 0; i < 64; ++i)
+    {
+        float angle = 2.0f * float(M_PI) * float(i) / 64.0f;
+        Vec3f origin(3.0f * std::cos(angle), 0.3f, 3.0f * std::sin(angle));
+        Vec3f direction = Vec3f(0.0f, 0.0f, 0.0f) - origin;
+        direction.normalize();
+        Ray ray(origin, direction, 0.0f, 10.0f);
+
+        BVH::Hit a, b;
+        ASSERT_TRUE(mapped.intersect(ray, a));
+        ASSERT_TRUE(imported.intersect(ray, b));
+        EXPECT_EQ(b.triangle, a.triangle);
+        EXPECT_FLOAT_EQ(b.t, a.t);
+    }
+}
+
+
+
+TEST_F(NutResourceFileTest, rejectsInvalidFiles)
+{
+    std::vector<Mesh> meshes(1);
+    makeSphere(meshes[0], 8, 16, Vec3f(0.0f, 0.0f, 0.0f), 1.0f);
+    ASSERT_TRUE(NutResourceFile::write(path, meshes));
+    std::vector<char> bytes = readBytes();
+
+    std::unique_ptr<NutResourceFile> file(load(path + ".missing"));
+    EXPECT_FALSE(file->isLoaded());
+    EXPECT_EQ(0u, file->getNumberOfMeshes());
+
+    // Truncated
+    writeBytes(std::vector<char>(bytes.begin(), bytes.begin() + bytes.size() / 2));
+    file.reset(load(path));
+    EXPECT_FALSE(file->isLoaded());
+
+    // Other version
+    std::vector<char> changed = bytes;
+    changed[4] ^= 0x7F;
+    writeBytes(changed);
+    file.reset(load(path));
+    EXPECT_FALSE(file->isLoaded());
+
+    // Section outside the file (first offset of the mesh table)
+    changed = bytes;
+    changed[NutResourceFile::ALIGNMENT + 6] = 0x7F;
+    writeBytes(changed);
+    file.reset(load(path));
+    EXPECT_FALSE(file->isLoaded());
+
+    // Vertex index out of range (first index of the mesh)
+    U64 indexOffset;
+    std::memcpy(&indexOffset, &bytes[NutResourceFile::ALIGNMENT + sizeof(U64)], sizeof(U64));
+    int badIndex = int(meshes[0].getVertices().size());
+    changed = bytes;
+    std::memcpy(&changed[size_t(indexOffset)], &badIndex, sizeof(int));
+    writeBytes(changed);
+    file.reset(load(path));
+    EXPECT_FALSE(file->isLoaded());
+
+    // Partial triangle (index count of the mesh)
+    U32 indexCount = U32(meshes[0].getTriangulation().size()) - 1;
+    changed = bytes;
+    std::memcpy(&changed[NutResourceFile::ALIGNMENT + 4 * sizeof(U64) + sizeof(U32)], &indexCount, sizeof(U32));
+    writeBytes(changed);
+    file.reset(load(path));
+    EXPECT_FALSE(file->isLoaded());
+
+    writeBytes(bytes);
+    file.reset(load(path));
+    EXPECT_TRUE(file->isLoaded());
+}
+
+
+
+TEST_F(NutResourceFileTest, factory)
+{
+    std::vector<Mesh> meshes(1);
+    makeQuad(meshes[0]);
+    ASSERT_TRUE(NutResourceFile::write(path, meshes));
+
+    ResourceFileFactory::getInstance().registerResourceFile(ResourceFileId::nut, NutResourceFile::createMe);
+    std::unique_ptr<IResourceFile> file(ResourceFileFactory::getInstance().createResourceFile(path));
+
+    ASSERT_TRUE(file != nullptr);
+    EXPECT_EQ(1u, file->getNumberOfResources());
+}
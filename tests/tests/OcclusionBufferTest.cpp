@@ -0,0 +1,367 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "Mesh.h"
+#include "OcclusionBuffer.h"
+
+using namespace nut;
+
+class OcclusionBufferTest : public RandomTest
+{
+    protected:
+
+    static const U32 WIDTH = 256;
+    static const U32 HEIGHT = 128;
+
+    OcclusionBuffer buffer;
+    GLMatrix<float> viewProjection;
+    std::vector<float> positions;
+    std::vector<int> indices;
+
+    // Camera at the origin looking down -z: 90 degrees fov, aspect 2, near 1, far 100
+    virtual void SetUp()
+    {
+        buffer.resize(WIDTH, HEIGHT);
+        setCamera(Vec3f(0.0f, 0.0f, -1.0f));
+    }
+
+    void setCamera(const Vec3f& direction)
+    {
+        GLMatrix<float> projection, view;
+        projection.setPerspective(90.0f, 2.0f, 1.0f, 100.0f);
+        view.setLookAt(0.0f, 0.0f, 0.0f, direction.x, direction.y, direction.z, 0.0f, 1.0f, 0.0f);
+        viewProjection = projection * view;
+    }
+
+    void addVertex(const Vec3f& p)
+    {
+        positions.push_back(p.x);
+        positions.push_back(p.y);
+        positions.push_back(p.z);
+    }
+
+    void addTriangle(const Vec3f& a, const Vec3f& b, const Vec3f& c)
+    {
+        int first = int(positions.size() / 3);
+        addVertex(a);
+        addVertex(b);
+        addVertex(c);
+        indices.push_back(first);
+        indices.push_back(first + 1);
+        indices.push_back(first + 2);
+    }
+
+    /**
+     * Quad a, b, c, d, counter-clockwise when seen from the front.
+     */
+    void addQuad(const Vec3f& a, const Vec3f& b, const Vec3f& c, const Vec3f& d)
+    {
+        addTriangle(a, b, c);
+        addTriangle(a, c, d);
+    }
+
+    bool render()
+    {
+        return buffer.render(&positions[0], positions.size() / 3, 3, &indices[0], indices.size() / 3, viewProjection);
+    }
+
+    /**
+     * Window coordinates of a point.
+     */
+    Vec3f project(const Vec3f& p) const
+    {
+        Vec4f c = viewProjection * Vec4f(p.x, p.y, p.z, 1.0f);
+        return Vec3f((c.x / c.w * 0.5f + 0.5f) * WIDTH, (c.y / c.w * 0.5f + 0.5f) * HEIGHT, c.z / c.w * 0.5f + 0.5f);
+    }
+
+    /**
+     * Exact nearest depth of the front facing triangles at every pixel center
+     * (1 where there's none). The triangles must be in front of the camera.
+     */
+    std::vector<float> referenceDepths() const
+    {
+        std::vector<float> depths(WIDTH * HEIGHT, 1.0f);
+
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            Vec3f v[3];
+
+            for (int k = 0; k < 3; ++k)
+            {
+                v[k] = project(Vec3f(positions[3 * indices[t + k]], positions[3 * indices[t + k] + 1],
+                                     positions[3 * indices[t + k] + 2]));
+            }
+
+            double area = double(v[1].x - v[0].x) * (v[2].y - v[0].y) - double(v[2].x - v[0].x) * (v[1].y - v[0].y);
+
+            if (area <= 0.0)
+            {
+                continue;
+            }
+
+            for (U32 y = 0; y < HEIGHT; ++y)
+            {
+                for (U32 x = 0; x < WIDTH; ++x)
+                {
+                    double px = x + 0.5, py = y + 0.5;
+                    double b[3];
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        const Vec3f& p = v[(k + 1) % 3];
+                        const Vec3f& q = v[(k + 2) % 3];
+                        b[k] = ((q.x - p.x) * (py - p.y) - (q.y - p.y) * (px - p.x)) / area;
+                    }
+
+                    if (b[0] >= 0.0 && b[1] >= 0.0 && b[2] >= 0.0)
+                    {
+                        float z = float(b[0] * v[0].z + b[1] * v[1].z + b[2] * v[2].z);
+                        depths[y * WIDTH + x] = std::min(depths[y * WIDTH + x], z);
+                    }
+                }
+            }
+        }
+
+        return depths;
+    }
+
+    static BoundingBox box(const Vec3f& center, float halfSize)
+    {
+        Vec3f e(halfSize, halfSize, halfSize);
+        return BoundingBox(center - e, center + e);
+    }
+};
+
+TEST_F(OcclusionBufferTest, resize)
+{
+    OcclusionBuffer empty;
+
+    EXPECT_TRUE(empty.isVisible(box(Vec3f(0.0f, 0.0f, -10.0f), 1.0f), viewProjection));
+    EXPECT_FALSE(empty.resize(100, 64));
+    EXPECT_FALSE(empty.resize(64, 60));
+    EXPECT_TRUE(empty.resize(64, 32));
+    EXPECT_EQ(64u, empty.getWidth());
+    EXPECT_EQ(32u, empty.getHeight());
+
+    // Cleared: every pixel is at the far plane
+    EXPECT_EQ(1.0f, buffer.getDepth(0, 0));
+    EXPECT_EQ(1.0f, buffer.getDepth(WIDTH - 1, HEIGHT - 1));
+    EXPECT_TRUE(buffer.isVisible(box(Vec3f(0.0f, 0.0f, -10.0f), 1.0f), viewProjection));
+}
+
+TEST_F(OcclusionBufferTest, wall)
+{
+    addQuad(Vec3f(-2.0f, -2.0f, -5.0f), Vec3f(2.0f, -2.0f, -5.0f), Vec3f(2.0f, 2.0f, -5.0f), Vec3f(-2.0f, 2.0f, -5.0f));
+    render();
+
+    // Depth of z = -5 with near 1 and far 100
+    float depth = (101.0f / 99.0f - 200.0f / (99.0f * 5.0f)) * 0.5f + 0.5f;
+    EXPECT_NEAR(depth, buffer.getDepth(WIDTH / 2, HEIGHT / 2), 1e-5f);
+    EXPECT_EQ(1.0f, buffer.getDepth(0, 0));
+
+    EXPECT_FALSE(buffer.isVisible(box(Vec3f(0.0f, 0.0f, -10.0f), 0.5f), viewProjection));
+    EXPECT_FALSE(buffer.isVisible(box(Vec3f(1.0f, -1.0f, -30.0f), 2.0f), viewProjection));
+    EXPECT_TRUE(buffer.isVisible(box(Vec3f(0.0f, 0.0f, -3.0f), 0.5f), viewProjection));   // In front
+    EXPECT_TRUE(buffer.isVisible(box(Vec3f(6.0f, 0.0f, -10.0f), 0.5f), viewProjection));  // Beside
+    EXPECT_TRUE(buffer.isVisible(box(Vec3f(4.0f, 0.0f, -10.0f), 0.5f), viewProjection));  // Across the edge
+    EXPECT_TRUE(buffer.isVisible(box(Vec3f(0.0f, 0.0f, -5.0f), 0.5f), viewProjection));   // Through the wall
+    EXPECT_TRUE(buffer.isVisible(box(Vec3f(0.0f, 0.0f, 0.0f), 0.5f), viewProjection));    // Around the camera
+    EXPECT_TRUE(buffer.isVisible(box(Vec3f(0.0f, 0.0f, 10.0f), 0.5f), viewProjection));   // Left to frustum culling
+    EXPECT_FALSE(buffer.isVisible(BoundingBox(), viewProjection));
+
+    // Back faces don't occlude
+    buffer.clear();
+    positions.clear();
+    indices.clear();
+    addQuad(Vec3f(-2.0f, -2.0f, -5.0f), Vec3f(-2.0f, 2.0f, -5.0f), Vec3f(2.0f, 2.0f, -5.0f), Vec3f(2.0f, -2.0f, -5.0f));
+    render();
+    EXPECT_EQ(1.0f, buffer.getDepth(WIDTH / 2, HEIGHT / 2));
+    EXPECT_TRUE(buffer.isVisible(box(Vec3f(0.0f, 0.0f, -10.0f), 0.5f), viewProjection));
+}
+
+TEST_F(OcclusionBufferTest, invalidIndices)
+{
+    addQuad(Vec3f(-2.0f, -2.0f, -5.0f), Vec3f(2.0f, -2.0f, -5.0f), Vec3f(2.0f, 2.0f, -5.0f), Vec3f(-2.0f, 2.0f, -5.0f));
+    indices.back() = int(positions.size() / 3);
+    EXPECT_FALSE(render());
+
+    indices.back() = -1;
+    EXPECT_FALSE(render());
+
+    // Nothing was rasterized
+    EXPECT_EQ(1.0f, buffer.getDepth(WIDTH / 2, HEIGHT / 2));
+
+    indices.back() = 0;
+    EXPECT_TRUE(render());
+}
+
+TEST_F(OcclusionBufferTest, clipping)
+{
+    // Far beyond the guard band
+    addQuad(Vec3f(-1000.0f, -1000.0f, -5.0f), Vec3f(1000.0f, -1000.0f, -5.0f),
+            Vec3f(1000.0f, 1000.0f, -5.0f), Vec3f(-1000.0f, 1000.0f, -5.0f));
+    render();
+
+    for (U32 y = 0; y < HEIGHT; y += 7)
+    {
+        for (U32 x = 0; x < WIDTH; x += 7)
+        {
+            ASSERT_GT(1.0f, buffer.getDepth(x, y));
+        }
+    }
+
+    EXPECT_FALSE(buffer.isVisible(box(Vec3f(20.0f, -5.0f, -30.0f), 2.0f), viewProjection));
+
+    // A floor under a camera looking down, crossing the near plane
+    buffer.clear();
+    positions.clear();
+    indices.clear();
+    setCamera(Vec3f(0.0f, -1.0f, -2.0f));
+    addQuad(Vec3f(-100.0f, -1.0f, 100.0f), Vec3f(100.0f, -1.0f, 100.0f),
+            Vec3f(100.0f, -1.0f, -100.0f), Vec3f(-100.0f, -1.0f, -100.0f));
+    render();
+
+    EXPECT_FALSE(buffer.isVisible(BoundingBox(Vec3f(-1.0f, -3.0f, -11.0f), Vec3f(1.0f, -2.0f, -9.0f)), viewProjection));
+    EXPECT_FALSE(buffer.isVisible(BoundingBox(Vec3f(-1.0f, -3.0f, -3.0f), Vec3f(1.0f, -2.0f, -2.0f)), viewProjection));
+    EXPECT_TRUE(buffer.isVisible(BoundingBox(Vec3f(-1.0f, -0.9f, -11.0f), Vec3f(1.0f, -0.5f, -9.0f)), viewProjection));
+}
+
+TEST_F(OcclusionBufferTest, conservative)
+{
+    // Random triangles of both orientations in front of the camera
+    for (int i = 0; i < 300; ++i)
+    {
+        Vec3f c(uniform(-12.0f, 12.0f), uniform(-6.0f, 6.0f), uniform(-25.0f, -4.0f));
+        Vec3f a = c + Vec3f(uniform(-3.0f, 3.0f), uniform(-3.0f, 3.0f), uniform(-2.0f, 2.0f));
+        Vec3f b = c + Vec3f(uniform(-3.0f, 3.0f), uniform(-3.0f, 3.0f), uniform(-2.0f, 2.0f));
+        Vec3f d = c + Vec3f(uniform(-3.0f, 3.0f), uniform(-3.0f, 3.0f), uniform(-2.0f, 2.0f));
+
+        a.z = std::min(a.z, -2.0f);
+        b.z = std::min(b.z, -2.0f);
+        d.z = std::min(d.z, -2.0f);
+        addTriangle(a, b, d);
+    }
+
+    render();
+
+    // The buffer is never in front of the occluders
+    std::vector<float> reference = referenceDepths();
+    int occluded = 0;
+
+    for (U32 y = 0; y < HEIGHT; ++y)
+    {
+        for (U32 x = 0; x < WIDTH; ++x)
+        {
+            float depth = buffer.getDepth(x, y);
+            ASSERT_GE(depth, reference[y * WIDTH + x] - 1e-5f) << "pixel " << x << ", " << y;
+            occluded += depth < 1.0f;
+        }
+    }
+
+    EXPECT_GT(occluded, int(WIDTH * HEIGHT / 4));
+
+    // Hidden boxes are behind the occluders at every pixel they cover
+    int hidden = 0;
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        BoundingBox b = box(Vec3f(uniform(-20.0f, 20.0f), uniform(-10.0f, 10.0f), uniform(-40.0f, -10.0f)), uniform(0.1f, 1.5f));
+
+        if (buffer.isVisible(b, viewProjection))
+        {
+            continue;
+        }
+
+        ++hidden;
+
+        for (int s = 0; s < 50; ++s)
+        {
+            Vec3f p = project(Vec3f(uniform(b.min.x, b.max.x), uniform(b.min.y, b.max.y), uniform(b.min.z, b.max.z)));
+
+            if (p.x >= 0.0f && p.x < WIDTH && p.y >= 0.0f && p.y < HEIGHT)
+            {
+                ASSERT_LE(reference[U32(p.y) * WIDTH + U32(p.x)], p.z + 1e-5f) << "box " << i;
+            }
+        }
+    }
+
+    EXPECT_GT(hidden, 0);
+}
+
+TEST_F(OcclusionBufferTest, cullBoxes)
+{
+    Mesh mesh;
+
+    // A wall as a mesh
+    const float corners[4][2] = { {-3.0f, -2.0f}, {3.0f, -2.0f}, {3.0f, 2.0f}, {-3.0f, 2.0f} };
+
+    for (int i = 0; i < 4; ++i)
+    {
+        Vertex v;
+        v.pos = Vec3f(corners[i][0], corners[i][1], -6.0f);
+        mesh.getVertices().push_back(v);
+    }
+
+    const int quad[6] = { 0, 1, 2, 0, 2, 3 };
+    mesh.getTriangulation().assign(quad, quad + 6);
+    buffer.render(mesh, viewProjection);
+
+    std::vector<BoundingBox> boxes;
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        boxes.push_back(box(Vec3f(uniform(-10.0f, 10.0f), uniform(-5.0f, 5.0f), uniform(-30.0f, -2.0f)), uniform(0.1f, 1.0f)));
+    }
+
+    std::vector<U32> visible(boxes.size());
+    size_t n = buffer.cullBoxes(&boxes[0], boxes.size(), viewProjection, &visible[0]);
+    size_t expected = 0;
+
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        if (buffer.isVisible(boxes[i], viewProjection))
+        {
+            ASSERT_LT(expected, n);
+            ASSERT_EQ(U32(i), visible[expected++]);
+        }
+    }
+
+    EXPECT_EQ(expected, n);
+    EXPECT_LT(n, boxes.size());
+}
+
+TEST_F(OcclusionBufferTest, terrain)
+{
+    // About 100k triangles: a terrain seen from above, in front of the camera
+    const int N = 224;
+    Mesh terrain;
+    std::vector<Vertex>& vertices = terrain.getVertices();
+    std::vector<int>& triangulation = terrain.getTriangulation();
+
+    for (int j = 0; j <= N; ++j)
+    {
+        for (int i = 0; i <= N; ++i)
+        {
+            Vertex v;
+            float x = -50.0f + 100.0f * i / N, z = -100.0f * j / N;
+            v.pos = Vec3f(x, -3.0f + std::sin(0.3f * x) * std::cos(0.2f * z), z);
+            vertices.push_back(v);
+        }
+    }
+
+    for (int j = 0; j < N; ++j)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            int a = j * (N + 1) + i, b = a + 1, c = a + N + 1, d = c + 1;
+            int cells[6] = { a, b, d, a, d, c };
+            triangulation.insert(triangulation.end(), cells, cells + 6);
+        }
+    }
+
+    buffer.render(terrain, viewProjection);
+
+    EXPECT_FALSE(buffer.isVisible(box(Vec3f(0.0f, -8.0f, -40.0f), 1.0f), viewProjection));
+    EXPECT_TRUE(buffer.isVisible(box(Vec3f(0.0f, 2.0f, -40.0f), 1.0f), viewProjection));
+}
@@ -0,0 +1,207 @@
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "Frustum.h"
+#include "OrientedBoundingBox.h"
+
+using namespace nut;
+
+class OrientedBoundingBoxTest : public RandomTest
+{
+    protected:
+
+    OrientedBoundingBox randomBox(float spread)
+    {
+        return OrientedBoundingBox(Vec3f(uniform(-spread, spread), uniform(-spread, spread), uniform(-spread, spread)),
+                                   Vec3f(uniform(0.2f, 2.0f), uniform(0.2f, 2.0f), uniform(0.2f, 2.0f)),
+                                   randomRotation());
+    }
+
+    // Project the corners of both boxes on a candidate axis
+    static bool separatedAlong(const Vec3f& axis, const Vec3f* a, const Vec3f* b)
+    {
+        float minA = FLT_MAX, maxA = -FLT_MAX, minB = FLT_MAX, maxB = -FLT_MAX;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            minA = std::min(minA, a[i] * axis);
+            maxA = std::max(maxA, a[i] * axis);
+            minB = std::min(minB, b[i] * axis);
+            maxB = std::max(maxB, b[i] * axis);
+        }
+
+        return maxA < minB || maxB < minA;
+    }
+
+    // Independent separating axis test on the box corners
+    static bool bruteForceOverlap(const OrientedBoundingBox& a, const OrientedBoundingBox& b)
+    {
+        Vec3f ca[8], cb[8];
+        a.getCorners(ca);
+        b.getCorners(cb);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            if (separatedAlong(a.getAxis(i), ca, cb) || separatedAlong(b.getAxis(i), ca, cb))
+            {
+                return false;
+            }
+
+            for (int j = 0; j < 3; ++j)
+            {
+                Vec3f axis = a.getAxis(i).cross(b.getAxis(j));
+
+                if (axis.length() > 1e-4f && separatedAlong(axis, ca, cb))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+};
+
+TEST_F(OrientedBoundingBoxTest, basics)
+{
+    BoundingBox aabb(Vec3f(-1.0f, 0.0f, 2.0f), Vec3f(3.0f, 2.0f, 3.0f));
+    OrientedBoundingBox box(aabb);
+
+    EXPECT_FLOAT_EQ(2.0f, box.halfExtents.x);
+    EXPECT_FLOAT_EQ(8.0f, box.getVolume());
+    EXPECT_TRUE(box.contains(Vec3f(2.9f, 1.9f, 2.1f)));
+    EXPECT_FALSE(box.contains(Vec3f(3.1f, 1.0f, 2.5f)));
+
+    BoundingBox back = box.getBoundingBox();
+    EXPECT_FLOAT_EQ(aabb.min.x, back.min.x);
+    EXPECT_FLOAT_EQ(aabb.max.z, back.max.z);
+
+    // 45 degrees around z: the AABB grows by sqrt(2)
+    GLMatrix<float> m;
+    m.setRotation(0.0f, 0.0f, 1.0f, 0.785398163f);
+    OrientedBoundingBox rotated(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 1.0f, 1.0f), Matrix3x3<float>(m));
+    EXPECT_NEAR(std::sqrt(2.0f), rotated.getBoundingBox().max.x, 1e-5f);
+    EXPECT_TRUE(rotated.contains(Vec3f(1.4f, 0.0f, 0.0f)));
+    EXPECT_FALSE(rotated.contains(Vec3f(1.0f, 1.0f, 0.0f)));
+
+    Vec3f corners[8];
+    rotated.getCorners(corners);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        EXPECT_NEAR(std::sqrt(3.0f), corners[i].length(), 1e-5f);
+    }
+}
+
+TEST_F(OrientedBoundingBoxTest, overlapsMatchesBruteForce)
+{
+    int overlapping = 0;
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        OrientedBoundingBox a = randomBox(3.0f), b = randomBox(3.0f);
+        bool expected = bruteForceOverlap(a, b);
+
+        ASSERT_EQ(expected, a.overlaps(b)) << "pair " << i;
+        ASSERT_EQ(expected, b.overlaps(a)) << "pair " << i;
+        overlapping += expected;
+    }
+
+    // Both outcomes are common
+    EXPECT_GT(overlapping, 2000);
+    EXPECT_LT(overlapping, 18000);
+}
+
+TEST_F(OrientedBoundingBoxTest, overlapsAABB)
+{
+    for (int i = 0; i < 5000; ++i)
+    {
+        Vec3f c(uniform(-3.0f, 3.0f), uniform(-3.0f, 3.0f), uniform(-3.0f, 3.0f));
+        Vec3f e(uniform(0.2f, 2.0f), uniform(0.2f, 2.0f), uniform(0.2f, 2.0f));
+        BoundingBox aabb(c - e, c + e);
+        OrientedBoundingBox box = randomBox(3.0f);
+
+        ASSERT_EQ(bruteForceOverlap(box, OrientedBoundingBox(aabb)), box.overlaps(aabb)) << "pair " << i;
+
+        // Axis aligned boxes agree with the AABB test
+        OrientedBoundingBox aligned(box.getBoundingBox());
+        ASSERT_EQ(box.getBoundingBox().overlaps(aabb), aligned.overlaps(aabb)) << "pair " << i;
+    }
+}
+
+TEST_F(OrientedBoundingBoxTest, frustum)
+{
+    GLMatrix<float> projection, view;
+    projection.setPerspective(90.0f, 1.0f, 1.0f, 100.0f);
+    view.setLookAt(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f);
+    Frustum frustum(projection * view);
+
+    Matrix3x3<float> rotation = randomRotation();
+    EXPECT_TRUE(frustum.intersects(OrientedBoundingBox(Vec3f(0.0f, 0.0f, -10.0f), Vec3f(1.0f, 1.0f, 1.0f), rotation)));
+    EXPECT_FALSE(frustum.intersects(OrientedBoundingBox(Vec3f(0.0f, 0.0f, 10.0f), Vec3f(1.0f, 1.0f, 1.0f), rotation)));
+    EXPECT_FALSE(frustum.intersects(OrientedBoundingBox(Vec3f(0.0f, 0.0f, -200.0f), Vec3f(1.0f, 1.0f, 1.0f), rotation)));
+
+    // A thin box rotated 45 degrees next to the left plane: its AABB touches
+    // the frustum, the box doesn't
+    GLMatrix<float> m;
+    m.setRotation(0.0f, 1.0f, 0.0f, -0.785398163f);
+    OrientedBoundingBox thin(Vec3f(-13.0f, 0.0f, -10.0f), Vec3f(4.0f, 1.0f, 0.1f), Matrix3x3<float>(m));
+    EXPECT_TRUE(frustum.intersects(thin.getBoundingBox()));
+    EXPECT_FALSE(frustum.intersects(thin));
+
+    // Never stricter than the exact answer: boxes containing a visible point pass
+    for (int i = 0; i < 2000; ++i)
+    {
+        OrientedBoundingBox box = randomBox(50.0f);
+        Vec3f corners[8];
+        box.getCorners(corners);
+        bool visible = frustum.contains(box.center);
+
+        for (int k = 0; k < 8; ++k)
+        {
+            visible = visible || frustum.contains(corners[k]);
+        }
+
+        if (visible)
+        {
+            ASSERT_TRUE(frustum.intersects(box)) << "box " << i;
+        }
+    }
+}
+
+TEST_F(OrientedBoundingBoxTest, fit)
+{
+    // Points filling a rotated, elongated box
+    Matrix3x3<float> rotation = randomRotation();
+    Vec3f center(5.0f, -3.0f, 2.0f), half(8.0f, 3.0f, 1.0f);
+    std::vector<Vec3f> points(200000);
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        Vec3f local(uniform(-half.x, half.x), uniform(-half.y, half.y), uniform(-half.z, half.z));
+        points[i] = center + rotation * local;
+    }
+
+    OrientedBoundingBox box = OrientedBoundingBox::fit(&points[0].x, points.size());
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        ASSERT_TRUE(box.contains(points[i] + (points[i] - box.center) * -1e-5f)) << "point " << i;
+    }
+
+    // Close to the generating box, much tighter than the AABB in general
+    EXPECT_NEAR(8.0f * half.x * half.y * half.z, box.getVolume(), 0.02f * box.getVolume());
+    EXPECT_LT(box.getVolume(), box.getBoundingBox().getExtents().x * box.getBoundingBox().getExtents().y *
+                               box.getBoundingBox().getExtents().z * 8.0f + 1e-3f);
+    EXPECT_NEAR(1.0f, std::fabs(box.getAxis(0) * Vec3f(rotation[0], rotation[1], rotation[2])), 1e-3f);
+    EXPECT_NEAR(8.0f, box.halfExtents.x, 0.01f);
+    EXPECT_NEAR(0.0f, (box.center - center).length(), 0.01f);
+
+    // Right-handed orthonormal basis
+    EXPECT_NEAR(1.0f, box.getAxis(0).cross(box.getAxis(1)) * box.getAxis(2), 1e-5f);
+
+    // No points
+    EXPECT_FLOAT_EQ(0.0f, OrientedBoundingBox::fit(&points[0].x, 0).getVolume());
+}
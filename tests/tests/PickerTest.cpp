@@ -0,0 +1,224 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "BVH.h"
+#include "GLMatrix.h"
+#include "Picker.h"
+#include "TLAS.h"
+
+using namespace nut;
+
+class PickerTest : public ::testing::Test
+{
+    protected:
+
+    BVH quad;
+    TLAS scene;
+    GLMatrix<float> viewProjection;
+    Vec4f viewport;
+
+    virtual void SetUp()
+    {
+        // A 2 x 2 quad facing +z, placed left and right of the origin
+        float positions[] = { -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.0f, -1.0f, 1.0f, 0.0f };
+        int indices[] = { 0, 1, 2, 0, 2, 3 };
+        ASSERT_TRUE(quad.build(positions, 4, 3, indices, 2));
+
+        GLMatrix<float> transform;
+        transform.setTranslation(-3.0f, 0.0f, 0.0f);
+        scene.addInstance(&quad, transform);
+        transform.setTranslation(3.0f, 0.0f, 0.0f);
+        scene.addInstance(&quad, transform);
+        scene.build();
+
+        GLMatrix<float> view, projection;
+        view.setLookAt(0.0f, 0.0f, 10.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+        projection.setPerspective(60.0f, 1.0f, 1.0f, 100.0f);
+        viewProjection = projection * view;
+        viewport = Vec4f(0.0f, 0.0f, 512.0f, 512.0f);
+    }
+};
+
+TEST_F(PickerTest, getRay)
+{
+    Ray ray = Picker::getRay(256.0f, 256.0f, viewport, viewProjection.inverse());
+
+    EXPECT_NEAR(0.0f, ray.origin.x, 1e-4f);
+    EXPECT_NEAR(0.0f, ray.origin.y, 1e-4f);
+    EXPECT_NEAR(9.0f, ray.origin.z, 1e-3f);
+    EXPECT_NEAR(-1.0f, ray.direction.z, 1e-5f);
+    EXPECT_NEAR(99.0f, ray.tMax, 1e-2f);
+
+    // Through the projection of a point
+    Vec3f p(3.5f, -0.5f, 0.0f);
+    Vec3f w = viewProjection.project(p, viewport);
+    ray = Picker::getRay(w.x, w.y, viewport, viewProjection.inverse());
+    Vec3f toPoint = p - ray.origin;
+
+    EXPECT_NEAR(1.0f, ray.direction.length(), 1e-5f);
+    EXPECT_NEAR(0.0f, toPoint.cross(ray.direction).length(), 1e-3f);
+}
+
+TEST_F(PickerTest, resultsInNextFrame)
+{
+    Picker picker;
+    std::vector<Picker::Result> results;
+
+    Vec3f right = viewProjection.project(Vec3f(3.0f, 0.5f, 0.0f), viewport);
+    U32 first = picker.pick(right.x, right.y);
+    U32 second = picker.pick(256.0f, 256.0f);
+    U32 third = picker.pick(Ray(Vec3f(-3.0f, 0.0f, -5.0f), Vec3f(0.0f, 0.0f, 1.0f)));
+
+    EXPECT_FALSE(picker.isPending());
+    picker.update(scene, viewProjection, viewport, results);
+    EXPECT_TRUE(picker.isPending());
+    EXPECT_TRUE(results.empty());
+
+    // The batch runs on a copy of the scene
+    scene.clear();
+    scene.build();
+
+    U32 fourth = picker.pick(right.x, right.y);
+    picker.wait();
+    picker.update(scene, viewProjection, viewport, results);
+    ASSERT_EQ(3u, results.size());
+
+    EXPECT_EQ(first, results[0].request);
+    ASSERT_TRUE(results[0].isHit());
+    EXPECT_EQ(1u, results[0].hit.instance);
+    EXPECT_NEAR(3.0f, results[0].point.x, 1e-3f);
+    EXPECT_NEAR(0.5f, results[0].point.y, 1e-3f);
+    EXPECT_NEAR(0.0f, results[0].point.z, 1e-3f);
+
+    // Between the quads
+    EXPECT_EQ(second, results[1].request);
+    EXPECT_FALSE(results[1].isHit());
+
+    // World ray, hitting the back of the left quad
+    EXPECT_EQ(third, results[2].request);
+    ASSERT_TRUE(results[2].isHit());
+    EXPECT_EQ(0u, results[2].hit.instance);
+    EXPECT_NEAR(5.0f, results[2].hit.t, 1e-4f);
+
+    // The empty scene of the last frame
+    results.clear();
+    picker.wait();
+    picker.update(scene, viewProjection, viewport, results);
+    ASSERT_EQ(1u, results.size());
+    EXPECT_EQ(fourth, results[0].request);
+    EXPECT_FALSE(results[0].isHit());
+    EXPECT_FALSE(picker.isPending());
+
+    // Nothing queued
+    results.clear();
+    picker.update(scene, viewProjection, viewport, results);
+    EXPECT_TRUE(results.empty());
+}
+
+TEST_F(PickerTest, manyFrames)
+{
+    Picker picker;
+    std::vector<Picker::Result> results;
+    size_t requests = 0;
+
+    for (int frame = 0; frame < 200; ++frame)
+    {
+        for (int i = 0; i < frame % 5; ++i)
+        {
+            picker.pick(float(frame), float(i * 100));
+            ++requests;
+        }
+
+        picker.update(scene, viewProjection, viewport, results);
+    }
+
+    while (picker.isPending())
+    {
+        picker.wait();
+        picker.update(scene, viewProjection, viewport, results);
+    }
+
+    ASSERT_EQ(requests, results.size());
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        ASSERT_EQ(U32(i), results[i].request);
+    }
+}
+
+TEST_F(PickerTest, updateDoesNotWait)
+{
+    // A stack of triangles whose bounds all contain the ray along the z axis,
+    // while the triangles miss it: every pick visits every leaf, so the batch
+    // runs for many frames (and many time slices on a single core)
+    const int layers = 4096;
+    std::vector<float> positions;
+    std::vector<int> indices;
+
+    for (int i = 0; i < layers; ++i)
+    {
+        const float corners[6] = { -0.8f, 1.2f, 1.2f, 1.2f, 1.2f, -0.8f };
+
+        for (int k = 0; k < 3; ++k)
+        {
+            positions.push_back(corners[2 * k]);
+            positions.push_back(corners[2 * k + 1]);
+            positions.push_back(0.001f * float(i));
+            indices.push_back(3 * i + k);
+        }
+    }
+
+    BVH stack;
+    ASSERT_TRUE(stack.build(&positions[0], size_t(3 * layers), 3, &indices[0], size_t(layers)));
+
+    TLAS slow;
+    slow.addInstance(&stack, GLMatrix<float>());
+    slow.build();
+
+    const size_t count = 2000;
+    const Ray ray(Vec3f(0.0f, 0.0f, 10.0f), Vec3f(0.0f, 0.0f, -1.0f));
+    Picker picker;
+    std::vector<Picker::Result> results;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        picker.pick(ray);
+    }
+
+    picker.update(slow, viewProjection, viewport, results);
+    ASSERT_TRUE(picker.isPending());
+
+    // The next frame returns right away, with nothing
+    U32 last = picker.pick(ray);
+    picker.update(slow, viewProjection, viewport, results);
+    EXPECT_TRUE(results.empty());
+    EXPECT_TRUE(picker.isPending());
+
+    // Requests queued meanwhile are handed over once the batch is done
+    int frames = 1;
+
+    while (results.size() < count)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        last = picker.pick(ray);
+        picker.update(slow, viewProjection, viewport, results);
+        ++frames;
+
+        EXPECT_TRUE(results.empty() || results.size() == count);
+        EXPECT_TRUE(picker.isPending());
+    }
+
+    picker.wait();
+    picker.update(slow, viewProjection, viewport, results);
+    ASSERT_EQ(count + size_t(frames), results.size());
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        ASSERT_EQ(U32(i), results[i].request);
+        ASSERT_FALSE(results[i].isHit());
+    }
+
+    EXPECT_EQ(last, results.back().request);
+    EXPECT_FALSE(picker.isPending());
+}
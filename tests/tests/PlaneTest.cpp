@@ -0,0 +1,293 @@
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "Mesh.h"
+#include "Plane.h"
+
+using namespace nut;
+
+class PlaneTest : public RandomTest
+{
+    protected:
+
+    static void addVertex(Mesh& mesh, const Vec3f& p)
+    {
+        Vertex v;
+        v.pos = p / p.length();
+        v.normal = v.pos;
+        v.tangent = Vec3f(0.0f, 0.0f, 1.0f).cross(v.pos);
+        v.bitangent = v.pos.cross(v.tangent);
+        mesh.getVertices().push_back(v);
+    }
+
+    /**
+     * Closed, indexed unit sphere: an octahedron subdivided @levels times.
+     */
+    static void makeSphere(Mesh& mesh, int levels)
+    {
+        const float octahedron[6][3] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+        const int faces[8][3] = { {0, 2, 4}, {2, 1, 4}, {1, 3, 4}, {3, 0, 4}, {2, 0, 5}, {1, 2, 5}, {3, 1, 5}, {0, 3, 5} };
+
+        for (int i = 0; i < 6; ++i)
+        {
+            addVertex(mesh, Vec3f(octahedron[i][0], octahedron[i][1], octahedron[i][2]));
+        }
+
+        std::vector<int>& triangulation = mesh.getTriangulation();
+        triangulation.assign(&faces[0][0], &faces[0][0] + 24);
+
+        for (int level = 0; level < levels; ++level)
+        {
+            std::map<std::pair<int, int>, int> midpoints;
+            std::vector<int> subdivided;
+
+            for (size_t t = 0; t < triangulation.size(); t += 3)
+            {
+                int m[3];
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    int a = triangulation[t + k], b = triangulation[t + (k + 1) % 3];
+                    std::pair<int, int> edge(a < b ? a : b, a < b ? b : a);
+
+                    if (midpoints.find(edge) == midpoints.end())
+                    {
+                        midpoints[edge] = int(mesh.getVertices().size());
+                        addVertex(mesh, mesh.getVertices()[a].pos + mesh.getVertices()[b].pos);
+                    }
+
+                    m[k] = midpoints[edge];
+                }
+
+                int children[12] = { triangulation[t], m[0], m[2], m[0], triangulation[t + 1], m[1],
+                                     m[2], m[1], triangulation[t + 2], m[0], m[1], m[2] };
+                subdivided.insert(subdivided.end(), children, children + 12);
+            }
+
+            triangulation.swap(subdivided);
+        }
+    }
+
+    /**
+     * Sum of the triangle areas, and their vector area (sum of cross products).
+     */
+    static float area(Mesh& mesh, Vec3f& vectorArea)
+    {
+        std::vector<Vertex>& vertices = mesh.getVertices();
+        std::vector<int>& triangulation = mesh.getTriangulation();
+        float sum = 0.0f;
+        vectorArea = Vec3f(0.0f, 0.0f, 0.0f);
+
+        for (size_t t = 0; t < triangulation.size(); t += 3)
+        {
+            const Vec3f& a = vertices[triangulation[t]].pos;
+            Vec3f c = (vertices[triangulation[t + 1]].pos - a).cross(vertices[triangulation[t + 2]].pos - a);
+            sum += 0.5f * c.length();
+            vectorArea += c * 0.5f;
+        }
+
+        return sum;
+    }
+
+    /**
+     * Expect the edges used by one triangle only (the border) to lie on the
+     * plane, i.e. the part has no cracks.
+     */
+    static void expectBorderOnPlane(Mesh& mesh, const Plane& plane)
+    {
+        std::map<std::pair<int, int>, int> edges;
+        std::vector<int>& triangulation = mesh.getTriangulation();
+
+        for (size_t t = 0; t < triangulation.size(); t += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                int a = triangulation[t + k], b = triangulation[t + (k + 1) % 3];
+                ++edges[std::pair<int, int>(a < b ? a : b, a < b ? b : a)];
+            }
+        }
+
+        for (std::map<std::pair<int, int>, int>::iterator it = edges.begin(); it != edges.end(); ++it)
+        {
+            ASSERT_LE(it->second, 2);
+
+            if (it->second == 1)
+            {
+                ASSERT_NEAR(0.0f, plane.getSignedDistance(mesh.getVertices()[it->first.first].pos), 1e-4f);
+                ASSERT_NEAR(0.0f, plane.getSignedDistance(mesh.getVertices()[it->first.second].pos), 1e-4f);
+            }
+        }
+    }
+};
+
+TEST_F(PlaneTest, queries)
+{
+    // z = 2, normal not unit length
+    Plane plane(Vec3f(0.0f, 0.0f, 2.0f), -4.0f);
+
+    Vec3f p = plane.project(Vec3f(1.0f, 2.0f, 7.0f));
+    EXPECT_FLOAT_EQ(1.0f, p.x);
+    EXPECT_FLOAT_EQ(2.0f, p.y);
+    EXPECT_FLOAT_EQ(2.0f, p.z);
+
+    // Rays hit from either side, within (tMin, tMax)
+    float t;
+    Ray down(Vec3f(1.0f, 1.0f, 5.0f), Vec3f(0.0f, 0.0f, -2.0f));
+    EXPECT_TRUE(plane.intersect(down, t));
+    EXPECT_FLOAT_EQ(1.5f, t);
+
+    Ray up(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(0.0f, 0.6f, 0.8f));
+    EXPECT_TRUE(plane.intersect(up, t));
+    EXPECT_FLOAT_EQ(2.5f, t);
+
+    EXPECT_FALSE(plane.intersect(Ray(Vec3f(0.0f, 0.0f, 3.0f), Vec3f(0.0f, 0.0f, 1.0f)), t));
+    EXPECT_FALSE(plane.intersect(Ray(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 0.0f, 0.0f)), t));
+
+    Ray shortRay(Vec3f(1.0f, 1.0f, 5.0f), Vec3f(0.0f, 0.0f, -1.0f));
+    shortRay.tMax = 2.0f;
+    EXPECT_FALSE(plane.intersect(shortRay, t));
+
+    // Plane-plane: x = 1 and z = 2 meet along y
+    Line line;
+    EXPECT_TRUE(plane.intersect(Plane(Vec3f(1.0f, 0.0f, 0.0f), Vec3f(1.0f, 5.0f, 5.0f)), line));
+    EXPECT_NEAR(1.0f, line.point.x, 1e-6f);
+    EXPECT_NEAR(2.0f, line.point.z, 1e-6f);
+    EXPECT_NEAR(0.0f, line.direction.x, 1e-6f);
+    EXPECT_NEAR(0.0f, line.direction.z, 1e-6f);
+
+    EXPECT_FALSE(plane.intersect(Plane(Vec3f(0.0f, 0.0f, -1.0f), 7.0f), line));
+
+    // Random pairs: the line lies on both planes
+    for (int n = 0; n < 200; ++n)
+    {
+        Plane a(randomPoint(1.0f), uniform(-2.0f, 2.0f));
+        Plane b(randomPoint(1.0f), uniform(-2.0f, 2.0f));
+
+        if (a.intersect(b, line))
+        {
+            for (int i = -2; i <= 2; ++i)
+            {
+                ASSERT_NEAR(0.0f, a.getSignedDistance(line.getPoint(float(i))), 1e-3f);
+                ASSERT_NEAR(0.0f, b.getSignedDistance(line.getPoint(float(i))), 1e-3f);
+            }
+        }
+    }
+}
+
+TEST_F(PlaneTest, signedDistances)
+{
+    Plane plane(Vec3f(0.3f, -0.5f, 0.8f), 0.25f);
+
+    // Tightly packed, with a tail
+    std::vector<float> positions(3 * 37);
+
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        positions[i] = uniform(-10.0f, 10.0f);
+    }
+
+    std::vector<float> distances(37);
+    plane.getSignedDistances(&positions[0], 37, 3, &distances[0]);
+
+    for (size_t i = 0; i < distances.size(); ++i)
+    {
+        Vec3f p(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+        ASSERT_NEAR(plane.getSignedDistance(p), distances[i], 1e-5f);
+    }
+
+    // Vertex positions
+    Mesh sphere;
+    makeSphere(sphere, 2);
+    std::vector<Vertex>& vertices = sphere.getVertices();
+    distances.resize(vertices.size());
+    plane.getSignedDistances(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float), &distances[0]);
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        ASSERT_NEAR(plane.getSignedDistance(vertices[i].pos), distances[i], 1e-6f);
+    }
+}
+
+TEST_F(PlaneTest, slice)
+{
+    Mesh sphere;
+    makeSphere(sphere, 4);
+    Vec3f vectorArea;
+    float sphereArea = area(sphere, vectorArea);
+
+    for (int n = 0; n < 20; ++n)
+    {
+        Vec3f normal = randomPoint(1.0f);
+        Plane plane(normal / normal.length(), uniform(-0.8f, 0.8f));
+        Mesh front, back;
+
+        plane.slice(sphere, front, back);
+
+        ASSERT_FALSE(front.getTriangulation().empty());
+        ASSERT_FALSE(back.getTriangulation().empty());
+
+        // Every vertex is on its side; cut ones on the plane with unit normals
+        for (size_t i = 0; i < front.getVertices().size(); ++i)
+        {
+            const Vertex& v = front.getVertices()[i];
+            ASSERT_GE(plane.getSignedDistance(v.pos), -1e-5f);
+            ASSERT_NEAR(1.0f, v.normal.length(), 1e-5f);
+        }
+
+        for (size_t i = 0; i < back.getVertices().size(); ++i)
+        {
+            ASSERT_LE(plane.getSignedDistance(back.getVertices()[i].pos), 1e-5f);
+        }
+
+        // Same surface, same orientation, no cracks
+        Vec3f frontVectorArea, backVectorArea;
+        float frontArea = area(front, frontVectorArea);
+        float backArea = area(back, backVectorArea);
+
+        ASSERT_NEAR(sphereArea, frontArea + backArea, 1e-3f);
+        ASSERT_NEAR(0.0f, (frontVectorArea + backVectorArea).length(), 1e-3f);
+
+        // The front part faces along the normal
+        ASSERT_GT(frontVectorArea * plane.normal, 0.0f);
+
+        expectBorderOnPlane(front, plane);
+        expectBorderOnPlane(back, plane);
+
+        // Clipping keeps the front part, also in place
+        Mesh clipped;
+        plane.clip(sphere, clipped);
+        ASSERT_EQ(front.getTriangulation(), clipped.getTriangulation());
+        ASSERT_EQ(front.getVertices().size(), clipped.getVertices().size());
+
+        Mesh copy = sphere;
+        plane.clip(copy, copy);
+        ASSERT_EQ(front.getTriangulation(), copy.getTriangulation());
+    }
+}
+
+TEST_F(PlaneTest, sliceOneSide)
+{
+    Mesh sphere, front, back;
+    makeSphere(sphere, 1);
+    back = sphere;
+
+    // Entirely in front
+    Plane plane(Vec3f(1.0f, 0.0f, 0.0f), 2.0f);
+    plane.slice(sphere, front, back);
+    EXPECT_EQ(sphere.getTriangulation(), front.getTriangulation());
+    EXPECT_TRUE(back.getVertices().empty());
+    EXPECT_TRUE(back.getTriangulation().empty());
+
+    // Entirely behind
+    Plane(Vec3f(1.0f, 0.0f, 0.0f), -2.0f).slice(sphere, front, back);
+    EXPECT_TRUE(front.getTriangulation().empty());
+    EXPECT_EQ(sphere.getTriangulation(), back.getTriangulation());
+
+    // Through vertices only (the equator): no new vertices
+    Plane(Vec3f(0.0f, 0.0f, 1.0f), 0.0f).slice(sphere, front, back);
+    EXPECT_EQ(sphere.getTriangulation().size(), front.getTriangulation().size() + back.getTriangulation().size());
+    EXPECT_EQ(sphere.getVertices().size() + 8, front.getVertices().size() + back.getVertices().size());
+}
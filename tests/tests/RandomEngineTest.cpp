@@ -0,0 +1,232 @@
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "SplitMix64.h"
+#include "Xoshiro256.h"
+#include "PCG32.h"
+#include "XORShift.h"
+#include "NormalDeviate.h"
+#include "ExpDeviate.h"
+#include "Mother.h"
+
+using namespace nut;
+
+class RandomEngineTest : public ::testing::Test
+{
+    protected:
+    
+    // virtual void SetUp() will be called before each test is run.  You
+    // should define it if you need to initialize the varaibles.
+    // Otherwise, this can be skipped.
+    virtual void SetUp()
+    {
+    }
+};
+
+
+
+TEST_F(RandomEngineTest, splitMix64)
+{
+    // Reference output of splitmix64.c seeded with zero
+    SplitMix64 sm(0);
+
+    EXPECT_TRUE(sm.next() == 0xE220A8397B1DCDAFULL);
+    EXPECT_TRUE(sm.next() == 0x6E789E6AA1B965F4ULL);
+    EXPECT_TRUE(sm.next() == 0x06C45D188009454FULL);
+}
+
+
+
+TEST_F(RandomEngineTest, xoshiro256)
+{
+    const U64 state[4] = { 1, 2, 3, 4 };
+
+    Xoshiro256 rng;
+    rng.setState(state);
+
+    // rotl(2 * 5, 7) * 9
+    EXPECT_TRUE(rng.next() == 11520ULL);
+    // rotl(((2 ^ 3) ^ 1) * 5, 7) * 9 after one step
+    EXPECT_TRUE(rng.next() == 0ULL);
+
+    // Floats are in [0, 1)
+    for (int i = 0; i < 10000; ++i)
+    {
+        float f = rng.nextFloat();
+        EXPECT_TRUE(f >= 0.0f && f < 1.0f);
+    }
+}
+
+
+
+TEST_F(RandomEngineTest, xoshiro256Jump)
+{
+    Xoshiro256 a(42);
+    Xoshiro256 b(a);
+
+    b.jump();
+
+    // Jumped stream must differ from the original
+    int equal = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        equal += a.next() == b.next() ? 1 : 0;
+    }
+    EXPECT_EQ(0, equal);
+
+    // Jumping is deterministic
+    Xoshiro256 c(42), d(42);
+    c.longJump();
+    d.longJump();
+    EXPECT_TRUE(c.next() == d.next());
+}
+
+
+
+TEST_F(RandomEngineTest, pcg32)
+{
+    // Reference output of pcg32-demo seeded with (42, 54)
+    PCG32 rng(42u, 54u);
+
+    EXPECT_TRUE(rng.next() == 0xA15C02B7u);
+    EXPECT_TRUE(rng.next() == 0x7B47F409u);
+    EXPECT_TRUE(rng.next() == 0xBA1D3330u);
+    EXPECT_TRUE(rng.next() == 0x83D2F293u);
+    EXPECT_TRUE(rng.next() == 0xBFA4784Bu);
+    EXPECT_TRUE(rng.next() == 0xCBED606Eu);
+
+    for (int i = 0; i < 10000; ++i)
+    {
+        EXPECT_TRUE(rng.nextBounded(7) < 7u);
+    }
+}
+
+
+
+TEST_F(RandomEngineTest, pcg32Advance)
+{
+    PCG32 a(7u, 3u), b(7u, 3u);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        a.next();
+    }
+
+    b.advance(1000);
+    EXPECT_TRUE(a.next() == b.next());
+
+    // Moving backwards restores the previous values
+    U32 value = b.next();
+    b.advance(~U64(0));
+    EXPECT_TRUE(b.next() == value);
+}
+
+
+
+TEST_F(RandomEngineTest, standardDistributions)
+{
+    Xoshiro256 xoshiro(11);
+    PCG32 pcg(11u, 5u);
+
+    std::uniform_int_distribution<int> digit(0, 9);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        int a = digit(xoshiro);
+        int b = digit(pcg);
+        EXPECT_TRUE(a >= 0 && a <= 9);
+        EXPECT_TRUE(b >= 0 && b <= 9);
+
+        double x = unit(xoshiro);
+        double y = unit(pcg);
+        EXPECT_TRUE(x >= 0.0 && x < 1.0);
+        EXPECT_TRUE(y >= 0.0 && y < 1.0);
+    }
+}
+
+
+
+TEST_F(RandomEngineTest, deviatesPerInstance)
+{
+    NormalDeviate n1, n2;
+    ExpDeviate e1, e2;
+    Mother m1(5), m2(5);
+
+    // Same seeds produce the same sequences regardless of interleaving
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_FLOAT_EQ(n1.next(), n2.next());
+        EXPECT_FLOAT_EQ(e1.next(), e2.next());
+        EXPECT_FLOAT_EQ(m1.next(), m2.next());
+    }
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_TRUE(e1.next() > 0.0f);
+
+        float m = m1.next();
+        EXPECT_TRUE(m >= 0.0f && m <= 1.0f);
+    }
+}
+
+
+
+TEST_F(RandomEngineTest, staticInterfacePerThread)
+{
+    XORShift::srand(1, 2, 3, 4);
+    unsigned long first = XORShift::rand();
+
+    // A new thread gets its own seed and doesn't disturb this one
+    unsigned long other = 0;
+    std::thread t([&other]() { other = XORShift::rand(); });
+    t.join();
+
+    XORShift local(1, 2, 3, 4);
+    EXPECT_TRUE(first == local.next());
+    EXPECT_TRUE(XORShift::rand() == local.next());
+    EXPECT_TRUE(other != first);
+}
+
+
+
+TEST_F(RandomEngineTest, staticInterfaceThreadsDiffer)
+{
+    const int n = 64;
+    std::vector< unsigned long > a(n), b(n);
+    std::vector< float > na(n), nb(n), ea(n), eb(n), ma(n), mb(n);
+
+    // Both threads run after srand(), so both reseed from the new base seed
+    XORShift::srand(5, 6, 7, 8);
+    NormalDeviate::srand(5, 6, 7, 8);
+    ExpDeviate::srand(5, 6, 7, 8);
+    Mother::srand(5);
+
+    auto draw = [n](std::vector< unsigned long >& x, std::vector< float >& normal,
+                    std::vector< float >& exponential, std::vector< float >& mother)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            x[i] = XORShift::rand();
+            normal[i] = NormalDeviate::rand();
+            exponential[i] = ExpDeviate::rand();
+            mother[i] = Mother::rand();
+        }
+    };
+
+    std::thread t1(draw, std::ref(a), std::ref(na), std::ref(ea), std::ref(ma));
+    std::thread t2(draw, std::ref(b), std::ref(nb), std::ref(eb), std::ref(mb));
+    t1.join();
+    t2.join();
+
+    EXPECT_TRUE(a != b);
+    EXPECT_TRUE(na != nb);
+    EXPECT_TRUE(ea != eb);
+    EXPECT_TRUE(ma != mb);
+
+    // Neither thread repeats the calling thread's sequence
+    XORShift local(5, 6, 7, 8);
+    EXPECT_TRUE(a[0] != local.next());
+}
@@ -0,0 +1,94 @@
+#include <cmath>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "Ray.h"
+
+using namespace nut;
+
+class RayTest : public RandomTest
+{
+};
+
+TEST_F(RayTest, inverseDirection)
+{
+    Ray ray(Vec3f(1.0f, 2.0f, 3.0f), Vec3f(2.0f, -4.0f, 0.0f));
+
+    EXPECT_FLOAT_EQ(0.5f, ray.invDirection.x);
+    EXPECT_FLOAT_EQ(-0.25f, ray.invDirection.y);
+    EXPECT_TRUE(std::isinf(ray.invDirection.z));
+    EXPECT_FLOAT_EQ(0.0f, ray.tMin);
+
+    Vec3f p = ray.getPoint(0.5f);
+    EXPECT_FLOAT_EQ(2.0f, p.x);
+    EXPECT_FLOAT_EQ(0.0f, p.y);
+    EXPECT_FLOAT_EQ(3.0f, p.z);
+}
+
+TEST_F(RayTest, triangle)
+{
+    Vec3f v0(0.0f, 0.0f, 5.0f), v1(1.0f, 0.0f, 5.0f), v2(0.0f, 1.0f, 5.0f);
+    float t, u, v;
+
+    // Hit from both sides
+    Ray ray(Vec3f(0.25f, 0.5f, 0.0f), Vec3f(0.0f, 0.0f, 2.0f));
+    ASSERT_TRUE(ray.intersect(v0, v1, v2, t, u, v));
+    EXPECT_FLOAT_EQ(2.5f, t);
+    EXPECT_FLOAT_EQ(0.25f, u);
+    EXPECT_FLOAT_EQ(0.5f, v);
+
+    Ray back(Vec3f(0.25f, 0.25f, 10.0f), Vec3f(0.0f, 0.0f, -1.0f));
+    EXPECT_TRUE(back.intersect(v0, v1, v2, t, u, v));
+
+    // Outside the triangle, parallel, behind and beyond the interval
+    EXPECT_FALSE(Ray(Vec3f(0.75f, 0.75f, 0.0f), Vec3f(0.0f, 0.0f, 1.0f)).intersect(v0, v1, v2, t, u, v));
+    EXPECT_FALSE(Ray(Vec3f(0.25f, 0.25f, 5.0f), Vec3f(1.0f, 0.0f, 0.0f)).intersect(v0, v1, v2, t, u, v));
+    EXPECT_FALSE(Ray(Vec3f(0.25f, 0.25f, 6.0f), Vec3f(0.0f, 0.0f, 1.0f)).intersect(v0, v1, v2, t, u, v));
+    EXPECT_FALSE(Ray(Vec3f(0.25f, 0.25f, 0.0f), Vec3f(0.0f, 0.0f, 1.0f), 0.0f, 4.0f).intersect(v0, v1, v2, t, u, v));
+
+    // Degenerate triangle
+    EXPECT_FALSE(ray.intersect(v0, v0, v2, t, u, v));
+}
+
+TEST_F(RayTest, pack)
+{
+    const int width = SIMDFloat::WIDTH;
+
+    for (int iteration = 0; iteration < 200; ++iteration)
+    {
+        Vec3f vertices[SIMDFloat::WIDTH][3];
+        TrianglePack pack;
+
+        // Large triangles around the origin so a good share of rays hit
+        for (int i = 0; i < width - 1; ++i)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                vertices[i][k] = randomPoint(4.0f);
+            }
+
+            pack.set(i, vertices[i][0], vertices[i][1], vertices[i][2]);
+        }
+
+        // The last lane keeps the degenerate triangle of the constructor
+        Ray ray(randomPoint(8.0f), randomPoint(1.0f), 0.0f, uniform(1.0f, 20.0f));
+        SIMDFloat t, u, v;
+        int bits = ray.intersect(pack, t, u, v);
+
+        EXPECT_EQ(0, bits >> (width - 1));
+
+        for (int i = 0; i < width - 1; ++i)
+        {
+            float ts, us, vs;
+            bool hit = ray.intersect(vertices[i][0], vertices[i][1], vertices[i][2], ts, us, vs);
+
+            ASSERT_EQ(hit, (bits >> i & 1) != 0);
+
+            if (hit)
+            {
+                EXPECT_NEAR(ts, t.lane(i), 1e-4f * ts);
+                EXPECT_NEAR(us, u.lane(i), 1e-4f);
+                EXPECT_NEAR(vs, v.lane(i), 1e-4f);
+            }
+        }
+    }
+}
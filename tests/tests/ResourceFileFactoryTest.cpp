@@ -0,0 +1,282 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "IResourceFile.h"
+#include "Mesh.h"
+#include "NutResourceFile.h"
+#include "ResourceFileFactory.h"
+
+using namespace nut;
+
+class ResourceFileFactoryTest : public ::testing::Test
+{
+    protected:
+
+    // File type whose loads block until the gate is opened, recording their order
+    class GatedResourceFile : public IResourceFile
+    {
+        public:
+
+        size_t getNumberOfResources() const
+        {
+            return 1;
+        }
+
+        size_t getMemoryUsage() const
+        {
+            return 0;
+        }
+    };
+
+    static std::mutex gateMutex;
+    static std::condition_variable gateOpened;
+    static bool gateOpen;
+    static std::vector<std::string> loadOrder;
+
+    static IResourceFile* createGated(const std::string& path)
+    {
+        std::unique_lock<std::mutex> lock(gateMutex);
+        loadOrder.push_back(path);
+        gateOpened.wait(lock, []() { return gateOpen; });
+
+        return new GatedResourceFile();
+    }
+
+    static void openGate()
+    {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        gateOpen = true;
+        gateOpened.notify_all();
+    }
+
+    ResourceFileFactory& factory = ResourceFileFactory::getInstance();
+    std::vector<std::string> paths;
+
+    virtual void SetUp()
+    {
+        factory.registerResourceFile(ResourceFileId::nut, NutResourceFile::createMe);
+        gateOpen = false;
+        loadOrder.clear();
+    }
+
+    virtual void TearDown()
+    {
+        factory.registerResourceFile(ResourceFileId::nut, NutResourceFile::createMe);
+
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            std::remove(paths[i].c_str());
+        }
+    }
+
+    // Cooked file with @meshes quads
+    std::string cook(const std::string& name, size_t meshes)
+    {
+        std::vector<Mesh> quads(meshes);
+
+        for (size_t m = 0; m < meshes; ++m)
+        {
+            const int triangles[6] = { 0, 1, 2, 0, 2, 3 };
+
+            for (int i = 0; i < 4; ++i)
+            {
+                Vertex v;
+                v.pos = Vec3f(float(i & 1), float(i >> 1), float(m));
+                quads[m].getVertices().push_back(v);
+            }
+
+            quads[m].getTriangulation().assign(triangles, triangles + 6);
+        }
+
+        std::string path = ::testing::TempDir() + name;
+        EXPECT_TRUE(NutResourceFile::write(path, quads));
+        paths.push_back(path);
+
+        return path;
+    }
+
+    static void waitForStatus(const LoadHandle& handle, LoadStatus status)
+    {
+        while (handle.getStatus() != status)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+std::mutex ResourceFileFactoryTest::gateMutex;
+std::condition_variable ResourceFileFactoryTest::gateOpened;
+bool ResourceFileFactoryTest::gateOpen = false;
+std::vector<std::string> ResourceFileFactoryTest::loadOrder;
+
+
+
+TEST_F(ResourceFileFactoryTest, loadAsync)
+{
+    factory.setNumberOfLoaderThreads(4);
+    EXPECT_EQ(4u, factory.getNumberOfLoaderThreads());
+
+    std::vector<std::string> files;
+    std::vector<LoadHandle> handles;
+
+    for (size_t i = 0; i < 32; ++i)
+    {
+        files.push_back(cook("ResourceFileFactoryTest" + std::to_string(i) + ".nut", 1 + i % 3));
+    }
+
+    // Callbacks on this thread
+    std::thread::id caller = std::this_thread::get_id();
+    std::vector<std::string> delivered;
+    bool sameThread = true;
+
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        handles.push_back(factory.loadAsync(files[i], 0,
+            [&](const std::string& path, const std::shared_ptr<IResourceFile>& file)
+            {
+                sameThread = sameThread && std::this_thread::get_id() == caller && file != nullptr;
+                delivered.push_back(path);
+            }));
+    }
+
+    for (size_t i = 0; i < handles.size(); ++i)
+    {
+        std::shared_ptr<IResourceFile> file = handles[i].wait();
+
+        ASSERT_TRUE(file != nullptr);
+        EXPECT_EQ(LoadStatus::Done, handles[i].getStatus());
+        EXPECT_EQ(1 + i % 3, file->getNumberOfResources());
+        EXPECT_EQ(file, handles[i].get());
+        EXPECT_FALSE(handles[i].cancel());
+    }
+
+    EXPECT_TRUE(delivered.empty());
+    EXPECT_EQ(files.size(), factory.dispatchCallbacks());
+    EXPECT_EQ(files.size(), delivered.size());
+    EXPECT_TRUE(sameThread);
+    EXPECT_EQ(0u, factory.dispatchCallbacks());
+
+    // Failures are reported too
+    LoadHandle missing = factory.loadAsync(::testing::TempDir() + "ResourceFileFactoryTestMissing.nut");
+    LoadHandle unknown = factory.loadAsync("ResourceFileFactoryTest.unknown");
+
+    EXPECT_TRUE(missing.wait() == nullptr);
+    EXPECT_TRUE(unknown.wait() == nullptr);
+    EXPECT_EQ(LoadStatus::Failed, missing.getStatus());
+    EXPECT_EQ(LoadStatus::Failed, unknown.getStatus());
+}
+
+
+
+TEST_F(ResourceFileFactoryTest, loaderThreadCallback)
+{
+    std::string path = cook("ResourceFileFactoryTest.nut", 2);
+    std::thread::id caller = std::this_thread::get_id();
+    std::thread::id loader = caller;
+    size_t resources = 0;
+
+    LoadHandle handle = factory.loadAsync(path, 0,
+        [&](const std::string&, const std::shared_ptr<IResourceFile>& file)
+        {
+            loader = std::this_thread::get_id();
+            resources = file->getNumberOfResources();
+        }, CallbackThread::Loader);
+
+    // The callback has returned once the load is finished
+    ASSERT_TRUE(handle.wait() != nullptr);
+    EXPECT_NE(caller, loader);
+    EXPECT_EQ(2u, resources);
+    EXPECT_EQ(0u, factory.dispatchCallbacks());
+}
+
+
+
+TEST_F(ResourceFileFactoryTest, cancelDuringLoaderCallback)
+{
+    std::string path = cook("ResourceFileFactoryTest.nut", 1);
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool entered = false, released = false;
+
+    LoadHandle handle = factory.loadAsync(path, 0,
+        [&](const std::string&, const std::shared_ptr<IResourceFile>&)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            entered = true;
+            changed.notify_all();
+            changed.wait(lock, [&]() { return released; });
+        }, CallbackThread::Loader);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&]() { return entered; });
+    }
+
+    // The callback already has the file: too late to cancel
+    EXPECT_EQ(LoadStatus::Loading, handle.getStatus());
+    EXPECT_FALSE(handle.cancel());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        changed.notify_all();
+    }
+
+    EXPECT_TRUE(handle.wait() != nullptr);
+    EXPECT_EQ(LoadStatus::Done, handle.getStatus());
+}
+
+
+
+TEST_F(ResourceFileFactoryTest, prioritiesAndCancellation)
+{
+    factory.setNumberOfLoaderThreads(1);
+    factory.registerResourceFile(ResourceFileId::nut, createGated);
+
+    // Keep the only loader busy while the queue fills up
+    bool called = false;
+    LoadHandle gate = factory.loadAsync("gate.nut", 0,
+        [&](const std::string&, const std::shared_ptr<IResourceFile>&) { called = true; });
+    waitForStatus(gate, LoadStatus::Loading);
+
+    LoadHandle low = factory.loadAsync("low.nut", -1);
+    LoadHandle first = factory.loadAsync("first.nut", 5);
+    LoadHandle high = factory.loadAsync("high.nut", 10);
+    LoadHandle dropped = factory.loadAsync("dropped.nut", 7);
+    LoadHandle second = factory.loadAsync("second.nut", 5);
+
+    EXPECT_EQ(LoadStatus::Queued, low.getStatus());
+    EXPECT_EQ(5u, factory.getNumberOfQueuedLoads());
+
+    EXPECT_TRUE(dropped.cancel());
+    EXPECT_EQ(LoadStatus::Cancelled, dropped.getStatus());
+    EXPECT_TRUE(dropped.wait() == nullptr);
+    EXPECT_EQ(4u, factory.getNumberOfQueuedLoads());
+
+    // A running load finishes, but is dropped
+    EXPECT_TRUE(gate.cancel());
+    openGate();
+
+    EXPECT_TRUE(gate.wait() == nullptr);
+    EXPECT_EQ(LoadStatus::Cancelled, gate.getStatus());
+    EXPECT_TRUE(low.wait() != nullptr);
+    EXPECT_TRUE(high.isFinished() && first.isFinished() && second.isFinished());
+    EXPECT_FALSE(low.cancel());
+
+    factory.dispatchCallbacks();
+    EXPECT_FALSE(called);
+
+    const char* expected[] = { "gate.nut", "high.nut", "first.nut", "second.nut", "low.nut" };
+    ASSERT_EQ(5u, loadOrder.size());
+
+    for (size_t i = 0; i < 5; ++i)
+    {
+        EXPECT_EQ(expected[i], loadOrder[i]);
+    }
+}
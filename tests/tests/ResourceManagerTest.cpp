@@ -0,0 +1,229 @@
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "IResourceFile.h"
+#include "Mesh.h"
+#include "NutResourceFile.h"
+#include "ResourceFileFactory.h"
+#include "ResourceManager.h"
+
+using namespace nut;
+
+class ResourceManagerTest : public ::testing::Test
+{
+    protected:
+
+    std::vector<std::string> paths;
+
+    virtual void SetUp()
+    {
+        ResourceFileFactory::getInstance().registerResourceFile(ResourceFileId::nut, NutResourceFile::createMe);
+    }
+
+    virtual void TearDown()
+    {
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            std::remove(paths[i].c_str());
+        }
+    }
+
+    // Cooked file with one grid mesh of @size x @size vertices
+    std::string cook(const std::string& name, int size)
+    {
+        std::vector<Mesh> meshes(1);
+
+        for (int i = 0; i < size * size; ++i)
+        {
+            Vertex v;
+            v.pos = Vec3f(float(i % size), float(i / size), 0.0f);
+            meshes[0].getVertices().push_back(v);
+        }
+
+        for (int i = 0; i + size + 1 < size * size; ++i)
+        {
+            const int triangles[6] = { i, i + 1, i + size, i + 1, i + size + 1, i + size };
+            meshes[0].getTriangulation().insert(meshes[0].getTriangulation().end(), triangles, triangles + 6);
+        }
+
+        std::string path = ::testing::TempDir() + name;
+        EXPECT_TRUE(NutResourceFile::write(path, meshes));
+        paths.push_back(path);
+
+        return path;
+    }
+};
+
+
+
+TEST_F(ResourceManagerTest, deduplication)
+{
+    std::string path = cook("ResourceManagerTest.nut", 16);
+    std::string directory = ::testing::TempDir();
+    ResourceManager manager;
+
+    ResourceHandle a = manager.acquire(path);
+    ResourceHandle b = manager.acquire(directory + "./ResourceManagerTest.nut");
+    ResourceHandle c = manager.acquire(directory + "/ResourceManagerTest.nut");
+
+    ASSERT_TRUE(a.isValid());
+    ASSERT_TRUE(a.get() != nullptr);
+    EXPECT_TRUE(a.isReady());
+    EXPECT_EQ(a.get(), b.get());
+    EXPECT_EQ(a.get(), c.get());
+    EXPECT_EQ(a.getPath(), b.getPath());
+
+    ResourceManager::Statistics statistics = manager.getStatistics();
+    EXPECT_EQ(2u, statistics.hits);
+    EXPECT_EQ(1u, statistics.misses);
+    EXPECT_EQ(1u, statistics.resources);
+    EXPECT_EQ(a.get()->getMemoryUsage(), statistics.memoryUsage);
+
+    manager.resetStatistics();
+    EXPECT_EQ(0u, manager.getStatistics().hits);
+    EXPECT_EQ(0u, manager.getStatistics().misses);
+}
+
+
+
+TEST_F(ResourceManagerTest, evictsLeastRecentlyUsed)
+{
+    std::string a = cook("ResourceManagerTestA.nut", 32);
+    std::string b = cook("ResourceManagerTestB.nut", 32);
+    std::string c = cook("ResourceManagerTestC.nut", 32);
+    ResourceManager manager;
+
+    ResourceHandle handleA = manager.acquire(a);
+    ResourceHandle handleB = manager.acquire(b);
+    ResourceHandle handleC = manager.acquire(c);
+    size_t size = handleA.get()->getMemoryUsage();
+    IResourceFile* fileA = handleA.get();
+
+    // Referenced files are kept over the budget
+    manager.setMemoryBudget(size * 5 / 2);
+    EXPECT_EQ(3u, manager.getStatistics().resources);
+    EXPECT_EQ(0u, manager.getStatistics().evictions);
+
+    handleA = ResourceHandle();
+    handleB = ResourceHandle();
+    handleC = ResourceHandle();
+
+    // A is now the most recent, B the least
+    handleA = manager.acquire(a);
+    EXPECT_EQ(fileA, handleA.get());
+    handleA = ResourceHandle();
+    manager.update();
+
+    ResourceManager::Statistics statistics = manager.getStatistics();
+    EXPECT_EQ(1u, statistics.evictions);
+    EXPECT_EQ(2u, statistics.resources);
+    EXPECT_EQ(2 * size, statistics.memoryUsage);
+
+    // B is loaded again, which evicts C
+    handleB = manager.acquire(b);
+    statistics = manager.getStatistics();
+    EXPECT_EQ(2u, statistics.evictions);
+    EXPECT_EQ(4u, statistics.misses);
+    EXPECT_EQ(1u, statistics.hits);
+
+    handleA = manager.acquire(a);
+    handleC = manager.acquire(c);
+    statistics = manager.getStatistics();
+    EXPECT_EQ(2u, statistics.hits);
+    EXPECT_EQ(5u, statistics.misses);
+    EXPECT_EQ(3 * size, statistics.memoryUsage);
+
+    // Nothing referenced: down to the budget
+    handleA = ResourceHandle();
+    handleB = ResourceHandle();
+    handleC = ResourceHandle();
+    manager.setMemoryBudget(0);
+    EXPECT_EQ(0u, manager.getStatistics().resources);
+    EXPECT_EQ(0u, manager.getStatistics().memoryUsage);
+}
+
+
+
+TEST_F(ResourceManagerTest, acquireAsync)
+{
+    std::string path = cook("ResourceManagerTestAsync.nut", 64);
+    ResourceManager manager;
+
+    ResourceHandle a = manager.acquireAsync(path, 1);
+    ResourceHandle b = manager.acquireAsync(path);
+
+    ASSERT_TRUE(a.wait() != nullptr);
+    EXPECT_EQ(a.get(), b.get());
+    EXPECT_TRUE(b.isReady());
+
+    manager.update();
+    ResourceManager::Statistics statistics = manager.getStatistics();
+    EXPECT_EQ(1u, statistics.misses);
+    EXPECT_EQ(1u, statistics.hits);
+    EXPECT_EQ(a.get()->getMemoryUsage(), statistics.memoryUsage);
+
+    // Failed loads aren't cached
+    std::string missing = ::testing::TempDir() + "ResourceManagerTestMissing.nut";
+    ResourceHandle c = manager.acquireAsync(missing);
+
+    EXPECT_TRUE(c.wait() == nullptr);
+    EXPECT_TRUE(c.isReady());
+    manager.update();
+    EXPECT_EQ(1u, manager.getStatistics().resources);
+    EXPECT_TRUE(manager.acquire(missing).get() == nullptr);
+    EXPECT_EQ(3u, manager.getStatistics().misses);
+}
+
+
+
+TEST_F(ResourceManagerTest, concurrentAcquire)
+{
+    std::vector<std::string> files;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        files.push_back(cook("ResourceManagerTestConcurrent" + std::to_string(i) + ".nut", 48));
+    }
+
+    ResourceManager manager;
+    std::vector<std::thread> threads;
+    std::vector< std::vector<IResourceFile*> > found(8, std::vector<IResourceFile*>(files.size(), nullptr));
+
+    for (size_t t = 0; t < found.size(); ++t)
+    {
+        threads.push_back(std::thread([&, t]()
+        {
+            for (int round = 0; round < 50; ++round)
+            {
+                for (size_t i = 0; i < files.size(); ++i)
+                {
+                    size_t f = (i + t) % files.size();
+                    ResourceHandle handle = (t + round) % 2 == 0 ? manager.acquire(files[f])
+                                                                 : manager.acquireAsync(files[f]);
+                    found[t][f] = handle.wait();
+                }
+            }
+        }));
+    }
+
+    for (size_t t = 0; t < threads.size(); ++t)
+    {
+        threads[t].join();
+    }
+
+    // Each file was loaded once
+    ResourceManager::Statistics statistics = manager.getStatistics();
+    EXPECT_EQ(files.size(), statistics.misses);
+    EXPECT_EQ(found.size() * 50 * files.size() - files.size(), statistics.hits);
+
+    for (size_t t = 0; t < found.size(); ++t)
+    {
+        for (size_t f = 0; f < files.size(); ++f)
+        {
+            ASSERT_TRUE(found[t][f] != nullptr);
+            EXPECT_EQ(found[0][f], found[t][f]);
+        }
+    }
+}
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "SIMDRandom.h"
+#include "NormalDeviate.h"
+#include "ExpDeviate.h"
+#include "XORShift.h"
+
+using namespace nut;
+
+class SIMDRandomTest : public ::testing::Test
+{
+    protected:
+
+    static const size_t N = 1000000;
+
+    std::vector<float> values;
+
+    // virtual void SetUp() will be called before each test is run.  You
+    // should define it if you need to initialize the varaibles.
+    // Otherwise, this can be skipped.
+    virtual void SetUp()
+    {
+        values.resize(N);
+    }
+
+    static void meanAndVariance(const std::vector<float>& v, double& mean, double& variance)
+    {
+        double sum = 0.0, sum2 = 0.0;
+
+        for (size_t i = 0; i < v.size(); ++i)
+        {
+            sum += v[i];
+            sum2 += double(v[i]) * v[i];
+        }
+
+        mean = sum / v.size();
+        variance = sum2 / v.size() - mean * mean;
+    }
+
+    /**
+     * Kolmogorov-Smirnov statistic of @v against the distribution function @cdf.
+     */
+    template<class CDF> static double kolmogorovSmirnov(std::vector<float> v, CDF cdf)
+    {
+        std::sort(v.begin(), v.end());
+
+        double d = 0.0;
+        double n = double(v.size());
+
+        for (size_t i = 0; i < v.size(); ++i)
+        {
+            double f = cdf(v[i]);
+            d = std::max(d, std::max(f - i / n, (i + 1) / n - f));
+        }
+
+        return d;
+    }
+
+    static double normalCDF(double x)
+    {
+        return 0.5 * std::erfc(-x / std::sqrt(2.0));
+    }
+
+    static double exponentialCDF(double x)
+    {
+        return x < 0.0 ? 0.0 : 1.0 - std::exp(-x);
+    }
+
+    // Critical value of the KS statistic for a significance level of 0.001
+    static double ksCritical(size_t n)
+    {
+        return 1.95 / std::sqrt(double(n));
+    }
+};
+
+
+
+TEST_F(SIMDRandomTest, uniform)
+{
+    SIMDRandom rng(1234);
+    rng.fillUniform(&values[0], N);
+
+    double mean, variance;
+    meanAndVariance(values, mean, variance);
+
+    EXPECT_NEAR(0.5, mean, 0.002);
+    EXPECT_NEAR(1.0 / 12.0, variance, 0.001);
+
+    // Chi-squared test over 100 bins (99 degrees of freedom, critical value
+    // for a significance level of 0.001 is 148.2)
+    std::vector<int> bins(100, 0);
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        ASSERT_TRUE(values[i] >= 0.0f && values[i] < 1.0f);
+        bins[int(values[i] * 100.0f)]++;
+    }
+
+    double expected = double(N) / 100.0;
+    double chi2 = 0.0;
+
+    for (size_t i = 0; i < bins.size(); ++i)
+    {
+        chi2 += (bins[i] - expected) * (bins[i] - expected) / expected;
+    }
+
+    EXPECT_LT(chi2, 148.2);
+
+    // Custom range
+    rng.fillUniform(&values[0], 1000, -3.0f, 5.0f);
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        EXPECT_TRUE(values[i] >= -3.0f && values[i] < 5.0f);
+    }
+}
+
+
+
+TEST_F(SIMDRandomTest, normal)
+{
+    SIMDRandom rng(99);
+    rng.fillNormal(&values[0], N);
+
+    double mean, variance;
+    meanAndVariance(values, mean, variance);
+
+    EXPECT_NEAR(0.0, mean, 0.005);
+    EXPECT_NEAR(1.0, variance, 0.005);
+    EXPECT_LT(kolmogorovSmirnov(values, normalCDF), ksCritical(N));
+
+    // Tails must be present: P(|x| > 3) = 0.0027
+    size_t tail = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        tail += std::fabs(values[i]) > 3.0f ? 1 : 0;
+    }
+    EXPECT_NEAR(0.0027, double(tail) / N, 0.0005);
+
+    // Scaled deviates
+    rng.fillNormal(&values[0], N, 10.0f, 2.0f);
+    meanAndVariance(values, mean, variance);
+
+    EXPECT_NEAR(10.0, mean, 0.01);
+    EXPECT_NEAR(4.0, variance, 0.02);
+}
+
+
+
+TEST_F(SIMDRandomTest, exponential)
+{
+    SIMDRandom rng(7);
+    rng.fillExponential(&values[0], N);
+
+    double mean, variance;
+    meanAndVariance(values, mean, variance);
+
+    EXPECT_NEAR(1.0, mean, 0.005);
+    EXPECT_NEAR(1.0, variance, 0.01);
+    EXPECT_LT(kolmogorovSmirnov(values, exponentialCDF), ksCritical(N));
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        ASSERT_TRUE(values[i] >= 0.0f);
+    }
+
+    rng.fillExponential(&values[0], N, 4.0f);
+    meanAndVariance(values, mean, variance);
+
+    EXPECT_NEAR(0.25, mean, 0.002);
+}
+
+
+
+TEST_F(SIMDRandomTest, scalarDeviates)
+{
+    NormalDeviate normal;
+    ExpDeviate exponential;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        values[i] = normal.next();
+    }
+    EXPECT_LT(kolmogorovSmirnov(values, normalCDF), ksCritical(N));
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        values[i] = exponential.next();
+    }
+    EXPECT_LT(kolmogorovSmirnov(values, exponentialCDF), ksCritical(N));
+}
+
+
+
+TEST_F(SIMDRandomTest, partialFillAndStreams)
+{
+    SIMDRandom a(5), b(5);
+
+    // Sizes that aren't a multiple of the lane count
+    std::vector<float> x(13), y(13);
+    a.fillNormal(&x[0], 13);
+    b.fillNormal(&y[0], 13);
+
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+        EXPECT_FLOAT_EQ(x[i], y[i]);
+    }
+
+    // A jumped copy produces a different stream
+    SIMDRandom c(a);
+    c.jump();
+
+    std::vector<U32> u(64), v(64);
+    a.fillBits(&u[0], u.size());
+    c.fillBits(&v[0], v.size());
+
+    int equal = 0;
+    for (size_t i = 0; i < u.size(); ++i)
+    {
+        equal += u[i] == v[i] ? 1 : 0;
+    }
+    EXPECT_EQ(0, equal);
+}
+
+
+
+TEST_F(SIMDRandomTest, throughput)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    SIMDRandom rng;
+    NormalDeviate normal;
+    ExpDeviate exponential;
+    volatile float sink = 0.0f;
+
+    auto report = [](const char* name, Clock::duration elapsed)
+    {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        std::cout << "[ BENCH    ] " << name << ": " << (N / seconds) / 1e6 << " M numbers/s" << std::endl;
+    };
+
+    Clock::time_point start = Clock::now();
+    rng.fillUniform(&values[0], N);
+    report("SIMDRandom::fillUniform", Clock::now() - start);
+
+    start = Clock::now();
+    rng.fillNormal(&values[0], N);
+    report("SIMDRandom::fillNormal", Clock::now() - start);
+
+    start = Clock::now();
+    rng.fillExponential(&values[0], N);
+    report("SIMDRandom::fillExponential", Clock::now() - start);
+
+    start = Clock::now();
+    for (size_t i = 0; i < N; ++i) values[i] = XORShift::rand() * (1.0f / 4294967296.0f);
+    report("XORShift::rand", Clock::now() - start);
+
+    start = Clock::now();
+    for (size_t i = 0; i < N; ++i) values[i] = normal.next();
+    report("NormalDeviate::next", Clock::now() - start);
+
+    start = Clock::now();
+    for (size_t i = 0; i < N; ++i) values[i] = exponential.next();
+    report("ExpDeviate::next", Clock::now() - start);
+
+    sink = values[N / 2];
+    (void)sink;
+}
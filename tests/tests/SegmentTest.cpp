@@ -0,0 +1,265 @@
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "Segment.h"
+
+using namespace nut;
+
+class SegmentTest : public RandomTest
+{
+    protected:
+
+    /**
+     * Random segment, sometimes degenerate or parallel to @other.
+     */
+    Segment randomSegment(const Segment& other)
+    {
+        Vec3f a = randomPoint(2.0f);
+        float kind = rng.nextFloat();
+
+        if (kind < 0.1f)
+        {
+            return Segment(a, a);
+        }
+        else if (kind < 0.2f)
+        {
+            return Segment(a, a + other.getDirection() * uniform(-2.0f, 2.0f));
+        }
+
+        return Segment(a, randomPoint(2.0f));
+    }
+
+    static float squaredDistance(const Vec3f& a, const Vec3f& b)
+    {
+        return (a - b) * (a - b);
+    }
+};
+
+TEST_F(SegmentTest, basics)
+{
+    Segment s(Vec3f(1.0f, 0.0f, 0.0f), Vec3f(3.0f, 0.0f, 0.0f));
+
+    EXPECT_FLOAT_EQ(2.0f, s.getLength());
+    EXPECT_FLOAT_EQ(2.0f, s.getCenter().x);
+    EXPECT_FLOAT_EQ(2.5f, s.getPoint(0.75f).x);
+
+    float t;
+    EXPECT_FLOAT_EQ(4.0f, s.closestPoint(Vec3f(2.5f, 2.0f, 0.0f), t));
+    EXPECT_FLOAT_EQ(0.75f, t);
+    EXPECT_FLOAT_EQ(5.0f, s.closestPoint(Vec3f(0.0f, 0.0f, 2.0f), t));
+    EXPECT_EQ(0.0f, t);
+    EXPECT_FLOAT_EQ(1.0f, s.closestPoint(Vec3f(4.0f, 0.0f, 0.0f), t));
+    EXPECT_EQ(1.0f, t);
+
+    // Degenerate
+    Segment point(Vec3f(1.0f, 1.0f, 1.0f), Vec3f(1.0f, 1.0f, 1.0f));
+    EXPECT_FLOAT_EQ(3.0f, point.closestPoint(Vec3f(0.0f, 0.0f, 0.0f), t));
+    EXPECT_EQ(0.0f, t);
+}
+
+TEST_F(SegmentTest, segments)
+{
+    Segment s(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(2.0f, 0.0f, 0.0f));
+    float t, u;
+
+    // Crossing at a right angle, one unit apart
+    EXPECT_FLOAT_EQ(1.0f, s.closestPoints(Segment(Vec3f(0.5f, -1.0f, 1.0f), Vec3f(0.5f, 1.0f, 1.0f)), t, u));
+    EXPECT_FLOAT_EQ(0.25f, t);
+    EXPECT_FLOAT_EQ(0.5f, u);
+
+    // Closest points at end points
+    EXPECT_FLOAT_EQ(2.0f, s.closestPoints(Segment(Vec3f(3.0f, 1.0f, 0.0f), Vec3f(5.0f, 1.0f, 0.0f)), t, u));
+    EXPECT_EQ(1.0f, t);
+    EXPECT_EQ(0.0f, u);
+
+    // Parallel and overlapping
+    EXPECT_FLOAT_EQ(4.0f, s.closestPoints(Segment(Vec3f(1.0f, 2.0f, 0.0f), Vec3f(5.0f, 2.0f, 0.0f)), t, u));
+    EXPECT_FLOAT_EQ(4.0f, squaredDistance(s.getPoint(t), Vec3f(1.0f + 4.0f * u, 2.0f, 0.0f)));
+
+    // Both degenerate
+    Segment p(Vec3f(0.0f, 3.0f, 4.0f), Vec3f(0.0f, 3.0f, 4.0f));
+    EXPECT_FLOAT_EQ(25.0f, p.closestPoints(Segment(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(0.0f, 0.0f, 0.0f)), t, u));
+
+    // Random segments: the result is never beaten by sampled pairs of points
+    for (int n = 0; n < 500; ++n)
+    {
+        Segment a(randomPoint(2.0f), randomPoint(2.0f));
+        Segment b = randomSegment(a);
+        float distance = a.closestPoints(b, t, u);
+
+        ASSERT_GE(t, 0.0f);
+        ASSERT_LE(t, 1.0f);
+        ASSERT_GE(u, 0.0f);
+        ASSERT_LE(u, 1.0f);
+        ASSERT_NEAR(distance, squaredDistance(a.getPoint(t), b.getPoint(u)), 1e-4f);
+
+        // Symmetric
+        float t2, u2;
+        ASSERT_NEAR(distance, b.closestPoints(a, t2, u2), 1e-4f);
+
+        for (int i = 0; i <= 20; ++i)
+        {
+            for (int j = 0; j <= 20; ++j)
+            {
+                ASSERT_LE(distance, squaredDistance(a.getPoint(i / 20.0f), b.getPoint(j / 20.0f)) + 1e-4f);
+            }
+        }
+    }
+}
+
+TEST_F(SegmentTest, triangles)
+{
+    Vec3f v0(0.0f, 0.0f, 0.0f), v1(2.0f, 0.0f, 0.0f), v2(0.0f, 2.0f, 0.0f);
+    float t;
+    Vec3f q;
+
+    // Crossing
+    Segment s(Vec3f(0.5f, 0.5f, -1.0f), Vec3f(0.5f, 0.5f, 3.0f));
+    EXPECT_EQ(0.0f, s.closestPoints(v0, v1, v2, t, q));
+    EXPECT_FLOAT_EQ(0.25f, t);
+    EXPECT_NEAR(0.0f, q.z, 1e-6f);
+
+    // End point over the face
+    s = Segment(Vec3f(0.5f, 0.5f, 1.0f), Vec3f(0.5f, 0.5f, 3.0f));
+    EXPECT_FLOAT_EQ(1.0f, s.closestPoints(v0, v1, v2, t, q));
+    EXPECT_EQ(0.0f, t);
+    EXPECT_FLOAT_EQ(0.5f, q.x);
+    EXPECT_FLOAT_EQ(0.5f, q.y);
+    EXPECT_NEAR(0.0f, q.z, 1e-6f);
+
+    // Above an edge, parallel to the face
+    s = Segment(Vec3f(-1.0f, 3.0f, 1.0f), Vec3f(3.0f, -1.0f, 1.0f));
+    EXPECT_FLOAT_EQ(1.0f, s.closestPoints(v0, v1, v2, t, q));
+    EXPECT_NEAR(0.0f, q.z, 1e-6f);
+    EXPECT_NEAR(2.0f, q.x + q.y, 1e-5f);
+
+    // Random: the result is never beaten by sampled points
+    for (int n = 0; n < 300; ++n)
+    {
+        Vec3f a = randomPoint(2.0f), b = randomPoint(2.0f), c = randomPoint(2.0f);
+
+        if (n % 10 == 0)
+        {
+            c = a + (b - a) * 0.3f; // Degenerate triangle
+        }
+
+        s = Segment(randomPoint(2.0f), randomPoint(2.0f));
+        float distance = s.closestPoints(a, b, c, t, q);
+
+        ASSERT_NEAR(distance, squaredDistance(s.getPoint(t), q), 1e-4f);
+
+        for (int i = 0; i <= 20; ++i)
+        {
+            for (int j = 0; j <= 20; ++j)
+            {
+                for (int k = 0; i + j + k <= 20; k += 4)
+                {
+                    Vec3f p = a + (b - a) * (j / 20.0f) + (c - a) * (k / 20.0f);
+                    ASSERT_LE(distance, squaredDistance(s.getPoint(i / 20.0f), p) + 1e-4f);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(SegmentTest, segmentPack)
+{
+    const int packCount = 64;
+    std::vector<SegmentPack> packs(packCount);
+    std::vector<Segment> segments;
+    Segment s(randomPoint(2.0f), randomPoint(2.0f));
+
+    for (int i = 0; i < packCount * SIMDFloat::WIDTH; ++i)
+    {
+        segments.push_back(randomSegment(s));
+        packs[i / SIMDFloat::WIDTH].set(i % SIMDFloat::WIDTH, segments[i].a, segments[i].b);
+    }
+
+    // A segment against itself, a degenerate one and a shared end point
+    segments[0] = s;
+    segments[1] = Segment(s.a, s.a);
+    segments[2] = Segment(s.b, s.b + Vec3f(1.0f, 0.0f, 0.0f));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        packs[0].set(i, segments[i].a, segments[i].b);
+    }
+
+    std::vector<float> distances(segments.size()), t(segments.size()), u(segments.size());
+    s.closestPoints(&packs[0], packs.size(), &distances[0], &t[0], &u[0]);
+
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        float ts, us;
+        float distance = s.closestPoints(segments[i], ts, us);
+
+        ASSERT_NEAR(distance, distances[i], 1e-4f) << "segment " << i;
+        ASSERT_NEAR(distances[i], squaredDistance(s.getPoint(t[i]), segments[i].getPoint(u[i])), 1e-4f);
+    }
+
+    EXPECT_EQ(0.0f, distances[0]);
+    EXPECT_EQ(0.0f, distances[1]);
+    EXPECT_EQ(0.0f, distances[2]);
+
+    // Per pack
+    SIMDFloat pt, pu;
+    SIMDFloat d = s.closestPoints(packs[1], pt, pu);
+
+    for (int i = 0; i < SIMDFloat::WIDTH; ++i)
+    {
+        EXPECT_EQ(distances[SIMDFloat::WIDTH + i], d.lane(i));
+    }
+}
+
+TEST_F(SegmentTest, trianglePack)
+{
+    const int packCount = 64;
+    std::vector<TrianglePack> packs(packCount);
+    std::vector<Vec3f> vertices;
+    Segment s(randomPoint(1.0f), randomPoint(1.0f));
+
+    for (int i = 0; i < packCount * SIMDFloat::WIDTH; ++i)
+    {
+        Vec3f a = randomPoint(2.0f), b = randomPoint(2.0f), c = randomPoint(2.0f);
+
+        if (i % 16 == 0)
+        {
+            c = a + (b - a) * 0.5f;
+        }
+
+        vertices.push_back(a);
+        vertices.push_back(b);
+        vertices.push_back(c);
+        packs[i / SIMDFloat::WIDTH].set(i % SIMDFloat::WIDTH, a, b, c);
+    }
+
+    std::vector<float> distances(vertices.size() / 3), t(vertices.size() / 3);
+    s.closestPoints(&packs[0], packs.size(), &distances[0], &t[0]);
+
+    int crossing = 0;
+
+    for (size_t i = 0; i < distances.size(); ++i)
+    {
+        float ts;
+        Vec3f q;
+        float distance = s.closestPoints(vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2], ts, q);
+
+        ASSERT_NEAR(distance, distances[i], 1e-4f) << "triangle " << i;
+        crossing += distances[i] == 0.0f;
+    }
+
+    EXPECT_GT(crossing, 0);
+
+    // Per pack, with the closest points on the triangles
+    SIMDFloat pt, q[3];
+    SIMDFloat d = s.closestPoints(packs[3], pt, q);
+
+    for (int i = 0; i < SIMDFloat::WIDTH; ++i)
+    {
+        Vec3f p = s.getPoint(pt.lane(i));
+        EXPECT_EQ(distances[3 * SIMDFloat::WIDTH + i], d.lane(i));
+        EXPECT_NEAR(d.lane(i), squaredDistance(p, Vec3f(q[0].lane(i), q[1].lane(i), q[2].lane(i))), 1e-4f);
+    }
+}
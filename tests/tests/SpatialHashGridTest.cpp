@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "Mesh.h"
+#include "SpatialHashGrid.h"
+
+using namespace nut;
+
+class SpatialHashGridTest : public RandomTest
+{
+    protected:
+
+    std::vector<Vec3f> randomPoints(size_t count, float size)
+    {
+        std::vector<Vec3f> points(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            points[i] = Vec3f(uniform(-size, size), uniform(-size, size), uniform(-size, size));
+        }
+
+        return points;
+    }
+
+    static std::vector<U32> bruteForceRadius(const std::vector<Vec3f>& points, const Vec3f& p, float radius)
+    {
+        std::vector<U32> found;
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            Vec3f v = points[i] - p;
+
+            if (v * v <= radius * radius)
+            {
+                found.push_back(U32(i));
+            }
+        }
+
+        return found;
+    }
+
+    static std::vector<U32> sorted(std::vector<U32> v)
+    {
+        std::sort(v.begin(), v.end());
+        return v;
+    }
+};
+
+TEST_F(SpatialHashGridTest, empty)
+{
+    SpatialHashGrid grid(2.0f);
+    std::vector<U32> found;
+    std::vector<U32> offsets, neighbors;
+    const U32* cellPoints;
+
+    EXPECT_EQ(0u, grid.queryRadius(Vec3f(0.0f, 0.0f, 0.0f), 10.0f, found));
+    EXPECT_EQ(0u, grid.queryNearest(Vec3f(0.0f, 0.0f, 0.0f), 3, found));
+    EXPECT_EQ(0u, grid.getCellPoints(Vec3i(0, 0, 0), cellPoints));
+
+    grid.build(std::vector<Vec3f>());
+    grid.findNeighbors(1.0f, offsets, neighbors);
+    EXPECT_EQ(0u, grid.getNumberOfCells());
+    EXPECT_EQ(1u, offsets.size());
+    EXPECT_TRUE(neighbors.empty());
+}
+
+TEST_F(SpatialHashGridTest, cells)
+{
+    SpatialHashGrid grid(2.0f);
+
+    // Negative coordinates round down
+    EXPECT_EQ(-1, grid.getCell(Vec3f(-0.5f, 0.0f, 0.0f)).x);
+    EXPECT_EQ(-2, grid.getCell(Vec3f(-2.5f, 0.0f, 0.0f)).x);
+    EXPECT_EQ(1, grid.getCell(Vec3f(0.0f, 2.0f, 0.0f)).y);
+
+    std::vector<Vec3f> points;
+    points.push_back(Vec3f(0.5f, 0.5f, 0.5f));
+    points.push_back(Vec3f(-0.5f, 0.5f, 0.5f));
+    points.push_back(Vec3f(1.5f, 1.0f, 0.1f));
+    points.push_back(Vec3f(-1.0f, 1.0f, 1.0f));
+    grid.build(points);
+
+    EXPECT_EQ(4u, grid.getNumberOfPoints());
+    EXPECT_EQ(2u, grid.getNumberOfCells());
+
+    // Points of a cell keep their original order
+    const U32* cellPoints;
+    ASSERT_EQ(2u, grid.getCellPoints(Vec3i(0, 0, 0), cellPoints));
+    EXPECT_EQ(0u, cellPoints[0]);
+    EXPECT_EQ(2u, cellPoints[1]);
+    ASSERT_EQ(2u, grid.getCellPoints(Vec3i(-1, 0, 0), cellPoints));
+    EXPECT_EQ(1u, cellPoints[0]);
+    EXPECT_EQ(3u, cellPoints[1]);
+    EXPECT_EQ(0u, grid.getCellPoints(Vec3i(0, 0, 1), cellPoints));
+    EXPECT_EQ(nullptr, cellPoints);
+
+    // Strided input, e.g. a Vertex array
+    std::vector<Vertex> vertices(points.size());
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        vertices[i].pos = points[i];
+    }
+
+    grid.build(&vertices[0].pos.x, vertices.size(), sizeof(Vertex) / sizeof(float));
+    ASSERT_EQ(2u, grid.getCellPoints(Vec3i(-1, 0, 0), cellPoints));
+    EXPECT_EQ(3u, cellPoints[1]);
+}
+
+TEST_F(SpatialHashGridTest, radiusQueries)
+{
+    std::vector<Vec3f> points = randomPoints(20000, 20.0f);
+
+    // Duplicates and a far away cluster
+    points[5] = points[6] = points[7];
+
+    for (size_t i = 0; i < 50; ++i)
+    {
+        points.push_back(Vec3f(1000.0f + uniform(0.0f, 1.0f), -1000.0f, 0.0f));
+    }
+
+    SpatialHashGrid grid(1.5f);
+    grid.build(points);
+
+    const float radii[4] = { 0.0f, 0.7f, 1.5f, 4.0f };
+
+    for (int q = 0; q < 200; ++q)
+    {
+        Vec3f p = q < 195 ? Vec3f(uniform(-22.0f, 22.0f), uniform(-22.0f, 22.0f), uniform(-22.0f, 22.0f)) : points[q];
+        float radius = radii[q % 4];
+
+        std::vector<U32> found;
+        size_t n = grid.queryRadius(p, radius, found);
+        EXPECT_EQ(n, found.size());
+        ASSERT_EQ(bruteForceRadius(points, p, radius), sorted(found)) << "query " << q;
+    }
+
+    // A radius covering more cells than the grid has falls back to a scan
+    std::vector<U32> found;
+    grid.queryRadius(Vec3f(500.0f, -500.0f, 0.0f), 1500.0f, found);
+    EXPECT_EQ(points.size(), found.size());
+}
+
+TEST_F(SpatialHashGridTest, nearestQueries)
+{
+    std::vector<Vec3f> points = randomPoints(5000, 10.0f);
+    SpatialHashGrid grid(0.8f);
+    grid.build(points);
+
+    for (int q = 0; q < 300; ++q)
+    {
+        // Inside, at the border and far outside the points
+        float size = q < 100 ? 10.0f : (q < 200 ? 12.0f : 60.0f);
+        Vec3f p(uniform(-size, size), uniform(-size, size), uniform(-size, size));
+        size_t k = 1 + q % 20;
+
+        std::vector< std::pair<float, U32> > expected;
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            Vec3f v = points[i] - p;
+            expected.push_back(std::make_pair(v * v, U32(i)));
+        }
+
+        std::sort(expected.begin(), expected.end());
+
+        std::vector<U32> found;
+        ASSERT_EQ(k, grid.queryNearest(p, k, found));
+
+        for (size_t i = 0; i < k; ++i)
+        {
+            Vec3f v = points[found[i]] - p;
+            ASSERT_FLOAT_EQ(expected[i].first, v * v) << "query " << q << ", neighbor " << i;
+        }
+    }
+
+    // Limited by the maximum radius, and by the number of points
+    Vec3f p(0.0f, 0.0f, 0.0f);
+    std::vector<U32> found;
+    size_t n = grid.queryNearest(p, 100, found, 1.0f);
+    EXPECT_EQ(bruteForceRadius(points, p, 1.0f).size(), n);
+    EXPECT_EQ(bruteForceRadius(points, p, 1.0f), sorted(found));
+
+    found.clear();
+    EXPECT_EQ(points.size(), grid.queryNearest(p, 10000, found));
+}
+
+TEST_F(SpatialHashGridTest, findNeighbors)
+{
+    std::vector<Vec3f> points = randomPoints(12000, 8.0f);
+    SpatialHashGrid grid(0.5f);
+    grid.build(points);
+
+    std::vector<U32> offsets, neighbors;
+    grid.findNeighbors(0.5f, offsets, neighbors);
+
+    ASSERT_EQ(points.size() + 1, offsets.size());
+    ASSERT_EQ(neighbors.size(), offsets.back());
+
+    size_t total = 0;
+
+    for (size_t i = 0; i < points.size(); i += 7)
+    {
+        std::vector<U32> expected = bruteForceRadius(points, points[i], 0.5f);
+        expected.erase(std::find(expected.begin(), expected.end(), U32(i)));
+
+        std::vector<U32> found(neighbors.begin() + offsets[i], neighbors.begin() + offsets[i + 1]);
+        ASSERT_EQ(expected, sorted(found)) << "point " << i;
+        total += found.size();
+    }
+
+    EXPECT_GT(total, 0u);
+}
@@ -0,0 +1,209 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "Frustum.h"
+#include "Mesh.h"
+#include "Sphere.h"
+
+using namespace nut;
+
+class SphereTest : public RandomTest
+{
+    protected:
+
+    static void expectContainsAll(const Sphere& s, const std::vector<Vec3f>& points)
+    {
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            ASSERT_TRUE(s.contains(points[i])) << "point " << i;
+        }
+    }
+};
+
+TEST_F(SphereTest, basics)
+{
+    Sphere empty;
+    EXPECT_TRUE(empty.isEmpty());
+    EXPECT_FALSE(empty.contains(Vec3f(0.0f, 0.0f, 0.0f)));
+    EXPECT_TRUE(empty.getBoundingBox().isEmpty());
+
+    Sphere s(Vec3f(1.0f, 2.0f, 3.0f), 2.0f);
+    EXPECT_TRUE(s.contains(Vec3f(1.0f, 2.0f, 5.0f)));
+    EXPECT_FALSE(s.contains(Vec3f(2.5f, 3.5f, 3.0f)));
+    EXPECT_TRUE(s.contains(Sphere(Vec3f(1.5f, 2.0f, 3.0f), 1.5f)));
+    EXPECT_FALSE(s.contains(Sphere(Vec3f(1.5f, 2.0f, 3.0f), 1.6f)));
+    EXPECT_TRUE(s.overlaps(Sphere(Vec3f(5.0f, 2.0f, 3.0f), 2.0f)));
+    EXPECT_FALSE(s.overlaps(Sphere(Vec3f(5.1f, 2.0f, 3.0f), 2.0f)));
+    EXPECT_FALSE(s.overlaps(empty));
+
+    // Box overlap uses the closest point, not the sphere's bounds
+    EXPECT_TRUE(s.overlaps(BoundingBox(Vec3f(2.9f, 0.0f, 0.0f), Vec3f(4.0f, 4.0f, 4.0f))));
+    EXPECT_FALSE(s.overlaps(BoundingBox(Vec3f(2.5f, 3.5f, 4.5f), Vec3f(4.0f, 4.0f, 6.0f))));
+    EXPECT_TRUE(s.getBoundingBox().overlaps(BoundingBox(Vec3f(2.5f, 3.5f, 4.5f), Vec3f(4.0f, 4.0f, 6.0f))));
+
+    // Scale 2 on one axis, then rotation and translation (either order)
+    GLMatrix<float> rotation, scale;
+    rotation.setRotation(1.0f, 0.0f, 1.0f, 1.0f);
+    scale.setScale(1.0f, 2.0f, 1.0f);
+    GLMatrix<float> m = rotation * scale;
+    m[12] = 10.0f;
+    Sphere t = s.transform(m);
+    EXPECT_NEAR(4.0f, t.radius, 1e-5f);
+    EXPECT_NEAR(0.0f, (t.center - m * s.center).length(), 1e-5f);
+    EXPECT_NEAR(4.0f, s.transform(scale * rotation).radius, 1e-5f);
+}
+
+TEST_F(SphereTest, expandAndMerge)
+{
+    Sphere s;
+    s.expand(Vec3f(1.0f, 0.0f, 0.0f));
+    EXPECT_FLOAT_EQ(0.0f, s.radius);
+
+    s.expand(Vec3f(-1.0f, 0.0f, 0.0f));
+    EXPECT_FLOAT_EQ(1.0f, s.radius);
+    EXPECT_FLOAT_EQ(0.0f, s.center.x);
+
+    // Points already inside don't change it
+    s.expand(Vec3f(0.0f, 0.5f, 0.0f));
+    EXPECT_FLOAT_EQ(1.0f, s.radius);
+
+    Sphere a(Vec3f(0.0f, 0.0f, 0.0f), 1.0f);
+    a.merge(Sphere(Vec3f(4.0f, 0.0f, 0.0f), 1.0f));
+    EXPECT_FLOAT_EQ(3.0f, a.radius);
+    EXPECT_FLOAT_EQ(2.0f, a.center.x);
+
+    // Enclosed spheres are absorbed; empty ones are ignored
+    a.merge(Sphere(Vec3f(2.0f, 1.0f, 0.0f), 0.5f));
+    a.merge(Sphere());
+    EXPECT_FLOAT_EQ(3.0f, a.radius);
+
+    Sphere b(Vec3f(2.0f, 0.0f, 0.0f), 0.5f);
+    b.merge(a);
+    EXPECT_FLOAT_EQ(3.0f, b.radius);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        Sphere p(Vec3f(uniform(-5.0f, 5.0f), uniform(-5.0f, 5.0f), uniform(-5.0f, 5.0f)), uniform(0.1f, 3.0f));
+        Sphere q(Vec3f(uniform(-5.0f, 5.0f), uniform(-5.0f, 5.0f), uniform(-5.0f, 5.0f)), uniform(0.1f, 3.0f));
+        Sphere r = p;
+        r.merge(q);
+
+        ASSERT_TRUE(Sphere(r.center, r.radius * 1.0001f).contains(p)) << "pair " << i;
+        ASSERT_TRUE(Sphere(r.center, r.radius * 1.0001f).contains(q)) << "pair " << i;
+        ASSERT_LE(r.radius, std::max(p.radius, q.radius) + (p.center - q.center).length() * 0.5f + 1e-4f);
+    }
+}
+
+TEST_F(SphereTest, fit)
+{
+    // Points in a unit ball, plus a few on its boundary
+    std::vector<Vec3f> points(20000);
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        points[i] = randomUnit() * (i % 1000 == 0 ? 1.0f : std::pow(uniform(0.0f, 1.0f), 3.0f) * 0.9f);
+        points[i] = points[i] * 3.0f + Vec3f(10.0f, -4.0f, 2.0f);
+    }
+
+    Sphere ritter = Sphere::fit(&points[0].x, points.size());
+    Sphere welzl = Sphere::fitExact(&points[0].x, points.size());
+
+    expectContainsAll(welzl, points);
+    expectContainsAll(Sphere(ritter.center, ritter.radius * (1.0f + 1e-6f)), points);
+
+    EXPECT_LE(welzl.radius, 3.0f * 1.00001f);
+    EXPECT_GE(welzl.radius, ritter.radius * 0.8f);
+    EXPECT_LE(welzl.radius, ritter.radius * 1.00001f);
+
+    // Stride over a Vertex array gives the same answer
+    Mesh mesh;
+    mesh.getVertices().resize(points.size());
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        mesh.getVertices()[i].pos = points[i];
+    }
+
+    EXPECT_FLOAT_EQ(welzl.radius, Sphere::fitExact(mesh).radius);
+    EXPECT_FLOAT_EQ(ritter.radius, Sphere::fit(mesh).radius);
+
+    Mesh noVertices;
+    EXPECT_TRUE(Sphere::fit(noVertices).isEmpty());
+    EXPECT_TRUE(Sphere::fitExact(noVertices).isEmpty());
+}
+
+TEST_F(SphereTest, fitExactSmallSets)
+{
+    const Vec3f single(1.0f, 2.0f, 3.0f);
+    Sphere s = Sphere::fitExact(&single.x, 1);
+    EXPECT_FLOAT_EQ(0.0f, s.radius);
+
+    // Two points: the diameter
+    const Vec3f two[2] = { Vec3f(0.0f, 0.0f, 0.0f), Vec3f(4.0f, 0.0f, 0.0f) };
+    s = Sphere::fitExact(&two[0].x, 2);
+    EXPECT_NEAR(2.0f, s.radius, 1e-6f);
+    EXPECT_NEAR(2.0f, s.center.x, 1e-6f);
+
+    // Equilateral triangle: circumcircle radius is side / sqrt(3)
+    const Vec3f triangle[3] = { Vec3f(0.0f, 0.0f, 0.0f), Vec3f(2.0f, 0.0f, 0.0f), Vec3f(1.0f, std::sqrt(3.0f), 0.0f) };
+    s = Sphere::fitExact(&triangle[0].x, 3);
+    EXPECT_NEAR(2.0f / std::sqrt(3.0f), s.radius, 1e-5f);
+
+    // Obtuse triangle: the longest side is the diameter
+    const Vec3f obtuse[3] = { Vec3f(0.0f, 0.0f, 0.0f), Vec3f(4.0f, 0.0f, 0.0f), Vec3f(2.0f, 0.5f, 0.0f) };
+    s = Sphere::fitExact(&obtuse[0].x, 3);
+    EXPECT_NEAR(2.0f, s.radius, 1e-5f);
+
+    // Regular tetrahedron with edge 2 sqrt(2): circumradius sqrt(3)
+    const Vec3f tetrahedron[4] = { Vec3f(1.0f, 1.0f, 1.0f), Vec3f(1.0f, -1.0f, -1.0f),
+                                   Vec3f(-1.0f, 1.0f, -1.0f), Vec3f(-1.0f, -1.0f, 1.0f) };
+    s = Sphere::fitExact(&tetrahedron[0].x, 4);
+    EXPECT_NEAR(std::sqrt(3.0f), s.radius, 1e-5f);
+
+    // Degenerate sets: collinear and coplanar points, duplicates
+    std::vector<Vec3f> line, grid;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        line.push_back(Vec3f(float(i % 10), float(i % 10) * 2.0f, 0.0f));
+        grid.push_back(Vec3f(float(i % 10), float(i / 10), 5.0f));
+    }
+
+    s = Sphere::fitExact(&line[0].x, line.size());
+    EXPECT_NEAR(std::sqrt(81.0f + 324.0f) * 0.5f, s.radius, 1e-4f);
+    expectContainsAll(s, line);
+
+    s = Sphere::fitExact(&grid[0].x, grid.size());
+    EXPECT_NEAR(std::sqrt(162.0f) * 0.5f, s.radius, 1e-4f);
+    expectContainsAll(s, grid);
+}
+
+TEST_F(SphereTest, fitExactCospherical)
+{
+    // Mesh-like input: every point on the same sphere
+    std::vector<Vec3f> points(5000);
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        points[i] = randomUnit() * 7.0f + Vec3f(-1.0f, 2.0f, 0.5f);
+    }
+
+    Sphere s = Sphere::fitExact(&points[0].x, points.size());
+    EXPECT_NEAR(7.0f, s.radius, 1e-3f);
+    EXPECT_NEAR(0.0f, (s.center - Vec3f(-1.0f, 2.0f, 0.5f)).length(), 1e-2f);
+    expectContainsAll(s, points);
+}
+
+TEST_F(SphereTest, frustum)
+{
+    GLMatrix<float> projection, view;
+    projection.setPerspective(90.0f, 1.0f, 1.0f, 100.0f);
+    view.setLookAt(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f);
+    Frustum frustum(projection * view);
+
+    EXPECT_TRUE(frustum.intersects(Sphere(Vec3f(0.0f, 0.0f, -10.0f), 1.0f)));
+    EXPECT_TRUE(frustum.intersects(Sphere(Vec3f(0.0f, 0.0f, -0.5f), 1.0f)));
+    EXPECT_FALSE(frustum.intersects(Sphere(Vec3f(0.0f, 0.0f, 5.0f), 1.0f)));
+    EXPECT_FALSE(frustum.intersects(Sphere()));
+}
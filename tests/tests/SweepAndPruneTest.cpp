@@ -0,0 +1,147 @@
+#include <set>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "SweepAndPrune.h"
+
+using namespace nut;
+
+class SweepAndPruneTest : public RandomTest
+{
+    protected:
+
+    typedef std::set< std::pair<U32, U32> > PairSet;
+
+    BoundingBox randomBox(const Vec3f& size, float maxExtent)
+    {
+        Vec3f c(uniform(-size.x, size.x), uniform(-size.y, size.y), uniform(-size.z, size.z));
+        Vec3f e(uniform(0.1f, maxExtent), uniform(0.1f, maxExtent), uniform(0.1f, maxExtent));
+        return BoundingBox(c - e, c + e);
+    }
+
+    static PairSet toSet(const std::vector<SweepAndPrune::Pair>& pairs)
+    {
+        PairSet set;
+
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            EXPECT_LT(pairs[i].a, pairs[i].b);
+            EXPECT_TRUE(set.insert(std::make_pair(pairs[i].a, pairs[i].b)).second) << "duplicate pair";
+        }
+
+        return set;
+    }
+
+    static PairSet bruteForcePairs(const std::vector<BoundingBox>& boxes)
+    {
+        PairSet set;
+
+        for (size_t i = 0; i < boxes.size(); ++i)
+        {
+            for (size_t j = i + 1; j < boxes.size(); ++j)
+            {
+                if (boxes[i].overlaps(boxes[j]))
+                {
+                    set.insert(std::make_pair(U32(i), U32(j)));
+                }
+            }
+        }
+
+        return set;
+    }
+};
+
+TEST_F(SweepAndPruneTest, smallSets)
+{
+    SweepAndPrune sap;
+    std::vector<BoundingBox> boxes;
+    std::vector<SweepAndPrune::Pair> pairs(3);
+
+    sap.findPairs(boxes, pairs);
+    EXPECT_TRUE(pairs.empty());
+
+    boxes.push_back(BoundingBox(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 1.0f, 1.0f)));
+    sap.findPairs(boxes, pairs);
+    EXPECT_TRUE(pairs.empty());
+
+    // Touching faces overlap; empty boxes overlap nothing
+    boxes.push_back(BoundingBox(Vec3f(1.0f, 0.0f, 0.0f), Vec3f(2.0f, 1.0f, 1.0f)));
+    boxes.push_back(BoundingBox(Vec3f(2.5f, 0.0f, 0.0f), Vec3f(3.0f, 1.0f, 1.0f)));
+    boxes.push_back(BoundingBox());
+    boxes.push_back(BoundingBox(Vec3f(0.5f, 1.5f, 0.0f), Vec3f(1.5f, 2.0f, 1.0f)));
+    sap.findPairs(boxes, pairs);
+
+    ASSERT_EQ(1u, pairs.size());
+    EXPECT_EQ(0u, pairs[0].a);
+    EXPECT_EQ(1u, pairs[0].b);
+}
+
+TEST_F(SweepAndPruneTest, identicalBoxes)
+{
+    // Every key is equal, so radix passes are skipped and every pair overlaps
+    std::vector<BoundingBox> boxes(300, BoundingBox(Vec3f(-1.0f, -2.0f, -3.0f), Vec3f(1.0f, 2.0f, 3.0f)));
+    std::vector<SweepAndPrune::Pair> pairs;
+    SweepAndPrune sap;
+
+    sap.findPairs(boxes, pairs);
+    EXPECT_EQ(300u * 299u / 2u, toSet(pairs).size());
+}
+
+TEST_F(SweepAndPruneTest, matchesBruteForce)
+{
+    SweepAndPrune sap;
+    std::vector<SweepAndPrune::Pair> pairs;
+
+    // Boxes spread along each axis in turn, crossing zero, with a few empty
+    // and duplicated ones, and counts that aren't multiples of the SIMD width
+    const size_t counts[3] = { 3001, 2047, 2500 };
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        Vec3f size(10.0f, 10.0f, 10.0f);
+        (axis == 0 ? size.x : (axis == 1 ? size.y : size.z)) = 200.0f;
+
+        std::vector<BoundingBox> boxes(counts[axis]);
+
+        for (size_t i = 0; i < boxes.size(); ++i)
+        {
+            boxes[i] = i % 97 == 0 ? BoundingBox() : randomBox(size, 1.5f);
+        }
+
+        boxes[10] = boxes[11];
+
+        sap.findPairs(boxes, pairs);
+        EXPECT_EQ(axis, sap.getSweepAxis());
+
+        PairSet found = toSet(pairs);
+        PairSet expected = bruteForcePairs(boxes);
+        EXPECT_GT(expected.size(), 100u);
+        EXPECT_TRUE(found == expected) << "axis " << axis << ": " << found.size() << " pairs, expected " << expected.size();
+    }
+}
+
+TEST_F(SweepAndPruneTest, deterministic)
+{
+    // More boxes than one sorting task, so several tasks take part
+    std::vector<BoundingBox> boxes(40000);
+
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        boxes[i] = randomBox(Vec3f(100.0f, 100.0f, 100.0f), 1.0f);
+    }
+
+    SweepAndPrune a, b;
+    std::vector<SweepAndPrune::Pair> first, second;
+    a.findPairs(boxes, first);
+    b.findPairs(boxes, second);
+    a.findPairs(boxes, second);
+
+    ASSERT_EQ(first.size(), second.size());
+
+    for (size_t i = 0; i < first.size(); ++i)
+    {
+        ASSERT_EQ(first[i].a, second[i].a);
+        ASSERT_EQ(first[i].b, second[i].b);
+    }
+}
@@ -0,0 +1,170 @@
+#include <cfloat>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../RandomTest.h"
+#include "Mesh.h"
+#include "TLAS.h"
+
+using namespace nut;
+
+class TLASTest : public RandomTest
+{
+    protected:
+
+    Mesh meshes[2];
+    BVH bvhs[2];
+
+    virtual void SetUp()
+    {
+        makeSoup(meshes[0], 300, 4.0f);
+        makeSoup(meshes[1], 500, 6.0f);
+        ASSERT_TRUE(bvhs[0].build(meshes[0]));
+        ASSERT_TRUE(bvhs[1].build(meshes[1]));
+    }
+
+    void makeSoup(Mesh& mesh, size_t triangles, float size)
+    {
+        std::vector<Vertex>& vertices = mesh.getVertices();
+        std::vector<int>& indices = mesh.getTriangulation();
+        vertices.resize(3 * triangles);
+        indices.resize(3 * triangles);
+
+        for (size_t t = 0; t < triangles; ++t)
+        {
+            Vec3f c(uniform(-size, size), uniform(-size, size), uniform(-size, size));
+
+            for (int k = 0; k < 3; ++k)
+            {
+                vertices[3 * t + k].pos = c + Vec3f(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f));
+                indices[3 * t + k] = int(3 * t + k);
+            }
+        }
+    }
+
+    // Random rotation, uniform scale and translation
+    GLMatrix<float> randomTransform(float size)
+    {
+        GLMatrix<float> m;
+        m.setRotation(uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(0.1f, 1.0f), uniform(0.0f, 6.28f));
+        m.scale(uniform(0.5f, 2.0f), uniform(0.5f, 2.0f), uniform(0.5f, 2.0f));
+        m[12] = uniform(-size, size);
+        m[13] = uniform(-size, size);
+        m[14] = uniform(-size, size);
+        return m;
+    }
+
+    // Closest hit by testing every triangle of every instance in world space
+    void bruteForce(const TLAS& tlas, const Ray& ray, TLAS::Hit& hit)
+    {
+        hit.t = ray.tMax;
+        hit.instance = hit.triangle = BVH::NO_HIT;
+
+        for (U32 i = 0; i < tlas.getNumberOfInstances(); ++i)
+        {
+            const TLAS::Instance& instance = tlas.getInstance(i);
+            Mesh& mesh = meshes[instance.bvh == &bvhs[0] ? 0 : 1];
+
+            for (size_t t = 0; t < mesh.getTriangulation().size() / 3; ++t)
+            {
+                const int* v = &mesh.getTriangulation()[3 * t];
+                float ti, u, w;
+
+                if (ray.intersect(instance.transform * mesh.getVertices()[v[0]].pos,
+                                  instance.transform * mesh.getVertices()[v[1]].pos,
+                                  instance.transform * mesh.getVertices()[v[2]].pos, ti, u, w) && ti < hit.t)
+                {
+                    hit.t = ti;
+                    hit.instance = i;
+                    hit.triangle = U32(t);
+                }
+            }
+        }
+    }
+
+    void compare(TLAS& tlas, size_t rayCount)
+    {
+        std::vector<Ray> rays(rayCount);
+        std::vector<TLAS::Hit> hits(rayCount);
+        bool* occluded = new bool[rayCount];
+        size_t hitCount = 0;
+
+        for (size_t i = 0; i < rayCount; ++i)
+        {
+            Vec3f o(uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f), uniform(-60.0f, 60.0f));
+            Vec3f target(uniform(-30.0f, 30.0f), uniform(-30.0f, 30.0f), uniform(-30.0f, 30.0f));
+            rays[i] = Ray(o, target - o);
+        }
+
+        tlas.intersect(&rays[0], &hits[0], rayCount);
+        tlas.occluded(&rays[0], occluded, rayCount);
+
+        for (size_t i = 0; i < rayCount; ++i)
+        {
+            TLAS::Hit expected, hit;
+            bruteForce(tlas, rays[i], expected);
+            bool found = tlas.intersect(rays[i], hit);
+
+            ASSERT_EQ(expected.instance != BVH::NO_HIT, found) << "ray " << i;
+            ASSERT_EQ(found, tlas.occluded(rays[i])) << "ray " << i;
+            ASSERT_EQ(found, occluded[i]) << "ray " << i;
+            EXPECT_EQ(hit.instance, hits[i].instance);
+
+            if (found)
+            {
+                EXPECT_EQ(expected.instance, hit.instance) << "ray " << i;
+                EXPECT_EQ(expected.triangle, hit.triangle) << "ray " << i;
+                EXPECT_NEAR(expected.t, hit.t, 1e-3f * expected.t);
+                ++hitCount;
+            }
+        }
+
+        delete[] occluded;
+
+        EXPECT_GT(hitCount, rayCount / 10);
+        EXPECT_LT(hitCount, rayCount);
+    }
+};
+
+TEST_F(TLASTest, empty)
+{
+    TLAS tlas;
+    BVH empty;
+    TLAS::Hit hit;
+
+    EXPECT_EQ(BVH::NO_HIT, tlas.addInstance(&empty, GLMatrix<float>::IDENTITY));
+    EXPECT_EQ(BVH::NO_HIT, tlas.addInstance(nullptr, GLMatrix<float>::IDENTITY));
+    EXPECT_EQ(size_t(0), tlas.getNumberOfInstances());
+
+    tlas.build();
+    EXPECT_FALSE(tlas.intersect(Ray(), hit));
+    EXPECT_EQ(BVH::NO_HIT, hit.instance);
+    EXPECT_FALSE(tlas.occluded(Ray()));
+}
+
+TEST_F(TLASTest, matchesBruteForce)
+{
+    TLAS tlas;
+
+    for (U32 i = 0; i < 60; ++i)
+    {
+        ASSERT_EQ(i, tlas.addInstance(&bvhs[i % 2], randomTransform(30.0f)));
+    }
+
+    tlas.build();
+    compare(tlas, 300);
+
+    // Move every instance, then refit
+    for (U32 i = 0; i < 60; ++i)
+    {
+        tlas.setTransform(i, randomTransform(30.0f));
+    }
+
+    tlas.refit();
+    compare(tlas, 300);
+
+    // Instances added after a build are picked up by refit
+    tlas.addInstance(&bvhs[0], randomTransform(30.0f));
+    tlas.refit();
+    EXPECT_EQ(tlas.getNumberOfInstances(), tlas.getInstanceIndices().size());
+    compare(tlas, 100);
+}
@@ -0,0 +1,68 @@
+#include <atomic>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ThreadPool.h"
+
+using namespace nut;
+
+TEST(ThreadPoolTest, parallelForVisitsEveryIndexOnce)
+{
+    const size_t N = 100003;
+    std::vector<int> visits(N, 0);
+
+    ThreadPool::getInstance().parallelFor(N, 1000, [&visits](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i) ++visits[i];
+    });
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        ASSERT_EQ(1, visits[i]) << "index " << i;
+    }
+}
+
+TEST(ThreadPoolTest, parallelForEdgeCases)
+{
+    std::atomic<int> calls(0);
+    ThreadPool& pool = ThreadPool::getInstance();
+
+    pool.parallelFor(0, 10, [&calls](size_t, size_t) { ++calls; });
+    EXPECT_EQ(0, calls.load());
+
+    // Grain 0 is treated as 1
+    pool.parallelFor(5, 0, [&calls](size_t begin, size_t end) { calls += int(end - begin); });
+    EXPECT_EQ(5, calls.load());
+
+    EXPECT_GE(pool.getNumberOfThreads(), size_t(1));
+}
+
+TEST(ThreadPoolTest, nestedParallelFor)
+{
+    std::atomic<long> sum(0);
+    ThreadPool& pool = ThreadPool::getInstance();
+
+    pool.parallelFor(16, 1, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            pool.parallelFor(1000, 10, [&](size_t b, size_t e)
+            {
+                long local = 0;
+                for (size_t j = b; j < e; ++j) local += long(j);
+                sum += local;
+            });
+        }
+    });
+
+    EXPECT_EQ(16L * 999L * 1000L / 2L, sum.load());
+}
+
+TEST(ThreadPoolTest, parallelInvoke)
+{
+    int a = 0, b = 0;
+
+    ThreadPool::getInstance().parallelInvoke([&a]() { a = 1; }, [&b]() { b = 2; });
+
+    EXPECT_EQ(1, a);
+    EXPECT_EQ(2, b);
+}